@@ -5,6 +5,16 @@ Texture2D NormalTexture;
 Texture2D MetallicTexture;
 Texture2D RoughnessTexture;
 
+#if COMPACT_VERTEX
+// Quantized position in slot 0, octahedral normal/tangent and half UV in slot 1
+struct VertexIn
+{
+    float4 PosL    : POSITION;
+    float2 NormalL : NORMAL;
+    float2 TexC    : TEXCOORD;
+    float2 TangentU : TANGENT;
+};
+#else
 struct VertexIn
 {
     float3 PosL    : POSITION;
@@ -12,6 +22,7 @@ struct VertexIn
     float2 TexC    : TEXCOORD;
     float3 TangentU : TANGENT;
 };
+#endif
 
 struct VertexOut
 {
@@ -41,14 +52,24 @@ VertexOut VS(VertexIn vin)
     // Fetch the material data.
 	MaterialData MatData = cbMaterialData;
 
+#if COMPACT_VERTEX
+    float3 PosL = DequantizePosition(vin.PosL.xyz);
+    float3 NormalL = DecodeOctahedral(vin.NormalL);
+    float3 TangentL = DecodeOctahedral(vin.TangentU);
+#else
+    float3 PosL = vin.PosL;
+    float3 NormalL = vin.NormalL;
+    float3 TangentL = vin.TangentU;
+#endif
+
     // Transform to world space.
-    float4 PosW = mul(float4(vin.PosL, 1.0f), gWorld);
+    float4 PosW = mul(float4(PosL, 1.0f), gWorld);
     Out.PosW = PosW.xyz;
 
     // Assumes nonuniform scaling; otherwise, need to use inverse-transpose of world matrix.
-    Out.NormalW = mul(vin.NormalL, (float3x3)gWorld);
+    Out.NormalW = mul(NormalL, (float3x3)gWorld);
 
-    Out.TangentW = mul(vin.TangentU, (float3x3)gWorld);
+    Out.TangentW = mul(TangentL, (float3x3)gWorld);
 
     // Transform to homogeneous clip space.
     Out.PosH = mul(PosW, gViewProj);
@@ -56,7 +77,7 @@ VertexOut VS(VertexIn vin)
     // CurPosH and PrevPosH
     Out.CurPosH = mul(PosW, gViewProj);
     
-    float4 PrevPosW = mul(float4(vin.PosL, 1.0f), gPrevWorld);
+    float4 PrevPosW = mul(float4(PosL, 1.0f), gPrevWorld);
     Out.PrevPosH = mul(PrevPosW, gPrevViewProj);
 
     // Output vertex attributes for interpolation across triangle.
@@ -94,7 +115,7 @@ PixelOutput PS(VertexOut pin) //: SV_Target
 	else
 	{
 		float4 NormalMapSample = NormalTexture.Sample(gsamAnisotropicWrap, pin.TexC);
-		float3 Normal = NormalSampleToWorldSpace(NormalMapSample.rgb, pin.NormalW, pin.TangentW);
+		float3 Normal = NormalSampleToWorldSpace(ReconstructNormalMapSample(NormalMapSample.rg), pin.NormalW, pin.TangentW);
 		Out.Normal = float4(normalize(Normal), 1.0f);
 	}
 
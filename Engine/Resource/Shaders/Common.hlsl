@@ -10,8 +10,20 @@ cbuffer cbPerObject
     float4x4 gWorld;
 	float4x4 gPrevWorld;
 	float4x4 gTexTransform;
+
+	// Compact vertex position bounds, Min 0 and Extent 1 for float positions
+	float3 gPosDequantMin;
+	float gObjPad0;
+	float3 gPosDequantExtent;
+	float gObjPad1;
 };
 
+// R16G16B16A16_UNORM positions arrive in [0,1], float positions pass through unchanged
+float3 DequantizePosition(float3 PosL)
+{
+	return gPosDequantMin + PosL * gPosDequantExtent;
+}
+
 cbuffer cbPass
 {
     float4x4 gView;
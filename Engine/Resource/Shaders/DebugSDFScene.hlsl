@@ -32,60 +32,35 @@ void RayMarchDistanceFields(float3 WorldRayStart, float3 WorldRayEnd, float MaxR
 	MinRayTime = MaxRayTime;
 	TotalStepsTaken = 0;
 	
-	for (uint i = 0; i < gObjectCount; i++)
+	float3 RayDir = normalize(WorldRayEnd - WorldRayStart);
+	float RayLength = length(WorldRayEnd - WorldRayStart);
+	
+	float SampleRayTime = 0.0f;
+	int Step = 0;
+	
+	[loop]
+	for (; Step < MAX_SDF_STEP; Step++)
 	{
-		int SDFIndex = ObjectSDFDescriptors[i].SDFIndex;
+		float3 SamplePosition = WorldRayStart + SampleRayTime * RayDir;
+		float DistanceField = SampleSceneDistanceField(SamplePosition, 0.0f);
 		
-		float3 LocalRayStart = mul(float4(WorldRayStart, 1.0f), ObjectSDFDescriptors[i].ObjInvWorld).xyz;
-		float3 LocalRayEnd = mul(float4(WorldRayEnd, 1.0f), ObjectSDFDescriptors[i].ObjInvWorld).xyz;
-		float3 LocalRayDir = LocalRayEnd - LocalRayStart;
-		LocalRayDir = normalize(LocalRayDir);
-		float LocalRayLength = length(LocalRayEnd - LocalRayStart);
-				
-		float Extent = MeshSDFDescriptors[SDFIndex].Extent;
-		int Resolution = MeshSDFDescriptors[SDFIndex].Resolution;
-		float RcpExtent = rcp(Extent);
+		float MinStepSize = 1.0f / (4 * MAX_SDF_STEP);
+		float StepDistance = max(DistanceField, MinStepSize);
+		SampleRayTime += StepDistance;
 		
-		float3 LocalExtent = float3(Extent, Extent, Extent);
-		float2 IntersectionTimes = LineBoxIntersect(LocalRayStart, LocalRayEnd, -LocalExtent, LocalExtent);	
-		
-		[branch]
-		if (IntersectionTimes.x < IntersectionTimes.y && IntersectionTimes.x < 1)
-		{	
-			float SampleRayTime = IntersectionTimes.x * LocalRayLength;
-			
-			float MinDistance = 1000000;
-			int Step = 0;			
-			
-			[loop]
-			for (; Step < MAX_SDF_STEP; Step++)
-			{
-				float3 SampleLocalPosition = LocalRayStart + SampleRayTime * LocalRayDir;
-				float3 ClampedSamplePosition = clamp(SampleLocalPosition, -LocalExtent, LocalExtent);
-				float3 VolumeUV = (ClampedSamplePosition * RcpExtent) * 0.5f + 0.5f;
-				float SDFWidth = Extent * 2.0f;
-				float DistanceField = SampleMeshDistanceField(SDFIndex, VolumeUV, SDFWidth);
-				MinDistance = min(MinDistance, DistanceField);
-				
-				float MinStepSize = 1.0f / (4 * MAX_SDF_STEP);
-				float StepDistance = max(DistanceField, MinStepSize);
-				SampleRayTime += StepDistance;
-				
-				// Terminate the trace if we reached a negative area or went past the end of the ray
-				if (DistanceField < 0 || SampleRayTime > IntersectionTimes.y * LocalRayLength)
-				{
-					break;
-				}
-			}
-			
-			if (MinDistance < 0 || Step == MAX_SDF_STEP)
-			{
-				MinRayTime = min(MinRayTime, SampleRayTime);
-			}
-				
-			TotalStepsTaken += Step;
+		// Terminate the trace if we reached a negative area or went past the end of the ray
+		if (DistanceField < 0 || SampleRayTime > RayLength)
+		{
+			break;
 		}
-	}	
+	}
+	
+	if (SampleRayTime <= RayLength)
+	{
+		MinRayTime = SampleRayTime;
+	}
+	
+	TotalStepsTaken = Step;
 }
 
 float4 PS(VertexOut pin) : SV_Target
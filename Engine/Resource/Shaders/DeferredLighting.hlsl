@@ -6,10 +6,10 @@ Texture2D NormalGbuffer;
 Texture2D WorldPosGbuffer;
 Texture2D OrmGbuffer;
 Texture2D EmissiveGbuffer;
-TextureCube IBLIrradianceMap;
 
+// Mip m is prefiltered with roughness m / (IBL_PREFILTER_ENVMAP_MIP_LEVEL - 1)
 #define IBL_PREFILTER_ENVMAP_MIP_LEVEL 5
-TextureCube IBLPrefilterEnvMaps[IBL_PREFILTER_ENVMAP_MIP_LEVEL];
+TextureCube IBLPrefilterEnvMap;
 
 Texture2D BrdfLUT;
 
@@ -31,6 +31,9 @@ StructuredBuffer<TileLightInfo> LightInfoList;
 cbuffer cbDeferredLighting
 {
 	uint EnableSSAO;
+	
+	// Irradiance / PI as 3rd order SH, see TSHIrradiance
+	float4 IBLIrradianceSH[9];
 };
 
 struct VertexIn
@@ -58,17 +61,27 @@ VertexOut VS(VertexIn vin)
     return vout;
 }
 
+float3 GetIrradiance(float3 N)
+{
+	float3 Irradiance = IBLIrradianceSH[0].rgb * 0.282095f
+		+ IBLIrradianceSH[1].rgb * (0.488603f * N.y)
+		+ IBLIrradianceSH[2].rgb * (0.488603f * N.z)
+		+ IBLIrradianceSH[3].rgb * (0.488603f * N.x)
+		+ IBLIrradianceSH[4].rgb * (1.092548f * N.x * N.y)
+		+ IBLIrradianceSH[5].rgb * (1.092548f * N.y * N.z)
+		+ IBLIrradianceSH[6].rgb * (0.315392f * (3.0f * N.z * N.z - 1.0f))
+		+ IBLIrradianceSH[7].rgb * (1.092548f * N.x * N.z)
+		+ IBLIrradianceSH[8].rgb * (0.546274f * (N.x * N.x - N.y * N.y));
+
+	// Ringing can go slightly negative opposite a bright light
+	return max(Irradiance, 0.0f);
+}
+
 float3 GetPrefilteredColor(float Roughness, float3 ReflectDir)
 {
+	// Trilinear filtering blends the two nearest roughness mips
 	float Level = Roughness * (IBL_PREFILTER_ENVMAP_MIP_LEVEL - 1);
-	int FloorLevel = floor(Level);
-	int CeilLevel = ceil(Level);
-
-	float3 FloorSample = IBLPrefilterEnvMaps[FloorLevel].SampleLevel(gsamLinearClamp, ReflectDir, 0).rgb;
-	float3 CeilSample = IBLPrefilterEnvMaps[CeilLevel].SampleLevel(gsamLinearClamp, ReflectDir, 0).rgb;
-	
-	float3 PrefilteredColor = lerp(FloorSample, CeilSample, (Level - FloorLevel));
-	return PrefilteredColor;
+	return IBLPrefilterEnvMap.SampleLevel(gsamLinearClamp, ReflectDir, Level).rgb;
 }
 
 float4 PS(VertexOut pin) : SV_TARGET
@@ -128,7 +141,7 @@ float4 PS(VertexOut pin) : SV_TARGET
 			if (Light.LightType == 1) 
 			{
 				// Irradiance
-				float3 Irradiance = IBLIrradianceMap.SampleLevel(gsamLinearClamp, Normal, 0).rgb;
+				float3 Irradiance = GetIrradiance(Normal);
 			
 				// PrefilteredColor
 				float3 ReflectDir = reflect(-ViewDir, Normal);
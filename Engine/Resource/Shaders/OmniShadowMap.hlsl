@@ -16,7 +16,7 @@ VertexOut VS(VertexIn vin)
 	VertexOut Out = (VertexOut)0.0f;
 	
     // Transform to world space.
-    float4 PosW = mul(float4(vin.PosL, 1.0f), gWorld);
+    float4 PosW = mul(float4(DequantizePosition(vin.PosL), 1.0f), gWorld);
 	Out.PosW = PosW.xyz;
 	
     // Transform to homogeneous clip space.
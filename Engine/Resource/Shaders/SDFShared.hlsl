@@ -1,18 +1,30 @@
 #include "Common.hlsl"
 
 #define MAX_SDF_STEP 256
-#define MAX_SDF_TEXTURE_COUNT 20
 #define EIGHT_BIT_MESH_DISTANCE_FIELDS 1
 
+// Match SDFBrickAtlas.h
+#define SDF_BRICK_SIZE 8
+#define SDF_BRICK_APRON 1
+#define SDF_BRICK_STORED_SIZE 10
+#define SDF_EMPTY_BRICK_FLAG 0x80000000
+
+// Match MeshSDFLayout.h
+#define MESH_SDF_DISTANCE_BAND_VOXELS 8
+
+// Match GlobalDistanceField.h
+#define GLOBAL_SDF_LEVEL_COUNT 4
+
 struct MeshSDFDescriptor
 {
 	float3 Center;
-	float Extent;
+	float VoxelSize;
 	
-	int Resolution;
-	int pad1;
-	int pad2;
-	int pad3;
+	float3 Extent;
+	int IndirectionOffset;
+	
+	int3 Resolution;
+	int pad0;
 };
 
 struct ObjectSDFDescriptor
@@ -22,7 +34,7 @@ struct ObjectSDFDescriptor
 	float4x4 ObjInvWorld_IT;
 	
 	int SDFIndex;
-	int pad1;
+	float LocalToWorldScale;
 	int pad2;
 	int pad3;
 };
@@ -30,23 +42,166 @@ struct ObjectSDFDescriptor
 cbuffer cbSDF
 {	
 	uint gObjectCount;
-	uint Pad1;
-	uint Pad2;
-	uint Pad3;
+	uint gBrickAtlasSlotsX;
+	uint gBrickAtlasSlotsY;
+	uint gBrickAtlasSlotsZ;
+	
+	// xyz first world voxel of the level window, w voxel size
+	float4 gGlobalSDFLevels[GLOBAL_SDF_LEVEL_COUNT];
+	
+	uint gGlobalSDFResolution;
+	float gGlobalSDFTruncationVoxels;
+	
+	// Traces read the object fields below this distance
+	float gGlobalSDFRefineDistance;
+	uint gGlobalSDFEnabled;
+	
+	// Uniform grid over the object SDF bounds
+	float3 gObjectGridOrigin;
+	float gObjectGridCellSize;
+	uint3 gObjectGridDims;
+	
+	// Objects farther than this from a cell are not binned into it
+	float gObjectGridInfluenceRadius;
 };
 
-Texture3D SDFTextures[MAX_SDF_TEXTURE_COUNT];
+// Narrow band bricks of every mesh, each slot stores SDF_BRICK_SIZE voxels plus the apron per axis
+Texture3D SDFBrickAtlas;
+
+// Per mesh brick grid, x fastest. Atlas slot index or SDF_EMPTY_BRICK_FLAG | 8 bit distance closest to the surface.
+StructuredBuffer<uint> SDFBrickIndirection;
+
+// Camera centered clipmap levels of the scene distance field, world voxel V is stored at texel V mod gGlobalSDFResolution
+Texture3D GlobalSDFLevels[GLOBAL_SDF_LEVEL_COUNT];
 
 StructuredBuffer<MeshSDFDescriptor> MeshSDFDescriptors; 
 StructuredBuffer<ObjectSDFDescriptor> ObjectSDFDescriptors; 
 
-float SampleMeshDistanceField(float SDFIndex, float3 VolumeUV, float SDFWidth)
+// Per grid cell, x fastest. x offset into SDFObjectGridIndices, y object count.
+StructuredBuffer<uint2> SDFObjectGridCells;
+
+// ObjectSDFDescriptors indices binned into the cells
+StructuredBuffer<uint> SDFObjectGridIndices;
+
+// DistanceRange is MESH_SDF_DISTANCE_BAND_VOXELS voxels, the R8 texels map [-DistanceRange, DistanceRange] to [0, 1]
+float SampleMeshDistanceField(int SDFIndex, float3 VolumeUV, float DistanceRange)
 {
-	float DistanceField = SDFTextures[SDFIndex].SampleLevel(gsamLinearClamp, VolumeUV, 0).x;				
+	int3 Resolution = MeshSDFDescriptors[SDFIndex].Resolution;
+	int3 BrickDim = (Resolution + SDF_BRICK_SIZE - 1) / SDF_BRICK_SIZE;
+	
+	float3 VoxelPosition = VolumeUV * Resolution;
+	int3 Brick = clamp(int3(floor(VoxelPosition / SDF_BRICK_SIZE)), 0, BrickDim - 1);
+	
+	uint BrickIndex = (Brick.z * BrickDim.y + Brick.y) * BrickDim.x + Brick.x;
+	uint Entry = SDFBrickIndirection[MeshSDFDescriptors[SDFIndex].IndirectionOffset + BrickIndex];
+	
+	float DistanceField;
+	
+	[branch]
+	if (Entry & SDF_EMPTY_BRICK_FLAG)
+	{
+		// Far from the surface, step by the closest distance over the brick
+		DistanceField = (Entry & 0xFF) / 255.0f;
+	}
+	else
+	{
+		uint3 Slot = uint3(Entry % gBrickAtlasSlotsX, (Entry / gBrickAtlasSlotsX) % gBrickAtlasSlotsY, Entry / (gBrickAtlasSlotsX * gBrickAtlasSlotsY));
+		float3 AtlasPosition = Slot * SDF_BRICK_STORED_SIZE + SDF_BRICK_APRON + (VoxelPosition - Brick * SDF_BRICK_SIZE);
+		float3 AtlasSize = float3(gBrickAtlasSlotsX, gBrickAtlasSlotsY, gBrickAtlasSlotsZ) * SDF_BRICK_STORED_SIZE;
+		
+		DistanceField = SDFBrickAtlas.SampleLevel(gsamLinearClamp, AtlasPosition / AtlasSize, 0).x;
+	}
+	
 #if EIGHT_BIT_MESH_DISTANCE_FIELDS
-	DistanceField = (DistanceField - 0.5f) * 2.0f * SDFWidth;
+	DistanceField = (DistanceField - 0.5f) * 2.0f * DistanceRange;
 #endif
 	
 	return DistanceField;
 }
 
+// World space distance to one object, a lower bound outside its SDF volume
+float SampleObjectDistanceField(uint ObjectIndex, float3 PositionW)
+{
+	int SDFIndex = ObjectSDFDescriptors[ObjectIndex].SDFIndex;
+	float3 Extent = MeshSDFDescriptors[SDFIndex].Extent;
+	
+	float3 LocalPosition = mul(float4(PositionW, 1.0f), ObjectSDFDescriptors[ObjectIndex].ObjInvWorld).xyz;
+	float3 ClampedPosition = clamp(LocalPosition, -Extent, Extent);
+	float BoxDistance = length(LocalPosition - ClampedPosition);
+	
+	float3 VolumeUV = (ClampedPosition / Extent) * 0.5f + 0.5f;
+	float DistanceField = SampleMeshDistanceField(SDFIndex, VolumeUV, MESH_SDF_DISTANCE_BAND_VOXELS * MeshSDFDescriptors[SDFIndex].VoxelSize);
+	
+	// Outside the volume the clamped sample only bounds the distance
+	float LocalDistance = BoxDistance > 0 ? max(BoxDistance, DistanceField - BoxDistance) : DistanceField;
+	
+	return LocalDistance * ObjectSDFDescriptors[ObjectIndex].LocalToWorldScale;
+}
+
+// Objects binned into the grid cell of PositionW. Objects outside the cell are farther than the influence radius,
+// so the distance clamps to it and marches pick up new objects as they cross cells.
+float SampleObjectDistanceFields(float3 PositionW)
+{
+	if (gObjectCount == 0)
+	{
+		return 1000000;
+	}
+	
+	float3 GridPosition = (PositionW - gObjectGridOrigin) / gObjectGridCellSize;
+	float3 Outside = max(max(-GridPosition, GridPosition - gObjectGridDims), 0.0f) * gObjectGridCellSize;
+	
+	// Every object is at least the influence radius inside the grid bounds
+	[branch]
+	if (any(Outside > 0.0f))
+	{
+		return length(Outside) + gObjectGridInfluenceRadius;
+	}
+	
+	uint3 Cell = min(uint3(GridPosition), gObjectGridDims - 1);
+	uint2 CellRange = SDFObjectGridCells[(Cell.z * gObjectGridDims.y + Cell.y) * gObjectGridDims.x + Cell.x];
+	
+	float MinDistance = gObjectGridInfluenceRadius;
+	
+	for (uint i = 0; i < CellRange.y; i++)
+	{
+		MinDistance = min(MinDistance, SampleObjectDistanceField(SDFObjectGridIndices[CellRange.x + i], PositionW));
+	}
+	
+	return MinDistance;
+}
+
+// Finest clipmap level holding PositionW with a voxel of margin, so filtering never crosses the toroidal seam
+bool SampleGlobalDistanceField(float3 PositionW, out float Distance)
+{
+	Distance = 0;
+	
+	[unroll]
+	for (int Level = 0; Level < GLOBAL_SDF_LEVEL_COUNT; Level++)
+	{
+		float VoxelSize = gGlobalSDFLevels[Level].w;
+		float3 VoxelPosition = PositionW / VoxelSize;
+		float3 WindowPosition = VoxelPosition - gGlobalSDFLevels[Level].xyz;
+		
+		if (all(WindowPosition >= 1.0f) && all(WindowPosition <= gGlobalSDFResolution - 1.0f))
+		{
+			float Value = GlobalSDFLevels[Level].SampleLevel(gsamLinearWrap, VoxelPosition / gGlobalSDFResolution, 0).x;
+			Distance = (Value * 2.0f - 1.0f) * gGlobalSDFTruncationVoxels * VoxelSize;
+			
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+// Coarse global field where it proves the nearest surface is at least RefineDistance away, the object fields otherwise
+float SampleSceneDistanceField(float3 PositionW, float RefineDistance)
+{
+	float GlobalDistance;
+	if (gGlobalSDFEnabled && SampleGlobalDistanceField(PositionW, GlobalDistance) && GlobalDistance > max(RefineDistance, gGlobalSDFRefineDistance))
+	{
+		return GlobalDistance;
+	}
+	
+	return SampleObjectDistanceFields(PositionW);
+}
@@ -154,57 +154,36 @@ float SDF(float3 ReceiverPosW, float3 LightPosW, float TanLightAngle)
 {
 	float MinConeVisibility = 1.0f;
 	
-	for (uint i = 0; i < gObjectCount; i++)
+	float3 RayDir = LightPosW - ReceiverPosW;
+	float RayLength = length(RayDir);
+	RayDir /= RayLength;
+	
+	float SampleRayTime = 0.0f;
+	
+	[loop]
+	for (int Step = 0; Step < MAX_SDF_STEP; Step++)
 	{
-	    int SDFIndex = ObjectSDFDescriptors[i].SDFIndex;
+		float3 SamplePosition = ReceiverPosW + SampleRayTime * RayDir;
 		
-		float3 LocalRayStart = mul(float4(ReceiverPosW, 1.0f), ObjectSDFDescriptors[i].ObjInvWorld).xyz;
-		float3 LocalRayEnd = mul(float4(LightPosW, 1.0f), ObjectSDFDescriptors[i].ObjInvWorld).xyz;
-		float3 LocalRayDir = LocalRayEnd - LocalRayStart;
-		LocalRayDir = normalize(LocalRayDir);
-		float LocalRayLength = length(LocalRayEnd - LocalRayStart);			
+		// The global field is only trusted where the cone can't reach a surface, so it never changes the visibility
+		float SphereRadius = TanLightAngle * SampleRayTime;
+		float DistanceField = SampleSceneDistanceField(SamplePosition, SphereRadius);
+
+		// Don't allow occlusion within an object's self shadow distance
+		float SelfShadowScale = 100.0f;
+		float SelfShadowVisibility = 1 - saturate(SampleRayTime * SelfShadowScale);
 		
-		float Extent = MeshSDFDescriptors[SDFIndex].Extent;
-		int Resolution = MeshSDFDescriptors[SDFIndex].Resolution;
-		float RcpExtent = rcp(Extent);
+		float StepConeVisibility = max(saturate(DistanceField / SphereRadius), SelfShadowVisibility);			
+		MinConeVisibility = min(MinConeVisibility, StepConeVisibility);							
 		
-		float3 LocalExtent = float3(Extent, Extent, Extent);
-		float2 IntersectionTimes = LineBoxIntersect(LocalRayStart, LocalRayEnd, -LocalExtent, LocalExtent);
+		float MinStepSize = 1.0f / (4 * MAX_SDF_STEP);
+		float StepDistance = max(DistanceField, MinStepSize);
+		SampleRayTime += StepDistance;
 		
-		[branch]
-		if (IntersectionTimes.x < IntersectionTimes.y && IntersectionTimes.x < 1)
-		{	
-			float SampleRayTime = IntersectionTimes.x * LocalRayLength;
-			
-			int Step = 0;			
-			
-			[loop]
-			for (; Step < MAX_SDF_STEP; Step++)
-			{
-				float3 SampleLocalPosition = LocalRayStart + SampleRayTime * LocalRayDir;
-				float3 ClampedSamplePosition = clamp(SampleLocalPosition, -LocalExtent, LocalExtent);
-				float3 VolumeUV = (ClampedSamplePosition * RcpExtent) * 0.5f + 0.5f;
-				float SDFWidth = Extent * 2.0f;
-				float DistanceField = SampleMeshDistanceField(SDFIndex, VolumeUV, SDFWidth);
-
-				// Don't allow occlusion within an object's self shadow distance
-				float SelfShadowScale = 100.0f;
-				float SelfShadowVisibility = 1 - saturate(SampleRayTime * SelfShadowScale);
-				
-				float SphereRadius = TanLightAngle * SampleRayTime;
-				float StepConeVisibility = max(saturate(DistanceField / SphereRadius), SelfShadowVisibility);			
-				MinConeVisibility = min(MinConeVisibility, StepConeVisibility);							
-				
-				float MinStepSize = 1.0f / (4 * MAX_SDF_STEP);
-				float StepDistance = max(DistanceField, MinStepSize);
-				SampleRayTime += StepDistance;
-				
-				// Terminate the trace if we reached a negative area or went past the end of the ray
-				if (DistanceField < 0 || SampleRayTime > IntersectionTimes.y * LocalRayLength)
-				{
-					break;
-				}
-			}
+		// Terminate the trace if we reached a negative area or went past the end of the ray
+		if (DistanceField < 0 || SampleRayTime > RayLength)
+		{
+			break;
 		}
 	}
 	
@@ -15,7 +15,7 @@ VertexOut VS(VertexIn vin)
 	VertexOut Out = (VertexOut)0.0f;
 	
     // Transform to world space.
-    float4 PosW = mul(float4(vin.PosL, 1.0f), gWorld);
+    float4 PosW = mul(float4(DequantizePosition(vin.PosL), 1.0f), gWorld);
 
     // Transform to homogeneous clip space.
     Out.PosH = mul(PosW, gViewProj);
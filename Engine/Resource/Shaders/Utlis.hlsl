@@ -14,6 +14,15 @@ float Pow4( float x )
 	return xx * xx;
 }
 
+// Rebuilds z of a tangent space normal map sample from x and y, so BC5 (two channel) normal maps work.
+float3 ReconstructNormalMapSample(float2 NormalMapSampleXY)
+{
+	float2 XY = 2.0f * NormalMapSampleXY - 1.0f;
+	float Z = sqrt(saturate(1.0f - dot(XY, XY)));
+
+	return float3(NormalMapSampleXY, Z * 0.5f + 0.5f);
+}
+
 // Transforms a normal map sample to world space.
 float3 NormalSampleToWorldSpace(float3 NormalMapSample, float3 UnitNormalW, float3 TangentW)
 {
@@ -33,6 +42,19 @@ float3 NormalSampleToWorldSpace(float3 NormalMapSample, float3 UnitNormalW, floa
 	return BumpedNormalW;
 }
 
+// Decodes an octahedral unit vector stored as R16G16_SNORM
+float3 DecodeOctahedral(float2 Encoded)
+{
+	float3 V = float3(Encoded, 1.0f - abs(Encoded.x) - abs(Encoded.y));
+	if (V.z < 0.0f)
+	{
+		float2 Sign = float2(V.x >= 0.0f ? 1.0f : -1.0f, V.y >= 0.0f ? 1.0f : -1.0f);
+		V.xy = (1.0f - abs(V.yx)) * Sign;
+	}
+
+	return normalize(V);
+}
+
 /*
 * Clips a ray to an AABB.  Does not handle rays parallel to any of the planes.
 *
@@ -21,6 +21,11 @@ void TStaticMeshActor::SetMaterialInstance(std::string MaterialInstanceName)
 	StaticMeshComponent->SetMaterialInstance(MaterialInstanceName);
 }
 
+void TStaticMeshActor::SetMaterialInstance(UINT MaterialSlot, std::string MaterialInstanceName)
+{
+	StaticMeshComponent->SetMaterialInstance(MaterialSlot, MaterialInstanceName);
+}
+
 void TStaticMeshActor::SetTextureScale(const TVector2& Scale)
 {
 	StaticMeshComponent->TexTransform = TMatrix::CreateScale(Scale.x, Scale.y, 1.0f);
@@ -14,6 +14,8 @@ public:
 
 	void SetMaterialInstance(std::string MaterialInstanceName);
 
+	void SetMaterialInstance(UINT MaterialSlot, std::string MaterialInstanceName);
+
 	void SetTextureScale(const TVector2& Scale);
 
 	void SetUseSDF(bool bUseSDF);
@@ -13,6 +13,7 @@ public:
 	virtual void SetWorldLocation(const TVector3& Location)
 	{
 		WorldTransform.Location = Location;
+		TransformVersion++;
 	}
 
 	TVector3 GetWorldLocation() const
@@ -23,6 +24,7 @@ public:
 	virtual void SetWorldRotation(const TRotator& Rotation)
 	{
 		WorldTransform.Rotation = Rotation;
+		TransformVersion++;
 	}
 
 	TRotator GetWorldRotation() const
@@ -33,6 +35,7 @@ public:
 	void SetWorldTransform(const TTransform& Transform)
 	{
 		WorldTransform = Transform;
+		TransformVersion++;
 	}
 
 	TTransform GetWorldTransform() const
@@ -50,10 +53,18 @@ public:
 		return PrevWorldTransform;
 	}
 
+	// Bumped by every world transform change, lets caches skip unchanged components
+	uint32_t GetTransformVersion() const
+	{
+		return TransformVersion;
+	}
+
 protected:
 	TTransform RelativeTransform; //TODO
 
 	TTransform WorldTransform;
 
 	TTransform PrevWorldTransform;
+
+	uint32_t TransformVersion = 0;
 };
@@ -55,4 +55,25 @@ void TMeshComponent::SetMaterialInstance(std::string MaterialInstanceName)
 	MaterialInstance = TMaterialRepository::Get().GetMaterialInstance(MaterialInstanceName);
 
 	assert(MaterialInstance);  //TODO
-}
\ No newline at end of file
+}
+void TMeshComponent::SetMaterialInstance(UINT MaterialSlot, std::string MaterialInstanceName)
+{
+	if (MaterialSlot >= SlotMaterialInstances.size())
+	{
+		SlotMaterialInstances.resize(MaterialSlot + 1, nullptr);
+	}
+
+	SlotMaterialInstances[MaterialSlot] = TMaterialRepository::Get().GetMaterialInstance(MaterialInstanceName);
+
+	assert(SlotMaterialInstances[MaterialSlot]);  //TODO
+}
+
+TMaterialInstance* TMeshComponent::GetMaterialInstance(UINT MaterialSlot)
+{
+	if (MaterialSlot < SlotMaterialInstances.size() && SlotMaterialInstances[MaterialSlot])
+	{
+		return SlotMaterialInstances[MaterialSlot];
+	}
+
+	return MaterialInstance;
+}
@@ -22,6 +22,11 @@ public:
 
 	TMaterialInstance* GetMaterialInstance() { return MaterialInstance; }
 
+	// Override for one material slot of the mesh, other slots use the default material instance
+	void SetMaterialInstance(UINT MaterialSlot, std::string MaterialInstanceName);
+
+	TMaterialInstance* GetMaterialInstance(UINT MaterialSlot);
+
 public:
 	TMatrix TexTransform = TMatrix::Identity;
 
@@ -32,4 +37,7 @@ private:
 	std::string MeshName;
 
 	TMaterialInstance* MaterialInstance;
+
+	// Indexed by material slot, null entries fall back to MaterialInstance
+	std::vector<TMaterialInstance*> SlotMaterialInstances;
 };
\ No newline at end of file
@@ -0,0 +1,218 @@
+#include "AssetCooker.h"
+#include "File/MappedFile.h"
+#include "Utils/Hash.h"
+#include "Utils/ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+std::string TCookStats::ToString() const
+{
+	char Buffer[256];
+	snprintf(Buffer, sizeof(Buffer), "Cooked %u, up to date %u, failed %u of %u assets in %.2f s",
+		CookedCount, SkippedCount, FailedCount, TaskCount, WallSeconds);
+
+	return std::string(Buffer);
+}
+
+bool TCookManifest::Load(const std::wstring& FilePath)
+{
+	Entries.clear();
+
+	std::ifstream File(std::filesystem::path(FilePath), std::ios::in);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	std::string Line;
+	while (std::getline(File, Line))
+	{
+		std::istringstream Stream(Line);
+
+		std::string AssetName;
+		std::string HashText;
+		TEntry Entry;
+		if (Stream >> AssetName >> HashText >> Entry.ToolVersion)
+		{
+			Entry.InputHash = std::stoull(HashText, nullptr, 16);
+			Entries[AssetName] = Entry;
+		}
+	}
+
+	return true;
+}
+
+bool TCookManifest::Save(const std::wstring& FilePath) const
+{
+	const std::filesystem::path TargetPath(FilePath);
+	std::filesystem::path TempPath = TargetPath;
+	TempPath += L".tmp";
+
+	std::error_code Error;
+	std::filesystem::create_directories(TargetPath.parent_path(), Error);
+
+	{
+		std::ofstream File(TempPath, std::ios::out | std::ios::trunc);
+		if (!File.is_open())
+		{
+			return false;
+		}
+
+		for (const auto& Pair : Entries)
+		{
+			char HashText[32];
+			snprintf(HashText, sizeof(HashText), "%016llx", (unsigned long long)Pair.second.InputHash);
+
+			File << Pair.first << " " << HashText << " " << Pair.second.ToolVersion << "\n";
+		}
+
+		if (!File.good())
+		{
+			return false;
+		}
+	}
+
+	std::filesystem::rename(TempPath, TargetPath, Error);
+
+	return !Error;
+}
+
+const TCookManifest::TEntry* TCookManifest::Find(const std::string& AssetName) const
+{
+	auto Iter = Entries.find(AssetName);
+
+	return Iter != Entries.end() ? &Iter->second : nullptr;
+}
+
+void TCookManifest::Set(const std::string& AssetName, const TEntry& Entry)
+{
+	Entries[AssetName] = Entry;
+}
+
+TAssetCooker::TAssetCooker(TThreadPool& InThreadPool, const std::wstring& InManifestPath)
+	:ThreadPool(InThreadPool), ManifestPath(InManifestPath)
+{
+}
+
+void TAssetCooker::AddTask(TCookTask Task)
+{
+	Tasks.push_back(std::move(Task));
+}
+
+bool TAssetCooker::HashFiles(const std::vector<std::wstring>& FilePaths, uint64_t& OutHash)
+{
+	uint64_t Hash = THash::HashBytes(nullptr, 0);
+
+	for (const std::wstring& FilePath : FilePaths)
+	{
+		TMappedFile File;
+		if (!File.Open(FilePath))
+		{
+			return false;
+		}
+
+		Hash = THash::Combine(Hash, THash::HashBytes(File.GetData(), File.GetSize()));
+	}
+
+	OutHash = Hash;
+
+	return true;
+}
+
+TCookStats TAssetCooker::Run(bool bForce)
+{
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	TCookManifest Manifest;
+	if (!bForce)
+	{
+		Manifest.Load(ManifestPath);
+	}
+
+	const uint32_t TaskCount = (uint32_t)Tasks.size();
+
+	TCookStats Stats;
+	Stats.TaskCount = TaskCount;
+	Stats.Results.resize(TaskCount);
+
+	// Fingerprint every task, sources are read in parallel
+	std::vector<uint64_t> InputHashes(TaskCount, 0);
+	std::vector<uint8_t> DirtyFlags(TaskCount, 0);
+	std::vector<uint8_t> HashedFlags(TaskCount, 0);
+
+	ThreadPool.ParallelFor(TaskCount, [&](uint32_t TaskIdx)
+	{
+		const TCookTask& Task = Tasks[TaskIdx];
+
+		HashedFlags[TaskIdx] = HashFiles(Task.SourceFiles, InputHashes[TaskIdx]);
+
+		bool bDirty = bForce || !HashedFlags[TaskIdx];
+
+		const TCookManifest::TEntry* Entry = Manifest.Find(Task.AssetName);
+		bDirty = bDirty || !Entry || Entry->InputHash != InputHashes[TaskIdx] || Entry->ToolVersion != Task.ToolVersion;
+
+		for (const std::wstring& OutputFile : Task.OutputFiles)
+		{
+			std::error_code Error;
+			bDirty = bDirty || !std::filesystem::exists(OutputFile, Error);
+		}
+
+		DirtyFlags[TaskIdx] = bDirty;
+	});
+
+	ThreadPool.ParallelFor(TaskCount, [&](uint32_t TaskIdx)
+	{
+		const TCookTask& Task = Tasks[TaskIdx];
+		TCookTaskResult& Result = Stats.Results[TaskIdx];
+		Result.AssetName = Task.AssetName;
+
+		if (!DirtyFlags[TaskIdx])
+		{
+			return;
+		}
+
+		auto TaskStartTime = std::chrono::high_resolution_clock::now();
+
+		// Stale outputs must not survive a failed cook
+		for (const std::wstring& OutputFile : Task.OutputFiles)
+		{
+			std::error_code Error;
+			std::filesystem::remove(OutputFile, Error);
+		}
+
+		Result.bCooked = true;
+		Result.bSuccess = HashedFlags[TaskIdx] && Task.Cook && Task.Cook();
+		Result.Seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - TaskStartTime).count();
+	});
+
+	for (uint32_t TaskIdx = 0; TaskIdx < TaskCount; TaskIdx++)
+	{
+		const TCookTaskResult& Result = Stats.Results[TaskIdx];
+		if (!Result.bCooked)
+		{
+			Stats.SkippedCount++;
+		}
+		else if (Result.bSuccess)
+		{
+			Stats.CookedCount++;
+
+			TCookManifest::TEntry Entry;
+			Entry.InputHash = InputHashes[TaskIdx];
+			Entry.ToolVersion = Tasks[TaskIdx].ToolVersion;
+			Manifest.Set(Tasks[TaskIdx].AssetName, Entry);
+		}
+		else
+		{
+			Stats.FailedCount++;
+		}
+	}
+
+	Manifest.Save(ManifestPath);
+
+	Stats.WallSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - StartTime).count();
+
+	return Stats;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+
+class TThreadPool;
+
+struct TCookTask
+{
+	// Manifest key, unique per task and without spaces
+	std::string AssetName;
+
+	// Content hashed to decide whether the task is dirty
+	std::vector<std::wstring> SourceFiles;
+
+	// A missing output also makes the task dirty
+	std::vector<std::wstring> OutputFiles;
+
+	// Changing it recooks the task, bump with the processor or its output format. No spaces.
+	std::string ToolVersion;
+
+	// Writes OutputFiles, runs on a pool thread
+	std::function<bool()> Cook;
+};
+
+struct TCookTaskResult
+{
+	std::string AssetName;
+
+	bool bCooked = false;
+
+	bool bSuccess = true;
+
+	double Seconds = 0.0;
+};
+
+struct TCookStats
+{
+	uint32_t TaskCount = 0;
+
+	uint32_t CookedCount = 0;
+
+	uint32_t SkippedCount = 0;
+
+	uint32_t FailedCount = 0;
+
+	double WallSeconds = 0.0;
+
+	std::vector<TCookTaskResult> Results;
+
+	std::string ToString() const;
+};
+
+// Text file with one "AssetName InputHash ToolVersion" line per cooked asset
+class TCookManifest
+{
+public:
+	struct TEntry
+	{
+		uint64_t InputHash = 0;
+
+		std::string ToolVersion;
+	};
+
+	bool Load(const std::wstring& FilePath);
+
+	// Written to a temporary file and renamed
+	bool Save(const std::wstring& FilePath) const;
+
+	const TEntry* Find(const std::string& AssetName) const;
+
+	void Set(const std::string& AssetName, const TEntry& Entry);
+
+private:
+	// Sorted so the manifest diffs cleanly
+	std::map<std::string, TEntry> Entries;
+};
+
+// Headless cook of source assets into runtime files. Only tasks whose source contents, tool version or outputs
+// changed since the last run are cooked, independent tasks run in parallel on the thread pool.
+class TAssetCooker
+{
+public:
+	TAssetCooker(TThreadPool& InThreadPool, const std::wstring& InManifestPath);
+
+	void AddTask(TCookTask Task);
+
+	// bForce cooks every task regardless of the manifest
+	TCookStats Run(bool bForce);
+
+	// Combined content hash of the files in order, false if one can not be read
+	static bool HashFiles(const std::vector<std::wstring>& FilePaths, uint64_t& OutHash);
+
+private:
+	TThreadPool& ThreadPool;
+
+	std::wstring ManifestPath;
+
+	std::vector<TCookTask> Tasks;
+};
@@ -0,0 +1,49 @@
+#include "MeshCookTasks.h"
+#include "AssetCooker.h"
+#include "File/FileHelpers.h"
+#include "Mesh/CookedMesh.h"
+#include "Mesh/FbxLoader.h"
+#include "Mesh/MeshAssets.h"
+#include "Mesh/MeshSDFBuilder.h"
+#include "Utils/ThreadPool.h"
+
+void AddMeshCookTasks(TAssetCooker& Cooker)
+{
+	const std::string ToolVersion = "Mesh" + std::to_string(CookedMeshVersion) + "-SDF" + std::to_string(MeshSDFVersion);
+
+	for (const TFbxMeshAsset& Asset : GetFbxMeshAssets())
+	{
+		TCookTask Task;
+		Task.AssetName = Asset.MeshName;
+		Task.SourceFiles.push_back(TFileHelpers::EngineDir() + L"Resource/Models/" + Asset.FileName);
+		Task.OutputFiles.push_back(GetCookedMeshPath(Asset.FileName));
+		Task.OutputFiles.push_back(GetMeshSDFPath(Asset.MeshName));
+		Task.ToolVersion = ToolVersion;
+
+		const std::string MeshName = Asset.MeshName;
+		const std::wstring FileName = Asset.FileName;
+		const std::wstring CookedMeshPath = Task.OutputFiles[0];
+
+		Task.Cook = [MeshName, FileName, CookedMeshPath]()
+		{
+			// FBX SDK managers are not shared between threads, every task gets its own loader
+			TFbxLoader FbxLoader;
+			FbxLoader.Init();
+
+			// The cooked mesh was removed before the task ran, so this imports and writes it
+			TMesh Mesh;
+			Mesh.MeshName = MeshName;
+			if (!FbxLoader.LoadFBXMesh(FileName, Mesh) || !TFileHelpers::IsFileExit(CookedMeshPath))
+			{
+				return false;
+			}
+
+			std::vector<uint8_t> MeshSDF;
+			BuildMeshSDF(Mesh, MeshSDF, TThreadPool::Get());
+
+			return SaveMeshSDF(GetMeshSDFPath(MeshName), GetMeshSDFBakeKey(Mesh), MeshSDF);
+		};
+
+		Cooker.AddTask(std::move(Task));
+	}
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+class TAssetCooker;
+
+// One task per GetFbxMeshAssets() FBX asset: the cooked mesh (Save/CookedMesh) and its SDF (Save/MeshSDF)
+void AddMeshCookTasks(TAssetCooker& Cooker);
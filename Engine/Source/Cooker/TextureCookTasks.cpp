@@ -0,0 +1,153 @@
+#include "TextureCookTasks.h"
+#include "AssetCooker.h"
+#include "File/FileHelpers.h"
+#include "Texture/TextureAssets.h"
+#include "TextureLoader/DDSWriter.h"
+#include "TextureLoader/MipGenerator.h"
+#include "TextureLoader/TextureDecodePipeline.h"
+#include "Utils/FormatConvert.h"
+#include "Utils/ThreadPool.h"
+#include <cstdio>
+
+namespace
+{
+	// Bump when the compressor output changes
+	const uint32_t TextureCookVersion = 1;
+
+	const char* GetQualityName(EBlockCompressQuality Quality)
+	{
+		switch (Quality)
+		{
+		case EBlockCompressQuality::Fast:
+			return "Fast";
+		case EBlockCompressQuality::Normal:
+			return "Normal";
+		default:
+			return "High";
+		}
+	}
+
+	bool HasSuffix(const std::string& Name, const std::string& Suffix)
+	{
+		return Name.size() >= Suffix.size() && Name.compare(Name.size() - Suffix.size(), Suffix.size(), Suffix) == 0;
+	}
+
+	EBlockFormat ChooseBlockFormat(const std::string& TextureName, const TDecodedImage& Image, bool bLegacyFormats)
+	{
+		if (Image.Format == EDecodedImageFormat::RGB32F)
+		{
+			return EBlockFormat::BC6H;
+		}
+
+		// Tangent space x and y, the base pass rebuilds z
+		if (IsNormalMap(TextureName))
+		{
+			return EBlockFormat::BC5;
+		}
+
+		// Shaders only read red from masks
+		if (Image.Format == EDecodedImageFormat::R8 || HasSuffix(TextureName, "_Metallic") || HasSuffix(TextureName, "_Roughness"))
+		{
+			return EBlockFormat::BC4;
+		}
+
+		if (!bLegacyFormats)
+		{
+			return EBlockFormat::BC7;
+		}
+
+		for (size_t i = 3; i < Image.Data.size(); i += 4)
+		{
+			if (Image.Data[i] < 255)
+			{
+				return EBlockFormat::BC3;
+			}
+		}
+
+		return EBlockFormat::BC1;
+	}
+
+	bool CookTexture(const TTextureAsset& Asset, const std::wstring& SourcePath, const std::wstring& CookedPath, const TTextureCookSettings& Settings)
+	{
+		const std::string SourceFile = TFormatConvert::WStrToStr(SourcePath);
+
+		// Before decoding, so the sidecar never claims a newer source than the one cooked
+		TCookedTextureSourceKey SourceKey;
+		if (!GetCookedTextureSourceKey(SourcePath, SourceKey))
+		{
+			return false;
+		}
+
+		std::vector<uint8_t> FileData;
+		TDecodedImage Image;
+		if (!TTextureDecodePipeline::ReadFile(SourceFile, 8 * 1024 * 1024, FileData)
+			|| !DecodeImageFromMemory(FileData.data(), FileData.size(), GetImageFileType(SourceFile), Image))
+		{
+			return false;
+		}
+
+		// D3D12 needs the top mip of a block compressed texture to be a multiple of 4
+		if (Image.Width % 4 != 0 || Image.Height % 4 != 0)
+		{
+			printf("%-16s %ux%u is not a multiple of 4, can not block compress\n", Asset.TextureName.c_str(), Image.Width, Image.Height);
+			return false;
+		}
+
+		// Same mip chain as TTextureRepository::LoadTextureResources builds at runtime
+		TMipGenSettings MipSettings;
+		MipSettings.bSRGB = Asset.bSRGB;
+		MipSettings.bNormalMap = IsNormalMap(Asset.TextureName);
+		MipSettings.bWrap = (Image.Format != EDecodedImageFormat::RGB32F);
+		GenerateMips(Image, MipSettings, TThreadPool::Get());
+
+		TBlockCompressSettings CompressSettings;
+		CompressSettings.Format = ChooseBlockFormat(Asset.TextureName, Image, Settings.bLegacyFormats);
+		CompressSettings.Quality = Settings.Quality;
+		CompressSettings.bSRGB = Asset.bSRGB;
+
+		TCompressedImage Compressed;
+		TBlockCompressStats Stats;
+		if (!CompressImage(Image, CompressSettings, TThreadPool::Get(), Compressed, &Stats))
+		{
+			return false;
+		}
+
+		printf("%-16s %s\n", Asset.TextureName.c_str(), Stats.ToString().c_str());
+
+		return SaveCompressedDDS(CookedPath, Compressed) && SaveCookedTextureSourceKey(CookedPath, SourceKey);
+	}
+}
+
+void AddTextureCookTasks(TAssetCooker& Cooker, const TTextureCookSettings& Settings)
+{
+	const std::string ToolVersion = "Texture" + std::to_string(TextureCookVersion) + "-" + GetQualityName(Settings.Quality)
+		+ (Settings.bLegacyFormats ? "-Legacy" : "");
+
+	for (const TTextureAsset& Asset : GetTextureAssets())
+	{
+		// Lookup tables are sampled at their exact values
+		const std::string FileName = TFormatConvert::WStrToStr(Asset.FileName);
+		const EImageFileType FileType = GetImageFileType(FileName);
+		if (!Asset.bGenerateMips || (FileType != EImageFileType::PNG && FileType != EImageFileType::JPG && FileType != EImageFileType::HDR))
+		{
+			continue;
+		}
+
+		TCookTask Task;
+		Task.AssetName = Asset.TextureName;
+		Task.SourceFiles.push_back(TFileHelpers::EngineDir() + L"Resource/Textures/" + Asset.FileName);
+		Task.OutputFiles.push_back(GetCookedTexturePath(Asset.TextureName));
+		Task.OutputFiles.push_back(GetCookedTextureSourceKeyPath(Task.OutputFiles[0]));
+		Task.ToolVersion = ToolVersion;
+
+		const std::wstring SourcePath = Task.SourceFiles[0];
+		const std::wstring CookedPath = Task.OutputFiles[0];
+
+		Task.Cook = [Asset, SourcePath, CookedPath, Settings]()
+		{
+			return CookTexture(Asset, SourcePath, CookedPath, Settings);
+		};
+
+		Cooker.AddTask(std::move(Task));
+	}
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "TextureLoader/BlockCompressor.h"
+
+class TAssetCooker;
+
+struct TTextureCookSettings
+{
+	EBlockCompressQuality Quality = EBlockCompressQuality::Normal;
+
+	// BC1/BC3 instead of BC7 for color textures
+	bool bLegacyFormats = false;
+};
+
+// One task per GetTextureAssets() PNG/JPG/HDR asset except lookup tables: a block compressed DDS with mips (Save/CookedTexture) and its source key sidecar.
+// HDR goes to BC6H, normal maps to BC5, gray, metallic and roughness maps to BC4, color to BC7 (or BC1/BC3).
+void AddTextureCookTasks(TAssetCooker& Cooker, const TTextureCookSettings& Settings);
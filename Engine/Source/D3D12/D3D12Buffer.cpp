@@ -49,6 +49,13 @@ TD3D12StructuredBufferRef TD3D12RHI::CreateStructuredBuffer(const void* Contents
 	return StructuredBufferRef;
 }
 
+void TD3D12RHI::UpdateStructuredBuffer(TD3D12StructuredBuffer* Buffer, uint32_t DstOffset, const void* Contents, uint32_t Size)
+{
+	assert(Buffer->ResourceLocation.MappedAddress != nullptr);
+
+	memcpy((uint8_t*)Buffer->ResourceLocation.MappedAddress + DstOffset, Contents, Size);
+}
+
 TD3D12RWStructuredBufferRef TD3D12RHI::CreateRWStructuredBuffer(uint32_t ElementSize, uint32_t ElementCount)
 {
 	TD3D12RWStructuredBufferRef RWStructuredBufferRef = std::make_shared<TD3D12RWStructuredBuffer>();
@@ -110,6 +117,24 @@ TD3D12IndexBufferRef TD3D12RHI::CreateIndexBuffer(const void* Contents, uint32_t
 	return IndexBufferRef;
 }
 
+TD3D12VertexBufferRef TD3D12RHI::CreateVertexBuffer(uint32_t Size)
+{
+	TD3D12VertexBufferRef VertexBufferRef = std::make_shared<TD3D12VertexBuffer>();
+
+	CreateStandAloneDefaultBuffer(Size, VertexBufferRef->ResourceLocation);
+
+	return VertexBufferRef;
+}
+
+TD3D12IndexBufferRef TD3D12RHI::CreateIndexBuffer(uint32_t Size)
+{
+	TD3D12IndexBufferRef IndexBufferRef = std::make_shared<TD3D12IndexBuffer>();
+
+	CreateStandAloneDefaultBuffer(Size, IndexBufferRef->ResourceLocation);
+
+	return IndexBufferRef;
+}
+
 TD3D12ReadBackBufferRef TD3D12RHI::CreateReadBackBuffer(uint32_t Size)
 {
 	TD3D12ReadBackBufferRef ReadBackBufferRef = std::make_shared<TD3D12ReadBackBuffer>();
@@ -141,11 +166,42 @@ void TD3D12RHI::CreateDefaultBuffer(uint32_t Size, uint32_t Alignment, D3D12_RES
 	DefaultBufferAllocator->AllocDefaultResource(ResourceDesc, Alignment, ResourceLocation);
 }
 
+void TD3D12RHI::CreateStandAloneDefaultBuffer(uint32_t Size, TD3D12ResourceLocation& ResourceLocation)
+{
+	Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+
+	HRESULT Hr = Device->GetD3DDevice()->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(Size),
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(&Resource));
+
+	ThrowIfFailed(Hr);
+
+	TD3D12Resource* NewResource = new TD3D12Resource(Resource, D3D12_RESOURCE_STATE_COMMON);
+	ResourceLocation.UnderlyingResource = NewResource;
+	ResourceLocation.SetType(TD3D12ResourceLocation::EResourceLocationType::StandAlone);
+	ResourceLocation.OffsetFromBaseOfResource = 0;
+	ResourceLocation.GPUVirtualAddress = NewResource->GPUVirtualAddress;
+}
+
 void TD3D12RHI::CreateAndInitDefaultBuffer(const void* Contents, uint32_t Size, uint32_t Alignment, TD3D12ResourceLocation& ResourceLocation)
 {
 	//Create default resource
 	CreateDefaultBuffer(Size, Alignment, D3D12_RESOURCE_FLAG_NONE, ResourceLocation);
 
+	UploadToDefaultBuffer(ResourceLocation, 0, Contents, Size);
+}
+
+void TD3D12RHI::UpdateBufferRegion(TD3D12Buffer* Buffer, uint32_t DstOffset, const void* Contents, uint32_t Size)
+{
+	UploadToDefaultBuffer(Buffer->ResourceLocation, DstOffset, Contents, Size);
+}
+
+void TD3D12RHI::UploadToDefaultBuffer(const TD3D12ResourceLocation& ResourceLocation, uint32_t DstOffset, const void* Contents, uint32_t Size)
+{
 	//Create upload resource 
 	TD3D12ResourceLocation UploadResourceLocation;
 	auto UploadBufferAllocator = GetDevice()->GetUploadBufferAllocator();
@@ -159,7 +215,7 @@ void TD3D12RHI::CreateAndInitDefaultBuffer(const void* Contents, uint32_t Size,
 	TD3D12Resource* UploadBuffer = UploadResourceLocation.UnderlyingResource;
 
 	TransitionResource(DefaultBuffer, D3D12_RESOURCE_STATE_COPY_DEST);
-	CopyBufferRegion(DefaultBuffer, ResourceLocation.OffsetFromBaseOfResource, UploadBuffer, UploadResourceLocation.OffsetFromBaseOfResource, Size);
+	CopyBufferRegion(DefaultBuffer, ResourceLocation.OffsetFromBaseOfResource + DstOffset, UploadBuffer, UploadResourceLocation.OffsetFromBaseOfResource, Size);
 }
 
 
@@ -0,0 +1,227 @@
+#include "D3D12CopyQueue.h"
+#include "D3D12Device.h"
+
+TD3D12CopyQueue::TD3D12CopyQueue(TD3D12Device* InDevice, uint64_t InStagingRingSize)
+	:Device(InDevice), StagingRingSize(InStagingRingSize)
+{
+	ID3D12Device* D3DDevice = Device->GetD3DDevice();
+
+	ThrowIfFailed(D3DDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&Fence)));
+
+	//Create copy type commandQueue
+	D3D12_COMMAND_QUEUE_DESC QueueDesc = {};
+	QueueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	QueueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	ThrowIfFailed(D3DDevice->CreateCommandQueue(&QueueDesc, IID_PPV_ARGS(&CommandQueue)));
+
+	ThrowIfFailed(D3DDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(CurrentAllocator.GetAddressOf())));
+
+	ThrowIfFailed(D3DDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, CurrentAllocator.Get(),
+		nullptr, IID_PPV_ARGS(CommandList.GetAddressOf())));
+
+	// Start off in a closed state, BeginRecording resets it.
+	ThrowIfFailed(CommandList->Close());
+
+	//Create staging ring, mapped for the whole lifetime
+	ThrowIfFailed(D3DDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(StagingRingSize),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&StagingRing)));
+
+	ThrowIfFailed(StagingRing->Map(0, nullptr, reinterpret_cast<void**>(&MappedStagingRing)));
+}
+
+TD3D12CopyQueue::~TD3D12CopyQueue()
+{
+	WaitForFenceValue(CurrentFenceValue);
+
+	StagingRing->Unmap(0, nullptr);
+}
+
+void TD3D12CopyQueue::AddTextureUpload(uint64_t RequestId, TD3D12TextureRef Texture, const std::vector<D3D12_SUBRESOURCE_DATA>& InitData)
+{
+	TPendingTextureUpload Upload;
+	Upload.Texture = Texture;
+	Upload.InitData = InitData;
+
+	PendingUploads.insert({ RequestId, Upload });
+}
+
+uint64_t TD3D12CopyQueue::GetRequiredStagingSize(TD3D12TextureRef Texture, uint32_t NumSubresources)
+{
+	D3D12_RESOURCE_DESC TexDesc = Texture->GetD3DResource()->GetDesc();
+
+	uint64_t RequiredSize = 0;
+	Device->GetD3DDevice()->GetCopyableFootprints(&TexDesc, 0, NumSubresources, 0, nullptr, nullptr, nullptr, &RequiredSize);
+
+	return RequiredSize;
+}
+
+void TD3D12CopyQueue::BeginRecording()
+{
+	ReleaseCompletedResources();
+
+	// Reuse the oldest allocator if the GPU is done with it
+	if (!InFlightAllocators.empty() && InFlightAllocators.front().first <= Fence->GetCompletedValue())
+	{
+		CurrentAllocator = InFlightAllocators.front().second;
+		InFlightAllocators.pop_front();
+
+		ThrowIfFailed(CurrentAllocator->Reset());
+	}
+	else
+	{
+		ThrowIfFailed(Device->GetD3DDevice()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(CurrentAllocator.ReleaseAndGetAddressOf())));
+	}
+
+	ThrowIfFailed(CommandList->Reset(CurrentAllocator.Get(), nullptr));
+
+	bRecording = true;
+}
+
+void TD3D12CopyQueue::RecordUpload(uint64_t RequestId, uint64_t StagingOffset)
+{
+	auto Iter = PendingUploads.find(RequestId);
+	assert(Iter != PendingUploads.end());
+
+	const TPendingTextureUpload& Upload = Iter->second;
+
+	if (!bRecording)
+	{
+		BeginRecording();
+	}
+
+	ID3D12Resource* TextureResource = Upload.Texture->GetD3DResource();
+	D3D12_RESOURCE_DESC TexDesc = TextureResource->GetDesc();
+
+	//GetCopyableFootprints
+	const UINT NumSubresources = (UINT)Upload.InitData.size();
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> Layouts(NumSubresources);
+	std::vector<uint32_t> NumRows(NumSubresources);
+	std::vector<uint64_t> RowSizesInBytes(NumSubresources);
+
+	uint64_t RequiredSize = 0;
+	Device->GetD3DDevice()->GetCopyableFootprints(&TexDesc, 0, NumSubresources, 0, &Layouts[0], &NumRows[0], &RowSizesInBytes[0], &RequiredSize);
+
+	//Get staging memory, from the ring or a buffer of its own
+	ID3D12Resource* StagingBuffer = nullptr;
+	uint8_t* MappedData = nullptr;
+	if (StagingOffset == DedicatedStagingOffset)
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> DedicatedBuffer;
+		ThrowIfFailed(Device->GetD3DDevice()->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+			D3D12_HEAP_FLAG_NONE,
+			&CD3DX12_RESOURCE_DESC::Buffer(RequiredSize),
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&DedicatedBuffer)));
+
+		ThrowIfFailed(DedicatedBuffer->Map(0, nullptr, reinterpret_cast<void**>(&MappedData)));
+
+		StagingBuffer = DedicatedBuffer.Get();
+		RecordingDedicatedBuffers.push_back(DedicatedBuffer);
+		StagingOffset = 0;
+	}
+	else
+	{
+		assert(StagingOffset + RequiredSize <= StagingRingSize);
+
+		StagingBuffer = StagingRing.Get();
+		MappedData = MappedStagingRing;
+	}
+
+	//Copy contents to staging memory
+	for (uint32_t i = 0; i < NumSubresources; ++i)
+	{
+		Layouts[i].Offset += StagingOffset;
+
+		D3D12_MEMCPY_DEST DestData = { MappedData + Layouts[i].Offset, Layouts[i].Footprint.RowPitch, SIZE_T(Layouts[i].Footprint.RowPitch) * SIZE_T(NumRows[i]) };
+		MemcpySubresource(&DestData, &(Upload.InitData[i]), static_cast<SIZE_T>(RowSizesInBytes[i]), NumRows[i], Layouts[i].Footprint.Depth);
+	}
+
+	if (StagingBuffer != StagingRing.Get())
+	{
+		StagingBuffer->Unmap(0, nullptr);
+	}
+
+	//Copy data from staging memory to texture.
+	//Texture is in COMMON state, it's promoted to COPY_DEST here and decays back when the copy queue finishes
+	for (UINT i = 0; i < NumSubresources; ++i)
+	{
+		CD3DX12_TEXTURE_COPY_LOCATION Src;
+		Src.pResource = StagingBuffer;
+		Src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+		Src.PlacedFootprint = Layouts[i];
+
+		CD3DX12_TEXTURE_COPY_LOCATION Dst;
+		Dst.pResource = TextureResource;
+		Dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		Dst.SubresourceIndex = i;
+
+		CommandList->CopyTextureRegion(&Dst, 0, 0, 0, &Src, nullptr);
+	}
+
+	PendingUploads.erase(Iter);
+}
+
+uint64_t TD3D12CopyQueue::Submit()
+{
+	assert(bRecording);
+
+	ThrowIfFailed(CommandList->Close());
+
+	ID3D12CommandList* cmdsLists[] = { CommandList.Get() };
+	CommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+
+	CurrentFenceValue++;
+	ThrowIfFailed(CommandQueue->Signal(Fence.Get(), CurrentFenceValue));
+
+	InFlightAllocators.push_back({ CurrentFenceValue, CurrentAllocator });
+	CurrentAllocator = nullptr;
+
+	for (auto& DedicatedBuffer : RecordingDedicatedBuffers)
+	{
+		InFlightDedicatedBuffers.push_back({ CurrentFenceValue, DedicatedBuffer });
+	}
+	RecordingDedicatedBuffers.clear();
+
+	bRecording = false;
+
+	return CurrentFenceValue;
+}
+
+uint64_t TD3D12CopyQueue::GetCompletedFenceValue()
+{
+	ReleaseCompletedResources();
+
+	return Fence->GetCompletedValue();
+}
+
+void TD3D12CopyQueue::WaitForFenceValue(uint64_t FenceValue)
+{
+	if (Fence->GetCompletedValue() < FenceValue)
+	{
+		HANDLE eventHandle = CreateEvent(nullptr, false, false, nullptr);
+
+		ThrowIfFailed(Fence->SetEventOnCompletion(FenceValue, eventHandle));
+
+		WaitForSingleObject(eventHandle, INFINITE);
+		CloseHandle(eventHandle);
+	}
+
+	ReleaseCompletedResources();
+}
+
+void TD3D12CopyQueue::ReleaseCompletedResources()
+{
+	uint64_t CompletedFenceValue = Fence->GetCompletedValue();
+
+	while (!InFlightDedicatedBuffers.empty() && InFlightDedicatedBuffers.front().first <= CompletedFenceValue)
+	{
+		InFlightDedicatedBuffers.pop_front();
+	}
+}
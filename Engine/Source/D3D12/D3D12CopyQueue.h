@@ -0,0 +1,81 @@
+#pragma once
+
+#include "D3D12Utils.h"
+#include "D3D12Texture.h"
+#include "RHI/RHI.h"
+#include <deque>
+#include <unordered_map>
+
+class TD3D12Device;
+
+// Copy type command queue with a persistently mapped staging ring.
+// Texture upload scheduling lives in TTextureUploadQueue, this class only records and executes the copies.
+class TD3D12CopyQueue : public TRHICopyQueue
+{
+public:
+	TD3D12CopyQueue(TD3D12Device* InDevice, uint64_t InStagingRingSize);
+
+	virtual ~TD3D12CopyQueue();
+
+public:
+	// Register the data of an upload request, copied into staging memory when the request is recorded
+	void AddTextureUpload(uint64_t RequestId, TD3D12TextureRef Texture, const std::vector<D3D12_SUBRESOURCE_DATA>& InitData);
+
+	// Staging bytes needed by all subresources of Texture
+	uint64_t GetRequiredStagingSize(TD3D12TextureRef Texture, uint32_t NumSubresources);
+
+public:
+	virtual uint64_t GetStagingRingSize() const override { return StagingRingSize; }
+
+	virtual void RecordUpload(uint64_t RequestId, uint64_t StagingOffset) override;
+
+	virtual uint64_t Submit() override;
+
+	virtual uint64_t GetCompletedFenceValue() override;
+
+	virtual void WaitForFenceValue(uint64_t FenceValue) override;
+
+private:
+	void BeginRecording();
+
+	void ReleaseCompletedResources();
+
+private:
+	struct TPendingTextureUpload
+	{
+		TD3D12TextureRef Texture;
+
+		std::vector<D3D12_SUBRESOURCE_DATA> InitData;
+	};
+
+	TD3D12Device* Device = nullptr;
+
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> CommandQueue = nullptr;
+
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> CommandList = nullptr;
+
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CurrentAllocator = nullptr;
+
+	// Allocators of submitted lists, reusable once their fence completes
+	std::deque<std::pair<uint64_t /*FenceValue*/, Microsoft::WRL::ComPtr<ID3D12CommandAllocator>>> InFlightAllocators;
+
+	Microsoft::WRL::ComPtr<ID3D12Fence> Fence = nullptr;
+
+	uint64_t CurrentFenceValue = 0;
+
+	bool bRecording = false;
+
+private:
+	uint64_t StagingRingSize = 0;
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> StagingRing = nullptr;
+
+	uint8_t* MappedStagingRing = nullptr;
+
+	// Staging buffers of requests larger than the ring
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> RecordingDedicatedBuffers;
+
+	std::deque<std::pair<uint64_t /*FenceValue*/, Microsoft::WRL::ComPtr<ID3D12Resource>>> InFlightDedicatedBuffers;
+
+	std::unordered_map<uint64_t /*RequestId*/, TPendingTextureUpload> PendingUploads;
+};
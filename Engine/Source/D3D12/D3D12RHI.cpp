@@ -5,6 +5,8 @@
 // Ref: https://stackoverflow.com/questions/60157794/dx12-d3d12getdebuginterface-app-requested-interface-depends-on-sdk-component
 #define InstalledDebugLayers true
 
+#define TEXTURE_STAGING_RING_SIZE (64 * 1024 * 1024)
+
 using Microsoft::WRL::ComPtr;
 
 TD3D12RHI::TD3D12RHI()
@@ -54,6 +56,10 @@ void TD3D12RHI::Initialize(HWND WindowHandle, int WindowWidth, int WindowHeight)
 
 	Viewport = std::make_unique<TD3D12Viewport>(this, ViewportInfo, WindowWidth, WindowHeight);
 
+	// Create copy queue and texture upload service
+	CopyQueue = std::make_unique<TD3D12CopyQueue>(Device.get(), TEXTURE_STAGING_RING_SIZE);
+	TextureUploadQueue = std::make_unique<TTextureUploadQueue>(CopyQueue.get());
+
 #ifdef _DEBUG
 	LogAdapters();
 #endif
@@ -64,6 +70,10 @@ void TD3D12RHI::Destroy()
 {
 	EndFrame();
 
+	TextureUploadQueue.reset();
+
+	CopyQueue.reset();
+
 	Viewport.reset();
 
 	Device.reset();
@@ -200,6 +210,10 @@ void TD3D12RHI::ExecuteCommandLists()
 void TD3D12RHI::ResetCommandList()
 {
 	GetDevice()->GetCommandContext()->ResetCommandList();
+
+	// A reset command list has no bindings
+	memset(CachedVertexBuffers, 0, sizeof(CachedVertexBuffers));
+	memset(&CachedIndexBuffer, 0, sizeof(CachedIndexBuffer));
 }
 
 void TD3D12RHI::ResetCommandAllocator()
@@ -244,7 +258,7 @@ void TD3D12RHI::CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* Dst, UINT D
 	GetDevice()->GetCommandList()->CopyTextureRegion(Dst, DstX, DstY, DstZ, Src, SrcBox);
 }
 
-void TD3D12RHI::SetVertexBuffer(const TD3D12VertexBufferRef& VertexBuffer, UINT Offset, UINT Stride, UINT Size)
+void TD3D12RHI::SetVertexBuffer(const TD3D12VertexBufferRef& VertexBuffer, UINT Offset, UINT Stride, UINT Size, UINT StartSlot)
 {
 	// Transition resource state
 	const TD3D12ResourceLocation& ResourceLocation = VertexBuffer->ResourceLocation;
@@ -256,7 +270,19 @@ void TD3D12RHI::SetVertexBuffer(const TD3D12VertexBufferRef& VertexBuffer, UINT
 	VBV.BufferLocation = ResourceLocation.GPUVirtualAddress + Offset;
 	VBV.StrideInBytes = Stride;
 	VBV.SizeInBytes = Size;
-	GetDevice()->GetCommandList()->IASetVertexBuffers(0, 1, &VBV);
+
+	if (StartSlot < MaxCachedVertexBuffers)
+	{
+		D3D12_VERTEX_BUFFER_VIEW& Cached = CachedVertexBuffers[StartSlot];
+		if (Cached.BufferLocation == VBV.BufferLocation && Cached.StrideInBytes == VBV.StrideInBytes && Cached.SizeInBytes == VBV.SizeInBytes)
+		{
+			return;
+		}
+
+		Cached = VBV;
+	}
+
+	GetDevice()->GetCommandList()->IASetVertexBuffers(StartSlot, 1, &VBV);
 }
 
 void TD3D12RHI::SetIndexBuffer(const TD3D12IndexBufferRef& IndexBuffer, UINT Offset, DXGI_FORMAT Format, UINT Size)
@@ -271,11 +297,25 @@ void TD3D12RHI::SetIndexBuffer(const TD3D12IndexBufferRef& IndexBuffer, UINT Off
 	IBV.BufferLocation = ResourceLocation.GPUVirtualAddress + Offset;
 	IBV.Format = Format;
 	IBV.SizeInBytes = Size;
+
+	if (CachedIndexBuffer.BufferLocation == IBV.BufferLocation && CachedIndexBuffer.Format == IBV.Format && CachedIndexBuffer.SizeInBytes == IBV.SizeInBytes)
+	{
+		return;
+	}
+
+	CachedIndexBuffer = IBV;
+
 	GetDevice()->GetCommandList()->IASetIndexBuffer(&IBV);
 }
 
 void TD3D12RHI::EndFrame()
 {
+	// Retire finished texture uploads and kick off new ones
+	if (TextureUploadQueue)
+	{
+		TextureUploadQueue->Tick();
+	}
+
 	// Clean memory allocations
 	GetDevice()->GetUploadBufferAllocator()->CleanUpAllocations();
 
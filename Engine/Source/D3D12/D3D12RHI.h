@@ -4,6 +4,8 @@
 #include "D3D12Viewport.h"
 #include "D3D12Texture.h"
 #include "D3D12Buffer.h"
+#include "D3D12CopyQueue.h"
+#include "Texture/TextureUploadQueue.h"
 #include "Texture/TextureInfo.h"
 #include "Math/Math.h"
 
@@ -53,12 +55,24 @@ public:
 
 	TD3D12StructuredBufferRef CreateStructuredBuffer(const void* Contents, uint32_t ElementSize, uint32_t ElementCount);
 
+	// Structured buffers live in the upload heap and are written in place, only while the GPU is not reading them
+	void UpdateStructuredBuffer(TD3D12StructuredBuffer* Buffer, uint32_t DstOffset, const void* Contents, uint32_t Size);
+
 	TD3D12RWStructuredBufferRef CreateRWStructuredBuffer(uint32_t ElementSize, uint32_t ElementCount);
 
 	TD3D12VertexBufferRef CreateVertexBuffer(const void* Contents, uint32_t Size);
 
 	TD3D12IndexBufferRef CreateIndexBuffer(const void* Contents, uint32_t Size);
 
+	// Uninitialized committed buffers for large long lived data such as the geometry pool.
+	// They never share a resource, so one can be copied into another with CopyBufferRegion.
+	TD3D12VertexBufferRef CreateVertexBuffer(uint32_t Size);
+
+	TD3D12IndexBufferRef CreateIndexBuffer(uint32_t Size);
+
+	// Copy Contents into a default buffer at DstOffset through the upload allocator
+	void UpdateBufferRegion(TD3D12Buffer* Buffer, uint32_t DstOffset, const void* Contents, uint32_t Size);
+
 	TD3D12ReadBackBufferRef CreateReadBackBuffer(uint32_t Size);
 
 	TD3D12TextureRef CreateTexture(const TTextureInfo& TextureInfo, uint32_t CreateFlags, TVector4 RTVClearValue = TVector4::Zero);
@@ -68,7 +82,15 @@ public:
 
 	void UploadTextureData(TD3D12TextureRef Texture, const std::vector<D3D12_SUBRESOURCE_DATA>& InitData);
 
-	void SetVertexBuffer(const TD3D12VertexBufferRef& VertexBuffer, UINT Offset, UINT Stride, UINT Size);
+	// Upload on the copy queue, OnResident is called from EndFrame once the copy has completed.
+	// InitData must stay valid until then.
+	void UploadTextureDataAsync(TD3D12TextureRef Texture, const std::vector<D3D12_SUBRESOURCE_DATA>& InitData, TUploadCallback OnResident);
+
+	void FlushTextureUploads();
+
+	TTextureUploadQueue* GetTextureUploadQueue() { return TextureUploadQueue.get(); }
+
+	void SetVertexBuffer(const TD3D12VertexBufferRef& VertexBuffer, UINT Offset, UINT Stride, UINT Size, UINT StartSlot = 0);
 
 	void SetIndexBuffer(const TD3D12IndexBufferRef& IndexBuffer, UINT Offset, DXGI_FORMAT Format, UINT Size);
 
@@ -81,6 +103,10 @@ private:
 
 	void CreateAndInitDefaultBuffer(const void* Contents, uint32_t Size, uint32_t Alignment, TD3D12ResourceLocation& ResourceLocation);
 
+	void UploadToDefaultBuffer(const TD3D12ResourceLocation& ResourceLocation, uint32_t DstOffset, const void* Contents, uint32_t Size);
+
+	void CreateStandAloneDefaultBuffer(uint32_t Size, TD3D12ResourceLocation& ResourceLocation);
+
 	TD3D12TextureRef CreateTextureResource(const TTextureInfo& TextureInfo, uint32_t CreateFlags, TVector4 RTVClearValue);
 
 	void CreateTextureViews(TD3D12TextureRef TextureRef, const TTextureInfo& TextureInfo, uint32_t CreateFlags);
@@ -99,7 +125,18 @@ private:
 
 	std::unique_ptr<TD3D12Viewport> Viewport = nullptr;
 
+	std::unique_ptr<TD3D12CopyQueue> CopyQueue = nullptr;
+
+	std::unique_ptr<TTextureUploadQueue> TextureUploadQueue = nullptr;
+
 	TD3D12ViewportInfo ViewportInfo;
 
+	// Last views set on the command list, meshes in the geometry pool share them so most binds are skipped
+	static const UINT MaxCachedVertexBuffers = 2;
+
+	D3D12_VERTEX_BUFFER_VIEW CachedVertexBuffers[MaxCachedVertexBuffers] = {};
+
+	D3D12_INDEX_BUFFER_VIEW CachedIndexBuffer = {};
+
 	Microsoft::WRL::ComPtr<IDXGIFactory4> DxgiFactory = nullptr;
 };
\ No newline at end of file
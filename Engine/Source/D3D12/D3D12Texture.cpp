@@ -313,4 +313,18 @@ void TD3D12RHI::UploadTextureData(TD3D12TextureRef Texture, const std::vector<D3
 	}
 
 	TransitionResource(TextureResource, D3D12_RESOURCE_STATE_COMMON);
+}
+
+void TD3D12RHI::UploadTextureDataAsync(TD3D12TextureRef Texture, const std::vector<D3D12_SUBRESOURCE_DATA>& InitData, TUploadCallback OnResident)
+{
+	uint64_t RequiredSize = CopyQueue->GetRequiredStagingSize(Texture, (uint32_t)InitData.size());
+
+	uint64_t RequestId = TextureUploadQueue->Enqueue(RequiredSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, OnResident);
+
+	CopyQueue->AddTextureUpload(RequestId, Texture, InitData);
+}
+
+void TD3D12RHI::FlushTextureUploads()
+{
+	TextureUploadQueue->Flush();
 }
\ No newline at end of file
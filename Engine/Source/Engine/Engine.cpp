@@ -108,6 +108,9 @@ int TEngine::Run()
 
 bool TEngine::Destroy()
 {
+	// In-flight uploads still read texture data owned by the repository
+	D3D12RHI->FlushTextureUploads();
+
 	Render.reset();
 
 	World.reset();
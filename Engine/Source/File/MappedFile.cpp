@@ -0,0 +1,131 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+TMappedFile::~TMappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool TMappedFile::Open(const std::wstring& FilePath)
+{
+	Close();
+
+	HANDLE File = CreateFileW(FilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (File == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER FileSize;
+	if (!GetFileSizeEx(File, &FileSize) || FileSize.QuadPart == 0)
+	{
+		CloseHandle(File);
+		return false;
+	}
+
+	HANDLE Mapping = CreateFileMappingW(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!Mapping)
+	{
+		CloseHandle(File);
+		return false;
+	}
+
+	void* View = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!View)
+	{
+		CloseHandle(Mapping);
+		CloseHandle(File);
+		return false;
+	}
+
+	FileHandle = File;
+	MappingHandle = Mapping;
+	Data = static_cast<const uint8_t*>(View);
+	Size = (size_t)FileSize.QuadPart;
+
+	return true;
+}
+
+void TMappedFile::Close()
+{
+	if (Data)
+	{
+		UnmapViewOfFile(Data);
+	}
+
+	if (MappingHandle)
+	{
+		CloseHandle(MappingHandle);
+	}
+
+	if (FileHandle)
+	{
+		CloseHandle(FileHandle);
+	}
+
+	Data = nullptr;
+	Size = 0;
+	FileHandle = nullptr;
+	MappingHandle = nullptr;
+}
+
+#else
+
+bool TMappedFile::Open(const std::wstring& FilePath)
+{
+	Close();
+
+	const std::string NativePath = std::filesystem::path(FilePath).string();
+
+	int File = open(NativePath.c_str(), O_RDONLY);
+	if (File < 0)
+	{
+		return false;
+	}
+
+	struct stat FileStat;
+	if (fstat(File, &FileStat) != 0 || FileStat.st_size == 0)
+	{
+		close(File);
+		return false;
+	}
+
+	void* View = mmap(nullptr, (size_t)FileStat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+
+	// The mapping keeps its own reference to the file
+	close(File);
+
+	if (View == MAP_FAILED)
+	{
+		return false;
+	}
+
+	Data = static_cast<const uint8_t*>(View);
+	Size = (size_t)FileStat.st_size;
+
+	return true;
+}
+
+void TMappedFile::Close()
+{
+	if (Data)
+	{
+		munmap(const_cast<uint8_t*>(Data), Size);
+	}
+
+	Data = nullptr;
+	Size = 0;
+}
+
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Read-only view of a whole file mapped into the address space, the OS pages it in on first touch
+class TMappedFile
+{
+public:
+	TMappedFile() = default;
+
+	~TMappedFile();
+
+	TMappedFile(const TMappedFile&) = delete;
+
+	TMappedFile& operator=(const TMappedFile&) = delete;
+
+	bool Open(const std::wstring& FilePath);
+
+	void Close();
+
+	bool IsOpen() const { return Data != nullptr; }
+
+	// The mapping starts on a page boundary
+	const uint8_t* GetData() const { return Data; }
+
+	size_t GetSize() const { return Size; }
+
+private:
+	const uint8_t* Data = nullptr;
+
+	size_t Size = 0;
+
+#ifdef _WIN32
+	void* FileHandle = nullptr;
+
+	void* MappingHandle = nullptr;
+#endif
+};
@@ -5,10 +5,14 @@
 #include "Vector4.h"
 #include "Matrix.h"
 #include "IntPoint.h"
-#include <Windows.h>
+#include <cfloat>
 #include <cstdint>
 #include <limits>
 
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
 
 #define MachineEpsilon (std::numeric_limits<float>::epsilon() * 0.5)
 
@@ -21,6 +25,7 @@ public:
 
 	static int Log2Int(uint64_t v)
 	{
+#ifdef _WIN32
 		unsigned long lz = 0;
 #if defined(_WIN64)
 		_BitScanReverse64(&lz, v);
@@ -31,6 +36,9 @@ public:
 			_BitScanReverse(&lz, v & 0xffffffff);
 #endif // _WIN64
 		return lz;
+#else
+		return v == 0 ? 0 : 63 - __builtin_clzll(v);
+#endif // _WIN32
 	}
 
 	static int Log2Int(int64_t v) { return Log2Int((uint64_t)v); }
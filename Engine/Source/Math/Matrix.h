@@ -43,7 +43,7 @@ struct TMatrix : public DirectX::XMFLOAT4X4
 			r1.x, r1.y, r1.z, r1.w,
 			r2.x, r2.y, r2.z, r2.w,
 			r3.x, r3.y, r3.z, r3.w) {}
-	TMatrix(const DirectX::XMFLOAT4X4& M) noexcept { memcpy_s(this, sizeof(float) * 16, &M, sizeof(XMFLOAT4X4)); }
+	TMatrix(const DirectX::XMFLOAT4X4& M) noexcept : XMFLOAT4X4(M) {}
 	TMatrix(const DirectX::XMFLOAT3X3& M) noexcept;
 	TMatrix(const DirectX::XMFLOAT4X3& M) noexcept;
 
@@ -0,0 +1,153 @@
+#include "CookedMesh.h"
+#include "Utils/Hash.h"
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	uint64_t AlignUp(uint64_t Value, uint64_t Alignment)
+	{
+		return (Value + Alignment - 1) / Alignment * Alignment;
+	}
+}
+
+bool GetCookedMeshSourceKey(const std::wstring& SourcePath, uint32_t Flags, TCookedMeshSourceKey& OutKey)
+{
+	TMappedFile SourceFile;
+	if (!SourceFile.Open(SourcePath))
+	{
+		return false;
+	}
+
+	OutKey = TCookedMeshSourceKey();
+	OutKey.SourceFileSize = SourceFile.GetSize();
+	OutKey.SourceHash = THash::HashBytes(SourceFile.GetData(), SourceFile.GetSize());
+	OutKey.Flags = Flags;
+
+	return true;
+}
+
+TCookedMeshWriter::TCookedMeshWriter()
+{
+	for (const void*& Data : SectionData)
+	{
+		Data = nullptr;
+	}
+}
+
+void TCookedMeshWriter::SetSection(ECookedMeshSection Section, const void* Data, uint32_t ElementSize, uint32_t ElementCount)
+{
+	TCookedMeshSection& Entry = Header.Sections[(size_t)Section];
+	Entry.ElementSize = ElementSize;
+	Entry.ElementCount = ElementCount;
+	Entry.ByteSize = (uint64_t)ElementSize * ElementCount;
+
+	SectionData[(size_t)Section] = Data;
+}
+
+bool TCookedMeshWriter::Write(const std::wstring& FilePath)
+{
+	// Lay out the blobs behind the header
+	uint64_t Offset = AlignUp(sizeof(TCookedMeshHeader), CookedMeshAlignment);
+	for (TCookedMeshSection& Entry : Header.Sections)
+	{
+		Entry.Offset = Offset;
+		Offset = AlignUp(Offset + Entry.ByteSize, CookedMeshAlignment);
+	}
+
+	const std::filesystem::path TargetPath(FilePath);
+	std::filesystem::path TempPath = TargetPath;
+	TempPath += L".tmp";
+
+	std::error_code Error;
+	if (TargetPath.has_parent_path())
+	{
+		std::filesystem::create_directories(TargetPath.parent_path(), Error);
+	}
+
+	{
+		std::ofstream File(TempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!File.is_open())
+		{
+			return false;
+		}
+
+		File.write(reinterpret_cast<const char*>(&Header), sizeof(TCookedMeshHeader));
+
+		const char Zeros[CookedMeshAlignment] = {};
+		uint64_t Written = sizeof(TCookedMeshHeader);
+
+		for (size_t i = 0; i < (size_t)ECookedMeshSection::Count; i++)
+		{
+			const TCookedMeshSection& Entry = Header.Sections[i];
+
+			File.write(Zeros, (std::streamsize)(Entry.Offset - Written));
+			if (Entry.ByteSize > 0)
+			{
+				File.write(reinterpret_cast<const char*>(SectionData[i]), (std::streamsize)Entry.ByteSize);
+			}
+
+			Written = Entry.Offset + Entry.ByteSize;
+		}
+
+		if (!File.good())
+		{
+			File.close();
+			std::filesystem::remove(TempPath, Error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(TempPath, TargetPath, Error);
+	if (Error)
+	{
+		std::filesystem::remove(TempPath, Error);
+		return false;
+	}
+
+	return true;
+}
+
+bool TCookedMeshReader::Open(const std::wstring& FilePath, const TCookedMeshSourceKey& ExpectedKey)
+{
+	Header = nullptr;
+
+	if (!File.Open(FilePath))
+	{
+		return false;
+	}
+
+	const size_t FileSize = File.GetSize();
+	if (FileSize < sizeof(TCookedMeshHeader))
+	{
+		File.Close();
+		return false;
+	}
+
+	const TCookedMeshHeader* FileHeader = reinterpret_cast<const TCookedMeshHeader*>(File.GetData());
+	const TCookedMeshSourceKey& Key = FileHeader->SourceKey;
+
+	bool bValid = FileHeader->Magic == CookedMeshMagic && FileHeader->Version == CookedMeshVersion
+		&& Key.SourceFileSize == ExpectedKey.SourceFileSize && Key.SourceHash == ExpectedKey.SourceHash && Key.Flags == ExpectedKey.Flags;
+
+	for (const TCookedMeshSection& Entry : FileHeader->Sections)
+	{
+		if (!bValid)
+		{
+			break;
+		}
+
+		bValid = Entry.Offset % CookedMeshAlignment == 0 && Entry.ByteSize == (uint64_t)Entry.ElementSize * Entry.ElementCount
+			&& Entry.Offset <= FileSize && Entry.ByteSize <= FileSize - Entry.Offset;
+	}
+
+	if (!bValid)
+	{
+		File.Close();
+		return false;
+	}
+
+	Header = FileHeader;
+
+	return true;
+}
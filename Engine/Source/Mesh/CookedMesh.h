@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "File/MappedFile.h"
+
+// 'TMSH'
+const uint32_t CookedMeshMagic = 0x48534D54;
+
+// Bump when TVertex, the section layout or the output of the import pipeline changes
+const uint32_t CookedMeshVersion = 4;
+
+// Every blob starts on a cache line, the mapping itself is page aligned
+const uint32_t CookedMeshAlignment = 64;
+
+enum class ECookedMeshSection
+{
+	Vertices,
+	Indices32,
+	Indices16,
+	IndexChunks,
+	Meshlets,
+	LODIndices,
+	LODTable,
+	Submeshes,
+	LODSubmeshes,
+	MaterialSlotNames,
+	Count,
+};
+
+enum ECookedMeshFlags
+{
+	CookedMesh_None              = 0,
+	CookedMesh_CompactVertex     = 1 << 0,
+	CookedMesh_SplitIndices16    = 1 << 1,
+};
+
+struct TCookedMeshSection
+{
+	// From the start of the file
+	uint64_t Offset = 0;
+
+	uint64_t ByteSize = 0;
+
+	uint32_t ElementSize = 0;
+
+	uint32_t ElementCount = 0;
+};
+
+// Source asset fingerprint and cook settings, any mismatch makes the cooked file stale.
+// Content based, so files cooked on another machine stay valid after a fresh checkout.
+struct TCookedMeshSourceKey
+{
+	uint64_t SourceFileSize = 0;
+
+	uint64_t SourceHash = 0;
+
+	uint32_t Flags = CookedMesh_None;
+
+	uint32_t Pad = 0;
+};
+
+// Range of a mesh that can be drawn with 16-bit indices relative to BaseVertex, IndexChunks stores them as is
+struct TMeshIndexChunk
+{
+	uint32_t StartIndex = 0;
+
+	uint32_t IndexCount = 0;
+
+	uint32_t BaseVertex = 0;
+
+	uint32_t VertexCount = 0;
+};
+
+// Index range drawn with one material slot, Submeshes and LODSubmeshes store them as is
+struct TMeshSubmesh
+{
+	uint32_t StartIndex = 0;
+
+	uint32_t IndexCount = 0;
+
+	uint32_t MaterialSlot = 0;
+
+	// Range in TMesh::Meshlets, set by BuildMeshlets
+	uint32_t FirstMeshlet = 0;
+
+	uint32_t MeshletCount = 0;
+};
+
+// LODIndices holds the index lists of LOD1 and coarser back to back,
+// LODSubmeshes holds one submesh table per LOD with ranges relative to that LOD's list.
+// MaterialSlotNames is a char blob of '\0' terminated names in slot order.
+struct TCookedMeshLOD
+{
+	uint32_t IndexCount = 0;
+
+	float Error = 0.0f;
+};
+
+// Fixed size header at offset 0, all data little endian
+struct TCookedMeshHeader
+{
+	uint32_t Magic = CookedMeshMagic;
+
+	uint32_t Version = CookedMeshVersion;
+
+	TCookedMeshSourceKey SourceKey;
+
+	float BoundsMin[3] = { 0.0f, 0.0f, 0.0f };
+
+	float BoundsMax[3] = { 0.0f, 0.0f, 0.0f };
+
+	float SDFCenter[3] = { 0.0f, 0.0f, 0.0f };
+
+	float SDFExtent[3] = { 0.0f, 0.0f, 0.0f };
+
+	int32_t SDFResolution[3] = { 0, 0, 0 };
+
+	float SDFVoxelSize = 0.0f;
+
+	TCookedMeshSection Sections[(size_t)ECookedMeshSection::Count];
+};
+
+// Hashes the source asset, false if it can not be read
+bool GetCookedMeshSourceKey(const std::wstring& SourcePath, uint32_t Flags, TCookedMeshSourceKey& OutKey);
+
+class TCookedMeshWriter
+{
+public:
+	TCookedMeshWriter();
+
+	// Data must stay alive until Write
+	void SetSection(ECookedMeshSection Section, const void* Data, uint32_t ElementSize, uint32_t ElementCount);
+
+	template<typename T>
+	void SetSection(ECookedMeshSection Section, const std::vector<T>& Data)
+	{
+		SetSection(Section, Data.data(), (uint32_t)sizeof(T), (uint32_t)Data.size());
+	}
+
+	// Writes a temporary file and renames it, so readers never see a partial cook
+	bool Write(const std::wstring& FilePath);
+
+public:
+	TCookedMeshHeader Header;
+
+private:
+	const void* SectionData[(size_t)ECookedMeshSection::Count];
+};
+
+class TCookedMeshReader
+{
+public:
+	// Maps the file and validates the header, the source key and every section range
+	bool Open(const std::wstring& FilePath, const TCookedMeshSourceKey& ExpectedKey);
+
+	const TCookedMeshHeader& GetHeader() const { return *Header; }
+
+	// Points into the mapping, valid while the reader is alive. False if the element type does not match.
+	template<typename T>
+	bool GetSection(ECookedMeshSection Section, const T*& OutData, uint32_t& OutCount) const
+	{
+		const TCookedMeshSection& Entry = Header->Sections[(size_t)Section];
+		if (Entry.ElementCount > 0 && Entry.ElementSize != sizeof(T))
+		{
+			return false;
+		}
+
+		OutData = reinterpret_cast<const T*>(File.GetData() + Entry.Offset);
+		OutCount = Entry.ElementCount;
+
+		return true;
+	}
+
+	template<typename T>
+	bool ReadSection(ECookedMeshSection Section, std::vector<T>& OutData) const
+	{
+		const T* Data = nullptr;
+		uint32_t Count = 0;
+		if (!GetSection(Section, Data, Count))
+		{
+			return false;
+		}
+
+		OutData.assign(Data, Data + Count);
+
+		return true;
+	}
+
+private:
+	TMappedFile File;
+
+	const TCookedMeshHeader* Header = nullptr;
+};
@@ -0,0 +1,373 @@
+#include "CookedMesh.h"
+#include "Meshlet.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// Cooks a sphere with two submeshes, 16-bit index chunks, meshlets and two LODs the way TMesh::SaveCooked lays it out,
+// maps it back and compares every header field and section. Then checks that a stale source key, another version, a
+// section running past the end and truncated files are rejected. Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	// The output of the load pipeline as TMesh holds it, TMesh itself needs the D3D12 headers
+	struct TTestMesh
+	{
+		std::vector<TVertex> Vertices;
+
+		std::vector<uint32_t> Indices32;
+
+		std::vector<uint16_t> Indices16;
+
+		std::vector<TMeshIndexChunk> IndexChunks;
+
+		std::vector<TMeshlet> Meshlets;
+
+		std::vector<TMeshSubmesh> Submeshes;
+
+		std::vector<std::string> MaterialSlotNames;
+
+		std::vector<std::vector<uint32_t>> LODIndices;
+
+		std::vector<std::vector<TMeshSubmesh>> LODSubmeshes;
+
+		std::vector<float> LODErrors;
+	};
+
+	TTestMesh MakeMesh()
+	{
+		TTestMesh Mesh;
+
+		const uint32_t Rings = 24;
+		const uint32_t Segments = 48;
+		for (uint32_t r = 0; r <= Rings; r++)
+		{
+			const float Theta = 3.14159265f * r / Rings;
+			for (uint32_t s = 0; s <= Segments; s++)
+			{
+				const float Phi = 6.28318531f * s / Segments;
+				const float X = std::sin(Theta) * std::cos(Phi);
+				const float Y = std::cos(Theta);
+				const float Z = std::sin(Theta) * std::sin(Phi);
+				Mesh.Vertices.push_back(TVertex(X, Y, Z, X, Y, Z, -std::sin(Phi), 0.0f, std::cos(Phi), (float)s / Segments, (float)r / Rings));
+			}
+		}
+
+		// Upper half uses slot 0, lower half slot 1
+		for (uint32_t r = 0; r < Rings; r++)
+		{
+			for (uint32_t s = 0; s < Segments; s++)
+			{
+				const uint32_t Corner = r * (Segments + 1) + s;
+				const uint32_t QuadIndices[6] = { Corner, Corner + 1, Corner + Segments + 1, Corner + 1, Corner + Segments + 2, Corner + Segments + 1 };
+				Mesh.Indices32.insert(Mesh.Indices32.end(), QuadIndices, QuadIndices + 6);
+			}
+		}
+
+		const uint32_t HalfIndexCount = (uint32_t)Mesh.Indices32.size() / 2;
+		Mesh.MaterialSlotNames = { "Upper", "Lower" };
+		for (uint32_t Slot = 0; Slot < 2; Slot++)
+		{
+			TMeshSubmesh Submesh;
+			Submesh.StartIndex = Slot * HalfIndexCount;
+			Submesh.IndexCount = HalfIndexCount;
+			Submesh.MaterialSlot = Slot;
+			Submesh.FirstMeshlet = (uint32_t)Mesh.Meshlets.size();
+			BuildMeshlets(Mesh.Vertices, Mesh.Indices32, Submesh.StartIndex, Submesh.IndexCount, Mesh.Meshlets);
+			Submesh.MeshletCount = (uint32_t)Mesh.Meshlets.size() - Submesh.FirstMeshlet;
+			Mesh.Submeshes.push_back(Submesh);
+		}
+
+		// One chunk per submesh, each relative to the first vertex it uses
+		for (const TMeshSubmesh& Submesh : Mesh.Submeshes)
+		{
+			TMeshIndexChunk Chunk;
+			Chunk.StartIndex = Submesh.StartIndex;
+			Chunk.IndexCount = Submesh.IndexCount;
+			Chunk.BaseVertex = Mesh.Indices32[Submesh.StartIndex];
+			Chunk.VertexCount = Mesh.Indices32[Submesh.StartIndex + Submesh.IndexCount - 1] + 1 - Chunk.BaseVertex;
+			Mesh.IndexChunks.push_back(Chunk);
+
+			for (uint32_t i = Submesh.StartIndex; i < Submesh.StartIndex + Submesh.IndexCount; i++)
+			{
+				Mesh.Indices16.push_back((uint16_t)(Mesh.Indices32[i] - Chunk.BaseVertex));
+			}
+		}
+
+		// Every LOD keeps every other triangle of the previous one, per submesh
+		const std::vector<uint32_t>* Previous = &Mesh.Indices32;
+		const std::vector<TMeshSubmesh>* PreviousSubmeshes = &Mesh.Submeshes;
+		for (uint32_t LOD = 0; LOD < 2; LOD++)
+		{
+			std::vector<uint32_t> Indices;
+			std::vector<TMeshSubmesh> Submeshes;
+			for (const TMeshSubmesh& PreviousSubmesh : *PreviousSubmeshes)
+			{
+				TMeshSubmesh Submesh = PreviousSubmesh;
+				Submesh.StartIndex = (uint32_t)Indices.size();
+				for (uint32_t i = PreviousSubmesh.StartIndex; i < PreviousSubmesh.StartIndex + PreviousSubmesh.IndexCount; i += 6)
+				{
+					Indices.insert(Indices.end(), Previous->begin() + i, Previous->begin() + i + 3);
+				}
+				Submesh.IndexCount = (uint32_t)Indices.size() - Submesh.StartIndex;
+				Submeshes.push_back(Submesh);
+			}
+
+			Mesh.LODIndices.push_back(std::move(Indices));
+			Mesh.LODSubmeshes.push_back(std::move(Submeshes));
+			Mesh.LODErrors.push_back(0.01f * (LOD + 1));
+			Previous = &Mesh.LODIndices.back();
+			PreviousSubmeshes = &Mesh.LODSubmeshes.back();
+		}
+
+		return Mesh;
+	}
+
+	void FillHeader(TCookedMeshHeader& Header, const TCookedMeshSourceKey& SourceKey)
+	{
+		Header.SourceKey = SourceKey;
+
+		const float BoundsMin[3] = { -1.0f, -1.0f, -1.0f };
+		const float BoundsMax[3] = { 1.0f, 1.0f, 1.0f };
+		const float SDFCenter[3] = { 0.0f, 0.125f, -0.25f };
+		const float SDFExtent[3] = { 1.25f, 1.5f, 1.75f };
+		const int32_t SDFResolution[3] = { 40, 48, 56 };
+		memcpy(Header.BoundsMin, BoundsMin, sizeof(BoundsMin));
+		memcpy(Header.BoundsMax, BoundsMax, sizeof(BoundsMax));
+		memcpy(Header.SDFCenter, SDFCenter, sizeof(SDFCenter));
+		memcpy(Header.SDFExtent, SDFExtent, sizeof(SDFExtent));
+		memcpy(Header.SDFResolution, SDFResolution, sizeof(SDFResolution));
+		Header.SDFVoxelSize = 0.0625f;
+	}
+
+	// Same sections and packing as TMesh::SaveCooked
+	bool SaveCooked(const TTestMesh& Mesh, const std::wstring& FilePath, const TCookedMeshSourceKey& SourceKey)
+	{
+		TCookedMeshWriter Writer;
+		FillHeader(Writer.Header, SourceKey);
+
+		std::vector<uint32_t> LODIndices;
+		std::vector<TCookedMeshLOD> LODTable;
+		std::vector<TMeshSubmesh> LODSubmeshes;
+		for (size_t LOD = 0; LOD < Mesh.LODIndices.size(); LOD++)
+		{
+			LODIndices.insert(LODIndices.end(), Mesh.LODIndices[LOD].begin(), Mesh.LODIndices[LOD].end());
+			LODSubmeshes.insert(LODSubmeshes.end(), Mesh.LODSubmeshes[LOD].begin(), Mesh.LODSubmeshes[LOD].end());
+
+			TCookedMeshLOD CookedLOD;
+			CookedLOD.IndexCount = (uint32_t)Mesh.LODIndices[LOD].size();
+			CookedLOD.Error = Mesh.LODErrors[LOD];
+			LODTable.push_back(CookedLOD);
+		}
+
+		std::vector<char> SlotNames;
+		for (const std::string& Name : Mesh.MaterialSlotNames)
+		{
+			SlotNames.insert(SlotNames.end(), Name.begin(), Name.end());
+			SlotNames.push_back('\0');
+		}
+
+		Writer.SetSection(ECookedMeshSection::Vertices, Mesh.Vertices);
+		Writer.SetSection(ECookedMeshSection::Indices32, Mesh.Indices32);
+		Writer.SetSection(ECookedMeshSection::Indices16, Mesh.Indices16);
+		Writer.SetSection(ECookedMeshSection::IndexChunks, Mesh.IndexChunks);
+		Writer.SetSection(ECookedMeshSection::Meshlets, Mesh.Meshlets);
+		Writer.SetSection(ECookedMeshSection::LODIndices, LODIndices);
+		Writer.SetSection(ECookedMeshSection::LODTable, LODTable);
+		Writer.SetSection(ECookedMeshSection::Submeshes, Mesh.Submeshes);
+		Writer.SetSection(ECookedMeshSection::LODSubmeshes, LODSubmeshes);
+		Writer.SetSection(ECookedMeshSection::MaterialSlotNames, SlotNames);
+
+		return Writer.Write(FilePath);
+	}
+
+	// Byte compare, every element type is tightly packed
+	template<typename T>
+	bool IsSameSection(const TCookedMeshReader& Reader, ECookedMeshSection Section, const std::vector<T>& Expected)
+	{
+		const T* Data = nullptr;
+		uint32_t Count = 0;
+
+		return Reader.GetSection(Section, Data, Count) && Count == Expected.size()
+			&& (Count == 0 || memcmp(Data, Expected.data(), Count * sizeof(T)) == 0);
+	}
+
+	template<typename T>
+	std::vector<T> Concatenate(const std::vector<std::vector<T>>& Lists)
+	{
+		std::vector<T> Result;
+		for (const std::vector<T>& List : Lists)
+		{
+			Result.insert(Result.end(), List.begin(), List.end());
+		}
+
+		return Result;
+	}
+
+	std::vector<char> ReadFile(const std::filesystem::path& Path)
+	{
+		std::ifstream File(Path, std::ios::in | std::ios::binary);
+
+		return std::vector<char>((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+	}
+
+	void WriteFile(const std::filesystem::path& Path, const std::vector<char>& Bytes, size_t Size)
+	{
+		std::ofstream File(Path, std::ios::out | std::ios::binary | std::ios::trunc);
+		File.write(Bytes.data(), Size);
+	}
+
+	void TestRoundTrip(const std::filesystem::path& FilePath, const TTestMesh& Mesh, const TCookedMeshSourceKey& SourceKey)
+	{
+		Check(SaveCooked(Mesh, FilePath.wstring(), SourceKey), "round trip: the cooked file is written");
+		Check(!std::filesystem::exists(FilePath.wstring() + L".tmp"), "round trip: the temporary file is renamed");
+
+		// The raw mapping, page aligned and every section on a cache line
+		TMappedFile File;
+		Check(File.Open(FilePath.wstring()), "round trip: the file maps");
+		Check(((uintptr_t)File.GetData() & 4095) == 0, "round trip: the mapping is page aligned");
+
+		const TCookedMeshHeader* RawHeader = reinterpret_cast<const TCookedMeshHeader*>(File.GetData());
+		bool bAligned = true;
+		for (const TCookedMeshSection& Entry : RawHeader->Sections)
+		{
+			bAligned &= Entry.Offset % CookedMeshAlignment == 0 && Entry.Offset + Entry.ByteSize <= File.GetSize();
+		}
+		Check(bAligned, "round trip: every section is aligned and inside the file");
+		File.Close();
+
+		TCookedMeshReader Reader;
+		Check(Reader.Open(FilePath.wstring(), SourceKey), "round trip: the reader accepts the file");
+
+		TCookedMeshHeader Expected;
+		FillHeader(Expected, SourceKey);
+		const TCookedMeshHeader& Header = Reader.GetHeader();
+		Check(Header.Magic == CookedMeshMagic && Header.Version == CookedMeshVersion, "round trip: magic and version");
+		Check(memcmp(&Header.SourceKey, &Expected.SourceKey, sizeof(TCookedMeshSourceKey)) == 0, "round trip: the source key");
+		Check(memcmp(Header.BoundsMin, Expected.BoundsMin, sizeof(Header.BoundsMin)) == 0
+			&& memcmp(Header.BoundsMax, Expected.BoundsMax, sizeof(Header.BoundsMax)) == 0, "round trip: the bounds");
+		Check(memcmp(Header.SDFCenter, Expected.SDFCenter, sizeof(Header.SDFCenter)) == 0
+			&& memcmp(Header.SDFExtent, Expected.SDFExtent, sizeof(Header.SDFExtent)) == 0
+			&& memcmp(Header.SDFResolution, Expected.SDFResolution, sizeof(Header.SDFResolution)) == 0
+			&& Header.SDFVoxelSize == Expected.SDFVoxelSize, "round trip: the SDF placement");
+
+		Check(IsSameSection(Reader, ECookedMeshSection::Vertices, Mesh.Vertices), "round trip: vertices");
+		Check(IsSameSection(Reader, ECookedMeshSection::Indices32, Mesh.Indices32), "round trip: 32-bit indices");
+		Check(IsSameSection(Reader, ECookedMeshSection::Indices16, Mesh.Indices16), "round trip: 16-bit indices");
+		Check(IsSameSection(Reader, ECookedMeshSection::IndexChunks, Mesh.IndexChunks), "round trip: index chunks");
+		Check(IsSameSection(Reader, ECookedMeshSection::Meshlets, Mesh.Meshlets), "round trip: meshlets");
+		Check(IsSameSection(Reader, ECookedMeshSection::Submeshes, Mesh.Submeshes), "round trip: submeshes");
+		Check(IsSameSection(Reader, ECookedMeshSection::LODIndices, Concatenate(Mesh.LODIndices)), "round trip: LOD indices");
+		Check(IsSameSection(Reader, ECookedMeshSection::LODSubmeshes, Concatenate(Mesh.LODSubmeshes)), "round trip: LOD submeshes");
+
+		std::vector<TCookedMeshLOD> LODTable;
+		bool bSameLODs = Reader.ReadSection(ECookedMeshSection::LODTable, LODTable) && LODTable.size() == Mesh.LODIndices.size();
+		for (size_t LOD = 0; bSameLODs && LOD < LODTable.size(); LOD++)
+		{
+			bSameLODs = LODTable[LOD].IndexCount == Mesh.LODIndices[LOD].size() && LODTable[LOD].Error == Mesh.LODErrors[LOD];
+		}
+		Check(bSameLODs, "round trip: the LOD table");
+
+		std::vector<char> SlotNames;
+		Check(Reader.ReadSection(ECookedMeshSection::MaterialSlotNames, SlotNames)
+			&& std::string(SlotNames.begin(), SlotNames.end()) == std::string("Upper\0Lower\0", 12), "round trip: material slot names");
+
+		// A section read as the wrong element type is refused
+		const TMeshSubmesh* WrongType = nullptr;
+		uint32_t WrongCount = 0;
+		Check(!Reader.GetSection(ECookedMeshSection::Meshlets, WrongType, WrongCount), "round trip: a wrong element type is refused");
+
+		printf("Cooked %zu vertices, %zu indices, %zu meshlets, %zu submeshes and %zu LODs into %zu bytes\n", Mesh.Vertices.size(),
+			Mesh.Indices32.size(), Mesh.Meshlets.size(), Mesh.Submeshes.size(), Mesh.LODIndices.size(), (size_t)std::filesystem::file_size(FilePath));
+	}
+
+	// A reader per attempt, so the mapping is released before the file is rewritten
+	bool CanOpen(const std::filesystem::path& FilePath, const TCookedMeshSourceKey& SourceKey)
+	{
+		TCookedMeshReader Reader;
+
+		return Reader.Open(FilePath.wstring(), SourceKey);
+	}
+
+	void TestRejection(const std::filesystem::path& FilePath, const TCookedMeshSourceKey& SourceKey)
+	{
+		const std::vector<char> Bytes = ReadFile(FilePath);
+		TCookedMeshSourceKey OtherKey = SourceKey;
+		OtherKey.SourceHash++;
+		Check(!CanOpen(FilePath, OtherKey), "reject: another source hash");
+
+		OtherKey = SourceKey;
+		OtherKey.Flags ^= CookedMesh_CompactVertex;
+		Check(!CanOpen(FilePath, OtherKey), "reject: other cook flags");
+
+		std::vector<char> Patched = Bytes;
+		const uint32_t OtherVersion = CookedMeshVersion - 1;
+		memcpy(Patched.data() + offsetof(TCookedMeshHeader, Version), &OtherVersion, sizeof(OtherVersion));
+		WriteFile(FilePath, Patched, Patched.size());
+		Check(!CanOpen(FilePath, SourceKey), "reject: another version");
+
+		Patched = Bytes;
+		Patched[offsetof(TCookedMeshHeader, Magic)] ^= 1;
+		WriteFile(FilePath, Patched, Patched.size());
+		Check(!CanOpen(FilePath, SourceKey), "reject: a wrong magic");
+
+		// A section that claims more bytes than the file holds
+		Patched = Bytes;
+		TCookedMeshHeader Header;
+		memcpy(&Header, Bytes.data(), sizeof(Header));
+		TCookedMeshSection& Meshlets = Header.Sections[(size_t)ECookedMeshSection::Meshlets];
+		Meshlets.ElementCount += 1000;
+		Meshlets.ByteSize = (uint64_t)Meshlets.ElementSize * Meshlets.ElementCount;
+		memcpy(Patched.data(), &Header, sizeof(Header));
+		WriteFile(FilePath, Patched, Patched.size());
+		Check(!CanOpen(FilePath, SourceKey), "reject: a section past the end of the file");
+
+		// Cut inside the header, inside the first section and inside the last one
+		const size_t Truncations[] = { 0, 4, sizeof(TCookedMeshHeader) - 1, sizeof(TCookedMeshHeader) + 100, Bytes.size() / 2, Bytes.size() - 1 };
+		bool bTruncationsRejected = true;
+		for (size_t Size : Truncations)
+		{
+			WriteFile(FilePath, Bytes, Size);
+			bTruncationsRejected &= !CanOpen(FilePath, SourceKey);
+		}
+		Check(bTruncationsRejected, "reject: truncated files");
+
+		// The untouched file is accepted again
+		WriteFile(FilePath, Bytes, Bytes.size());
+		Check(CanOpen(FilePath, SourceKey), "reject: the original file still opens");
+
+		std::filesystem::remove(FilePath);
+		Check(!CanOpen(FilePath, SourceKey), "reject: a missing file");
+	}
+}
+
+int main()
+{
+	const std::filesystem::path FilePath = std::filesystem::temp_directory_path() / "CookedMeshTest.mesh";
+
+	TCookedMeshSourceKey SourceKey;
+	SourceKey.SourceFileSize = 123456;
+	SourceKey.SourceHash = 0xF00DCAFE12345678ull;
+	SourceKey.Flags = CookedMesh_SplitIndices16;
+
+	const TTestMesh Mesh = MakeMesh();
+	TestRoundTrip(FilePath, Mesh, SourceKey);
+	TestRejection(FilePath, SourceKey);
+
+	printf("%s\n", FailureCount == 0 ? "All cooked mesh checks passed" : "Cooked mesh checks FAILED");
+
+	return FailureCount;
+}
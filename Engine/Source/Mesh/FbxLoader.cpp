@@ -1,5 +1,12 @@
 #include "FbxLoader.h"
+#include "MeshAssets.h"
 #include "File/FileHelpers.h"
+#include "VertexWelder.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/FormatConvert.h"
+#include "Utils/Logger.h"
+#include <algorithm>
+#include <chrono>
 
 using namespace std;
 
@@ -12,6 +19,12 @@ void TFbxLoader::Init()
 
 	Manager->SetIOSettings(IOSettings.get());
 
+	bSplitLargeMeshes = false;
+
+	bCompactVertex = true;
+
+	bUseCookedMesh = true;
+
 	//Debug
 	bDebugMode = false;
 
@@ -27,6 +40,28 @@ bool TFbxLoader::LoadFBXMesh(std::wstring MeshName, TMesh& Mesh)
 	//Get model path and convert to UTF8
 	std::wstring ModelDir = TFileHelpers::EngineDir() + L"Resource/Models/";
 	std::wstring ModelPath = ModelDir + MeshName;
+
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	// The cooked file holds the output of everything below, keyed on the FBX contents and the loader flags
+	std::wstring CookedPath = GetCookedMeshPath(MeshName);
+
+	uint32_t CookFlags = (bCompactVertex ? CookedMesh_CompactVertex : 0) | (bSplitLargeMeshes ? CookedMesh_SplitIndices16 : 0);
+
+	TCookedMeshSourceKey SourceKey;
+	bool bCanCook = bUseCookedMesh && GetCookedMeshSourceKey(ModelPath, CookFlags, SourceKey);
+
+	if (bCanCook && Mesh.LoadCooked(CookedPath, SourceKey))
+	{
+		double LoadTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - StartTime).count();
+
+		char CookedLog[256];
+		sprintf_s(CookedLog, "Loaded cooked %s in %.2f ms\n", TFormatConvert::WStrToStr(MeshName).c_str(), LoadTime);
+		TLogger::LogToOutput(CookedLog);
+
+		return true;
+	}
+
 	char* ModelPath_UTF8;
 	FbxWCToUTF8(ModelPath.c_str(), ModelPath_UTF8);
 
@@ -72,24 +107,66 @@ bool TFbxLoader::LoadFBXMesh(std::wstring MeshName, TMesh& Mesh)
 	}
 
 	//Process the scene tree from root node, collect all mesh data after processing
-	ProcessNode(RootNode, Mesh);
+	std::vector<TMesh::uint32> TriangleMaterialSlots;
+	ProcessNode(RootNode, Mesh, TriangleMaterialSlots);
+
+	Mesh.BuildSubmeshes(TriangleMaterialSlots);
+
+	// ImportMesh emits one vertex per triangle corner, merge the duplicates
+	TVertexWeldStats WeldStats = WeldVertices(Mesh.Vertices, Mesh.Indices32, TVertexWeldSettings(), TThreadPool::Get());
+
+	char WeldLog[256];
+	sprintf_s(WeldLog, "Welded %s: %u -> %u vertices\n", TFormatConvert::WStrToStr(MeshName).c_str(),
+		WeldStats.VertexCountBefore, WeldStats.VertexCountAfter);
+	TLogger::LogToOutput(WeldLog);
+
+	Mesh.OptimizeVertexOrder();
+
+	if (bSplitLargeMeshes)
+	{
+		Mesh.SplitIndices16Chunks();
+	}
+
+	Mesh.GenerateLODs();
 
 	Mesh.GenerateIndices16();
+
+	Mesh.BuildMeshlets();
+
+	if (bCompactVertex)
+	{
+		Mesh.UseCompactVertex();
+	}
+
+	Mesh.GenerateBoundingBox();
+
+	double ImportTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - StartTime).count();
+
+	char ImportLog[256];
+	sprintf_s(ImportLog, "Imported %s from FBX in %.2f ms\n", TFormatConvert::WStrToStr(MeshName).c_str(), ImportTime);
+	TLogger::LogToOutput(ImportLog);
+
+	if (bCanCook && !Mesh.SaveCooked(CookedPath, SourceKey))
+	{
+		char CookLog[256];
+		sprintf_s(CookLog, "Failed to write cooked %s\n", TFormatConvert::WStrToStr(MeshName).c_str());
+		TLogger::LogToOutput(CookLog);
+	}
 	
 	return true;
 }
 
-bool TFbxLoader::ProcessNode(FbxNode* Node, TMesh& Mesh)
+bool TFbxLoader::ProcessNode(FbxNode* Node, TMesh& Mesh, std::vector<TMesh::uint32>& TriangleMaterialSlots)
 {
 	if (Node->GetMesh())
 	{
-		if (!ImportMesh(Node, Mesh))
+		if (!ImportMesh(Node, Mesh, TriangleMaterialSlots))
 			return false;
 	}
 
 	for (int i = 0; i < Node->GetChildCount(); i++)
 	{
-		if (!ProcessNode(Node->GetChild(i), Mesh))
+		if (!ProcessNode(Node->GetChild(i), Mesh, TriangleMaterialSlots))
 		{
 			return false;
 		}
@@ -97,7 +174,7 @@ bool TFbxLoader::ProcessNode(FbxNode* Node, TMesh& Mesh)
 	return true;
 }
 
-bool TFbxLoader::ImportMesh(FbxNode* Node, TMesh& Mesh)
+bool TFbxLoader::ImportMesh(FbxNode* Node, TMesh& Mesh, std::vector<TMesh::uint32>& TriangleMaterialSlots)
 {
 	auto MeshObject = Node->GetMesh();
 
@@ -115,8 +192,22 @@ bool TFbxLoader::ImportMesh(FbxNode* Node, TMesh& Mesh)
 
 	FbxAMatrix VertMatrix = Node->EvaluateGlobalTransform() * GetGeometryTransform(Node);
 
+	FbxGeometryElementMaterial* ElementMaterial = MeshObject->GetElementMaterial(0);
+
 	for (uint32_t t = 0; t < numTriangles; t++)
 	{
+		int NodeMaterialIndex = 0;
+		if (ElementMaterial && ElementMaterial->GetMappingMode() == FbxGeometryElement::eByPolygon)
+		{
+			NodeMaterialIndex = ElementMaterial->GetIndexArray().GetAt(t);
+		}
+		else if (ElementMaterial && ElementMaterial->GetIndexArray().GetCount() > 0)
+		{
+			NodeMaterialIndex = ElementMaterial->GetIndexArray().GetAt(0);
+		}
+
+		TriangleMaterialSlots.push_back(GetMaterialSlot(Node, NodeMaterialIndex, Mesh));
+
 		for (uint32_t v = 0; v < 3; v++)
 		{
 			int CtrlPointIndex = MeshObject->GetPolygonVertex(t, v);
@@ -154,6 +245,27 @@ bool TFbxLoader::ImportMesh(FbxNode* Node, TMesh& Mesh)
 	return true;
 }
 
+TMesh::uint32 TFbxLoader::GetMaterialSlot(FbxNode* Node, int NodeMaterialIndex, TMesh& Mesh)
+{
+	FbxSurfaceMaterial* Material = nullptr;
+	if (NodeMaterialIndex >= 0 && NodeMaterialIndex < Node->GetMaterialCount())
+	{
+		Material = Node->GetMaterial(NodeMaterialIndex);
+	}
+
+	std::string SlotName = Material ? Material->GetName() : "Default";
+
+	auto Iter = std::find(Mesh.MaterialSlotNames.begin(), Mesh.MaterialSlotNames.end(), SlotName);
+	if (Iter != Mesh.MaterialSlotNames.end())
+	{
+		return TMesh::uint32(Iter - Mesh.MaterialSlotNames.begin());
+	}
+
+	Mesh.MaterialSlotNames.push_back(SlotName);
+
+	return TMesh::uint32(Mesh.MaterialSlotNames.size() - 1);
+}
+
 FbxAMatrix TFbxLoader::GetGeometryTransform(FbxNode* Node)
 {
 	assert(Node);
@@ -20,9 +20,12 @@ public:
 	bool LoadFBXMesh(std::wstring MeshName, TMesh& Mesh);
 
 private:
-	bool ProcessNode(FbxNode* Node, TMesh& Mesh);
+	bool ProcessNode(FbxNode* Node, TMesh& Mesh, std::vector<TMesh::uint32>& TriangleMaterialSlots);
 
-	bool ImportMesh(FbxNode* Node, TMesh& Mesh);
+	bool ImportMesh(FbxNode* Node, TMesh& Mesh, std::vector<TMesh::uint32>& TriangleMaterialSlots);
+
+	// Mesh wide slot of the node material, slots are shared by name across nodes
+	TMesh::uint32 GetMaterialSlot(FbxNode* Node, int NodeMaterialIndex, TMesh& Mesh);
 
 	FbxAMatrix GetGeometryTransform(FbxNode* Node);
 
@@ -52,4 +55,13 @@ private:
 	std::unique_ptr<FbxIOSettings, TFbxDeleter> IOSettings;
 
 	bool bDebugMode;
+
+	// Split meshes above 65536 vertices into 16-bit chunks instead of using 32-bit indices
+	bool bSplitLargeMeshes;
+
+	// Upload static meshes with the quantized 20-byte vertex format
+	bool bCompactVertex;
+
+	// Load from Save/CookedMesh when the cooked file matches the FBX, write it after every import
+	bool bUseCookedMesh;
 };
\ No newline at end of file
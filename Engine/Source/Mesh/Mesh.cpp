@@ -1,5 +1,10 @@
 #include "Mesh.h"
 #include "File/FileHelpers.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshSDFLayout.h"
+#include "Utils/Logger.h"
+#include <cfloat>
 #include <fstream>
 
 TMesh::TMesh()
@@ -558,12 +563,326 @@ void TMesh::CreateQuad(float x, float y, float w, float h, float depth)
 
 void TMesh::GenerateIndices16()
 {
-	if (Indices16.empty())
+	if (!Indices16.empty())
+	{
+		return;
+	}
+
+	if (!IndexChunks.empty())
+	{
+		Indices16.resize(Indices32.size());
+		for (const TMeshIndexChunk& Chunk : IndexChunks)
+		{
+			for (uint32 i = Chunk.StartIndex; i < Chunk.StartIndex + Chunk.IndexCount; ++i)
+				Indices16[i] = static_cast<uint16>(Indices32[i] - Chunk.BaseVertex);
+		}
+	}
+	else if (Vertices.size() <= MaxVertices16)
 	{
 		Indices16.resize(Indices32.size());
 		for (size_t i = 0; i < Indices32.size(); ++i)
 			Indices16[i] = static_cast<uint16>(Indices32[i]);
 	}
+	// Otherwise the mesh is drawn with Indices32
+}
+
+void TMesh::SplitIndices16Chunks()
+{
+	if (Vertices.size() <= MaxVertices16 || !IndexChunks.empty())
+	{
+		return;
+	}
+
+	EnsureSubmeshes();
+
+	std::vector<TVertex> ChunkedVertices;
+	ChunkedVertices.reserve(Vertices.size());
+
+	// Local index of each source vertex in the current chunk, valid when stamped with the chunk index
+	std::vector<uint32> LocalIndex(Vertices.size());
+	std::vector<uint32> ChunkStamp(Vertices.size(), UINT32_MAX);
+
+	TMeshIndexChunk Chunk;
+	uint32 ChunkIndex = 0;
+
+	for (const TMeshSubmesh& Submesh : Submeshes)
+	{
+		const uint32 FirstTriangle = Submesh.StartIndex / 3;
+		const uint32 EndTriangle = (Submesh.StartIndex + Submesh.IndexCount) / 3;
+
+		for (uint32 t = FirstTriangle; t < EndTriangle; ++t)
+		{
+			uint32 NewVertexCount = 0;
+			for (uint32 k = 0; k < 3; ++k)
+			{
+				if (ChunkStamp[Indices32[t * 3 + k]] != ChunkIndex)
+					NewVertexCount++;
+			}
+
+			// Close the chunk before it overflows or at a submesh border, so every chunk draws one material
+			bool bSubmeshStart = (t == FirstTriangle && Chunk.IndexCount > 0);
+			if (bSubmeshStart || Chunk.VertexCount + NewVertexCount > MaxVertices16)
+			{
+				IndexChunks.push_back(Chunk);
+
+				ChunkIndex++;
+				Chunk.StartIndex = t * 3;
+				Chunk.IndexCount = 0;
+				Chunk.BaseVertex = (uint32)ChunkedVertices.size();
+				Chunk.VertexCount = 0;
+			}
+
+			for (uint32 k = 0; k < 3; ++k)
+			{
+				uint32& Index = Indices32[t * 3 + k];
+
+				if (ChunkStamp[Index] != ChunkIndex)
+				{
+					ChunkStamp[Index] = ChunkIndex;
+					LocalIndex[Index] = Chunk.VertexCount++;
+					ChunkedVertices.push_back(Vertices[Index]);
+				}
+
+				Index = Chunk.BaseVertex + LocalIndex[Index];
+			}
+
+			Chunk.IndexCount += 3;
+		}
+	}
+
+	IndexChunks.push_back(Chunk);
+
+	Vertices = std::move(ChunkedVertices);
+	Indices16.clear();
+}
+
+void TMesh::OptimizeVertexOrder()
+{
+	// Chunk ranges would no longer match the triangle order
+	if (!IndexChunks.empty() || Indices32.empty())
+	{
+		return;
+	}
+
+	EnsureSubmeshes();
+
+	TVertexCacheStats Before = AnalyzeVertexCache(Indices32, (uint32)Vertices.size());
+
+	// Triangles only move inside their submesh
+	for (const TMeshSubmesh& Submesh : Submeshes)
+	{
+		auto SubmeshBegin = Indices32.begin() + Submesh.StartIndex;
+		std::vector<uint32> SubmeshIndices(SubmeshBegin, SubmeshBegin + Submesh.IndexCount);
+
+		OptimizeVertexCache(SubmeshIndices, (uint32)Vertices.size());
+		OptimizeOverdraw(SubmeshIndices, Vertices);
+
+		std::copy(SubmeshIndices.begin(), SubmeshIndices.end(), SubmeshBegin);
+	}
+
+	OptimizeVertexFetch(Vertices, Indices32);
+
+	TVertexCacheStats After = AnalyzeVertexCache(Indices32, (uint32)Vertices.size());
+
+	// Indices16 mirrors the old order
+	if (!Indices16.empty())
+	{
+		Indices16.clear();
+		GenerateIndices16();
+	}
+
+	char Log[256];
+	sprintf_s(Log, "Optimized %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", MeshName.c_str(), Before.ACMR, After.ACMR, Before.ATVR, After.ATVR);
+	TLogger::LogToOutput(Log);
+}
+
+void TMesh::GenerateLODs()
+{
+	LODs.clear();
+
+	// Chunked meshes would need per chunk LOD ranges
+	if (!IndexChunks.empty())
+	{
+		return;
+	}
+
+	EnsureSubmeshes();
+
+	const uint32 MinLODTriangles = 128;
+
+	const std::vector<uint32>* PrevIndices = &Indices32;
+	const std::vector<TMeshSubmesh>* PrevSubmeshes = &Submeshes;
+	float PrevError = 0.0f;
+
+	for (uint32 LODIndex = 1; LODIndex < MaxLODCount; LODIndex++)
+	{
+		const uint32 PrevTriangleCount = (uint32)PrevIndices->size() / 3;
+		if (PrevTriangleCount < MinLODTriangles * 2)
+		{
+			break;
+		}
+
+		// Submeshes are simplified separately, their shared borders stay locked
+		TMeshLOD LOD;
+		uint32 TriangleCount = 0;
+		float MaxError = 0.0f;
+
+		for (size_t i = 0; i < Submeshes.size(); i++)
+		{
+			const TMeshSubmesh& PrevSubmesh = (*PrevSubmeshes)[i];
+			auto PrevBegin = PrevIndices->begin() + PrevSubmesh.StartIndex;
+			std::vector<uint32> SubmeshIndices(PrevBegin, PrevBegin + PrevSubmesh.IndexCount);
+
+			std::vector<uint32> Simplified;
+			const uint32 SubmeshTriangleCount = PrevSubmesh.IndexCount / 3;
+			TSimplifyResult Result = SimplifyMesh(Vertices, SubmeshIndices, (SubmeshTriangleCount / 2) * 3, FLT_MAX, Simplified);
+
+			OptimizeVertexCache(Simplified, (uint32)Vertices.size());
+
+			TMeshSubmesh LODSubmesh;
+			LODSubmesh.StartIndex = (uint32)LOD.Indices.size();
+			LODSubmesh.IndexCount = (uint32)Simplified.size();
+			LODSubmesh.MaterialSlot = PrevSubmesh.MaterialSlot;
+			LOD.Submeshes.push_back(LODSubmesh);
+
+			LOD.Indices.insert(LOD.Indices.end(), Simplified.begin(), Simplified.end());
+
+			TriangleCount += Result.TriangleCount;
+			MaxError = std::max<float>(MaxError, Result.Error);
+		}
+
+		// Locked seams and borders stop the reduction, another level would not pay off
+		if (TriangleCount * 5 > PrevTriangleCount * 4)
+		{
+			break;
+		}
+
+		LOD.Error = PrevError + MaxError;
+
+		char Log[256];
+		sprintf_s(Log, "%s LOD%u: %u -> %u triangles, error %f\n", MeshName.c_str(), LODIndex, PrevTriangleCount, TriangleCount, LOD.Error);
+		TLogger::LogToOutput(Log);
+
+		LODs.push_back(std::move(LOD));
+		PrevIndices = &LODs.back().Indices;
+		PrevSubmeshes = &LODs.back().Submeshes;
+		PrevError = LODs.back().Error;
+	}
+}
+
+void TMesh::BuildMeshlets()
+{
+	Meshlets.clear();
+
+	EnsureSubmeshes();
+
+	for (TMeshSubmesh& Submesh : Submeshes)
+	{
+		Submesh.FirstMeshlet = (uint32)Meshlets.size();
+
+		if (IndexChunks.empty())
+		{
+			::BuildMeshlets(Vertices, Indices32, Submesh.StartIndex, Submesh.IndexCount, Meshlets);
+		}
+		else
+		{
+			// Meshlets must not straddle chunks, each chunk draws with its own BaseVertex.
+			// Chunks never straddle submeshes.
+			const uint32 SubmeshEnd = Submesh.StartIndex + Submesh.IndexCount;
+			for (const TMeshIndexChunk& Chunk : IndexChunks)
+			{
+				if (Chunk.StartIndex < Submesh.StartIndex || Chunk.StartIndex >= SubmeshEnd)
+				{
+					continue;
+				}
+
+				size_t FirstMeshlet = Meshlets.size();
+				::BuildMeshlets(Vertices, Indices32, Chunk.StartIndex, Chunk.IndexCount, Meshlets);
+
+				for (size_t i = FirstMeshlet; i < Meshlets.size(); i++)
+				{
+					Meshlets[i].BaseVertex = (int32_t)Chunk.BaseVertex;
+				}
+			}
+		}
+
+		Submesh.MeshletCount = (uint32)Meshlets.size() - Submesh.FirstMeshlet;
+	}
+
+	char Log[256];
+	sprintf_s(Log, "Built %zu meshlets for %s (%zu triangles)\n", Meshlets.size(), MeshName.c_str(), Indices32.size() / 3);
+	TLogger::LogToOutput(Log);
+}
+
+void TMesh::BuildSubmeshes(const std::vector<uint32>& TriangleMaterialSlots)
+{
+	Submeshes.clear();
+
+	const uint32 TriangleCount = (uint32)Indices32.size() / 3;
+	if (TriangleMaterialSlots.size() != TriangleCount)
+	{
+		EnsureSubmeshes();
+		return;
+	}
+
+	uint32 SlotCount = 1;
+	for (uint32 Slot : TriangleMaterialSlots)
+	{
+		SlotCount = std::max<uint32>(SlotCount, Slot + 1);
+	}
+
+	// Counting sort keeps the triangle order inside each slot
+	std::vector<uint32> SlotTriangleStart(SlotCount + 1, 0);
+	for (uint32 Slot : TriangleMaterialSlots)
+	{
+		SlotTriangleStart[Slot + 1]++;
+	}
+
+	for (uint32 Slot = 0; Slot < SlotCount; Slot++)
+	{
+		const uint32 SlotTriangleCount = SlotTriangleStart[Slot + 1];
+		SlotTriangleStart[Slot + 1] += SlotTriangleStart[Slot];
+
+		if (SlotTriangleCount > 0)
+		{
+			TMeshSubmesh Submesh;
+			Submesh.StartIndex = SlotTriangleStart[Slot] * 3;
+			Submesh.IndexCount = SlotTriangleCount * 3;
+			Submesh.MaterialSlot = Slot;
+			Submeshes.push_back(Submesh);
+		}
+	}
+
+	std::vector<uint32> SortedIndices(Indices32.size());
+	for (uint32 t = 0; t < TriangleCount; t++)
+	{
+		const uint32 Dest = SlotTriangleStart[TriangleMaterialSlots[t]]++;
+		for (uint32 k = 0; k < 3; k++)
+		{
+			SortedIndices[Dest * 3 + k] = Indices32[t * 3 + k];
+		}
+	}
+
+	Indices32 = std::move(SortedIndices);
+	Indices16.clear();
+}
+
+void TMesh::EnsureSubmeshes()
+{
+	if (!Submeshes.empty())
+	{
+		return;
+	}
+
+	TMeshSubmesh Submesh;
+	Submesh.IndexCount = (uint32)Indices32.size();
+	Submeshes.push_back(Submesh);
+}
+
+void TMesh::UseCompactVertex()
+{
+	bCompactVertex = true;
+	InputLayoutName = "CompactInputLayout";
 }
 
 const std::vector<std::uint16_t>& TMesh::GetIndices16() const
@@ -579,4 +898,196 @@ std::string TMesh::GetInputLayoutName() const
 void TMesh::GenerateBoundingBox()
 {
 	BoundingBox.Init(Vertices);
-}
\ No newline at end of file
+
+	const float BoundsMin[3] = { BoundingBox.Min.x, BoundingBox.Min.y, BoundingBox.Min.z };
+	const float BoundsMax[3] = { BoundingBox.Max.x, BoundingBox.Max.y, BoundingBox.Max.z };
+	TMeshSDFLayout Layout = ComputeMeshSDFLayout(BoundsMin, BoundsMax);
+
+	SDFDescriptor = TMeshSDFDescriptor();
+	SDFDescriptor.Center = TVector3(Layout.Center[0], Layout.Center[1], Layout.Center[2]);
+	SDFDescriptor.VoxelSize = Layout.VoxelSize;
+	SDFDescriptor.Extent = TVector3(Layout.Extent[0], Layout.Extent[1], Layout.Extent[2]);
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		SDFDescriptor.Resolution[Axis] = Layout.Resolution[Axis];
+	}
+}
+
+float TMesh::ComputeUVDensity() const
+{
+	double SurfaceArea = 0.0;
+	double UVArea = 0.0;
+
+	for (size_t i = 0; i + 2 < Indices32.size(); i += 3)
+	{
+		const TVertex& V0 = Vertices[Indices32[i + 0]];
+		const TVertex& V1 = Vertices[Indices32[i + 1]];
+		const TVertex& V2 = Vertices[Indices32[i + 2]];
+
+		TVector3 E1 = V1.Position - V0.Position;
+		TVector3 E2 = V2.Position - V0.Position;
+		SurfaceArea += 0.5 * E1.Cross(E2).Length();
+
+		TVector2 T1 = V1.TexC - V0.TexC;
+		TVector2 T2 = V2.TexC - V0.TexC;
+		UVArea += 0.5 * std::abs(T1.x * T2.y - T1.y * T2.x);
+	}
+
+	if (SurfaceArea <= 0.0 || UVArea <= 0.0)
+	{
+		return 1.0f;
+	}
+
+	return (float)std::sqrt(UVArea / SurfaceArea);
+}
+
+bool TMesh::SaveCooked(const std::wstring& FilePath, const TCookedMeshSourceKey& SourceKey) const
+{
+	TCookedMeshWriter Writer;
+	TCookedMeshHeader& Header = Writer.Header;
+	Header.SourceKey = SourceKey;
+
+	Header.BoundsMin[0] = BoundingBox.Min.x;
+	Header.BoundsMin[1] = BoundingBox.Min.y;
+	Header.BoundsMin[2] = BoundingBox.Min.z;
+	Header.BoundsMax[0] = BoundingBox.Max.x;
+	Header.BoundsMax[1] = BoundingBox.Max.y;
+	Header.BoundsMax[2] = BoundingBox.Max.z;
+
+	Header.SDFCenter[0] = SDFDescriptor.Center.x;
+	Header.SDFCenter[1] = SDFDescriptor.Center.y;
+	Header.SDFCenter[2] = SDFDescriptor.Center.z;
+	Header.SDFExtent[0] = SDFDescriptor.Extent.x;
+	Header.SDFExtent[1] = SDFDescriptor.Extent.y;
+	Header.SDFExtent[2] = SDFDescriptor.Extent.z;
+	Header.SDFVoxelSize = SDFDescriptor.VoxelSize;
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		Header.SDFResolution[Axis] = SDFDescriptor.Resolution[Axis];
+	}
+
+	std::vector<uint32> LODIndices;
+	std::vector<TCookedMeshLOD> LODTable;
+	std::vector<TMeshSubmesh> LODSubmeshes;
+	for (const TMeshLOD& LOD : LODs)
+	{
+		LODIndices.insert(LODIndices.end(), LOD.Indices.begin(), LOD.Indices.end());
+		LODSubmeshes.insert(LODSubmeshes.end(), LOD.Submeshes.begin(), LOD.Submeshes.end());
+
+		TCookedMeshLOD CookedLOD;
+		CookedLOD.IndexCount = (uint32)LOD.Indices.size();
+		CookedLOD.Error = LOD.Error;
+		LODTable.push_back(CookedLOD);
+	}
+
+	Writer.SetSection(ECookedMeshSection::Vertices, Vertices);
+	Writer.SetSection(ECookedMeshSection::Indices32, Indices32);
+	Writer.SetSection(ECookedMeshSection::Indices16, Indices16);
+	Writer.SetSection(ECookedMeshSection::IndexChunks, IndexChunks);
+	Writer.SetSection(ECookedMeshSection::Meshlets, Meshlets);
+	Writer.SetSection(ECookedMeshSection::LODIndices, LODIndices);
+	Writer.SetSection(ECookedMeshSection::LODTable, LODTable);
+	Writer.SetSection(ECookedMeshSection::Submeshes, Submeshes);
+	Writer.SetSection(ECookedMeshSection::LODSubmeshes, LODSubmeshes);
+
+	std::vector<char> SlotNames;
+	for (const std::string& Name : MaterialSlotNames)
+	{
+		SlotNames.insert(SlotNames.end(), Name.begin(), Name.end());
+		SlotNames.push_back('\0');
+	}
+	Writer.SetSection(ECookedMeshSection::MaterialSlotNames, SlotNames);
+
+	return Writer.Write(FilePath);
+}
+
+bool TMesh::LoadCooked(const std::wstring& FilePath, const TCookedMeshSourceKey& SourceKey)
+{
+	TCookedMeshReader Reader;
+	if (!Reader.Open(FilePath, SourceKey))
+	{
+		return false;
+	}
+
+	// One bulk copy per blob, no per-vertex parsing
+	std::vector<uint32> LODIndices;
+	std::vector<TCookedMeshLOD> LODTable;
+	std::vector<TMeshSubmesh> LODSubmeshes;
+	std::vector<char> SlotNames;
+	bool bRead = Reader.ReadSection(ECookedMeshSection::Vertices, Vertices)
+		&& Reader.ReadSection(ECookedMeshSection::Indices32, Indices32)
+		&& Reader.ReadSection(ECookedMeshSection::Indices16, Indices16)
+		&& Reader.ReadSection(ECookedMeshSection::IndexChunks, IndexChunks)
+		&& Reader.ReadSection(ECookedMeshSection::Meshlets, Meshlets)
+		&& Reader.ReadSection(ECookedMeshSection::LODIndices, LODIndices)
+		&& Reader.ReadSection(ECookedMeshSection::LODTable, LODTable)
+		&& Reader.ReadSection(ECookedMeshSection::Submeshes, Submeshes)
+		&& Reader.ReadSection(ECookedMeshSection::LODSubmeshes, LODSubmeshes)
+		&& Reader.ReadSection(ECookedMeshSection::MaterialSlotNames, SlotNames);
+
+	if (!bRead || LODSubmeshes.size() != LODTable.size() * Submeshes.size())
+	{
+		return false;
+	}
+
+	for (const TMeshSubmesh& Submesh : Submeshes)
+	{
+		if ((size_t)Submesh.StartIndex + Submesh.IndexCount > Indices32.size())
+		{
+			return false;
+		}
+	}
+
+	MaterialSlotNames.clear();
+	size_t NameStart = 0;
+	for (size_t i = 0; i < SlotNames.size(); i++)
+	{
+		if (SlotNames[i] == '\0')
+		{
+			MaterialSlotNames.emplace_back(SlotNames.data() + NameStart, i - NameStart);
+			NameStart = i + 1;
+		}
+	}
+
+	LODs.clear();
+	size_t LODStart = 0;
+	for (const TCookedMeshLOD& CookedLOD : LODTable)
+	{
+		if (LODStart + CookedLOD.IndexCount > LODIndices.size())
+		{
+			return false;
+		}
+
+		TMeshLOD LOD;
+		LOD.Indices.assign(LODIndices.begin() + LODStart, LODIndices.begin() + LODStart + CookedLOD.IndexCount);
+		LOD.Error = CookedLOD.Error;
+
+		auto SubmeshBegin = LODSubmeshes.begin() + LODs.size() * Submeshes.size();
+		LOD.Submeshes.assign(SubmeshBegin, SubmeshBegin + Submeshes.size());
+
+		LODs.push_back(std::move(LOD));
+
+		LODStart += CookedLOD.IndexCount;
+	}
+
+	const TCookedMeshHeader& Header = Reader.GetHeader();
+
+	BoundingBox.Min = TVector3(Header.BoundsMin[0], Header.BoundsMin[1], Header.BoundsMin[2]);
+	BoundingBox.Max = TVector3(Header.BoundsMax[0], Header.BoundsMax[1], Header.BoundsMax[2]);
+	BoundingBox.bInit = true;
+
+	SDFDescriptor.Center = TVector3(Header.SDFCenter[0], Header.SDFCenter[1], Header.SDFCenter[2]);
+	SDFDescriptor.Extent = TVector3(Header.SDFExtent[0], Header.SDFExtent[1], Header.SDFExtent[2]);
+	SDFDescriptor.VoxelSize = Header.SDFVoxelSize;
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		SDFDescriptor.Resolution[Axis] = Header.SDFResolution[Axis];
+	}
+
+	if (Header.SourceKey.Flags & CookedMesh_CompactVertex)
+	{
+		UseCompactVertex();
+	}
+
+	return true;
+}
@@ -6,17 +6,36 @@
 #include <memory>
 #include "Vertex.h"
 #include "BoundingBox.h"
+#include "Meshlet.h"
+#include "CookedMesh.h"
 #include "Texture/Texture.h"
 
+// Match MeshSDFDescriptor in SDFShared.hlsl, placed by ComputeMeshSDFLayout
 struct TMeshSDFDescriptor
 {
 	TVector3 Center;
-	float Extent;
+	float VoxelSize;
 
-	int Resolution;
-	int pad1;
-	int pad2;
-	int pad3;
+	// Half size of the volume per axis
+	TVector3 Extent;
+
+	// First entry of the mesh in the SDF brick indirection buffer, set by TRender::UpdateSDFData
+	int IndirectionOffset;
+
+	int Resolution[3];
+	int pad0;
+};
+
+// Simplified index list over the shared vertex buffer
+struct TMeshLOD
+{
+	std::vector<uint32_t> Indices;
+
+	// Ranges in Indices, one per TMesh::Submeshes entry and in the same order
+	std::vector<TMeshSubmesh> Submeshes;
+
+	// Accumulated simplification error against LOD0 in mesh space units
+	float Error = 0.0f;
 };
 
 class TMesh
@@ -25,6 +44,12 @@ public:
 	using uint16 = std::uint16_t;
 	using uint32 = std::uint32_t;
 
+	// Vertices addressable by one 16-bit index range
+	static const uint32 MaxVertices16 = 65536;
+
+	// Including LOD0
+	static const uint32 MaxLODCount = 5;
+
 	TMesh();
 
 	TMesh(TMesh&&) = default;
@@ -61,29 +86,49 @@ public:
 
 	std::string GetInputLayoutName() const;
 
+	// Fills Indices16 only when the mesh (or every chunk) fits 16-bit indices
 	void GenerateIndices16();
 
+	bool HasIndices16() const { return !Indices16.empty(); }
+
+	// Reorder vertices into chunks of at most MaxVertices16 so large meshes keep 16-bit indices.
+	// Vertices shared across chunk borders are duplicated, Indices32 stays valid.
+	void SplitIndices16Chunks();
+
+	// Reorder triangles for the post-transform cache and overdraw, then vertices for fetch locality.
+	// Logs simulated ACMR/ATVR before and after.
+	void OptimizeVertexOrder();
+
+	// Build LOD1 and coarser by halving the triangle count of the previous LOD with quadric simplification.
+	// Skipped for meshes split into 16-bit chunks.
+	void GenerateLODs();
+
+	// Upload as quantized position and attribute streams (CompactInputLayout) instead of TVertex
+	void UseCompactVertex();
+
+	// Split the final index order into meshlets for per-cluster culling, call after GenerateIndices16
+	void BuildMeshlets();
+
+	// Group triangles by material slot (stable) and build one submesh per used slot
+	void BuildSubmeshes(const std::vector<uint32>& TriangleMaterialSlots);
+
+	// Single submesh over all indices for meshes built without a submesh table
+	void EnsureSubmeshes();
+
+	// Store the output of the load pipeline, bounds and SDF placement as a cooked binary file
+	bool SaveCooked(const std::wstring& FilePath, const TCookedMeshSourceKey& SourceKey) const;
+
+	// Restore from a cooked file, false if it is missing or stale for SourceKey
+	bool LoadCooked(const std::wstring& FilePath, const TCookedMeshSourceKey& SourceKey);
+
 public:
+	// Also places the SDF volume around the new bounds
 	void GenerateBoundingBox();
 
-	TBoundingBox GetBoundingBox() { return BoundingBox; }
+	// Average UV units per unit of surface length, used to estimate texture footprint on screen
+	float ComputeUVDensity() const;
 
-	void SetSDFTexture(std::unique_ptr<TTexture3D>& InSDFTexture)
-	{ 
-		SDFTexture = std::move(InSDFTexture);
-	}
-
-	TTexture3D* GetSDFTexture()
-	{
-		if (SDFTexture)
-		{
-			return SDFTexture.get();
-		}
-		else
-		{
-			return nullptr;
-		}
-	}
+	TBoundingBox GetBoundingBox() { return BoundingBox; }
 
 private:
 
@@ -104,12 +149,29 @@ public:
 
 	std::vector<uint16> Indices16;
 
+	// Empty unless SplitIndices16Chunks was called on a large mesh
+	std::vector<TMeshIndexChunk> IndexChunks;
+
+	// Sorted by StartIndex and covering Indices32, chunks and meshlets never straddle two submeshes
+	std::vector<TMeshSubmesh> Submeshes;
+
+	// Imported material names, indexed by TMeshSubmesh::MaterialSlot
+	std::vector<std::string> MaterialSlotNames;
+
+	// Contiguous index ranges with bounds and normal cones
+	std::vector<TMeshlet> Meshlets;
+
+	// LOD1 and coarser, LOD0 is Indices32
+	std::vector<TMeshLOD> LODs;
+
 	std::string InputLayoutName;
 
+	bool bCompactVertex = false;
+
 	TBoundingBox BoundingBox;
 
-	// SDF
-	std::unique_ptr<TTexture3D> SDFTexture = nullptr;
+	// SDF, one atlas slot or empty brick entry per SDF brick (see SDFBrickAtlas.h)
+	std::vector<uint32_t> SDFBrickIndirection;
 
 	TMeshSDFDescriptor SDFDescriptor;
 };
\ No newline at end of file
@@ -0,0 +1,26 @@
+#include "MeshAssets.h"
+#include "File/FileHelpers.h"
+#include "Utils/FormatConvert.h"
+
+const std::vector<TFbxMeshAsset>& GetFbxMeshAssets()
+{
+	static const std::vector<TFbxMeshAsset> Assets =
+	{
+		{ "AssaultRifle", L"LOW_WEPON.fbx" },
+		{ "CyborgWeapon", L"Cyborg_Weapon.fbx" },
+		{ "Helmet", L"helmet_low.fbx" },
+		{ "Column", L"column.fbx" },
+	};
+
+	return Assets;
+}
+
+std::wstring GetCookedMeshPath(const std::wstring& FileName)
+{
+	return TFileHelpers::EngineDir() + L"Save/CookedMesh/" + FileName + L".mesh";
+}
+
+std::wstring GetMeshSDFPath(const std::string& MeshName)
+{
+	return TFileHelpers::EngineDir() + L"Save/MeshSDF/" + TFormatConvert::StrToWStr(MeshName) + L".sdf";
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct TFbxMeshAsset
+{
+	std::string MeshName;
+
+	// Relative to Resource/Models
+	std::wstring FileName;
+};
+
+// Imported meshes, shared by TMeshRepository and the asset cooker
+const std::vector<TFbxMeshAsset>& GetFbxMeshAssets();
+
+// Save/CookedMesh/<FileName>.mesh, FileName is the FBX file name
+std::wstring GetCookedMeshPath(const std::wstring& FileName);
+
+// Save/MeshSDF/<MeshName>.sdf
+std::wstring GetMeshSDFPath(const std::string& MeshName);
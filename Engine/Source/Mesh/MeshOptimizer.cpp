@@ -0,0 +1,445 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Cache size the Forsyth scores are tuned for
+	const uint32_t ScoringCacheSize = 32;
+
+	const float CacheDecayPower = 1.5f;
+
+	const float LastTriangleScore = 0.75f;
+
+	const float ValenceBoostScale = 2.0f;
+
+	const float ValenceBoostPower = 0.5f;
+
+	float ComputeVertexScore(int32_t CachePosition, uint32_t RemainingValence)
+	{
+		// No triangles left to use this vertex
+		if (RemainingValence == 0)
+		{
+			return -1.0f;
+		}
+
+		float Score = 0.0f;
+
+		if (CachePosition >= 0)
+		{
+			if (CachePosition < 3)
+			{
+				// Used by the last triangle, fixed score so strips aren't favoured over fans
+				Score = LastTriangleScore;
+			}
+			else
+			{
+				float Scaler = 1.0f / (ScoringCacheSize - 3);
+				Score = std::pow(1.0f - (CachePosition - 3) * Scaler, CacheDecayPower);
+			}
+		}
+
+		// Prefer finishing vertices with few triangles left
+		Score += ValenceBoostScale * std::pow((float)RemainingValence, -ValenceBoostPower);
+
+		return Score;
+	}
+
+	// Misses of each triangle against a FIFO cache, the cache is flushed at index 0
+	void SimulateTriangleMisses(const std::vector<uint32_t>& Indices, uint32_t VertexCount, uint32_t CacheSize,
+		std::vector<uint8_t>& OutMisses)
+	{
+		const uint32_t TriangleCount = (uint32_t)Indices.size() / 3;
+		OutMisses.assign(TriangleCount, 0);
+
+		// A vertex is cached while fewer than CacheSize misses happened since it was loaded
+		std::vector<uint32_t> LoadTime(VertexCount, 0);
+		uint32_t Time = CacheSize + 1;
+
+		for (uint32_t t = 0; t < TriangleCount; t++)
+		{
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint32_t Vertex = Indices[t * 3 + k];
+				if (Time - LoadTime[Vertex] > CacheSize)
+				{
+					LoadTime[Vertex] = Time++;
+					OutMisses[t]++;
+				}
+			}
+		}
+	}
+}
+
+TVertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& Indices, uint32_t VertexCount, uint32_t CacheSize)
+{
+	TVertexCacheStats Stats;
+	Stats.TriangleCount = (uint32_t)Indices.size() / 3;
+	Stats.VertexCount = VertexCount;
+
+	std::vector<uint8_t> Misses;
+	SimulateTriangleMisses(Indices, VertexCount, CacheSize, Misses);
+
+	for (uint8_t TriangleMisses : Misses)
+	{
+		Stats.CacheMisses += TriangleMisses;
+	}
+
+	if (Stats.TriangleCount > 0)
+	{
+		Stats.ACMR = (float)Stats.CacheMisses / Stats.TriangleCount;
+	}
+
+	if (Stats.VertexCount > 0)
+	{
+		Stats.ATVR = (float)Stats.CacheMisses / Stats.VertexCount;
+	}
+
+	return Stats;
+}
+
+void OptimizeVertexCache(std::vector<uint32_t>& Indices, uint32_t VertexCount)
+{
+	const uint32_t TriangleCount = (uint32_t)Indices.size() / 3;
+	if (TriangleCount == 0)
+	{
+		return;
+	}
+
+	// Triangles using each vertex, the live ones are kept at the front of each range
+	std::vector<uint32_t> Valence(VertexCount, 0);
+	for (uint32_t Index : Indices)
+	{
+		Valence[Index]++;
+	}
+
+	std::vector<uint32_t> AdjacencyOffsets(VertexCount + 1, 0);
+	for (uint32_t v = 0; v < VertexCount; v++)
+	{
+		AdjacencyOffsets[v + 1] = AdjacencyOffsets[v] + Valence[v];
+	}
+
+	std::vector<uint32_t> AdjacentTriangles(Indices.size());
+	{
+		std::vector<uint32_t> FillCount(VertexCount, 0);
+		for (uint32_t t = 0; t < TriangleCount; t++)
+		{
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint32_t Vertex = Indices[t * 3 + k];
+				AdjacentTriangles[AdjacencyOffsets[Vertex] + FillCount[Vertex]++] = t;
+			}
+		}
+	}
+
+	std::vector<float> VertexScores(VertexCount);
+	for (uint32_t v = 0; v < VertexCount; v++)
+	{
+		VertexScores[v] = ComputeVertexScore(-1, Valence[v]);
+	}
+
+	std::vector<float> TriangleScores(TriangleCount);
+	std::vector<bool> Emitted(TriangleCount, false);
+	for (uint32_t t = 0; t < TriangleCount; t++)
+	{
+		TriangleScores[t] = VertexScores[Indices[t * 3]] + VertexScores[Indices[t * 3 + 1]] + VertexScores[Indices[t * 3 + 2]];
+	}
+
+	std::vector<uint32_t> Output;
+	Output.reserve(Indices.size());
+
+	uint32_t Cache[ScoringCacheSize + 3];
+	uint32_t NewCache[ScoringCacheSize + 3];
+	uint32_t CacheCount = 0;
+
+	int64_t BestTriangle = std::max_element(TriangleScores.begin(), TriangleScores.end()) - TriangleScores.begin();
+	uint32_t ScanPosition = 0;
+
+	while (Output.size() < Indices.size())
+	{
+		if (BestTriangle < 0)
+		{
+			// Nothing adjacent to the cache is left, continue with the next unused triangle
+			while (Emitted[ScanPosition])
+			{
+				ScanPosition++;
+			}
+
+			BestTriangle = ScanPosition;
+		}
+
+		const uint32_t Triangle = (uint32_t)BestTriangle;
+		const uint32_t* TriangleVertices = &Indices[Triangle * 3];
+
+		Output.insert(Output.end(), TriangleVertices, TriangleVertices + 3);
+		Emitted[Triangle] = true;
+
+		// Remove the triangle from its vertices' live adjacency
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			uint32_t Vertex = TriangleVertices[k];
+			uint32_t* Adjacency = &AdjacentTriangles[AdjacencyOffsets[Vertex]];
+
+			for (uint32_t a = 0; a < Valence[Vertex]; a++)
+			{
+				if (Adjacency[a] == Triangle)
+				{
+					std::swap(Adjacency[a], Adjacency[Valence[Vertex] - 1]);
+					Valence[Vertex]--;
+					break;
+				}
+			}
+		}
+
+		// Move the triangle's vertices to the front of the LRU cache
+		uint32_t NewCacheCount = 0;
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			NewCache[NewCacheCount++] = TriangleVertices[k];
+		}
+
+		for (uint32_t c = 0; c < CacheCount; c++)
+		{
+			uint32_t Vertex = Cache[c];
+			if (Vertex != TriangleVertices[0] && Vertex != TriangleVertices[1] && Vertex != TriangleVertices[2])
+			{
+				NewCache[NewCacheCount++] = Vertex;
+			}
+		}
+
+		// Rescore every vertex that moved, including the ones pushed out of the cache
+		BestTriangle = -1;
+		float BestScore = -1.0f;
+
+		for (uint32_t c = 0; c < NewCacheCount; c++)
+		{
+			uint32_t Vertex = NewCache[c];
+			int32_t CachePosition = (c < ScoringCacheSize) ? (int32_t)c : -1;
+
+			float Score = ComputeVertexScore(CachePosition, Valence[Vertex]);
+			float ScoreDelta = Score - VertexScores[Vertex];
+			VertexScores[Vertex] = Score;
+
+			const uint32_t* Adjacency = &AdjacentTriangles[AdjacencyOffsets[Vertex]];
+			for (uint32_t a = 0; a < Valence[Vertex]; a++)
+			{
+				uint32_t AdjacentTriangle = Adjacency[a];
+				TriangleScores[AdjacentTriangle] += ScoreDelta;
+
+				if (CachePosition >= 0 && TriangleScores[AdjacentTriangle] > BestScore)
+				{
+					BestScore = TriangleScores[AdjacentTriangle];
+					BestTriangle = AdjacentTriangle;
+				}
+			}
+		}
+
+		CacheCount = std::min<uint32_t>(NewCacheCount, ScoringCacheSize);
+		std::copy(NewCache, NewCache + CacheCount, Cache);
+	}
+
+	Indices.swap(Output);
+}
+
+void OptimizeOverdraw(std::vector<uint32_t>& Indices, const std::vector<TVertex>& Vertices, float Threshold)
+{
+	const uint32_t TriangleCount = (uint32_t)Indices.size() / 3;
+	if (TriangleCount < 2)
+	{
+		return;
+	}
+
+	const uint32_t CacheSize = 16;
+
+	std::vector<uint8_t> Misses;
+	SimulateTriangleMisses(Indices, (uint32_t)Vertices.size(), CacheSize, Misses);
+
+	// Hard boundaries: every vertex missed, so the cache restarts here anyway
+	std::vector<uint32_t> HardClusters;
+	for (uint32_t t = 0; t < TriangleCount; t++)
+	{
+		if (t == 0 || Misses[t] == 3)
+		{
+			HardClusters.push_back(t);
+		}
+	}
+	HardClusters.push_back(TriangleCount);
+
+	// Soft boundaries: split further once a cluster drawn from a cold cache is as good as the whole hard cluster.
+	// Reordering makes every cluster start cold, so that's how misses are counted here.
+	std::vector<uint32_t> LoadTime(Vertices.size(), 0);
+	uint32_t Time = 0;
+
+	auto FlushCache = [&]()
+	{
+		Time += CacheSize + 1;
+	};
+
+	auto CountMisses = [&](uint32_t Triangle)
+	{
+		uint32_t TriangleMisses = 0;
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			uint32_t Vertex = Indices[Triangle * 3 + k];
+			if (Time - LoadTime[Vertex] > CacheSize)
+			{
+				LoadTime[Vertex] = Time++;
+				TriangleMisses++;
+			}
+		}
+		return TriangleMisses;
+	};
+
+	std::vector<uint32_t> ClusterStarts;
+	for (size_t h = 0; h + 1 < HardClusters.size(); h++)
+	{
+		uint32_t Start = HardClusters[h];
+		uint32_t End = HardClusters[h + 1];
+
+		FlushCache();
+
+		uint32_t ClusterMisses = 0;
+		for (uint32_t t = Start; t < End; t++)
+		{
+			ClusterMisses += CountMisses(t);
+		}
+
+		float ClusterThreshold = Threshold * (float)ClusterMisses / (End - Start);
+
+		ClusterStarts.push_back(Start);
+		FlushCache();
+
+		uint32_t RunningMisses = 0;
+		uint32_t RunningTriangles = 0;
+		for (uint32_t t = Start; t < End; t++)
+		{
+			RunningMisses += CountMisses(t);
+			RunningTriangles++;
+
+			if (t + 1 < End && (float)RunningMisses / RunningTriangles <= ClusterThreshold)
+			{
+				ClusterStarts.push_back(t + 1);
+				FlushCache();
+				RunningMisses = 0;
+				RunningTriangles = 0;
+			}
+		}
+	}
+
+	const uint32_t ClusterCount = (uint32_t)ClusterStarts.size();
+	ClusterStarts.push_back(TriangleCount);
+
+	// Area weighted centroid and normal of the mesh and every cluster
+	struct TClusterInfo
+	{
+		float Centroid[3] = { 0.0f, 0.0f, 0.0f };
+
+		float Normal[3] = { 0.0f, 0.0f, 0.0f };
+
+		float Area = 0.0f;
+
+		float SortKey = 0.0f;
+	};
+
+	std::vector<TClusterInfo> Clusters(ClusterCount);
+	float MeshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+	float MeshArea = 0.0f;
+
+	for (uint32_t c = 0; c < ClusterCount; c++)
+	{
+		TClusterInfo& Cluster = Clusters[c];
+
+		for (uint32_t t = ClusterStarts[c]; t < ClusterStarts[c + 1]; t++)
+		{
+			const TVector3& P0 = Vertices[Indices[t * 3 + 0]].Position;
+			const TVector3& P1 = Vertices[Indices[t * 3 + 1]].Position;
+			const TVector3& P2 = Vertices[Indices[t * 3 + 2]].Position;
+
+			float E1[3] = { P1.x - P0.x, P1.y - P0.y, P1.z - P0.z };
+			float E2[3] = { P2.x - P0.x, P2.y - P0.y, P2.z - P0.z };
+			float N[3] = { E1[1] * E2[2] - E1[2] * E2[1], E1[2] * E2[0] - E1[0] * E2[2], E1[0] * E2[1] - E1[1] * E2[0] };
+			float Area = std::sqrt(N[0] * N[0] + N[1] * N[1] + N[2] * N[2]);
+
+			Cluster.Centroid[0] += (P0.x + P1.x + P2.x) * (Area / 3.0f);
+			Cluster.Centroid[1] += (P0.y + P1.y + P2.y) * (Area / 3.0f);
+			Cluster.Centroid[2] += (P0.z + P1.z + P2.z) * (Area / 3.0f);
+			Cluster.Normal[0] += N[0];
+			Cluster.Normal[1] += N[1];
+			Cluster.Normal[2] += N[2];
+			Cluster.Area += Area;
+		}
+
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			MeshCentroid[i] += Cluster.Centroid[i];
+		}
+		MeshArea += Cluster.Area;
+
+		float InvArea = Cluster.Area > 0.0f ? 1.0f / Cluster.Area : 0.0f;
+		float NormalLength = std::sqrt(Cluster.Normal[0] * Cluster.Normal[0] + Cluster.Normal[1] * Cluster.Normal[1] + Cluster.Normal[2] * Cluster.Normal[2]);
+		float InvNormalLength = NormalLength > 0.0f ? 1.0f / NormalLength : 0.0f;
+
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			Cluster.Centroid[i] *= InvArea;
+			Cluster.Normal[i] *= InvNormalLength;
+		}
+	}
+
+	float InvMeshArea = MeshArea > 0.0f ? 1.0f / MeshArea : 0.0f;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		MeshCentroid[i] *= InvMeshArea;
+	}
+
+	// Clusters facing away from the center are likely occluders, draw them first
+	for (TClusterInfo& Cluster : Clusters)
+	{
+		Cluster.SortKey = (Cluster.Centroid[0] - MeshCentroid[0]) * Cluster.Normal[0]
+			+ (Cluster.Centroid[1] - MeshCentroid[1]) * Cluster.Normal[1]
+			+ (Cluster.Centroid[2] - MeshCentroid[2]) * Cluster.Normal[2];
+	}
+
+	std::vector<uint32_t> ClusterOrder(ClusterCount);
+	for (uint32_t c = 0; c < ClusterCount; c++)
+	{
+		ClusterOrder[c] = c;
+	}
+
+	std::stable_sort(ClusterOrder.begin(), ClusterOrder.end(), [&](uint32_t A, uint32_t B)
+	{
+		return Clusters[A].SortKey > Clusters[B].SortKey;
+	});
+
+	std::vector<uint32_t> Output;
+	Output.reserve(Indices.size());
+
+	for (uint32_t c : ClusterOrder)
+	{
+		Output.insert(Output.end(), Indices.begin() + ClusterStarts[c] * 3, Indices.begin() + ClusterStarts[c + 1] * 3);
+	}
+
+	Indices.swap(Output);
+}
+
+void OptimizeVertexFetch(std::vector<TVertex>& Vertices, std::vector<uint32_t>& Indices)
+{
+	const uint32_t Unused = UINT32_MAX;
+
+	std::vector<uint32_t> Remap(Vertices.size(), Unused);
+	std::vector<TVertex> NewVertices;
+	NewVertices.reserve(Vertices.size());
+
+	for (uint32_t& Index : Indices)
+	{
+		if (Remap[Index] == Unused)
+		{
+			Remap[Index] = (uint32_t)NewVertices.size();
+			NewVertices.push_back(Vertices[Index]);
+		}
+
+		Index = Remap[Index];
+	}
+
+	Vertices.swap(NewVertices);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+struct TVertexCacheStats
+{
+	uint32_t TriangleCount = 0;
+
+	uint32_t VertexCount = 0;
+
+	uint32_t CacheMisses = 0;
+
+	// Average cache miss ratio, transformed vertices per triangle (0.5 is ideal for large grids, 3 is worst)
+	float ACMR = 0.0f;
+
+	// Average transform to vertex ratio, 1 means each vertex is shaded once
+	float ATVR = 0.0f;
+};
+
+// Simulate a FIFO post-transform cache over a triangle list
+TVertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& Indices, uint32_t VertexCount, uint32_t CacheSize = 16);
+
+// Reorder triangles for post-transform cache locality (Forsyth's linear-speed algorithm)
+void OptimizeVertexCache(std::vector<uint32_t>& Indices, uint32_t VertexCount);
+
+// Split a cache-optimized list into clusters and draw outward-facing clusters first to cut overdraw.
+// Clusters are only split where the cache miss ratio stays within Threshold of the input.
+void OptimizeOverdraw(std::vector<uint32_t>& Indices, const std::vector<TVertex>& Vertices, float Threshold = 1.05f);
+
+// Reorder vertices by first use so fetches walk the vertex buffer linearly, unused vertices are dropped
+void OptimizeVertexFetch(std::vector<TVertex>& Vertices, std::vector<uint32_t>& Indices);
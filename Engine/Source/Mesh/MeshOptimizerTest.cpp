@@ -0,0 +1,226 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// Runs the Forsyth cache optimizer on a row by row grid and on the same grid in random triangle order, checks that the
+// simulated ACMR drops below both inputs and that the triangle set, windings included, is unchanged. Then checks that
+// the overdraw and vertex fetch passes keep the triangles and the cache efficiency. Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	typedef std::array<uint32_t, 3> TTriangle;
+
+	// Rotated so the smallest index comes first, which keeps the winding
+	std::vector<TTriangle> GetSortedTriangles(const std::vector<uint32_t>& Indices)
+	{
+		std::vector<TTriangle> Triangles;
+		for (size_t i = 0; i + 2 < Indices.size(); i += 3)
+		{
+			TTriangle Triangle = { Indices[i], Indices[i + 1], Indices[i + 2] };
+			std::rotate(Triangle.begin(), std::min_element(Triangle.begin(), Triangle.end()), Triangle.end());
+			Triangles.push_back(Triangle);
+		}
+		std::sort(Triangles.begin(), Triangles.end());
+
+		return Triangles;
+	}
+
+	// Size x Size quads in the XZ plane, two triangles each, row by row
+	void MakeGrid(uint32_t Size, std::vector<TVertex>& OutVertices, std::vector<uint32_t>& OutIndices)
+	{
+		OutVertices.clear();
+		OutIndices.clear();
+
+		for (uint32_t z = 0; z <= Size; z++)
+		{
+			for (uint32_t x = 0; x <= Size; x++)
+			{
+				OutVertices.push_back(TVertex((float)x, 0.0f, (float)z, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, (float)x / Size, (float)z / Size));
+			}
+		}
+
+		for (uint32_t z = 0; z < Size; z++)
+		{
+			for (uint32_t x = 0; x < Size; x++)
+			{
+				const uint32_t Corner = z * (Size + 1) + x;
+				const uint32_t QuadIndices[6] = { Corner, Corner + Size + 1, Corner + 1, Corner + 1, Corner + Size + 1, Corner + Size + 2 };
+				OutIndices.insert(OutIndices.end(), QuadIndices, QuadIndices + 6);
+			}
+		}
+	}
+
+	// Latitude/longitude sphere, outward facing
+	void MakeSphere(uint32_t Rings, uint32_t Segments, std::vector<TVertex>& OutVertices, std::vector<uint32_t>& OutIndices)
+	{
+		OutVertices.clear();
+		OutIndices.clear();
+
+		for (uint32_t r = 0; r <= Rings; r++)
+		{
+			const float Theta = 3.14159265f * r / Rings;
+			for (uint32_t s = 0; s <= Segments; s++)
+			{
+				const float Phi = 6.28318531f * s / Segments;
+				const float X = std::sin(Theta) * std::cos(Phi);
+				const float Y = std::cos(Theta);
+				const float Z = std::sin(Theta) * std::sin(Phi);
+				OutVertices.push_back(TVertex(X, Y, Z, X, Y, Z, -std::sin(Phi), 0.0f, std::cos(Phi), (float)s / Segments, (float)r / Rings));
+			}
+		}
+
+		for (uint32_t r = 0; r < Rings; r++)
+		{
+			for (uint32_t s = 0; s < Segments; s++)
+			{
+				const uint32_t Corner = r * (Segments + 1) + s;
+				const uint32_t QuadIndices[6] = { Corner, Corner + 1, Corner + Segments + 1, Corner + 1, Corner + Segments + 2, Corner + Segments + 1 };
+				OutIndices.insert(OutIndices.end(), QuadIndices, QuadIndices + 6);
+			}
+		}
+	}
+
+	void ShuffleTriangles(std::vector<uint32_t>& Indices, uint32_t Seed)
+	{
+		std::vector<TTriangle> Triangles(Indices.size() / 3);
+		for (size_t t = 0; t < Triangles.size(); t++)
+		{
+			Triangles[t] = { Indices[t * 3], Indices[t * 3 + 1], Indices[t * 3 + 2] };
+		}
+
+		std::shuffle(Triangles.begin(), Triangles.end(), std::mt19937(Seed));
+
+		for (size_t t = 0; t < Triangles.size(); t++)
+		{
+			std::copy(Triangles[t].begin(), Triangles[t].end(), Indices.begin() + t * 3);
+		}
+	}
+
+	void TestAnalyze()
+	{
+		// One triangle misses every vertex, drawing it again hits every one
+		const std::vector<uint32_t> Twice = { 0, 1, 2, 0, 1, 2 };
+		TVertexCacheStats Stats = AnalyzeVertexCache(Twice, 3);
+		Check(Stats.CacheMisses == 3 && Stats.ACMR == 1.5f && Stats.ATVR == 1.0f, "analyze: a repeated triangle only misses once");
+
+		// A FIFO of 3 entries has evicted vertex 0 by the time it is used again
+		const std::vector<uint32_t> Fan = { 0, 1, 2, 3, 4, 5, 0, 1, 2 };
+		Stats = AnalyzeVertexCache(Fan, 6, 3);
+		Check(Stats.CacheMisses == 9, "analyze: a small FIFO evicts the oldest vertices");
+		Stats = AnalyzeVertexCache(Fan, 6, 16);
+		Check(Stats.CacheMisses == 6, "analyze: a large FIFO keeps them");
+	}
+
+	void TestVertexCache()
+	{
+		std::vector<TVertex> Vertices;
+		std::vector<uint32_t> RowIndices;
+		MakeGrid(128, Vertices, RowIndices);
+		const uint32_t VertexCount = (uint32_t)Vertices.size();
+
+		std::vector<uint32_t> ShuffledIndices = RowIndices;
+		ShuffleTriangles(ShuffledIndices, 1);
+
+		const TVertexCacheStats RowStats = AnalyzeVertexCache(RowIndices, VertexCount);
+		const TVertexCacheStats ShuffledStats = AnalyzeVertexCache(ShuffledIndices, VertexCount);
+
+		std::vector<uint32_t> Optimized = ShuffledIndices;
+		const auto StartTime = std::chrono::steady_clock::now();
+		OptimizeVertexCache(Optimized, VertexCount);
+		const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+		const TVertexCacheStats OptimizedStats = AnalyzeVertexCache(Optimized, VertexCount);
+
+		std::vector<uint32_t> OptimizedRows = RowIndices;
+		OptimizeVertexCache(OptimizedRows, VertexCount);
+		const TVertexCacheStats OptimizedRowStats = AnalyzeVertexCache(OptimizedRows, VertexCount);
+
+		printf("128x128 grid ACMR (FIFO 16): rows %.3f, shuffled %.3f, optimized from shuffled %.3f, from rows %.3f, ATVR %.3f, %.1f ms\n",
+			RowStats.ACMR, ShuffledStats.ACMR, OptimizedStats.ACMR, OptimizedRowStats.ACMR, OptimizedStats.ATVR, Seconds * 1000.0);
+
+		Check(OptimizedStats.ACMR < ShuffledStats.ACMR * 0.3f, "cache: the optimizer cuts the ACMR of a shuffled grid");
+		Check(OptimizedStats.ACMR < RowStats.ACMR, "cache: the optimizer beats drawing the grid row by row");
+		Check(OptimizedRowStats.ACMR < RowStats.ACMR, "cache: the optimizer improves a row by row grid");
+		Check(OptimizedStats.ACMR < 0.8f, "cache: the ACMR approaches 0.5 on a grid");
+
+		const std::vector<TTriangle> Triangles = GetSortedTriangles(RowIndices);
+		Check(GetSortedTriangles(Optimized) == Triangles, "cache: the same triangles with the same windings");
+		Check(GetSortedTriangles(OptimizedRows) == Triangles, "cache: the same triangles from the row by row input");
+
+		std::vector<uint32_t> Empty;
+		OptimizeVertexCache(Empty, 0);
+		Check(Empty.empty(), "cache: an empty list stays empty");
+	}
+
+	void TestOverdrawAndFetch()
+	{
+		std::vector<TVertex> Vertices;
+		std::vector<uint32_t> Indices;
+		MakeSphere(48, 96, Vertices, Indices);
+		ShuffleTriangles(Indices, 2);
+
+		OptimizeVertexCache(Indices, (uint32_t)Vertices.size());
+		const TVertexCacheStats CacheStats = AnalyzeVertexCache(Indices, (uint32_t)Vertices.size());
+		const std::vector<TTriangle> Triangles = GetSortedTriangles(Indices);
+
+		const float Threshold = 1.05f;
+		OptimizeOverdraw(Indices, Vertices, Threshold);
+		const TVertexCacheStats OverdrawStats = AnalyzeVertexCache(Indices, (uint32_t)Vertices.size());
+
+		printf("Sphere ACMR: cache optimized %.3f, overdraw optimized %.3f\n", CacheStats.ACMR, OverdrawStats.ACMR);
+
+		Check(GetSortedTriangles(Indices) == Triangles, "overdraw: the same triangles with the same windings");
+
+		// Clusters restart from a cold cache, the threshold bounds each cluster against its hard cluster
+		Check(OverdrawStats.ACMR <= CacheStats.ACMR * Threshold * 1.1f, "overdraw: the ACMR stays near the threshold");
+
+		// Vertices in first use order, every triangle keeps its positions and the unused vertex is dropped
+		std::vector<TVertex> FetchVertices = Vertices;
+		FetchVertices.push_back(TVertex(9.0f, 9.0f, 9.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f));
+		std::vector<uint32_t> FetchIndices = Indices;
+		OptimizeVertexFetch(FetchVertices, FetchIndices);
+
+		bool bSamePositions = true;
+		uint32_t NextNewVertex = 0;
+		bool bFirstUseOrder = true;
+		for (size_t i = 0; i < Indices.size(); i++)
+		{
+			const TVector3& Before = Vertices[Indices[i]].Position;
+			const TVector3& After = FetchVertices[FetchIndices[i]].Position;
+			bSamePositions &= Before.x == After.x && Before.y == After.y && Before.z == After.z;
+
+			bFirstUseOrder &= FetchIndices[i] <= NextNewVertex;
+			NextNewVertex = std::max<uint32_t>(NextNewVertex, FetchIndices[i] + 1);
+		}
+
+		Check(bSamePositions, "fetch: every index still points at the same vertex");
+		Check(bFirstUseOrder, "fetch: vertices are stored in first use order");
+		Check(FetchVertices.size() == Vertices.size(), "fetch: the unused vertex is dropped");
+		Check(AnalyzeVertexCache(FetchIndices, (uint32_t)FetchVertices.size()).CacheMisses == OverdrawStats.CacheMisses,
+			"fetch: renumbering leaves the cache misses unchanged");
+	}
+}
+
+int main()
+{
+	TestAnalyze();
+	TestVertexCache();
+	TestOverdrawAndFetch();
+
+	printf("%s\n", FailureCount == 0 ? "All mesh optimizer checks passed" : "Mesh optimizer checks FAILED");
+
+	return FailureCount;
+}
@@ -17,24 +17,28 @@ void TMeshRepository::Load()
 	TMesh BoxMesh;
 	BoxMesh.CreateBox(1.0f, 1.0f, 1.0f, 3);
 	BoxMesh.MeshName = "BoxMesh";
+	BoxMesh.OptimizeVertexOrder();
 	BoxMesh.GenerateBoundingBox();
 	MeshMap.emplace("BoxMesh", std::move(BoxMesh));
 
 	TMesh SphereMesh;
 	SphereMesh.CreateSphere(0.5f, 20, 20);
 	SphereMesh.MeshName = "SphereMesh";
+	SphereMesh.OptimizeVertexOrder();
 	SphereMesh.GenerateBoundingBox();
 	MeshMap.emplace("SphereMesh", std::move(SphereMesh));
 
 	TMesh CylinderMesh;
 	CylinderMesh.CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20);
 	CylinderMesh.MeshName = "CylinderMesh";
+	CylinderMesh.OptimizeVertexOrder();
 	CylinderMesh.GenerateBoundingBox();
 	MeshMap.emplace("CylinderMesh", std::move(CylinderMesh));
 
 	TMesh GridMesh;
 	GridMesh.CreateGrid(20.0f, 30.0f, 60, 40);
 	GridMesh.MeshName = "GridMesh";
+	GridMesh.OptimizeVertexOrder();
 	GridMesh.GenerateBoundingBox();
 	MeshMap.emplace("GridMesh", std::move(GridMesh));
 
@@ -50,29 +54,13 @@ void TMeshRepository::Load()
 	ScreenQuadMesh.GenerateBoundingBox();
 	MeshMap.emplace("ScreenQuadMesh", std::move(ScreenQuadMesh));
 
-	TMesh AssaultRifleMesh;
-	AssaultRifleMesh.MeshName = "AssaultRifle";
-	FbxLoader->LoadFBXMesh(L"LOW_WEPON.fbx", AssaultRifleMesh);
-	AssaultRifleMesh.GenerateBoundingBox();
-	MeshMap.emplace("AssaultRifle", std::move(AssaultRifleMesh));
-
-	TMesh CyborgWeaponMesh;
-	CyborgWeaponMesh.MeshName = "CyborgWeapon";
-	FbxLoader->LoadFBXMesh(L"Cyborg_Weapon.fbx", CyborgWeaponMesh);
-	CyborgWeaponMesh.GenerateBoundingBox();
-	MeshMap.emplace("CyborgWeapon", std::move(CyborgWeaponMesh));
-
-	TMesh HelmetMesh;
-	HelmetMesh.MeshName = "Helmet";
-	FbxLoader->LoadFBXMesh(L"helmet_low.fbx", HelmetMesh);
-	HelmetMesh.GenerateBoundingBox();
-	MeshMap.emplace("Helmet", std::move(HelmetMesh));
-
-	TMesh ColumnMesh;
-	ColumnMesh.MeshName = "Column";
-	FbxLoader->LoadFBXMesh(L"column.fbx", ColumnMesh);
-	ColumnMesh.GenerateBoundingBox();
-	MeshMap.emplace("Column", std::move(ColumnMesh));
+	for (const TFbxMeshAsset& Asset : GetFbxMeshAssets())
+	{
+		TMesh Mesh;
+		Mesh.MeshName = Asset.MeshName;
+		FbxLoader->LoadFBXMesh(Asset.FileName, Mesh);
+		MeshMap.emplace(Asset.MeshName, std::move(Mesh));
+	}
 }
 
 void TMeshRepository::Unload()
@@ -2,8 +2,10 @@
 
 #include <unordered_map>
 #include <string>
+#include <vector>
 #include "Mesh.h"
 #include "FbxLoader.h"
+#include "MeshAssets.h"
 
 class TMeshRepository
 {
@@ -0,0 +1,300 @@
+#include "MeshSDFBuilder.h"
+#include "KdTree.h"
+#include "MeshSDFLayout.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/Hash.h"
+#include "Utils/LZCompress.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	void GenerateUniformSphereSamples(uint32_t SampleCount, std::vector<TVector3>& Samples)
+	{
+		// Generate Fibonacci lattice.
+		// Ref: https://stackoverflow.com/questions/9600801/evenly-distributing-n-points-on-a-sphere/26127012#26127012
+
+		const float Phi = TMath::Pi * (3.0f - sqrt(5.0f)); // Golden angle in radians
+		for (uint32_t i = 0; i < SampleCount; i++)
+		{
+			TVector3 Sample;
+			Sample.y = 1 - (i / float(SampleCount - 1)) * 2;  // y goes from 1 to - 1
+			float Radius = sqrt(1.0f - Sample.y * Sample.y);  // Radius at y
+
+			float Theta = Phi * i;    // Golden angle increment
+			Sample.x = Radius * cos(Theta);
+			Sample.z = Radius * sin(Theta);
+
+			Samples.push_back(Sample);
+		}
+	}
+}
+
+bool TMeshSDFBakeKey::operator==(const TMeshSDFBakeKey& Other) const
+{
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		if (Center[Axis] != Other.Center[Axis] || Extent[Axis] != Other.Extent[Axis] || Resolution[Axis] != Other.Resolution[Axis])
+		{
+			return false;
+		}
+	}
+
+	return SourceHash == Other.SourceHash && SampleCount == Other.SampleCount;
+}
+
+TMeshSDFBakeKey GetMeshSDFBakeKey(const TMesh& Mesh)
+{
+	// Only positions and triangles reach the bake, normals or UVs changing keep the cache valid
+	std::vector<float> Positions;
+	Positions.reserve(Mesh.Vertices.size() * 3);
+	for (const TVertex& Vertex : Mesh.Vertices)
+	{
+		Positions.push_back(Vertex.Position.x);
+		Positions.push_back(Vertex.Position.y);
+		Positions.push_back(Vertex.Position.z);
+	}
+
+	TMeshSDFBakeKey Key;
+	Key.SourceHash = THash::HashBytes(Positions.data(), Positions.size() * sizeof(float));
+	Key.SourceHash = THash::Combine(Key.SourceHash, THash::HashBytes(Mesh.Indices32.data(), Mesh.Indices32.size() * sizeof(uint32_t)));
+	Key.Center[0] = Mesh.SDFDescriptor.Center.x;
+	Key.Center[1] = Mesh.SDFDescriptor.Center.y;
+	Key.Center[2] = Mesh.SDFDescriptor.Center.z;
+	Key.Extent[0] = Mesh.SDFDescriptor.Extent.x;
+	Key.Extent[1] = Mesh.SDFDescriptor.Extent.y;
+	Key.Extent[2] = Mesh.SDFDescriptor.Extent.z;
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		Key.Resolution[Axis] = Mesh.SDFDescriptor.Resolution[Axis];
+	}
+	Key.SampleCount = MeshSDFSampleCount;
+
+	return Key;
+}
+
+void BuildMeshSDF(const TMesh& Mesh, std::vector<uint8_t>& OutMeshSDF, TThreadPool& ThreadPool)
+{
+	const std::vector<uint32_t>& Indices = Mesh.Indices32;
+	const std::vector<TVertex>& Vertices = Mesh.Vertices;
+	uint32_t IndiceCount = (uint32_t)Indices.size();
+	uint32_t TriangleCount = IndiceCount / 3;
+
+	// Get all triangles
+	std::vector<std::shared_ptr<TPrimitive>> BuildTriangles;
+	for (uint32_t i = 0; i < TriangleCount; i++)
+	{
+		// Indices for this triangle.
+		uint32_t i0 = Indices[i * 3 + 0];
+		uint32_t i1 = Indices[i * 3 + 1];
+		uint32_t i2 = Indices[i * 3 + 2];
+
+		// Vertices for this triangle.
+		TVector3 v0 = Vertices[i0].Position;
+		TVector3 v1 = Vertices[i1].Position;
+		TVector3 v2 = Vertices[i2].Position;
+
+		auto Triangle = std::make_shared<TTriangle>(v0, v1, v2, TColor::Black);
+		Triangle->GenerateBoundingBox();
+
+		BuildTriangles.push_back(Triangle);
+	}
+
+	// Bulid kd-tree
+	auto KdTree = std::make_unique<TKdTreeAccelerator>(std::move(BuildTriangles));
+
+	// Build SDF, the volume is placed by TMesh::GenerateBoundingBox
+	const TMeshSDFDescriptor& Descriptor = Mesh.SDFDescriptor;
+	const int ResolutionX = Descriptor.Resolution[0];
+	const int ResolutionY = Descriptor.Resolution[1];
+	const int ResolutionZ = Descriptor.Resolution[2];
+	const float SDFUnit = Descriptor.VoxelSize;
+	const TVector3 SDFMin = Descriptor.Center - Descriptor.Extent;
+	const int SampleCount = (int)MeshSDFSampleCount;
+
+	// Quantized distances span a fixed band of voxels around the surface
+	const float DistanceRange = MeshSDFDistanceBandVoxels * SDFUnit;
+
+	std::vector<TVector3> SampleDirections;
+	GenerateUniformSphereSamples(SampleCount, SampleDirections);
+
+	std::vector<float> SDF;
+	SDF.resize((size_t)ResolutionX * ResolutionY * ResolutionZ);
+
+	ThreadPool.ParallelFor((uint32_t)ResolutionZ, [&](uint32_t Slice)
+	{
+		const int z = (int)Slice;
+
+		for (int y = 0; y < ResolutionY; y++)
+		{
+			for (int x = 0; x < ResolutionX; x++)
+			{
+				TVector3 RayOrigin(
+					((float)x + 0.5f) * SDFUnit + SDFMin.x,
+					((float)y + 0.5f) * SDFUnit + SDFMin.y,
+					((float)z + 0.5f) * SDFUnit + SDFMin.z
+				);
+
+				float MinDistance = TMath::Infinity;
+				int FrontCount = 0;
+				int BackCount = 0;
+
+				// Fibonacci lattices.
+				for (int i = 0; i < SampleCount; i++)
+				{
+					TVector3 RayDirection = SampleDirections[i];
+
+					// Ray-Triangle Intersection test with kd-tree
+					float Dist;
+					bool bBackFace;
+					if (KdTree->Intersect(TRay(RayOrigin, RayDirection), Dist, bBackFace))
+					{
+						if (Dist < MinDistance)
+						{
+							MinDistance = Dist;
+						}
+
+						if (bBackFace)
+						{
+							BackCount++;
+						}
+						else
+						{
+							FrontCount++;
+						}
+					}
+				}
+
+				size_t SDFIndex = ((size_t)z * ResolutionY + y) * ResolutionX + x;
+				SDF[SDFIndex] = MinDistance;
+				if (BackCount > FrontCount)
+				{
+					SDF[SDFIndex] *= -1.0f;
+				}
+			}
+		}
+	});
+
+	// Convert to EightBitFixedPoint(uint8)
+	std::vector<uint8_t> QuantizedSDF;
+	QuantizedSDF.resize(SDF.size());
+	for (size_t Index = 0; Index < SDF.size(); Index++)
+	{
+		if (SDF[Index] == TMath::Infinity)
+		{
+			QuantizedSDF[Index] = 255;
+		}
+		else
+		{
+			// Convert to range [-1, 1]
+			float Value = SDF[Index] / DistanceRange;
+
+			// Convert to range [0, 1]
+			Value = Value * 0.5f + 0.5f;
+
+			// Covert to range [0, 255], based on D3D format conversion rules for DXGI_FORMAT_R8_UNORM
+			int QuantizedValue = int(Value * 255.0f + .5f);
+			QuantizedSDF[Index] = (uint8_t)std::clamp(QuantizedValue, 0, 255);
+		}
+	}
+
+	std::swap(QuantizedSDF, OutMeshSDF);
+}
+
+bool SaveMeshSDF(const std::wstring& FilePath, const TMeshSDFBakeKey& Key, const std::vector<uint8_t>& MeshSDF, EMeshSDFCompression Compression)
+{
+	std::vector<uint8_t> Compressed;
+	if (Compression == EMeshSDFCompression::LZ)
+	{
+		TLZCompress::Compress(MeshSDF.data(), MeshSDF.size(), Compressed);
+
+		if (Compressed.size() >= MeshSDF.size())
+		{
+			Compression = EMeshSDFCompression::None;
+		}
+	}
+
+	const std::vector<uint8_t>& Payload = (Compression == EMeshSDFCompression::LZ) ? Compressed : MeshSDF;
+
+	TMeshSDFFileHeader Header;
+	Header.Key = Key;
+	Header.Compression = Compression;
+	Header.PayloadSize = (uint32_t)Payload.size();
+	Header.PayloadHash = THash::HashBytes(MeshSDF.data(), MeshSDF.size());
+
+	std::error_code Error;
+	std::filesystem::create_directories(std::filesystem::path(FilePath).parent_path(), Error);
+
+	std::ofstream File(std::filesystem::path(FilePath), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	File.write((const char*)&Header, sizeof(Header));
+	File.write((const char*)Payload.data(), Payload.size());
+
+	return File.good();
+}
+
+bool LoadMeshSDF(const std::wstring& FilePath, const TMeshSDFBakeKey& Key, std::vector<uint8_t>& OutMeshSDF)
+{
+	std::ifstream File(std::filesystem::path(FilePath), std::ios::in | std::ios::binary);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	TMeshSDFFileHeader Header;
+	File.read((char*)&Header, sizeof(Header));
+
+	if (!File.good() || Header.Magic != MeshSDFMagic || Header.Version != MeshSDFVersion || !(Header.Key == Key))
+	{
+		return false;
+	}
+
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		if (Key.Resolution[Axis] <= 0 || Key.Resolution[Axis] > 1024)
+		{
+			return false;
+		}
+	}
+
+	const size_t SDFDataCount = (size_t)Key.Resolution[0] * Key.Resolution[1] * Key.Resolution[2];
+
+	std::vector<uint8_t> Payload(Header.PayloadSize);
+	File.read((char*)Payload.data(), Payload.size());
+
+	if (!File.good())
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> MeshSDF;
+	if (Header.Compression == EMeshSDFCompression::LZ)
+	{
+		if (!TLZCompress::Decompress(Payload.data(), Payload.size(), SDFDataCount, MeshSDF))
+		{
+			return false;
+		}
+	}
+	else if (Header.Compression == EMeshSDFCompression::None && Payload.size() == SDFDataCount)
+	{
+		std::swap(MeshSDF, Payload);
+	}
+	else
+	{
+		return false;
+	}
+
+	if (THash::HashBytes(MeshSDF.data(), MeshSDF.size()) != Header.PayloadHash)
+	{
+		return false;
+	}
+
+	std::swap(MeshSDF, OutMeshSDF);
+
+	return true;
+}
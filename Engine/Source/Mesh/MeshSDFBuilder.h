@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Mesh.h"
+
+class TThreadPool;
+
+// 'TSDF'
+const uint32_t MeshSDFMagic = 0x46445354;
+
+// Bump when the bake or the file layout changes, cached SDFs are then rebaked
+const uint32_t MeshSDFVersion = 4;
+
+// Rays cast per voxel
+const uint32_t MeshSDFSampleCount = 256;
+
+enum class EMeshSDFCompression : uint32_t
+{
+	None,
+	LZ,
+};
+
+// Everything the bake depends on, a cached SDF is only used when the whole key matches
+struct TMeshSDFBakeKey
+{
+	// Vertex positions and indices
+	uint64_t SourceHash = 0;
+
+	float Center[3] = { 0.0f, 0.0f, 0.0f };
+
+	float Extent[3] = { 0.0f, 0.0f, 0.0f };
+
+	int32_t Resolution[3] = { 0, 0, 0 };
+
+	uint32_t SampleCount = MeshSDFSampleCount;
+
+	bool operator==(const TMeshSDFBakeKey& Other) const;
+};
+
+// Fixed size header at offset 0, followed by PayloadSize bytes of voxels
+struct TMeshSDFFileHeader
+{
+	uint32_t Magic = MeshSDFMagic;
+
+	uint32_t Version = MeshSDFVersion;
+
+	TMeshSDFBakeKey Key;
+
+	EMeshSDFCompression Compression = EMeshSDFCompression::None;
+
+	uint32_t PayloadSize = 0;
+
+	// Hash of the Resolution x * y * z bytes once decompressed
+	uint64_t PayloadHash = 0;
+};
+
+// Bake key of Mesh.SDFDescriptor and the mesh geometry
+TMeshSDFBakeKey GetMeshSDFBakeKey(const TMesh& Mesh);
+
+// Bake the R8 distance field of Mesh inside Mesh.SDFDescriptor, slices are split across the thread pool
+void BuildMeshSDF(const TMesh& Mesh, std::vector<uint8_t>& OutMeshSDF, TThreadPool& ThreadPool);
+
+// Save/MeshSDF file: header with the bake key followed by the voxels, LZ compressed unless that doesn't shrink them
+bool SaveMeshSDF(const std::wstring& FilePath, const TMeshSDFBakeKey& Key, const std::vector<uint8_t>& MeshSDF,
+	EMeshSDFCompression Compression = EMeshSDFCompression::LZ);
+
+// False when the file is missing, corrupt, of another version or baked for another key
+bool LoadMeshSDF(const std::wstring& FilePath, const TMeshSDFBakeKey& Key, std::vector<uint8_t>& OutMeshSDF);
@@ -0,0 +1,78 @@
+#include "MeshSDFLayout.h"
+#include "SDFBrickAtlas.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	int RoundUpToBricks(int Resolution)
+	{
+		return (Resolution + SDFBrickSize - 1) / SDFBrickSize * SDFBrickSize;
+	}
+
+	void ComputeResolution(const float Size[3], float VoxelSize, const TMeshSDFResolutionSettings& Settings, int OutResolution[3])
+	{
+		const int MinResolution = RoundUpToBricks(std::max<int>(Settings.MinResolution, 1));
+
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			int Voxels = (int)std::ceil(Size[Axis] / VoxelSize) + 2 * Settings.PaddingVoxels;
+			OutResolution[Axis] = std::max<int>(RoundUpToBricks(Voxels), MinResolution);
+		}
+
+		if (!Settings.bAnisotropic)
+		{
+			int MaxResolution = std::max<int>(std::max<int>(OutResolution[0], OutResolution[1]), OutResolution[2]);
+			OutResolution[0] = OutResolution[1] = OutResolution[2] = MaxResolution;
+		}
+	}
+}
+
+std::string TMeshSDFLayout::ToString() const
+{
+	char Buffer[256];
+	snprintf(Buffer, sizeof(Buffer), "%dx%dx%d voxels of %.4f (%.1f per unit), %.1f KB dense",
+		Resolution[0], Resolution[1], Resolution[2], VoxelSize, GetVoxelDensity(), GetVoxelCount() / 1024.0);
+
+	return Buffer;
+}
+
+TMeshSDFLayout ComputeMeshSDFLayout(const float BoundsMin[3], const float BoundsMax[3], const TMeshSDFResolutionSettings& Settings)
+{
+	float Size[3];
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		Size[Axis] = std::max<float>(BoundsMax[Axis] - BoundsMin[Axis], 0.0f);
+	}
+
+	float VoxelSize = std::max<float>(Settings.TargetVoxelSize, 1e-6f);
+
+	int Resolution[3];
+	for (int Iteration = 0; Iteration < 64; Iteration++)
+	{
+		ComputeResolution(Size, VoxelSize, Settings, Resolution);
+
+		const int LargestResolution = std::max<int>(std::max<int>(Resolution[0], Resolution[1]), Resolution[2]);
+		const int64_t VoxelCount = (int64_t)Resolution[0] * Resolution[1] * Resolution[2];
+		if (LargestResolution <= Settings.MaxResolution && VoxelCount <= Settings.MaxVoxelCount)
+		{
+			break;
+		}
+
+		// Grow by what the worst limit asks for, at least a little so rounding to bricks can't stall it
+		float Scale = std::max<float>((float)LargestResolution / Settings.MaxResolution, std::cbrt((float)VoxelCount / Settings.MaxVoxelCount));
+		VoxelSize *= std::max<float>(Scale, 1.05f);
+	}
+
+	TMeshSDFLayout Layout;
+	Layout.VoxelSize = VoxelSize;
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		Layout.Center[Axis] = (BoundsMin[Axis] + BoundsMax[Axis]) * 0.5f;
+		Layout.Resolution[Axis] = Resolution[Axis];
+		Layout.Extent[Axis] = Resolution[Axis] * VoxelSize * 0.5f;
+	}
+
+	return Layout;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// How the SDF volume of a mesh is sized. Voxels are cubes of one size per mesh, the volume is
+// sized per axis around the bounds so elongated meshes don't pay for a cube around their longest side.
+struct TMeshSDFResolutionSettings
+{
+	// Voxel edge the bake aims for, in mesh units. Instance scales are unknown when baking.
+	float TargetVoxelSize = 0.05f;
+
+	// Empty space around the bounds on every side
+	int PaddingVoxels = 4;
+
+	// Per axis limits, resolutions are rounded up to whole SDF bricks
+	int MinResolution = 16;
+
+	int MaxResolution = 128;
+
+	// Dense voxels of one mesh, the voxel size grows until the volume fits
+	int64_t MaxVoxelCount = 64 * 64 * 64;
+
+	// Off: the largest resolution on every axis, a cube as before
+	bool bAnisotropic = true;
+};
+
+struct TMeshSDFLayout
+{
+	float Center[3] = {};
+
+	// Half size of the volume per axis, Resolution * VoxelSize / 2
+	float Extent[3] = {};
+
+	int Resolution[3] = {};
+
+	float VoxelSize = 0.0f;
+
+	int64_t GetVoxelCount() const { return (int64_t)Resolution[0] * Resolution[1] * Resolution[2]; }
+
+	// Voxels per mesh unit
+	float GetVoxelDensity() const { return VoxelSize > 0.0f ? 1.0f / VoxelSize : 0.0f; }
+
+	std::string ToString() const;
+};
+
+// Place the SDF volume around the bounds at the target voxel size, coarsened until it fits the budget
+TMeshSDFLayout ComputeMeshSDFLayout(const float BoundsMin[3], const float BoundsMax[3],
+	const TMeshSDFResolutionSettings& Settings = TMeshSDFResolutionSettings());
+
+// The R8 volume maps distances in [-Band, Band] voxels to [0, 255], farther ones are clamped to the band.
+// A step is 1/16 voxel whatever the volume size. Match MESH_SDF_DISTANCE_BAND_VOXELS in SDFShared.hlsl.
+const int MeshSDFDistanceBandVoxels = 8;
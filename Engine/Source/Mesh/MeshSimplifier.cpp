@@ -0,0 +1,409 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+	struct TQuadric
+	{
+		double A2 = 0.0, AB = 0.0, AC = 0.0, AD = 0.0;
+		double B2 = 0.0, BC = 0.0, BD = 0.0;
+		double C2 = 0.0, CD = 0.0;
+		double D2 = 0.0;
+		double Weight = 0.0;
+
+		void AddPlane(double A, double B, double C, double D, double W)
+		{
+			A2 += W * A * A; AB += W * A * B; AC += W * A * C; AD += W * A * D;
+			B2 += W * B * B; BC += W * B * C; BD += W * B * D;
+			C2 += W * C * C; CD += W * C * D;
+			D2 += W * D * D;
+			Weight += W;
+		}
+
+		void Add(const TQuadric& Other)
+		{
+			A2 += Other.A2; AB += Other.AB; AC += Other.AC; AD += Other.AD;
+			B2 += Other.B2; BC += Other.BC; BD += Other.BD;
+			C2 += Other.C2; CD += Other.CD;
+			D2 += Other.D2;
+			Weight += Other.Weight;
+		}
+
+		// Weighted mean squared distance to the accumulated planes
+		double Evaluate(const TVector3& P) const
+		{
+			const double X = P.x, Y = P.y, Z = P.z;
+			double Result = A2 * X * X + 2.0 * AB * X * Y + 2.0 * AC * X * Z + 2.0 * AD * X
+				+ B2 * Y * Y + 2.0 * BC * Y * Z + 2.0 * BD * Y
+				+ C2 * Z * Z + 2.0 * CD * Z
+				+ D2;
+
+			return Weight > 0.0 ? std::max<double>(Result, 0.0) / Weight : 0.0;
+		}
+	};
+
+	struct TCollapse
+	{
+		uint32_t From;
+		uint32_t To;
+		double Cost;
+
+		bool operator<(const TCollapse& Other) const
+		{
+			if (Cost != Other.Cost)
+			{
+				return Cost < Other.Cost;
+			}
+
+			return From != Other.From ? From < Other.From : To < Other.To;
+		}
+	};
+
+	struct TPositionKey
+	{
+		uint32_t Bits[3];
+
+		bool operator==(const TPositionKey& Other) const
+		{
+			return Bits[0] == Other.Bits[0] && Bits[1] == Other.Bits[1] && Bits[2] == Other.Bits[2];
+		}
+	};
+
+	struct TPositionKeyHash
+	{
+		size_t operator()(const TPositionKey& Key) const
+		{
+			uint64_t Hash = 14695981039346656037ull;
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				Hash ^= Key.Bits[i];
+				Hash *= 1099511628211ull;
+			}
+
+			return (size_t)Hash;
+		}
+	};
+
+	uint64_t MakeEdgeKey(uint32_t A, uint32_t B)
+	{
+		return A < B ? ((uint64_t)A << 32 | B) : ((uint64_t)B << 32 | A);
+	}
+
+	void TriangleNormal(const TVector3& P0, const TVector3& P1, const TVector3& P2, double OutNormal[3])
+	{
+		const double E1[3] = { (double)P1.x - P0.x, (double)P1.y - P0.y, (double)P1.z - P0.z };
+		const double E2[3] = { (double)P2.x - P0.x, (double)P2.y - P0.y, (double)P2.z - P0.z };
+
+		OutNormal[0] = E1[1] * E2[2] - E1[2] * E2[1];
+		OutNormal[1] = E1[2] * E2[0] - E1[0] * E2[2];
+		OutNormal[2] = E1[0] * E2[1] - E1[1] * E2[0];
+	}
+}
+
+TSimplifyResult SimplifyMesh(const std::vector<TVertex>& Vertices, const std::vector<uint32_t>& Indices,
+	uint32_t TargetIndexCount, float TargetError, std::vector<uint32_t>& OutIndices)
+{
+	const uint32_t VertexCount = (uint32_t)Vertices.size();
+
+	OutIndices.assign(Indices.begin(), Indices.end() - Indices.size() % 3);
+
+	TSimplifyResult Result;
+	Result.TriangleCount = (uint32_t)OutIndices.size() / 3;
+
+	if (VertexCount == 0 || OutIndices.size() <= TargetIndexCount)
+	{
+		return Result;
+	}
+
+	// Vertices at one position form a group, a group with several vertices lies on an attribute seam
+	std::vector<uint32_t> Group(VertexCount);
+	std::vector<uint32_t> GroupSize(VertexCount, 0);
+	{
+		std::unordered_map<TPositionKey, uint32_t, TPositionKeyHash> PositionMap;
+		PositionMap.reserve(VertexCount);
+
+		for (uint32_t v = 0; v < VertexCount; v++)
+		{
+			TPositionKey Key;
+			std::memcpy(Key.Bits, &Vertices[v].Position, sizeof(Key.Bits));
+
+			Group[v] = PositionMap.emplace(Key, v).first->second;
+			GroupSize[Group[v]]++;
+		}
+	}
+
+	// Lock groups on open borders and non-manifold edges
+	std::vector<uint8_t> Locked(VertexCount, 0);
+	{
+		std::unordered_map<uint64_t, uint32_t> EdgeTriangleCount;
+		EdgeTriangleCount.reserve(OutIndices.size());
+
+		for (size_t i = 0; i < OutIndices.size(); i += 3)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				uint32_t GA = Group[OutIndices[i + e]];
+				uint32_t GB = Group[OutIndices[i + (e + 1) % 3]];
+				if (GA != GB)
+				{
+					EdgeTriangleCount[MakeEdgeKey(GA, GB)]++;
+				}
+			}
+		}
+
+		for (const auto& Pair : EdgeTriangleCount)
+		{
+			if (Pair.second != 2)
+			{
+				Locked[(uint32_t)(Pair.first >> 32)] = 1;
+				Locked[(uint32_t)(Pair.first & 0xFFFFFFFF)] = 1;
+			}
+		}
+	}
+
+	// Area weighted plane quadrics per group
+	std::vector<TQuadric> Quadrics(VertexCount);
+	for (size_t i = 0; i < OutIndices.size(); i += 3)
+	{
+		const TVector3& P0 = Vertices[OutIndices[i + 0]].Position;
+		const TVector3& P1 = Vertices[OutIndices[i + 1]].Position;
+		const TVector3& P2 = Vertices[OutIndices[i + 2]].Position;
+
+		double N[3];
+		TriangleNormal(P0, P1, P2, N);
+
+		double Length = std::sqrt(N[0] * N[0] + N[1] * N[1] + N[2] * N[2]);
+		if (Length <= 0.0)
+		{
+			continue;
+		}
+
+		N[0] /= Length;
+		N[1] /= Length;
+		N[2] /= Length;
+
+		double D = -(N[0] * P0.x + N[1] * P0.y + N[2] * P0.z);
+		double Area = Length * 0.5;
+
+		TQuadric Quadric;
+		Quadric.AddPlane(N[0], N[1], N[2], D, Area);
+
+		Quadrics[Group[OutIndices[i + 0]]].Add(Quadric);
+		Quadrics[Group[OutIndices[i + 1]]].Add(Quadric);
+		Quadrics[Group[OutIndices[i + 2]]].Add(Quadric);
+	}
+
+	const double MaxCost = (double)TargetError * TargetError;
+	double MaxAcceptedCost = 0.0;
+
+	std::vector<TCollapse> Collapses;
+	std::vector<uint32_t> Remap(VertexCount);
+	std::vector<uint8_t> Marked(VertexCount);
+	std::vector<uint32_t> TriangleOffsets(VertexCount + 1);
+	std::vector<uint32_t> VertexTriangles;
+
+	while (OutIndices.size() > TargetIndexCount)
+	{
+		const uint32_t TriangleCount = (uint32_t)OutIndices.size() / 3;
+
+		// Vertex to triangle adjacency
+		std::fill(TriangleOffsets.begin(), TriangleOffsets.end(), 0);
+		for (uint32_t Index : OutIndices)
+		{
+			TriangleOffsets[Index + 1]++;
+		}
+		for (uint32_t v = 0; v < VertexCount; v++)
+		{
+			TriangleOffsets[v + 1] += TriangleOffsets[v];
+		}
+
+		VertexTriangles.resize(OutIndices.size());
+		{
+			std::vector<uint32_t> Cursor(TriangleOffsets.begin(), TriangleOffsets.end() - 1);
+			for (uint32_t t = 0; t < TriangleCount; t++)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					VertexTriangles[Cursor[OutIndices[t * 3 + k]]++] = t;
+				}
+			}
+		}
+
+		// Half edge collapses of free, seam-less vertices onto a neighbour
+		Collapses.clear();
+		for (uint32_t t = 0; t < TriangleCount; t++)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				uint32_t From = OutIndices[t * 3 + e];
+				uint32_t To = OutIndices[t * 3 + (e + 1) % 3];
+
+				for (int Direction = 0; Direction < 2; Direction++)
+				{
+					uint32_t GF = Group[From];
+					uint32_t GT = Group[To];
+
+					if (GF != GT && !Locked[GF] && GroupSize[GF] == 1)
+					{
+						TQuadric Quadric = Quadrics[GF];
+						Quadric.Add(Quadrics[GT]);
+
+						Collapses.push_back({ From, To, Quadric.Evaluate(Vertices[To].Position) });
+					}
+
+					std::swap(From, To);
+				}
+			}
+		}
+
+		std::sort(Collapses.begin(), Collapses.end());
+		Collapses.erase(std::unique(Collapses.begin(), Collapses.end(), [](const TCollapse& A, const TCollapse& B)
+		{
+			return A.From == B.From && A.To == B.To;
+		}), Collapses.end());
+
+		for (uint32_t v = 0; v < VertexCount; v++)
+		{
+			Remap[v] = v;
+		}
+		std::fill(Marked.begin(), Marked.end(), 0);
+
+		uint32_t RemovedTriangles = 0;
+		uint32_t AcceptedCollapses = 0;
+		const uint32_t TrianglesToRemove = TriangleCount - TargetIndexCount / 3;
+
+		for (const TCollapse& Collapse : Collapses)
+		{
+			if (Collapse.Cost > MaxCost || RemovedTriangles >= TrianglesToRemove)
+			{
+				break;
+			}
+
+			const uint32_t GF = Group[Collapse.From];
+			const uint32_t GT = Group[Collapse.To];
+
+			if (Marked[GF] || Marked[GT])
+			{
+				continue;
+			}
+
+			bool bValid = true;
+			uint32_t Degenerated = 0;
+
+			for (uint32_t i = TriangleOffsets[Collapse.From]; i < TriangleOffsets[Collapse.From + 1] && bValid; i++)
+			{
+				const uint32_t* Triangle = &OutIndices[VertexTriangles[i] * 3];
+
+				bool bTouchesTarget = false;
+				for (int k = 0; k < 3; k++)
+				{
+					if (Group[Triangle[k]] == GT)
+					{
+						bTouchesTarget = true;
+
+						// The target vertex must carry the attributes of this side of a seam
+						bValid = Triangle[k] == Collapse.To;
+					}
+
+					// Neighbours must stay put while their one-ring changes
+					if (Triangle[k] != Collapse.From && Marked[Group[Triangle[k]]])
+					{
+						bValid = false;
+					}
+				}
+
+				if (!bValid)
+				{
+					break;
+				}
+
+				if (bTouchesTarget)
+				{
+					Degenerated++;
+					continue;
+				}
+
+				// Reject collapses that flip a remaining triangle
+				TVector3 Positions[3];
+				double OldNormal[3];
+				double NewNormal[3];
+
+				for (int k = 0; k < 3; k++)
+				{
+					Positions[k] = Vertices[Triangle[k]].Position;
+				}
+				TriangleNormal(Positions[0], Positions[1], Positions[2], OldNormal);
+
+				for (int k = 0; k < 3; k++)
+				{
+					if (Triangle[k] == Collapse.From)
+					{
+						Positions[k] = Vertices[Collapse.To].Position;
+					}
+				}
+				TriangleNormal(Positions[0], Positions[1], Positions[2], NewNormal);
+
+				double OldLength = std::sqrt(OldNormal[0] * OldNormal[0] + OldNormal[1] * OldNormal[1] + OldNormal[2] * OldNormal[2]);
+				double NewLength = std::sqrt(NewNormal[0] * NewNormal[0] + NewNormal[1] * NewNormal[1] + NewNormal[2] * NewNormal[2]);
+				double Dot = OldNormal[0] * NewNormal[0] + OldNormal[1] * NewNormal[1] + OldNormal[2] * NewNormal[2];
+
+				bValid = Dot > 0.25 * OldLength * NewLength;
+			}
+
+			if (!bValid)
+			{
+				continue;
+			}
+
+			// Mark the one-ring so collapses within a pass stay independent
+			for (uint32_t i = TriangleOffsets[Collapse.From]; i < TriangleOffsets[Collapse.From + 1]; i++)
+			{
+				const uint32_t* Triangle = &OutIndices[VertexTriangles[i] * 3];
+				for (int k = 0; k < 3; k++)
+				{
+					Marked[Group[Triangle[k]]] = 1;
+				}
+			}
+
+			Remap[Collapse.From] = Collapse.To;
+			Quadrics[GT].Add(Quadrics[GF]);
+
+			MaxAcceptedCost = std::max<double>(MaxAcceptedCost, Collapse.Cost);
+			RemovedTriangles += Degenerated;
+			AcceptedCollapses++;
+		}
+
+		if (AcceptedCollapses == 0)
+		{
+			break;
+		}
+
+		// Apply the pass and drop triangles that lost an edge
+		size_t WriteIndex = 0;
+		for (size_t i = 0; i < OutIndices.size(); i += 3)
+		{
+			uint32_t A = Remap[OutIndices[i + 0]];
+			uint32_t B = Remap[OutIndices[i + 1]];
+			uint32_t C = Remap[OutIndices[i + 2]];
+
+			if (Group[A] == Group[B] || Group[B] == Group[C] || Group[A] == Group[C])
+			{
+				continue;
+			}
+
+			OutIndices[WriteIndex++] = A;
+			OutIndices[WriteIndex++] = B;
+			OutIndices[WriteIndex++] = C;
+		}
+
+		OutIndices.resize(WriteIndex);
+	}
+
+	Result.TriangleCount = (uint32_t)OutIndices.size() / 3;
+	Result.Error = (float)std::sqrt(MaxAcceptedCost);
+
+	return Result;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+struct TSimplifyResult
+{
+	uint32_t TriangleCount = 0;
+
+	// Largest collapse error in mesh space units (quadric distance)
+	float Error = 0.0f;
+};
+
+// Quadric error edge collapse. Vertices are never moved or added, so every LOD can share one vertex buffer.
+// Vertices on UV/normal seams, open borders and non-manifold edges are locked to keep the silhouette and seams intact.
+// Stops at TargetIndexCount or before a collapse would exceed TargetError, the result is deterministic.
+TSimplifyResult SimplifyMesh(const std::vector<TVertex>& Vertices, const std::vector<uint32_t>& Indices,
+	uint32_t TargetIndexCount, float TargetError, std::vector<uint32_t>& OutIndices);
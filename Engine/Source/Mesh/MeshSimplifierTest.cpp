@@ -0,0 +1,264 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <set>
+
+// Builds a LOD chain the way TMesh::GenerateLODs does and reports triangle count and error per level.
+// Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	// Unit UV sphere, the first and last columns share positions with different UVs and form a seam
+	void BuildSphere(uint32_t Slices, uint32_t Stacks, std::vector<TVertex>& OutVertices, std::vector<uint32_t>& OutIndices)
+	{
+		const float Pi = 3.14159265f;
+		for (uint32_t Stack = 0; Stack <= Stacks; Stack++)
+		{
+			for (uint32_t Slice = 0; Slice <= Slices; Slice++)
+			{
+				const float Theta = Pi * Stack / Stacks;
+				const float Phi = 2.0f * Pi * (Slice % Slices) / Slices;
+
+				TVertex Vertex;
+				Vertex.Position = TVector3(std::sin(Theta) * std::cos(Phi), std::cos(Theta), std::sin(Theta) * std::sin(Phi));
+				Vertex.Normal = Vertex.Position;
+				Vertex.TexC = TVector2((float)Slice / Slices, (float)Stack / Stacks);
+				OutVertices.push_back(Vertex);
+			}
+		}
+
+		// The pole rows are single points, skip their zero area triangles
+		for (uint32_t Stack = 0; Stack < Stacks; Stack++)
+		{
+			for (uint32_t Slice = 0; Slice < Slices; Slice++)
+			{
+				const uint32_t A = Stack * (Slices + 1) + Slice;
+				const uint32_t B = A + 1;
+				const uint32_t C = A + Slices + 1;
+				const uint32_t D = C + 1;
+
+				if (Stack > 0)
+				{
+					OutIndices.insert(OutIndices.end(), { A, B, C });
+				}
+				if (Stack < Stacks - 1)
+				{
+					OutIndices.insert(OutIndices.end(), { B, D, C });
+				}
+			}
+		}
+	}
+
+	// Largest distance from a triangle centroid to the unit sphere
+	float MeasureSphereDeviation(const std::vector<TVertex>& Vertices, const std::vector<uint32_t>& Indices)
+	{
+		float Deviation = 0.0f;
+		for (size_t i = 0; i < Indices.size(); i += 3)
+		{
+			const TVector3& A = Vertices[Indices[i + 0]].Position;
+			const TVector3& B = Vertices[Indices[i + 1]].Position;
+			const TVector3& C = Vertices[Indices[i + 2]].Position;
+
+			const float X = (A.x + B.x + C.x) / 3.0f;
+			const float Y = (A.y + B.y + C.y) / 3.0f;
+			const float Z = (A.z + B.z + C.z) / 3.0f;
+			Deviation = std::max<float>(Deviation, 1.0f - std::sqrt(X * X + Y * Y + Z * Z));
+		}
+
+		return Deviation;
+	}
+
+	// Every triangle still faces away from the center, so no collapse folded the surface over
+	bool IsOutwardFacing(const std::vector<TVertex>& Vertices, const std::vector<uint32_t>& Indices)
+	{
+		for (size_t i = 0; i < Indices.size(); i += 3)
+		{
+			const TVector3& A = Vertices[Indices[i + 0]].Position;
+			const TVector3& B = Vertices[Indices[i + 1]].Position;
+			const TVector3& C = Vertices[Indices[i + 2]].Position;
+
+			const float E1[3] = { B.x - A.x, B.y - A.y, B.z - A.z };
+			const float E2[3] = { C.x - A.x, C.y - A.y, C.z - A.z };
+			const float Normal[3] = { E1[1] * E2[2] - E1[2] * E2[1], E1[2] * E2[0] - E1[0] * E2[2], E1[0] * E2[1] - E1[1] * E2[0] };
+			if (Normal[0] * (A.x + B.x + C.x) + Normal[1] * (A.y + B.y + C.y) + Normal[2] * (A.z + B.z + C.z) <= 0.0f)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool IsValidIndexList(const std::vector<uint32_t>& Indices, size_t VertexCount)
+	{
+		if (Indices.size() % 3 != 0)
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < Indices.size(); i += 3)
+		{
+			const uint32_t A = Indices[i + 0];
+			const uint32_t B = Indices[i + 1];
+			const uint32_t C = Indices[i + 2];
+			if (A >= VertexCount || B >= VertexCount || C >= VertexCount || A == B || B == C || A == C)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void TestSphereChain()
+	{
+		const uint32_t Slices = 256;
+		const uint32_t Stacks = 256;
+
+		std::vector<TVertex> Vertices;
+		std::vector<uint32_t> Indices;
+		BuildSphere(Slices, Stacks, Vertices, Indices);
+
+		// Vertices of the UV seam, away from the poles
+		std::set<uint32_t> SeamVertices;
+		for (uint32_t Stack = 1; Stack < Stacks; Stack++)
+		{
+			SeamVertices.insert(Stack * (Slices + 1));
+			SeamVertices.insert(Stack * (Slices + 1) + Slices);
+		}
+
+		const float BaseDeviation = MeasureSphereDeviation(Vertices, Indices);
+		printf("Sphere LOD0: %zu triangles, deviation %g\n", Indices.size() / 3, BaseDeviation);
+
+		// Halve each level like TMesh::GenerateLODs, the error accumulates over the chain
+		std::vector<uint32_t> PrevIndices = Indices;
+		float ChainError = 0.0f;
+		for (uint32_t Level = 1; Level <= 4; Level++)
+		{
+			const uint32_t TargetIndexCount = (uint32_t)(PrevIndices.size() / 6) * 3;
+
+			const auto StartTime = std::chrono::steady_clock::now();
+			std::vector<uint32_t> LODIndices;
+			const TSimplifyResult Result = SimplifyMesh(Vertices, PrevIndices, TargetIndexCount, FLT_MAX, LODIndices);
+			const double Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
+
+			std::vector<uint32_t> RepeatIndices;
+			SimplifyMesh(Vertices, PrevIndices, TargetIndexCount, FLT_MAX, RepeatIndices);
+
+			ChainError += Result.Error;
+			const float Deviation = MeasureSphereDeviation(Vertices, LODIndices);
+
+			printf("Sphere LOD%u: %u triangles (target %u), error %g, chain error %g, deviation %g, %.1f ms\n",
+				Level, Result.TriangleCount, TargetIndexCount / 3, Result.Error, ChainError, Deviation, Milliseconds);
+
+			std::set<uint32_t> UsedVertices(LODIndices.begin(), LODIndices.end());
+			bool bSeamKept = true;
+			for (uint32_t Vertex : SeamVertices)
+			{
+				bSeamKept &= UsedVertices.count(Vertex) != 0;
+			}
+
+			Check(IsValidIndexList(LODIndices, Vertices.size()), "sphere: LODs index existing vertices and have no degenerate triangles");
+			Check(Result.TriangleCount * 3 == LODIndices.size(), "sphere: triangle count matches the index list");
+			Check(Result.TriangleCount * 3 <= PrevIndices.size() * 6 / 10, "sphere: each level removes at least 40% of the triangles");
+			Check(LODIndices == RepeatIndices, "sphere: simplification is deterministic");
+			Check(bSeamKept, "sphere: UV seam vertices are locked");
+			Check(IsOutwardFacing(Vertices, LODIndices), "sphere: no triangle is flipped");
+
+			// The quadric error bounds how far the surface moved from the previous level
+			Check(Deviation <= BaseDeviation + ChainError, "sphere: deviation from the sphere stays within the reported error");
+
+			PrevIndices = LODIndices;
+		}
+
+		Check(ChainError < 0.01f, "sphere: four levels stay within 1% of the radius");
+	}
+
+	// A planar grid has no error to pay, everything inside the locked border collapses
+	void TestPlanarGrid()
+	{
+		const uint32_t Size = 100;
+
+		std::vector<TVertex> Vertices;
+		std::vector<uint32_t> Indices;
+		for (uint32_t Y = 0; Y <= Size; Y++)
+		{
+			for (uint32_t X = 0; X <= Size; X++)
+			{
+				TVertex Vertex;
+				Vertex.Position = TVector3((float)X, 0.0f, (float)Y);
+				Vertex.Normal = TVector3(0.0f, 1.0f, 0.0f);
+				Vertices.push_back(Vertex);
+			}
+		}
+		for (uint32_t Y = 0; Y < Size; Y++)
+		{
+			for (uint32_t X = 0; X < Size; X++)
+			{
+				const uint32_t A = Y * (Size + 1) + X;
+				const uint32_t B = A + 1;
+				const uint32_t C = A + Size + 1;
+				const uint32_t D = C + 1;
+				Indices.insert(Indices.end(), { A, C, B, B, C, D });
+			}
+		}
+
+		std::vector<uint32_t> LODIndices;
+		const TSimplifyResult Result = SimplifyMesh(Vertices, Indices, 0, 1e-4f, LODIndices);
+
+		printf("Planar grid: %zu -> %u triangles, error %g\n", Indices.size() / 3, Result.TriangleCount, Result.Error);
+
+		Check(IsValidIndexList(LODIndices, Vertices.size()), "grid: valid index list");
+		Check(Result.Error <= 1e-4f, "grid: stays within the target error");
+		Check(Result.TriangleCount < Indices.size() / 3 / 10, "grid: interior collapses");
+
+		std::set<uint32_t> UsedVertices(LODIndices.begin(), LODIndices.end());
+		bool bBorderKept = true;
+		for (uint32_t i = 0; i <= Size; i++)
+		{
+			bBorderKept &= UsedVertices.count(i) && UsedVertices.count(Size * (Size + 1) + i);
+			bBorderKept &= UsedVertices.count(i * (Size + 1)) && UsedVertices.count(i * (Size + 1) + Size);
+		}
+		Check(bBorderKept, "grid: open border vertices are locked");
+	}
+
+	// A tight target error stops the sphere early instead of reaching the triangle target
+	void TestTargetError()
+	{
+		std::vector<TVertex> Vertices;
+		std::vector<uint32_t> Indices;
+		BuildSphere(64, 64, Vertices, Indices);
+
+		const float TargetError = 1e-3f;
+		std::vector<uint32_t> LODIndices;
+		const TSimplifyResult Result = SimplifyMesh(Vertices, Indices, 0, TargetError, LODIndices);
+
+		printf("Sphere to error %g: %zu -> %u triangles, error %g\n", TargetError, Indices.size() / 3, Result.TriangleCount, Result.Error);
+
+		Check(Result.Error <= TargetError, "target error: stays within the target");
+		Check(Result.TriangleCount > 0 && Result.TriangleCount * 3 < Indices.size(), "target error: reduces the mesh but stops short of empty");
+	}
+}
+
+int main()
+{
+	TestSphereChain();
+	TestPlanarGrid();
+	TestTargetError();
+
+	printf("%s\n", FailureCount == 0 ? "All mesh simplifier checks passed" : "Mesh simplifier checks FAILED");
+
+	return FailureCount;
+}
@@ -0,0 +1,237 @@
+#include "Meshlet.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	void ComputeMeshletBounds(const std::vector<TVertex>& Vertices, const std::vector<uint32_t>& Indices, TMeshlet& Meshlet)
+	{
+		const uint32_t EndIndex = Meshlet.StartIndex + Meshlet.TriangleCount * 3;
+
+		// Sphere around the AABB center
+		float Min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float Max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		for (uint32_t i = Meshlet.StartIndex; i < EndIndex; i++)
+		{
+			const TVector3& Position = Vertices[Indices[i]].Position;
+			const float P[3] = { Position.x, Position.y, Position.z };
+
+			for (int Axis = 0; Axis < 3; Axis++)
+			{
+				Min[Axis] = std::min<float>(Min[Axis], P[Axis]);
+				Max[Axis] = std::max<float>(Max[Axis], P[Axis]);
+			}
+		}
+
+		float RadiusSq = 0.0f;
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			Meshlet.Center[Axis] = (Min[Axis] + Max[Axis]) * 0.5f;
+		}
+
+		for (uint32_t i = Meshlet.StartIndex; i < EndIndex; i++)
+		{
+			const TVector3& Position = Vertices[Indices[i]].Position;
+			float DX = Position.x - Meshlet.Center[0];
+			float DY = Position.y - Meshlet.Center[1];
+			float DZ = Position.z - Meshlet.Center[2];
+
+			RadiusSq = std::max<float>(RadiusSq, DX * DX + DY * DY + DZ * DZ);
+		}
+
+		Meshlet.Radius = std::sqrt(RadiusSq);
+
+		// Face normals, cross(P1 - P0, P2 - P0) points to the front side of clockwise triangles
+		std::vector<float> Normals;
+		Normals.reserve(Meshlet.TriangleCount * 3);
+
+		float Axis[3] = { 0.0f, 0.0f, 0.0f };
+		for (uint32_t i = Meshlet.StartIndex; i < EndIndex; i += 3)
+		{
+			const TVector3& P0 = Vertices[Indices[i + 0]].Position;
+			const TVector3& P1 = Vertices[Indices[i + 1]].Position;
+			const TVector3& P2 = Vertices[Indices[i + 2]].Position;
+
+			float E1[3] = { P1.x - P0.x, P1.y - P0.y, P1.z - P0.z };
+			float E2[3] = { P2.x - P0.x, P2.y - P0.y, P2.z - P0.z };
+
+			float N[3] = { E1[1] * E2[2] - E1[2] * E2[1], E1[2] * E2[0] - E1[0] * E2[2], E1[0] * E2[1] - E1[1] * E2[0] };
+			float Length = std::sqrt(N[0] * N[0] + N[1] * N[1] + N[2] * N[2]);
+
+			// Degenerate triangles are never rasterized
+			if (Length <= 1e-20f)
+			{
+				continue;
+			}
+
+			for (int k = 0; k < 3; k++)
+			{
+				N[k] /= Length;
+				Axis[k] += N[k];
+				Normals.push_back(N[k]);
+			}
+		}
+
+		float AxisLength = std::sqrt(Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2]);
+		if (Normals.empty() || AxisLength <= 1e-6f)
+		{
+			return;
+		}
+
+		for (int k = 0; k < 3; k++)
+		{
+			Axis[k] /= AxisLength;
+		}
+
+		float MinDot = 1.0f;
+		for (size_t i = 0; i < Normals.size(); i += 3)
+		{
+			float Dot = Normals[i] * Axis[0] + Normals[i + 1] * Axis[1] + Normals[i + 2] * Axis[2];
+			MinDot = std::min<float>(MinDot, Dot);
+		}
+
+		// Normals spread over a hemisphere or more, some triangle always faces the camera
+		if (MinDot <= 0.0f)
+		{
+			return;
+		}
+
+		Meshlet.ConeAxis[0] = Axis[0];
+		Meshlet.ConeAxis[1] = Axis[1];
+		Meshlet.ConeAxis[2] = Axis[2];
+
+		// Back facing region is the normal cone widened by 90 degrees and inverted, cos(a + 90) = -sin(a)
+		Meshlet.ConeCutoff = std::sqrt(1.0f - MinDot * MinDot);
+	}
+}
+
+void BuildMeshlets(const std::vector<TVertex>& Vertices, const std::vector<uint32_t>& Indices, uint32_t StartIndex, uint32_t IndexCount,
+	std::vector<TMeshlet>& OutMeshlets, const TMeshletSettings& Settings)
+{
+	const uint32_t EndIndex = StartIndex + IndexCount - IndexCount % 3;
+
+	// Meshlet that last referenced each vertex, avoids clearing a set per meshlet
+	std::vector<uint32_t> VertexStamp(Vertices.size(), UINT32_MAX);
+	uint32_t Stamp = 0;
+
+	TMeshlet Meshlet;
+	Meshlet.StartIndex = StartIndex;
+
+	for (uint32_t i = StartIndex; i < EndIndex; i += 3)
+	{
+		const uint32_t A = Indices[i + 0];
+		const uint32_t B = Indices[i + 1];
+		const uint32_t C = Indices[i + 2];
+
+		uint32_t NewVertexCount = (VertexStamp[A] != Stamp) + (VertexStamp[B] != Stamp && B != A) + (VertexStamp[C] != Stamp && C != A && C != B);
+
+		if (Meshlet.VertexCount + NewVertexCount > Settings.MaxVertices || Meshlet.TriangleCount + 1 > Settings.MaxTriangles)
+		{
+			ComputeMeshletBounds(Vertices, Indices, Meshlet);
+			OutMeshlets.push_back(Meshlet);
+
+			Meshlet = TMeshlet();
+			Meshlet.StartIndex = i;
+			Stamp++;
+
+			NewVertexCount = 1 + (B != A) + (C != A && C != B);
+		}
+
+		VertexStamp[A] = Stamp;
+		VertexStamp[B] = Stamp;
+		VertexStamp[C] = Stamp;
+
+		Meshlet.VertexCount += NewVertexCount;
+		Meshlet.TriangleCount++;
+	}
+
+	if (Meshlet.TriangleCount > 0)
+	{
+		ComputeMeshletBounds(Vertices, Indices, Meshlet);
+		OutMeshlets.push_back(Meshlet);
+	}
+}
+
+void ExtractFrustumPlanes(const float LocalToClip[16], float OutPlanes[6][4])
+{
+	// Column j of the matrix yields clip component j
+	auto Column = [&](int j, int i) { return LocalToClip[i * 4 + j]; };
+
+	for (int i = 0; i < 4; i++)
+	{
+		OutPlanes[0][i] = Column(3, i) + Column(0, i); // Left:   x >= -w
+		OutPlanes[1][i] = Column(3, i) - Column(0, i); // Right:  x <= w
+		OutPlanes[2][i] = Column(3, i) + Column(1, i); // Bottom: y >= -w
+		OutPlanes[3][i] = Column(3, i) - Column(1, i); // Top:    y <= w
+		OutPlanes[4][i] = Column(2, i);                // Near:   z >= 0
+		OutPlanes[5][i] = Column(3, i) - Column(2, i); // Far:    z <= w
+	}
+
+	for (int Plane = 0; Plane < 6; Plane++)
+	{
+		float Length = std::sqrt(OutPlanes[Plane][0] * OutPlanes[Plane][0] + OutPlanes[Plane][1] * OutPlanes[Plane][1] + OutPlanes[Plane][2] * OutPlanes[Plane][2]);
+		if (Length > 0.0f)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				OutPlanes[Plane][i] /= Length;
+			}
+		}
+	}
+}
+
+TMeshletCullStats CullMeshlets(const std::vector<TMeshlet>& Meshlets, const TMeshletCullParams& Params, std::vector<uint32_t>& OutVisibleMeshlets)
+{
+	TMeshletCullStats Stats;
+	Stats.MeshletCount = (uint32_t)Meshlets.size();
+
+	float Planes[6][4];
+	ExtractFrustumPlanes(Params.LocalToClip, Planes);
+
+	const float* Camera = Params.LocalCameraPosition;
+
+	for (uint32_t MeshletIdx = 0; MeshletIdx < (uint32_t)Meshlets.size(); MeshletIdx++)
+	{
+		const TMeshlet& Meshlet = Meshlets[MeshletIdx];
+		const float* Center = Meshlet.Center;
+
+		Stats.TriangleCount += Meshlet.TriangleCount;
+
+		if (Params.bFrustumCulling)
+		{
+			bool bOutside = false;
+			for (int Plane = 0; Plane < 6 && !bOutside; Plane++)
+			{
+				float Distance = Planes[Plane][0] * Center[0] + Planes[Plane][1] * Center[1] + Planes[Plane][2] * Center[2] + Planes[Plane][3];
+				bOutside = Distance < -Meshlet.Radius;
+			}
+
+			if (bOutside)
+			{
+				continue;
+			}
+		}
+
+		if (Params.bConeCulling && Meshlet.ConeCutoff < 1.0f)
+		{
+			// Every triangle faces away when the camera sits inside the back facing cone around the sphere
+			float View[3] = { Center[0] - Camera[0], Center[1] - Camera[1], Center[2] - Camera[2] };
+			float ViewLength = std::sqrt(View[0] * View[0] + View[1] * View[1] + View[2] * View[2]);
+			float Dot = View[0] * Meshlet.ConeAxis[0] + View[1] * Meshlet.ConeAxis[1] + View[2] * Meshlet.ConeAxis[2];
+
+			if (Dot >= Meshlet.ConeCutoff * ViewLength + Meshlet.Radius)
+			{
+				continue;
+			}
+		}
+
+		OutVisibleMeshlets.push_back(MeshletIdx);
+
+		Stats.VisibleMeshletCount++;
+		Stats.VisibleTriangleCount += Meshlet.TriangleCount;
+	}
+
+	return Stats;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+struct TMeshletSettings
+{
+	uint32_t MaxVertices = 64;
+
+	uint32_t MaxTriangles = 124;
+};
+
+// Cluster of triangles stored as a contiguous range of the mesh index buffer
+struct TMeshlet
+{
+	uint32_t StartIndex = 0;
+
+	uint32_t TriangleCount = 0;
+
+	uint32_t VertexCount = 0;
+
+	// Set for meshes split into 16-bit chunks
+	int32_t BaseVertex = 0;
+
+	// Bounding sphere in mesh space
+	float Center[3] = { 0.0f, 0.0f, 0.0f };
+
+	float Radius = 0.0f;
+
+	// Normal cone, ConeCutoff is 1 when the cone is too wide to cull
+	float ConeAxis[3] = { 0.0f, 0.0f, 0.0f };
+
+	float ConeCutoff = 1.0f;
+};
+
+struct TMeshletCullParams
+{
+	// Mesh space to clip space, row vector convention (p * M)
+	float LocalToClip[16];
+
+	float LocalCameraPosition[3];
+
+	bool bFrustumCulling = true;
+
+	// Only valid when back faces are culled
+	bool bConeCulling = true;
+};
+
+struct TMeshletCullStats
+{
+	uint32_t MeshletCount = 0;
+
+	uint32_t VisibleMeshletCount = 0;
+
+	uint32_t TriangleCount = 0;
+
+	uint32_t VisibleTriangleCount = 0;
+};
+
+// Greedily split Indices[StartIndex, StartIndex + IndexCount) into meshlets in triangle order,
+// so a cache-optimized index buffer keeps its order and every meshlet stays a contiguous range
+void BuildMeshlets(const std::vector<TVertex>& Vertices, const std::vector<uint32_t>& Indices, uint32_t StartIndex, uint32_t IndexCount,
+	std::vector<TMeshlet>& OutMeshlets, const TMeshletSettings& Settings = TMeshletSettings());
+
+// Inward-facing planes (left, right, bottom, top, near, far) of the clip volume in mesh space
+void ExtractFrustumPlanes(const float LocalToClip[16], float OutPlanes[6][4]);
+
+// Appends the indices of meshlets that pass the frustum and backface cone tests
+TMeshletCullStats CullMeshlets(const std::vector<TMeshlet>& Meshlets, const TMeshletCullParams& Params, std::vector<uint32_t>& OutVisibleMeshlets);
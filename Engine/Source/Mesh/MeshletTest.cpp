@@ -0,0 +1,363 @@
+#include "Meshlet.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <set>
+
+// Splits spheres into meshlets and checks the vertex and triangle limits, that the meshlets cover every
+// triangle of the range exactly once, and that culling is conservative: frustum culling only drops meshlets with no
+// vertex in view and cone culling only drops meshlets whose triangles all face away, while it does drop the far side
+// of a sphere. Prints build and cull timings on a million triangles. Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	typedef std::chrono::steady_clock TClock;
+
+	double ElapsedMilliseconds(TClock::time_point StartTime)
+	{
+		return std::chrono::duration<double, std::milli>(TClock::now() - StartTime).count();
+	}
+
+	// Latitude/longitude sphere, cross(P1 - P0, P2 - P0) points outward
+	void MakeSphere(uint32_t Rings, uint32_t Segments, float Radius, std::vector<TVertex>& OutVertices, std::vector<uint32_t>& OutIndices)
+	{
+		OutVertices.clear();
+		OutIndices.clear();
+
+		for (uint32_t r = 0; r <= Rings; r++)
+		{
+			const float Theta = 3.14159265f * r / Rings;
+			for (uint32_t s = 0; s <= Segments; s++)
+			{
+				const float Phi = 6.28318531f * s / Segments;
+				const float X = std::sin(Theta) * std::cos(Phi);
+				const float Y = std::cos(Theta);
+				const float Z = std::sin(Theta) * std::sin(Phi);
+				OutVertices.push_back(TVertex(X * Radius, Y * Radius, Z * Radius, X, Y, Z, -std::sin(Phi), 0.0f, std::cos(Phi),
+					(float)s / Segments, (float)r / Rings));
+			}
+		}
+
+		for (uint32_t r = 0; r < Rings; r++)
+		{
+			for (uint32_t s = 0; s < Segments; s++)
+			{
+				const uint32_t Corner = r * (Segments + 1) + s;
+				const uint32_t QuadIndices[6] = { Corner, Corner + 1, Corner + Segments + 1, Corner + 1, Corner + Segments + 2, Corner + Segments + 1 };
+				OutIndices.insert(OutIndices.end(), QuadIndices, QuadIndices + 6);
+			}
+		}
+	}
+
+	// Perspective camera at Eye looking down +Z, D3D clip depth in [0, w], row vector convention
+	void MakeLocalToClip(const float Eye[3], float FovY, float Aspect, float Near, float Far, float OutLocalToClip[16])
+	{
+		const float YScale = 1.0f / std::tan(FovY * 0.5f);
+		const float XScale = YScale / Aspect;
+		const float ZScale = Far / (Far - Near);
+
+		const float Matrix[16] =
+		{
+			XScale, 0.0f, 0.0f, 0.0f,
+			0.0f, YScale, 0.0f, 0.0f,
+			0.0f, 0.0f, ZScale, 1.0f,
+			-Eye[0] * XScale, -Eye[1] * YScale, -Eye[2] * ZScale - Near * ZScale, -Eye[2]
+		};
+
+		std::copy(Matrix, Matrix + 16, OutLocalToClip);
+	}
+
+	bool IsInsideClip(const TVector3& Position, const float LocalToClip[16])
+	{
+		float Clip[4];
+		for (int j = 0; j < 4; j++)
+		{
+			Clip[j] = Position.x * LocalToClip[j] + Position.y * LocalToClip[4 + j] + Position.z * LocalToClip[8 + j] + LocalToClip[12 + j];
+		}
+
+		return Clip[3] > 0.0f && std::fabs(Clip[0]) <= Clip[3] && std::fabs(Clip[1]) <= Clip[3] && Clip[2] >= 0.0f && Clip[2] <= Clip[3];
+	}
+
+	// Triangles facing away from the camera, the same winding as the meshlet cones
+	bool IsBackFacing(const std::vector<TVertex>& Vertices, const uint32_t* Triangle, const float Camera[3])
+	{
+		const TVector3& P0 = Vertices[Triangle[0]].Position;
+		const TVector3& P1 = Vertices[Triangle[1]].Position;
+		const TVector3& P2 = Vertices[Triangle[2]].Position;
+
+		const float E1[3] = { P1.x - P0.x, P1.y - P0.y, P1.z - P0.z };
+		const float E2[3] = { P2.x - P0.x, P2.y - P0.y, P2.z - P0.z };
+		const float N[3] = { E1[1] * E2[2] - E1[2] * E2[1], E1[2] * E2[0] - E1[0] * E2[2], E1[0] * E2[1] - E1[1] * E2[0] };
+
+		return N[0] * (P0.x - Camera[0]) + N[1] * (P0.y - Camera[1]) + N[2] * (P0.z - Camera[2]) >= 0.0f;
+	}
+
+	// Meshlets tile the range in order without gaps and respect the limits, their vertex counts are exact
+	bool IsValidSplit(const std::vector<uint32_t>& Indices, uint32_t StartIndex, uint32_t IndexCount,
+		const std::vector<TMeshlet>& Meshlets, const TMeshletSettings& Settings)
+	{
+		uint32_t NextIndex = StartIndex;
+		for (const TMeshlet& Meshlet : Meshlets)
+		{
+			if (Meshlet.StartIndex != NextIndex || Meshlet.TriangleCount == 0 || Meshlet.TriangleCount > Settings.MaxTriangles
+				|| Meshlet.VertexCount > Settings.MaxVertices)
+			{
+				return false;
+			}
+
+			const std::set<uint32_t> UniqueVertices(Indices.begin() + Meshlet.StartIndex, Indices.begin() + Meshlet.StartIndex + Meshlet.TriangleCount * 3);
+			if (UniqueVertices.size() != Meshlet.VertexCount)
+			{
+				return false;
+			}
+
+			NextIndex += Meshlet.TriangleCount * 3;
+		}
+
+		return NextIndex == StartIndex + IndexCount;
+	}
+
+	void TestLimits()
+	{
+		std::vector<TVertex> Vertices;
+		std::vector<uint32_t> Indices;
+		MakeSphere(32, 64, 1.0f, Vertices, Indices);
+		const uint32_t IndexCount = (uint32_t)Indices.size();
+
+		const TMeshletSettings SettingsList[] = { { 64, 124 }, { 128, 256 }, { 32, 200 }, { 256, 16 }, { 3, 1 } };
+		bool bAllValid = true;
+		for (const TMeshletSettings& Settings : SettingsList)
+		{
+			std::vector<TMeshlet> Meshlets;
+			BuildMeshlets(Vertices, Indices, 0, IndexCount, Meshlets, Settings);
+			bAllValid &= IsValidSplit(Indices, 0, IndexCount, Meshlets, Settings);
+
+			uint32_t MeshletVertices = 0;
+			for (const TMeshlet& Meshlet : Meshlets)
+			{
+				MeshletVertices += Meshlet.VertexCount;
+			}
+			printf("Limits %u/%u: %zu meshlets, %.1f triangles and %.1f vertices per meshlet\n", Settings.MaxVertices,
+				Settings.MaxTriangles, Meshlets.size(), (double)IndexCount / 3 / Meshlets.size(), (double)MeshletVertices / Meshlets.size());
+		}
+		Check(bAllValid, "limits: every meshlet respects the vertex and triangle limits and covers its range exactly once");
+
+		// A submesh range, the meshlets stay inside it
+		const uint32_t StartIndex = 600;
+		const uint32_t RangeIndexCount = 3000;
+		std::vector<TMeshlet> Meshlets;
+		BuildMeshlets(Vertices, Indices, StartIndex, RangeIndexCount, Meshlets);
+		Check(IsValidSplit(Indices, StartIndex, RangeIndexCount, Meshlets, TMeshletSettings()), "limits: a submesh range is covered exactly once");
+
+		// Degenerate triangles still count as triangles and share their repeated vertex
+		const std::vector<uint32_t> Degenerate = { 0, 0, 1, 2, 2, 2, 3, 4, 5 };
+		Meshlets.clear();
+		BuildMeshlets(Vertices, Degenerate, 0, (uint32_t)Degenerate.size(), Meshlets);
+		Check(Meshlets.size() == 1 && Meshlets[0].TriangleCount == 3 && Meshlets[0].VertexCount == 6, "limits: repeated vertices in a triangle are counted once");
+
+		Meshlets.clear();
+		BuildMeshlets(Vertices, Indices, 0, 0, Meshlets);
+		Check(Meshlets.empty(), "limits: an empty range has no meshlets");
+	}
+
+	void TestBounds()
+	{
+		std::vector<TVertex> Vertices;
+		std::vector<uint32_t> Indices;
+		MakeSphere(32, 64, 2.0f, Vertices, Indices);
+
+		std::vector<TMeshlet> Meshlets;
+		BuildMeshlets(Vertices, Indices, 0, (uint32_t)Indices.size(), Meshlets);
+
+		bool bContained = true;
+		for (const TMeshlet& Meshlet : Meshlets)
+		{
+			for (uint32_t i = Meshlet.StartIndex; i < Meshlet.StartIndex + Meshlet.TriangleCount * 3; i++)
+			{
+				const TVector3& P = Vertices[Indices[i]].Position;
+				const float DX = P.x - Meshlet.Center[0];
+				const float DY = P.y - Meshlet.Center[1];
+				const float DZ = P.z - Meshlet.Center[2];
+				bContained &= std::sqrt(DX * DX + DY * DY + DZ * DZ) <= Meshlet.Radius * 1.0001f;
+			}
+		}
+		Check(bContained, "bounds: every meshlet sphere holds its vertices");
+	}
+
+	void TestConeCulling()
+	{
+		// Meshlets follow the rings, enough segments keep a meshlet within about 40 degrees of the ring
+		std::vector<TVertex> Vertices;
+		std::vector<uint32_t> Indices;
+		MakeSphere(64, 256, 1.0f, Vertices, Indices);
+
+		std::vector<TMeshlet> Meshlets;
+		BuildMeshlets(Vertices, Indices, 0, (uint32_t)Indices.size(), Meshlets);
+
+		TMeshletCullParams Params;
+		Params.bFrustumCulling = false;
+		Params.bConeCulling = true;
+
+		// Cameras around the sphere at a few distances, a culled meshlet must not have a single front facing triangle
+		const float Cameras[][3] = { { 0.0f, 0.0f, -5.0f }, { 3.0f, 1.0f, 0.0f }, { 0.0f, -1.5f, 0.2f }, { 20.0f, 20.0f, 20.0f } };
+		bool bConservative = true;
+		uint32_t CulledTriangles = 0;
+		uint32_t BackFacingTriangles = 0;
+		uint32_t TotalTriangles = 0;
+
+		for (const float* Camera : Cameras)
+		{
+			std::copy(Camera, Camera + 3, Params.LocalCameraPosition);
+			std::fill(Params.LocalToClip, Params.LocalToClip + 16, 0.0f);
+
+			std::vector<uint32_t> Visible;
+			const TMeshletCullStats Stats = CullMeshlets(Meshlets, Params, Visible);
+
+			std::vector<bool> bVisible(Meshlets.size(), false);
+			for (uint32_t MeshletIdx : Visible)
+			{
+				bVisible[MeshletIdx] = true;
+			}
+
+			for (size_t m = 0; m < Meshlets.size(); m++)
+			{
+				for (uint32_t i = Meshlets[m].StartIndex; i < Meshlets[m].StartIndex + Meshlets[m].TriangleCount * 3; i += 3)
+				{
+					const bool bBackFacing = IsBackFacing(Vertices, &Indices[i], Camera);
+					bConservative &= bVisible[m] || bBackFacing;
+					BackFacingTriangles += bBackFacing;
+				}
+			}
+
+			CulledTriangles += Stats.TriangleCount - Stats.VisibleTriangleCount;
+			TotalTriangles += Stats.TriangleCount;
+		}
+
+		printf("Cone culling: %u of %u triangles back facing, %u culled with %zu meshlets\n", BackFacingTriangles, TotalTriangles,
+			CulledTriangles, Meshlets.size());
+
+		Check(bConservative, "cone: only meshlets whose triangles all face away are culled");
+		Check(CulledTriangles > BackFacingTriangles / 3, "cone: the far side of the sphere is rejected");
+
+		// Disabling the test keeps everything
+		Params.bConeCulling = false;
+		std::vector<uint32_t> Visible;
+		Check(CullMeshlets(Meshlets, Params, Visible).VisibleMeshletCount == Meshlets.size(), "cone: nothing is culled with the test off");
+	}
+
+	void TestFrustumCulling()
+	{
+		// Spheres in a row along X, the camera sees the middle ones
+		std::vector<TVertex> Vertices;
+		std::vector<uint32_t> Indices;
+		std::vector<TVertex> SphereVertices;
+		std::vector<uint32_t> SphereIndices;
+		MakeSphere(16, 32, 1.0f, SphereVertices, SphereIndices);
+
+		for (int i = -10; i <= 10; i++)
+		{
+			const uint32_t Base = (uint32_t)Vertices.size();
+			for (TVertex Vertex : SphereVertices)
+			{
+				Vertex.Position.x += i * 3.0f;
+				Vertices.push_back(Vertex);
+			}
+			for (uint32_t Index : SphereIndices)
+			{
+				Indices.push_back(Base + Index);
+			}
+		}
+
+		std::vector<TMeshlet> Meshlets;
+		BuildMeshlets(Vertices, Indices, 0, (uint32_t)Indices.size(), Meshlets);
+
+		TMeshletCullParams Params;
+		Params.bFrustumCulling = true;
+		Params.bConeCulling = false;
+		const float Eye[3] = { 0.0f, 0.0f, -10.0f };
+		std::copy(Eye, Eye + 3, Params.LocalCameraPosition);
+		MakeLocalToClip(Eye, 1.0f, 1.0f, 0.1f, 100.0f, Params.LocalToClip);
+
+		std::vector<uint32_t> Visible;
+		const TMeshletCullStats Stats = CullMeshlets(Meshlets, Params, Visible);
+
+		std::vector<bool> bVisible(Meshlets.size(), false);
+		for (uint32_t MeshletIdx : Visible)
+		{
+			bVisible[MeshletIdx] = true;
+		}
+
+		bool bConservative = true;
+		for (size_t m = 0; m < Meshlets.size(); m++)
+		{
+			for (uint32_t i = Meshlets[m].StartIndex; i < Meshlets[m].StartIndex + Meshlets[m].TriangleCount * 3; i++)
+			{
+				bConservative &= bVisible[m] || !IsInsideClip(Vertices[Indices[i]].Position, Params.LocalToClip);
+			}
+		}
+
+		printf("Frustum culling: %u of %u meshlets visible\n", Stats.VisibleMeshletCount, Stats.MeshletCount);
+
+		Check(bConservative, "frustum: no meshlet with a vertex in view is culled");
+		Check(Stats.VisibleMeshletCount < Stats.MeshletCount / 2, "frustum: meshlets outside the view are culled");
+		Check(Stats.VisibleMeshletCount > 0, "frustum: meshlets in view are kept");
+	}
+
+	void TestTimings()
+	{
+		std::vector<TVertex> Vertices;
+		std::vector<uint32_t> Indices;
+		MakeSphere(512, 1024, 1.0f, Vertices, Indices);
+
+		auto StartTime = TClock::now();
+		std::vector<TMeshlet> Meshlets;
+		BuildMeshlets(Vertices, Indices, 0, (uint32_t)Indices.size(), Meshlets);
+		const double BuildMilliseconds = ElapsedMilliseconds(StartTime);
+
+		TMeshletCullParams Params;
+		const float Eye[3] = { 0.3f, 0.2f, -3.0f };
+		std::copy(Eye, Eye + 3, Params.LocalCameraPosition);
+		MakeLocalToClip(Eye, 0.5f, 1.0f, 0.1f, 100.0f, Params.LocalToClip);
+
+		StartTime = TClock::now();
+		std::vector<uint32_t> Visible;
+		TMeshletCullStats Stats;
+		const int CullRuns = 20;
+		for (int Run = 0; Run < CullRuns; Run++)
+		{
+			Visible.clear();
+			Stats = CullMeshlets(Meshlets, Params, Visible);
+		}
+		const double CullMilliseconds = ElapsedMilliseconds(StartTime) / CullRuns;
+
+		printf("%zu triangles: built %zu meshlets in %.1f ms, culled in %.3f ms, %u meshlets and %u triangles visible\n",
+			Indices.size() / 3, Meshlets.size(), BuildMilliseconds, CullMilliseconds, Stats.VisibleMeshletCount, Stats.VisibleTriangleCount);
+
+		Check(IsValidSplit(Indices, 0, (uint32_t)Indices.size(), Meshlets, TMeshletSettings()), "timings: the large mesh is split validly");
+		Check(Stats.VisibleTriangleCount < Stats.TriangleCount / 2, "timings: a close view culls most of the sphere");
+	}
+}
+
+int main()
+{
+	TestLimits();
+	TestBounds();
+	TestConeCulling();
+	TestFrustumCulling();
+	TestTimings();
+
+	printf("%s\n", FailureCount == 0 ? "All meshlet checks passed" : "Meshlet checks FAILED");
+
+	return FailureCount;
+}
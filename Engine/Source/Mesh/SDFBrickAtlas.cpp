@@ -0,0 +1,350 @@
+#include "SDFBrickAtlas.h"
+#include "MeshSDFLayout.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	// Signed distance in voxels of an R8 texel, the bake maps [-Band, Band] to [0, 255]
+	float QuantizedToVoxels(uint8_t Value)
+	{
+		return (Value / 255.0f - 0.5f) * 2.0f * MeshSDFDistanceBandVoxels;
+	}
+
+	size_t GetVoxelIndex(const int Resolution[3], int X, int Y, int Z)
+	{
+		X = std::clamp(X, 0, Resolution[0] - 1);
+		Y = std::clamp(Y, 0, Resolution[1] - 1);
+		Z = std::clamp(Z, 0, Resolution[2] - 1);
+
+		return ((size_t)Z * Resolution[1] + Y) * Resolution[0] + X;
+	}
+
+	size_t GetBrickIndex(const int BrickDim[3], int X, int Y, int Z)
+	{
+		return ((size_t)Z * BrickDim[1] + Y) * BrickDim[0] + X;
+	}
+
+	void GetBrickDim(const int Resolution[3], int OutBrickDim[3])
+	{
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			OutBrickDim[Axis] = (Resolution[Axis] + SDFBrickSize - 1) / SDFBrickSize;
+		}
+	}
+
+	float Lerp(float A, float B, float T)
+	{
+		return A + (B - A) * T;
+	}
+
+	template<typename TFetch>
+	float SampleTrilinear(float X, float Y, float Z, TFetch Fetch)
+	{
+		// Texel centers sit at i + 0.5
+		X -= 0.5f;
+		Y -= 0.5f;
+		Z -= 0.5f;
+
+		const int X0 = (int)std::floor(X);
+		const int Y0 = (int)std::floor(Y);
+		const int Z0 = (int)std::floor(Z);
+		const float FX = X - X0;
+		const float FY = Y - Y0;
+		const float FZ = Z - Z0;
+
+		float Planes[2];
+		for (int k = 0; k < 2; k++)
+		{
+			float Row0 = Lerp(Fetch(X0, Y0, Z0 + k), Fetch(X0 + 1, Y0, Z0 + k), FX);
+			float Row1 = Lerp(Fetch(X0, Y0 + 1, Z0 + k), Fetch(X0 + 1, Y0 + 1, Z0 + k), FX);
+			Planes[k] = Lerp(Row0, Row1, FY);
+		}
+
+		return Lerp(Planes[0], Planes[1], FZ);
+	}
+}
+
+void BuildSparseMeshSDF(const std::vector<uint8_t>& DenseSDF, const int Resolution[3], float BandVoxels, TSparseMeshSDF& OutSparseSDF)
+{
+	TSparseMeshSDF SparseSDF;
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		SparseSDF.Resolution[Axis] = Resolution[Axis];
+	}
+	GetBrickDim(Resolution, SparseSDF.BrickDim);
+
+	const int* BrickDim = SparseSDF.BrickDim;
+	SparseSDF.Indirection.resize((size_t)BrickDim[0] * BrickDim[1] * BrickDim[2]);
+
+
+	// Clamp addressing, the apron of border bricks repeats the edge voxels
+	auto Fetch = [&](int X, int Y, int Z)
+	{
+		return DenseSDF[GetVoxelIndex(Resolution, X, Y, Z)];
+	};
+
+	uint8_t BrickTexels[SDFBrickTexelCount];
+
+	for (int BrickZ = 0; BrickZ < BrickDim[2]; BrickZ++)
+	{
+		for (int BrickY = 0; BrickY < BrickDim[1]; BrickY++)
+		{
+			for (int BrickX = 0; BrickX < BrickDim[0]; BrickX++)
+			{
+				const int StartX = BrickX * SDFBrickSize - SDFBrickApron;
+				const int StartY = BrickY * SDFBrickSize - SDFBrickApron;
+				const int StartZ = BrickZ * SDFBrickSize - SDFBrickApron;
+
+				// Texel closest to the surface, also the step distance of the brick if it is not stored
+				uint8_t ClosestValue = 0;
+				float ClosestDistance = 1e30f;
+
+				int TexelIndex = 0;
+				for (int z = 0; z < SDFBrickStoredSize; z++)
+				{
+					for (int y = 0; y < SDFBrickStoredSize; y++)
+					{
+						for (int x = 0; x < SDFBrickStoredSize; x++)
+						{
+							uint8_t Value = Fetch(StartX + x, StartY + y, StartZ + z);
+							BrickTexels[TexelIndex++] = Value;
+
+							float Distance = std::abs(QuantizedToVoxels(Value));
+							if (Distance < ClosestDistance)
+							{
+								ClosestDistance = Distance;
+								ClosestValue = Value;
+							}
+						}
+					}
+				}
+
+				uint32_t& Entry = SparseSDF.Indirection[GetBrickIndex(BrickDim, BrickX, BrickY, BrickZ)];
+				if (ClosestDistance < BandVoxels)
+				{
+					Entry = SparseSDF.GetStoredBrickCount();
+					SparseSDF.Bricks.insert(SparseSDF.Bricks.end(), BrickTexels, BrickTexels + SDFBrickTexelCount);
+				}
+				else
+				{
+					Entry = SDFEmptyBrickFlag | ClosestValue;
+				}
+			}
+		}
+	}
+
+	OutSparseSDF = std::move(SparseSDF);
+}
+
+TSDFBrickAtlas::TSDFBrickAtlas(int InSlotsX, int InSlotsY, int InMaxSlotsZ)
+	:SlotsX(InSlotsX), SlotsY(InSlotsY), MaxSlotsZ(InMaxSlotsZ)
+{
+}
+
+bool TSDFBrickAtlas::AddSlotLayer()
+{
+	if (SlotsZ >= MaxSlotsZ)
+	{
+		return false;
+	}
+
+	const uint32_t LayerSlotCount = (uint32_t)(SlotsX * SlotsY);
+	const uint32_t FirstSlot = (uint32_t)SlotsZ * LayerSlotCount;
+
+	// Slots are z major, so the new layer is appended to the data without moving older slots
+	SlotsZ++;
+	Data.resize((size_t)GetWidth() * GetHeight() * GetDepth(), 255);
+
+	for (uint32_t i = LayerSlotCount; i > 0; i--)
+	{
+		FreeSlots.push_back(FirstSlot + i - 1);
+	}
+
+	return true;
+}
+
+bool TSDFBrickAtlas::AllocateSlot(uint32_t& OutSlot)
+{
+	if (FreeSlots.empty() && !AddSlotLayer())
+	{
+		return false;
+	}
+
+	OutSlot = FreeSlots.back();
+	FreeSlots.pop_back();
+
+	return true;
+}
+
+void TSDFBrickAtlas::FreeSlot(uint32_t Slot)
+{
+	FreeSlots.push_back(Slot);
+}
+
+void TSDFBrickAtlas::GetSlotOrigin(uint32_t Slot, int& OutX, int& OutY, int& OutZ) const
+{
+	OutX = (int)(Slot % SlotsX) * SDFBrickStoredSize;
+	OutY = (int)((Slot / SlotsX) % SlotsY) * SDFBrickStoredSize;
+	OutZ = (int)(Slot / (SlotsX * SlotsY)) * SDFBrickStoredSize;
+}
+
+void TSDFBrickAtlas::AddMesh(const TSparseMeshSDF& MeshSDF, std::vector<uint32_t>& OutIndirection)
+{
+	OutIndirection = MeshSDF.Indirection;
+
+	for (uint32_t& Entry : OutIndirection)
+	{
+		if (Entry & SDFEmptyBrickFlag)
+		{
+			continue;
+		}
+
+		const uint8_t* BrickTexels = MeshSDF.Bricks.data() + (size_t)Entry * SDFBrickTexelCount;
+
+		uint32_t Slot;
+		if (!AllocateSlot(Slot))
+		{
+			// Atlas is full, keep the closest distance of the brick as a conservative step
+			uint8_t ClosestValue = *std::min_element(BrickTexels, BrickTexels + SDFBrickTexelCount, [](uint8_t A, uint8_t B)
+			{
+				return std::abs(A - 127.5f) < std::abs(B - 127.5f);
+			});
+			Entry = SDFEmptyBrickFlag | ClosestValue;
+
+			continue;
+		}
+
+		int OriginX, OriginY, OriginZ;
+		GetSlotOrigin(Slot, OriginX, OriginY, OriginZ);
+
+		for (int z = 0; z < SDFBrickStoredSize; z++)
+		{
+			for (int y = 0; y < SDFBrickStoredSize; y++)
+			{
+				size_t AtlasOffset = ((size_t)(OriginZ + z) * GetHeight() + OriginY + y) * GetWidth() + OriginX;
+				std::copy(BrickTexels, BrickTexels + SDFBrickStoredSize, Data.begin() + AtlasOffset);
+				BrickTexels += SDFBrickStoredSize;
+			}
+		}
+
+		Entry = Slot;
+	}
+
+	bDirty = true;
+}
+
+void TSDFBrickAtlas::RemoveMesh(const std::vector<uint32_t>& Indirection)
+{
+	for (uint32_t Entry : Indirection)
+	{
+		if (!(Entry & SDFEmptyBrickFlag))
+		{
+			FreeSlot(Entry);
+		}
+	}
+}
+
+float SampleSparseMeshSDF(const TSDFBrickAtlas& Atlas, const std::vector<uint32_t>& Indirection, const int Resolution[3], const float VolumeUV[3])
+{
+	int BrickDim[3];
+	GetBrickDim(Resolution, BrickDim);
+
+	float VoxelPosition[3];
+	int Brick[3];
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		VoxelPosition[Axis] = VolumeUV[Axis] * Resolution[Axis];
+		Brick[Axis] = std::clamp((int)std::floor(VoxelPosition[Axis] / SDFBrickSize), 0, BrickDim[Axis] - 1);
+	}
+
+	uint32_t Entry = Indirection[GetBrickIndex(BrickDim, Brick[0], Brick[1], Brick[2])];
+	if (Entry & SDFEmptyBrickFlag)
+	{
+		return (Entry & 0xFF) / 255.0f;
+	}
+
+	int Origin[3];
+	Atlas.GetSlotOrigin(Entry, Origin[0], Origin[1], Origin[2]);
+
+	float AtlasPosition[3];
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		AtlasPosition[Axis] = Origin[Axis] + SDFBrickApron + (VoxelPosition[Axis] - Brick[Axis] * SDFBrickSize);
+	}
+
+	return SampleTrilinear(AtlasPosition[0], AtlasPosition[1], AtlasPosition[2], [&](int X, int Y, int Z)
+	{
+		X = std::clamp(X, 0, Atlas.GetWidth() - 1);
+		Y = std::clamp(Y, 0, Atlas.GetHeight() - 1);
+		Z = std::clamp(Z, 0, Atlas.GetDepth() - 1);
+
+		return Atlas.GetTexel(X, Y, Z) / 255.0f;
+	});
+}
+
+float SampleDenseMeshSDF(const std::vector<uint8_t>& DenseSDF, const int Resolution[3], const float VolumeUV[3])
+{
+	return SampleTrilinear(VolumeUV[0] * Resolution[0], VolumeUV[1] * Resolution[1], VolumeUV[2] * Resolution[2], [&](int X, int Y, int Z)
+	{
+		return DenseSDF[GetVoxelIndex(Resolution, X, Y, Z)] / 255.0f;
+	});
+}
+
+std::string TSparseSDFValidation::ToString() const
+{
+	char Buffer[256];
+	snprintf(Buffer, sizeof(Buffer), "%u samples, max stored brick error %.4f voxels, %u non conservative empty brick samples",
+		SampleCount, MaxStoredError, NonConservativeCount);
+
+	return Buffer;
+}
+
+TSparseSDFValidation ValidateSparseMeshSDF(const std::vector<uint8_t>& DenseSDF, const int Resolution[3],
+	const TSDFBrickAtlas& Atlas, const std::vector<uint32_t>& Indirection)
+{
+	TSparseSDFValidation Validation;
+
+	int BrickDim[3];
+	GetBrickDim(Resolution, BrickDim);
+
+	const int SampleDim[3] = { Resolution[0] * 2, Resolution[1] * 2, Resolution[2] * 2 };
+
+	for (int z = 0; z < SampleDim[2]; z++)
+	{
+		for (int y = 0; y < SampleDim[1]; y++)
+		{
+			for (int x = 0; x < SampleDim[0]; x++)
+			{
+				const float VolumeUV[3] = { (x + 0.5f) / SampleDim[0], (y + 0.5f) / SampleDim[1], (z + 0.5f) / SampleDim[2] };
+
+				float Dense = SampleDenseMeshSDF(DenseSDF, Resolution, VolumeUV);
+				float Sparse = SampleSparseMeshSDF(Atlas, Indirection, Resolution, VolumeUV);
+
+				int BrickX = std::min<int>((int)(VolumeUV[0] * Resolution[0]) / SDFBrickSize, BrickDim[0] - 1);
+				int BrickY = std::min<int>((int)(VolumeUV[1] * Resolution[1]) / SDFBrickSize, BrickDim[1] - 1);
+				int BrickZ = std::min<int>((int)(VolumeUV[2] * Resolution[2]) / SDFBrickSize, BrickDim[2] - 1);
+				uint32_t Entry = Indirection[GetBrickIndex(BrickDim, BrickX, BrickY, BrickZ)];
+
+				if (Entry & SDFEmptyBrickFlag)
+				{
+					// Half a quantization step of slack
+					if (Dense >= 0.5f && Sparse > Dense + 0.5f / 255.0f)
+					{
+						Validation.NonConservativeCount++;
+					}
+				}
+				else
+				{
+					// [0, 1] spans 2 * MeshSDFDistanceBandVoxels voxels
+					Validation.MaxStoredError = std::max<float>(Validation.MaxStoredError, std::abs(Sparse - Dense) * 2.0f * MeshSDFDistanceBandVoxels);
+				}
+
+				Validation.SampleCount++;
+			}
+		}
+	}
+
+	return Validation;
+}
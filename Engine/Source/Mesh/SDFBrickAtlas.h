@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Voxels per brick edge. Stored bricks carry a one voxel apron on every side so trilinear filtering
+// never reads a neighbouring atlas slot, match SDF_BRICK_SIZE and SDF_BRICK_APRON in SDFShared.hlsl.
+const int SDFBrickSize = 8;
+const int SDFBrickApron = 1;
+const int SDFBrickStoredSize = SDFBrickSize + 2 * SDFBrickApron;
+const int SDFBrickTexelCount = SDFBrickStoredSize * SDFBrickStoredSize * SDFBrickStoredSize;
+
+// Indirection entry of a brick without storage, the low 8 bits hold the quantized distance closest to the surface
+const uint32_t SDFEmptyBrickFlag = 0x80000000u;
+
+// Narrow band of a mesh distance field cut into bricks
+struct TSparseMeshSDF
+{
+	int Resolution[3] = {};
+
+	// Bricks per axis, Resolution / SDFBrickSize rounded up
+	int BrickDim[3] = {};
+
+	// One entry per brick, x fastest. Index of the brick in Bricks or SDFEmptyBrickFlag | distance.
+	std::vector<uint32_t> Indirection;
+
+	// Stored bricks back to back, SDFBrickTexelCount R8 texels each (apron included)
+	std::vector<uint8_t> Bricks;
+
+	uint32_t GetStoredBrickCount() const { return (uint32_t)(Bricks.size() / SDFBrickTexelCount); }
+};
+
+// Cut the dense R8 volume of BuildMeshSDF into bricks. Bricks whose texels (apron included) come within
+// BandVoxels voxels of the surface are stored, the others keep their smallest distance as a conservative step.
+void BuildSparseMeshSDF(const std::vector<uint8_t>& DenseSDF, const int Resolution[3], float BandVoxels, TSparseMeshSDF& OutSparseSDF);
+
+// Shared R8 3D texture of brick slots. Slots are laid out x, y then z and the atlas grows by whole z layers,
+// so growing never moves an allocated slot.
+class TSDFBrickAtlas
+{
+public:
+	TSDFBrickAtlas(int InSlotsX = 16, int InSlotsY = 16, int InMaxSlotsZ = 2048 / SDFBrickStoredSize);
+
+	// Copy the stored bricks of MeshSDF into free slots. OutIndirection is the mesh indirection with atlas slot indices,
+	// bricks that no longer fit fall back to empty entries.
+	void AddMesh(const TSparseMeshSDF& MeshSDF, std::vector<uint32_t>& OutIndirection);
+
+	// Return the slots referenced by an indirection from AddMesh
+	void RemoveMesh(const std::vector<uint32_t>& Indirection);
+
+	bool AllocateSlot(uint32_t& OutSlot);
+
+	void FreeSlot(uint32_t Slot);
+
+	// First texel of the slot apron
+	void GetSlotOrigin(uint32_t Slot, int& OutX, int& OutY, int& OutZ) const;
+
+	uint8_t GetTexel(int X, int Y, int Z) const { return Data[((size_t)Z * GetHeight() + Y) * GetWidth() + X]; }
+
+	int GetSlotsX() const { return SlotsX; }
+
+	int GetSlotsY() const { return SlotsY; }
+
+	int GetSlotsZ() const { return SlotsZ; }
+
+	int GetWidth() const { return SlotsX * SDFBrickStoredSize; }
+
+	int GetHeight() const { return SlotsY * SDFBrickStoredSize; }
+
+	int GetDepth() const { return SlotsZ * SDFBrickStoredSize; }
+
+	uint32_t GetUsedSlotCount() const { return (uint32_t)(SlotsX * SlotsY * SlotsZ) - (uint32_t)FreeSlots.size(); }
+
+	// Width * Height * Depth texels, x fastest
+	const std::vector<uint8_t>& GetData() const { return Data; }
+
+	// Set by AddMesh, the owner recreates the GPU texture and clears it
+	bool IsDirty() const { return bDirty; }
+
+	void ClearDirty() { bDirty = false; }
+
+private:
+	bool AddSlotLayer();
+
+private:
+	int SlotsX = 0;
+
+	int SlotsY = 0;
+
+	int SlotsZ = 0;
+
+	int MaxSlotsZ = 0;
+
+	// Lowest slot last
+	std::vector<uint32_t> FreeSlots;
+
+	std::vector<uint8_t> Data;
+
+	bool bDirty = false;
+};
+
+// CPU reference of SampleMeshDistanceField in SDFShared.hlsl, trilinear filtered R8 value in [0, 1] at VolumeUV
+float SampleSparseMeshSDF(const TSDFBrickAtlas& Atlas, const std::vector<uint32_t>& Indirection, const int Resolution[3], const float VolumeUV[3]);
+
+// Trilinear filtered R8 value in [0, 1] of the dense volume with clamp addressing
+float SampleDenseMeshSDF(const std::vector<uint8_t>& DenseSDF, const int Resolution[3], const float VolumeUV[3]);
+
+struct TSparseSDFValidation
+{
+	uint32_t SampleCount = 0;
+
+	// Largest difference to the dense volume inside stored bricks, in voxels
+	float MaxStoredError = 0.0f;
+
+	// Samples outside the surface where an empty brick reports more distance than the dense volume
+	uint32_t NonConservativeCount = 0;
+
+	std::string ToString() const;
+};
+
+// Compare the atlas lookup against the dense volume on a grid of 2 * Resolution samples per axis
+TSparseSDFValidation ValidateSparseMeshSDF(const std::vector<uint8_t>& DenseSDF, const int Resolution[3],
+	const TSDFBrickAtlas& Atlas, const std::vector<uint32_t>& Indirection);
@@ -0,0 +1,249 @@
+#include "VertexQuantization.h"
+#include "Utils/HalfFloat.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const float RadiansToDegrees = 57.2957795f;
+
+	float SignNotZero(float Value)
+	{
+		return Value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	float Snorm16ToFloat(int16_t Value)
+	{
+		// Same as the input assembler, -32768 and -32767 both map to -1
+		return std::max<float>(Value / 32767.0f, -1.0f);
+	}
+
+	uint16_t FloatToUnorm16(float Value)
+	{
+		Value = std::min<float>(std::max<float>(Value, 0.0f), 1.0f);
+		return (uint16_t)std::lround(Value * 65535.0f);
+	}
+
+	bool Normalize(float Vector[3])
+	{
+		float Length = std::sqrt(Vector[0] * Vector[0] + Vector[1] * Vector[1] + Vector[2] * Vector[2]);
+		if (Length < 1e-12f)
+		{
+			return false;
+		}
+
+		Vector[0] /= Length;
+		Vector[1] /= Length;
+		Vector[2] /= Length;
+
+		return true;
+	}
+
+	// atan2 of the cross and dot products, acos of a float dot can not resolve angles below about 0.02 degrees
+	float AngleBetweenDegrees(const float A[3], const float B[3])
+	{
+		const float CrossX = A[1] * B[2] - A[2] * B[1];
+		const float CrossY = A[2] * B[0] - A[0] * B[2];
+		const float CrossZ = A[0] * B[1] - A[1] * B[0];
+		const float Dot = A[0] * B[0] + A[1] * B[1] + A[2] * B[2];
+
+		return std::atan2(std::sqrt(CrossX * CrossX + CrossY * CrossY + CrossZ * CrossZ), Dot) * RadiansToDegrees;
+	}
+}
+
+void EncodeOctahedral(const float Vector[3], int16_t OutEncoded[2])
+{
+	float N[3] = { Vector[0], Vector[1], Vector[2] };
+	if (!Normalize(N))
+	{
+		OutEncoded[0] = 0;
+		OutEncoded[1] = 0;
+		return;
+	}
+
+	// Project onto the octahedron and unfold the lower half
+	float InvL1 = 1.0f / (std::fabs(N[0]) + std::fabs(N[1]) + std::fabs(N[2]));
+	float X = N[0] * InvL1;
+	float Y = N[1] * InvL1;
+
+	if (N[2] < 0.0f)
+	{
+		float FoldedX = (1.0f - std::fabs(Y)) * SignNotZero(X);
+		float FoldedY = (1.0f - std::fabs(X)) * SignNotZero(Y);
+		X = FoldedX;
+		Y = FoldedY;
+	}
+
+	// Plain rounding can be off by a texel, keep the neighbour that decodes closest
+	int16_t BaseX = (int16_t)std::max<float>(std::floor(X * 32767.0f), -32767.0f);
+	int16_t BaseY = (int16_t)std::max<float>(std::floor(Y * 32767.0f), -32767.0f);
+
+	float BestDot = -2.0f;
+	for (int32_t dy = 0; dy <= 1; dy++)
+	{
+		for (int32_t dx = 0; dx <= 1; dx++)
+		{
+			int16_t Candidate[2] = { (int16_t)std::min<int32_t>(BaseX + dx, 32767), (int16_t)std::min<int32_t>(BaseY + dy, 32767) };
+
+			float Decoded[3];
+			DecodeOctahedral(Candidate, Decoded);
+
+			float Dot = Decoded[0] * N[0] + Decoded[1] * N[1] + Decoded[2] * N[2];
+			if (Dot > BestDot)
+			{
+				BestDot = Dot;
+				OutEncoded[0] = Candidate[0];
+				OutEncoded[1] = Candidate[1];
+			}
+		}
+	}
+}
+
+void DecodeOctahedral(const int16_t Encoded[2], float OutVector[3])
+{
+	float X = Snorm16ToFloat(Encoded[0]);
+	float Y = Snorm16ToFloat(Encoded[1]);
+	float Z = 1.0f - std::fabs(X) - std::fabs(Y);
+
+	if (Z < 0.0f)
+	{
+		float UnfoldedX = (1.0f - std::fabs(Y)) * SignNotZero(X);
+		float UnfoldedY = (1.0f - std::fabs(X)) * SignNotZero(Y);
+		X = UnfoldedX;
+		Y = UnfoldedY;
+	}
+
+	OutVector[0] = X;
+	OutVector[1] = Y;
+	OutVector[2] = Z;
+
+	if (!Normalize(OutVector))
+	{
+		OutVector[0] = 0.0f;
+		OutVector[1] = 0.0f;
+		OutVector[2] = 1.0f;
+	}
+}
+
+TPositionQuantization ComputePositionQuantization(const std::vector<TVertex>& Vertices)
+{
+	TPositionQuantization Quantization;
+	if (Vertices.empty())
+	{
+		return Quantization;
+	}
+
+	float Min[3] = { Vertices[0].Position.x, Vertices[0].Position.y, Vertices[0].Position.z };
+	float Max[3] = { Min[0], Min[1], Min[2] };
+
+	for (const TVertex& Vertex : Vertices)
+	{
+		const float Position[3] = { Vertex.Position.x, Vertex.Position.y, Vertex.Position.z };
+		for (int i = 0; i < 3; i++)
+		{
+			Min[i] = std::min<float>(Min[i], Position[i]);
+			Max[i] = std::max<float>(Max[i], Position[i]);
+		}
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		Quantization.Min[i] = Min[i];
+
+		// Flat axis, any extent decodes to Min
+		Quantization.Extent[i] = (Max[i] > Min[i]) ? (Max[i] - Min[i]) : 1.0f;
+	}
+
+	return Quantization;
+}
+
+void EncodeCompactVertices(const std::vector<TVertex>& Vertices, const TPositionQuantization& Quantization,
+	std::vector<TCompactPosition>& OutPositions, std::vector<TCompactAttributes>& OutAttributes)
+{
+	OutPositions.resize(Vertices.size());
+	OutAttributes.resize(Vertices.size());
+
+	for (size_t i = 0; i < Vertices.size(); i++)
+	{
+		const TVertex& Vertex = Vertices[i];
+
+		TCompactPosition& Position = OutPositions[i];
+		Position.X = FloatToUnorm16((Vertex.Position.x - Quantization.Min[0]) / Quantization.Extent[0]);
+		Position.Y = FloatToUnorm16((Vertex.Position.y - Quantization.Min[1]) / Quantization.Extent[1]);
+		Position.Z = FloatToUnorm16((Vertex.Position.z - Quantization.Min[2]) / Quantization.Extent[2]);
+		Position.W = 65535;
+
+		TCompactAttributes& Attributes = OutAttributes[i];
+
+		const float Normal[3] = { Vertex.Normal.x, Vertex.Normal.y, Vertex.Normal.z };
+		EncodeOctahedral(Normal, Attributes.Normal);
+
+		const float Tangent[3] = { Vertex.TangentU.x, Vertex.TangentU.y, Vertex.TangentU.z };
+		EncodeOctahedral(Tangent, Attributes.Tangent);
+
+		Attributes.TexC[0] = THalfFloat::FromFloat(Vertex.TexC.x);
+		Attributes.TexC[1] = THalfFloat::FromFloat(Vertex.TexC.y);
+	}
+}
+
+TVertex DecodeCompactVertex(const TCompactPosition& Position, const TCompactAttributes& Attributes, const TPositionQuantization& Quantization)
+{
+	TVertex Vertex;
+	Vertex.Position.x = Quantization.Min[0] + (Position.X / 65535.0f) * Quantization.Extent[0];
+	Vertex.Position.y = Quantization.Min[1] + (Position.Y / 65535.0f) * Quantization.Extent[1];
+	Vertex.Position.z = Quantization.Min[2] + (Position.Z / 65535.0f) * Quantization.Extent[2];
+
+	float Normal[3];
+	DecodeOctahedral(Attributes.Normal, Normal);
+	Vertex.Normal.x = Normal[0];
+	Vertex.Normal.y = Normal[1];
+	Vertex.Normal.z = Normal[2];
+
+	float Tangent[3];
+	DecodeOctahedral(Attributes.Tangent, Tangent);
+	Vertex.TangentU.x = Tangent[0];
+	Vertex.TangentU.y = Tangent[1];
+	Vertex.TangentU.z = Tangent[2];
+
+	Vertex.TexC.x = THalfFloat::ToFloat(Attributes.TexC[0]);
+	Vertex.TexC.y = THalfFloat::ToFloat(Attributes.TexC[1]);
+
+	return Vertex;
+}
+
+TVertexQuantizationError MeasureQuantizationError(const std::vector<TVertex>& Vertices, const std::vector<TCompactPosition>& Positions,
+	const std::vector<TCompactAttributes>& Attributes, const TPositionQuantization& Quantization)
+{
+	TVertexQuantizationError Error;
+
+	for (size_t i = 0; i < Vertices.size(); i++)
+	{
+		const TVertex& Original = Vertices[i];
+		const TVertex Decoded = DecodeCompactVertex(Positions[i], Attributes[i], Quantization);
+
+		float DX = Decoded.Position.x - Original.Position.x;
+		float DY = Decoded.Position.y - Original.Position.y;
+		float DZ = Decoded.Position.z - Original.Position.z;
+		Error.MaxPositionError = std::max<float>(Error.MaxPositionError, std::sqrt(DX * DX + DY * DY + DZ * DZ));
+
+		// Zero vectors carry no direction to compare
+		float OriginalNormal[3] = { Original.Normal.x, Original.Normal.y, Original.Normal.z };
+		if (Normalize(OriginalNormal))
+		{
+			const float DecodedNormal[3] = { Decoded.Normal.x, Decoded.Normal.y, Decoded.Normal.z };
+			Error.MaxNormalErrorDegrees = std::max<float>(Error.MaxNormalErrorDegrees, AngleBetweenDegrees(OriginalNormal, DecodedNormal));
+		}
+
+		float OriginalTangent[3] = { Original.TangentU.x, Original.TangentU.y, Original.TangentU.z };
+		if (Normalize(OriginalTangent))
+		{
+			const float DecodedTangent[3] = { Decoded.TangentU.x, Decoded.TangentU.y, Decoded.TangentU.z };
+			Error.MaxTangentErrorDegrees = std::max<float>(Error.MaxTangentErrorDegrees, AngleBetweenDegrees(OriginalTangent, DecodedTangent));
+		}
+
+		Error.MaxUVError = std::max<float>(Error.MaxUVError, std::fabs(Decoded.TexC.x - Original.TexC.x));
+		Error.MaxUVError = std::max<float>(Error.MaxUVError, std::fabs(Decoded.TexC.y - Original.TexC.y));
+	}
+
+	return Error;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+// Position stream (R16G16B16A16_UNORM), xyz relative to the mesh bounds, w is the bitangent sign
+struct TCompactPosition
+{
+	uint16_t X;
+	uint16_t Y;
+	uint16_t Z;
+	uint16_t W;
+};
+
+// Shading stream, octahedral normal and tangent (R16G16_SNORM) and half UV (R16G16_FLOAT)
+struct TCompactAttributes
+{
+	int16_t Normal[2];
+	int16_t Tangent[2];
+	uint16_t TexC[2];
+};
+
+// Position = Min + Unorm * Extent
+struct TPositionQuantization
+{
+	float Min[3] = { 0.0f, 0.0f, 0.0f };
+
+	float Extent[3] = { 1.0f, 1.0f, 1.0f };
+};
+
+struct TVertexQuantizationError
+{
+	float MaxPositionError = 0.0f;
+
+	float MaxNormalErrorDegrees = 0.0f;
+
+	float MaxTangentErrorDegrees = 0.0f;
+
+	float MaxUVError = 0.0f;
+};
+
+// Unit vector to two SNORM16 octahedral coordinates and back
+void EncodeOctahedral(const float Vector[3], int16_t OutEncoded[2]);
+
+void DecodeOctahedral(const int16_t Encoded[2], float OutVector[3]);
+
+TPositionQuantization ComputePositionQuantization(const std::vector<TVertex>& Vertices);
+
+// TVertex has no bitangent handedness, so the sign is stored as +1
+void EncodeCompactVertices(const std::vector<TVertex>& Vertices, const TPositionQuantization& Quantization,
+	std::vector<TCompactPosition>& OutPositions, std::vector<TCompactAttributes>& OutAttributes);
+
+// CPU reference of the decode done in the vertex shaders
+TVertex DecodeCompactVertex(const TCompactPosition& Position, const TCompactAttributes& Attributes, const TPositionQuantization& Quantization);
+
+TVertexQuantizationError MeasureQuantizationError(const std::vector<TVertex>& Vertices, const std::vector<TCompactPosition>& Positions,
+	const std::vector<TCompactAttributes>& Attributes, const TPositionQuantization& Quantization);
@@ -0,0 +1,171 @@
+#include "VertexQuantization.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// Round trips random vertices through the compact streams and checks the error against the precision of each format.
+// Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	TVector3 RandomUnitVector(std::mt19937& Random)
+	{
+		std::uniform_real_distribution<float> Uniform(-1.0f, 1.0f);
+		while (true)
+		{
+			const float X = Uniform(Random);
+			const float Y = Uniform(Random);
+			const float Z = Uniform(Random);
+			const float Length = std::sqrt(X * X + Y * Y + Z * Z);
+			if (Length > 0.01f && Length <= 1.0f)
+			{
+				return TVector3(X / Length, Y / Length, Z / Length);
+			}
+		}
+	}
+
+	// In double through atan2, a float acos can not resolve angles below about 0.02 degrees
+	double AngleDegrees(const float A[3], const float B[3])
+	{
+		const double CrossX = (double)A[1] * B[2] - (double)A[2] * B[1];
+		const double CrossY = (double)A[2] * B[0] - (double)A[0] * B[2];
+		const double CrossZ = (double)A[0] * B[1] - (double)A[1] * B[0];
+		const double Dot = (double)A[0] * B[0] + (double)A[1] * B[1] + (double)A[2] * B[2];
+		return std::atan2(std::sqrt(CrossX * CrossX + CrossY * CrossY + CrossZ * CrossZ), Dot) * 57.29577951308232;
+	}
+
+	void TestOctahedral()
+	{
+		std::mt19937 Random(3);
+
+		// Axes and the folds of the octahedron, where the lower half is unfolded
+		std::vector<TVector3> Directions = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+			{ 0.7071068f, 0.7071068f, 0 }, { -0.7071068f, 0, -0.7071068f }, { 0, 0.7071068f, -0.7071068f } };
+		for (int i = 0; i < 100000; i++)
+		{
+			Directions.push_back(RandomUnitVector(Random));
+		}
+
+		double MaxErrorDegrees = 0.0;
+		for (const TVector3& Direction : Directions)
+		{
+			const float Vector[3] = { Direction.x, Direction.y, Direction.z };
+			int16_t Encoded[2];
+			EncodeOctahedral(Vector, Encoded);
+
+			float Decoded[3];
+			DecodeOctahedral(Encoded, Decoded);
+			MaxErrorDegrees = std::max<double>(MaxErrorDegrees, AngleDegrees(Vector, Decoded));
+		}
+
+		printf("Octahedral SNORM16: %zu directions, max error %.5f degrees\n", Directions.size(), MaxErrorDegrees);
+
+		// A texel of the octahedron is 2/32767 wide, a little over 0.007 degrees on the sphere at worst
+		Check(MaxErrorDegrees < 0.01f, "octahedral round trip is within a texel");
+
+		const float Zero[3] = { 0.0f, 0.0f, 0.0f };
+		int16_t Encoded[2] = { 1, 1 };
+		EncodeOctahedral(Zero, Encoded);
+		float Decoded[3];
+		DecodeOctahedral(Encoded, Decoded);
+		Check(Encoded[0] == 0 && Encoded[1] == 0 && Decoded[2] == 1.0f, "zero vector encodes to +Z");
+	}
+
+	void TestVertices()
+	{
+		std::mt19937 Random(1);
+		std::uniform_real_distribution<float> Uniform(-1.0f, 1.0f);
+
+		// Wide, tall and thin bounds so each axis has its own step
+		std::vector<TVertex> Vertices(100000);
+		for (TVertex& Vertex : Vertices)
+		{
+			Vertex.Position = TVector3(Uniform(Random) * 50.0f, Uniform(Random) * 20.0f + 5.0f, Uniform(Random) * 3.0f);
+			Vertex.Normal = RandomUnitVector(Random);
+			Vertex.TangentU = RandomUnitVector(Random);
+			Vertex.TexC = TVector2(Uniform(Random) * 2.0f, Uniform(Random));
+		}
+
+		const TPositionQuantization Quantization = ComputePositionQuantization(Vertices);
+
+		std::vector<TCompactPosition> Positions;
+		std::vector<TCompactAttributes> Attributes;
+		EncodeCompactVertices(Vertices, Quantization, Positions, Attributes);
+
+		const TVertexQuantizationError Error = MeasureQuantizationError(Vertices, Positions, Attributes, Quantization);
+
+		printf("Compact vertices: %zu + %zu bytes instead of %zu, position %g, normal %.5f degrees, tangent %.5f degrees, UV %g\n",
+			sizeof(TCompactPosition), sizeof(TCompactAttributes), sizeof(TVertex),
+			Error.MaxPositionError, Error.MaxNormalErrorDegrees, Error.MaxTangentErrorDegrees, Error.MaxUVError);
+
+		// Half a UNORM16 step on every axis, plus float rounding
+		float MaxPositionError = 0.0f;
+		for (int i = 0; i < 3; i++)
+		{
+			const float HalfStep = 0.5f * Quantization.Extent[i] / 65535.0f;
+			MaxPositionError += HalfStep * HalfStep;
+		}
+		MaxPositionError = std::sqrt(MaxPositionError) * 1.01f;
+
+		Check(Positions.size() == Vertices.size() && Attributes.size() == Vertices.size(), "one compact vertex per vertex");
+		Check(Error.MaxPositionError <= MaxPositionError, "positions are within half a UNORM16 step of the bounds");
+		Check(Error.MaxNormalErrorDegrees < 0.01f, "normals are within a texel");
+		Check(Error.MaxTangentErrorDegrees < 0.01f, "tangents are within a texel");
+
+		// Half precision has 11 significant bits, UVs below 2 are off by at most 2^-11
+		Check(Error.MaxUVError <= 1.0f / 2048.0f, "UVs are within half a half float step");
+
+		bool bSignStored = true;
+		for (const TCompactPosition& Position : Positions)
+		{
+			bSignStored &= Position.W == 65535;
+		}
+		Check(bSignStored, "bitangent sign is stored as +1");
+	}
+
+	// A flat mesh and a single vertex must not divide by a zero extent
+	void TestDegenerateBounds()
+	{
+		std::vector<TVertex> Vertices;
+		for (int i = 0; i < 16; i++)
+		{
+			Vertices.push_back(TVertex((float)i, 2.0f, -1.0f, 0, 1, 0, 1, 0, 0, 0.25f, 0.5f));
+		}
+
+		const TPositionQuantization Quantization = ComputePositionQuantization(Vertices);
+
+		std::vector<TCompactPosition> Positions;
+		std::vector<TCompactAttributes> Attributes;
+		EncodeCompactVertices(Vertices, Quantization, Positions, Attributes);
+
+		const TVertexQuantizationError Error = MeasureQuantizationError(Vertices, Positions, Attributes, Quantization);
+		Check(Quantization.Extent[1] == 1.0f && Quantization.Extent[2] == 1.0f, "flat axes get a unit extent");
+		Check(Error.MaxPositionError <= 15.0f / 65535.0f, "flat mesh decodes onto its plane");
+		Check(Error.MaxUVError == 0.0f, "exact UVs survive half precision");
+
+		const TPositionQuantization Empty = ComputePositionQuantization(std::vector<TVertex>());
+		Check(Empty.Extent[0] == 1.0f && Empty.Min[0] == 0.0f, "empty mesh gets the unit bounds");
+	}
+}
+
+int main()
+{
+	TestOctahedral();
+	TestVertices();
+	TestDegenerateBounds();
+
+	printf("%s\n", FailureCount == 0 ? "All vertex quantization checks passed" : "Vertex quantization checks FAILED");
+
+	return FailureCount;
+}
@@ -0,0 +1,256 @@
+#include "VertexWelder.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace
+{
+	// Empty table slot and end of the vertex lists of a cell
+	const uint32_t EmptySlot = 0xFFFFFFFF;
+
+	// Position grid cell, cells are four times PositionEpsilon wide
+	struct TWeldCell
+	{
+		int64_t X = 0;
+
+		int64_t Y = 0;
+
+		int64_t Z = 0;
+
+		bool operator==(const TWeldCell& Other) const
+		{
+			return X == Other.X && Y == Other.Y && Z == Other.Z;
+		}
+	};
+
+	size_t HashWeldCell(const TWeldCell& Cell)
+	{
+		uint64_t Hash = 14695981039346656037ull;
+		const int64_t Values[3] = { Cell.X, Cell.Y, Cell.Z };
+		for (int64_t Value : Values)
+		{
+			Hash ^= (uint64_t)Value;
+			Hash *= 1099511628211ull;
+			Hash ^= Hash >> 29;
+		}
+
+		return (size_t)Hash;
+	}
+
+	// Open addressing table from occupied cells to the first vertex in them, slots only hold the vertex index
+	class TWeldCellTable
+	{
+	public:
+		TWeldCellTable(const std::vector<TWeldCell>& InCells)
+			:Cells(InCells)
+		{
+			size_t Capacity = 16;
+			while (Capacity < Cells.size() * 2)
+			{
+				Capacity *= 2;
+			}
+
+			Slots.resize(Capacity, EmptySlot);
+			Mask = Capacity - 1;
+		}
+
+		// Slot of the cell of the vertex, EmptySlot when no vertex was added to that cell yet
+		uint32_t& FindOrAdd(uint32_t VertexIndex)
+		{
+			return Slots[FindSlot(Cells[VertexIndex])];
+		}
+
+		// First vertex in the cell, EmptySlot when there is none
+		uint32_t Find(const TWeldCell& Cell) const
+		{
+			return Slots[FindSlot(Cell)];
+		}
+
+	private:
+		size_t FindSlot(const TWeldCell& Cell) const
+		{
+			size_t Slot = HashWeldCell(Cell) & Mask;
+			while (Slots[Slot] != EmptySlot && !(Cells[Slots[Slot]] == Cell))
+			{
+				Slot = (Slot + 1) & Mask;
+			}
+
+			return Slot;
+		}
+
+	private:
+		const std::vector<TWeldCell>& Cells;
+
+		std::vector<uint32_t> Slots;
+
+		size_t Mask = 0;
+	};
+
+	// Cell of Value, and the neighbouring cell when Value is within a quarter cell of its boundary with it.
+	// OutNeighbour is OutCell when values within a quarter cell all share its cell.
+	void GetCellCoords(float Value, float InvCellSize, int64_t& OutCell, int64_t& OutNeighbour)
+	{
+		const double Scaled = (double)Value * InvCellSize;
+		const double Cell = std::floor(Scaled);
+		const double Offset = Scaled - Cell;
+
+		OutCell = (int64_t)Cell;
+		OutNeighbour = (Offset < 0.25) ? OutCell - 1 : ((Offset >= 0.75) ? OutCell + 1 : OutCell);
+	}
+
+	bool IsNear(float A, float B, float Epsilon)
+	{
+		return std::fabs(A - B) <= Epsilon;
+	}
+
+	bool CanWeld(const TVertex& A, const TVertex& B, const TVertexWeldSettings& Settings)
+	{
+		return IsNear(A.Position.x, B.Position.x, Settings.PositionEpsilon)
+			&& IsNear(A.Position.y, B.Position.y, Settings.PositionEpsilon)
+			&& IsNear(A.Position.z, B.Position.z, Settings.PositionEpsilon)
+			&& IsNear(A.Normal.x, B.Normal.x, Settings.NormalEpsilon)
+			&& IsNear(A.Normal.y, B.Normal.y, Settings.NormalEpsilon)
+			&& IsNear(A.Normal.z, B.Normal.z, Settings.NormalEpsilon)
+			&& IsNear(A.TangentU.x, B.TangentU.x, Settings.NormalEpsilon)
+			&& IsNear(A.TangentU.y, B.TangentU.y, Settings.NormalEpsilon)
+			&& IsNear(A.TangentU.z, B.TangentU.z, Settings.NormalEpsilon)
+			&& IsNear(A.TexC.x, B.TexC.x, Settings.UVEpsilon)
+			&& IsNear(A.TexC.y, B.TexC.y, Settings.UVEpsilon);
+	}
+}
+
+TVertexWeldStats WeldVertices(std::vector<TVertex>& Vertices, std::vector<uint32_t>& Indices,
+	const TVertexWeldSettings& Settings, TThreadPool& ThreadPool)
+{
+	TVertexWeldStats Stats;
+	Stats.VertexCountBefore = (uint32_t)Vertices.size();
+	Stats.VertexCountAfter = Stats.VertexCountBefore;
+
+	const uint32_t VertexCount = (uint32_t)Vertices.size();
+	if (VertexCount == 0)
+	{
+		return Stats;
+	}
+
+	const bool bParallel = VertexCount >= Settings.ParallelThreshold && ThreadPool.GetThreadCount() > 1;
+	const uint32_t VerticesPerTask = 16384;
+	const uint32_t TaskCount = (VertexCount + VerticesPerTask - 1) / VerticesPerTask;
+
+	auto RunTasks = [&](const std::function<void(uint32_t)>& Func)
+	{
+		if (bParallel)
+		{
+			ThreadPool.ParallelFor(TaskCount, Func);
+		}
+		else
+		{
+			for (uint32_t Task = 0; Task < TaskCount; Task++)
+			{
+				Func(Task);
+			}
+		}
+	};
+
+	// Grid cell of every vertex and the neighbouring cells within epsilon of it
+	const float InvCellSize = 0.25f / Settings.PositionEpsilon;
+	std::vector<TWeldCell> Cells(VertexCount);
+	std::vector<TWeldCell> NeighbourCells(VertexCount);
+
+	RunTasks([&](uint32_t Task)
+	{
+		uint32_t End = std::min<uint32_t>((Task + 1) * VerticesPerTask, VertexCount);
+		for (uint32_t i = Task * VerticesPerTask; i < End; i++)
+		{
+			GetCellCoords(Vertices[i].Position.x, InvCellSize, Cells[i].X, NeighbourCells[i].X);
+			GetCellCoords(Vertices[i].Position.y, InvCellSize, Cells[i].Y, NeighbourCells[i].Y);
+			GetCellCoords(Vertices[i].Position.z, InvCellSize, Cells[i].Z, NeighbourCells[i].Z);
+		}
+	});
+
+	// Vertices of every cell as a list in input order, the table points at the first one
+	TWeldCellTable CellTable(Cells);
+	std::vector<uint32_t> NextInCell(VertexCount);
+
+	for (uint32_t i = VertexCount; i-- > 0;)
+	{
+		uint32_t& FirstInCell = CellTable.FindOrAdd(i);
+		NextInCell[i] = FirstInCell;
+		FirstInCell = i;
+	}
+
+	// First earlier vertex within epsilon of every attribute. Rounding never splits a match: its position is within
+	// a quarter cell on every axis, so it lies in the vertex cell or in a cell spanned with the neighbouring ones.
+	std::vector<uint32_t> FirstMatch(VertexCount);
+
+	RunTasks([&](uint32_t Task)
+	{
+		uint32_t End = std::min<uint32_t>((Task + 1) * VerticesPerTask, VertexCount);
+		for (uint32_t i = Task * VerticesPerTask; i < End; i++)
+		{
+			uint32_t Match = i;
+			for (uint32_t Corner = 0; Corner < 8; Corner++)
+			{
+				if (((Corner & 1) && NeighbourCells[i].X == Cells[i].X)
+					|| ((Corner & 2) && NeighbourCells[i].Y == Cells[i].Y)
+					|| ((Corner & 4) && NeighbourCells[i].Z == Cells[i].Z))
+				{
+					continue;
+				}
+
+				TWeldCell Cell;
+				Cell.X = (Corner & 1) ? NeighbourCells[i].X : Cells[i].X;
+				Cell.Y = (Corner & 2) ? NeighbourCells[i].Y : Cells[i].Y;
+				Cell.Z = (Corner & 4) ? NeighbourCells[i].Z : Cells[i].Z;
+
+				// Lists are in input order and end with EmptySlot
+				for (uint32_t Candidate = CellTable.Find(Cell); Candidate < Match; Candidate = NextInCell[Candidate])
+				{
+					if (CanWeld(Vertices[i], Vertices[Candidate], Settings))
+					{
+						Match = Candidate;
+						break;
+					}
+				}
+			}
+
+			FirstMatch[i] = Match;
+		}
+	});
+
+	// Matches are earlier vertices, so they are already resolved to the first vertex of their chain
+	std::vector<uint32_t> Remap(VertexCount);
+	for (uint32_t i = 0; i < VertexCount; i++)
+	{
+		Remap[i] = (FirstMatch[i] == i) ? i : Remap[FirstMatch[i]];
+	}
+
+	// Compact, keeping first occurrences in input order
+	std::vector<uint32_t> NewIndex(VertexCount);
+	uint32_t WriteIndex = 0;
+
+	for (uint32_t i = 0; i < VertexCount; i++)
+	{
+		if (Remap[i] == i)
+		{
+			NewIndex[i] = WriteIndex;
+			Vertices[WriteIndex] = Vertices[i];
+			WriteIndex++;
+		}
+		else
+		{
+			NewIndex[i] = NewIndex[Remap[i]];
+		}
+	}
+
+	Vertices.resize(WriteIndex);
+
+	for (uint32_t& Index : Indices)
+	{
+		Index = NewIndex[Index];
+	}
+
+	Stats.VertexCountAfter = WriteIndex;
+
+	return Stats;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+class TThreadPool;
+
+struct TVertexWeldSettings
+{
+	// Largest difference per component of two welded attributes
+	float PositionEpsilon = 1e-5f;
+
+	float NormalEpsilon = 1e-3f;
+
+	float UVEpsilon = 1e-5f;
+
+	// Meshes below this vertex count are welded on the calling thread
+	uint32_t ParallelThreshold = 65536;
+};
+
+struct TVertexWeldStats
+{
+	uint32_t VertexCountBefore = 0;
+
+	uint32_t VertexCountAfter = 0;
+};
+
+// Merge vertices whose position/normal/tangent/UV match within the epsilons and rewrite Indices.
+// A vertex welds to the first earlier vertex within the epsilons, chains of such vertices merge into their first one.
+// The first occurrence of each vertex is kept, so the output order follows the input.
+TVertexWeldStats WeldVertices(std::vector<TVertex>& Vertices, std::vector<uint32_t>& Indices,
+	const TVertexWeldSettings& Settings, TThreadPool& ThreadPool);
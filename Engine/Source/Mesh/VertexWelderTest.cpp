@@ -0,0 +1,379 @@
+#include "VertexWelder.h"
+#include "Utils/ThreadPool.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// Welds grids of unshared quads jittered just inside and just outside the epsilons, checks that UV seams and hard
+// normal edges survive, that every remapped index points at a vertex within epsilon of the original one, and that
+// the result matches a brute force weld on the serial and the pooled path. Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	bool IsNear(float A, float B, float Epsilon)
+	{
+		return std::fabs(A - B) <= Epsilon;
+	}
+
+	bool IsWithinEpsilons(const TVertex& A, const TVertex& B, const TVertexWeldSettings& Settings)
+	{
+		return IsNear(A.Position.x, B.Position.x, Settings.PositionEpsilon)
+			&& IsNear(A.Position.y, B.Position.y, Settings.PositionEpsilon)
+			&& IsNear(A.Position.z, B.Position.z, Settings.PositionEpsilon)
+			&& IsNear(A.Normal.x, B.Normal.x, Settings.NormalEpsilon)
+			&& IsNear(A.Normal.y, B.Normal.y, Settings.NormalEpsilon)
+			&& IsNear(A.Normal.z, B.Normal.z, Settings.NormalEpsilon)
+			&& IsNear(A.TangentU.x, B.TangentU.x, Settings.NormalEpsilon)
+			&& IsNear(A.TangentU.y, B.TangentU.y, Settings.NormalEpsilon)
+			&& IsNear(A.TangentU.z, B.TangentU.z, Settings.NormalEpsilon)
+			&& IsNear(A.TexC.x, B.TexC.x, Settings.UVEpsilon)
+			&& IsNear(A.TexC.y, B.TexC.y, Settings.UVEpsilon);
+	}
+
+	bool IsSameVertex(const TVertex& A, const TVertex& B)
+	{
+		return A.Position.x == B.Position.x && A.Position.y == B.Position.y && A.Position.z == B.Position.z
+			&& A.Normal.x == B.Normal.x && A.Normal.y == B.Normal.y && A.Normal.z == B.Normal.z
+			&& A.TangentU.x == B.TangentU.x && A.TangentU.y == B.TangentU.y && A.TangentU.z == B.TangentU.z
+			&& A.TexC.x == B.TexC.x && A.TexC.y == B.TexC.y;
+	}
+
+	// Flat grid of Size x Size quads in the XZ plane, every quad with its own four vertices. Corners are moved by up to
+	// Jitter on every axis, Offset shifts the grid so corners can land on the welder's cell boundaries.
+	void MakeQuadGrid(uint32_t Size, float Spacing, float Jitter, float Offset, uint32_t Seed,
+		std::vector<TVertex>& OutVertices, std::vector<uint32_t>& OutIndices)
+	{
+		std::mt19937 Random(Seed);
+		std::uniform_real_distribution<float> Uniform(-Jitter, Jitter);
+
+		OutVertices.clear();
+		OutIndices.clear();
+
+		for (uint32_t z = 0; z < Size; z++)
+		{
+			for (uint32_t x = 0; x < Size; x++)
+			{
+				const uint32_t Base = (uint32_t)OutVertices.size();
+				for (uint32_t Corner = 0; Corner < 4; Corner++)
+				{
+					const uint32_t CornerX = x + (Corner & 1);
+					const uint32_t CornerZ = z + (Corner >> 1);
+					const float U = (float)CornerX / Size;
+					const float V = (float)CornerZ / Size;
+
+					OutVertices.push_back(TVertex(Offset + CornerX * Spacing + Uniform(Random), Offset + Uniform(Random),
+						Offset + CornerZ * Spacing + Uniform(Random), 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, U, V));
+				}
+
+				const uint32_t QuadIndices[6] = { 0, 2, 1, 1, 2, 3 };
+				for (uint32_t Index : QuadIndices)
+				{
+					OutIndices.push_back(Base + Index);
+				}
+			}
+		}
+	}
+
+	// Every index still points at a vertex within epsilon of the one it pointed at before the weld
+	bool IsRemapValid(const std::vector<TVertex>& Before, const std::vector<uint32_t>& IndicesBefore,
+		const std::vector<TVertex>& After, const std::vector<uint32_t>& IndicesAfter, const TVertexWeldSettings& Settings)
+	{
+		if (IndicesBefore.size() != IndicesAfter.size())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < IndicesAfter.size(); i++)
+		{
+			if (IndicesAfter[i] >= After.size() || !IsWithinEpsilons(Before[IndicesBefore[i]], After[IndicesAfter[i]], Settings))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// O(n^2) reference: every vertex welds to the first earlier vertex within the epsilons, chains resolve to their first
+	void BruteForceWeld(std::vector<TVertex>& Vertices, std::vector<uint32_t>& Indices, const TVertexWeldSettings& Settings)
+	{
+		std::vector<uint32_t> Remap(Vertices.size());
+		for (uint32_t i = 0; i < Vertices.size(); i++)
+		{
+			Remap[i] = i;
+			for (uint32_t j = 0; j < i; j++)
+			{
+				if (IsWithinEpsilons(Vertices[i], Vertices[j], Settings))
+				{
+					Remap[i] = Remap[j];
+					break;
+				}
+			}
+		}
+
+		std::vector<uint32_t> NewIndex(Vertices.size());
+		uint32_t WriteIndex = 0;
+		for (uint32_t i = 0; i < Vertices.size(); i++)
+		{
+			if (Remap[i] == i)
+			{
+				NewIndex[i] = WriteIndex;
+				Vertices[WriteIndex++] = Vertices[i];
+			}
+			else
+			{
+				NewIndex[i] = NewIndex[Remap[i]];
+			}
+		}
+		Vertices.resize(WriteIndex);
+
+		for (uint32_t& Index : Indices)
+		{
+			Index = NewIndex[Index];
+		}
+	}
+
+	bool IsSameMesh(const std::vector<TVertex>& VerticesA, const std::vector<uint32_t>& IndicesA,
+		const std::vector<TVertex>& VerticesB, const std::vector<uint32_t>& IndicesB)
+	{
+		if (VerticesA.size() != VerticesB.size() || IndicesA != IndicesB)
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < VerticesA.size(); i++)
+		{
+			if (!IsSameVertex(VerticesA[i], VerticesB[i]))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void TestEpsilon(TThreadPool& ThreadPool)
+	{
+		TVertexWeldSettings Settings;
+		const uint32_t Size = 32;
+		const uint32_t GridVertexCount = (Size + 1) * (Size + 1);
+
+		// Copies of a corner differ by up to twice the jitter, a little under half the epsilon leaves room for rounding
+		std::vector<TVertex> Vertices;
+		std::vector<uint32_t> Indices;
+		MakeQuadGrid(Size, 0.1f, Settings.PositionEpsilon * 0.4f, 0.0f, 1, Vertices, Indices);
+		const std::vector<TVertex> Before = Vertices;
+		const std::vector<uint32_t> IndicesBefore = Indices;
+
+		TVertexWeldStats Stats = WeldVertices(Vertices, Indices, Settings, ThreadPool);
+		printf("Within epsilon: %u -> %u vertices\n", Stats.VertexCountBefore, Stats.VertexCountAfter);
+
+		Check(Stats.VertexCountBefore == Size * Size * 4, "epsilon: the stats count the input vertices");
+		Check(Stats.VertexCountAfter == GridVertexCount && Vertices.size() == GridVertexCount, "epsilon: jittered copies within epsilon weld into one grid vertex");
+		Check(IsRemapValid(Before, IndicesBefore, Vertices, Indices, Settings), "epsilon: remapped indices point at a vertex within epsilon");
+
+		// First occurrences are kept in input order, the first quad's corners stay the first vertices
+		bool bFirstKept = true;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			bFirstKept &= IsSameVertex(Vertices[i], Before[i]);
+		}
+		Check(bFirstKept, "epsilon: the first occurrence of a vertex is kept in input order");
+
+		// Every quad is lifted 1.5 epsilons above the previous one, the copies of a corner no longer weld
+		MakeQuadGrid(Size, 0.1f, 0.0f, 0.0f, 1, Vertices, Indices);
+		for (size_t i = 0; i < Vertices.size(); i++)
+		{
+			Vertices[i].Position.y = (float)(i / 4) * Settings.PositionEpsilon * 1.5f;
+		}
+		Stats = WeldVertices(Vertices, Indices, Settings, ThreadPool);
+		Check(Stats.VertexCountAfter == Stats.VertexCountBefore, "epsilon: copies further apart than the epsilon stay apart");
+
+		// Corners on the quarter cell boundaries of the welder's grid, cells are four epsilons wide
+		MakeQuadGrid(Size, Settings.PositionEpsilon * 3.0f, Settings.PositionEpsilon * 0.5f, Settings.PositionEpsilon, 2, Vertices, Indices);
+		std::vector<TVertex> Reference = Vertices;
+		std::vector<uint32_t> ReferenceIndices = Indices;
+		BruteForceWeld(Reference, ReferenceIndices, Settings);
+		WeldVertices(Vertices, Indices, Settings, ThreadPool);
+		Check(IsSameMesh(Vertices, Indices, Reference, ReferenceIndices), "epsilon: vertices across cell boundaries match the brute force weld");
+	}
+
+	void TestSeams(TThreadPool& ThreadPool)
+	{
+		TVertexWeldSettings Settings;
+
+		// A cube with a hard normal and its own UVs on every face, the 24 face vertices share 8 positions
+		std::vector<TVertex> Vertices;
+		std::vector<uint32_t> Indices;
+		for (uint32_t Face = 0; Face < 6; Face++)
+		{
+			const uint32_t Axis = Face / 2;
+			const float Sign = (Face & 1) ? -1.0f : 1.0f;
+
+			// Each face is drawn twice, the copies weld and the faces don't
+			for (uint32_t Copy = 0; Copy < 2; Copy++)
+			{
+				const uint32_t Base = (uint32_t)Vertices.size();
+				for (uint32_t Corner = 0; Corner < 4; Corner++)
+				{
+					float Position[3];
+					Position[Axis] = Sign;
+					Position[(Axis + 1) % 3] = (Corner & 1) ? 1.0f : -1.0f;
+					Position[(Axis + 2) % 3] = (Corner & 2) ? 1.0f : -1.0f;
+
+					float Normal[3] = { 0.0f, 0.0f, 0.0f };
+					Normal[Axis] = Sign;
+
+					Vertices.push_back(TVertex(Position[0], Position[1], Position[2], Normal[0], Normal[1], Normal[2],
+						Normal[1], Normal[2], Normal[0], (float)(Corner & 1), (float)(Corner >> 1)));
+				}
+
+				const uint32_t QuadIndices[6] = { 0, 1, 2, 2, 1, 3 };
+				for (uint32_t Index : QuadIndices)
+				{
+					Indices.push_back(Base + Index);
+				}
+			}
+		}
+
+		const std::vector<TVertex> Before = Vertices;
+		const std::vector<uint32_t> IndicesBefore = Indices;
+		TVertexWeldStats Stats = WeldVertices(Vertices, Indices, Settings, ThreadPool);
+		printf("Hard edged cube: %u -> %u vertices\n", Stats.VertexCountBefore, Stats.VertexCountAfter);
+
+		Check(Stats.VertexCountAfter == 24, "seams: hard normal edges keep a vertex per face");
+		Check(IsRemapValid(Before, IndicesBefore, Vertices, Indices, Settings), "seams: remapped indices keep their face normal");
+
+		// Same positions and normals, a UV seam runs through the middle of the strip
+		Vertices.clear();
+		Indices.clear();
+		for (uint32_t Side = 0; Side < 2; Side++)
+		{
+			for (uint32_t i = 0; i < 8; i++)
+			{
+				const float U = (Side == 0) ? 1.0f : 0.0f;
+				Vertices.push_back(TVertex((float)(i / 2), (float)(i % 2), 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, U, (float)(i % 2)));
+			}
+		}
+		for (uint32_t i = 0; i + 2 < Vertices.size(); i++)
+		{
+			Indices.push_back(i);
+			Indices.push_back(i + 1);
+			Indices.push_back(i + 2);
+		}
+
+		Stats = WeldVertices(Vertices, Indices, Settings, ThreadPool);
+		bool bSeamKept = true;
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			bSeamKept &= Vertices[i].TexC.x == 1.0f && Vertices[8 + i].TexC.x == 0.0f;
+		}
+		Check(Stats.VertexCountAfter == 16 && bSeamKept, "seams: a UV seam keeps both sides");
+
+		// UVs within the UV epsilon do weld
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			Vertices[8 + i].TexC.x = 1.0f + Settings.UVEpsilon * 0.5f;
+		}
+		Stats = WeldVertices(Vertices, Indices, Settings, ThreadPool);
+		Check(Stats.VertexCountAfter == 8, "seams: UVs within the UV epsilon weld");
+	}
+
+	void TestRemap(TThreadPool& ThreadPool)
+	{
+		// Vertices in clusters tighter than the epsilon scattered in random order, with random indices into them
+		TVertexWeldSettings Settings;
+		Settings.PositionEpsilon = 1e-3f;
+
+		std::mt19937 Random(5);
+		std::uniform_real_distribution<float> Uniform(0.0f, 1.0f);
+		std::uniform_real_distribution<float> Jitter(-Settings.PositionEpsilon * 0.4f, Settings.PositionEpsilon * 0.4f);
+
+		std::vector<TVertex> Centers(500);
+		for (TVertex& Center : Centers)
+		{
+			Center = TVertex(Uniform(Random), Uniform(Random), Uniform(Random), 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+		}
+
+		std::vector<TVertex> Vertices(4000);
+		for (TVertex& Vertex : Vertices)
+		{
+			Vertex = Centers[Random() % Centers.size()];
+			Vertex.Position.x += Jitter(Random);
+			Vertex.Position.y += Jitter(Random);
+			Vertex.Position.z += Jitter(Random);
+		}
+
+		std::vector<uint32_t> Indices(12000);
+		for (uint32_t& Index : Indices)
+		{
+			Index = Random() % Vertices.size();
+		}
+
+		std::vector<TVertex> Reference = Vertices;
+		std::vector<uint32_t> ReferenceIndices = Indices;
+		BruteForceWeld(Reference, ReferenceIndices, Settings);
+
+		const std::vector<TVertex> Before = Vertices;
+		const std::vector<uint32_t> IndicesBefore = Indices;
+		const TVertexWeldStats Stats = WeldVertices(Vertices, Indices, Settings, ThreadPool);
+		printf("Random clusters: %u -> %u vertices (%zu by brute force)\n", Stats.VertexCountBefore, Stats.VertexCountAfter, Reference.size());
+
+		Check(IsSameMesh(Vertices, Indices, Reference, ReferenceIndices), "remap: matches the brute force weld");
+		Check(IsRemapValid(Before, IndicesBefore, Vertices, Indices, Settings), "remap: every index points at a vertex within epsilon");
+	}
+
+	void TestParallel()
+	{
+		// Its own pool, so the pooled path runs on machines with a single core too
+		TThreadPool ThreadPool(4);
+		TVertexWeldSettings Settings;
+
+		std::vector<TVertex> Vertices;
+		std::vector<uint32_t> Indices;
+		MakeQuadGrid(256, 0.01f, Settings.PositionEpsilon * 0.4f, 0.0f, 3, Vertices, Indices);
+		std::vector<TVertex> SerialVertices = Vertices;
+		std::vector<uint32_t> SerialIndices = Indices;
+
+		Settings.ParallelThreshold = 0xFFFFFFFF;
+		auto StartTime = std::chrono::steady_clock::now();
+		WeldVertices(SerialVertices, SerialIndices, Settings, ThreadPool);
+		const double SerialSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+		Settings.ParallelThreshold = 0;
+		StartTime = std::chrono::steady_clock::now();
+		const TVertexWeldStats Stats = WeldVertices(Vertices, Indices, Settings, ThreadPool);
+		const double ParallelSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+		printf("256x256 quads: %u -> %u vertices, serial %.1f ms, %u threads %.1f ms\n", Stats.VertexCountBefore,
+			Stats.VertexCountAfter, SerialSeconds * 1000.0, ThreadPool.GetThreadCount(), ParallelSeconds * 1000.0);
+
+		Check(Stats.VertexCountAfter == 257 * 257, "parallel: the large grid welds fully");
+		Check(IsSameMesh(Vertices, Indices, SerialVertices, SerialIndices), "parallel: the pooled weld matches the serial one");
+	}
+}
+
+int main()
+{
+	TThreadPool ThreadPool;
+
+	TestEpsilon(ThreadPool);
+	TestSeams(ThreadPool);
+	TestRemap(ThreadPool);
+	TestParallel();
+
+	printf("%s\n", FailureCount == 0 ? "All vertex welder checks passed" : "Vertex welder checks FAILED");
+
+	return FailureCount;
+}
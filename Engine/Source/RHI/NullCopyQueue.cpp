@@ -0,0 +1,36 @@
+#include "NullCopyQueue.h"
+#include <cassert>
+#include <algorithm>
+
+void TNullCopyQueue::RecordUpload(uint64_t RequestId, uint64_t StagingOffset)
+{
+	assert(StagingOffset == DedicatedStagingOffset || StagingOffset < StagingRingSize);
+
+	if (bSubmitted)
+	{
+		RecordedUploads.clear();
+		bSubmitted = false;
+	}
+
+	RecordedUploads.push_back({ RequestId, StagingOffset });
+}
+
+uint64_t TNullCopyQueue::Submit()
+{
+	bSubmitted = true;
+	SubmitCount++;
+
+	return ++SubmittedFenceValue;
+}
+
+void TNullCopyQueue::WaitForFenceValue(uint64_t FenceValue)
+{
+	assert(FenceValue <= SubmittedFenceValue);
+
+	CompleteFenceValue(FenceValue);
+}
+
+void TNullCopyQueue::CompleteFenceValue(uint64_t FenceValue)
+{
+	CompletedFenceValue = std::max(CompletedFenceValue, std::min(FenceValue, SubmittedFenceValue));
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "RHI.h"
+#include <vector>
+
+// Copy queue without a device, fences only complete when told to.
+// Lets the upload queue's scheduling be driven step by step.
+class TNullCopyQueue : public TRHICopyQueue
+{
+public:
+	TNullCopyQueue(uint64_t InStagingRingSize)
+		:StagingRingSize(InStagingRingSize)
+	{}
+
+	virtual ~TNullCopyQueue() {}
+
+public:
+	virtual uint64_t GetStagingRingSize() const override { return StagingRingSize; }
+
+	virtual void RecordUpload(uint64_t RequestId, uint64_t StagingOffset) override;
+
+	virtual uint64_t Submit() override;
+
+	virtual uint64_t GetCompletedFenceValue() override { return CompletedFenceValue; }
+
+	virtual void WaitForFenceValue(uint64_t FenceValue) override;
+
+public:
+	// Complete submissions up to FenceValue, as if the GPU had caught up
+	void CompleteFenceValue(uint64_t FenceValue);
+
+	void CompleteAll() { CompleteFenceValue(SubmittedFenceValue); }
+
+	uint64_t GetSubmittedFenceValue() const { return SubmittedFenceValue; }
+
+	// (RequestId, StagingOffset) of uploads recorded since the last Submit
+	const std::vector<std::pair<uint64_t, uint64_t>>& GetRecordedUploads() const { return RecordedUploads; }
+
+	uint32_t GetSubmitCount() const { return SubmitCount; }
+
+private:
+	uint64_t StagingRingSize = 0;
+
+	uint64_t SubmittedFenceValue = 0;
+
+	uint64_t CompletedFenceValue = 0;
+
+	uint32_t SubmitCount = 0;
+
+	std::vector<std::pair<uint64_t, uint64_t>> RecordedUploads;
+
+	bool bSubmitted = false;
+};
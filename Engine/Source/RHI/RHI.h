@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+// Dedicated copy queue with a staging ring, used by TTextureUploadQueue.
+// The queue decides what gets uploaded when, the backend only moves bytes.
+// This is the only part of the renderer behind an interface, TRender still talks to TD3D12RHI directly.
+class TRHICopyQueue
+{
+public:
+	virtual ~TRHICopyQueue() {}
+
+	// Request does not fit in the ring, backend must use its own staging memory
+	// and keep it alive until the submission's fence completes
+	static constexpr uint64_t DedicatedStagingOffset = ~0ull;
+
+public:
+	virtual uint64_t GetStagingRingSize() const = 0;
+
+	// Write the request's data into the staging ring at StagingOffset and record its copy commands
+	virtual void RecordUpload(uint64_t RequestId, uint64_t StagingOffset) = 0;
+
+	// Close and execute recorded copies, returns the fence value signaled when they complete
+	virtual uint64_t Submit() = 0;
+
+	virtual uint64_t GetCompletedFenceValue() = 0;
+
+	virtual void WaitForFenceValue(uint64_t FenceValue) = 0;
+};
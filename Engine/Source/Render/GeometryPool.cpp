@@ -0,0 +1,174 @@
+#include "GeometryPool.h"
+#include "Mesh/Vertex.h"
+#include "Mesh/VertexQuantization.h"
+#include "Utils/Logger.h"
+#include <algorithm>
+
+TGeometryPool::TGeometryPool(TD3D12RHI* InD3D12RHI)
+	:D3D12RHI(InD3D12RHI)
+{
+	Arenas[(size_t)EGeometryArena::Vertices].Strides = { sizeof(TVertex) };
+	Arenas[(size_t)EGeometryArena::CompactVertices].Strides = { sizeof(TCompactPosition), sizeof(TCompactAttributes) };
+
+	Arenas[(size_t)EGeometryArena::Indices16].Strides = { sizeof(std::uint16_t) };
+	Arenas[(size_t)EGeometryArena::Indices16].IndexFormat = DXGI_FORMAT_R16_UINT;
+
+	Arenas[(size_t)EGeometryArena::Indices32].Strides = { sizeof(std::uint32_t) };
+	Arenas[(size_t)EGeometryArena::Indices32].IndexFormat = DXGI_FORMAT_R32_UINT;
+}
+
+bool TGeometryPool::AllocateVertices(EGeometryArena Arena, UINT VertexCount, const std::vector<const void*>& StreamData, TOffsetAllocation& OutAllocation)
+{
+	TArena& VertexArena = Arenas[(size_t)Arena];
+	assert(VertexArena.IndexFormat == DXGI_FORMAT_UNKNOWN && StreamData.size() == VertexArena.Strides.size());
+
+	if (!Allocate(Arena, VertexCount, OutAllocation))
+	{
+		return false;
+	}
+
+	for (size_t Stream = 0; Stream < VertexArena.Strides.size(); Stream++)
+	{
+		const UINT Stride = VertexArena.Strides[Stream];
+		D3D12RHI->UpdateBufferRegion(VertexArena.VertexBuffers[Stream].get(), OutAllocation.Offset * Stride, StreamData[Stream], VertexCount * Stride);
+	}
+
+	return true;
+}
+
+bool TGeometryPool::AllocateIndices(EGeometryArena Arena, UINT IndexCount, const void* Data, TOffsetAllocation& OutAllocation)
+{
+	TArena& IndexArena = Arenas[(size_t)Arena];
+	assert(IndexArena.IndexFormat != DXGI_FORMAT_UNKNOWN);
+
+	if (!Allocate(Arena, IndexCount, OutAllocation))
+	{
+		return false;
+	}
+
+	const UINT Stride = IndexArena.Strides[0];
+	D3D12RHI->UpdateBufferRegion(IndexArena.IndexBuffer.get(), OutAllocation.Offset * Stride, Data, IndexCount * Stride);
+
+	return true;
+}
+
+void TGeometryPool::Free(EGeometryArena Arena, const TOffsetAllocation& Allocation)
+{
+	Arenas[(size_t)Arena].Allocator.Free(Allocation);
+}
+
+void TGeometryPool::SetVertexBuffers(EGeometryArena Arena, UINT StreamCount)
+{
+	TArena& VertexArena = Arenas[(size_t)Arena];
+
+	const UINT Capacity = VertexArena.Allocator.GetCapacity();
+	for (UINT Stream = 0; Stream < StreamCount && Stream < (UINT)VertexArena.VertexBuffers.size(); Stream++)
+	{
+		const UINT Stride = VertexArena.Strides[Stream];
+		D3D12RHI->SetVertexBuffer(VertexArena.VertexBuffers[Stream], 0, Stride, Capacity * Stride, Stream);
+	}
+}
+
+void TGeometryPool::SetIndexBuffer(EGeometryArena Arena)
+{
+	TArena& IndexArena = Arenas[(size_t)Arena];
+
+	if (IndexArena.IndexBuffer)
+	{
+		D3D12RHI->SetIndexBuffer(IndexArena.IndexBuffer, 0, IndexArena.IndexFormat, IndexArena.Allocator.GetCapacity() * IndexArena.Strides[0]);
+	}
+}
+
+void TGeometryPool::ReleaseRetiredBuffers()
+{
+	RetiredBuffers.clear();
+}
+
+bool TGeometryPool::Allocate(EGeometryArena Arena, UINT Count, TOffsetAllocation& OutAllocation)
+{
+	TOffsetAllocator& Allocator = Arenas[(size_t)Arena].Allocator;
+
+	// Alignment 1 keeps every element reachable through BaseVertexLocation/StartIndexLocation
+	if (Allocator.Allocate(Count, 1, OutAllocation))
+	{
+		return true;
+	}
+
+	Grow(Arena, Allocator.GetUsedSize() + Count);
+
+	return Allocator.Allocate(Count, 1, OutAllocation);
+}
+
+void TGeometryPool::Grow(EGeometryArena ArenaType, UINT MinCapacity)
+{
+	TArena& Arena = Arenas[(size_t)ArenaType];
+
+	const UINT OldCapacity = Arena.Allocator.GetCapacity();
+	const UINT NewCapacity = std::max<UINT>(std::max<UINT>(InitialCapacity, OldCapacity * 2), MinCapacity);
+
+	// Fragmentation is fixed while copying into the new buffers
+	std::vector<TOffsetMove> Moves;
+	Arena.Allocator.Defragment(Moves);
+	Arena.Allocator.Grow(NewCapacity);
+
+	// Allocations are packed in offset order with alignment 1, so everything before the first move kept its offset
+	const UINT KeptSize = Moves.empty() ? OldCapacity : Moves[0].NewOffset;
+
+	const bool bIndexArena = Arena.IndexFormat != DXGI_FORMAT_UNKNOWN;
+	for (size_t Stream = 0; Stream < Arena.Strides.size(); Stream++)
+	{
+		const UINT Stride = Arena.Strides[Stream];
+
+		std::shared_ptr<TD3D12Buffer> OldBuffer;
+		std::shared_ptr<TD3D12Buffer> NewBuffer;
+		if (bIndexArena)
+		{
+			OldBuffer = Arena.IndexBuffer;
+			Arena.IndexBuffer = D3D12RHI->CreateIndexBuffer(NewCapacity * Stride);
+			NewBuffer = Arena.IndexBuffer;
+		}
+		else
+		{
+			if (Arena.VertexBuffers.size() <= Stream)
+			{
+				Arena.VertexBuffers.resize(Stream + 1);
+			}
+
+			OldBuffer = Arena.VertexBuffers[Stream];
+			Arena.VertexBuffers[Stream] = D3D12RHI->CreateVertexBuffer(NewCapacity * Stride);
+			NewBuffer = Arena.VertexBuffers[Stream];
+		}
+
+		if (!OldBuffer)
+		{
+			continue;
+		}
+
+		TD3D12Resource* OldResource = OldBuffer->GetResource();
+		TD3D12Resource* NewResource = NewBuffer->GetResource();
+		D3D12RHI->TransitionResource(OldResource, D3D12_RESOURCE_STATE_COPY_SOURCE);
+		D3D12RHI->TransitionResource(NewResource, D3D12_RESOURCE_STATE_COPY_DEST);
+
+		if (KeptSize > 0)
+		{
+			D3D12RHI->CopyBufferRegion(NewResource, 0, OldResource, 0, (UINT64)KeptSize * Stride);
+		}
+
+		for (const TOffsetMove& Move : Moves)
+		{
+			D3D12RHI->CopyBufferRegion(NewResource, (UINT64)Move.NewOffset * Stride, OldResource, (UINT64)Move.OldOffset * Stride, (UINT64)Move.Size * Stride);
+		}
+
+		// The copies are still pending on the command list
+		RetiredBuffers.push_back(OldBuffer);
+	}
+
+	char Log[256];
+	sprintf_s(Log, "Geometry pool arena %d: %u -> %u elements, %zu allocations moved\n", (int)ArenaType, OldCapacity, NewCapacity, Moves.size());
+	TLogger::LogToOutput(Log);
+
+	if (!Moves.empty() && RelocateCallback)
+	{
+		RelocateCallback(ArenaType, Moves);
+	}
+}
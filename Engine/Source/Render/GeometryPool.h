@@ -0,0 +1,84 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "D3D12/D3D12RHI.h"
+#include "Utils/OffsetAllocator.h"
+
+// One arena per vertex layout and index format. Streams of a vertex arena share one allocator,
+// so a single BaseVertexLocation addresses the position and attribute streams of compact meshes.
+enum class EGeometryArena
+{
+	Vertices,
+	CompactVertices,
+	Indices16,
+	Indices32,
+	Count,
+};
+
+// Shared vertex and index buffers for every static mesh. Arenas are bound once at offset 0 and
+// draws add the allocation offset to BaseVertexLocation/StartIndexLocation, so consecutive draws
+// of different meshes need no new IASetVertexBuffers/IASetIndexBuffer.
+class TGeometryPool
+{
+public:
+	// Called after a full arena was packed into a larger buffer, owners must apply the moves to their allocations
+	typedef std::function<void(EGeometryArena Arena, const std::vector<TOffsetMove>& Moves)> TRelocateCallback;
+
+public:
+	TGeometryPool(TD3D12RHI* InD3D12RHI);
+
+	// StreamData holds one pointer per stream of the arena, VertexCount elements each
+	bool AllocateVertices(EGeometryArena Arena, UINT VertexCount, const std::vector<const void*>& StreamData, TOffsetAllocation& OutAllocation);
+
+	bool AllocateIndices(EGeometryArena Arena, UINT IndexCount, const void* Data, TOffsetAllocation& OutAllocation);
+
+	void Free(EGeometryArena Arena, const TOffsetAllocation& Allocation);
+
+	// Binds the first StreamCount streams of a vertex arena from slot 0
+	void SetVertexBuffers(EGeometryArena Arena, UINT StreamCount);
+
+	void SetIndexBuffer(EGeometryArena Arena);
+
+	void SetRelocateCallback(TRelocateCallback Callback) { RelocateCallback = Callback; }
+
+	// Buffers replaced by a grow, call once the GPU has finished the frame that copied from them
+	void ReleaseRetiredBuffers();
+
+	UINT GetUsedSize(EGeometryArena Arena) const { return Arenas[(size_t)Arena].Allocator.GetUsedSize(); }
+
+	UINT GetCapacity(EGeometryArena Arena) const { return Arenas[(size_t)Arena].Allocator.GetCapacity(); }
+
+private:
+	struct TArena
+	{
+		// Byte stride of each stream, index arenas have one stream
+		std::vector<UINT> Strides;
+
+		std::vector<TD3D12VertexBufferRef> VertexBuffers;
+
+		TD3D12IndexBufferRef IndexBuffer;
+
+		DXGI_FORMAT IndexFormat = DXGI_FORMAT_UNKNOWN;
+
+		// In vertices or indices
+		TOffsetAllocator Allocator;
+	};
+
+	bool Allocate(EGeometryArena Arena, UINT Count, TOffsetAllocation& OutAllocation);
+
+	// Packs live allocations into new buffers with room for at least MinCapacity elements
+	void Grow(EGeometryArena Arena, UINT MinCapacity);
+
+private:
+	TD3D12RHI* D3D12RHI = nullptr;
+
+	TArena Arenas[(size_t)EGeometryArena::Count];
+
+	std::vector<std::shared_ptr<TD3D12Buffer>> RetiredBuffers;
+
+	TRelocateCallback RelocateCallback;
+
+	// Initial arena size in elements, arenas at least double on every grow
+	const UINT InitialCapacity = 256 * 1024;
+};
@@ -0,0 +1,444 @@
+#include "GlobalDistanceField.h"
+#include "Mesh/MeshSDFLayout.h"
+#include "Mesh/SDFBrickAtlas.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	struct TWorldBounds
+	{
+		float Min[3];
+
+		float Max[3];
+	};
+
+	// Merge a level's dirty regions into their bounds past this count, overlapping regions would be composed twice
+	const size_t MaxDirtyRegionsPerLevel = 16;
+
+	void TransformPoint(const float Matrix[4][3], const float Point[3], float OutPoint[3])
+	{
+		for (int Column = 0; Column < 3; Column++)
+		{
+			OutPoint[Column] = Point[0] * Matrix[0][Column] + Point[1] * Matrix[1][Column] + Point[2] * Matrix[2][Column] + Matrix[3][Column];
+		}
+	}
+
+	bool IsSameObject(const TGlobalSDFObject& A, const TGlobalSDFObject& B)
+	{
+		return std::memcmp(A.LocalToWorld, B.LocalToWorld, sizeof(A.LocalToWorld)) == 0 && std::memcmp(A.Extent, B.Extent, sizeof(A.Extent)) == 0
+			&& std::memcmp(A.Resolution, B.Resolution, sizeof(A.Resolution)) == 0 && A.BrickIndirection == B.BrickIndirection;
+	}
+
+	float DistanceToBounds(const float Position[3], const float BoundsMin[3], const float BoundsMax[3])
+	{
+		float SquaredDistance = 0.0f;
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			float Outside = std::max<float>(std::max<float>(BoundsMin[Axis] - Position[Axis], Position[Axis] - BoundsMax[Axis]), 0.0f);
+			SquaredDistance += Outside * Outside;
+		}
+
+		return std::sqrt(SquaredDistance);
+	}
+
+	int FloorDiv(int Value, int Divisor)
+	{
+		return (Value >= 0) ? Value / Divisor : -((-Value + Divisor - 1) / Divisor);
+	}
+
+	float ObjectDistance(const TGlobalSDFObject& Object, float LocalToWorldScale, const TSDFBrickAtlas& Atlas, const float Position[3])
+	{
+		float LocalPosition[3];
+		TransformPoint(Object.WorldToLocal, Position, LocalPosition);
+
+		float ClampedPosition[3];
+		float VolumeUV[3];
+		float SquaredBoxDistance = 0.0f;
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			ClampedPosition[Axis] = std::clamp(LocalPosition[Axis], -Object.Extent[Axis], Object.Extent[Axis]);
+			VolumeUV[Axis] = ClampedPosition[Axis] / Object.Extent[Axis] * 0.5f + 0.5f;
+
+			float Offset = LocalPosition[Axis] - ClampedPosition[Axis];
+			SquaredBoxDistance += Offset * Offset;
+		}
+
+		// Same decode as SampleMeshDistanceField, R8 [0, 1] spans [-Band, Band] voxels
+		float VoxelSize = 2.0f * Object.Extent[0] / Object.Resolution[0];
+		float DistanceRange = MeshSDFDistanceBandVoxels * VoxelSize;
+		float DistanceField = (SampleSparseMeshSDF(Atlas, *Object.BrickIndirection, Object.Resolution, VolumeUV) - 0.5f) * 2.0f * DistanceRange;
+
+		float BoxDistance = std::sqrt(SquaredBoxDistance);
+		float LocalDistance = (BoxDistance > 0.0f) ? std::max<float>(BoxDistance, DistanceField - BoxDistance) : DistanceField;
+
+		return LocalDistance * LocalToWorldScale;
+	}
+}
+
+int64_t TGlobalSDFBox::GetVoxelCount() const
+{
+	return IsEmpty() ? 0 : (int64_t)(Max[0] - Min[0]) * (Max[1] - Min[1]) * (Max[2] - Min[2]);
+}
+
+float ComputeObjectLocalToWorldScale(const TGlobalSDFObject& Object)
+{
+	float MinScale = 1e30f;
+	for (int Row = 0; Row < 3; Row++)
+	{
+		const float* Axis = Object.LocalToWorld[Row];
+		MinScale = std::min<float>(MinScale, std::sqrt(Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2]));
+	}
+
+	return MinScale;
+}
+
+void ComputeObjectWorldBounds(const TGlobalSDFObject& Object, float OutMin[3], float OutMax[3])
+{
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		OutMin[Axis] = 1e30f;
+		OutMax[Axis] = -1e30f;
+	}
+
+	for (int Corner = 0; Corner < 8; Corner++)
+	{
+		const float LocalCorner[3] = {
+			(Corner & 1) ? Object.Extent[0] : -Object.Extent[0],
+			(Corner & 2) ? Object.Extent[1] : -Object.Extent[1],
+			(Corner & 4) ? Object.Extent[2] : -Object.Extent[2] };
+
+		float WorldCorner[3];
+		TransformPoint(Object.LocalToWorld, LocalCorner, WorldCorner);
+
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			OutMin[Axis] = std::min<float>(OutMin[Axis], WorldCorner[Axis]);
+			OutMax[Axis] = std::max<float>(OutMax[Axis], WorldCorner[Axis]);
+		}
+	}
+}
+
+float ComputeObjectDistance(const TGlobalSDFObject& Object, const TSDFBrickAtlas& Atlas, const float Position[3])
+{
+	return ObjectDistance(Object, ComputeObjectLocalToWorldScale(Object), Atlas, Position);
+}
+
+TGlobalDistanceField::TGlobalDistanceField(const TGlobalSDFSettings& InSettings)
+	:Settings(InSettings)
+{
+	const size_t TexelCount = (size_t)Settings.Resolution * Settings.Resolution * Settings.Resolution;
+
+	for (int LevelIndex = 0; LevelIndex < GlobalSDFLevelCount; LevelIndex++)
+	{
+		TGlobalSDFLevel& Level = Levels[LevelIndex];
+		Level.VoxelSize = Settings.Level0VoxelSize * (float)(1 << LevelIndex);
+		Level.Data.resize(TexelCount, 255);
+	}
+}
+
+void TGlobalDistanceField::Invalidate()
+{
+	for (TGlobalSDFLevel& Level : Levels)
+	{
+		Level.bInitialized = false;
+	}
+}
+
+size_t TGlobalDistanceField::GetTexelIndex(int X, int Y, int Z) const
+{
+	const int Resolution = Settings.Resolution;
+
+	X = ((X % Resolution) + Resolution) % Resolution;
+	Y = ((Y % Resolution) + Resolution) % Resolution;
+	Z = ((Z % Resolution) + Resolution) % Resolution;
+
+	return ((size_t)Z * Resolution + Y) * Resolution + X;
+}
+
+void TGlobalDistanceField::ScrollLevel(int LevelIndex, const float ViewPosition[3])
+{
+	TGlobalSDFLevel& Level = Levels[LevelIndex];
+	const int Resolution = Settings.Resolution;
+	const int Snap = std::max<int>(Settings.ScrollSnapVoxels, 1);
+
+	TGlobalSDFBox OldWindow;
+	TGlobalSDFBox NewWindow;
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		int CenterVoxel = (int)std::floor(ViewPosition[Axis] / Level.VoxelSize);
+		int NewOrigin = FloorDiv(CenterVoxel - Resolution / 2, Snap) * Snap;
+
+		OldWindow.Min[Axis] = Level.Origin[Axis];
+		OldWindow.Max[Axis] = Level.Origin[Axis] + Resolution;
+		NewWindow.Min[Axis] = NewOrigin;
+		NewWindow.Max[Axis] = NewOrigin + Resolution;
+
+		Level.Origin[Axis] = NewOrigin;
+	}
+
+	if (!Level.bInitialized)
+	{
+		Level.UpdatedRegions.push_back(NewWindow);
+		Level.bInitialized = true;
+
+		return;
+	}
+
+	// Cut the part of the new window outside the old one into at most six slabs, what is left is the overlap
+	TGlobalSDFBox Remaining = NewWindow;
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		if (OldWindow.Min[Axis] > Remaining.Min[Axis])
+		{
+			TGlobalSDFBox Slab = Remaining;
+			Slab.Max[Axis] = std::min<int>(OldWindow.Min[Axis], Remaining.Max[Axis]);
+			Level.UpdatedRegions.push_back(Slab);
+			Remaining.Min[Axis] = Slab.Max[Axis];
+		}
+
+		if (OldWindow.Max[Axis] < Remaining.Max[Axis])
+		{
+			TGlobalSDFBox Slab = Remaining;
+			Slab.Min[Axis] = std::max<int>(OldWindow.Max[Axis], Remaining.Min[Axis]);
+			Level.UpdatedRegions.push_back(Slab);
+			Remaining.Max[Axis] = Slab.Min[Axis];
+		}
+	}
+}
+
+void TGlobalDistanceField::AddDirtyBounds(int LevelIndex, const float BoundsMin[3], const float BoundsMax[3])
+{
+	TGlobalSDFLevel& Level = Levels[LevelIndex];
+	const float Truncation = GetTruncation(LevelIndex);
+
+	TGlobalSDFBox Region;
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		// Voxels whose center is within the truncation distance of the bounds
+		Region.Min[Axis] = std::max<int>((int)std::floor((BoundsMin[Axis] - Truncation) / Level.VoxelSize - 0.5f), Level.Origin[Axis]);
+		Region.Max[Axis] = std::min<int>((int)std::ceil((BoundsMax[Axis] + Truncation) / Level.VoxelSize + 0.5f), Level.Origin[Axis] + Settings.Resolution);
+	}
+
+	if (!Region.IsEmpty())
+	{
+		Level.UpdatedRegions.push_back(Region);
+	}
+}
+
+void TGlobalDistanceField::Update(const float ViewPosition[3], const std::vector<TGlobalSDFObject>& Objects, const TSDFBrickAtlas& Atlas, TThreadPool& ThreadPool)
+{
+	for (TGlobalSDFLevel& Level : Levels)
+	{
+		Level.UpdatedRegions.clear();
+	}
+
+	// World bounds that changed since the last update: old and new bounds of moved objects, added and removed objects
+	std::vector<TWorldBounds> DirtyBounds;
+
+	std::unordered_map<uint64_t, TTrackedObject> NewTrackedObjects;
+	for (const TGlobalSDFObject& Object : Objects)
+	{
+		if (!Object.BrickIndirection || Object.Resolution[0] <= 0)
+		{
+			continue;
+		}
+
+		TTrackedObject& Tracked = NewTrackedObjects[Object.Id];
+		Tracked.Object = Object;
+		ComputeObjectWorldBounds(Object, Tracked.BoundsMin, Tracked.BoundsMax);
+
+		auto Iter = TrackedObjects.find(Object.Id);
+		if (Iter != TrackedObjects.end() && IsSameObject(Iter->second.Object, Object))
+		{
+			continue;
+		}
+
+		if (Iter != TrackedObjects.end())
+		{
+			const TTrackedObject& Old = Iter->second;
+			DirtyBounds.push_back({ { Old.BoundsMin[0], Old.BoundsMin[1], Old.BoundsMin[2] }, { Old.BoundsMax[0], Old.BoundsMax[1], Old.BoundsMax[2] } });
+		}
+
+		DirtyBounds.push_back({ { Tracked.BoundsMin[0], Tracked.BoundsMin[1], Tracked.BoundsMin[2] }, { Tracked.BoundsMax[0], Tracked.BoundsMax[1], Tracked.BoundsMax[2] } });
+	}
+
+	for (const auto& Pair : TrackedObjects)
+	{
+		if (NewTrackedObjects.find(Pair.first) == NewTrackedObjects.end())
+		{
+			const TTrackedObject& Old = Pair.second;
+			DirtyBounds.push_back({ { Old.BoundsMin[0], Old.BoundsMin[1], Old.BoundsMin[2] }, { Old.BoundsMax[0], Old.BoundsMax[1], Old.BoundsMax[2] } });
+		}
+	}
+
+	std::swap(TrackedObjects, NewTrackedObjects);
+
+	LastUpdateVoxelCount = 0;
+
+	for (int LevelIndex = 0; LevelIndex < GlobalSDFLevelCount; LevelIndex++)
+	{
+		TGlobalSDFLevel& Level = Levels[LevelIndex];
+
+		bool bWasInitialized = Level.bInitialized;
+		ScrollLevel(LevelIndex, ViewPosition);
+
+		// A fresh level is rebuilt whole
+		if (bWasInitialized)
+		{
+			for (const TWorldBounds& Bounds : DirtyBounds)
+			{
+				AddDirtyBounds(LevelIndex, Bounds.Min, Bounds.Max);
+			}
+		}
+
+		if (Level.UpdatedRegions.size() > MaxDirtyRegionsPerLevel)
+		{
+			TGlobalSDFBox Merged = Level.UpdatedRegions[0];
+			for (const TGlobalSDFBox& Region : Level.UpdatedRegions)
+			{
+				for (int Axis = 0; Axis < 3; Axis++)
+				{
+					Merged.Min[Axis] = std::min<int>(Merged.Min[Axis], Region.Min[Axis]);
+					Merged.Max[Axis] = std::max<int>(Merged.Max[Axis], Region.Max[Axis]);
+				}
+			}
+
+			Level.UpdatedRegions.assign(1, Merged);
+		}
+
+		const float Truncation = GetTruncation(LevelIndex);
+
+		for (const TGlobalSDFBox& Region : Level.UpdatedRegions)
+		{
+			// Objects that can store a distance below the truncation inside the region
+			std::vector<const TTrackedObject*> RegionObjects;
+			for (const auto& Pair : TrackedObjects)
+			{
+				const TTrackedObject& Tracked = Pair.second;
+
+				bool bOverlap = true;
+				for (int Axis = 0; Axis < 3; Axis++)
+				{
+					float RegionMin = Region.Min[Axis] * Level.VoxelSize;
+					float RegionMax = Region.Max[Axis] * Level.VoxelSize;
+					bOverlap = bOverlap && Tracked.BoundsMin[Axis] - Truncation < RegionMax && Tracked.BoundsMax[Axis] + Truncation > RegionMin;
+				}
+
+				if (bOverlap)
+				{
+					RegionObjects.push_back(&Tracked);
+				}
+			}
+
+			ComposeRegion(LevelIndex, Region, RegionObjects, Atlas, ThreadPool);
+
+			LastUpdateVoxelCount += (uint64_t)Region.GetVoxelCount();
+		}
+	}
+}
+
+void TGlobalDistanceField::ComposeRegion(int LevelIndex, const TGlobalSDFBox& Region, const std::vector<const TTrackedObject*>& Objects,
+	const TSDFBrickAtlas& Atlas, TThreadPool& ThreadPool)
+{
+	TGlobalSDFLevel& Level = Levels[LevelIndex];
+	const float Truncation = GetTruncation(LevelIndex);
+
+	std::vector<float> Scales;
+	for (const TTrackedObject* Tracked : Objects)
+	{
+		Scales.push_back(ComputeObjectLocalToWorldScale(Tracked->Object));
+	}
+
+	ThreadPool.ParallelFor((uint32_t)(Region.Max[2] - Region.Min[2]), [&](uint32_t Slice)
+	{
+		const int z = Region.Min[2] + (int)Slice;
+
+		for (int y = Region.Min[1]; y < Region.Max[1]; y++)
+		{
+			for (int x = Region.Min[0]; x < Region.Max[0]; x++)
+			{
+				const float Position[3] = { (x + 0.5f) * Level.VoxelSize, (y + 0.5f) * Level.VoxelSize, (z + 0.5f) * Level.VoxelSize };
+
+				float MinDistance = Truncation;
+				for (size_t i = 0; i < Objects.size(); i++)
+				{
+					// The surface lies inside the bounds, skip objects that can't get closer
+					if (DistanceToBounds(Position, Objects[i]->BoundsMin, Objects[i]->BoundsMax) >= std::abs(MinDistance))
+					{
+						continue;
+					}
+
+					float Distance = ObjectDistance(Objects[i]->Object, Scales[i], Atlas, Position);
+					MinDistance = std::min<float>(MinDistance, Distance);
+				}
+
+				// [-Truncation, Truncation] to R8
+				float Value = std::clamp(MinDistance / Truncation, -1.0f, 1.0f) * 0.5f + 0.5f;
+				Level.Data[GetTexelIndex(x, y, z)] = (uint8_t)(Value * 255.0f + 0.5f);
+			}
+		}
+	});
+}
+
+bool TGlobalDistanceField::SampleDistance(const float Position[3], float& OutDistance) const
+{
+	const int Resolution = Settings.Resolution;
+
+	for (int LevelIndex = 0; LevelIndex < GlobalSDFLevelCount; LevelIndex++)
+	{
+		const TGlobalSDFLevel& Level = Levels[LevelIndex];
+		if (!Level.bInitialized)
+		{
+			continue;
+		}
+
+		float VoxelPosition[3];
+		bool bInside = true;
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			VoxelPosition[Axis] = Position[Axis] / Level.VoxelSize;
+
+			// One voxel of margin keeps trilinear filtering off the toroidal seam
+			float WindowPosition = VoxelPosition[Axis] - Level.Origin[Axis];
+			bInside = bInside && WindowPosition >= 1.0f && WindowPosition <= Resolution - 1.0f;
+		}
+
+		if (!bInside)
+		{
+			continue;
+		}
+
+		// Texel centers sit at V + 0.5
+		int Base[3];
+		float Fraction[3];
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			float TexelPosition = VoxelPosition[Axis] - 0.5f;
+			Base[Axis] = (int)std::floor(TexelPosition);
+			Fraction[Axis] = TexelPosition - Base[Axis];
+		}
+
+		float Value = 0.0f;
+		for (int Corner = 0; Corner < 8; Corner++)
+		{
+			int Offset[3] = { Corner & 1, (Corner >> 1) & 1, (Corner >> 2) & 1 };
+
+			float Weight = 1.0f;
+			for (int Axis = 0; Axis < 3; Axis++)
+			{
+				Weight *= Offset[Axis] ? Fraction[Axis] : 1.0f - Fraction[Axis];
+			}
+
+			Value += Weight * Level.Data[GetTexelIndex(Base[0] + Offset[0], Base[1] + Offset[1], Base[2] + Offset[2])] / 255.0f;
+		}
+
+		OutDistance = (Value * 2.0f - 1.0f) * GetTruncation(LevelIndex);
+
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class TThreadPool;
+class TSDFBrickAtlas;
+
+// Match GLOBAL_SDF_LEVEL_COUNT in SDFShared.hlsl
+const int GlobalSDFLevelCount = 4;
+
+struct TGlobalSDFSettings
+{
+	// Voxels per axis of every level
+	int Resolution = 64;
+
+	// Voxel size of level 0, doubled every level
+	float Level0VoxelSize = 0.125f;
+
+	// Levels store distances clamped to TruncationVoxels voxels of the level
+	float TruncationVoxels = 4.0f;
+
+	// Level windows move in steps of this many voxels, so a moving camera rebuilds slabs every few frames
+	int ScrollSnapVoxels = 4;
+};
+
+// Mesh SDF placed in the world. Affine transforms in row vector convention, the first three columns of a TMatrix.
+struct TGlobalSDFObject
+{
+	// Stable between updates, the component address
+	uint64_t Id = 0;
+
+	float LocalToWorld[4][3] = {};
+
+	float WorldToLocal[4][3] = {};
+
+	// Half size of the mesh SDF volume per axis, centered on the local origin
+	float Extent[3] = {};
+
+	int Resolution[3] = {};
+
+	// TMesh::SDFBrickIndirection
+	const std::vector<uint32_t>* BrickIndirection = nullptr;
+};
+
+// World voxel coordinates of one level, Max exclusive
+struct TGlobalSDFBox
+{
+	int Min[3] = {};
+
+	int Max[3] = {};
+
+	bool IsEmpty() const { return Min[0] >= Max[0] || Min[1] >= Max[1] || Min[2] >= Max[2]; }
+
+	int64_t GetVoxelCount() const;
+};
+
+struct TGlobalSDFLevel
+{
+	float VoxelSize = 0.0f;
+
+	// World voxel coordinate of the first voxel of the window
+	int Origin[3] = {};
+
+	// Resolution^3 R8 texels addressed toroidally, world voxel V lives at texel V mod Resolution.
+	// Scrolling keeps every texel that stays in the window where it is.
+	std::vector<uint8_t> Data;
+
+	// Regions rebuilt by the last Update
+	std::vector<TGlobalSDFBox> UpdatedRegions;
+
+	bool bInitialized = false;
+};
+
+// Camera centered clipmap of the scene distance field, composed on the CPU from the mesh SDF bricks.
+// Only regions that scrolled into a level or that an added, moved or removed object touches are recomposed.
+class TGlobalDistanceField
+{
+public:
+	TGlobalDistanceField(const TGlobalSDFSettings& InSettings = TGlobalSDFSettings());
+
+	// Scroll the levels around ViewPosition and recompose the dirty regions, z slices are split across the thread pool
+	void Update(const float ViewPosition[3], const std::vector<TGlobalSDFObject>& Objects, const TSDFBrickAtlas& Atlas, TThreadPool& ThreadPool);
+
+	// Rebuild every level on the next Update, e.g. after the brick atlas was repacked
+	void Invalidate();
+
+	const TGlobalSDFSettings& GetSettings() const { return Settings; }
+
+	const TGlobalSDFLevel& GetLevel(int Level) const { return Levels[Level]; }
+
+	// Largest distance a level stores, in world units
+	float GetTruncation(int Level) const { return Settings.TruncationVoxels * Levels[Level].VoxelSize; }
+
+	// Voxels recomposed by the last Update over every level
+	uint64_t GetLastUpdateVoxelCount() const { return LastUpdateVoxelCount; }
+
+	// CPU reference of SampleGlobalDistanceField in SDFShared.hlsl. Trilinear distance of the finest level
+	// whose window holds Position with a voxel of margin, false outside every level.
+	bool SampleDistance(const float Position[3], float& OutDistance) const;
+
+private:
+	struct TTrackedObject
+	{
+		TGlobalSDFObject Object;
+
+		float BoundsMin[3];
+
+		float BoundsMax[3];
+	};
+
+	void ScrollLevel(int LevelIndex, const float ViewPosition[3]);
+
+	// Clip a world space box grown by the level truncation to the level window
+	void AddDirtyBounds(int LevelIndex, const float BoundsMin[3], const float BoundsMax[3]);
+
+	void ComposeRegion(int LevelIndex, const TGlobalSDFBox& Region, const std::vector<const TTrackedObject*>& Objects,
+		const TSDFBrickAtlas& Atlas, TThreadPool& ThreadPool);
+
+	size_t GetTexelIndex(int X, int Y, int Z) const;
+
+private:
+	TGlobalSDFSettings Settings;
+
+	TGlobalSDFLevel Levels[GlobalSDFLevelCount];
+
+	// Objects of the last Update by Id
+	std::unordered_map<uint64_t, TTrackedObject> TrackedObjects;
+
+	uint64_t LastUpdateVoxelCount = 0;
+};
+
+// Smallest axis scale of LocalToWorld, local distances times it never overestimate world distances
+float ComputeObjectLocalToWorldScale(const TGlobalSDFObject& Object);
+
+// World space bounds of the SDF volume of Object
+void ComputeObjectWorldBounds(const TGlobalSDFObject& Object, float OutMin[3], float OutMax[3]);
+
+// World space distance from Position to the surface of Object. Outside the SDF volume it is a lower bound,
+// the larger of the distance to the volume and the clamped sample minus that distance.
+float ComputeObjectDistance(const TGlobalSDFObject& Object, const TSDFBrickAtlas& Atlas, const float Position[3]);
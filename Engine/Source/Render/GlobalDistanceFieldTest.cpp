@@ -0,0 +1,260 @@
+#include "GlobalDistanceField.h"
+#include "Mesh/MeshSDFLayout.h"
+#include "Mesh/SDFBrickAtlas.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// Composes a scene of sphere SDFs into the clipmap and compares it against the analytic distance, then checks that
+// incremental updates after moves, removals and camera scrolling match a field built from scratch.
+// Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	const int SphereResolution = 32;
+
+	// Dense R8 volume of a sphere of radius 0.5 in a unit extent, quantized like BuildMeshSDF
+	std::vector<uint8_t> BuildSphereSDF()
+	{
+		const int Resolution = SphereResolution;
+		const float VoxelSize = 2.0f / Resolution;
+		const float DistanceRange = MeshSDFDistanceBandVoxels * VoxelSize;
+
+		std::vector<uint8_t> SDF((size_t)Resolution * Resolution * Resolution);
+		for (int Z = 0; Z < Resolution; Z++)
+		{
+			for (int Y = 0; Y < Resolution; Y++)
+			{
+				for (int X = 0; X < Resolution; X++)
+				{
+					const float PX = (X + 0.5f) * VoxelSize - 1.0f;
+					const float PY = (Y + 0.5f) * VoxelSize - 1.0f;
+					const float PZ = (Z + 0.5f) * VoxelSize - 1.0f;
+					const float Distance = std::sqrt(PX * PX + PY * PY + PZ * PZ) - 0.5f;
+
+					const float Value = Distance / DistanceRange * 0.5f + 0.5f;
+					SDF[((size_t)Z * Resolution + Y) * Resolution + X] = (uint8_t)std::clamp((int)(Value * 255.0f + 0.5f), 0, 255);
+				}
+			}
+		}
+
+		return SDF;
+	}
+
+	// Uniform scale and translation, the sphere radius in world units is 0.5 * Scale
+	TGlobalSDFObject MakeSphereObject(uint64_t Id, float X, float Y, float Z, float Scale, const std::vector<uint32_t>& Indirection)
+	{
+		TGlobalSDFObject Object;
+		Object.Id = Id;
+		Object.BrickIndirection = &Indirection;
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			Object.Extent[Axis] = 1.0f;
+			Object.Resolution[Axis] = SphereResolution;
+			Object.LocalToWorld[Axis][Axis] = Scale;
+			Object.WorldToLocal[Axis][Axis] = 1.0f / Scale;
+		}
+
+		const float Translation[3] = { X, Y, Z };
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			Object.LocalToWorld[3][Axis] = Translation[Axis];
+			Object.WorldToLocal[3][Axis] = -Translation[Axis] / Scale;
+		}
+
+		return Object;
+	}
+
+	float ComputeSceneDistance(const std::vector<TGlobalSDFObject>& Objects, const float Position[3])
+	{
+		float Distance = 1e30f;
+		for (const TGlobalSDFObject& Object : Objects)
+		{
+			const float DX = Position[0] - Object.LocalToWorld[3][0];
+			const float DY = Position[1] - Object.LocalToWorld[3][1];
+			const float DZ = Position[2] - Object.LocalToWorld[3][2];
+			Distance = std::min<float>(Distance, std::sqrt(DX * DX + DY * DY + DZ * DZ) - 0.5f * Object.LocalToWorld[0][0]);
+		}
+
+		return Distance;
+	}
+
+	// Finest level whose window holds Position with a voxel of margin, like SampleDistance
+	int FindLevel(const TGlobalDistanceField& Field, const float Position[3])
+	{
+		const int Resolution = Field.GetSettings().Resolution;
+		for (int Level = 0; Level < GlobalSDFLevelCount; Level++)
+		{
+			const TGlobalSDFLevel& LevelData = Field.GetLevel(Level);
+
+			bool bInside = true;
+			for (int Axis = 0; Axis < 3; Axis++)
+			{
+				const float Voxel = Position[Axis] / LevelData.VoxelSize - LevelData.Origin[Axis];
+				bInside &= Voxel >= 1.0f && Voxel <= Resolution - 1.0f;
+			}
+
+			if (bInside)
+			{
+				return Level;
+			}
+		}
+
+		return GlobalSDFLevelCount - 1;
+	}
+
+	int CountDifferentTexels(const TGlobalDistanceField& A, const TGlobalDistanceField& B)
+	{
+		int Count = 0;
+		for (int Level = 0; Level < GlobalSDFLevelCount; Level++)
+		{
+			const std::vector<uint8_t>& DataA = A.GetLevel(Level).Data;
+			const std::vector<uint8_t>& DataB = B.GetLevel(Level).Data;
+			if (DataA.size() != DataB.size())
+			{
+				return -1;
+			}
+
+			for (size_t i = 0; i < DataA.size(); i++)
+			{
+				Count += DataA[i] != DataB[i];
+			}
+		}
+
+		return Count;
+	}
+
+	double ElapsedMilliseconds(std::chrono::steady_clock::time_point StartTime)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
+	}
+}
+
+int main()
+{
+	TThreadPool ThreadPool;
+
+	const int Resolution[3] = { SphereResolution, SphereResolution, SphereResolution };
+	TSparseMeshSDF SphereSDF;
+	BuildSparseMeshSDF(BuildSphereSDF(), Resolution, 4.0f, SphereSDF);
+
+	TSDFBrickAtlas Atlas;
+	std::vector<uint32_t> Indirection;
+	Atlas.AddMesh(SphereSDF, Indirection);
+
+	// 5 x 4 spheres of three sizes around the camera
+	std::vector<TGlobalSDFObject> Objects;
+	for (int i = 0; i < 20; i++)
+	{
+		Objects.push_back(MakeSphereObject(i + 1, (i % 5) * 2.0f - 4.0f, 1.0f, (i / 5) * 2.0f - 4.0f, 1.0f + 0.2f * (i % 3), Indirection));
+	}
+
+	float ViewPosition[3] = { 0.0f, 1.0f, 0.0f };
+
+	TGlobalDistanceField Field;
+	auto StartTime = std::chrono::steady_clock::now();
+	Field.Update(ViewPosition, Objects, Atlas, ThreadPool);
+	printf("Full build: %llu voxels in %.1f ms\n", (unsigned long long)Field.GetLastUpdateVoxelCount(), ElapsedMilliseconds(StartTime));
+
+	// Accuracy against the analytic scene, clamped to the truncation of the level that answers. Mesh SDFs saturate at
+	// their band and are a lower bound outside their volume, so underestimates are expected and only reported,
+	// while overestimates would let sphere tracing step past the surface.
+	{
+		std::mt19937 Random(1);
+		std::uniform_real_distribution<float> Uniform(-20.0f, 20.0f);
+
+		double MaxOverestimateVoxels[GlobalSDFLevelCount] = {};
+		double MaxUnderestimateVoxels[GlobalSDFLevelCount] = {};
+		double TotalErrorVoxels = 0.0;
+		int SampleCount = 0;
+		int OverestimateCount = 0;
+		for (int i = 0; i < 200000; i++)
+		{
+			const float Position[3] = { Uniform(Random), Uniform(Random) * 0.1f + 1.0f, Uniform(Random) };
+
+			float Distance;
+			if (!Field.SampleDistance(Position, Distance))
+			{
+				continue;
+			}
+			SampleCount++;
+
+			const int Level = FindLevel(Field, Position);
+			const float VoxelSize = Field.GetLevel(Level).VoxelSize;
+			const float Reference = ComputeSceneDistance(Objects, Position);
+			const float Truncation = Field.GetTruncation(Level);
+
+			const double ErrorVoxels = (Distance - std::clamp(Reference, -Truncation, Truncation)) / VoxelSize;
+			MaxOverestimateVoxels[Level] = std::max<double>(MaxOverestimateVoxels[Level], ErrorVoxels);
+			MaxUnderestimateVoxels[Level] = std::max<double>(MaxUnderestimateVoxels[Level], -ErrorVoxels);
+			TotalErrorVoxels += std::fabs(ErrorVoxels);
+
+			OverestimateCount += ErrorVoxels > 1.0;
+		}
+
+		printf("Accuracy: %d samples, mean error %.3f voxels, %d overestimates by more than a voxel\n",
+			SampleCount, TotalErrorVoxels / std::max<int>(SampleCount, 1), OverestimateCount);
+		for (int Level = 0; Level < GlobalSDFLevelCount; Level++)
+		{
+			printf("  Level %d: max overestimate %.2f voxels, max underestimate %.2f voxels\n",
+				Level, MaxOverestimateVoxels[Level], MaxUnderestimateVoxels[Level]);
+		}
+
+		Check(SampleCount > 0, "accuracy: samples fall inside the clipmap");
+		Check(OverestimateCount == 0, "accuracy: no distance overestimates the scene by more than a voxel");
+	}
+
+	// Move an object, remove another and scroll the camera
+	Objects[3] = MakeSphereObject(4, 0.3f, 1.2f, 0.7f, 1.1f, Indirection);
+	Objects.pop_back();
+	ViewPosition[0] = 1.37f;
+	ViewPosition[2] = -0.9f;
+
+	StartTime = std::chrono::steady_clock::now();
+	Field.Update(ViewPosition, Objects, Atlas, ThreadPool);
+	const uint64_t IncrementalVoxelCount = Field.GetLastUpdateVoxelCount();
+	printf("Incremental update: %llu voxels in %.1f ms\n", (unsigned long long)IncrementalVoxelCount, ElapsedMilliseconds(StartTime));
+
+	{
+		TGlobalDistanceField FreshField;
+		FreshField.Update(ViewPosition, Objects, Atlas, ThreadPool);
+		Check(CountDifferentTexels(Field, FreshField) == 0, "incremental update matches a fresh build");
+		Check(IncrementalVoxelCount < FreshField.GetLastUpdateVoxelCount(), "incremental update recomposes less than a fresh build");
+	}
+
+	Field.Update(ViewPosition, Objects, Atlas, ThreadPool);
+	Check(Field.GetLastUpdateVoxelCount() == 0, "nothing changed, nothing is recomposed");
+
+	// An object following a moving camera for 30 frames
+	for (int Frame = 0; Frame < 30; Frame++)
+	{
+		ViewPosition[0] += 0.37f;
+		ViewPosition[1] += 0.11f;
+		ViewPosition[2] -= 0.23f;
+		Objects[0] = MakeSphereObject(1, ViewPosition[0], 1.0f, ViewPosition[2], 1.0f, Indirection);
+		Field.Update(ViewPosition, Objects, Atlas, ThreadPool);
+	}
+
+	{
+		TGlobalDistanceField FreshField;
+		FreshField.Update(ViewPosition, Objects, Atlas, ThreadPool);
+		Check(CountDifferentTexels(Field, FreshField) == 0, "30 scrolling updates match a fresh build");
+	}
+
+	printf("%s\n", FailureCount == 0 ? "All global distance field checks passed" : "Global distance field checks FAILED");
+
+	return FailureCount;
+}
@@ -0,0 +1,527 @@
+#include "IBLPrecompute.h"
+#include "Utils/HalfFloat.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	const float Pi = 3.14159265358979f;
+
+	const uint32_t IBLFileMagic = 0x4C424954; // "TIBL"
+
+	float SRGBToLinear(float Value)
+	{
+		return Value <= 0.04045f ? Value / 12.92f : std::pow((Value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	void EvaluateSHBasis(float X, float Y, float Z, float OutBasis[9])
+	{
+		OutBasis[0] = 0.282095f;
+		OutBasis[1] = 0.488603f * Y;
+		OutBasis[2] = 0.488603f * Z;
+		OutBasis[3] = 0.488603f * X;
+		OutBasis[4] = 1.092548f * X * Y;
+		OutBasis[5] = 1.092548f * Y * Z;
+		OutBasis[6] = 0.315392f * (3.0f * Z * Z - 1.0f);
+		OutBasis[7] = 1.092548f * X * Z;
+		OutBasis[8] = 0.546274f * (X * X - Y * Y);
+	}
+
+	// Equirectangular RGB float mip chain, sampled bilinearly with U wrapping and V clamped
+	class TEquirectMips
+	{
+	public:
+		bool Build(const TDecodedImage& Image)
+		{
+			if (Image.Width == 0 || Image.Height == 0 || (Image.Format != EDecodedImageFormat::RGB32F && Image.Format != EDecodedImageFormat::RGBA8))
+			{
+				return false;
+			}
+
+			TLevel Top;
+			Top.Width = Image.Width;
+			Top.Height = Image.Height;
+			Top.Texels.resize((size_t)Top.Width * Top.Height * 3);
+
+			for (uint32_t y = 0; y < Image.Height; y++)
+			{
+				const uint8_t* Row = Image.Data.data() + (size_t)y * Image.RowPitch;
+				float* Dest = &Top.Texels[(size_t)y * Top.Width * 3];
+
+				for (uint32_t x = 0; x < Image.Width; x++)
+				{
+					if (Image.Format == EDecodedImageFormat::RGB32F)
+					{
+						memcpy(Dest + x * 3, Row + x * 3 * sizeof(float), 3 * sizeof(float));
+					}
+					else
+					{
+						// LDR skies are sRGB, like the texture the GPU path sampled
+						for (uint32_t c = 0; c < 3; c++)
+						{
+							Dest[x * 3 + c] = SRGBToLinear(Row[x * 4 + c] / 255.0f);
+						}
+					}
+				}
+			}
+
+			Levels.push_back(std::move(Top));
+
+			// 2x2 box filter down to a few texels, odd sizes drop their last row or column
+			while (Levels.back().Width > 4 && Levels.back().Height > 2)
+			{
+				const TLevel& Source = Levels.back();
+
+				TLevel Level;
+				Level.Width = Source.Width / 2;
+				Level.Height = Source.Height / 2;
+				Level.Texels.resize((size_t)Level.Width * Level.Height * 3);
+
+				for (uint32_t y = 0; y < Level.Height; y++)
+				{
+					for (uint32_t x = 0; x < Level.Width; x++)
+					{
+						for (uint32_t c = 0; c < 3; c++)
+						{
+							float Sum = Source.At(x * 2, y * 2)[c] + Source.At(x * 2 + 1, y * 2)[c]
+								+ Source.At(x * 2, y * 2 + 1)[c] + Source.At(x * 2 + 1, y * 2 + 1)[c];
+
+							Level.Texels[((size_t)y * Level.Width + x) * 3 + c] = Sum * 0.25f;
+						}
+					}
+				}
+
+				Levels.push_back(std::move(Level));
+			}
+
+			return true;
+		}
+
+		// Lod 0 is the source image, fractional levels blend two mips
+		void Sample(const float Direction[3], float Lod, float OutColor[3]) const
+		{
+			const float U = std::atan2(Direction[2], Direction[0]) / (2.0f * Pi) + 0.5f;
+			const float V = std::asin(std::max<float>(-1.0f, std::min<float>(1.0f, Direction[1]))) / Pi + 0.5f;
+
+			Lod = std::max<float>(0.0f, std::min<float>(Lod, (float)(Levels.size() - 1)));
+			const uint32_t Lod0 = (uint32_t)Lod;
+			const uint32_t Lod1 = std::min<uint32_t>(Lod0 + 1, (uint32_t)Levels.size() - 1);
+			const float LodBlend = Lod - (float)Lod0;
+
+			float Color0[3];
+			float Color1[3];
+			Levels[Lod0].Sample(U, V, Color0);
+			Levels[Lod1].Sample(U, V, Color1);
+
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				OutColor[c] = Color0[c] + (Color1[c] - Color0[c]) * LodBlend;
+			}
+		}
+
+		// Solid angle of a level 0 texel, averaged over the sphere
+		float GetTexelSolidAngle() const
+		{
+			return 4.0f * Pi / ((float)Levels[0].Width * Levels[0].Height);
+		}
+
+		const std::vector<float>& GetTopTexels() const { return Levels[0].Texels; }
+
+		uint32_t GetWidth() const { return Levels[0].Width; }
+
+		uint32_t GetHeight() const { return Levels[0].Height; }
+
+	private:
+		struct TLevel
+		{
+			uint32_t Width = 0;
+
+			uint32_t Height = 0;
+
+			std::vector<float> Texels;
+
+			const float* At(uint32_t x, uint32_t y) const
+			{
+				return &Texels[((size_t)y * Width + x) * 3];
+			}
+
+			void Sample(float U, float V, float OutColor[3]) const
+			{
+				const float X = U * Width - 0.5f;
+				const float Y = V * Height - 0.5f;
+				const float FloorX = std::floor(X);
+				const float FloorY = std::floor(Y);
+				const float FracX = X - FloorX;
+				const float FracY = Y - FloorY;
+
+				const int32_t X0 = ((int32_t)FloorX % (int32_t)Width + (int32_t)Width) % (int32_t)Width;
+				const int32_t X1 = (X0 + 1) % (int32_t)Width;
+				const int32_t Y0 = std::max<int32_t>(0, std::min<int32_t>((int32_t)FloorY, (int32_t)Height - 1));
+				const int32_t Y1 = std::max<int32_t>(0, std::min<int32_t>((int32_t)FloorY + 1, (int32_t)Height - 1));
+
+				const float* T00 = At(X0, Y0);
+				const float* T10 = At(X1, Y0);
+				const float* T01 = At(X0, Y1);
+				const float* T11 = At(X1, Y1);
+
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					const float Top = T00[c] + (T10[c] - T00[c]) * FracX;
+					const float Bottom = T01[c] + (T11[c] - T01[c]) * FracX;
+					OutColor[c] = Top + (Bottom - Top) * FracY;
+				}
+			}
+		};
+
+		std::vector<TLevel> Levels;
+	};
+
+	// D3D cubemap face order +X, -X, +Y, -Y, +Z, -Z. S and T in [-1, 1], T grows downwards.
+	void CubeFaceToDirection(uint32_t Face, float S, float T, float OutDirection[3])
+	{
+		float X = 0.0f, Y = 0.0f, Z = 0.0f;
+		switch (Face)
+		{
+		case 0: X = 1.0f;  Y = -T;    Z = -S;    break;
+		case 1: X = -1.0f; Y = -T;    Z = S;     break;
+		case 2: X = S;     Y = 1.0f;  Z = T;     break;
+		case 3: X = S;     Y = -1.0f; Z = -T;    break;
+		case 4: X = S;     Y = -T;    Z = 1.0f;  break;
+		default: X = -S;   Y = -T;    Z = -1.0f; break;
+		}
+
+		const float InvLength = 1.0f / std::sqrt(X * X + Y * Y + Z * Z);
+		OutDirection[0] = X * InvLength;
+		OutDirection[1] = Y * InvLength;
+		OutDirection[2] = Z * InvLength;
+	}
+
+	float RadicalInverse(uint32_t Bits)
+	{
+		Bits = (Bits << 16u) | (Bits >> 16u);
+		Bits = ((Bits & 0x55555555u) << 1u) | ((Bits & 0xAAAAAAAAu) >> 1u);
+		Bits = ((Bits & 0x33333333u) << 2u) | ((Bits & 0xCCCCCCCCu) >> 2u);
+		Bits = ((Bits & 0x0F0F0F0Fu) << 4u) | ((Bits & 0xF0F0F0F0u) >> 4u);
+		Bits = ((Bits & 0x00FF00FFu) << 8u) | ((Bits & 0xFF00FF00u) >> 8u);
+
+		return (float)Bits * 2.3283064365386963e-10f;
+	}
+
+	// Light direction in tangent space (N = +Z, V = N) with its NoL weight and source lod
+	struct TGGXSample
+	{
+		float L[3];
+
+		float NoL;
+
+		float Lod;
+	};
+
+	// Hammersley points through ImportanceSampleGGX (Sampler.hlsl), reflected around H with V = N
+	void BuildGGXSamples(float Roughness, uint32_t SampleCount, float TexelSolidAngle, float SourceTexelSolidAngle, std::vector<TGGXSample>& OutSamples)
+	{
+		OutSamples.clear();
+
+		const float A = Roughness * Roughness;
+		const float A2 = A * A;
+
+		for (uint32_t i = 0; i < SampleCount; i++)
+		{
+			const float Phi = 2.0f * Pi * (float)i / (float)SampleCount;
+			const float Xi = RadicalInverse(i);
+			const float CosTheta = std::sqrt((1.0f - Xi) / (1.0f + (A2 - 1.0f) * Xi));
+			const float SinTheta = std::sqrt(std::max<float>(0.0f, 1.0f - CosTheta * CosTheta));
+
+			const float H[3] = { std::cos(Phi) * SinTheta, std::sin(Phi) * SinTheta, CosTheta };
+
+			TGGXSample Sample;
+			Sample.L[0] = 2.0f * CosTheta * H[0];
+			Sample.L[1] = 2.0f * CosTheta * H[1];
+			Sample.L[2] = 2.0f * CosTheta * H[2] - 1.0f;
+			Sample.NoL = Sample.L[2];
+
+			if (Sample.NoL <= 0.0f)
+			{
+				continue;
+			}
+
+			// With V = N the pdf of L is D(H) / 4, each sample covers 1 / (SampleCount * pdf) steradians
+			const float Denom = CosTheta * CosTheta * (A2 - 1.0f) + 1.0f;
+			const float D = A2 / (Pi * Denom * Denom);
+			const float SampleSolidAngle = 4.0f / ((float)SampleCount * D);
+
+			Sample.Lod = 0.5f * std::log2(std::max<float>(SampleSolidAngle, TexelSolidAngle) / SourceTexelSolidAngle);
+
+			OutSamples.push_back(Sample);
+		}
+	}
+
+	void BuildPrefilterMip(const TEquirectMips& Source, uint32_t Size, float Roughness, uint32_t SampleCount, TThreadPool& ThreadPool, std::vector<uint16_t>& OutTexels)
+	{
+		// A cube texel is about 4 / Size^2 steradians at the face center
+		const float TexelSolidAngle = 4.0f * Pi / (6.0f * Size * Size);
+
+		std::vector<TGGXSample> Samples;
+		if (Roughness > 0.0f)
+		{
+			BuildGGXSamples(Roughness, SampleCount, TexelSolidAngle, Source.GetTexelSolidAngle(), Samples);
+		}
+		else
+		{
+			// Mirror reflection, one sample at the lod matching the texel footprint
+			TGGXSample Sample = { { 0.0f, 0.0f, 1.0f }, 1.0f, 0.5f * std::log2(std::max<float>(TexelSolidAngle / Source.GetTexelSolidAngle(), 1.0f)) };
+			Samples.push_back(Sample);
+		}
+
+		OutTexels.assign((size_t)6 * Size * Size * 4, 0);
+
+		ThreadPool.ParallelFor(6 * Size, [&](uint32_t RowIndex)
+		{
+			const uint32_t Face = RowIndex / Size;
+			const uint32_t y = RowIndex % Size;
+
+			for (uint32_t x = 0; x < Size; x++)
+			{
+				float N[3];
+				CubeFaceToDirection(Face, ((float)x + 0.5f) / Size * 2.0f - 1.0f, ((float)y + 0.5f) / Size * 2.0f - 1.0f, N);
+
+				// Same tangent frame as ImportanceSampleGGX
+				const float Up[3] = { std::abs(N[2]) < 0.999f ? 0.0f : 1.0f, 0.0f, std::abs(N[2]) < 0.999f ? 1.0f : 0.0f };
+				float TangentX[3] = { Up[1] * N[2] - Up[2] * N[1], Up[2] * N[0] - Up[0] * N[2], Up[0] * N[1] - Up[1] * N[0] };
+				const float InvLength = 1.0f / std::sqrt(TangentX[0] * TangentX[0] + TangentX[1] * TangentX[1] + TangentX[2] * TangentX[2]);
+				for (float& Value : TangentX)
+				{
+					Value *= InvLength;
+				}
+				const float TangentY[3] = { N[1] * TangentX[2] - N[2] * TangentX[1], N[2] * TangentX[0] - N[0] * TangentX[2], N[0] * TangentX[1] - N[1] * TangentX[0] };
+
+				float Color[3] = { 0.0f, 0.0f, 0.0f };
+				float TotalWeight = 0.0f;
+
+				for (const TGGXSample& Sample : Samples)
+				{
+					float L[3];
+					for (uint32_t c = 0; c < 3; c++)
+					{
+						L[c] = TangentX[c] * Sample.L[0] + TangentY[c] * Sample.L[1] + N[c] * Sample.L[2];
+					}
+
+					float SampleColor[3];
+					Source.Sample(L, Sample.Lod, SampleColor);
+
+					for (uint32_t c = 0; c < 3; c++)
+					{
+						Color[c] += SampleColor[c] * Sample.NoL;
+					}
+					TotalWeight += Sample.NoL;
+				}
+
+				uint16_t* Texel = &OutTexels[(((size_t)Face * Size + y) * Size + x) * 4];
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					Texel[c] = THalfFloat::FromFloat(TotalWeight > 0.0f ? Color[c] / TotalWeight : 0.0f);
+				}
+				Texel[3] = THalfFloat::FromFloat(1.0f);
+			}
+		});
+	}
+
+	void ProjectSH(const TEquirectMips& Source, TThreadPool& ThreadPool, TSHIrradiance& OutIrradiance)
+	{
+		const uint32_t Width = Source.GetWidth();
+		const uint32_t Height = Source.GetHeight();
+		const std::vector<float>& Texels = Source.GetTopTexels();
+
+		// Per row sums, added up in order so the result doesn't depend on scheduling
+		std::vector<double> RowSums((size_t)Height * 27, 0.0);
+
+		ThreadPool.ParallelFor(Height, [&](uint32_t y)
+		{
+			// Exact solid angle of the texels in this latitude band
+			const double SinLat0 = std::sin(((double)y / Height - 0.5) * Pi);
+			const double SinLat1 = std::sin(((double)(y + 1) / Height - 0.5) * Pi);
+			const double TexelSolidAngle = 2.0 * Pi / Width * (SinLat1 - SinLat0);
+
+			double* Sums = &RowSums[(size_t)y * 27];
+			for (uint32_t x = 0; x < Width; x++)
+			{
+				float Direction[3];
+				EquirectUVToDirection(((float)x + 0.5f) / Width, ((float)y + 0.5f) / Height, Direction);
+
+				float Basis[9];
+				EvaluateSHBasis(Direction[0], Direction[1], Direction[2], Basis);
+
+				const float* Texel = &Texels[((size_t)y * Width + x) * 3];
+				for (uint32_t i = 0; i < 9; i++)
+				{
+					const double Weight = Basis[i] * TexelSolidAngle;
+					Sums[i * 3 + 0] += Texel[0] * Weight;
+					Sums[i * 3 + 1] += Texel[1] * Weight;
+					Sums[i * 3 + 2] += Texel[2] * Weight;
+				}
+			}
+		});
+
+		// Clamped cosine convolution per band (PI, 2PI/3, PI/4), divided by PI
+		const float BandScale[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+
+		for (uint32_t i = 0; i < 9; i++)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				double Sum = 0.0;
+				for (uint32_t y = 0; y < Height; y++)
+				{
+					Sum += RowSums[(size_t)y * 27 + i * 3 + c];
+				}
+
+				OutIrradiance.Coefficients[i][c] = (float)Sum * BandScale[i];
+			}
+		}
+	}
+}
+
+void TSHIrradiance::Evaluate(float X, float Y, float Z, float OutColor[3]) const
+{
+	float Basis[9];
+	EvaluateSHBasis(X, Y, Z, Basis);
+
+	for (uint32_t c = 0; c < 3; c++)
+	{
+		OutColor[c] = 0.0f;
+		for (uint32_t i = 0; i < 9; i++)
+		{
+			OutColor[c] += Coefficients[i][c] * Basis[i];
+		}
+	}
+}
+
+void EquirectUVToDirection(float U, float V, float OutDirection[3])
+{
+	// Inverse of SampleSphericalMap in IBLEnvironment.hlsl
+	const float Phi = (U - 0.5f) * 2.0f * Pi;
+	const float Latitude = (V - 0.5f) * Pi;
+
+	OutDirection[0] = std::cos(Latitude) * std::cos(Phi);
+	OutDirection[1] = std::sin(Latitude);
+	OutDirection[2] = std::cos(Latitude) * std::sin(Phi);
+}
+
+bool ComputeSHIrradiance(const TDecodedImage& Equirect, TThreadPool& ThreadPool, TSHIrradiance& OutIrradiance)
+{
+	TEquirectMips Source;
+	if (!Source.Build(Equirect))
+	{
+		return false;
+	}
+
+	ProjectSH(Source, ThreadPool, OutIrradiance);
+
+	return true;
+}
+
+bool BuildIBLData(const TDecodedImage& Equirect, const TIBLSettings& Settings, TThreadPool& ThreadPool, TIBLData& OutData)
+{
+	if (Settings.PrefilterMipCount == 0 || (Settings.PrefilterSize >> (Settings.PrefilterMipCount - 1)) == 0)
+	{
+		return false;
+	}
+
+	TEquirectMips Source;
+	if (!Source.Build(Equirect))
+	{
+		return false;
+	}
+
+	TIBLData Data;
+	ProjectSH(Source, ThreadPool, Data.Irradiance);
+
+	Data.PrefilterSize = Settings.PrefilterSize;
+	Data.PrefilterMips.resize(Settings.PrefilterMipCount);
+
+	for (uint32_t Mip = 0; Mip < Settings.PrefilterMipCount; Mip++)
+	{
+		const float Roughness = Settings.PrefilterMipCount > 1 ? (float)Mip / (float)(Settings.PrefilterMipCount - 1) : 0.0f;
+
+		BuildPrefilterMip(Source, Settings.PrefilterSize >> Mip, Roughness, Settings.SampleCount, ThreadPool, Data.PrefilterMips[Mip]);
+	}
+
+	OutData = std::move(Data);
+
+	return true;
+}
+
+bool SaveIBLData(const std::wstring& FilePath, uint64_t SourceHash, const TIBLSettings& Settings, const TIBLData& Data)
+{
+	std::error_code Error;
+	std::filesystem::create_directories(std::filesystem::path(FilePath).parent_path(), Error);
+
+	std::ofstream File(std::filesystem::path(FilePath), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	File.write((const char*)&IBLFileMagic, sizeof(uint32_t));
+	File.write((const char*)&IBLCacheVersion, sizeof(uint32_t));
+	File.write((const char*)&SourceHash, sizeof(uint64_t));
+	File.write((const char*)&Settings.PrefilterSize, sizeof(uint32_t));
+	File.write((const char*)&Settings.PrefilterMipCount, sizeof(uint32_t));
+	File.write((const char*)&Settings.SampleCount, sizeof(uint32_t));
+	File.write((const char*)Data.Irradiance.Coefficients, sizeof(Data.Irradiance.Coefficients));
+
+	for (const std::vector<uint16_t>& Mip : Data.PrefilterMips)
+	{
+		File.write((const char*)Mip.data(), Mip.size() * sizeof(uint16_t));
+	}
+
+	return File.good();
+}
+
+bool LoadIBLData(const std::wstring& FilePath, uint64_t SourceHash, const TIBLSettings& Settings, TIBLData& OutData)
+{
+	std::ifstream File(std::filesystem::path(FilePath), std::ios::in | std::ios::binary);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	uint32_t Magic = 0, Version = 0, PrefilterSize = 0, PrefilterMipCount = 0, SampleCount = 0;
+	uint64_t FileSourceHash = 0;
+	File.read((char*)&Magic, sizeof(uint32_t));
+	File.read((char*)&Version, sizeof(uint32_t));
+	File.read((char*)&FileSourceHash, sizeof(uint64_t));
+	File.read((char*)&PrefilterSize, sizeof(uint32_t));
+	File.read((char*)&PrefilterMipCount, sizeof(uint32_t));
+	File.read((char*)&SampleCount, sizeof(uint32_t));
+
+	if (!File.good() || Magic != IBLFileMagic || Version != IBLCacheVersion || FileSourceHash != SourceHash
+		|| PrefilterSize != Settings.PrefilterSize || PrefilterMipCount != Settings.PrefilterMipCount || SampleCount != Settings.SampleCount)
+	{
+		return false;
+	}
+
+	TIBLData Data;
+	Data.PrefilterSize = PrefilterSize;
+	File.read((char*)Data.Irradiance.Coefficients, sizeof(Data.Irradiance.Coefficients));
+
+	Data.PrefilterMips.resize(PrefilterMipCount);
+	for (uint32_t Mip = 0; Mip < PrefilterMipCount; Mip++)
+	{
+		const size_t MipSize = PrefilterSize >> Mip;
+		Data.PrefilterMips[Mip].resize(6 * MipSize * MipSize * 4);
+		File.read((char*)Data.PrefilterMips[Mip].data(), Data.PrefilterMips[Mip].size() * sizeof(uint16_t));
+	}
+
+	if (!File.good())
+	{
+		return false;
+	}
+
+	OutData = std::move(Data);
+
+	return true;
+}
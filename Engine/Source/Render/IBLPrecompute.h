@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "TextureLoader/ImageDecoder.h"
+
+class TThreadPool;
+
+// Bump when the precompute changes, cached results are then rebuilt
+const uint32_t IBLCacheVersion = 1;
+
+struct TIBLSettings
+{
+	// Face size of prefiltered mip 0, halved every mip
+	uint32_t PrefilterSize = 128;
+
+	// Mip m is filtered with roughness m / (PrefilterMipCount - 1)
+	uint32_t PrefilterMipCount = 5;
+
+	// GGX samples per prefiltered texel, the source mip chain keeps few samples noise free
+	uint32_t SampleCount = 256;
+};
+
+// Diffuse irradiance divided by PI (what the irradiance cubemap stored) as 3rd order spherical harmonics.
+// The coefficients are already convolved with the clamped cosine lobe, basis order:
+// 1, y, z, x, xy, yz, 3z^2-1, xz, x^2-y^2 (times the usual real SH constants).
+struct TSHIrradiance
+{
+	float Coefficients[9][3] = {};
+
+	void Evaluate(float X, float Y, float Z, float OutColor[3]) const;
+};
+
+struct TIBLData
+{
+	TSHIrradiance Irradiance;
+
+	uint32_t PrefilterSize = 0;
+
+	// One entry per mip: six faces in D3D cubemap order, each Size * Size RGBA half floats
+	std::vector<std::vector<uint16_t>> PrefilterMips;
+};
+
+// Equirectangular map to world direction, matching IBLEnvironment.hlsl. U and V in [0, 1], V = 0 is the first row.
+void EquirectUVToDirection(float U, float V, float OutDirection[3]);
+
+// Project an equirectangular RGB32F (or sRGB RGBA8) map to SH irradiance, rows are split across the thread pool
+bool ComputeSHIrradiance(const TDecodedImage& Equirect, TThreadPool& ThreadPool, TSHIrradiance& OutIrradiance);
+
+// SH irradiance and the GGX prefiltered cubemap mips, texels are split across the thread pool.
+// Uses filtered importance sampling, every GGX sample reads the source mip matching its solid angle.
+bool BuildIBLData(const TDecodedImage& Equirect, const TIBLSettings& Settings, TThreadPool& ThreadPool, TIBLData& OutData);
+
+// Cache file, the caller picks its path: version, source hash and settings followed by the SH coefficients and prefiltered mips
+bool SaveIBLData(const std::wstring& FilePath, uint64_t SourceHash, const TIBLSettings& Settings, const TIBLData& Data);
+
+// False when the file is missing, corrupt or was built from another source, version or settings
+bool LoadIBLData(const std::wstring& FilePath, uint64_t SourceHash, const TIBLSettings& Settings, TIBLData& OutData);
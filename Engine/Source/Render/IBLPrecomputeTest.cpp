@@ -0,0 +1,263 @@
+#include "IBLPrecompute.h"
+#include "Utils/HalfFloat.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// Precomputes IBL data for environments with known answers: a constant sky has only the DC SH term and a flat
+// prefiltered cubemap, a clamped cosine lobe matches its closed form irradiance. Then round trips the cache file and
+// checks that another source, version or settings, or a truncated file, are rejected. Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	const float Pi = 3.14159265358979f;
+
+	const uint32_t EquirectWidth = 256;
+
+	const uint32_t EquirectHeight = 128;
+
+	// RGB32F equirect map, Radiance is called with the direction of every texel center
+	template<typename TRadianceFunction>
+	TDecodedImage MakeEquirect(TRadianceFunction Radiance)
+	{
+		TDecodedImage Image;
+		Image.Width = EquirectWidth;
+		Image.Height = EquirectHeight;
+		Image.Format = EDecodedImageFormat::RGB32F;
+		Image.RowPitch = EquirectWidth * 3 * sizeof(float);
+		Image.Data.resize((size_t)Image.RowPitch * EquirectHeight);
+
+		for (uint32_t y = 0; y < EquirectHeight; y++)
+		{
+			float* Row = reinterpret_cast<float*>(Image.Data.data() + (size_t)y * Image.RowPitch);
+			for (uint32_t x = 0; x < EquirectWidth; x++)
+			{
+				float Direction[3];
+				EquirectUVToDirection((x + 0.5f) / EquirectWidth, (y + 0.5f) / EquirectHeight, Direction);
+				Radiance(Direction, Row + x * 3);
+			}
+		}
+
+		return Image;
+	}
+
+	TIBLSettings MakeSettings()
+	{
+		TIBLSettings Settings;
+		Settings.PrefilterSize = 16;
+		Settings.PrefilterMipCount = 5;
+		Settings.SampleCount = 64;
+
+		return Settings;
+	}
+
+	void TestConstantEnvironment(TThreadPool& ThreadPool)
+	{
+		const float Color[3] = { 0.25f, 1.0f, 3.5f };
+		const TDecodedImage Equirect = MakeEquirect([&Color](const float*, float* OutColor) { memcpy(OutColor, Color, sizeof(Color)); });
+
+		TIBLData Data;
+		Check(BuildIBLData(Equirect, MakeSettings(), ThreadPool, Data), "constant: IBL data is built");
+
+		// Irradiance over PI of a constant sky is the sky itself, carried by the DC term alone
+		float MaxHigherOrder = 0.0f;
+		for (uint32_t i = 1; i < 9; i++)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				MaxHigherOrder = std::max<float>(MaxHigherOrder, std::fabs(Data.Irradiance.Coefficients[i][c]));
+			}
+		}
+
+		float MaxIrradianceError = 0.0f;
+		for (uint32_t i = 0; i < 64; i++)
+		{
+			float Direction[3];
+			EquirectUVToDirection((i % 8 + 0.3f) / 8.0f, (i / 8 + 0.6f) / 8.0f, Direction);
+
+			float Irradiance[3];
+			Data.Irradiance.Evaluate(Direction[0], Direction[1], Direction[2], Irradiance);
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				MaxIrradianceError = std::max<float>(MaxIrradianceError, std::fabs(Irradiance[c] - Color[c]) / Color[c]);
+			}
+		}
+
+		// Every texel of every mip, half floats hold about 3 decimal digits
+		float MaxPrefilterError = 0.0f;
+		for (const std::vector<uint16_t>& Mip : Data.PrefilterMips)
+		{
+			for (size_t i = 0; i < Mip.size(); i += 4)
+			{
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					MaxPrefilterError = std::max<float>(MaxPrefilterError, std::fabs(THalfFloat::ToFloat(Mip[i + c]) - Color[c]) / Color[c]);
+				}
+			}
+		}
+
+		printf("Constant sky: largest higher order SH term %g, irradiance error %.5f, prefiltered error %.5f\n",
+			MaxHigherOrder, MaxIrradianceError, MaxPrefilterError);
+
+		Check(std::fabs(Data.Irradiance.Coefficients[0][1] * 0.282095f - Color[1]) < 1e-3f * Color[1], "constant: the DC term carries the sky");
+		Check(MaxHigherOrder < 1e-3f, "constant: higher order SH terms vanish");
+		Check(MaxIrradianceError < 1e-3f, "constant: irradiance equals the sky in every direction");
+		Check(Data.PrefilterMips.size() == 5 && Data.PrefilterMips[4].size() == 6 * 1 * 1 * 4, "constant: every mip down to 1x1 is built");
+		Check(MaxPrefilterError < 2e-3f, "constant: every prefiltered mip is flat");
+	}
+
+	// Clamped cosine around +Y. Irradiance over PI at angle Theta from the lobe axis is
+	// 2 / (3 PI) * ((PI - Theta) cos(Theta) + sin(Theta)).
+	void TestCosineLobe(TThreadPool& ThreadPool)
+	{
+		const TDecodedImage Equirect = MakeEquirect([](const float* Direction, float* OutColor)
+		{
+			OutColor[0] = OutColor[1] = OutColor[2] = std::max<float>(Direction[1], 0.0f);
+		});
+
+		TSHIrradiance Irradiance;
+		Check(ComputeSHIrradiance(Equirect, ThreadPool, Irradiance), "cosine lobe: SH irradiance is computed");
+
+		// Three bands can't hold the lobe's band 4 and above exactly, the convolution leaves them below 1% of the peak
+		float MaxError = 0.0f;
+		for (uint32_t i = 0; i <= 64; i++)
+		{
+			const float Theta = Pi * i / 64.0f;
+			const float Reference = 2.0f / (3.0f * Pi) * ((Pi - Theta) * std::cos(Theta) + std::sin(Theta));
+
+			// Tilted around X and around Z, the result only depends on the angle to the axis
+			float Color[3];
+			Irradiance.Evaluate(0.0f, std::cos(Theta), std::sin(Theta), Color);
+			MaxError = std::max<float>(MaxError, std::fabs(Color[0] - Reference));
+
+			Irradiance.Evaluate(-std::sin(Theta), std::cos(Theta), 0.0f, Color);
+			MaxError = std::max<float>(MaxError, std::fabs(Color[1] - Reference));
+		}
+
+		float Up[3];
+		float Down[3];
+		Irradiance.Evaluate(0.0f, 1.0f, 0.0f, Up);
+		Irradiance.Evaluate(0.0f, -1.0f, 0.0f, Down);
+
+		printf("Cosine lobe: up %.4f (exact %.4f), down %.4f (exact 0), largest error %.4f\n", Up[0], 2.0f / 3.0f, Down[0], MaxError);
+
+		Check(MaxError < 0.01f, "cosine lobe: SH irradiance matches the closed form within 1% of the peak");
+
+		// x, z, xy, yz and xz are odd around the Y axis
+		float MaxAsymmetric = 0.0f;
+		for (uint32_t i : { 2, 3, 4, 5, 7 })
+		{
+			MaxAsymmetric = std::max<float>(MaxAsymmetric, std::fabs(Irradiance.Coefficients[i][0]));
+		}
+		Check(MaxAsymmetric < 1e-4f, "cosine lobe: only terms symmetric around the lobe axis remain");
+	}
+
+	bool IsSameData(const TIBLData& A, const TIBLData& B)
+	{
+		return memcmp(A.Irradiance.Coefficients, B.Irradiance.Coefficients, sizeof(A.Irradiance.Coefficients)) == 0
+			&& A.PrefilterSize == B.PrefilterSize && A.PrefilterMips == B.PrefilterMips;
+	}
+
+	std::vector<char> ReadFile(const std::filesystem::path& Path)
+	{
+		std::ifstream File(Path, std::ios::in | std::ios::binary);
+
+		return std::vector<char>((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+	}
+
+	void WriteFile(const std::filesystem::path& Path, const std::vector<char>& Bytes, size_t Size)
+	{
+		std::ofstream File(Path, std::ios::out | std::ios::binary | std::ios::trunc);
+		File.write(Bytes.data(), Size);
+	}
+
+	void TestCache(TThreadPool& ThreadPool)
+	{
+		const TDecodedImage Equirect = MakeEquirect([](const float* Direction, float* OutColor)
+		{
+			OutColor[0] = 1.0f + Direction[0];
+			OutColor[1] = 0.5f + 0.5f * Direction[1] * Direction[1];
+			OutColor[2] = Direction[2] > 0.9f ? 50.0f : 0.1f;
+		});
+
+		const TIBLSettings Settings = MakeSettings();
+		const uint64_t SourceHash = 0x1234567890ABCDEFull;
+
+		TIBLData Data;
+		BuildIBLData(Equirect, Settings, ThreadPool, Data);
+
+		const std::filesystem::path FilePath = std::filesystem::temp_directory_path() / "IBLPrecomputeTest.ibl";
+		Check(SaveIBLData(FilePath.wstring(), SourceHash, Settings, Data), "cache: the file is written");
+
+		TIBLData Loaded;
+		Check(LoadIBLData(FilePath.wstring(), SourceHash, Settings, Loaded) && IsSameData(Data, Loaded), "cache: the data round trips exactly");
+
+		TIBLData Rejected;
+		Check(!LoadIBLData(FilePath.wstring(), SourceHash + 1, Settings, Rejected), "cache: another source hash is rejected");
+
+		TIBLSettings OtherSettings = Settings;
+		OtherSettings.PrefilterSize = 32;
+		Check(!LoadIBLData(FilePath.wstring(), SourceHash, OtherSettings, Rejected), "cache: another prefilter size is rejected");
+
+		OtherSettings = Settings;
+		OtherSettings.PrefilterMipCount = 4;
+		Check(!LoadIBLData(FilePath.wstring(), SourceHash, OtherSettings, Rejected), "cache: another mip count is rejected");
+
+		OtherSettings = Settings;
+		OtherSettings.SampleCount = 128;
+		Check(!LoadIBLData(FilePath.wstring(), SourceHash, OtherSettings, Rejected), "cache: another sample count is rejected");
+
+		// Files written by another version or cut short, the version follows the magic
+		const std::vector<char> Bytes = ReadFile(FilePath);
+
+		std::vector<char> OtherVersion = Bytes;
+		const uint32_t Version = IBLCacheVersion + 1;
+		memcpy(OtherVersion.data() + 4, &Version, sizeof(Version));
+		WriteFile(FilePath, OtherVersion, OtherVersion.size());
+		Check(!LoadIBLData(FilePath.wstring(), SourceHash, Settings, Rejected), "cache: another version is rejected");
+
+		std::vector<char> OtherMagic = Bytes;
+		OtherMagic[0] ^= 1;
+		WriteFile(FilePath, OtherMagic, OtherMagic.size());
+		Check(!LoadIBLData(FilePath.wstring(), SourceHash, Settings, Rejected), "cache: a wrong magic is rejected");
+
+		bool bTruncationsRejected = true;
+		const size_t Truncations[] = { 0, 3, 16, 28, 28 + 108, Bytes.size() / 2, Bytes.size() - 1 };
+		for (size_t Size : Truncations)
+		{
+			WriteFile(FilePath, Bytes, Size);
+			bTruncationsRejected &= !LoadIBLData(FilePath.wstring(), SourceHash, Settings, Rejected);
+		}
+		Check(bTruncationsRejected, "cache: truncated files are rejected");
+
+		std::filesystem::remove(FilePath);
+		Check(!LoadIBLData(FilePath.wstring(), SourceHash, Settings, Rejected), "cache: a missing file is rejected");
+	}
+}
+
+int main()
+{
+	TThreadPool ThreadPool;
+
+	TestConstantEnvironment(ThreadPool);
+	TestCosineLobe(ThreadPool);
+	TestCache(ThreadPool);
+
+	printf("%s\n", FailureCount == 0 ? "All IBL precompute checks passed" : "IBL precompute checks FAILED");
+
+	return FailureCount;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Material/Material.h"
+#include "RenderProxy.h"
 #include <string>
 #include <unordered_map>
 
@@ -16,8 +17,25 @@ struct TMeshBatch
 
 	TMeshComponent* MeshComponent = nullptr;
 
+	// One batch per submesh of the mesh proxy
+	UINT SubmeshIndex = 0;
+
+	TMaterialInstance* MaterialInstance = nullptr;
+
 	// Flags
 	bool bUseSDF = false;
+
+	bool bCompactVertex = false;
+
+	TMatrix World = TMatrix::Identity;
+
+	// LOD selected for the camera
+	UINT LODIndex = 0;
+
+	// Camera cluster culling result, merged runs of visible meshlets
+	bool bClusterCulled = false;
+
+	std::vector<TMeshDrawRange> ClusterDraws;
 };
 
 struct TMeshCommand
@@ -70,6 +88,9 @@ public:
 	TMaterialRenderState RenderState;
 
 	TMeshShaderParamters ShaderParameters;
+
+	// Index ranges to draw, chosen per pass by LOD and cluster culling
+	std::vector<TMeshDrawRange> Draws;
 };
 
 typedef std::vector<TMeshCommand> TMeshCommandList;
\ No newline at end of file
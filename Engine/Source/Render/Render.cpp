@@ -8,14 +8,18 @@
 #include "Texture/TextureRepository.h"
 #include "Material/MaterialRepository.h"
 #include "Mesh/MeshRepository.h"
-#include "Mesh/KdTree.h"
+#include "Mesh/MeshSDFBuilder.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/Hash.h"
+#include "File/MappedFile.h"
+#include "Mesh/VertexQuantization.h"
 #include "Texture/TextureInfo.h"
 #include "Utils/Logger.h"
 #include <fstream>
 #include <algorithm>
+#include <unordered_set>
+#include <chrono>
 #include "File/FileHelpers.h"
-#include "File/BinarySaver.h"
-#include "File/BinaryReader.h"
 #include "Sampler.h"
 
 using namespace DirectX;
@@ -121,16 +125,31 @@ void TRender::CreateRenderResource()
 
 	CreateNullDescriptors();
 
+	GetSkyInfo();
+
 	CreateTextures();
 
-	GetSkyInfo();
 	if (SkyMeshComponent)
 	{
 		bEnableIBLEnvLighting = true;
 
 		CreateSceneCaptureCube();
+
+		CreateIBLLightingData();
 	}
 
+	GeometryPool = std::make_unique<TGeometryPool>(D3D12RHI);
+
+	SDFBrickAtlas = std::make_unique<TSDFBrickAtlas>();
+
+	SDFObjectTable = std::make_unique<TSDFObjectTable>();
+
+	CreateGlobalDistanceField();
+	GeometryPool->SetRelocateCallback([this](EGeometryArena Arena, const std::vector<TOffsetMove>& Moves)
+	{
+		RelocateMeshProxys(Arena, Moves);
+	});
+
 	CreateMeshProxys();
 
 	CreateInputLayouts();
@@ -146,6 +165,8 @@ void TRender::CreateRenderResource()
 
 	// Wait until initialization is complete.
 	D3D12RHI->FlushCommandQueue();
+
+	GeometryPool->ReleaseRetiredBuffers();
 }
 
 void TRender::CreateNullDescriptors()
@@ -195,11 +216,49 @@ void TRender::CreateTextures()
 {
 	const auto& TextureMap = TTextureRepository::Get().TextureMap;
 
+	// Textures sampled by render passes must be ready before the first frame,
+	// the rest stream in on the copy queue
+	const std::unordered_set<std::string> ImmediateTextures = { "NullTex", "IBL_BRDF_LUT", "LtcMat_1", "LtcMat_2", "BlueNoiseTex", SkyCubeTextureName };
+
+	TTextureStreamingSettings StreamingSettings;
+	StreamingSettings.PoolBudget = (uint64_t)RenderSettings.TextureStreamingPoolSizeMB * 1024 * 1024;
+	TextureStreamingManager = std::make_unique<TTextureStreamingManager>(StreamingSettings);
+
+	// Decode texture files
+	TTextureRepository::Get().LoadTextureResources(D3D12RHI);
+
 	// Create textures in reposity
 	for (const auto& TexturePair : TextureMap)
 	{
-		TexturePair.second->LoadTextureResourceFromFlie(D3D12RHI);
-		TexturePair.second->CreateTexture(D3D12RHI);
+		if (ImmediateTextures.count(TexturePair.first) > 0)
+		{
+			TexturePair.second->CreateTexture(D3D12RHI);
+		}
+		else if (TexturePair.second->IsStreamable())
+		{
+			// Mips are requested by UpdateTextureStreaming, tail first. Only the tail stays in CPU memory
+			// after an upload, higher mips are read from the file again when they are requested.
+			const TTextureResource& Resource = TexturePair.second->TextureResource;
+
+			TStreamingTextureDesc StreamingDesc;
+			StreamingDesc.Width = (uint32_t)Resource.TextureInfo.Width;
+			StreamingDesc.Height = (uint32_t)Resource.TextureInfo.Height;
+			for (const D3D12_SUBRESOURCE_DATA& MipData : Resource.InitData)
+			{
+				StreamingDesc.MipSizes.push_back((uint64_t)MipData.SlicePitch);
+			}
+
+			const uint32_t StreamingId = TextureStreamingManager->RegisterTexture(StreamingDesc);
+			TexturePair.second->bStreamed = true;
+			TexturePair.second->StreamedTailMip = TextureStreamingManager->GetTailMip(StreamingId);
+
+			StreamingTextureIds.insert({ TexturePair.first, StreamingId });
+			StreamingTextures.push_back(TexturePair.second.get());
+		}
+		else
+		{
+			TexturePair.second->CreateTextureAsync(D3D12RHI);
+		}
 	}
 
 	// Create SpriteFont and font texture
@@ -220,26 +279,117 @@ void TRender::CreateTextures()
 	InitData.RowPitch = static_cast<LONG_PTR>(SpriteFont->textureStride);
 	InitData.SlicePitch = InitData.RowPitch * uint64_t(SpriteFont->textureRows);
 	
-	SpriteFont->GetFontTexture()->SetTextureResourceDirectly(TextureInfo, SpriteFont->textureData, InitData);
+	// The font texture owns the pixels from here on and frees them after the upload
+	SpriteFont->GetFontTexture()->SetTextureResourceDirectly(TextureInfo, std::move(SpriteFont->textureData), InitData);
 	SpriteFont->GetFontTexture()->CreateTexture(D3D12RHI);
+
+	std::string Report = TTexture::GetMemoryStats().ToString();
+	TLogger::LogToOutput(Report.data());
+}
+
+TD3D12ShaderResourceView* TRender::GetTextureSRV(const std::string& TextureName)
+{
+	auto& TextureMap = TTextureRepository::Get().TextureMap;
+
+	TTexture* Texture = TextureMap.at(TextureName).get();
+	if (!Texture->IsResident())
+	{
+		Texture = TextureMap.at("NullTex").get();
+	}
+
+	return Texture->GetD3DTexture()->GetSRV();
 }
 
 void TRender::CreateSceneCaptureCube()
 {
 	IBLEnvironmentMap = std::make_unique<TSceneCaptureCube>(false, 512, DXGI_FORMAT_R32G32B32A32_FLOAT, D3D12RHI);
 	IBLEnvironmentMap->CreatePerspectiveViews({ 0.0f, 0.0f, 0.0f }, 0.1f, 10.0f);
+}
+
+void TRender::CreateIBLLightingData()
+{
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	TIBLSettings Settings;
+	Settings.PrefilterMipCount = IBLPrefilterMaxMipLevel;
+
+	// Keyed by the content of the source file, the sky texture itself may be a cooked DDS
+	TIBLData IBLData;
+	bool bCacheHit = false;
 
-	IBLIrradianceMap = std::make_unique<TSceneCaptureCube>(false, 32, DXGI_FORMAT_R32G32B32A32_FLOAT, D3D12RHI);
-	IBLIrradianceMap->CreatePerspectiveViews({ 0.0f, 0.0f, 0.0f }, 0.1f, 10.0f);
+	const std::wstring SourcePath = GetTextureSourcePath(SkyCubeTextureName);
 
-	for (UINT Mip = 0; Mip < IBLPrefilterMaxMipLevel; Mip++)
+	TMappedFile SourceFile;
+	if (!SourcePath.empty() && SourceFile.Open(SourcePath))
 	{
-		UINT MipWidth = UINT(128 * std::pow(0.5, Mip));
-		auto PrefilterEnvMap = std::make_unique<TSceneCaptureCube>(false, MipWidth, DXGI_FORMAT_R16G16B16A16_FLOAT, D3D12RHI);
-		PrefilterEnvMap->CreatePerspectiveViews({ 0.0f, 0.0f, 0.0f }, 0.1f, 10.0f);
+		const uint64_t SourceHash = THash::HashBytes(SourceFile.GetData(), SourceFile.GetSize());
+		const std::wstring CachePath = TFileHelpers::EngineDir() + L"Save/IBL/" + TFormatConvert::StrToWStr(SkyCubeTextureName) + L".ibl";
 
-		IBLPrefilterEnvMaps.push_back(std::move(PrefilterEnvMap));
+		bCacheHit = LoadIBLData(CachePath, SourceHash, Settings, IBLData);
+		if (!bCacheHit)
+		{
+			TDecodedImage Equirect;
+			EImageFileType FileType = GetImageFileType(TFormatConvert::WStrToStr(SourcePath));
+
+			if (DecodeImageFromMemory(SourceFile.GetData(), SourceFile.GetSize(), FileType, Equirect)
+				&& BuildIBLData(Equirect, Settings, TThreadPool::Get(), IBLData))
+			{
+				SaveIBLData(CachePath, SourceHash, Settings, IBLData);
+			}
+		}
 	}
+
+	if (IBLData.PrefilterMips.empty())
+	{
+		// Sky source can't be read, ambient lighting stays black
+		IBLData.PrefilterSize = Settings.PrefilterSize;
+		for (UINT Mip = 0; Mip < Settings.PrefilterMipCount; Mip++)
+		{
+			const size_t MipSize = Settings.PrefilterSize >> Mip;
+			IBLData.PrefilterMips.emplace_back(6 * MipSize * MipSize * 4, (uint16_t)0);
+		}
+	}
+
+	IBLIrradianceSH = IBLData.Irradiance;
+
+	TTextureInfo TextureInfo;
+	TextureInfo.Type = ETextureType::TEXTURE_CUBE;
+	TextureInfo.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	TextureInfo.Width = IBLData.PrefilterSize;
+	TextureInfo.Height = IBLData.PrefilterSize;
+	TextureInfo.Depth = 1;
+	TextureInfo.ArraySize = 6;
+	TextureInfo.MipCount = IBLData.PrefilterMips.size();
+	TextureInfo.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+
+	IBLPrefilterEnvMap = D3D12RHI->CreateTexture(TextureInfo, TexCreate_SRV);
+
+	// Subresources go face by face, mips within a face
+	std::vector<D3D12_SUBRESOURCE_DATA> InitData;
+	for (UINT Face = 0; Face < 6; Face++)
+	{
+		for (UINT Mip = 0; Mip < (UINT)IBLData.PrefilterMips.size(); Mip++)
+		{
+			const size_t MipSize = IBLData.PrefilterSize >> Mip;
+
+			D3D12_SUBRESOURCE_DATA FaceData;
+			FaceData.pData = IBLData.PrefilterMips[Mip].data() + Face * MipSize * MipSize * 4;
+			FaceData.RowPitch = (LONG_PTR)(MipSize * 4 * sizeof(uint16_t));
+			FaceData.SlicePitch = FaceData.RowPitch * MipSize;
+
+			InitData.push_back(FaceData);
+		}
+	}
+
+	// Copied to the upload heap here, IBLData can go
+	D3D12RHI->UploadTextureData(IBLPrefilterEnvMap, InitData);
+
+	auto EndTime = std::chrono::high_resolution_clock::now();
+
+	char Log[256];
+	sprintf_s(Log, "IBL lighting data for %s: %s in %.3fs\n", SkyCubeTextureName.c_str(), bCacheHit ? "loaded from cache" : "precomputed",
+		std::chrono::duration<double>(EndTime - StartTime).count());
+	TLogger::LogToOutput(Log);
 }
 
 void TRender::CreateGBuffers()
@@ -295,267 +445,346 @@ void TRender::CreateMeshProxys()
 	{
 		TMesh& Mesh = MeshPair.second;
 
-		// Create SDF texture
-		CreateMeshSDFTexture(Mesh);
+		// Pack SDF bricks into the atlas
+		CreateMeshSDFBricks(Mesh);
 
 		// Generate MeshProxy
 		MeshProxyMap.emplace(Mesh.MeshName, TMeshProxy());
 		TMeshProxy& MeshProxy = MeshProxyMap.at(Mesh.MeshName);
 
-		const UINT VbByteSize = (UINT)Mesh.Vertices.size() * sizeof(TVertex);
+		if (Mesh.bCompactVertex)
+		{
+			CreateCompactVertexBuffers(Mesh, MeshProxy);
+		}
+		else
+		{
+			MeshProxy.VertexArena = EGeometryArena::Vertices;
+			GeometryPool->AllocateVertices(MeshProxy.VertexArena, (UINT)Mesh.Vertices.size(), { Mesh.Vertices.data() }, MeshProxy.VertexAllocation);
+		}
 
-		std::vector<std::uint16_t> indices = Mesh.GetIndices16();
-		const UINT IbByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
+		Mesh.EnsureSubmeshes();
 
-		MeshProxy.VertexBufferRef = D3D12RHI->CreateVertexBuffer(Mesh.Vertices.data(), VbByteSize);
-		MeshProxy.IndexBufferRef = D3D12RHI->CreateIndexBuffer(indices.data(), IbByteSize);
+		// 16-bit indices unless the mesh has more vertices than they can address
+		if (Mesh.HasIndices16())
+		{
+			std::vector<std::uint16_t> indices = Mesh.GetIndices16();
+			for (const TMeshLOD& LOD : Mesh.LODs)
+			{
+				for (std::uint32_t Index : LOD.Indices)
+				{
+					indices.push_back((std::uint16_t)Index);
+				}
+			}
 
-		MeshProxy.VertexByteStride = sizeof(TVertex);
-		MeshProxy.VertexBufferByteSize = VbByteSize;
-		MeshProxy.IndexFormat = DXGI_FORMAT_R16_UINT;
-		MeshProxy.IndexBufferByteSize = IbByteSize;
+			MeshProxy.IndexArena = EGeometryArena::Indices16;
+			MeshProxy.IndexFormat = DXGI_FORMAT_R16_UINT;
+			GeometryPool->AllocateIndices(MeshProxy.IndexArena, (UINT)indices.size(), indices.data(), MeshProxy.IndexAllocation);
+		}
+		else
+		{
+			std::vector<std::uint32_t> indices = Mesh.Indices32;
+			for (const TMeshLOD& LOD : Mesh.LODs)
+			{
+				indices.insert(indices.end(), LOD.Indices.begin(), LOD.Indices.end());
+			}
+
+			MeshProxy.IndexArena = EGeometryArena::Indices32;
+			MeshProxy.IndexFormat = DXGI_FORMAT_R32_UINT;
+			GeometryPool->AllocateIndices(MeshProxy.IndexArena, (UINT)indices.size(), indices.data(), MeshProxy.IndexAllocation);
+		}
 
-		TSubmeshProxy submesh;
-		submesh.IndexCount = (UINT)indices.size();
-		submesh.StartIndexLocation = 0;
-		submesh.BaseVertexLocation = 0;
+		for (const TMeshSubmesh& Submesh : Mesh.Submeshes)
+		{
+			TMeshSubmeshProxy SubmeshProxy;
+			SubmeshProxy.MaterialSlot = Submesh.MaterialSlot;
 
-		MeshProxy.SubMeshs["Default"] = submesh;
+			const UINT SubmeshEnd = Submesh.StartIndex + Submesh.IndexCount;
+			if (Mesh.IndexChunks.empty())
+			{
+				TMeshDrawRange Draw;
+				Draw.IndexCount = Submesh.IndexCount;
+				Draw.StartIndexLocation = Submesh.StartIndex;
+				Draw.BaseVertexLocation = 0;
+
+				SubmeshProxy.Draws.push_back(Draw);
+			}
+			else
+			{
+				// One draw per 16-bit chunk
+				for (const TMeshIndexChunk& Chunk : Mesh.IndexChunks)
+				{
+					if (Chunk.StartIndex >= Submesh.StartIndex && Chunk.StartIndex < SubmeshEnd)
+					{
+						TMeshDrawRange Draw;
+						Draw.IndexCount = Chunk.IndexCount;
+						Draw.StartIndexLocation = Chunk.StartIndex;
+						Draw.BaseVertexLocation = (INT)Chunk.BaseVertex;
+
+						SubmeshProxy.Draws.push_back(Draw);
+					}
+				}
+			}
+
+			SubmeshProxy.Meshlets.assign(Mesh.Meshlets.begin() + Submesh.FirstMeshlet, Mesh.Meshlets.begin() + Submesh.FirstMeshlet + Submesh.MeshletCount);
+
+			// Indices32 addresses the whole vertex buffer even for chunked meshes
+			TVector3 BoundsMin(FLT_MAX);
+			TVector3 BoundsMax(-FLT_MAX);
+			for (UINT i = Submesh.StartIndex; i < SubmeshEnd; i++)
+			{
+				const TVector3& Position = Mesh.Vertices[Mesh.Indices32[i]].Position;
+				BoundsMin = TVector3::Min(BoundsMin, Position);
+				BoundsMax = TVector3::Max(BoundsMax, Position);
+			}
+
+			if (Submesh.IndexCount > 0)
+			{
+				DirectX::BoundingBox::CreateFromPoints(SubmeshProxy.Bounds, XMLoadFloat3(&BoundsMin), XMLoadFloat3(&BoundsMax));
+			}
+
+			MeshProxy.Submeshes.push_back(SubmeshProxy);
+		}
+
+		// LOD index lists follow LOD0 in the same index buffer
+		UINT LODStartIndex = (UINT)Mesh.Indices32.size();
+		for (const TMeshLOD& LOD : Mesh.LODs)
+		{
+			TMeshLODProxy LODProxy;
+			LODProxy.Error = LOD.Error;
+			MeshProxy.LODs.push_back(LODProxy);
+
+			for (size_t i = 0; i < LOD.Submeshes.size() && i < MeshProxy.Submeshes.size(); i++)
+			{
+				TMeshDrawRange Draw;
+				Draw.StartIndexLocation = LODStartIndex + LOD.Submeshes[i].StartIndex;
+				Draw.IndexCount = LOD.Submeshes[i].IndexCount;
+				MeshProxy.Submeshes[i].LODDraws.push_back(Draw);
+			}
+
+			LODStartIndex += (UINT)LOD.Indices.size();
+		}
+
+		MeshProxy.UVDensity = Mesh.ComputeUVDensity();
+
+		if (!Mesh.BoundingBox.bInit)
+		{
+			Mesh.GenerateBoundingBox();
+		}
+		MeshProxy.BoundsCenter = Mesh.BoundingBox.GetCenter();
+		MeshProxy.BoundsRadius = Mesh.BoundingBox.GetExtend().Length();
 	}
+
+	CreateSDFBrickAtlasTexture();
 }
 
-void TRender::CreateMeshSDFTexture(TMesh& Mesh)
+void TRender::CreateCompactVertexBuffers(const TMesh& Mesh, TMeshProxy& MeshProxy)
 {
-	std::vector<uint8_t> MeshSDF;
+	TPositionQuantization Quantization = ComputePositionQuantization(Mesh.Vertices);
 
-	std::wstring MeshSDFPath = TFileHelpers::EngineDir() + L"Save/MeshSDF/" + TFormatConvert::StrToWStr(Mesh.MeshName) + L".sdf";
-	if (TFileHelpers::IsFileExit(MeshSDFPath)) //Read SDF from file
-	{
-		TBinaryReader Reader(MeshSDFPath.c_str());
-		TMeshSDFDescriptor& Descriptor = Mesh.SDFDescriptor;
-		Descriptor.Center.x = Reader.Read<float>();
-		Descriptor.Center.y = Reader.Read<float>();
-		Descriptor.Center.z = Reader.Read<float>();
-		Descriptor.Extent = Reader.Read<float>();
-		Descriptor.Resolution = Reader.Read<int>();
+	std::vector<TCompactPosition> Positions;
+	std::vector<TCompactAttributes> Attributes;
+	EncodeCompactVertices(Mesh.Vertices, Quantization, Positions, Attributes);
 
-		int SDFDataCount = Descriptor.Resolution * Descriptor.Resolution * Descriptor.Resolution;
-		const uint8_t* SDFData = Reader.ReadArray<uint8_t>(SDFDataCount);
-		MeshSDF.assign(SDFData, SDFData + SDFDataCount);
-	}
-	else // Bulid SDF and save to file
-	{
-		BulidMeshSDF(Mesh, MeshSDF);
+	MeshProxy.bCompactVertex = true;
+	MeshProxy.VertexArena = EGeometryArena::CompactVertices;
+	GeometryPool->AllocateVertices(MeshProxy.VertexArena, (UINT)Positions.size(), { Positions.data(), Attributes.data() }, MeshProxy.VertexAllocation);
 
-		TBinarySaver FileSaver(MeshSDFPath);
-		const TMeshSDFDescriptor& Descriptor = Mesh.SDFDescriptor;
-		FileSaver.Save(Descriptor.Center.x);
-		FileSaver.Save(Descriptor.Center.y);
-		FileSaver.Save(Descriptor.Center.z);
-		FileSaver.Save(Descriptor.Extent);
-		FileSaver.Save(Descriptor.Resolution);
+	MeshProxy.PositionDequantMin = TVector3(Quantization.Min[0], Quantization.Min[1], Quantization.Min[2]);
+	MeshProxy.PositionDequantExtent = TVector3(Quantization.Extent[0], Quantization.Extent[1], Quantization.Extent[2]);
 
-		FileSaver.SaveArray<uint8_t>(MeshSDF.data(), MeshSDF.size());
-	}
+	TVertexQuantizationError Error = MeasureQuantizationError(Mesh.Vertices, Positions, Attributes, Quantization);
 
-	int SDFResolution = Mesh.SDFDescriptor.Resolution;
+	char Log[512];
+	sprintf_s(Log, "Compact vertices %s: %u -> %u bytes, max error position %f, normal %.3f deg, tangent %.3f deg, uv %f\n",
+		Mesh.MeshName.c_str(), (UINT)(Mesh.Vertices.size() * sizeof(TVertex)), (UINT)(Positions.size() * sizeof(TCompactPosition) + Attributes.size() * sizeof(TCompactAttributes)),
+		Error.MaxPositionError, Error.MaxNormalErrorDegrees, Error.MaxTangentErrorDegrees, Error.MaxUVError);
+	TLogger::LogToOutput(Log);
+}
 
-	// Create  SDF texture
-	TTextureInfo TextureInfo;
-	TextureInfo.Type = ETextureType::TEXTURE_3D;
-	TextureInfo.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
-	TextureInfo.Width = (UINT)(SDFResolution);
-	TextureInfo.Height = (UINT)(SDFResolution);
-	TextureInfo.Depth = (UINT)(SDFResolution);
-	TextureInfo.ArraySize = 1;
-	TextureInfo.MipCount = 1;
-	TextureInfo.Format = DXGI_FORMAT::DXGI_FORMAT_R8_UNORM;
+void TRender::SetMeshVertexBuffers(const TMeshProxy& MeshProxy, bool bPositionOnly)
+{
+	GeometryPool->SetVertexBuffers(MeshProxy.VertexArena, (MeshProxy.bCompactVertex && !bPositionOnly) ? 2 : 1);
+}
 
-	D3D12_SUBRESOURCE_DATA InitData;
-	InitData.pData = MeshSDF.data();
-	InitData.RowPitch = static_cast<LONG_PTR>(SDFResolution);
-	InitData.SlicePitch = InitData.RowPitch * SDFResolution;
+void TRender::SetMeshIndexBuffer(const TMeshProxy& MeshProxy)
+{
+	GeometryPool->SetIndexBuffer(MeshProxy.IndexArena);
+}
 
-	auto SDFTeture = std::make_unique<TTexture3D>("SDFTeture", false, L" ");
-	SDFTeture->SetTextureResourceDirectly(TextureInfo, MeshSDF, InitData);
-	SDFTeture->CreateTexture(D3D12RHI);
+void TRender::DrawMeshRanges(const TMeshProxy& MeshProxy, const std::vector<TMeshDrawRange>& Draws)
+{
+	for (const TMeshDrawRange& Draw : Draws)
+	{
+		CommandList->DrawIndexedInstanced(Draw.IndexCount, 1,
+			MeshProxy.IndexAllocation.Offset + Draw.StartIndexLocation, (INT)MeshProxy.VertexAllocation.Offset + Draw.BaseVertexLocation, 0);
+	}
+}
 
-	Mesh.SetSDFTexture(SDFTeture);
+void TRender::DrawMeshProxy(const TMeshProxy& MeshProxy)
+{
+	for (const TMeshSubmeshProxy& SubmeshProxy : MeshProxy.Submeshes)
+	{
+		DrawMeshRanges(MeshProxy, SubmeshProxy.Draws);
+	}
 }
 
-void GenerateUniformSphereSamples(UINT SampleCount, std::vector<TVector3>& Samples)
+void TRender::RelocateMeshProxys(EGeometryArena Arena, const std::vector<TOffsetMove>& Moves)
 {
-	// Generate Fibonacci lattice.
-	// Ref: https://stackoverflow.com/questions/9600801/evenly-distributing-n-points-on-a-sphere/26127012#26127012
+	std::unordered_map<UINT, UINT> NewOffsets;
+	for (const TOffsetMove& Move : Moves)
+	{
+		NewOffsets[Move.OldOffset] = Move.NewOffset;
+	}
 
-	const float Phi = TMath::Pi * (3.0f - sqrt(5.0f)); // Golden angle in radians
-	for (UINT i = 0; i < SampleCount; i++)
+	for (auto& Pair : MeshProxyMap)
 	{
-		TVector3 Sample;
-		Sample.y = 1 - (i / float(SampleCount - 1)) * 2;  // y goes from 1 to - 1
-		float Radius = sqrt(1.0f - Sample.y * Sample.y);  // Radius at y
+		TMeshProxy& MeshProxy = Pair.second;
 
-		float Theta = Phi * i;    // Golden angle increment
-		Sample.x = Radius * cos(Theta);
-		Sample.z = Radius * sin(Theta);
+		if (MeshProxy.VertexArena == Arena && NewOffsets.count(MeshProxy.VertexAllocation.Offset))
+		{
+			MeshProxy.VertexAllocation.Offset = NewOffsets[MeshProxy.VertexAllocation.Offset];
+		}
 
-		Samples.push_back(Sample);
+		if (MeshProxy.IndexArena == Arena && NewOffsets.count(MeshProxy.IndexAllocation.Offset))
+		{
+			MeshProxy.IndexAllocation.Offset = NewOffsets[MeshProxy.IndexAllocation.Offset];
+		}
 	}
 }
 
-void TRender::BulidMeshSDF(TMesh& Mesh, std::vector<uint8_t>& OutMeshSDF)
+void TRender::CreateMeshSDFBricks(TMesh& Mesh)
 {
-	std::vector<uint32_t>& Indices = Mesh.Indices32;
-	std::vector<TVertex>& Vertices = Mesh.Vertices;
-	UINT IndiceCount = (UINT)Indices.size();
-	UINT TriangleCount = IndiceCount / 3;
+	std::vector<uint8_t> MeshSDF;
 
-	// Get all triangles
-	std::vector<std::shared_ptr<TPrimitive>> BuildTriangles;
-	for (UINT i = 0; i < TriangleCount; i++) 
+	// The bake key covers the SDF placement, so make sure it is set before looking up the cache
+	if (!Mesh.BoundingBox.bInit)
 	{
-		// Indices for this triangle.
-		UINT i0 = Indices[i * 3 + 0];
-		UINT i1 = Indices[i * 3 + 1];
-		UINT i2 = Indices[i * 3 + 2];
+		Mesh.GenerateBoundingBox();
+	}
 
-		// Vertices for this triangle.
-		TVector3 v0 = Vertices[i0].Position;
-		TVector3 v1 = Vertices[i1].Position;
-		TVector3 v2 = Vertices[i2].Position;
+	// Normally baked by the asset cooker, missing or stale files are rebaked and saved here
+	std::wstring MeshSDFPath = GetMeshSDFPath(Mesh.MeshName);
+	TMeshSDFBakeKey BakeKey = GetMeshSDFBakeKey(Mesh);
+	if (!LoadMeshSDF(MeshSDFPath, BakeKey, MeshSDF))
+	{
+		char Message[256];
+		sprintf_s(Message, "Baking mesh SDF of %s, the cached file is missing or stale\n", Mesh.MeshName.c_str());
+		TLogger::LogToOutput(Message);
 
-		auto Triangle = std::make_shared<TTriangle>(v0, v1, v2, TColor::Black);
-		Triangle->GenerateBoundingBox();
+		BuildMeshSDF(Mesh, MeshSDF, TThreadPool::Get());
 
-		BuildTriangles.push_back(Triangle);
+		SaveMeshSDF(MeshSDFPath, BakeKey, MeshSDF);
 	}
 
-	// Bulid kd-tree
-	auto KdTree = std::make_unique<TKdTreeAccelerator>(std::move(BuildTriangles));
+	const int* SDFResolution = Mesh.SDFDescriptor.Resolution;
 
-	// Build SDF
-	TVector3 SDFCenter = Mesh.BoundingBox.GetCenter();
-	float SDFWidth = Mesh.BoundingBox.GetMaxWidth() * 1.4f;
-	const int SDFResolution = 32;
-	float SDFUnit = SDFWidth / SDFResolution;
-	const int SampleCount = 256;
+	// Only the narrow band around the surface goes to the shared atlas
+	TSparseMeshSDF SparseSDF;
+	BuildSparseMeshSDF(MeshSDF, SDFResolution, SDFBrickBandVoxels, SparseSDF);
 
-	std::vector<float> SDF;
-	SDF.resize(SDFResolution * SDFResolution * SDFResolution);
+	SDFBrickAtlas->RemoveMesh(Mesh.SDFBrickIndirection);
+	SDFBrickAtlas->AddMesh(SparseSDF, Mesh.SDFBrickIndirection);
 
-	for (int z = 0; z < SDFResolution; z++)
+#ifdef _DEBUG
+	// Check the atlas lookup the shaders mirror against the dense volume, it samples every voxel so release loads skip it
+	TSparseSDFValidation Validation = ValidateSparseMeshSDF(MeshSDF, SDFResolution, *SDFBrickAtlas, Mesh.SDFBrickIndirection);
+	if (Validation.MaxStoredError > 0.01f || Validation.NonConservativeCount > 0)
 	{
-		for (int y = 0; y < SDFResolution; y++)
-		{
-			for (int x = 0; x < SDFResolution; x++)
-			{
-				TVector3 RayOrigin(
-					((float)x - SDFResolution / 2 + 0.5f) * SDFUnit + SDFCenter.x,
-					((float)y - SDFResolution / 2 + 0.5f) * SDFUnit + SDFCenter.y,
-					((float)z - SDFResolution / 2 + 0.5f) * SDFUnit + SDFCenter.z
-				);
+		char Message[512];
+		sprintf_s(Message, "Mesh SDF bricks of %s don't match the dense volume: %s\n", Mesh.MeshName.c_str(), Validation.ToString().c_str());
+		TLogger::LogToOutput(Message);
+	}
+#endif
 
-				float MinDistance = TMath::Infinity;
-				int FrontCount = 0;
-				int BackCount = 0;
+	{
+		char Message[256];
+		sprintf_s(Message, "Mesh SDF of %s: %dx%dx%d voxels of %.4f (%.1f per unit), %u bricks\n", Mesh.MeshName.c_str(),
+			SDFResolution[0], SDFResolution[1], SDFResolution[2], Mesh.SDFDescriptor.VoxelSize,
+			1.0f / Mesh.SDFDescriptor.VoxelSize, SparseSDF.GetStoredBrickCount());
+		TLogger::LogToOutput(Message);
+	}
 
-				std::vector<TVector3> SampleDirections;
-				GenerateUniformSphereSamples(SampleCount, SampleDirections);
+	SDFDenseBytes += MeshSDF.size();
+}
 
-				// Fibonacci lattices.
-				for (int i = 0; i < SampleCount; i++)
-				{
-					TVector3 RayDirection = SampleDirections[i];
+void TRender::CreateSDFBrickAtlasTexture()
+{
+	if (!SDFBrickAtlas->IsDirty() || SDFBrickAtlas->GetSlotsZ() == 0)
+	{
+		return;
+	}
 
-					// Ray-Triangle Intersection test with kd-tree
-					float Dist;
-					bool bBackFace;
-					if (KdTree->Intersect(TRay(RayOrigin, RayDirection), Dist, bBackFace))
-					{
-						if (Dist < MinDistance)
-						{
-							MinDistance = Dist;
-						}
-
-						if (bBackFace)
-						{
-							BackCount++;
-						}
-						else
-						{
-							FrontCount++;
-						}
-					}
-				}
+	TTextureInfo TextureInfo;
+	TextureInfo.Type = ETextureType::TEXTURE_3D;
+	TextureInfo.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+	TextureInfo.Width = (UINT)SDFBrickAtlas->GetWidth();
+	TextureInfo.Height = (UINT)SDFBrickAtlas->GetHeight();
+	TextureInfo.Depth = (UINT)SDFBrickAtlas->GetDepth();
+	TextureInfo.ArraySize = 1;
+	TextureInfo.MipCount = 1;
+	TextureInfo.Format = DXGI_FORMAT::DXGI_FORMAT_R8_UNORM;
 
-				int SDFIndex = z * SDFResolution * SDFResolution + y * SDFResolution + x;
-				SDF[SDFIndex] = MinDistance;
-				if (BackCount > FrontCount)
-				{
-					SDF[SDFIndex] *= -1.0f;
-				}
-			}
-		}
-	}
+	// The atlas keeps its CPU copy for later meshes, the texture gets its own
+	std::vector<uint8_t> AtlasData = SDFBrickAtlas->GetData();
+
+	D3D12_SUBRESOURCE_DATA InitData;
+	InitData.pData = AtlasData.data();
+	InitData.RowPitch = static_cast<LONG_PTR>(TextureInfo.Width);
+	InitData.SlicePitch = InitData.RowPitch * TextureInfo.Height;
+
+	SDFBrickAtlasTexture = std::make_unique<TTexture3D>("SDFBrickAtlas", false, L" ");
+	SDFBrickAtlasTexture->SetTextureResourceDirectly(TextureInfo, std::move(AtlasData), InitData);
+	SDFBrickAtlasTexture->CreateTexture(D3D12RHI);
+
+	SDFBrickAtlas->ClearDirty();
 
-	// Draw SDF debug point
-	if (false)
+	// Object fields changed under the clipmap
+	GlobalDistanceField->Invalidate();
+
+	char Message[256];
+	sprintf_s(Message, "SDF brick atlas: %u bricks in %ux%ux%u texels (%.2f MB), dense volumes would take %.2f MB\n",
+		SDFBrickAtlas->GetUsedSlotCount(), TextureInfo.Width, TextureInfo.Height, TextureInfo.Depth,
+		SDFBrickAtlas->GetData().size() / (1024.0 * 1024.0), SDFDenseBytes / (1024.0 * 1024.0));
+	TLogger::LogToOutput(Message);
+}
+
+void TRender::SetSDFParameters(TShader* InShader)
+{
+	if (SDFBrickAtlasTexture)
 	{
-		for (int z = 0; z < SDFResolution; z++)
-		{
-			for (int y = 0; y < SDFResolution; y++)
-			{
-				for (int x = 0; x < SDFResolution; x++)
-				{
-					TVector3 DrawCenter(-5.0f, 2.0f, 0.0f);
-					float DrawUnit = SDFUnit * 0.5f;
-					TVector3 DrawPosition(
-						((float)x - SDFResolution / 2 + 0.5f) * DrawUnit + DrawCenter.x,
-						((float)y - SDFResolution / 2 + 0.5f) * DrawUnit + DrawCenter.y,
-						((float)z - SDFResolution / 2 + 0.5f) * DrawUnit + DrawCenter.z
-					);
-
-					int SDFIndex = z * SDFResolution * SDFResolution + y * SDFResolution + x;
-
-					float SDFValue = SDF[SDFIndex];
-					if (std::abs(SDFValue) < 0.1f)
-					{
-						World->DrawPoint(DrawPosition, TColor::Red, 3);
-					}
-				}
-			}
-		}
+		InShader->SetParameter("SDFBrickAtlas", SDFBrickAtlasTexture->D3DTexture->GetSRV());
 	}
-
-	// Convert to EightBitFixedPoint(uint8)
-	std::vector<uint8_t> QuantizedSDF;
-	QuantizedSDF.resize(SDFResolution * SDFResolution * SDFResolution);
-	for (int Index = 0; Index < SDF.size(); Index++)
+	else
 	{
-		if (SDF[Index] == TMath::Infinity)
-		{
-			QuantizedSDF[Index] = 255;
-		}
-		else
-		{
-			// Convert to range [-1, 1]
-			float Value = SDF[Index] / SDFWidth;
-
-			// Convert to range [0, 1]
-			Value = Value * 0.5f + 0.5f;
+		InShader->SetParameter("SDFBrickAtlas", Texture3DNullDescriptor.get());
+	}
 
-			// Covert to range [0, 255], based on D3D format conversion rules for DXGI_FORMAT_R8_UNORM
-			int QuantizedValue = int(Value * 255.0f + .5f);
-			QuantizedSDF[Index] = (UINT8)std::clamp(QuantizedValue, 0, 255);
-		}
+	if (SDFBrickIndirectionBuffer)
+	{
+		InShader->SetParameter("SDFBrickIndirection", SDFBrickIndirectionBuffer->GetSRV());
+	}
+	else
+	{
+		InShader->SetParameter("SDFBrickIndirection", StructuredBufferNullDescriptor.get());
 	}
 
-	std::swap(QuantizedSDF, OutMeshSDF);
+	if (SDFObjectGridCellBuffer)
+	{
+		InShader->SetParameter("SDFObjectGridCells", SDFObjectGridCellBuffer->GetSRV());
+		InShader->SetParameter("SDFObjectGridIndices", SDFObjectGridIndexBuffer->GetSRV());
+	}
+	else
+	{
+		InShader->SetParameter("SDFObjectGridCells", StructuredBufferNullDescriptor.get());
+		InShader->SetParameter("SDFObjectGridIndices", StructuredBufferNullDescriptor.get());
+	}
 
-	// Save SDFDescriptor
-	Mesh.SDFDescriptor.Center = SDFCenter;
-	Mesh.SDFDescriptor.Extent = SDFWidth * 0.5f;
-	Mesh.SDFDescriptor.Resolution = SDFResolution;
+	std::vector<TD3D12ShaderResourceView*> GlobalSDFSRVs;
+	for (int LevelIndex = 0; LevelIndex < GlobalSDFLevelCount; LevelIndex++)
+	{
+		GlobalSDFSRVs.push_back(GlobalSDFTextures[LevelIndex]->GetSRV());
+	}
+	InShader->SetParameter("GlobalSDFLevels", GlobalSDFSRVs);
 }
 
 void TRender::CreateInputLayouts()
@@ -589,6 +818,25 @@ void TRender::CreateInputLayouts()
 	};
 
 	InputLayoutManager.AddInputLayout("PositionTexcoordInputLayout", PositionTexcoordInputLayout);
+
+	//CompactInputLayout, see VertexQuantization.h
+	std::vector<D3D12_INPUT_ELEMENT_DESC> CompactInputLayout =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 1, 4, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 1, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
+
+	InputLayoutManager.AddInputLayout("CompactInputLayout", CompactInputLayout);
+
+	//CompactPositionInputLayout, depth-only passes fetch just the position stream
+	std::vector<D3D12_INPUT_ELEMENT_DESC> CompactPositionInputLayout =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
+
+	InputLayoutManager.AddInputLayout("CompactPositionInputLayout", CompactPositionInputLayout);
 }
 
 void TRender::CreateGlobalShaders()
@@ -630,26 +878,6 @@ void TRender::CreateGlobalShaders()
 		IBLEnvironmentShader = std::make_unique<TShader>(ShaderInfo, D3D12RHI);
 	}
 
-	if(bEnableIBLEnvLighting)
-	{
-		TShaderInfo ShaderInfo;
-		ShaderInfo.ShaderName = "IBLIrradiance";
-		ShaderInfo.FileName = "IBLIrradiance";
-		ShaderInfo.bCreateVS = true;
-		ShaderInfo.bCreatePS = true;
-		IBLIrradianceShader = std::make_unique<TShader>(ShaderInfo, D3D12RHI);
-	}
-
-	if(bEnableIBLEnvLighting)
-	{
-		TShaderInfo ShaderInfo;
-		ShaderInfo.ShaderName = "IBLPrefilterEnv";
-		ShaderInfo.FileName = "IBLPrefilterEnv";
-		ShaderInfo.bCreateVS = true;
-		ShaderInfo.bCreatePS = true;
-		IBLPrefilterEnvShader = std::make_unique<TShader>(ShaderInfo, D3D12RHI);
-	}
-
 	{
 		TShaderInfo ShaderInfo;
 		ShaderInfo.ShaderName = "DeferredLighting";
@@ -812,36 +1040,6 @@ void TRender::CreateGlobalPSO()
 		GraphicsPSOManager->TryCreatePSO(IBLEnvironmentPSODescriptor);
 	}
 
-	// IBLIrradiance PSO
-	if(bEnableIBLEnvLighting)
-	{	
-		IBLIrradiancePSODescriptor.InputLayoutName = std::string("DefaultInputLayout");
-		IBLIrradiancePSODescriptor.Shader = IBLIrradianceShader.get();
-		IBLIrradiancePSODescriptor.RTVFormats[0] = IBLIrradianceMap->GetRTCube()->GetFormat();
-		IBLIrradiancePSODescriptor.NumRenderTargets = 1;
-		// The camera is inside the cube, so just turn off culling.
-		IBLIrradiancePSODescriptor.RasterizerDesc.CullMode = D3D12_CULL_MODE_NONE;
-		IBLIrradiancePSODescriptor.DepthStencilDesc.DepthEnable = false;
-		IBLIrradiancePSODescriptor.DepthStencilFormat = DXGI_FORMAT_UNKNOWN;
-
-		GraphicsPSOManager->TryCreatePSO(IBLIrradiancePSODescriptor);
-	}
-
-	// IBLPrefilterEnv PSO
-	if(bEnableIBLEnvLighting)
-	{
-		IBLPrefilterEnvPSODescriptor.InputLayoutName = std::string("DefaultInputLayout");
-		IBLPrefilterEnvPSODescriptor.Shader = IBLPrefilterEnvShader.get();
-		IBLPrefilterEnvPSODescriptor.RTVFormats[0] = IBLPrefilterEnvMaps[0]->GetRTCube()->GetFormat();
-		IBLPrefilterEnvPSODescriptor.NumRenderTargets = 1;
-		// The camera is inside the cube, so just turn off culling.
-		IBLPrefilterEnvPSODescriptor.RasterizerDesc.CullMode = D3D12_CULL_MODE_NONE;
-		IBLPrefilterEnvPSODescriptor.DepthStencilDesc.DepthEnable = false;
-		IBLPrefilterEnvPSODescriptor.DepthStencilFormat = DXGI_FORMAT_UNKNOWN;
-
-		GraphicsPSOManager->TryCreatePSO(IBLPrefilterEnvPSODescriptor);
-	}
-
 	// DeferredLighting
 	{
 		D3D12_DEPTH_STENCIL_DESC lightPassDSD;
@@ -1104,15 +1302,14 @@ void TRender::Draw(const GameTimer& gt)
 
 	if (bEnableIBLEnvLighting && FrameCount == 0)
 	{
+		// Only the sky needs the cubemap, lighting data comes from CreateIBLLightingData
 		CreateIBLEnviromentMap();
-
-		CreateIBLIrradianceMap();
-
-		CreateIBLPrefilterEnvMap();
 	}
 
 	GatherAllMeshBatchs();
 
+	UpdateTextureStreaming();
+
 	UpdateLightData();
 
 	ShadowPass();
@@ -1170,6 +1367,9 @@ void TRender::EndFrame()
 {
 	D3D12RHI->EndFrame();
 
+	// Draw flushed the queue, copies out of replaced pool buffers are done
+	GeometryPool->ReleaseRetiredBuffers();
+
 	FrameCount++;
 }
 
@@ -1247,173 +1447,21 @@ void TRender::CreateIBLEnviromentMap()
 			const TMeshProxy& MeshProxy = MeshProxyMap.at("BoxMesh");
 
 			// Set vertex buffer
-			D3D12RHI->SetVertexBuffer(MeshProxy.VertexBufferRef, 0, MeshProxy.VertexByteStride, MeshProxy.VertexBufferByteSize);
+			SetMeshVertexBuffers(MeshProxy, false);
 
 			// Set index buffer
-			D3D12RHI->SetIndexBuffer(MeshProxy.IndexBufferRef, 0, MeshProxy.IndexFormat, MeshProxy.IndexBufferByteSize);
+			SetMeshIndexBuffer(MeshProxy);
 
 			D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 			CommandList->IASetPrimitiveTopology(PrimitiveType);
 
 			// Draw 
-			auto& SubMesh = MeshProxy.SubMeshs.at("Default");
-			CommandList->DrawIndexedInstanced(SubMesh.IndexCount, 1, SubMesh.StartIndexLocation, SubMesh.BaseVertexLocation, 0);
-		}
-	}
-
-	// Change back to GENERIC_READ so we can read the texture in a shader.
-	D3D12RHI->TransitionResource(IBLEnvironmentMap->GetRTCube()->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
-}
-
-void TRender::UpdateIBLIrradiancePassCB()
-{
-	for (int i = 0; i < 6; i++)
-	{
-		TMatrix View = IBLIrradianceMap->GetSceneView(i).View;
-		TMatrix Proj = IBLIrradianceMap->GetSceneView(i).Proj;
-
-		PassConstants PassCB;
-		PassCB.View = View.Transpose();
-		PassCB.Proj = Proj.Transpose();
-
-		IBLIrradiancePassCBRef[i] = D3D12RHI->CreateConstantBuffer(&PassCB, sizeof(PassCB));
-	}
-}
-
-void TRender::CreateIBLIrradianceMap()
-{
-	UpdateIBLIrradiancePassCB();
-
-	D3D12RHI->TransitionResource(IBLIrradianceMap->GetRTCube()->GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET);
-
-	// Set viewport
-	CommandList->RSSetViewports(1, &IBLIrradianceMap->GetViewport());
-	CommandList->RSSetScissorRects(1, &IBLIrradianceMap->GetScissorRect());
-
-	// Set PSO
-	CommandList->SetPipelineState(GraphicsPSOManager->GetPSO(IBLIrradiancePSODescriptor));
-
-	// Set RootSignature
-	TShader* Shader = IBLIrradiancePSODescriptor.Shader;
-	CommandList->SetGraphicsRootSignature(Shader->RootSignature.Get()); //should before binding
-
-	for (UINT i = 0; i < 6; i++)
-	{
-		// Set renderTarget
-		auto RTV = IBLIrradianceMap->GetRTCube()->GetRTV(i);
-		float* ClearValue = IBLIrradianceMap->GetRTCube()->GetClearColorPtr();
-		CommandList->ClearRenderTargetView(RTV->GetDescriptorHandle(), ClearValue, 0, nullptr);
-		CommandList->OMSetRenderTargets(1, &RTV->GetDescriptorHandle(), true, nullptr);
-
-		// Draw Box
-		{
-			Shader->SetParameter("cbPass", IBLIrradiancePassCBRef[i]);
-	
-			TD3D12ShaderResourceView* EnvironmentSRV = IBLEnvironmentMap->GetRTCube()->GetSRV();
-			Shader->SetParameter("EnvironmentMap", EnvironmentSRV);
-
-			// Bind paramters
-			Shader->BindParameters();
-
-			const TMeshProxy& MeshProxy = MeshProxyMap.at("BoxMesh");
-
-			// Set vertex buffer
-			D3D12RHI->SetVertexBuffer(MeshProxy.VertexBufferRef, 0, MeshProxy.VertexByteStride, MeshProxy.VertexBufferByteSize);
-
-			// Set index buffer
-			D3D12RHI->SetIndexBuffer(MeshProxy.IndexBufferRef, 0, MeshProxy.IndexFormat, MeshProxy.IndexBufferByteSize);
-
-			D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-			CommandList->IASetPrimitiveTopology(PrimitiveType);
-
-			// Draw 
-			auto& SubMesh = MeshProxy.SubMeshs.at("Default");
-			CommandList->DrawIndexedInstanced(SubMesh.IndexCount, 1, SubMesh.StartIndexLocation, SubMesh.BaseVertexLocation, 0);
-		}
-	}
-
-	// Change back to GENERIC_READ so we can read the texture in a shader.
-	D3D12RHI->TransitionResource(IBLIrradianceMap->GetRTCube()->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
-}
-
-void TRender::UpdateIBLPrefilterEnvCB()
-{
-	for (UINT Mip = 0; Mip < IBLPrefilterMaxMipLevel; Mip++)
-	{
-		float Roughness = (float)Mip / (float)(IBLPrefilterMaxMipLevel - 1);
-
-		for (UINT i = 0; i < 6; i++)
-		{
-			TMatrix View = IBLPrefilterEnvMaps[Mip]->GetSceneView(i).View;
-			TMatrix Proj = IBLPrefilterEnvMaps[Mip]->GetSceneView(i).Proj;
-
-			PrefilterEnvironmentConstant PassCB;
-			PassCB.View = View.Transpose();
-			PassCB.Proj = Proj.Transpose();
-			PassCB.Roughness = Roughness;
-
-			IBLPrefilterEnvPassCBRef[Mip * 6 + i] = D3D12RHI->CreateConstantBuffer(&PassCB, sizeof(PassCB));
-		}
-	}
-}
-
-void TRender::CreateIBLPrefilterEnvMap()
-{
-	UpdateIBLPrefilterEnvCB();
-
-	for (UINT Mip = 0; Mip < IBLPrefilterMaxMipLevel; Mip++)
-	{
-		D3D12RHI->TransitionResource(IBLPrefilterEnvMaps[Mip]->GetRTCube()->GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET);
-
-		// Set viewport
-		CommandList->RSSetViewports(1, &IBLPrefilterEnvMaps[Mip]->GetViewport());
-		CommandList->RSSetScissorRects(1, &IBLPrefilterEnvMaps[Mip]->GetScissorRect());
-
-		// Set PSO
-		CommandList->SetPipelineState(GraphicsPSOManager->GetPSO(IBLPrefilterEnvPSODescriptor));
-
-		// Set RootSignature
-		CommandList->SetGraphicsRootSignature(IBLPrefilterEnvShader->RootSignature.Get()); //should before binding	
-
-		for (UINT i = 0; i < 6; i++)
-		{
-			// Set renderTarget
-			auto RTV = IBLPrefilterEnvMaps[Mip]->GetRTCube()->GetRTV(i);
-			float* ClearValue = IBLPrefilterEnvMaps[Mip]->GetRTCube()->GetClearColorPtr();
-			CommandList->ClearRenderTargetView(RTV->GetDescriptorHandle(), ClearValue, 0, nullptr);
-			CommandList->OMSetRenderTargets(1, &RTV->GetDescriptorHandle(), true, nullptr);
-
-			// Draw Box
-			{
-				IBLPrefilterEnvShader->SetParameter("cbPrefilterEnvPass", IBLPrefilterEnvPassCBRef[Mip * 6 + i]);
-
-
-				TD3D12ShaderResourceView* EnvironmentSRV = IBLEnvironmentMap->GetRTCube()->GetSRV();
-				IBLPrefilterEnvShader->SetParameter("EnvironmentMap", EnvironmentSRV);
-
-				// Bind paramters
-				IBLPrefilterEnvShader->BindParameters();
-
-				const TMeshProxy& MeshProxy = MeshProxyMap.at("BoxMesh");
-
-				// Set vertex buffer
-				D3D12RHI->SetVertexBuffer(MeshProxy.VertexBufferRef, 0, MeshProxy.VertexByteStride, MeshProxy.VertexBufferByteSize);
-
-				// Set index buffer
-				D3D12RHI->SetIndexBuffer(MeshProxy.IndexBufferRef, 0, MeshProxy.IndexFormat, MeshProxy.IndexBufferByteSize);
-
-				D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-				CommandList->IASetPrimitiveTopology(PrimitiveType);
-
-				// Draw 
-				auto& SubMesh = MeshProxy.SubMeshs.at("Default");
-				CommandList->DrawIndexedInstanced(SubMesh.IndexCount, 1, SubMesh.StartIndexLocation, SubMesh.BaseVertexLocation, 0);
-			}
+			DrawMeshProxy(MeshProxy);
 		}
-
-		// Change back to GENERIC_READ so we can read the texture in a shader.
-		D3D12RHI->TransitionResource(IBLPrefilterEnvMaps[Mip]->GetRTCube()->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
 	}
+
+	// Change back to GENERIC_READ so we can read the texture in a shader.
+	D3D12RHI->TransitionResource(IBLEnvironmentMap->GetRTCube()->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
 }
 
 void TRender::GatherAllMeshBatchs()
@@ -1453,6 +1501,7 @@ void TRender::GatherAllMeshBatchs()
 	//World->DrawString(11, "Mesh count before culling: " + std::to_string(AllMeshComponents.size()), 0.1f);
 
 	std::vector<TMeshComponent*> MeshComponentsAfterCulling;
+	std::vector<BoundingFrustum> LocalSpaceFrustums;
 	for (auto MeshComponent : AllMeshComponents)
 	{		
 		TMatrix WorldToLocal = MeshComponent->GetWorldTransform().GetTransformMatrix().Invert();
@@ -1473,25 +1522,37 @@ void TRender::GatherAllMeshBatchs()
 			if (LocalSpaceFrustum.Contains(BoundingBox.GetD3DBox()) != DirectX::DISJOINT)
 			{
 				MeshComponentsAfterCulling.push_back(MeshComponent);
+				LocalSpaceFrustums.push_back(LocalSpaceFrustum);
 			}
 		}
 		else
 		{
 			MeshComponentsAfterCulling.push_back(MeshComponent);
+			LocalSpaceFrustums.push_back(LocalSpaceFrustum);
 		}
 	}
 
 	//World->DrawString(12, "Mesh count after culling: " + std::to_string(MeshComponentsAfterCulling.size()), 0.1f);
 
 
-	// Generate MeshBatchs
-	for (auto MeshComponent : MeshComponentsAfterCulling)
+	// Cluster culling works in mesh space with the camera view-projection
+	TMatrix ViewProj = CameraComponent->GetView() * CameraComponent->GetProj();
+	TVector3 CameraLocation = CameraComponent->GetWorldLocation();
+
+	ClusterCullStats = TMeshletCullStats();
+	ClusterCullTime = 0.0;
+
+	D3D12_VIEWPORT ScreenViewport;
+	D3D12_RECT ScissorRect;
+	D3D12RHI->GetViewport()->GetD3DViewport(ScreenViewport, ScissorRect);
+
+	// Generate MeshBatchs, one per submesh
+	for (size_t ComponentIdx = 0; ComponentIdx < MeshComponentsAfterCulling.size(); ComponentIdx++)
 	{
+		TMeshComponent* MeshComponent = MeshComponentsAfterCulling[ComponentIdx];
 		std::string MeshName = MeshComponent->GetMeshName();
 
-		TMeshBatch MeshBatch;
-		MeshBatch.MeshName = MeshName;
-		MeshBatch.InputLayoutName = TMeshRepository::Get().MeshMap.at(MeshName).GetInputLayoutName();
+		const TMeshProxy& MeshProxy = MeshProxyMap.at(MeshName);
 
 		//Create Object ConstantBuffer		
 		TMatrix World = MeshComponent->GetWorldTransform().GetTransformMatrix();
@@ -1502,14 +1563,164 @@ void TRender::GatherAllMeshBatchs()
 		ObjConst.World = World.Transpose();
 		ObjConst.PrevWorld = PrevWorld.Transpose();
 		ObjConst.TexTransform = TexTransform.Transpose();
-		MeshBatch.ObjConstantBuffer = D3D12RHI->CreateConstantBuffer(&ObjConst, sizeof(ObjConst));
+		ObjConst.PosDequantMin = MeshProxy.PositionDequantMin;
+		ObjConst.PosDequantExtent = MeshProxy.PositionDequantExtent;
+		TD3D12ConstantBufferRef ObjConstantBuffer = D3D12RHI->CreateConstantBuffer(&ObjConst, sizeof(ObjConst));
+
+		// Base and back depth passes draw the camera LOD, meshlets only cover LOD0
+		UINT LODIndex = SelectMeshLOD(MeshProxy, World, CameraComponent->GetView(), CameraComponent->GetProj(), ScreenViewport.Height);
+
+		for (UINT SubmeshIdx = 0; SubmeshIdx < (UINT)MeshProxy.Submeshes.size(); SubmeshIdx++)
+		{
+			const TMeshSubmeshProxy& SubmeshProxy = MeshProxy.Submeshes[SubmeshIdx];
+
+			// Whole mesh passed, submeshes of large meshes can still be outside
+			if (bEnableFrustumCulling && MeshProxy.Submeshes.size() > 1
+				&& LocalSpaceFrustums[ComponentIdx].Contains(SubmeshProxy.Bounds) == DirectX::DISJOINT)
+			{
+				continue;
+			}
+
+			TMeshBatch MeshBatch;
+			MeshBatch.MeshName = MeshName;
+			MeshBatch.InputLayoutName = TMeshRepository::Get().MeshMap.at(MeshName).GetInputLayoutName();
+			MeshBatch.bCompactVertex = MeshProxy.bCompactVertex;
+			MeshBatch.ObjConstantBuffer = ObjConstantBuffer;
+			MeshBatch.MeshComponent = MeshComponent;
+			MeshBatch.SubmeshIndex = SubmeshIdx;
+			MeshBatch.MaterialInstance = MeshComponent->GetMaterialInstance(SubmeshProxy.MaterialSlot);
+			MeshBatch.bUseSDF = MeshComponent->bUseSDF;
+			MeshBatch.World = World;
+			MeshBatch.LODIndex = LODIndex;
+
+			if (bEnableClusterCulling && !SubmeshProxy.Meshlets.empty() && MeshBatch.LODIndex == 0)
+			{
+				CullMeshClusters(MeshBatch, SubmeshProxy.Meshlets, World * ViewProj, World.Invert().Transform(CameraLocation));
+			}
+
+			//Add to list
+			MeshBatchs.emplace_back(MeshBatch);
+		}
+	}
+
+	if (RenderSettings.bDrawDebugText && ClusterCullStats.MeshletCount > 0)
+	{
+		World->DrawString(8, "Cluster culling: " + std::to_string(ClusterCullStats.VisibleMeshletCount) + "/" + std::to_string(ClusterCullStats.MeshletCount)
+			+ " clusters, " + std::to_string(ClusterCullStats.VisibleTriangleCount) + "/" + std::to_string(ClusterCullStats.TriangleCount)
+			+ " triangles, " + std::to_string((int)ClusterCullTime) + " us", 0.1f);
+	}
+}
+
+UINT TRender::SelectMeshLOD(const TMeshProxy& MeshProxy, const TMatrix& World, const TMatrix& View, const TMatrix& Proj, float ViewportHeight)
+{
+	if (!bEnableMeshLOD || MeshProxy.LODs.empty())
+	{
+		return 0;
+	}
+
+	// Largest axis scale of the world transform
+	TVector3 AxisX(World._11, World._12, World._13);
+	TVector3 AxisY(World._21, World._22, World._23);
+	TVector3 AxisZ(World._31, World._32, World._33);
+	float Scale = std::max<float>(AxisX.Length(), std::max<float>(AxisY.Length(), AxisZ.Length()));
+
+	// Pixels covered by one world unit at the nearest point of the bounds
+	float PixelsPerUnit = Proj._22 * ViewportHeight * 0.5f;
+
+	const bool bPerspective = Proj._34 != 0.0f;
+	if (bPerspective)
+	{
+		TMatrix WorldView = World * View;
+		TVector3 CenterV = WorldView.Transform(MeshProxy.BoundsCenter);
+
+		float Depth = CenterV.z - MeshProxy.BoundsRadius * Scale;
+		if (Depth <= 0.0f)
+		{
+			return 0;
+		}
+
+		PixelsPerUnit /= Depth;
+	}
+
+	// Coarsest LOD whose error stays below the pixel threshold
+	UINT LODIndex = 0;
+	for (UINT i = 0; i < (UINT)MeshProxy.LODs.size(); i++)
+	{
+		if (MeshProxy.LODs[i].Error * Scale * PixelsPerUnit > LODPixelError)
+		{
+			break;
+		}
+
+		LODIndex = i + 1;
+	}
+
+	return LODIndex;
+}
+
+void TRender::GetMeshDraws(const TMeshProxy& MeshProxy, UINT SubmeshIndex, UINT LODIndex, std::vector<TMeshDrawRange>& OutDraws)
+{
+	OutDraws.clear();
+
+	const TMeshSubmeshProxy& SubmeshProxy = MeshProxy.Submeshes[SubmeshIndex];
+
+	if (LODIndex > 0)
+	{
+		OutDraws.push_back(SubmeshProxy.LODDraws[LODIndex - 1]);
+		return;
+	}
+
+	OutDraws = SubmeshProxy.Draws;
+}
+
+void TRender::CullMeshClusters(TMeshBatch& MeshBatch, const std::vector<TMeshlet>& Meshlets, const TMatrix& LocalToClip, const TVector3& LocalCameraPosition)
+{
+	TMeshletCullParams Params;
+	memcpy(Params.LocalToClip, &LocalToClip.m[0][0], sizeof(Params.LocalToClip));
+	Params.LocalCameraPosition[0] = LocalCameraPosition.x;
+	Params.LocalCameraPosition[1] = LocalCameraPosition.y;
+	Params.LocalCameraPosition[2] = LocalCameraPosition.z;
+
+	// Back facing clusters are only invisible when the material culls back faces
+	auto MaterialInstance = MeshBatch.MaterialInstance;
+	Params.bConeCulling = MaterialInstance->Material->RenderState.CullMode == D3D12_CULL_MODE_BACK;
+
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	std::vector<uint32_t> VisibleMeshlets;
+	TMeshletCullStats Stats = CullMeshlets(Meshlets, Params, VisibleMeshlets);
+
+	auto EndTime = std::chrono::high_resolution_clock::now();
+	ClusterCullTime += std::chrono::duration<double, std::micro>(EndTime - StartTime).count();
+
+	ClusterCullStats.MeshletCount += Stats.MeshletCount;
+	ClusterCullStats.VisibleMeshletCount += Stats.VisibleMeshletCount;
+	ClusterCullStats.TriangleCount += Stats.TriangleCount;
+	ClusterCullStats.VisibleTriangleCount += Stats.VisibleTriangleCount;
 
-		MeshBatch.MeshComponent = MeshComponent;
-		MeshBatch.bUseSDF = MeshComponent->bUseSDF;
+	// Merge neighbouring visible meshlets into one draw
+	MeshBatch.bClusterCulled = true;
+	MeshBatch.ClusterDraws.clear();
 
-		//Add to list
-		MeshBatchs.emplace_back(MeshBatch);
-	}	
+	for (uint32_t MeshletIdx : VisibleMeshlets)
+	{
+		const TMeshlet& Meshlet = Meshlets[MeshletIdx];
+
+		if (!MeshBatch.ClusterDraws.empty())
+		{
+			TMeshDrawRange& Last = MeshBatch.ClusterDraws.back();
+			if (Last.BaseVertexLocation == Meshlet.BaseVertex && Last.StartIndexLocation + Last.IndexCount == Meshlet.StartIndex)
+			{
+				Last.IndexCount += Meshlet.TriangleCount * 3;
+				continue;
+			}
+		}
+
+		TMeshDrawRange Draw;
+		Draw.StartIndexLocation = Meshlet.StartIndex;
+		Draw.IndexCount = Meshlet.TriangleCount * 3;
+		Draw.BaseVertexLocation = Meshlet.BaseVertex;
+		MeshBatch.ClusterDraws.push_back(Draw);
+	}
 }
 
 TMatrix TRender::TextureTransform()
@@ -1523,6 +1734,103 @@ TMatrix TRender::TextureTransform()
 	return T;
 }
 
+void TRender::UpdateTextureStreaming()
+{
+	TTextureStreamingManager* Manager = TextureStreamingManager.get();
+
+	auto StreamTexture = [this, Manager](const TTextureStreamingRequest& Request)
+	{
+		StreamingTextures[Request.TextureId]->CreateStreamedTexture(D3D12RHI, Request.FirstMip, [Manager, Request]()
+		{
+			Manager->OnRequestCompleted(Request.TextureId, Request.FirstMip);
+		});
+	};
+
+	// Upload the mips read back by the thread pool since the last frame
+	std::vector<TStreamingReload> Reloads;
+	{
+		std::lock_guard<std::mutex> Lock(StreamingReloadMutex);
+		Reloads.swap(CompletedStreamingReloads);
+	}
+
+	for (TStreamingReload& Reload : Reloads)
+	{
+		TTexture* Texture = StreamingTextures[Reload.Request.TextureId];
+		if (Reload.bSuccess && Texture->SetReloadedTextureResource(std::move(Reload.Resource)))
+		{
+			StreamTexture(Reload.Request);
+		}
+		else
+		{
+			std::string Message = "Failed to reload streamed texture " + Texture->Name + "\n";
+			TLogger::LogToOutput(Message.data());
+
+			Manager->OnRequestFailed(Reload.Request.TextureId);
+		}
+	}
+
+	TextureStreamingManager->BeginFrame();
+
+	// Feed screen-space footprint of every visible material texture
+	TCameraComponent* CameraComponent = World->GetCameraComponent();
+	TVector3 EyePos = CameraComponent->GetWorldLocation();
+	float PixelsPerWorldUnitAtUnitDistance = (float)WindowHeight / (2.0f * std::tan(0.5f * CameraComponent->GetFovY()));
+
+	for (const TMeshBatch& MeshBatch : MeshBatchs)
+	{
+		TMeshComponent* MeshComponent = MeshBatch.MeshComponent;
+
+		TBoundingBox WorldBox;
+		if (!MeshComponent->GetWorldBoundingBox(WorldBox))
+		{
+			continue;
+		}
+
+		// Distance to the nearest point of the bounds, clamped to the near plane
+		float Distance = (WorldBox.GetCenter() - EyePos).Length() - 0.5f * WorldBox.GetSize().Length();
+		Distance = std::max<float>(Distance, CameraComponent->GetNearZ());
+		float PixelsPerWorldUnit = PixelsPerWorldUnitAtUnitDistance / Distance;
+
+		TVector3 Scale = MeshComponent->GetWorldTransform().Scale;
+		float MaxScale = std::max<float>(std::abs(Scale.x), std::max<float>(std::abs(Scale.y), std::abs(Scale.z)));
+		float UVDensity = MeshProxyMap.at(MeshBatch.MeshName).UVDensity / std::max<float>(MaxScale, 1e-4f);
+
+		for (const auto& Pair : MeshBatch.MaterialInstance->Parameters.TextureMap)
+		{
+			auto Iter = StreamingTextureIds.find(Pair.second);
+			if (Iter != StreamingTextureIds.end())
+			{
+				TextureStreamingManager->ReportFootprint(Iter->second, UVDensity, PixelsPerWorldUnit);
+			}
+		}
+	}
+
+	std::vector<TTextureStreamingRequest> Requests;
+	TextureStreamingManager->Update(Requests);
+
+	for (const TTextureStreamingRequest& Request : Requests)
+	{
+		TTexture* Texture = StreamingTextures[Request.TextureId];
+		if (Texture->HasCPUMips(Request.FirstMip))
+		{
+			StreamTexture(Request);
+			continue;
+		}
+
+		// Mips above the tail were released after the last upload. Evictions read them too, there is no GPU to GPU
+		// copy of the resident mips. The texture stays pending in the manager until the reload is uploaded.
+		TThreadPool::Get().Enqueue([this, Texture, Request]()
+		{
+			TStreamingReload Reload;
+			Reload.Request = Request;
+			Reload.bSuccess = TTextureRepository::Get().ReloadTextureResource(*Texture, Reload.Resource);
+
+			std::lock_guard<std::mutex> Lock(StreamingReloadMutex);
+			CompletedStreamingReloads.push_back(std::move(Reload));
+		});
+	}
+}
+
 void TRender::UpdateLightData()
 {
 	std::vector<TLightShaderParameters> LightShaderParametersArray;
@@ -1742,7 +2050,7 @@ void TRender::UpdateShadowPassCB(const TSceneView& SceneView, UINT ShadowWidth,
 	ShadowPassCBRef = D3D12RHI->CreateConstantBuffer(&ShadowPassCB, sizeof(ShadowPassCB));
 }
 
-void TRender::GetShadowPassMeshCommandMap(EShadowMapType Type)
+void TRender::GetShadowPassMeshCommandMap(EShadowMapType Type, const TSceneView& SceneView, UINT ShadowMapSize)
 {
 	ShadowMeshCommandMap.clear();
 
@@ -1752,7 +2060,12 @@ void TRender::GetShadowPassMeshCommandMap(EShadowMapType Type)
 		TMeshCommand MeshCommand;
 		MeshCommand.MeshName = MeshBatch.MeshName;
 
-		auto MaterialInstance = MeshBatch.MeshComponent->GetMaterialInstance();
+		// LOD by the shadow view's projected error
+		const TMeshProxy& MeshProxy = MeshProxyMap.at(MeshBatch.MeshName);
+		UINT LODIndex = SelectMeshLOD(MeshProxy, MeshBatch.World, SceneView.View, SceneView.Proj, (float)ShadowMapSize);
+		GetMeshDraws(MeshProxy, MeshBatch.SubmeshIndex, LODIndex, MeshCommand.Draws);
+
+		auto MaterialInstance = MeshBatch.MaterialInstance;
 		// Get material constanct buffer
 		if (MaterialInstance->MaterialConstantBuffer == nullptr)
 		{
@@ -1766,7 +2079,7 @@ void TRender::GetShadowPassMeshCommandMap(EShadowMapType Type)
 
 		// Get PSO descriptor of this mesh
 		TGraphicsPSODescriptor Descriptor;
-		Descriptor.InputLayoutName = MeshBatch.InputLayoutName;
+		Descriptor.InputLayoutName = MeshBatch.bCompactVertex ? "CompactPositionInputLayout" : MeshBatch.InputLayoutName;
 		if (Type == EShadowMapType::SM_SINGLE)
 		{
 			Descriptor.Shader = SingleShadowMapShader.get();
@@ -1846,7 +2159,7 @@ void TRender::GenerateSingleShadowMap(TShadowMap2D* ShadowMap)
 {
 	UpdateShadowPassCB(ShadowMap->GetSceneView(), ShadowMap->GetWidth(), ShadowMap->GetHeight());
 
-	GetShadowPassMeshCommandMap(EShadowMapType::SM_SINGLE);
+	GetShadowPassMeshCommandMap(EShadowMapType::SM_SINGLE, ShadowMap->GetSceneView(), ShadowMap->GetHeight());
 
 	// Change to DEPTH_WRITE.
 	D3D12RHI->TransitionResource(ShadowMap->GetRT()->GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
@@ -1887,17 +2200,16 @@ void TRender::GenerateSingleShadowMap(TShadowMap2D* ShadowMap)
 			const TMeshProxy& MeshProxy = MeshProxyMap.at(MeshCommand.MeshName);
 
 			// Set vertex buffer
-			D3D12RHI->SetVertexBuffer(MeshProxy.VertexBufferRef, 0, MeshProxy.VertexByteStride, MeshProxy.VertexBufferByteSize);
+			SetMeshVertexBuffers(MeshProxy, true);
 
 			// Set index buffer
-			D3D12RHI->SetIndexBuffer(MeshProxy.IndexBufferRef, 0, MeshProxy.IndexFormat, MeshProxy.IndexBufferByteSize);
+			SetMeshIndexBuffer(MeshProxy);
 
 			D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 			CommandList->IASetPrimitiveTopology(PrimitiveType);
 
 			// Draw 
-			auto& SubMesh = MeshProxy.SubMeshs.at("Default");
-			CommandList->DrawIndexedInstanced(SubMesh.IndexCount, 1, SubMesh.StartIndexLocation, SubMesh.BaseVertexLocation, 0);
+			DrawMeshRanges(MeshProxy, MeshCommand.Draws);
 		}
 	}
 
@@ -1911,7 +2223,7 @@ void TRender::GenerateOmniShadowMap(TShadowMapCube* ShadowMap)
 	{
 		UpdateShadowPassCB(ShadowMap->GetSceneView(i), ShadowMap->GetCubeMapSize(), ShadowMap->GetCubeMapSize());
 
-		GetShadowPassMeshCommandMap(EShadowMapType::SM_OMNI);
+		GetShadowPassMeshCommandMap(EShadowMapType::SM_OMNI, ShadowMap->GetSceneView(i), ShadowMap->GetCubeMapSize());
 
 		// Change to DEPTH_WRITE.
 		D3D12RHI->TransitionResource(ShadowMap->GetRTCube()->GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
@@ -1952,17 +2264,16 @@ void TRender::GenerateOmniShadowMap(TShadowMapCube* ShadowMap)
 				const TMeshProxy& MeshProxy = MeshProxyMap.at(MeshCommand.MeshName);
 
 				// Set vertex buffer
-				D3D12RHI->SetVertexBuffer(MeshProxy.VertexBufferRef, 0, MeshProxy.VertexByteStride, MeshProxy.VertexBufferByteSize);
+				SetMeshVertexBuffers(MeshProxy, true);
 
 				// Set index buffer
-				D3D12RHI->SetIndexBuffer(MeshProxy.IndexBufferRef, 0, MeshProxy.IndexFormat, MeshProxy.IndexBufferByteSize);
+				SetMeshIndexBuffer(MeshProxy);
 
 				D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 				CommandList->IASetPrimitiveTopology(PrimitiveType);
 
 				// Draw 
-				auto& SubMesh = MeshProxy.SubMeshs.at("Default");
-				CommandList->DrawIndexedInstanced(SubMesh.IndexCount, 1, SubMesh.StartIndexLocation, SubMesh.BaseVertexLocation, 0);
+				DrawMeshRanges(MeshProxy, MeshCommand.Draws);
 			}
 		}
 
@@ -2082,7 +2393,7 @@ void TRender::GetBasePassMeshCommandMap()
 		TMeshCommand MeshCommand;
 		MeshCommand.MeshName = MeshBatch.MeshName;
 
-		auto MaterialInstance = MeshBatch.MeshComponent->GetMaterialInstance();
+		auto MaterialInstance = MeshBatch.MaterialInstance;
 		MeshCommand.RenderState = MaterialInstance->Material->RenderState;
 
 		// Get material constanct buffer
@@ -2106,21 +2417,35 @@ void TRender::GetBasePassMeshCommandMap()
 			}
 			else
 			{
-				SRV = TTextureRepository::Get().TextureMap[TextureName]->GetD3DTexture()->GetSRV();
+				SRV = GetTextureSRV(TextureName);
 			}
 
 			MeshCommand.SetShaderParameter(Pair.first, SRV);
 		}
 
 		// Get PSO descriptor of this mesh
+		// Camera cluster culling only applies to the base pass
+		if (MeshBatch.bClusterCulled)
+		{
+			MeshCommand.Draws = MeshBatch.ClusterDraws;
+		}
+		else
+		{
+			GetMeshDraws(MeshProxyMap.at(MeshBatch.MeshName), MeshBatch.SubmeshIndex, MeshBatch.LODIndex, MeshCommand.Draws);
+		}
+
 		TGraphicsPSODescriptor Descriptor;
 		Descriptor.InputLayoutName = MeshBatch.InputLayoutName;
 		Descriptor.RasterizerDesc.CullMode = MeshCommand.RenderState.CullMode;
 		Descriptor.DepthStencilDesc.DepthFunc = MeshCommand.RenderState.DepthFunc;
 
 		TMaterial* Material = MaterialInstance->Material;
-		TShaderDefines EmptyShaderDefines;
-		Descriptor.Shader = Material->GetShader(EmptyShaderDefines, D3D12RHI);
+		TShaderDefines ShaderDefines;
+		if (MeshBatch.bCompactVertex)
+		{
+			ShaderDefines.SetDefine("COMPACT_VERTEX", "1");
+		}
+		Descriptor.Shader = Material->GetShader(ShaderDefines, D3D12RHI);
 		
 		// GBuffer PSO common settings
 		Descriptor.RTVFormats[0] = GBufferBaseColor->GetFormat();
@@ -2216,17 +2541,16 @@ void TRender::BasePass()
 			const TMeshProxy& MeshProxy = MeshProxyMap.at(MeshCommand.MeshName);
 
 			// Set vertex buffer
-			D3D12RHI->SetVertexBuffer(MeshProxy.VertexBufferRef, 0, MeshProxy.VertexByteStride, MeshProxy.VertexBufferByteSize);
+			SetMeshVertexBuffers(MeshProxy, false);
 
 			// Set index buffer
-			D3D12RHI->SetIndexBuffer(MeshProxy.IndexBufferRef, 0, MeshProxy.IndexFormat, MeshProxy.IndexBufferByteSize);
+			SetMeshIndexBuffer(MeshProxy);
 
 			D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 			CommandList->IASetPrimitiveTopology(PrimitiveType);
 
 			// Draw 
-			auto& SubMesh = MeshProxy.SubMeshs.at("Default");
-			CommandList->DrawIndexedInstanced(SubMesh.IndexCount, 1, SubMesh.StartIndexLocation, SubMesh.BaseVertexLocation, 0);
+			DrawMeshRanges(MeshProxy, MeshCommand.Draws);
 		}
 	}
 
@@ -2249,7 +2573,7 @@ void TRender::GetBackDepthPassMeshCommandMap()
 		TMeshCommand MeshCommand;
 		MeshCommand.MeshName = MeshBatch.MeshName;
 
-		auto MaterialInstance = MeshBatch.MeshComponent->GetMaterialInstance();
+		auto MaterialInstance = MeshBatch.MaterialInstance;
 		// Get material constanct buffer
 		if (MaterialInstance->MaterialConstantBuffer == nullptr)
 		{
@@ -2261,9 +2585,12 @@ void TRender::GetBackDepthPassMeshCommandMap()
 		MeshCommand.SetShaderParameter("cbPerObject", MeshBatch.ObjConstantBuffer);
 		MeshCommand.SetShaderParameter("cbPass", BasePassCBRef);
 
+		// Same LOD as the base pass, without cluster culling since front faces are culled here
+		GetMeshDraws(MeshProxyMap.at(MeshBatch.MeshName), MeshBatch.SubmeshIndex, MeshBatch.LODIndex, MeshCommand.Draws);
+
 		// Get PSO descriptor of this mesh
 		TGraphicsPSODescriptor Descriptor;
-		Descriptor.InputLayoutName = MeshBatch.InputLayoutName;
+		Descriptor.InputLayoutName = MeshBatch.bCompactVertex ? "CompactPositionInputLayout" : MeshBatch.InputLayoutName;
 		Descriptor.Shader = BackDepthShader.get();
 		// Shadow map pass does not have a render target.
 		Descriptor.RTVFormats[0] = DXGI_FORMAT_UNKNOWN;
@@ -2328,17 +2655,16 @@ void TRender::BackDepthPass()
 			const TMeshProxy& MeshProxy = MeshProxyMap.at(MeshCommand.MeshName);
 
 			// Set vertex buffer
-			D3D12RHI->SetVertexBuffer(MeshProxy.VertexBufferRef, 0, MeshProxy.VertexByteStride, MeshProxy.VertexBufferByteSize);
+			SetMeshVertexBuffers(MeshProxy, true);
 
 			// Set index buffer
-			D3D12RHI->SetIndexBuffer(MeshProxy.IndexBufferRef, 0, MeshProxy.IndexFormat, MeshProxy.IndexBufferByteSize);
+			SetMeshIndexBuffer(MeshProxy);
 
 			D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 			CommandList->IASetPrimitiveTopology(PrimitiveType);
 
 			// Draw 
-			auto& SubMesh = MeshProxy.SubMeshs.at("Default");
-			CommandList->DrawIndexedInstanced(SubMesh.IndexCount, 1, SubMesh.StartIndexLocation, SubMesh.BaseVertexLocation, 0);
+			DrawMeshRanges(MeshProxy, MeshCommand.Draws);
 		}
 	}
 
@@ -2404,17 +2730,16 @@ void TRender::SSAOPass()
 		const TMeshProxy& MeshProxy = MeshProxyMap.at("ScreenQuadMesh");
 
 		// Set vertex buffer
-		D3D12RHI->SetVertexBuffer(MeshProxy.VertexBufferRef, 0, MeshProxy.VertexByteStride, MeshProxy.VertexBufferByteSize);
+		SetMeshVertexBuffers(MeshProxy, false);
 
 		// Set index buffer
-		D3D12RHI->SetIndexBuffer(MeshProxy.IndexBufferRef, 0, MeshProxy.IndexFormat, MeshProxy.IndexBufferByteSize);
+		SetMeshIndexBuffer(MeshProxy);
 
 		D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		CommandList->IASetPrimitiveTopology(PrimitiveType);
 
 		// Draw 
-		auto& SubMesh = MeshProxy.SubMeshs.at("Default");
-		CommandList->DrawIndexedInstanced(SubMesh.IndexCount, 1, SubMesh.StartIndexLocation, SubMesh.BaseVertexLocation, 0);
+		DrawMeshProxy(MeshProxy);
 	}
 
 
@@ -2814,6 +3139,12 @@ void TRender::UpdateDeferredLightingPassCB()
 	DeferredLightingPassConstants DeferredLightPassCB;
 	DeferredLightPassCB.EnableSSAO = RenderSettings.bEnableSSAO;
 
+	for (UINT i = 0; i < 9; i++)
+	{
+		const float* Coefficient = IBLIrradianceSH.Coefficients[i];
+		DeferredLightPassCB.IBLIrradianceSH[i] = TVector4(Coefficient[0], Coefficient[1], Coefficient[2], 0.0f);
+	}
+
 	DeferredLightPassCBRef = D3D12RHI->CreateConstantBuffer(&DeferredLightPassCB, sizeof(DeferredLightPassCB));
 }
 
@@ -2878,29 +3209,15 @@ void TRender::DeferredLightingPass()
 
 	if (bEnableIBLEnvLighting)
 	{
-		Shader->SetParameter("IBLIrradianceMap", IBLIrradianceMap->GetRTCube()->GetSRV());
-		
 		auto BRDFIntegrationMapSRV = TextureMap["IBL_BRDF_LUT"]->GetD3DTexture()->GetSRV();
 		Shader->SetParameter("BrdfLUT", BRDFIntegrationMapSRV);
 
-		std::vector<TD3D12ShaderResourceView*> IBLPrefilterEnvMapSRVs;
-		for (UINT i = 0; i < IBLPrefilterMaxMipLevel; i++)
-		{
-			IBLPrefilterEnvMapSRVs.push_back(IBLPrefilterEnvMaps[i]->GetRTCube()->GetSRV());
-		}
-		Shader->SetParameter("IBLPrefilterEnvMaps", IBLPrefilterEnvMapSRVs);
+		Shader->SetParameter("IBLPrefilterEnvMap", IBLPrefilterEnvMap->GetSRV());
 	}
 	else
 	{
-		Shader->SetParameter("IBLIrradianceMap", TextureCubeNullDescriptor.get());
 		Shader->SetParameter("BrdfLUT", Texture2DNullDescriptor.get());
-
-		std::vector<TD3D12ShaderResourceView*> NullSRVs;
-		for (UINT i = 0; i < IBLPrefilterMaxMipLevel; i++)
-		{
-			NullSRVs.push_back(TextureCubeNullDescriptor.get());
-		}
-		Shader->SetParameter("IBLPrefilterEnvMaps", NullSRVs);
+		Shader->SetParameter("IBLPrefilterEnvMap", TextureCubeNullDescriptor.get());
 	}
 
 	// Append null SRVs, make sure the size of SRVs is the same as shader binding count
@@ -2917,28 +3234,8 @@ void TRender::DeferredLightingPass()
 	}
 	Shader->SetParameter("ShadowMapCubes", ShadowMapCubeSRVs);
 
-	// SDF texture
-	auto& MeshMap = TMeshRepository::Get().MeshMap;
-
-	std::vector<TD3D12ShaderResourceView*> SDFTextureSRVs;
-	SDFTextureSRVs.resize(MAX_SDF_TEXTURE_COUNT);
-	for (const auto& Pair : MeshSDFMap)
-	{
-		std::string MeshName = Pair.first;
-		int SDFIndex = Pair.second;
-
-		TMesh& Mesh = MeshMap[MeshName];
-		auto SRV = Mesh.GetSDFTexture()->D3DTexture->GetSRV();
-		SDFTextureSRVs[SDFIndex] = SRV;
-	}
-
-	// Append null SRVs, make sure the size of SRVs is the same as shader binding count
-	for (size_t i = MeshSDFMap.size(); i < MAX_SDF_TEXTURE_COUNT; i++)
-	{
-		SDFTextureSRVs[i] = Texture3DNullDescriptor.get();
-	}
-
-	Shader->SetParameter("SDFTextures", SDFTextureSRVs);
+	// SDF bricks and global distance field
+	SetSDFParameters(Shader);
 
 	if (MeshSDFBuffer)
 	{
@@ -2970,17 +3267,16 @@ void TRender::DeferredLightingPass()
 		const TMeshProxy& MeshProxy = MeshProxyMap.at("ScreenQuadMesh");
 
 		// Set vertex buffer
-		D3D12RHI->SetVertexBuffer(MeshProxy.VertexBufferRef, 0, MeshProxy.VertexByteStride, MeshProxy.VertexBufferByteSize);
+		SetMeshVertexBuffers(MeshProxy, false);
 
 		// Set index buffer
-		D3D12RHI->SetIndexBuffer(MeshProxy.IndexBufferRef, 0, MeshProxy.IndexFormat, MeshProxy.IndexBufferByteSize);
+		SetMeshIndexBuffer(MeshProxy);
 
 		D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		CommandList->IASetPrimitiveTopology(PrimitiveType);
 
 		// Draw 
-		auto& SubMesh = MeshProxy.SubMeshs.at("Default");
-		CommandList->DrawIndexedInstanced(SubMesh.IndexCount, 1, SubMesh.StartIndexLocation, SubMesh.BaseVertexLocation, 0);
+		DrawMeshProxy(MeshProxy);
 	}
 
 	// Transition to PRESENT state.
@@ -3048,17 +3344,16 @@ void TRender::SSRPass()
 		const TMeshProxy& MeshProxy = MeshProxyMap.at("ScreenQuadMesh");
 
 		// Set vertex buffer
-		D3D12RHI->SetVertexBuffer(MeshProxy.VertexBufferRef, 0, MeshProxy.VertexByteStride, MeshProxy.VertexBufferByteSize);
+		SetMeshVertexBuffers(MeshProxy, false);
 
 		// Set index buffer
-		D3D12RHI->SetIndexBuffer(MeshProxy.IndexBufferRef, 0, MeshProxy.IndexFormat, MeshProxy.IndexBufferByteSize);
+		SetMeshIndexBuffer(MeshProxy);
 
 		D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		CommandList->IASetPrimitiveTopology(PrimitiveType);
 
 		// Draw 
-		auto& SubMesh = MeshProxy.SubMeshs.at("Default");
-		CommandList->DrawIndexedInstanced(SubMesh.IndexCount, 1, SubMesh.StartIndexLocation, SubMesh.BaseVertexLocation, 0);
+		DrawMeshProxy(MeshProxy);
 	}
 
 	// Transition back-buffer to PRESENT state.
@@ -3116,17 +3411,16 @@ void TRender::TAAPass()
 			const TMeshProxy& MeshProxy = MeshProxyMap.at("ScreenQuadMesh");
 
 			// Set vertex buffer
-			D3D12RHI->SetVertexBuffer(MeshProxy.VertexBufferRef, 0, MeshProxy.VertexByteStride, MeshProxy.VertexBufferByteSize);
+			SetMeshVertexBuffers(MeshProxy, false);
 
 			// Set index buffer
-			D3D12RHI->SetIndexBuffer(MeshProxy.IndexBufferRef, 0, MeshProxy.IndexFormat, MeshProxy.IndexBufferByteSize);
+			SetMeshIndexBuffer(MeshProxy);
 
 			D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 			CommandList->IASetPrimitiveTopology(PrimitiveType);
 
 			// Draw 
-			auto& SubMesh = MeshProxy.SubMeshs.at("Default");
-			CommandList->DrawIndexedInstanced(SubMesh.IndexCount, 1, SubMesh.StartIndexLocation, SubMesh.BaseVertexLocation, 0);
+			DrawMeshProxy(MeshProxy);
 		}
 	}
 
@@ -3250,7 +3544,6 @@ void TRender::GatherAllSpriteBatchs()
 		TSpriteBatch& SpriteBatch = PSOSpriteBatchMap[PSODescriptor];
 	}
 
-	auto& TextureMap = TTextureRepository::Get().TextureMap;
 	TSpriteBatch& SpriteBatch = PSOSpriteBatchMap[PSODescriptor];
 
 	// Get spriteItems from world sprites
@@ -3258,8 +3551,7 @@ void TRender::GatherAllSpriteBatchs()
 	for (const TSprite& Sprite : WorldSprites)
 	{
 		TSpriteItem SpriteItem;
-		TTexture* Texture = TextureMap[Sprite.TextureName].get();
-		SpriteItem.SpriteSRV = Texture->GetD3DTexture()->GetSRV();
+		SpriteItem.SpriteSRV = GetTextureSRV(Sprite.TextureName);
 		SpriteItem.TextureSize = Sprite.TextureSize;
 		SpriteItem.SourceRect = Sprite.SourceRect;
 		SpriteItem.DestRect = Sprite.DestRect;
@@ -3428,12 +3720,11 @@ void TRender::UpdateSDFData()
 {
 	auto& MeshMap = TMeshRepository::Get().MeshMap;
 
-	std::vector<TMeshSDFDescriptor> MeshSDFDescriptors;
-	std::vector<TObjectSDFDescriptor> ObjectSDFDescriptors;
+	bool bMeshSDFChanged = false;
 
-	MeshSDFMap.clear();
+	SDFObjectTable->BeginUpdate();
 
-	for (const TMeshBatch& MeshBatch : MeshBatchs) // Add new ObjectSDFDescriptor
+	for (const TMeshBatch& MeshBatch : MeshBatchs)
 	{
 		if (!MeshBatch.bUseSDF)
 		{
@@ -3446,46 +3737,225 @@ void TRender::UpdateSDFData()
 		if (MeshSDFMap.find(MeshName) == MeshSDFMap.end()) // Add new MeshSDFDescriptor
 		{
 			MeshSDFMap[MeshName] = (int)MeshSDFDescriptors.size();
-			MeshSDFDescriptors.push_back(Mesh.SDFDescriptor);			
+			MeshSDFDescriptors.push_back(Mesh.SDFDescriptor);
+			MeshSDFDescriptors.back().IndirectionOffset = (int)SDFBrickIndirection.size();
+			SDFBrickIndirection.insert(SDFBrickIndirection.end(), Mesh.SDFBrickIndirection.begin(), Mesh.SDFBrickIndirection.end());
+
+			bMeshSDFChanged = true;
 		}
 
+		// Submeshes of one component share its SDF object, unchanged transforms are skipped
 		auto MeshComponent = MeshBatch.MeshComponent;
+		const uint64_t ObjectId = (uint64_t)(uintptr_t)MeshComponent;
+		const int SDFIndex = MeshSDFMap[MeshName];
+		if (SDFObjectTable->KeepObject(ObjectId, MeshComponent->GetTransformVersion(), SDFIndex))
+		{
+			continue;
+		}
+
 		TMatrix World = MeshComponent->GetWorldTransform().GetTransformMatrix();
 		TMatrix CenterOffset = TMatrix::CreateTranslation(Mesh.BoundingBox.GetCenter());
 		World = CenterOffset * World;
 
-		TObjectSDFDescriptor ObjectSDFDescriptor;
-		ObjectSDFDescriptor.ObjWorld = World.Transpose();
-		ObjectSDFDescriptor.ObjInvWorld = World.Invert().Transpose();
-		ObjectSDFDescriptor.ObjInvWorld_IT = World;
-		ObjectSDFDescriptor.SDFIndex = MeshSDFMap[MeshName]; 
+		TGlobalSDFObject SDFObject;
+		SDFObject.Id = ObjectId;
+		for (int Row = 0; Row < 4; Row++)
+		{
+			for (int Column = 0; Column < 3; Column++)
+			{
+				SDFObject.LocalToWorld[Row][Column] = World.m[Row][Column];
+			}
+		}
+		SDFObject.Extent[0] = Mesh.SDFDescriptor.Extent.x;
+		SDFObject.Extent[1] = Mesh.SDFDescriptor.Extent.y;
+		SDFObject.Extent[2] = Mesh.SDFDescriptor.Extent.z;
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			SDFObject.Resolution[Axis] = Mesh.SDFDescriptor.Resolution[Axis];
+		}
+		SDFObject.BrickIndirection = &Mesh.SDFBrickIndirection;
+
+		SDFObjectTable->SetObject(SDFObject, SDFIndex, MeshComponent->GetTransformVersion());
+	}
 
-		ObjectSDFDescriptors.push_back(ObjectSDFDescriptor);
+	SDFObjectTable->EndUpdate();
+
+	// Only SDF shadows and the SDF debug view trace the scene
+	const bool bUseGlobalSDF = RenderSettings.ShadowMapImpl == EShadowMapImpl::SDF || RenderSettings.bDebugSDFScene;
+	if (bUseGlobalSDF)
+	{
+		UpdateGlobalDistanceField(SDFObjectTable->GetGlobalSDFObjects());
 	}
 
-	if (MeshSDFDescriptors.size() > 0)
+	if (bMeshSDFChanged)
 	{
 		MeshSDFBuffer = D3D12RHI->CreateStructuredBuffer(MeshSDFDescriptors.data(), (uint32_t)(sizeof(TMeshSDFDescriptor)),
 			(uint32_t)(MeshSDFDescriptors.size()));
+
+		SDFBrickIndirectionBuffer = D3D12RHI->CreateStructuredBuffer(SDFBrickIndirection.data(), (uint32_t)(sizeof(uint32_t)),
+			(uint32_t)(SDFBrickIndirection.size()));
 	}
-	else
+
+	UpdateObjectSDFBuffers();
+
+	const TSDFObjectGrid& ObjectGrid = SDFObjectTable->GetGrid();
+
+	SDFConstants Constants;
+	Constants.ObjectCount = SDFObjectTable->GetObjectCount();
+	Constants.BrickAtlasSlotsX = (UINT)SDFBrickAtlas->GetSlotsX();
+	Constants.BrickAtlasSlotsY = (UINT)SDFBrickAtlas->GetSlotsY();
+	Constants.BrickAtlasSlotsZ = (UINT)SDFBrickAtlas->GetSlotsZ();
+
+	const TGlobalSDFSettings& GlobalSDFSettings = GlobalDistanceField->GetSettings();
+	for (int LevelIndex = 0; LevelIndex < GlobalSDFLevelCount; LevelIndex++)
+	{
+		const TGlobalSDFLevel& Level = GlobalDistanceField->GetLevel(LevelIndex);
+		Constants.GlobalSDFLevels[LevelIndex] = TVector4((float)Level.Origin[0], (float)Level.Origin[1], (float)Level.Origin[2], Level.VoxelSize);
+	}
+	Constants.GlobalSDFResolution = (UINT)GlobalSDFSettings.Resolution;
+	Constants.GlobalSDFTruncationVoxels = GlobalSDFSettings.TruncationVoxels;
+	Constants.GlobalSDFRefineDistance = GlobalSDFRefineVoxels * GlobalSDFSettings.Level0VoxelSize;
+	Constants.GlobalSDFEnabled = bUseGlobalSDF ? 1 : 0;
+	Constants.ObjectGridOrigin = TVector3(ObjectGrid.Origin[0], ObjectGrid.Origin[1], ObjectGrid.Origin[2]);
+	Constants.ObjectGridCellSize = ObjectGrid.CellSize;
+	Constants.ObjectGridDimsX = (UINT)ObjectGrid.Dims[0];
+	Constants.ObjectGridDimsY = (UINT)ObjectGrid.Dims[1];
+	Constants.ObjectGridDimsZ = (UINT)ObjectGrid.Dims[2];
+	Constants.ObjectGridInfluenceRadius = ObjectGrid.InfluenceRadius;
+
+	SDFCBRef = D3D12RHI->CreateConstantBuffer(&Constants, sizeof(Constants));
+}
+
+void TRender::UpdateObjectSDFBuffers()
+{
+	const std::vector<TSDFObjectSlot>& Slots = SDFObjectTable->GetSlots();
+
+	auto MakeObjectSDFDescriptor = [](const TSDFObjectSlot& Slot)
 	{
-		MeshSDFBuffer = nullptr;
-	}
+		TObjectSDFDescriptor ObjectSDFDescriptor = {};
+		if (!Slot.bValid)
+		{
+			return ObjectSDFDescriptor;
+		}
+
+		TMatrix World = TMatrix::Identity;
+		TMatrix InvWorld = TMatrix::Identity;
+		for (int Row = 0; Row < 4; Row++)
+		{
+			for (int Column = 0; Column < 3; Column++)
+			{
+				World.m[Row][Column] = Slot.Object.LocalToWorld[Row][Column];
+				InvWorld.m[Row][Column] = Slot.Object.WorldToLocal[Row][Column];
+			}
+		}
+
+		ObjectSDFDescriptor.ObjWorld = World.Transpose();
+		ObjectSDFDescriptor.ObjInvWorld = InvWorld.Transpose();
+		ObjectSDFDescriptor.ObjInvWorld_IT = World;
+		ObjectSDFDescriptor.SDFIndex = Slot.MeshSDFIndex;
+		ObjectSDFDescriptor.LocalToWorldScale = Slot.LocalToWorldScale;
+
+		return ObjectSDFDescriptor;
+	};
 
-	if (ObjectSDFDescriptors.size() > 0)
+	// Grow by doubling and rewrite every slot, otherwise only the slots set this frame
+	if (Slots.size() > ObjectSDFBufferCapacity)
 	{
+		ObjectSDFBufferCapacity = std::max<uint32_t>(64, ObjectSDFBufferCapacity * 2);
+		while (ObjectSDFBufferCapacity < Slots.size())
+		{
+			ObjectSDFBufferCapacity *= 2;
+		}
+
+		std::vector<TObjectSDFDescriptor> ObjectSDFDescriptors(ObjectSDFBufferCapacity, TObjectSDFDescriptor());
+		for (size_t SlotIndex = 0; SlotIndex < Slots.size(); SlotIndex++)
+		{
+			ObjectSDFDescriptors[SlotIndex] = MakeObjectSDFDescriptor(Slots[SlotIndex]);
+		}
+
 		ObjectSDFBuffer = D3D12RHI->CreateStructuredBuffer(ObjectSDFDescriptors.data(), (uint32_t)(sizeof(TObjectSDFDescriptor)),
-			(uint32_t)(ObjectSDFDescriptors.size()));
+			ObjectSDFBufferCapacity);
 	}
-	else
+	else if (SDFObjectTable->GetDirtyBegin() < SDFObjectTable->GetDirtyEnd())
 	{
-		ObjectSDFBuffer = nullptr;
+		std::vector<TObjectSDFDescriptor> ObjectSDFDescriptors;
+		for (uint32_t SlotIndex = SDFObjectTable->GetDirtyBegin(); SlotIndex < SDFObjectTable->GetDirtyEnd(); SlotIndex++)
+		{
+			ObjectSDFDescriptors.push_back(MakeObjectSDFDescriptor(Slots[SlotIndex]));
+		}
+
+		D3D12RHI->UpdateStructuredBuffer(ObjectSDFBuffer.get(), SDFObjectTable->GetDirtyBegin() * (uint32_t)sizeof(TObjectSDFDescriptor),
+			ObjectSDFDescriptors.data(), (uint32_t)(ObjectSDFDescriptors.size() * sizeof(TObjectSDFDescriptor)));
 	}
 
-	SDFConstants Constants;
-	Constants.ObjectCount =(UINT)ObjectSDFDescriptors.size();
-	SDFCBRef = D3D12RHI->CreateConstantBuffer(&Constants, sizeof(Constants));
+	if (SDFObjectTable->IsGridDirty())
+	{
+		const TSDFObjectGrid& ObjectGrid = SDFObjectTable->GetGrid();
+
+		if (ObjectGrid.Cells.size() > 0 && ObjectGrid.ObjectIndices.size() > 0)
+		{
+			SDFObjectGridCellBuffer = D3D12RHI->CreateStructuredBuffer(ObjectGrid.Cells.data(), (uint32_t)(sizeof(TSDFObjectGridCell)),
+				(uint32_t)(ObjectGrid.Cells.size()));
+
+			SDFObjectGridIndexBuffer = D3D12RHI->CreateStructuredBuffer(ObjectGrid.ObjectIndices.data(), (uint32_t)(sizeof(uint32_t)),
+				(uint32_t)(ObjectGrid.ObjectIndices.size()));
+		}
+		else
+		{
+			SDFObjectGridCellBuffer = nullptr;
+			SDFObjectGridIndexBuffer = nullptr;
+		}
+	}
+}
+
+void TRender::CreateGlobalDistanceField()
+{
+	GlobalDistanceField = std::make_unique<TGlobalDistanceField>();
+
+	const int Resolution = GlobalDistanceField->GetSettings().Resolution;
+
+	TTextureInfo TextureInfo;
+	TextureInfo.Type = ETextureType::TEXTURE_3D;
+	TextureInfo.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+	TextureInfo.Width = (UINT)Resolution;
+	TextureInfo.Height = (UINT)Resolution;
+	TextureInfo.Depth = (UINT)Resolution;
+	TextureInfo.ArraySize = 1;
+	TextureInfo.MipCount = 1;
+	TextureInfo.Format = DXGI_FORMAT::DXGI_FORMAT_R8_UNORM;
+
+	for (int LevelIndex = 0; LevelIndex < GlobalSDFLevelCount; LevelIndex++)
+	{
+		GlobalSDFTextures[LevelIndex] = D3D12RHI->CreateTexture(TextureInfo, TexCreate_SRV);
+	}
+}
+
+void TRender::UpdateGlobalDistanceField(const std::vector<TGlobalSDFObject>& Objects)
+{
+	TCameraComponent* CameraComponent = World->GetCameraComponent();
+	TVector3 CameraLocation = CameraComponent->GetWorldLocation();
+	const float ViewPosition[3] = { CameraLocation.x, CameraLocation.y, CameraLocation.z };
+
+	GlobalDistanceField->Update(ViewPosition, Objects, *SDFBrickAtlas, TThreadPool::Get());
+
+	const int Resolution = GlobalDistanceField->GetSettings().Resolution;
+
+	// Levels are small, a level with any rebuilt region is uploaded whole
+	for (int LevelIndex = 0; LevelIndex < GlobalSDFLevelCount; LevelIndex++)
+	{
+		const TGlobalSDFLevel& Level = GlobalDistanceField->GetLevel(LevelIndex);
+		if (Level.UpdatedRegions.empty())
+		{
+			continue;
+		}
+
+		D3D12_SUBRESOURCE_DATA InitData;
+		InitData.pData = Level.Data.data();
+		InitData.RowPitch = static_cast<LONG_PTR>(Resolution);
+		InitData.SlicePitch = InitData.RowPitch * Resolution;
+
+		D3D12RHI->UploadTextureData(GlobalSDFTextures[LevelIndex], { InitData });
+	}
 }
 
 void TRender::DebugSDFScenePass()
@@ -3505,28 +3975,7 @@ void TRender::DebugSDFScenePass()
 	// Set RootSignature
 	CommandList->SetGraphicsRootSignature(DebugSDFSceneShader->RootSignature.Get()); //should before binding
 
-	auto& MeshMap = TMeshRepository::Get().MeshMap;
-
-	std::vector<TD3D12ShaderResourceView*> SDFTextureSRVs;
-	SDFTextureSRVs.resize(MAX_SDF_TEXTURE_COUNT);
-	for (const auto& Pair : MeshSDFMap)
-	{
-		std::string MeshName = Pair.first;
-		int SDFIndex = Pair.second;
-
-		TMesh& Mesh = MeshMap[MeshName];
-		auto SRV = Mesh.GetSDFTexture()->D3DTexture->GetSRV();
-		SDFTextureSRVs[SDFIndex] = SRV;
-	}
-
-	// Append null SRVs, make sure the size of SRVs is the same as shader binding count
-	auto& TextureMap = TTextureRepository::Get().TextureMap;
-	for (size_t i = MeshSDFMap.size(); i < MAX_SDF_TEXTURE_COUNT; i++)
-	{
-		SDFTextureSRVs[i] = Texture3DNullDescriptor.get();
-	}
-
-	DebugSDFSceneShader->SetParameter("SDFTextures", SDFTextureSRVs);
+	SetSDFParameters(DebugSDFSceneShader.get());
 
 	if (MeshSDFBuffer)
 	{
@@ -3560,17 +4009,16 @@ void TRender::DebugSDFScenePass()
 		const TMeshProxy& MeshProxy = MeshProxyMap.at("ScreenQuadMesh");
 
 		// Set vertex buffer
-		D3D12RHI->SetVertexBuffer(MeshProxy.VertexBufferRef, 0, MeshProxy.VertexByteStride, MeshProxy.VertexBufferByteSize);
+		SetMeshVertexBuffers(MeshProxy, false);
 
 		// Set index buffer
-		D3D12RHI->SetIndexBuffer(MeshProxy.IndexBufferRef, 0, MeshProxy.IndexFormat, MeshProxy.IndexBufferByteSize);
+		SetMeshIndexBuffer(MeshProxy);
 
 		D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		CommandList->IASetPrimitiveTopology(PrimitiveType);
 
 		// Draw 
-		auto& SubMesh = MeshProxy.SubMeshs.at("Default");
-		CommandList->DrawIndexedInstanced(SubMesh.IndexCount, 1, SubMesh.StartIndexLocation, SubMesh.BaseVertexLocation, 0);
+		DrawMeshProxy(MeshProxy);
 	}
 
 	// Transition to PRESENT state.
@@ -3615,17 +4063,16 @@ void TRender::PostProcessPass()
 		const TMeshProxy& MeshProxy = MeshProxyMap.at("ScreenQuadMesh");
 
 		// Set vertex buffer
-		D3D12RHI->SetVertexBuffer(MeshProxy.VertexBufferRef, 0, MeshProxy.VertexByteStride, MeshProxy.VertexBufferByteSize);
+		SetMeshVertexBuffers(MeshProxy, false);
 
 		// Set index buffer
-		D3D12RHI->SetIndexBuffer(MeshProxy.IndexBufferRef, 0, MeshProxy.IndexFormat, MeshProxy.IndexBufferByteSize);
+		SetMeshIndexBuffer(MeshProxy);
 
 		D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		CommandList->IASetPrimitiveTopology(PrimitiveType);
 
 		// Draw 
-		auto& SubMesh = MeshProxy.SubMeshs.at("Default");
-		CommandList->DrawIndexedInstanced(SubMesh.IndexCount, 1, SubMesh.StartIndexLocation, SubMesh.BaseVertexLocation, 0);
+		DrawMeshProxy(MeshProxy);
 	}
 
 	// Transition back-buffer to PRESENT state.
@@ -3634,6 +4081,9 @@ void TRender::PostProcessPass()
 
 void TRender::OnDestroy()
 {
+	// Streaming reloads still running push into CompletedStreamingReloads
+	TThreadPool::Get().Wait();
+
 	D3D12RHI->FlushCommandQueue();
 }
 
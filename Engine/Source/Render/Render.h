@@ -2,6 +2,7 @@
 
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 #include <wrl/client.h>
 #include "Shader/Shader.h"
 #include "Actor/Actor.h"
@@ -23,6 +24,11 @@
 #include "SceneCaptureCube.h"
 #include "ShadowMap.h"
 #include "D3D12/D3D12RHI.h"
+#include "Texture/TextureStreaming.h"
+#include "IBLPrecompute.h"
+#include "Mesh/SDFBrickAtlas.h"
+#include "GlobalDistanceField.h"
+#include "SDFObjectTable.h"
 
 // Link necessary d3d12 libraries.
 #pragma comment(lib,"d3dcompiler.lib")
@@ -62,6 +68,9 @@ struct TRenderSettings
 	bool bDebugSDFScene = false;
 
 	bool bDrawDebugText = false;
+
+	// VRAM budget of streamed material textures
+	uint32_t TextureStreamingPoolSizeMB = 256;
 };
 
 class TRender
@@ -101,6 +110,9 @@ private:
 
 	void CreateTextures();
 
+	// SRV of a repository texture, NullTex while it's still uploading
+	TD3D12ShaderResourceView* GetTextureSRV(const std::string& TextureName);
+
 	void CreateSceneCaptureCube();
 
 	void CreateGBuffers();
@@ -113,9 +125,36 @@ private:
 
 	void CreateMeshProxys();
 
-	void CreateMeshSDFTexture(TMesh& Mesh);
+	// Quantized position stream plus octahedral/half attribute stream
+	void CreateCompactVertexBuffers(const TMesh& Mesh, TMeshProxy& MeshProxy);
+
+	// Compact meshes bind the position stream to slot 0 and, unless bPositionOnly, attributes to slot 1
+	void SetMeshVertexBuffers(const TMeshProxy& MeshProxy, bool bPositionOnly);
+
+	void SetMeshIndexBuffer(const TMeshProxy& MeshProxy);
+
+	// Offsets the ranges by the mesh allocations inside the shared geometry pool
+	void DrawMeshRanges(const TMeshProxy& MeshProxy, const std::vector<TMeshDrawRange>& Draws);
+
+	// Every submesh at LOD0, for passes drawing whole meshes
+	void DrawMeshProxy(const TMeshProxy& MeshProxy);
+
+	// Applies a geometry pool defragment to every mesh allocated from Arena
+	void RelocateMeshProxys(EGeometryArena Arena, const std::vector<TOffsetMove>& Moves);
 
-	void BulidMeshSDF(TMesh& Mesh, std::vector<uint8_t>& OutMeshSDF);
+	// Bakes or loads the dense SDF of Mesh and packs its narrow band into SDFBrickAtlas
+	void CreateMeshSDFBricks(TMesh& Mesh);
+
+	// Recreates SDFBrickAtlasTexture after meshes were added to the atlas
+	void CreateSDFBrickAtlasTexture();
+
+	// Binds the brick atlas, indirection and global distance field levels
+	void SetSDFParameters(TShader* InShader);
+
+	void CreateGlobalDistanceField();
+
+	// Recomposes the clipmap regions touched by moved objects or camera scrolling and uploads the changed levels
+	void UpdateGlobalDistanceField(const std::vector<TGlobalSDFObject>& Objects);
 
 	void CreateInputLayouts();
 
@@ -136,15 +175,21 @@ private:
 
 	void CreateIBLEnviromentMap();
 
-	void UpdateIBLIrradiancePassCB();
+	// SH irradiance and the prefiltered environment map, loaded from Save/IBL or precomputed on the CPU
+	void CreateIBLLightingData();
 
-	void CreateIBLIrradianceMap();
+	void GatherAllMeshBatchs();
 
-	void UpdateIBLPrefilterEnvCB();
+	// Coarsest LOD whose simplification error projects to at most LODPixelError pixels
+	UINT SelectMeshLOD(const TMeshProxy& MeshProxy, const TMatrix& World, const TMatrix& View, const TMatrix& Proj, float ViewportHeight);
 
-	void CreateIBLPrefilterEnvMap();
+	// Index ranges of one submesh at a LOD, LOD0 draws every 16-bit chunk of the submesh
+	void GetMeshDraws(const TMeshProxy& MeshProxy, UINT SubmeshIndex, UINT LODIndex, std::vector<TMeshDrawRange>& OutDraws);
 
-	void GatherAllMeshBatchs();
+	// Camera frustum and backface cone test per meshlet, fills MeshBatch.ClusterDraws
+	void CullMeshClusters(TMeshBatch& MeshBatch, const std::vector<TMeshlet>& Meshlets, const TMatrix& LocalToClip, const TVector3& LocalCameraPosition);
+
+	void UpdateTextureStreaming();
 
 	TMatrix TextureTransform();
 
@@ -152,7 +197,7 @@ private:
 
 	void UpdateShadowPassCB(const TSceneView& SceneView, UINT ShadowWidth, UINT ShadowHeight);
 
-	void GetShadowPassMeshCommandMap(EShadowMapType Type);
+	void GetShadowPassMeshCommandMap(EShadowMapType Type, const TSceneView& SceneView, UINT ShadowMapSize);
 
 	void ShadowPass();
 
@@ -206,6 +251,9 @@ private:
 
 	void UpdateSDFData();
 
+	// Write the object descriptors set this frame and the object grid
+	void UpdateObjectSDFBuffers();
+
 	void DebugSDFScenePass();
 
 	void PostProcessPass();
@@ -271,6 +319,41 @@ private:
 
 	std::unordered_map<std::string/*MeshName*/, int/*SdfIndex*/> MeshSDFMap;
 
+	// Mesh SDFs in MeshSDFMap order, they never change once added
+	std::vector<TMeshSDFDescriptor> MeshSDFDescriptors;
+
+	std::vector<uint32_t> SDFBrickIndirection;
+
+	// Persistent object slots, ObjectSDFBuffer mirrors them
+	std::unique_ptr<TSDFObjectTable> SDFObjectTable;
+
+	uint32_t ObjectSDFBufferCapacity = 0;
+
+	// TSDFObjectGrid cells and slot indices
+	TD3D12StructuredBufferRef SDFObjectGridCellBuffer = nullptr;
+
+	TD3D12StructuredBufferRef SDFObjectGridIndexBuffer = nullptr;
+
+	std::unique_ptr<TSDFBrickAtlas> SDFBrickAtlas;
+
+	std::unique_ptr<TTexture3D> SDFBrickAtlasTexture;
+
+	// Every mesh indirection back to back, TMeshSDFDescriptor::IndirectionOffset points into it
+	TD3D12StructuredBufferRef SDFBrickIndirectionBuffer = nullptr;
+
+	// Size the dense volumes of the packed meshes would take
+	size_t SDFDenseBytes = 0;
+
+	// Bricks with a voxel closer to the surface than this are stored, inside MeshSDFDistanceBandVoxels
+	const float SDFBrickBandVoxels = 4.0f;
+
+	std::unique_ptr<TGlobalDistanceField> GlobalDistanceField;
+
+	TD3D12TextureRef GlobalSDFTextures[GlobalSDFLevelCount];
+
+	// Traces switch to the object fields closer than this many level 0 voxels to a surface
+	const float GlobalSDFRefineVoxels = 2.0f;
+
 	// InputLayout
 	TInputLayoutManager InputLayoutManager;
 
@@ -285,12 +368,9 @@ private:
 
 	TD3D12ConstantBufferRef IBLEnviromentPassCBRef[6];
 
-	TD3D12ConstantBufferRef IBLIrradiancePassCBRef[6];
-
+	// Same as IBL_PREFILTER_ENVMAP_MIP_LEVEL in DeferredLighting.hlsl
 	const static UINT IBLPrefilterMaxMipLevel = 5;
 
-	TD3D12ConstantBufferRef IBLPrefilterEnvPassCBRef[IBLPrefilterMaxMipLevel * 6];
-
 	TD3D12ConstantBufferRef DeferredLightPassCBRef;
 
 	// Computshader resource
@@ -317,10 +397,6 @@ private:
 
 	std::unique_ptr<TShader> IBLEnvironmentShader = nullptr;
 
-	std::unique_ptr<TShader> IBLIrradianceShader = nullptr;
-
-	std::unique_ptr<TShader> IBLPrefilterEnvShader = nullptr;
-
 	std::unique_ptr<TShader> DeferredLightingShader = nullptr;
 
 	std::unique_ptr<TShader> PrimitiveShader = nullptr;
@@ -354,10 +430,6 @@ private:
 
 	TGraphicsPSODescriptor IBLEnvironmentPSODescriptor;
 
-	TGraphicsPSODescriptor IBLIrradiancePSODescriptor;
-
-	TGraphicsPSODescriptor IBLPrefilterEnvPSODescriptor;
-
 	TGraphicsPSODescriptor DeferredLightingPSODescriptor;
 
 	TGraphicsPSODescriptor DebugSDFScenePSODescriptor;
@@ -418,8 +490,6 @@ private:
 
 	const UINT MAX_SHADOW_MAP_CUBE_NUM = 5;
 
-	const UINT MAX_SDF_TEXTURE_COUNT = 20;
-
 	const UINT ShadowSize = 4096;
 
 	std::vector<TD3D12ShaderResourceView*> ShadowMapSRVs;
@@ -434,13 +504,51 @@ private:
 	// PBR
 	std::unique_ptr<TSceneCaptureCube> IBLEnvironmentMap;
 
-	std::unique_ptr<TSceneCaptureCube> IBLIrradianceMap;
+	TSHIrradiance IBLIrradianceSH;
 
-	std::vector<std::unique_ptr<TSceneCaptureCube>> IBLPrefilterEnvMaps;
+	// One mip per roughness step
+	TD3D12TextureRef IBLPrefilterEnvMap;
 
 	// Culling
 	bool bEnableFrustumCulling = false;
 
+	// Camera view only, for the base pass. The back depth pass keeps back facing clusters and
+	// shadow views have their own frustums, both draw whole submeshes.
+	bool bEnableClusterCulling = true;
+
+	// LOD
+	bool bEnableMeshLOD = true;
+
+	float LODPixelError = 1.0f;
+
+	TMeshletCullStats ClusterCullStats;
+
+	// Microseconds spent in CullMeshlets this frame
+	double ClusterCullTime = 0.0;
+
+	// Texture streaming
+	std::unique_ptr<TTextureStreamingManager> TextureStreamingManager;
+
+	std::unique_ptr<TGeometryPool> GeometryPool;
+
+	std::unordered_map<std::string/*TextureName*/, uint32_t/*StreamingId*/> StreamingTextureIds;
+
+	std::vector<TTexture*> StreamingTextures;
+
+	// Mips of a streamed texture read again on the thread pool
+	struct TStreamingReload
+	{
+		TTextureStreamingRequest Request;
+
+		TTextureResource Resource;
+
+		bool bSuccess = false;
+	};
+
+	std::mutex StreamingReloadMutex;
+
+	std::vector<TStreamingReload> CompletedStreamingReloads;
+
 	// D3D12RHI
 	TD3D12RHI* D3D12RHI = nullptr;
 
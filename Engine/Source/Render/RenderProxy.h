@@ -6,6 +6,9 @@
 #include "D3D12/D3D12Resource.h"
 #include "D3D12/D3D12View.h"
 #include "Math/Math.h"
+#include "Mesh/Meshlet.h"
+#include "GeometryPool.h"
+#include "GlobalDistanceField.h"
 
 struct TMaterialConstants
 {
@@ -21,17 +24,40 @@ public:
 	UINT ShadingModel;
 };
 
-// Defines a subrange of geometry in a TMeshProxy.  This is for when multiple
-// geometries are stored in one vertex and index buffer.  It provides the offsets
-// and data needed to draw a subset of geometry stores in the vertex and index 
-// buffers
-struct TSubmeshProxy
+// Index range of one draw call in a TMeshProxy, relative to its geometry pool allocations.
+// Submeshes split into one range per 16-bit chunk, cluster culling into runs of visible meshlets.
+struct TMeshDrawRange
 {
 	UINT IndexCount = 0;
 	UINT StartIndexLocation = 0;
 	INT BaseVertexLocation = 0;
 
-	// Bounding box of the geometry defined by this submesh. 
+	// Bounding box of the geometry in this range
+	DirectX::BoundingBox Bounds;
+};
+
+// Simplification level shared by every submesh, the index ranges live in TMeshSubmeshProxy::LODDraws
+struct TMeshLODProxy
+{
+	// Simplification error in mesh space units
+	float Error = 0.0f;
+};
+
+// Geometry drawn with one material slot
+struct TMeshSubmeshProxy
+{
+	UINT MaterialSlot = 0;
+
+	// LOD0 index ranges, one per 16-bit chunk of the submesh
+	std::vector<TMeshDrawRange> Draws;
+
+	// LOD1 and coarser, parallel to TMeshProxy::LODs
+	std::vector<TMeshDrawRange> LODDraws;
+
+	// Empty for submeshes drawn without cluster culling
+	std::vector<TMeshlet> Meshlets;
+
+	// Mesh space bounds for per-submesh frustum culling
 	DirectX::BoundingBox Bounds;
 };
 
@@ -40,20 +66,34 @@ struct TMeshProxy
 	// Give it a name so we can look it up by name.
 	std::string Name;
 
-	TD3D12VertexBufferRef VertexBufferRef;
-	TD3D12IndexBufferRef IndexBufferRef;
-
+	// Ranges in the shared geometry pool, draws add the offsets to BaseVertexLocation/StartIndexLocation
+	EGeometryArena VertexArena = EGeometryArena::Vertices;
+	TOffsetAllocation VertexAllocation;
 
-	// Data about the buffers.
-	UINT VertexByteStride = 0;
-	UINT VertexBufferByteSize = 0;
+	EGeometryArena IndexArena = EGeometryArena::Indices16;
+	TOffsetAllocation IndexAllocation;
 	DXGI_FORMAT IndexFormat = DXGI_FORMAT_R16_UINT;
-	UINT IndexBufferByteSize = 0;
 
-	// A MeshGeometry may store multiple geometries in one vertex/index buffer.
-	// Use this container to define the Submesh geometries so we can draw
-	// the Submeshes individually.
-	std::unordered_map<std::string, TSubmeshProxy> SubMeshs;
+	// UV units per unit of surface length in mesh space
+	float UVDensity = 1.0f;
+
+	// Compact meshes keep quantized positions in slot 0 and the octahedral
+	// normal/tangent and half UV stream in slot 1
+	bool bCompactVertex = false;
+
+	// Position = PositionDequantMin + Unorm * PositionDequantExtent
+	TVector3 PositionDequantMin = TVector3(0.0f);
+	TVector3 PositionDequantExtent = TVector3(1.0f);
+
+	// One entry per material slot in use, all share the vertex and index buffers
+	std::vector<TMeshSubmeshProxy> Submeshes;
+
+	// LOD1 and coarser, drawn instead of the submesh Draws
+	std::vector<TMeshLODProxy> LODs;
+
+	// Mesh space bounding sphere for LOD selection
+	TVector3 BoundsCenter = TVector3(0.0f);
+	float BoundsRadius = 0.0f;
 };
 
 struct TLightShaderParameters
@@ -124,6 +164,12 @@ struct ObjectConstants
 	TMatrix World = TMatrix::Identity;
 	TMatrix PrevWorld = TMatrix::Identity;
 	TMatrix TexTransform = TMatrix::Identity;
+
+	// Compact vertex position bounds
+	TVector3 PosDequantMin = TVector3(0.0f);
+	float ObjPad0 = 0.0f;
+	TVector3 PosDequantExtent = TVector3(1.0f);
+	float ObjPad1 = 0.0f;
 };
 
 struct SpritePassConstants
@@ -166,7 +212,7 @@ struct TObjectSDFDescriptor
 	TMatrix ObjInvWorld_IT;
 
 	int SDFIndex;
-	int pad1;
+	float LocalToWorldScale;
 	int pad2;
 	int pad3;
 };
@@ -174,9 +220,25 @@ struct TObjectSDFDescriptor
 struct SDFConstants
 {
 	UINT ObjectCount;
-	UINT Pad1;
-	UINT Pad2;
-	UINT Pad3;
+	UINT BrickAtlasSlotsX;
+	UINT BrickAtlasSlotsY;
+	UINT BrickAtlasSlotsZ;
+
+	// xyz first world voxel of the clipmap level window, w voxel size
+	TVector4 GlobalSDFLevels[GlobalSDFLevelCount];
+
+	UINT GlobalSDFResolution;
+	float GlobalSDFTruncationVoxels;
+	float GlobalSDFRefineDistance;
+	UINT GlobalSDFEnabled;
+
+	// Uniform grid over the object SDF bounds, see TSDFObjectGrid
+	TVector3 ObjectGridOrigin;
+	float ObjectGridCellSize;
+	UINT ObjectGridDimsX;
+	UINT ObjectGridDimsY;
+	UINT ObjectGridDimsZ;
+	float ObjectGridInfluenceRadius;
 };
 
 struct SSAOPassConstants
@@ -193,11 +255,10 @@ struct SSAOPassConstants
 struct DeferredLightingPassConstants
 {
 	UINT EnableSSAO;
-};
+	UINT DeferredLightingPad0;
+	UINT DeferredLightingPad1;
+	UINT DeferredLightingPad2;
 
-struct PrefilterEnvironmentConstant
-{
-	TMatrix View = TMatrix::Identity;
-	TMatrix Proj = TMatrix::Identity;
-	float Roughness;
+	// TSHIrradiance coefficients in xyz
+	TVector4 IBLIrradianceSH[9];
 };
\ No newline at end of file
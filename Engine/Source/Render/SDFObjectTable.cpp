@@ -0,0 +1,347 @@
+#include "SDFObjectTable.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace
+{
+	// Affine inverse of a row vector 4x3 matrix, the 3x3 part through its adjugate
+	void InvertAffine(const float M[4][3], float R[4][3])
+	{
+		const float Cofactor00 = M[1][1] * M[2][2] - M[1][2] * M[2][1];
+		const float Cofactor01 = M[1][2] * M[2][0] - M[1][0] * M[2][2];
+		const float Cofactor02 = M[1][0] * M[2][1] - M[1][1] * M[2][0];
+
+		const float Determinant = M[0][0] * Cofactor00 + M[0][1] * Cofactor01 + M[0][2] * Cofactor02;
+		const float InvDeterminant = (Determinant != 0.0f) ? 1.0f / Determinant : 0.0f;
+
+		R[0][0] = Cofactor00 * InvDeterminant;
+		R[1][0] = Cofactor01 * InvDeterminant;
+		R[2][0] = Cofactor02 * InvDeterminant;
+		R[0][1] = (M[0][2] * M[2][1] - M[0][1] * M[2][2]) * InvDeterminant;
+		R[1][1] = (M[0][0] * M[2][2] - M[0][2] * M[2][0]) * InvDeterminant;
+		R[2][1] = (M[0][1] * M[2][0] - M[0][0] * M[2][1]) * InvDeterminant;
+		R[0][2] = (M[0][1] * M[1][2] - M[0][2] * M[1][1]) * InvDeterminant;
+		R[1][2] = (M[0][2] * M[1][0] - M[0][0] * M[1][2]) * InvDeterminant;
+		R[2][2] = (M[0][0] * M[1][1] - M[0][1] * M[1][0]) * InvDeterminant;
+
+		for (int Column = 0; Column < 3; Column++)
+		{
+			R[3][Column] = -(M[3][0] * R[0][Column] + M[3][1] * R[1][Column] + M[3][2] * R[2][Column]);
+		}
+	}
+}
+
+TSDFObjectTable::TSDFObjectTable(const TSDFObjectTableSettings& InSettings)
+	:Settings(InSettings)
+{
+	Grid.InfluenceRadius = Settings.GridInfluenceRadius;
+}
+
+void TSDFObjectTable::BeginUpdate()
+{
+	UpdateIndex++;
+
+	DirtyBegin = (uint32_t)Slots.size();
+	DirtyEnd = 0;
+	ChangeCount = 0;
+}
+
+bool TSDFObjectTable::KeepObject(uint64_t Id, uint32_t TransformVersion, int MeshSDFIndex)
+{
+	auto Iter = SlotMap.find(Id);
+	if (Iter == SlotMap.end())
+	{
+		return false;
+	}
+
+	TSDFObjectSlot& Slot = Slots[Iter->second];
+	if (Slot.TransformVersion != TransformVersion || Slot.MeshSDFIndex != MeshSDFIndex)
+	{
+		return false;
+	}
+
+	Slot.LastSeenUpdate = UpdateIndex;
+
+	return true;
+}
+
+void TSDFObjectTable::SetObject(const TGlobalSDFObject& Object, int MeshSDFIndex, uint32_t TransformVersion)
+{
+	uint32_t SlotIndex;
+
+	auto Iter = SlotMap.find(Object.Id);
+	if (Iter != SlotMap.end())
+	{
+		SlotIndex = Iter->second;
+		UnbinSlot(SlotIndex);
+	}
+	else if (!FreeSlots.empty())
+	{
+		SlotIndex = FreeSlots.back();
+		FreeSlots.pop_back();
+	}
+	else
+	{
+		SlotIndex = (uint32_t)Slots.size();
+		Slots.emplace_back();
+		SlotCells.emplace_back();
+	}
+
+	SlotMap[Object.Id] = SlotIndex;
+
+	TSDFObjectSlot& Slot = Slots[SlotIndex];
+	Slot.Object = Object;
+	InvertAffine(Slot.Object.LocalToWorld, Slot.Object.WorldToLocal);
+	Slot.MeshSDFIndex = MeshSDFIndex;
+	Slot.LocalToWorldScale = ComputeObjectLocalToWorldScale(Slot.Object);
+	ComputeObjectWorldBounds(Slot.Object, Slot.BoundsMin, Slot.BoundsMax);
+	Slot.TransformVersion = TransformVersion;
+	Slot.LastSeenUpdate = UpdateIndex;
+	Slot.bValid = true;
+
+	PendingSlots.push_back(SlotIndex);
+
+	DirtyBegin = std::min<uint32_t>(DirtyBegin, SlotIndex);
+	DirtyEnd = std::max<uint32_t>(DirtyEnd, SlotIndex + 1);
+	ChangeCount++;
+}
+
+void TSDFObjectTable::EndUpdate()
+{
+	bool bRemoved = false;
+
+	for (uint32_t SlotIndex = 0; SlotIndex < (uint32_t)Slots.size(); SlotIndex++)
+	{
+		TSDFObjectSlot& Slot = Slots[SlotIndex];
+		if (Slot.bValid && Slot.LastSeenUpdate != UpdateIndex)
+		{
+			UnbinSlot(SlotIndex);
+
+			SlotMap.erase(Slot.Object.Id);
+			Slot = TSDFObjectSlot();
+			FreeSlots.push_back(SlotIndex);
+
+			bRemoved = true;
+			ChangeCount++;
+		}
+	}
+
+	if (bRemoved)
+	{
+		std::sort(FreeSlots.begin(), FreeSlots.end(), std::greater<uint32_t>());
+	}
+
+	if (DirtyBegin >= DirtyEnd)
+	{
+		DirtyBegin = DirtyEnd = 0;
+	}
+
+	LastChangeCount = ChangeCount;
+
+	bGridDirty = ChangeCount > 0;
+	if (!bGridDirty)
+	{
+		return;
+	}
+
+	// Moved and added objects are binned into the current grid, the grid is only rebuilt when one leaves it
+	bool bFitsGrid = !CellObjects.empty() && !SlotMap.empty();
+	for (size_t i = 0; i < PendingSlots.size() && bFitsGrid; i++)
+	{
+		const TSDFObjectSlot& Slot = Slots[PendingSlots[i]];
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			float GridMax = Grid.Origin[Axis] + Grid.CellSize * (float)Grid.Dims[Axis];
+			bFitsGrid = bFitsGrid && Slot.BoundsMin[Axis] - Grid.InfluenceRadius >= Grid.Origin[Axis] && Slot.BoundsMax[Axis] + Grid.InfluenceRadius <= GridMax;
+		}
+	}
+
+	if (bFitsGrid)
+	{
+		for (uint32_t SlotIndex : PendingSlots)
+		{
+			BinSlot(SlotIndex);
+		}
+	}
+	else
+	{
+		BuildGrid();
+	}
+	PendingSlots.clear();
+
+	// Flatten the cell lists for upload
+	uint32_t Offset = 0;
+	Grid.ObjectIndices.clear();
+	for (size_t CellIndex = 0; CellIndex < CellObjects.size(); CellIndex++)
+	{
+		const std::vector<uint32_t>& Objects = CellObjects[CellIndex];
+
+		Grid.Cells[CellIndex].Offset = Offset;
+		Grid.Cells[CellIndex].Count = (uint32_t)Objects.size();
+		Grid.ObjectIndices.insert(Grid.ObjectIndices.end(), Objects.begin(), Objects.end());
+
+		Offset += (uint32_t)Objects.size();
+	}
+
+	GlobalSDFObjects.clear();
+	for (const TSDFObjectSlot& Slot : Slots)
+	{
+		if (Slot.bValid)
+		{
+			GlobalSDFObjects.push_back(Slot.Object);
+		}
+	}
+}
+
+void TSDFObjectTable::BuildGrid()
+{
+	Grid = TSDFObjectGrid();
+	Grid.InfluenceRadius = Settings.GridInfluenceRadius;
+
+	CellObjects.clear();
+	for (TSlotCells& Cells : SlotCells)
+	{
+		Cells.bBinned = false;
+	}
+
+	if (SlotMap.empty())
+	{
+		return;
+	}
+
+	// A cell of slack on every side, so small moves stay in the grid
+	const float Margin = Grid.InfluenceRadius + Settings.GridCellSize;
+
+	float GridMin[3] = { 1e30f, 1e30f, 1e30f };
+	float GridMax[3] = { -1e30f, -1e30f, -1e30f };
+	for (const TSDFObjectSlot& Slot : Slots)
+	{
+		if (Slot.bValid)
+		{
+			for (int Axis = 0; Axis < 3; Axis++)
+			{
+				GridMin[Axis] = std::min<float>(GridMin[Axis], Slot.BoundsMin[Axis] - Margin);
+				GridMax[Axis] = std::max<float>(GridMax[Axis], Slot.BoundsMax[Axis] + Margin);
+			}
+		}
+	}
+
+	float LargestSize = 0.0f;
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		LargestSize = std::max<float>(LargestSize, GridMax[Axis] - GridMin[Axis]);
+	}
+
+	Grid.CellSize = std::max<float>(Settings.GridCellSize, LargestSize / (float)Settings.MaxGridCellsPerAxis);
+
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		Grid.Origin[Axis] = GridMin[Axis];
+		Grid.Dims[Axis] = std::clamp<int>((int)std::ceil((GridMax[Axis] - GridMin[Axis]) / Grid.CellSize), 1, Settings.MaxGridCellsPerAxis);
+	}
+
+	const size_t CellCount = (size_t)Grid.Dims[0] * Grid.Dims[1] * Grid.Dims[2];
+	Grid.Cells.resize(CellCount);
+	CellObjects.resize(CellCount);
+
+	for (uint32_t SlotIndex = 0; SlotIndex < (uint32_t)Slots.size(); SlotIndex++)
+	{
+		if (Slots[SlotIndex].bValid)
+		{
+			BinSlot(SlotIndex);
+		}
+	}
+}
+
+void TSDFObjectTable::BinSlot(uint32_t SlotIndex)
+{
+	UnbinSlot(SlotIndex);
+
+	const TSDFObjectSlot& Slot = Slots[SlotIndex];
+	TSlotCells& Cells = SlotCells[SlotIndex];
+
+	// Cells overlapped by the bounds grown by the influence radius, Max inclusive
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		float Min = (Slot.BoundsMin[Axis] - Grid.InfluenceRadius - Grid.Origin[Axis]) / Grid.CellSize;
+		float Max = (Slot.BoundsMax[Axis] + Grid.InfluenceRadius - Grid.Origin[Axis]) / Grid.CellSize;
+
+		Cells.Min[Axis] = std::clamp<int>((int)std::floor(Min), 0, Grid.Dims[Axis] - 1);
+		Cells.Max[Axis] = std::clamp<int>((int)std::floor(Max), 0, Grid.Dims[Axis] - 1);
+	}
+
+	for (int Z = Cells.Min[2]; Z <= Cells.Max[2]; Z++)
+	{
+		for (int Y = Cells.Min[1]; Y <= Cells.Max[1]; Y++)
+		{
+			for (int X = Cells.Min[0]; X <= Cells.Max[0]; X++)
+			{
+				CellObjects[((size_t)Z * Grid.Dims[1] + Y) * Grid.Dims[0] + X].push_back(SlotIndex);
+			}
+		}
+	}
+
+	Cells.bBinned = true;
+}
+
+void TSDFObjectTable::UnbinSlot(uint32_t SlotIndex)
+{
+	TSlotCells& Cells = SlotCells[SlotIndex];
+	if (!Cells.bBinned)
+	{
+		return;
+	}
+
+	for (int Z = Cells.Min[2]; Z <= Cells.Max[2]; Z++)
+	{
+		for (int Y = Cells.Min[1]; Y <= Cells.Max[1]; Y++)
+		{
+			for (int X = Cells.Min[0]; X <= Cells.Max[0]; X++)
+			{
+				std::vector<uint32_t>& Objects = CellObjects[((size_t)Z * Grid.Dims[1] + Y) * Grid.Dims[0] + X];
+				Objects.erase(std::find(Objects.begin(), Objects.end(), SlotIndex));
+			}
+		}
+	}
+
+	Cells.bBinned = false;
+}
+
+float SampleObjectGridDistance(const TSDFObjectTable& Table, const TSDFBrickAtlas& Atlas, const float Position[3])
+{
+	const TSDFObjectGrid& Grid = Table.GetGrid();
+
+	if (Grid.Cells.empty())
+	{
+		return 1000000.0f;
+	}
+
+	int Cell[3];
+	float SquaredOutside = 0.0f;
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		float GridPosition = (Position[Axis] - Grid.Origin[Axis]) / Grid.CellSize;
+		float Outside = std::max<float>(std::max<float>(-GridPosition, GridPosition - (float)Grid.Dims[Axis]), 0.0f) * Grid.CellSize;
+		SquaredOutside += Outside * Outside;
+
+		Cell[Axis] = std::clamp<int>((int)std::floor(GridPosition), 0, Grid.Dims[Axis] - 1);
+	}
+
+	// Every object is at least the influence radius inside the grid bounds
+	if (SquaredOutside > 0.0f)
+	{
+		return std::sqrt(SquaredOutside) + Grid.InfluenceRadius;
+	}
+
+	const TSDFObjectGridCell& GridCell = Grid.Cells[((size_t)Cell[2] * Grid.Dims[1] + Cell[1]) * Grid.Dims[0] + Cell[0]];
+
+	float MinDistance = Grid.InfluenceRadius;
+	for (uint32_t i = 0; i < GridCell.Count; i++)
+	{
+		const TSDFObjectSlot& Slot = Table.GetSlots()[Grid.ObjectIndices[GridCell.Offset + i]];
+		MinDistance = std::min<float>(MinDistance, ComputeObjectDistance(Slot.Object, Atlas, Position));
+	}
+
+	return MinDistance;
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "GlobalDistanceField.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct TSDFObjectTableSettings
+{
+	// Cell size of the object grid in world units
+	float GridCellSize = 1.0f;
+
+	// Larger scenes get larger cells instead of more
+	int MaxGridCellsPerAxis = 32;
+
+	// Objects are binned into every cell within this distance of their bounds. Objects left out of a cell are
+	// farther than this from any point in it, so samples clamp to it and traces step at most this far.
+	float GridInfluenceRadius = 1.0f;
+};
+
+struct TSDFObjectSlot
+{
+	TGlobalSDFObject Object;
+
+	int MeshSDFIndex = -1;
+
+	float LocalToWorldScale = 0.0f;
+
+	float BoundsMin[3] = {};
+
+	float BoundsMax[3] = {};
+
+	uint32_t TransformVersion = 0;
+
+	// Update that last kept or set the object
+	uint32_t LastSeenUpdate = 0;
+
+	bool bValid = false;
+};
+
+// Match SDFObjectGridCells in SDFShared.hlsl
+struct TSDFObjectGridCell
+{
+	uint32_t Offset = 0;
+
+	uint32_t Count = 0;
+};
+
+// Uniform grid over the world bounds of the live objects
+struct TSDFObjectGrid
+{
+	float Origin[3] = {};
+
+	float CellSize = 1.0f;
+
+	// Zero when the table is empty
+	int Dims[3] = {};
+
+	float InfluenceRadius = 0.0f;
+
+	// x fastest, ranges of ObjectIndices
+	std::vector<TSDFObjectGridCell> Cells;
+
+	// Slot indices
+	std::vector<uint32_t> ObjectIndices;
+};
+
+// Persistent slots of the scene SDF objects. Slots keep their index while an object lives, so only changed
+// descriptors are uploaded, and inverses, bounds and grid cells are only recomputed for new or moved objects.
+class TSDFObjectTable
+{
+public:
+	TSDFObjectTable(const TSDFObjectTableSettings& InSettings = TSDFObjectTableSettings());
+
+	void BeginUpdate();
+
+	// Keep Id alive this update. False when the object is new or its transform or mesh changed, SetObject must follow.
+	bool KeepObject(uint64_t Id, uint32_t TransformVersion, int MeshSDFIndex);
+
+	// Object.WorldToLocal is computed from Object.LocalToWorld
+	void SetObject(const TGlobalSDFObject& Object, int MeshSDFIndex, uint32_t TransformVersion);
+
+	// Free the slots of objects neither kept nor set since BeginUpdate, rebin the grid when anything changed
+	void EndUpdate();
+
+	const TSDFObjectTableSettings& GetSettings() const { return Settings; }
+
+	// Dead slots stay in place with bValid false until reused
+	const std::vector<TSDFObjectSlot>& GetSlots() const { return Slots; }
+
+	uint32_t GetObjectCount() const { return (uint32_t)SlotMap.size(); }
+
+	// Slots set by the last update are in [DirtyBegin, DirtyEnd)
+	uint32_t GetDirtyBegin() const { return DirtyBegin; }
+
+	uint32_t GetDirtyEnd() const { return DirtyEnd; }
+
+	// Objects set or removed by the last update
+	uint32_t GetLastChangeCount() const { return LastChangeCount; }
+
+	// The grid and the global SDF object list changed in the last update
+	bool IsGridDirty() const { return bGridDirty; }
+
+	const TSDFObjectGrid& GetGrid() const { return Grid; }
+
+	// Live objects in slot order
+	const std::vector<TGlobalSDFObject>& GetGlobalSDFObjects() const { return GlobalSDFObjects; }
+
+private:
+	// Cells of the grid a slot is binned into, Max inclusive
+	struct TSlotCells
+	{
+		int Min[3] = {};
+
+		int Max[3] = {};
+
+		bool bBinned = false;
+	};
+
+	// Fit the grid around every live object and rebin them all
+	void BuildGrid();
+
+	void BinSlot(uint32_t SlotIndex);
+
+	void UnbinSlot(uint32_t SlotIndex);
+
+private:
+	TSDFObjectTableSettings Settings;
+
+	std::unordered_map<uint64_t, uint32_t> SlotMap;
+
+	std::vector<TSDFObjectSlot> Slots;
+
+	// Lowest index last, so the table stays packed at the front
+	std::vector<uint32_t> FreeSlots;
+
+	uint32_t UpdateIndex = 0;
+
+	uint32_t DirtyBegin = 0;
+
+	uint32_t DirtyEnd = 0;
+
+	uint32_t ChangeCount = 0;
+
+	uint32_t LastChangeCount = 0;
+
+	bool bGridDirty = false;
+
+	TSDFObjectGrid Grid;
+
+	// Slot indices per cell, flattened into Grid after every change
+	std::vector<std::vector<uint32_t>> CellObjects;
+
+	// Parallel to Slots
+	std::vector<TSlotCells> SlotCells;
+
+	// Slots set this update, binned in EndUpdate
+	std::vector<uint32_t> PendingSlots;
+
+	std::vector<TGlobalSDFObject> GlobalSDFObjects;
+};
+
+// CPU reference of SampleObjectDistanceFields in SDFShared.hlsl. The closest object binned into the grid cell
+// of Position clamped to the influence radius, outside the grid the distance to it plus the influence radius.
+float SampleObjectGridDistance(const TSDFObjectTable& Table, const TSDFBrickAtlas& Atlas, const float Position[3]);
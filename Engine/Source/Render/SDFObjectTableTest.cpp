@@ -0,0 +1,374 @@
+#include "SDFObjectTable.h"
+#include "Mesh/MeshSDFLayout.h"
+#include "Mesh/SDFBrickAtlas.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+// Benchmarks TSDFObjectTable updates against rebuilding every descriptor each frame, and checks that grid sampling
+// matches a brute force loop over every object and that an incrementally updated table matches a fresh one.
+// Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	typedef std::chrono::steady_clock TClock;
+
+	double ElapsedMilliseconds(TClock::time_point StartTime)
+	{
+		return std::chrono::duration<double, std::milli>(TClock::now() - StartTime).count();
+	}
+
+	const int SphereResolution = 32;
+
+	// Dense R8 volume of a sphere of radius 0.5 in a unit extent, quantized like BuildMeshSDF
+	std::vector<uint8_t> BuildSphereSDF()
+	{
+		const int Resolution = SphereResolution;
+		const float VoxelSize = 2.0f / Resolution;
+		const float DistanceRange = MeshSDFDistanceBandVoxels * VoxelSize;
+
+		std::vector<uint8_t> SDF((size_t)Resolution * Resolution * Resolution);
+		for (int Z = 0; Z < Resolution; Z++)
+		{
+			for (int Y = 0; Y < Resolution; Y++)
+			{
+				for (int X = 0; X < Resolution; X++)
+				{
+					const float PX = (X + 0.5f) * VoxelSize - 1.0f;
+					const float PY = (Y + 0.5f) * VoxelSize - 1.0f;
+					const float PZ = (Z + 0.5f) * VoxelSize - 1.0f;
+					const float Distance = std::sqrt(PX * PX + PY * PY + PZ * PZ) - 0.5f;
+
+					const float Value = Distance / DistanceRange * 0.5f + 0.5f;
+					SDF[((size_t)Z * Resolution + Y) * Resolution + X] = (uint8_t)std::clamp((int)(Value * 255.0f + 0.5f), 0, 255);
+				}
+			}
+		}
+
+		return SDF;
+	}
+
+	// Scene object as a component would describe it, Version bumps on every move
+	struct TSceneObject
+	{
+		uint64_t Id = 0;
+
+		float Position[3] = {};
+
+		float Scale = 1.0f;
+
+		uint32_t Version = 0;
+	};
+
+	TGlobalSDFObject MakeObject(const TSceneObject& SceneObject, const std::vector<uint32_t>& Indirection)
+	{
+		TGlobalSDFObject Object;
+		Object.Id = SceneObject.Id;
+		Object.BrickIndirection = &Indirection;
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			Object.Extent[Axis] = 1.0f;
+			Object.Resolution[Axis] = SphereResolution;
+			Object.LocalToWorld[Axis][Axis] = SceneObject.Scale;
+			Object.LocalToWorld[3][Axis] = SceneObject.Position[Axis];
+		}
+
+		return Object;
+	}
+
+	// What the renderer did per object and frame before the table: a general matrix inverse, scale and bounds
+	struct TRebuiltDescriptor
+	{
+		float LocalToWorld[4][3];
+
+		float WorldToLocal[4][3];
+
+		float Scale;
+
+		float BoundsMin[3];
+
+		float BoundsMax[3];
+	};
+
+	void InvertAffine(const float Matrix[4][3], float OutInverse[4][3])
+	{
+		// Gauss-Jordan on the 4x4 matrix with the implicit last column, like a generic XMMatrixInverse
+		double Augmented[4][8] = {};
+		for (int Row = 0; Row < 4; Row++)
+		{
+			for (int Column = 0; Column < 3; Column++)
+			{
+				Augmented[Row][Column] = Matrix[Row][Column];
+			}
+			Augmented[Row][3] = Row == 3 ? 1.0 : 0.0;
+			Augmented[Row][4 + Row] = 1.0;
+		}
+
+		for (int Column = 0; Column < 4; Column++)
+		{
+			int Pivot = Column;
+			for (int Row = Column + 1; Row < 4; Row++)
+			{
+				if (std::fabs(Augmented[Row][Column]) > std::fabs(Augmented[Pivot][Column]))
+				{
+					Pivot = Row;
+				}
+			}
+			std::swap(Augmented[Column], Augmented[Pivot]);
+
+			const double InvPivot = 1.0 / Augmented[Column][Column];
+			for (int k = 0; k < 8; k++)
+			{
+				Augmented[Column][k] *= InvPivot;
+			}
+
+			for (int Row = 0; Row < 4; Row++)
+			{
+				if (Row != Column)
+				{
+					const double Factor = Augmented[Row][Column];
+					for (int k = 0; k < 8; k++)
+					{
+						Augmented[Row][k] -= Factor * Augmented[Column][k];
+					}
+				}
+			}
+		}
+
+		for (int Row = 0; Row < 4; Row++)
+		{
+			for (int Column = 0; Column < 3; Column++)
+			{
+				OutInverse[Row][Column] = (float)Augmented[Row][4 + Column];
+			}
+		}
+	}
+
+	void UpdateTable(TSDFObjectTable& Table, const std::vector<TSceneObject>& SceneObjects, const std::vector<uint32_t>& Indirection)
+	{
+		Table.BeginUpdate();
+		for (const TSceneObject& SceneObject : SceneObjects)
+		{
+			if (!Table.KeepObject(SceneObject.Id, SceneObject.Version, 0))
+			{
+				Table.SetObject(MakeObject(SceneObject, Indirection), 0, SceneObject.Version);
+			}
+		}
+		Table.EndUpdate();
+	}
+
+	void RunScene(int ObjectCount, const TSDFBrickAtlas& Atlas, const std::vector<uint32_t>& Indirection)
+	{
+		const int FrameCount = 50;
+
+		// Keep the density constant, a flat scene like a level
+		std::mt19937 Random(7);
+		const float Span = std::cbrt((float)ObjectCount) * 2.0f;
+		std::uniform_real_distribution<float> Uniform(-Span, Span);
+		std::uniform_real_distribution<float> UniformScale(0.3f, 1.2f);
+
+		auto MakeSceneObject = [&](uint64_t Id)
+		{
+			TSceneObject SceneObject;
+			SceneObject.Id = Id;
+			SceneObject.Position[0] = Uniform(Random);
+			SceneObject.Position[1] = Uniform(Random) * 0.25f;
+			SceneObject.Position[2] = Uniform(Random);
+			SceneObject.Scale = UniformScale(Random);
+			return SceneObject;
+		};
+
+		std::vector<TSceneObject> SceneObjects;
+		for (int i = 0; i < ObjectCount; i++)
+		{
+			SceneObjects.push_back(MakeSceneObject(i + 1));
+		}
+
+		TSDFObjectTable Table;
+		TClock::time_point StartTime = TClock::now();
+		UpdateTable(Table, SceneObjects, Indirection);
+		const double FirstMs = ElapsedMilliseconds(StartTime);
+
+		std::vector<TRebuiltDescriptor> Rebuilt(ObjectCount);
+		StartTime = TClock::now();
+		for (int Frame = 0; Frame < FrameCount; Frame++)
+		{
+			for (int i = 0; i < ObjectCount; i++)
+			{
+				const TGlobalSDFObject Object = MakeObject(SceneObjects[i], Indirection);
+				memcpy(Rebuilt[i].LocalToWorld, Object.LocalToWorld, sizeof(Object.LocalToWorld));
+				InvertAffine(Object.LocalToWorld, Rebuilt[i].WorldToLocal);
+				Rebuilt[i].Scale = ComputeObjectLocalToWorldScale(Object);
+				ComputeObjectWorldBounds(Object, Rebuilt[i].BoundsMin, Rebuilt[i].BoundsMax);
+			}
+		}
+		const double RebuildMs = ElapsedMilliseconds(StartTime) / FrameCount;
+
+		bool bStaticUnchanged = true;
+		StartTime = TClock::now();
+		for (int Frame = 0; Frame < FrameCount; Frame++)
+		{
+			UpdateTable(Table, SceneObjects, Indirection);
+			bStaticUnchanged &= Table.GetLastChangeCount() == 0 && !Table.IsGridDirty();
+		}
+		const double StaticMs = ElapsedMilliseconds(StartTime) / FrameCount;
+
+		Check(bStaticUnchanged, "static frames change nothing and keep the grid");
+
+		// 1% and 10% of the objects move every frame
+		const int MoveCounts[2] = { std::max<int>(1, ObjectCount / 100), ObjectCount / 10 };
+		double MoveMs[2] = {};
+		bool bChangesCounted = true;
+		for (int k = 0; k < 2; k++)
+		{
+			StartTime = TClock::now();
+			for (int Frame = 0; Frame < FrameCount; Frame++)
+			{
+				for (int m = 0; m < MoveCounts[k]; m++)
+				{
+					TSceneObject& SceneObject = SceneObjects[(Frame * MoveCounts[k] + m) % ObjectCount];
+					SceneObject.Position[0] += 0.01f;
+					SceneObject.Version++;
+				}
+
+				UpdateTable(Table, SceneObjects, Indirection);
+				bChangesCounted &= Table.GetLastChangeCount() == (uint32_t)MoveCounts[k];
+			}
+			MoveMs[k] = ElapsedMilliseconds(StartTime) / FrameCount;
+		}
+
+		Check(bChangesCounted, "moving objects are the only changes");
+
+		// Remove 5% and add 2.5% new objects
+		SceneObjects.erase(SceneObjects.begin() + ObjectCount / 3, SceneObjects.begin() + ObjectCount / 3 + ObjectCount / 20);
+		for (int i = 0; i < ObjectCount / 40; i++)
+		{
+			SceneObjects.push_back(MakeSceneObject(ObjectCount + 100 + i));
+		}
+		UpdateTable(Table, SceneObjects, Indirection);
+
+		Check(Table.GetObjectCount() == SceneObjects.size(), "removed objects free their slots");
+
+		// Slots are freed in EndUpdate, so objects added from the next update on reuse them
+		const size_t SlotCount = Table.GetSlots().size();
+		for (int i = 0; i < ObjectCount / 40; i++)
+		{
+			SceneObjects.push_back(MakeSceneObject(ObjectCount * 2 + 100 + i));
+		}
+		UpdateTable(Table, SceneObjects, Indirection);
+
+		Check(Table.GetSlots().size() == SlotCount, "new objects reuse freed slots");
+
+		TSDFObjectTable FreshTable;
+		UpdateTable(FreshTable, SceneObjects, Indirection);
+
+		// Random samples over the scene, a little beyond it so some fall outside the grid. Fewer in large scenes to keep
+		// the brute force reference affordable.
+		const int SampleCount = std::min<int>(20000, 2000000 / ObjectCount);
+		std::vector<float> Positions(SampleCount * 3);
+		for (int s = 0; s < SampleCount; s++)
+		{
+			Positions[s * 3 + 0] = Uniform(Random) * 1.1f;
+			Positions[s * 3 + 1] = Uniform(Random) * 1.1f * 0.25f;
+			Positions[s * 3 + 2] = Uniform(Random) * 1.1f;
+		}
+
+		std::vector<float> BruteDistances(SampleCount);
+		StartTime = TClock::now();
+		for (int s = 0; s < SampleCount; s++)
+		{
+			float Distance = 1e6f;
+			for (const TSDFObjectSlot& Slot : Table.GetSlots())
+			{
+				if (Slot.bValid)
+				{
+					Distance = std::min<float>(Distance, ComputeObjectDistance(Slot.Object, Atlas, &Positions[s * 3]));
+				}
+			}
+			BruteDistances[s] = Distance;
+		}
+		const double BruteMs = ElapsedMilliseconds(StartTime);
+
+		std::vector<float> GridDistances(SampleCount);
+		StartTime = TClock::now();
+		for (int s = 0; s < SampleCount; s++)
+		{
+			GridDistances[s] = SampleObjectGridDistance(Table, Atlas, &Positions[s * 3]);
+		}
+		const double GridMs = ElapsedMilliseconds(StartTime);
+
+		const TSDFObjectGrid& Grid = Table.GetGrid();
+		int OverestimateCount = 0;
+		int NearMismatchCount = 0;
+		int FreshMismatchCount = 0;
+		double VisitedObjects = 0.0;
+		for (int s = 0; s < SampleCount; s++)
+		{
+			const float* Position = &Positions[s * 3];
+
+			// Objects left out of a cell are farther than the influence radius, within it the grid is exact
+			OverestimateCount += GridDistances[s] > BruteDistances[s] + 1e-5f;
+			NearMismatchCount += BruteDistances[s] < Grid.InfluenceRadius && std::fabs(GridDistances[s] - BruteDistances[s]) > 1e-5f;
+
+			const float FreshDistance = SampleObjectGridDistance(FreshTable, Atlas, Position);
+			FreshMismatchCount += std::min<float>(FreshDistance, Grid.InfluenceRadius) != std::min<float>(GridDistances[s], Grid.InfluenceRadius);
+
+			int Cell[3];
+			bool bInsideGrid = true;
+			for (int Axis = 0; Axis < 3; Axis++)
+			{
+				const float GridPosition = (Position[Axis] - Grid.Origin[Axis]) / Grid.CellSize;
+				bInsideGrid &= GridPosition >= 0.0f && GridPosition < Grid.Dims[Axis];
+				Cell[Axis] = std::min<int>((int)GridPosition, Grid.Dims[Axis] - 1);
+			}
+			if (bInsideGrid)
+			{
+				VisitedObjects += Grid.Cells[((size_t)Cell[2] * Grid.Dims[1] + Cell[1]) * Grid.Dims[0] + Cell[0]].Count;
+			}
+		}
+
+		printf("%d objects: grid %dx%dx%d of %.2f, %zu binned indices\n",
+			ObjectCount, Grid.Dims[0], Grid.Dims[1], Grid.Dims[2], Grid.CellSize, Grid.ObjectIndices.size());
+		printf("  first update %.3f ms, full rebuild %.3f ms/frame, static %.4f ms/frame, %d moving %.3f ms/frame, %d moving %.3f ms/frame\n",
+			FirstMs, RebuildMs, StaticMs, MoveCounts[0], MoveMs[0], MoveCounts[1], MoveMs[1]);
+		printf("  %d samples: brute force %.1f ms over %u objects, grid %.1f ms over %.1f objects on average\n",
+			SampleCount, BruteMs, Table.GetObjectCount(), GridMs, VisitedObjects / SampleCount);
+
+		Check(OverestimateCount == 0, "grid samples never overestimate the brute force distance");
+		Check(NearMismatchCount == 0, "grid samples match brute force within the influence radius");
+		Check(FreshMismatchCount == 0, "incrementally updated table samples like a fresh one");
+	}
+}
+
+int main()
+{
+	const int Resolution[3] = { SphereResolution, SphereResolution, SphereResolution };
+	TSparseMeshSDF SphereSDF;
+	BuildSparseMeshSDF(BuildSphereSDF(), Resolution, 4.0f, SphereSDF);
+
+	TSDFBrickAtlas Atlas;
+	std::vector<uint32_t> Indirection;
+	Atlas.AddMesh(SphereSDF, Indirection);
+
+	for (int ObjectCount : { 100, 1000, 5000 })
+	{
+		RunScene(ObjectCount, Atlas, Indirection);
+	}
+
+	printf("%s\n", FailureCount == 0 ? "All SDF object table checks passed" : "SDF object table checks FAILED");
+
+	return FailureCount;
+}
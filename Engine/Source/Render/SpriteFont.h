@@ -38,6 +38,7 @@ public:
 	DXGI_FORMAT textureFormat;
 	uint32_t textureStride;
 	uint32_t textureRows;
+	// Moved into FontTexture when it is created, which releases it after the upload
 	std::vector<uint8_t> textureData;
 
 	std::shared_ptr<TTexture2D> GetFontTexture() { return FontTexture; }
@@ -3,6 +3,45 @@
 #include "TextureLoader/WICTextureLoader.h"
 #include "TextureLoader/HDRTextureLoader.h"
 #include "Utils/FormatConvert.h"
+#include <cstdio>
+#include <cstring>
+
+TTextureMemoryStats TTexture::MemoryStats;
+
+uint64_t TTextureMemoryStats::GetTotalCPUBytes() const
+{
+	uint64_t Total = 0;
+	for (uint64_t Bytes : CPUBytes)
+	{
+		Total += Bytes;
+	}
+
+	return Total;
+}
+
+std::string TTextureMemoryStats::ToString() const
+{
+	const char* StateNames[(size_t)ETextureResidency::Count] = { "Loading", "CPUResident", "Uploading", "GPUOnly", "GPUAndCPU" };
+
+	std::string Result = "Texture CPU memory:";
+	char Line[128];
+	for (size_t i = 0; i < (size_t)ETextureResidency::Count; i++)
+	{
+		sprintf_s(Line, " %s %u (%.2f MB),", StateNames[i], TextureCount[i], CPUBytes[i] / (1024.0 * 1024.0));
+		Result += Line;
+	}
+
+	sprintf_s(Line, " total %.2f MB, released %.2f MB\n", GetTotalCPUBytes() / (1024.0 * 1024.0), ReleasedCPUBytes / (1024.0 * 1024.0));
+	Result += Line;
+
+	return Result;
+}
+
+TTexture::~TTexture()
+{
+	MemoryStats.TextureCount[(size_t)Residency]--;
+	MemoryStats.CPUBytes[(size_t)Residency] -= AccountedCPUBytes;
+}
 
 void TTexture::LoadTextureResourceFromFlie(TD3D12RHI* D3D12RHI)
 {
@@ -19,6 +58,8 @@ void TTexture::LoadTextureResourceFromFlie(TD3D12RHI* D3D12RHI)
 	{
 		LoadHDRTexture(D3D12RHI->GetDevice());
 	}
+
+	SetResidency(ETextureResidency::CPUResident);
 }
 
 std::wstring TTexture::GetExtension(std::wstring path)
@@ -64,10 +105,93 @@ void TTexture::LoadHDRTexture(TD3D12Device* Device)
 	TextureResource.InitData.push_back(InitData);
 }
 
-void TTexture::SetTextureResourceDirectly(const TTextureInfo& InTextureInfo, const std::vector<uint8_t>& InTextureData, const D3D12_SUBRESOURCE_DATA& InInitData)
+void TTexture::SetTextureResourceFromDecodedImage(TDecodedImage& Image)
+{
+	FillTextureResource(Image, bSRGB, TextureResource);
+
+	SetResidency(ETextureResidency::CPUResident);
+}
+
+void TTexture::FillTextureResource(TDecodedImage& Image, bool InbSRGB, TTextureResource& OutResource)
+{
+	TTextureInfo& TextureInfo = OutResource.TextureInfo;
+	TextureInfo.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	TextureInfo.Width = Image.Width;
+	TextureInfo.Height = Image.Height;
+	TextureInfo.Depth = 1;
+	TextureInfo.ArraySize = 1;
+	TextureInfo.MipCount = Image.Mips.empty() ? 1 : Image.Mips.size();
+
+	// Same formats the WIC and HDR loaders produce
+	switch (Image.Format)
+	{
+	case EDecodedImageFormat::R8:
+		TextureInfo.Format = DXGI_FORMAT_R8_UNORM;
+		break;
+	case EDecodedImageFormat::RGBA8:
+		TextureInfo.Format = InbSRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+		break;
+	case EDecodedImageFormat::RGB32F:
+		TextureInfo.Format = DXGI_FORMAT_R32G32B32_FLOAT;
+		break;
+	case EDecodedImageFormat::R9G9B9E5:
+		TextureInfo.Format = DXGI_FORMAT_R9G9B9E5_SHAREDEXP;
+		break;
+	case EDecodedImageFormat::R11G11B10:
+		TextureInfo.Format = DXGI_FORMAT_R11G11B10_FLOAT;
+		break;
+	}
+
+	OutResource.TextureData = std::move(Image.Data);
+	OutResource.InitData.clear();
+
+	if (Image.Mips.empty())
+	{
+		D3D12_SUBRESOURCE_DATA InitData;
+		InitData.pData = OutResource.TextureData.data();
+		InitData.RowPitch = Image.RowPitch;
+		InitData.SlicePitch = (LONG_PTR)Image.RowPitch * Image.Height;
+
+		OutResource.InitData.push_back(InitData);
+	}
+	else
+	{
+		for (const TDecodedMip& Mip : Image.Mips)
+		{
+			D3D12_SUBRESOURCE_DATA InitData;
+			InitData.pData = OutResource.TextureData.data() + Mip.Offset;
+			InitData.RowPitch = Mip.RowPitch;
+			InitData.SlicePitch = (LONG_PTR)Mip.RowPitch * Mip.Height;
+
+			OutResource.InitData.push_back(InitData);
+		}
+	}
+}
+
+bool TTexture::SetReloadedTextureResource(TTextureResource&& Resource)
+{
+	const TTextureInfo& TextureInfo = TextureResource.TextureInfo;
+	if (Resource.TextureInfo.Width != TextureInfo.Width || Resource.TextureInfo.Height != TextureInfo.Height
+		|| Resource.TextureInfo.MipCount != TextureInfo.MipCount || Resource.TextureInfo.Format != TextureInfo.Format
+		|| Resource.InitData.size() != TextureInfo.MipCount)
+	{
+		return false;
+	}
+
+	// Moving the vectors keeps the InitData pointers into TextureData valid
+	Resource.TextureInfo.Type = TextureInfo.Type;
+	TextureResource = std::move(Resource);
+
+	// Count the new TextureData in the current state
+	SetResidency(Residency);
+
+	return true;
+}
+
+void TTexture::SetTextureResourceDirectly(const TTextureInfo& InTextureInfo, std::vector<uint8_t>&& InTextureData, const D3D12_SUBRESOURCE_DATA& InInitData)
 {
 	TextureResource.TextureInfo = InTextureInfo;
-	TextureResource.TextureData = InTextureData;
+	TextureResource.TextureData = std::move(InTextureData);
 
 	D3D12_SUBRESOURCE_DATA InitData;
 	InitData.pData = TextureResource.TextureData.data();
@@ -75,6 +199,8 @@ void TTexture::SetTextureResourceDirectly(const TTextureInfo& InTextureInfo, con
 	InitData.SlicePitch = InInitData.SlicePitch;
 
 	TextureResource.InitData.push_back(InitData);
+
+	SetResidency(ETextureResidency::CPUResident);
 }
 
 void TTexture::CreateTexture(TD3D12RHI* D3D12RHI)
@@ -88,8 +214,149 @@ void TTexture::CreateTexture(TD3D12RHI* D3D12RHI)
 
 	//Upload InitData
 	D3D12RHI->UploadTextureData(D3DTexture, TextureResource.InitData);
+
+	OnUploaded();
+}
+
+void TTexture::CreateTextureAsync(TD3D12RHI* D3D12RHI)
+{
+	//Create D3DTexture
+	auto& TextureInfo = TextureResource.TextureInfo;
+	TextureInfo.Type = Type;
+	D3DTexture = D3D12RHI->CreateTexture(TextureInfo, TexCreate_SRV);
+
+	//Upload InitData on copy queue, it is read when the copy is recorded
+	SetResidency(ETextureResidency::Uploading);
+
+	D3D12RHI->UploadTextureDataAsync(D3DTexture, TextureResource.InitData, [this]()
+	{
+		OnUploaded();
+	});
+}
+
+void TTexture::CreateStreamedTexture(TD3D12RHI* D3D12RHI, uint32_t FirstMip, TUploadCallback OnStreamed)
+{
+	// Every request uploads from TextureResource, mips above the tail must have been reloaded first
+	assert(bStreamed && FirstMip < TextureResource.TextureInfo.MipCount && HasCPUMips(FirstMip));
+
+	TTextureInfo TextureInfo = TextureResource.TextureInfo;
+	TextureInfo.Type = Type;
+	TextureInfo.Width = std::max<size_t>(TextureInfo.Width >> FirstMip, 1);
+	TextureInfo.Height = std::max<size_t>(TextureInfo.Height >> FirstMip, 1);
+	TextureInfo.MipCount -= FirstMip;
+
+	TD3D12TextureRef StreamedTexture = D3D12RHI->CreateTexture(TextureInfo, TexCreate_SRV);
+
+	std::vector<D3D12_SUBRESOURCE_DATA> InitData(TextureResource.InitData.begin() + FirstMip, TextureResource.InitData.end());
+
+	SetResidency(ETextureResidency::Uploading);
+
+	// The GPU is idle when upload callbacks run, so the old texture can be released right away
+	D3D12RHI->UploadTextureDataAsync(StreamedTexture, InitData, [this, StreamedTexture, OnStreamed]()
+	{
+		D3DTexture = StreamedTexture;
+		OnUploaded();
+
+		if (OnStreamed)
+		{
+			OnStreamed();
+		}
+	});
 }
 
+bool TTexture::IsStreamable() const
+{
+	const TTextureInfo& TextureInfo = TextureResource.TextureInfo;
+
+	// Block compressed textures need a multiple of 4 top mip, which only power of two sizes keep for every streamed mip
+	const bool bBlockCompressed = (TextureInfo.Format >= DXGI_FORMAT_BC1_TYPELESS && TextureInfo.Format <= DXGI_FORMAT_BC5_SNORM)
+		|| (TextureInfo.Format >= DXGI_FORMAT_BC6H_TYPELESS && TextureInfo.Format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+	if (bBlockCompressed && ((TextureInfo.Width & (TextureInfo.Width - 1)) != 0 || (TextureInfo.Height & (TextureInfo.Height - 1)) != 0))
+	{
+		return false;
+	}
+
+	return Type == ETextureType::TEXTURE_2D && TextureInfo.ArraySize == 1 && TextureInfo.MipCount > 1
+		&& TextureResource.InitData.size() == TextureInfo.MipCount;
+}
+
+bool TTexture::HasCPUMips(uint32_t FirstMip) const
+{
+	// Mips are released from the top, so the first one tells for the rest
+	return FirstMip < TextureResource.InitData.size() && TextureResource.InitData[FirstMip].pData != nullptr;
+}
+
+void TTexture::SetResidency(ETextureResidency NewResidency)
+{
+	MemoryStats.TextureCount[(size_t)Residency]--;
+	MemoryStats.CPUBytes[(size_t)Residency] -= AccountedCPUBytes;
+
+	Residency = NewResidency;
+	AccountedCPUBytes = TextureResource.TextureData.size();
+
+	MemoryStats.TextureCount[(size_t)Residency]++;
+	MemoryStats.CPUBytes[(size_t)Residency] += AccountedCPUBytes;
+}
+
+void TTexture::OnUploaded()
+{
+	bResident = true;
+
+	if (bKeepCPUData)
+	{
+		SetResidency(ETextureResidency::GPUAndCPU);
+		return;
+	}
+
+	if (bStreamed)
+	{
+		ReleaseStreamedMips();
+		SetResidency(ETextureResidency::GPUOnly);
+		return;
+	}
+
+	// Swap with empty containers, clear() keeps the capacity
+	MemoryStats.ReleasedCPUBytes += TextureResource.TextureData.size();
+	std::vector<uint8_t>().swap(TextureResource.TextureData);
+	std::vector<D3D12_SUBRESOURCE_DATA>().swap(TextureResource.InitData);
+
+	SetResidency(ETextureResidency::GPUOnly);
+}
+
+void TTexture::ReleaseStreamedMips()
+{
+	std::vector<D3D12_SUBRESOURCE_DATA>& InitData = TextureResource.InitData;
+	const uint32_t TailMip = std::min<uint32_t>(StreamedTailMip, (uint32_t)InitData.size() - 1);
+
+	uint64_t TailBytes = 0;
+	for (uint32_t Mip = TailMip; Mip < (uint32_t)InitData.size(); Mip++)
+	{
+		TailBytes += InitData[Mip].SlicePitch;
+	}
+
+	// Already released by an earlier upload
+	if (TailBytes >= TextureResource.TextureData.size())
+	{
+		return;
+	}
+
+	std::vector<uint8_t> TailData(TailBytes);
+	uint8_t* Dest = TailData.data();
+	for (uint32_t Mip = TailMip; Mip < (uint32_t)InitData.size(); Mip++)
+	{
+		memcpy(Dest, InitData[Mip].pData, InitData[Mip].SlicePitch);
+		InitData[Mip].pData = Dest;
+		Dest += InitData[Mip].SlicePitch;
+	}
+
+	for (uint32_t Mip = 0; Mip < TailMip; Mip++)
+	{
+		InitData[Mip].pData = nullptr;
+	}
+
+	MemoryStats.ReleasedCPUBytes += TextureResource.TextureData.size() - TailBytes;
+	TextureResource.TextureData.swap(TailData);
+}
 
 TTexture2D::TTexture2D(const std::string& InName, bool InbSRGB, std::wstring InFilePath)
 	:TTexture(InName, ETextureType::TEXTURE_2D, InbSRGB, InFilePath)
@@ -2,9 +2,45 @@
 
 #include <string>
 #include "Texture/TextureInfo.h"
+#include "TextureLoader/ImageDecoder.h"
 #include "D3D12/D3D12Texture.h"
 #include "D3D12/D3D12RHI.h"
 
+// Where the pixels of a texture live
+enum class ETextureResidency
+{
+	// Not loaded yet
+	Loading,
+
+	// Pixels in TextureResource, no GPU texture
+	CPUResident,
+
+	// GPU texture created, its upload has not completed
+	Uploading,
+
+	// Uploaded, CPU pixels released. Streamed textures keep their tail mips.
+	GPUOnly,
+
+	// Uploaded, CPU pixels kept (bKeepCPUData)
+	GPUAndCPU,
+
+	Count,
+};
+
+struct TTextureMemoryStats
+{
+	uint32_t TextureCount[(size_t)ETextureResidency::Count] = {};
+
+	// TextureData held by textures in each state
+	uint64_t CPUBytes[(size_t)ETextureResidency::Count] = {};
+
+	uint64_t ReleasedCPUBytes = 0;
+
+	uint64_t GetTotalCPUBytes() const;
+
+	std::string ToString() const;
+};
+
 struct TTextureResource
 {
 	TTextureInfo TextureInfo;
@@ -19,10 +55,11 @@ class TTexture
 public:
 	TTexture(const std::string& InName, ETextureType InType, bool InbSRGB, std::wstring InFilePath)
 		:Name(InName), Type(InType), bSRGB(InbSRGB), FilePath(InFilePath)
-	{}
+	{
+		MemoryStats.TextureCount[(size_t)ETextureResidency::Loading]++;
+	}
 
-	virtual ~TTexture()
-	{}
+	virtual ~TTexture();
 
 	TTexture(const TTexture& Other) = delete;
 
@@ -31,11 +68,43 @@ public:
 public:
 	void LoadTextureResourceFromFlie(TD3D12RHI* D3D12RHI);
 
-	void SetTextureResourceDirectly(const TTextureInfo& InTextureInfo, const std::vector<uint8_t>& InTextureData, 
+	// Take over pixels decoded by TTextureDecodePipeline
+	void SetTextureResourceFromDecodedImage(TDecodedImage& Image);
+
+	// Fill a resource from decoded pixels without touching any texture, safe on worker threads
+	static void FillTextureResource(TDecodedImage& Image, bool InbSRGB, TTextureResource& OutResource);
+
+	// Take over the full mip chain of a streamed texture read again from its file.
+	// Returns false if the file no longer matches the registered texture.
+	bool SetReloadedTextureResource(TTextureResource&& Resource);
+
+	// Takes ownership of InTextureData
+	void SetTextureResourceDirectly(const TTextureInfo& InTextureInfo, std::vector<uint8_t>&& InTextureData, 
 		const D3D12_SUBRESOURCE_DATA& InInitData);
 
+	// CPU pixels are released right away unless bKeepCPUData, UploadTextureData has copied them to the upload heap
 	void CreateTexture(TD3D12RHI* D3D12RHI);
 
+	// Create texture now and upload its data on the copy queue, not resident until the upload completes.
+	// CPU pixels are released once the copy fence completes unless bKeepCPUData.
+	void CreateTextureAsync(TD3D12RHI* D3D12RHI);
+
+	// Replace D3DTexture with one holding mips [FirstMip, MipCount) once their upload completes.
+	// Only mips from StreamedTailMip on stay in TextureResource afterwards.
+	void CreateStreamedTexture(TD3D12RHI* D3D12RHI, uint32_t FirstMip, TUploadCallback OnStreamed);
+
+	bool IsStreamable() const;
+
+	// Whether TextureResource still holds mips [FirstMip, MipCount)
+	bool HasCPUMips(uint32_t FirstMip) const;
+
+	bool IsResident() const { return bResident; }
+
+	ETextureResidency GetResidency() const { return Residency; }
+
+	// Live textures by residency state, updated on every state change
+	static const TTextureMemoryStats& GetMemoryStats() { return MemoryStats; }
+
 	TD3D12TextureRef GetD3DTexture() { return D3DTexture; }
 
 private:
@@ -47,6 +116,14 @@ private:
 
 	void LoadHDRTexture(TD3D12Device* Device);
 
+	void SetResidency(ETextureResidency NewResidency);
+
+	// Called once the GPU texture holds every mip
+	void OnUploaded();
+
+	// Compact TextureData to the mips from StreamedTailMip on, higher mips keep their pitches with a null pData
+	void ReleaseStreamedMips();
+
 public:
 	std::string Name;
 
@@ -56,9 +133,30 @@ public:
 
 	bool bSRGB = true;
 
+	// Build a CPU mip chain for PNG/JPG/HDR files
+	bool bGenerateMips = true;
+
+	// Keep TextureResource after the upload, for textures read or sampled on the CPU
+	bool bKeepCPUData = false;
+
+	// Mips are uploaded by CreateStreamedTexture, only those from StreamedTailMip on are kept in CPU memory
+	bool bStreamed = false;
+
+	uint32_t StreamedTailMip = 0;
+
 	TTextureResource TextureResource;
 
 	TD3D12TextureRef D3DTexture = nullptr;
+
+	bool bResident = false;
+
+private:
+	ETextureResidency Residency = ETextureResidency::Loading;
+
+	// TextureData bytes counted in MemoryStats for the current state
+	uint64_t AccountedCPUBytes = 0;
+
+	static TTextureMemoryStats MemoryStats;
 };
 
 class TTexture2D : public TTexture
@@ -0,0 +1,157 @@
+#include "TextureAssets.h"
+#include "File/FileHelpers.h"
+#include "File/MappedFile.h"
+#include "Utils/FormatConvert.h"
+#include "Utils/Hash.h"
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	const uint32_t CookedTextureKeyMagic = 0x59454B54; // "TKEY"
+}
+
+const std::vector<TTextureAsset>& GetTextureAssets()
+{
+	// Lookup tables are read at their exact resolution
+	static const std::vector<TTextureAsset> Assets =
+	{
+		{ "NullTex", L"white1x1.dds", false, true },
+
+		// PBR textures
+		{ "AssaultRifle_BaseColor", L"AssaultRifle_BaseColor.png", true, true },
+		{ "AssaultRifle_Normal", L"AssaultRifle_Normal.png", false, true },
+		{ "AssaultRifle_Metallic", L"AssaultRifle_Metallic.png", false, true },
+		{ "AssaultRifle_Roughness", L"AssaultRifle_Roughness.png", false, true },
+		{ "CyborgWeapon_BaseColor", L"CyborgWeapon_BaseColor.png", true, true },
+		{ "CyborgWeapon_Normal", L"CyborgWeapon_Normal.png", false, true },
+		{ "CyborgWeapon_Metallic", L"CyborgWeapon_Metallic.png", false, true },
+		{ "CyborgWeapon_Roughness", L"CyborgWeapon_Roughness.png", false, true },
+		{ "RustedIron_BaseColor", L"rustediron2_basecolor.png", true, true },
+		{ "RustedIron_Normal", L"rustediron2_normal.png", false, true },
+		{ "RustedIron_Metallic", L"rustediron2_metallic.png", false, true },
+		{ "RustedIron_Roughness", L"rustediron2_roughness.png", false, true },
+		{ "GrayGranite_BaseColor", L"gray-granite-flecks-albedo.png", true, true },
+		{ "GrayGranite_Normal", L"gray-granite-flecks-Normal-dx.png", false, true },
+		{ "GrayGranite_Metallic", L"gray-granite-flecks-Metallic.png", false, true },
+		{ "GrayGranite_Roughness", L"gray-granite-flecks-Roughness.png", false, true },
+		{ "Helmet_BaseColor", L"helmet_low_DefaultMaterial_BaseColor.png", true, true },
+		{ "Helmet_Normal", L"helmet_low_DefaultMaterial_Normal.png", false, true },
+		{ "Helmet_Metallic", L"helmet_low_DefaultMaterial_Metallic.png", false, true },
+		{ "Helmet_Roughness", L"helmet_low_DefaultMaterial_Roughness.png", false, true },
+		{ "Floor_BaseColor", L"hardwood-brown-planks-albedo.png", true, true },
+		{ "Floor_Normal", L"hardwood-brown-planks-normal-dx.png", false, true },
+		{ "Floor_Metallic", L"hardwood-brown-planks-metallic.png", false, true },
+		{ "Floor_Roughness", L"hardwood-brown-planks-roughness.png", false, true },
+		{ "Column_BaseColor", L"column_albedo.jpg", true, true },
+		{ "Column_Normal", L"column_normal.png", false, true },
+		{ "Column_Roughness", L"column_roughness.jpg", false, true },
+
+		// LUT
+		{ "IBL_BRDF_LUT", L"IBL_BRDF_LUT.png", false, false },
+
+		// HDR
+		{ "Newport_Loft", L"Newport_Loft_Ref.hdr", false, true },
+		{ "Shiodome_Stairs", L"10-Shiodome_Stairs_3k.hdr", false, true },
+
+		// AreaLight(LTC)
+		{ "LtcMat_1", L"ltc_1.dds", false, true },
+		{ "LtcMat_2", L"ltc_2.dds", false, true },
+
+		// Noise
+		{ "BlueNoiseTex", L"BlueNoise.png", false, false },
+	};
+
+	return Assets;
+}
+
+std::wstring GetTextureSourcePath(const std::string& TextureName)
+{
+	for (const TTextureAsset& Asset : GetTextureAssets())
+	{
+		if (Asset.TextureName == TextureName)
+		{
+			return TFileHelpers::EngineDir() + L"Resource/Textures/" + Asset.FileName;
+		}
+	}
+
+	return std::wstring();
+}
+
+std::wstring GetCookedTexturePath(const std::string& TextureName)
+{
+	return TFileHelpers::EngineDir() + L"Save/CookedTexture/" + TFormatConvert::StrToWStr(TextureName) + L".dds";
+}
+
+bool IsNormalMap(const std::string& TextureName)
+{
+	const std::string Suffix = "_Normal";
+
+	return TextureName.size() >= Suffix.size() && TextureName.compare(TextureName.size() - Suffix.size(), Suffix.size(), Suffix) == 0;
+}
+
+std::wstring GetCookedTextureSourceKeyPath(const std::wstring& CookedPath)
+{
+	return CookedPath + L".key";
+}
+
+bool GetCookedTextureSourceKey(const std::wstring& SourcePath, TCookedTextureSourceKey& OutKey)
+{
+	TMappedFile SourceFile;
+	if (!SourceFile.Open(SourcePath))
+	{
+		return false;
+	}
+
+	OutKey = TCookedTextureSourceKey();
+	OutKey.SourceFileSize = SourceFile.GetSize();
+	OutKey.SourceHash = THash::HashBytes(SourceFile.GetData(), SourceFile.GetSize());
+
+	return true;
+}
+
+bool SaveCookedTextureSourceKey(const std::wstring& CookedPath, const TCookedTextureSourceKey& Key)
+{
+	std::ofstream File(std::filesystem::path(GetCookedTextureSourceKeyPath(CookedPath)), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	File.write((const char*)&CookedTextureKeyMagic, sizeof(CookedTextureKeyMagic));
+	File.write((const char*)&Key, sizeof(Key));
+
+	return File.good();
+}
+
+bool IsCookedTextureUpToDate(const std::wstring& SourcePath, const std::wstring& CookedPath)
+{
+	std::error_code Error;
+	if (!std::filesystem::exists(CookedPath, Error))
+	{
+		return false;
+	}
+
+	std::ifstream File(std::filesystem::path(GetCookedTextureSourceKeyPath(CookedPath)), std::ios::in | std::ios::binary);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	uint32_t Magic = 0;
+	TCookedTextureSourceKey CookedKey;
+	File.read((char*)&Magic, sizeof(Magic));
+	File.read((char*)&CookedKey, sizeof(CookedKey));
+	if (!File.good() || Magic != CookedTextureKeyMagic)
+	{
+		return false;
+	}
+
+	TCookedTextureSourceKey SourceKey;
+	if (!GetCookedTextureSourceKey(SourcePath, SourceKey))
+	{
+		return false;
+	}
+
+	return CookedKey.SourceFileSize == SourceKey.SourceFileSize && CookedKey.SourceHash == SourceKey.SourceHash;
+}
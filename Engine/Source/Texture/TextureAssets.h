@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TTextureAsset
+{
+	std::string TextureName;
+
+	// Relative to Resource/Textures
+	std::wstring FileName;
+
+	bool bSRGB = false;
+
+	// False for lookup tables, which are also never block compressed
+	bool bGenerateMips = true;
+};
+
+// Texture files, shared by TTextureRepository and the asset cooker
+const std::vector<TTextureAsset>& GetTextureAssets();
+
+// Source file in Resource/Textures, empty for unknown textures
+std::wstring GetTextureSourcePath(const std::string& TextureName);
+
+// Block compressed DDS written by the asset cooker
+std::wstring GetCookedTexturePath(const std::string& TextureName);
+
+bool IsNormalMap(const std::string& TextureName);
+
+// Fingerprint of the source a DDS was cooked from, kept in a sidecar next to it.
+// Content based like TCookedMeshSourceKey, so cooked files stay valid after a fresh checkout.
+struct TCookedTextureSourceKey
+{
+	uint64_t SourceFileSize = 0;
+
+	uint64_t SourceHash = 0;
+};
+
+// <CookedPath>.key
+std::wstring GetCookedTextureSourceKeyPath(const std::wstring& CookedPath);
+
+// Hashes the source file, false if it can not be read
+bool GetCookedTextureSourceKey(const std::wstring& SourcePath, TCookedTextureSourceKey& OutKey);
+
+bool SaveCookedTextureSourceKey(const std::wstring& CookedPath, const TCookedTextureSourceKey& Key);
+
+// The DDS exists and its sidecar matches the current source
+bool IsCookedTextureUpToDate(const std::wstring& SourcePath, const std::wstring& CookedPath);
@@ -1,5 +1,11 @@
 #include "TextureRepository.h"
 #include "File/FileHelpers.h"
+#include "TextureLoader/TextureDecodePipeline.h"
+#include "TextureLoader/DDSTextureLoader.h"
+#include "TextureLoader/HDRPacking.h"
+#include "TextureLoader/MipGenerator.h"
+#include "Utils/FormatConvert.h"
+#include "Utils/Logger.h"
 
 TTextureRepository& TTextureRepository::Get()
 {
@@ -11,81 +17,128 @@ void TTextureRepository::Load()
 {
 	std::wstring TextureDir = TFileHelpers::EngineDir() + L"Resource/Textures/";
 
-	TextureMap.emplace("NullTex", std::make_shared<TTexture2D>("NullTex", false, TextureDir + L"white1x1.dds"));
-
-	// PBR textures
-	TextureMap.emplace("AssaultRifle_BaseColor", std::make_shared<TTexture2D>("AssaultRifle_BaseColor", true, TextureDir + L"AssaultRifle_BaseColor.png"));
-
-	TextureMap.emplace("AssaultRifle_Normal", std::make_shared<TTexture2D>("AssaultRifle_Normal", false, TextureDir + L"AssaultRifle_Normal.png"));
-
-	TextureMap.emplace("AssaultRifle_Metallic", std::make_shared<TTexture2D>("AssaultRifle_Metallic", false, TextureDir + L"AssaultRifle_Metallic.png"));
-
-	TextureMap.emplace("AssaultRifle_Roughness", std::make_shared<TTexture2D>("AssaultRifle_Roughness", false, TextureDir + L"AssaultRifle_Roughness.png"));
-
-	TextureMap.emplace("CyborgWeapon_BaseColor", std::make_shared<TTexture2D>("CyborgWeapon_BaseColor", true, TextureDir + L"CyborgWeapon_BaseColor.png"));
-
-	TextureMap.emplace("CyborgWeapon_Normal", std::make_shared<TTexture2D>("CyborgWeapon_Normal", false, TextureDir + L"CyborgWeapon_Normal.png"));
-
-	TextureMap.emplace("CyborgWeapon_Metallic", std::make_shared<TTexture2D>("CyborgWeapon_Metallic", false, TextureDir + L"CyborgWeapon_Metallic.png"));
-
-	TextureMap.emplace("CyborgWeapon_Roughness", std::make_shared<TTexture2D>("CyborgWeapon_Roughness", false, TextureDir + L"CyborgWeapon_Roughness.png"));
-
-	TextureMap.emplace("RustedIron_BaseColor", std::make_shared<TTexture2D>("RustedIron_BaseColor", true, TextureDir + L"rustediron2_basecolor.png"));
-
-	TextureMap.emplace("RustedIron_Normal", std::make_shared<TTexture2D>("RustedIron_Normal", false, TextureDir + L"rustediron2_normal.png"));
-
-	TextureMap.emplace("RustedIron_Metallic", std::make_shared<TTexture2D>("RustedIron_Metallic", false, TextureDir + L"rustediron2_metallic.png"));
-
-	TextureMap.emplace("RustedIron_Roughness", std::make_shared<TTexture2D>("RustedIron_Roughness", false, TextureDir + L"rustediron2_roughness.png"));
-
-	TextureMap.emplace("GrayGranite_BaseColor", std::make_shared<TTexture2D>("GrayGranite_BaseColor", true, TextureDir + L"gray-granite-flecks-albedo.png"));
-
-	TextureMap.emplace("GrayGranite_Normal", std::make_shared<TTexture2D>("GrayGranite_Normal", false, TextureDir + L"gray-granite-flecks-Normal-dx.png"));
-
-	TextureMap.emplace("GrayGranite_Metallic", std::make_shared<TTexture2D>("GrayGranite_Metallic", false, TextureDir + L"gray-granite-flecks-Metallic.png"));
-
-	TextureMap.emplace("GrayGranite_Roughness", std::make_shared<TTexture2D>("GrayGranite_Roughness", false, TextureDir + L"gray-granite-flecks-Roughness.png"));
-
-	TextureMap.emplace("Helmet_BaseColor", std::make_shared<TTexture2D>("Helmet_BaseColor", true, TextureDir + L"helmet_low_DefaultMaterial_BaseColor.png"));
-
-	TextureMap.emplace("Helmet_Normal", std::make_shared<TTexture2D>("Helmet_Normal", false, TextureDir + L"helmet_low_DefaultMaterial_Normal.png"));
-
-	TextureMap.emplace("Helmet_Metallic", std::make_shared<TTexture2D>("Helmet_Metallic", false, TextureDir + L"helmet_low_DefaultMaterial_Metallic.png"));
-
-	TextureMap.emplace("Helmet_Roughness", std::make_shared<TTexture2D>("Helmet_Roughness", false, TextureDir + L"helmet_low_DefaultMaterial_Roughness.png"));
-
-	TextureMap.emplace("Floor_BaseColor", std::make_shared<TTexture2D>("Floor_BaseColor", true, TextureDir + L"hardwood-brown-planks-albedo.png"));
-
-	TextureMap.emplace("Floor_Normal", std::make_shared<TTexture2D>("Floor_Normal", false, TextureDir + L"hardwood-brown-planks-normal-dx.png"));
-
-	TextureMap.emplace("Floor_Metallic", std::make_shared<TTexture2D>("Floor_Metallic", false, TextureDir + L"hardwood-brown-planks-metallic.png"));
-
-	TextureMap.emplace("Floor_Roughness", std::make_shared<TTexture2D>("Floor_Roughness", false, TextureDir + L"hardwood-brown-planks-roughness.png"));
-
-	TextureMap.emplace("Column_BaseColor", std::make_shared<TTexture2D>("Column_BaseColor", true, TextureDir + L"column_albedo.jpg"));
+	for (const TTextureAsset& Asset : GetTextureAssets())
+	{
+		// Block compressed DDS from the asset cooker, as long as it was cooked from the current source
+		std::wstring FilePath = TextureDir + Asset.FileName;
+		std::wstring CookedPath = GetCookedTexturePath(Asset.TextureName);
+		if (bUseCookedTextures && IsCookedTextureUpToDate(FilePath, CookedPath))
+		{
+			FilePath = CookedPath;
+		}
+
+		auto Texture = std::make_shared<TTexture2D>(Asset.TextureName, Asset.bSRGB, FilePath);
+		Texture->bGenerateMips = Asset.bGenerateMips;
+
+		TextureMap.emplace(Asset.TextureName, Texture);
+	}
+}
 
-	TextureMap.emplace("Column_Normal", std::make_shared<TTexture2D>("Column_Normal", false, TextureDir + L"column_normal.png"));
+void TTextureRepository::Unload()
+{
+	TextureMap.clear();
+}
 
-	TextureMap.emplace("Column_Roughness", std::make_shared<TTexture2D>("Column_Roughness", false, TextureDir + L"column_roughness.jpg"));
+void TTextureRepository::LoadTextureResources(TD3D12RHI* D3D12RHI)
+{
+	std::vector<TTexture*> DecodeTextures;
+	std::vector<std::string> DecodeFilePaths;
+
+	for (const auto& TexturePair : TextureMap)
+	{
+		TTexture* Texture = TexturePair.second.get();
+		std::string FilePath = TFormatConvert::WStrToStr(Texture->FilePath);
+
+		EImageFileType FileType = GetImageFileType(FilePath);
+		if (FileType == EImageFileType::PNG || FileType == EImageFileType::JPG || FileType == EImageFileType::HDR)
+		{
+			DecodeTextures.push_back(Texture);
+			DecodeFilePaths.push_back(FilePath);
+		}
+		else
+		{
+			// DDS is uploaded as stored, there is nothing to decode on the pool. The DDS loader reads through Win32 and
+			// updates the texture memory stats, which are not thread safe, so these stay on this thread.
+			Texture->LoadTextureResourceFromFlie(D3D12RHI);
+		}
+	}
+
+	TTextureDecodePipeline DecodePipeline(TThreadPool::Get());
+
+	std::vector<TTextureDecodeResult> Results;
+	DecodePipeline.DecodeFiles(DecodeFilePaths, Results);
+
+	for (size_t i = 0; i < DecodeTextures.size(); i++)
+	{
+		if (Results[i].bSuccess)
+		{
+			TTexture* Texture = DecodeTextures[i];
+			TDecodedImage& Image = Results[i].Image;
+
+			THDRPackStats PackStats;
+			if (PrepareDecodedImage(*Texture, Image, &PackStats))
+			{
+				std::string Message = "HDR texture " + Texture->Name + " packed to " + PackStats.ToString() + "\n";
+				TLogger::LogToOutput(Message.data());
+			}
+
+			Texture->SetTextureResourceFromDecodedImage(Image);
+		}
+		else
+		{
+			// Unsupported variant, fall back to the platform loader
+			DecodeTextures[i]->LoadTextureResourceFromFlie(D3D12RHI);
+		}
+	}
+
+	std::string Report = DecodePipeline.GetStats().ToString();
+	TLogger::LogToOutput(Report.data());
+}
 
-	// LUT
-	TextureMap.emplace("IBL_BRDF_LUT", std::make_shared<TTexture2D>("IBL_BRDF_LUT", false, TextureDir + L"IBL_BRDF_LUT.png"));
+bool TTextureRepository::ReloadTextureResource(const TTexture& Texture, TTextureResource& OutResource) const
+{
+	std::string FilePath = TFormatConvert::WStrToStr(Texture.FilePath);
+
+	EImageFileType FileType = GetImageFileType(FilePath);
+	if (FileType != EImageFileType::PNG && FileType != EImageFileType::JPG && FileType != EImageFileType::HDR)
+	{
+		return SUCCEEDED(DirectX::CreateDDSTextureFromFile(Texture.FilePath.c_str(), OutResource.TextureInfo,
+			OutResource.InitData, OutResource.TextureData, Texture.bSRGB));
+	}
+
+	std::vector<uint8_t> FileData;
+	TDecodedImage Image;
+	if (!TTextureDecodePipeline::ReadFile(FilePath, TTextureDecodeSettings().ReadChunkSize, FileData)
+		|| !DecodeImageFromMemory(FileData.data(), FileData.size(), FileType, Image))
+	{
+		return false;
+	}
+
+	PrepareDecodedImage(Texture, Image, nullptr);
+	TTexture::FillTextureResource(Image, Texture.bSRGB, OutResource);
+
+	return true;
+}
 
-	// HDR
-	TextureMap.emplace("Newport_Loft", std::make_shared<TTexture2D>("Newport_Loft", false, TextureDir + L"Newport_Loft_Ref.hdr"));
+bool TTextureRepository::PrepareDecodedImage(const TTexture& Texture, TDecodedImage& Image, THDRPackStats* OutPackStats) const
+{
+	if (Texture.bGenerateMips)
+	{
+		TMipGenSettings MipSettings;
+		MipSettings.bSRGB = Texture.bSRGB;
+		MipSettings.bNormalMap = IsNormalMap(Texture.Name);
 
-	TextureMap.emplace("Shiodome_Stairs", std::make_shared<TTexture2D>("Shiodome_Stairs", false, TextureDir + L"10-Shiodome_Stairs_3k.hdr"));
+		// Material textures tile, environment maps are filtered with clamp
+		MipSettings.bWrap = (Image.Format != EDecodedImageFormat::RGB32F);
 
-	// AreaLight(LTC)
-	TextureMap.emplace("LtcMat_1", std::make_shared<TTexture2D>("LtcMat_1", false, TextureDir + L"ltc_1.dds"));
+		GenerateMips(Image, MipSettings, TThreadPool::Get());
+	}
 
-	TextureMap.emplace("LtcMat_2", std::make_shared<TTexture2D>("LtcMat_2", false, TextureDir + L"ltc_2.dds"));
+	// Mips are filtered from the float texels, then every level is packed to 4 bytes per texel
+	if (Image.Format == EDecodedImageFormat::RGB32F && HDRTextureFormat != EDecodedImageFormat::RGB32F)
+	{
+		return PackHDRImage(Image, HDRTextureFormat, TThreadPool::Get(), OutPackStats);
+	}
 
-	// Noise
-	TextureMap.emplace("BlueNoiseTex", std::make_shared<TTexture2D>("BlueNoiseTex", false, TextureDir + L"BlueNoise.png"));
+	return false;
 }
-
-void TTextureRepository::Unload()
-{
-	TextureMap.clear();
-}
\ No newline at end of file
@@ -3,7 +3,10 @@
 #include <unordered_map>
 #include <string>
 #include <memory>
+#include <vector>
 #include "Texture.h"
+#include "TextureAssets.h"
+#include "TextureLoader/HDRPacking.h"
 
 class TTextureRepository
 {
@@ -14,6 +17,23 @@ public:
 
 	void Unload();
 
+	// Read and decode all texture files, PNG/JPG/HDR in parallel
+	void LoadTextureResources(TD3D12RHI* D3D12RHI);
+
+	// Read the file of a streamed texture again, with the same mips and packing as LoadTextureResources.
+	// Leaves the texture untouched, so it can run on a worker thread.
+	bool ReloadTextureResource(const TTexture& Texture, TTextureResource& OutResource) const;
+
+private:
+	// Generate mips and pack HDR texels, returns true if the image was packed
+	bool PrepareDecodedImage(const TTexture& Texture, TDecodedImage& Image, THDRPackStats* OutPackStats) const;
+
 public:
+	// Load the cooked DDS of a texture instead of its source when it is up to date
+	bool bUseCookedTextures = true;
+
+	// Uncooked HDR textures are packed to R9G9B9E5 or R11G11B10, RGB32F keeps 12 bytes per texel
+	EDecodedImageFormat HDRTextureFormat = EDecodedImageFormat::R9G9B9E5;
+
 	std::unordered_map<std::string /*TextureName*/, std::shared_ptr<TTexture>> TextureMap;
 };
@@ -0,0 +1,253 @@
+#include "TextureStreaming.h"
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+TTextureStreamingManager::TTextureStreamingManager(const TTextureStreamingSettings& InSettings)
+	:Settings(InSettings)
+{
+}
+
+uint32_t TTextureStreamingManager::RegisterTexture(const TStreamingTextureDesc& Desc)
+{
+	assert(!Desc.MipSizes.empty());
+
+	TStreamingTexture Texture;
+	Texture.Desc = Desc;
+	Texture.MipCount = (uint32_t)Desc.MipSizes.size();
+
+	// Tail starts at the first mip small enough, the last mip at least
+	Texture.TailMip = Texture.MipCount - 1;
+	for (uint32_t Mip = 0; Mip < Texture.MipCount; Mip++)
+	{
+		uint32_t MipSize = std::max(Desc.Width >> Mip, Desc.Height >> Mip);
+		if (MipSize <= Settings.TailMipSize)
+		{
+			Texture.TailMip = Mip;
+			break;
+		}
+	}
+
+	Texture.ResidentMip = Texture.MipCount;
+	Texture.RequestedMip = Texture.MipCount;
+	Texture.WantedMip = Texture.TailMip;
+
+	Textures.push_back(Texture);
+
+	return (uint32_t)Textures.size() - 1;
+}
+
+void TTextureStreamingManager::BeginFrame()
+{
+	FrameIndex++;
+
+	for (TStreamingTexture& Texture : Textures)
+	{
+		Texture.WantedMip = Texture.TailMip;
+	}
+}
+
+uint32_t TTextureStreamingManager::ComputeWantedMip(uint32_t Width, uint32_t Height, uint32_t MipCount, float UVDensity, float PixelsPerWorldUnit)
+{
+	if (PixelsPerWorldUnit <= 0.0f || MipCount == 0)
+	{
+		return MipCount > 0 ? MipCount - 1 : 0;
+	}
+
+	// Texels of mip 0 covering one pixel on screen, each mip halves it
+	float TexelsPerPixel = (float)std::max(Width, Height) * UVDensity / PixelsPerWorldUnit;
+	if (TexelsPerPixel <= 1.0f)
+	{
+		return 0;
+	}
+
+	uint32_t Mip = (uint32_t)std::floor(std::log2(TexelsPerPixel));
+
+	return std::min(Mip, MipCount - 1);
+}
+
+void TTextureStreamingManager::ReportFootprint(uint32_t TextureId, float UVDensity, float PixelsPerWorldUnit)
+{
+	TStreamingTexture& Texture = Textures[TextureId];
+
+	uint32_t Mip = ComputeWantedMip(Texture.Desc.Width, Texture.Desc.Height, Texture.MipCount, UVDensity, PixelsPerWorldUnit);
+
+	Texture.WantedMip = std::min(Texture.WantedMip, Mip);
+	Texture.LastUsedFrame = FrameIndex;
+}
+
+uint64_t TTextureStreamingManager::GetMipChainSize(const TStreamingTexture& Texture, uint32_t FirstMip) const
+{
+	uint64_t Size = 0;
+	for (uint32_t Mip = FirstMip; Mip < Texture.MipCount; Mip++)
+	{
+		Size += Texture.Desc.MipSizes[Mip];
+	}
+
+	return Size;
+}
+
+uint64_t TTextureStreamingManager::GetAllocatedSize(const TStreamingTexture& Texture) const
+{
+	return GetMipChainSize(Texture, Texture.RequestedMip);
+}
+
+void TTextureStreamingManager::Update(std::vector<TTextureStreamingRequest>& OutRequests)
+{
+	// Candidates: idle textures that want more than they have.
+	// Missing tails first, then the largest gap between wanted and resident mip
+	std::vector<uint32_t> Candidates;
+	for (uint32_t Id = 0; Id < (uint32_t)Textures.size(); Id++)
+	{
+		const TStreamingTexture& Texture = Textures[Id];
+		if (!IsPending(Texture) && Texture.WantedMip < Texture.ResidentMip)
+		{
+			Candidates.push_back(Id);
+		}
+	}
+
+	std::stable_sort(Candidates.begin(), Candidates.end(), [this](uint32_t A, uint32_t B)
+	{
+		const TStreamingTexture& TextureA = Textures[A];
+		const TStreamingTexture& TextureB = Textures[B];
+
+		bool bMissingTailA = TextureA.ResidentMip > TextureA.TailMip;
+		bool bMissingTailB = TextureB.ResidentMip > TextureB.TailMip;
+		if (bMissingTailA != bMissingTailB)
+		{
+			return bMissingTailA;
+		}
+
+		return (TextureA.ResidentMip - TextureA.WantedMip) > (TextureB.ResidentMip - TextureB.WantedMip);
+	});
+
+	uint32_t RequestCount = 0;
+	for (uint32_t Id : Candidates)
+	{
+		if (RequestCount >= Settings.MaxRequestsPerUpdate)
+		{
+			break;
+		}
+
+		TStreamingTexture& Texture = Textures[Id];
+
+		uint32_t TargetMip = Texture.WantedMip;
+
+		// The tail is always granted, higher mips only within budget
+		if (TargetMip < Texture.TailMip)
+		{
+			uint64_t CurrentSize = GetAllocatedSize(Texture);
+			uint64_t TailSize = GetMipChainSize(Texture, Texture.TailMip);
+			uint64_t NeededBytes = GetMipChainSize(Texture, TargetMip) - std::max(CurrentSize, TailSize);
+
+			if (AllocatedBytes + NeededBytes > Settings.PoolBudget)
+			{
+				EvictFor(NeededBytes, Id, OutRequests);
+			}
+
+			// Still short, settle for the largest mip that fits
+			while (TargetMip < Texture.TailMip)
+			{
+				NeededBytes = GetMipChainSize(Texture, TargetMip) - std::max(CurrentSize, TailSize);
+				if (AllocatedBytes + NeededBytes <= Settings.PoolBudget)
+				{
+					break;
+				}
+				TargetMip++;
+			}
+		}
+
+		if (TargetMip >= Texture.ResidentMip)
+		{
+			continue;
+		}
+
+		AllocatedBytes -= GetAllocatedSize(Texture);
+		Texture.RequestedMip = TargetMip;
+		AllocatedBytes += GetAllocatedSize(Texture);
+
+		TTextureStreamingRequest Request;
+		Request.TextureId = Id;
+		Request.FirstMip = TargetMip;
+		OutRequests.push_back(Request);
+
+		RequestCount++;
+		Stats.LoadCount++;
+	}
+
+	// Refresh stats
+	Stats.ResidentBytes = 0;
+	Stats.WantedBytes = 0;
+	Stats.PendingRequests = 0;
+	for (const TStreamingTexture& Texture : Textures)
+	{
+		Stats.ResidentBytes += GetMipChainSize(Texture, Texture.ResidentMip);
+		Stats.WantedBytes += GetMipChainSize(Texture, Texture.WantedMip);
+		Stats.PendingRequests += IsPending(Texture) ? 1 : 0;
+	}
+}
+
+bool TTextureStreamingManager::EvictFor(uint64_t NeededBytes, uint32_t ExcludeTextureId, std::vector<TTextureStreamingRequest>& OutRequests)
+{
+	// Idle textures holding mips above what they want, least recently used first
+	std::vector<uint32_t> Victims;
+	for (uint32_t Id = 0; Id < (uint32_t)Textures.size(); Id++)
+	{
+		const TStreamingTexture& Texture = Textures[Id];
+		if (Id != ExcludeTextureId && !IsPending(Texture) && Texture.ResidentMip < Texture.WantedMip)
+		{
+			Victims.push_back(Id);
+		}
+	}
+
+	std::stable_sort(Victims.begin(), Victims.end(), [this](uint32_t A, uint32_t B)
+	{
+		return Textures[A].LastUsedFrame < Textures[B].LastUsedFrame;
+	});
+
+	for (uint32_t Id : Victims)
+	{
+		if (AllocatedBytes + NeededBytes <= Settings.PoolBudget)
+		{
+			break;
+		}
+
+		TStreamingTexture& Texture = Textures[Id];
+
+		// Charged immediately, the backend drops the mips when it handles the request
+		AllocatedBytes -= GetAllocatedSize(Texture);
+		Texture.RequestedMip = Texture.WantedMip;
+		AllocatedBytes += GetAllocatedSize(Texture);
+
+		TTextureStreamingRequest Request;
+		Request.TextureId = Id;
+		Request.FirstMip = Texture.WantedMip;
+		OutRequests.push_back(Request);
+
+		Stats.EvictionCount++;
+	}
+
+	return AllocatedBytes + NeededBytes <= Settings.PoolBudget;
+}
+
+void TTextureStreamingManager::OnRequestCompleted(uint32_t TextureId, uint32_t FirstMip)
+{
+	TStreamingTexture& Texture = Textures[TextureId];
+	assert(Texture.RequestedMip == FirstMip);
+
+	AllocatedBytes -= GetAllocatedSize(Texture);
+	Texture.ResidentMip = FirstMip;
+	AllocatedBytes += GetAllocatedSize(Texture);
+}
+
+void TTextureStreamingManager::OnRequestFailed(uint32_t TextureId)
+{
+	TStreamingTexture& Texture = Textures[TextureId];
+	assert(IsPending(Texture));
+
+	AllocatedBytes -= GetAllocatedSize(Texture);
+	Texture.RequestedMip = Texture.ResidentMip;
+	AllocatedBytes += GetAllocatedSize(Texture);
+
+	Stats.FailedCount++;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct TTextureStreamingSettings
+{
+	// VRAM available to streamed textures
+	uint64_t PoolBudget = 256 * 1024 * 1024;
+
+	// Mips no larger than this are the tail, loaded first and never evicted
+	uint32_t TailMipSize = 64;
+
+	uint32_t MaxRequestsPerUpdate = 8;
+};
+
+struct TStreamingTextureDesc
+{
+	uint32_t Width = 0;
+
+	uint32_t Height = 0;
+
+	// Byte size of each mip, mip 0 first
+	std::vector<uint64_t> MipSizes;
+};
+
+// Ask the backend to make mips [FirstMip, MipCount) of a texture resident, both for loads and evictions
+struct TTextureStreamingRequest
+{
+	uint32_t TextureId = 0;
+
+	uint32_t FirstMip = 0;
+};
+
+struct TTextureStreamingStats
+{
+	uint64_t ResidentBytes = 0;
+
+	uint64_t WantedBytes = 0;
+
+	uint32_t PendingRequests = 0;
+
+	uint64_t LoadCount = 0;
+
+	uint64_t EvictionCount = 0;
+
+	uint64_t FailedCount = 0;
+};
+
+// Decides which mips of each streamed texture should be resident.
+// Per-frame screen-space footprints raise a texture's wanted mip, Update turns the difference between wanted
+// and resident mips into requests, evicting least recently used textures down to their tail to stay in budget.
+// Holds no device state, the caller executes requests and reports back with OnRequestCompleted or OnRequestFailed.
+class TTextureStreamingManager
+{
+public:
+	TTextureStreamingManager(const TTextureStreamingSettings& InSettings = TTextureStreamingSettings());
+
+public:
+	uint32_t RegisterTexture(const TStreamingTextureDesc& Desc);
+
+	// Resets wanted mips, call before reporting this frame's footprints
+	void BeginFrame();
+
+	// UVDensity: UV units per world unit of the mesh surface, PixelsPerWorldUnit: projected size at the mesh
+	void ReportFootprint(uint32_t TextureId, float UVDensity, float PixelsPerWorldUnit);
+
+	void Update(std::vector<TTextureStreamingRequest>& OutRequests);
+
+	void OnRequestCompleted(uint32_t TextureId, uint32_t FirstMip);
+
+	// The backend could not load the mips, the texture keeps its resident mips and is requested again by a later Update
+	void OnRequestFailed(uint32_t TextureId);
+
+	uint32_t GetResidentMip(uint32_t TextureId) const { return Textures[TextureId].ResidentMip; }
+
+	uint32_t GetWantedMip(uint32_t TextureId) const { return Textures[TextureId].WantedMip; }
+
+	uint32_t GetTailMip(uint32_t TextureId) const { return Textures[TextureId].TailMip; }
+
+	const TTextureStreamingStats& GetStats() const { return Stats; }
+
+	static uint32_t ComputeWantedMip(uint32_t Width, uint32_t Height, uint32_t MipCount, float UVDensity, float PixelsPerWorldUnit);
+
+private:
+	struct TStreamingTexture
+	{
+		TStreamingTextureDesc Desc;
+
+		uint32_t MipCount = 0;
+
+		uint32_t TailMip = 0;
+
+		// First resident mip, MipCount if nothing is resident yet
+		uint32_t ResidentMip = 0;
+
+		uint32_t WantedMip = 0;
+
+		// First mip of the in-flight request, equal to ResidentMip when idle
+		uint32_t RequestedMip = 0;
+
+		uint64_t LastUsedFrame = 0;
+	};
+
+	uint64_t GetMipChainSize(const TStreamingTexture& Texture, uint32_t FirstMip) const;
+
+	// Memory charged to a texture, pending requests are counted at their target size
+	uint64_t GetAllocatedSize(const TStreamingTexture& Texture) const;
+
+	bool IsPending(const TStreamingTexture& Texture) const { return Texture.RequestedMip != Texture.ResidentMip; }
+
+	bool EvictFor(uint64_t NeededBytes, uint32_t ExcludeTextureId, std::vector<TTextureStreamingRequest>& OutRequests);
+
+private:
+	TTextureStreamingSettings Settings;
+
+	std::vector<TStreamingTexture> Textures;
+
+	uint64_t AllocatedBytes = 0;
+
+	uint64_t FrameIndex = 0;
+
+	TTextureStreamingStats Stats;
+};
@@ -0,0 +1,314 @@
+#include "TextureStreaming.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <random>
+
+// Linux simulation of TTextureStreamingManager: a backend that completes requests in order after a few frames,
+// a static view that fits the budget, a moving camera that does not and a request the backend fails. Returns the number
+// of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	TStreamingTextureDesc MakeDesc(uint32_t Size)
+	{
+		TStreamingTextureDesc Desc;
+		Desc.Width = Size;
+		Desc.Height = Size;
+		for (uint32_t MipSize = Size; MipSize > 0; MipSize >>= 1)
+		{
+			Desc.MipSizes.push_back((uint64_t)MipSize * MipSize * 4);
+		}
+
+		return Desc;
+	}
+
+	uint64_t GetChainSize(const TStreamingTextureDesc& Desc, uint32_t FirstMip)
+	{
+		uint64_t Size = 0;
+		for (uint32_t Mip = FirstMip; Mip < (uint32_t)Desc.MipSizes.size(); Mip++)
+		{
+			Size += Desc.MipSizes[Mip];
+		}
+
+		return Size;
+	}
+
+	uint32_t GetTailMip(const TStreamingTextureDesc& Desc, uint32_t TailMipSize)
+	{
+		for (uint32_t Mip = 0; Mip < (uint32_t)Desc.MipSizes.size(); Mip++)
+		{
+			if (std::max(Desc.Width >> Mip, Desc.Height >> Mip) <= TailMipSize)
+			{
+				return Mip;
+			}
+		}
+
+		return (uint32_t)Desc.MipSizes.size() - 1;
+	}
+
+	// Requests complete in issue order after Latency updates, like a copy queue
+	class TStreamingBackend
+	{
+	public:
+		TStreamingBackend(TTextureStreamingManager& InManager, const std::vector<TStreamingTextureDesc>& InDescs, uint32_t InLatency)
+			:Manager(InManager), Descs(InDescs), Latency(InLatency), ResidentMips(InDescs.size())
+		{
+			for (size_t Id = 0; Id < Descs.size(); Id++)
+			{
+				ResidentMips[Id] = (uint32_t)Descs[Id].MipSizes.size();
+			}
+		}
+
+		void Submit(const std::vector<TTextureStreamingRequest>& Requests, uint64_t Frame)
+		{
+			for (const TTextureStreamingRequest& Request : Requests)
+			{
+				InFlight.push_back({ Request, Frame + Latency });
+			}
+		}
+
+		// Completes due requests, returns the largest resident size seen after a completion
+		uint64_t Tick(uint64_t Frame)
+		{
+			uint64_t PeakBytes = GetResidentBytes();
+			while (!InFlight.empty() && InFlight.front().DoneFrame <= Frame)
+			{
+				const TTextureStreamingRequest Request = InFlight.front().Request;
+				InFlight.pop_front();
+
+				ResidentMips[Request.TextureId] = Request.FirstMip;
+				Manager.OnRequestCompleted(Request.TextureId, Request.FirstMip);
+
+				PeakBytes = std::max<uint64_t>(PeakBytes, GetResidentBytes());
+			}
+
+			return PeakBytes;
+		}
+
+		uint64_t GetResidentBytes() const
+		{
+			uint64_t Bytes = 0;
+			for (size_t Id = 0; Id < Descs.size(); Id++)
+			{
+				Bytes += GetChainSize(Descs[Id], ResidentMips[Id]);
+			}
+
+			return Bytes;
+		}
+
+		uint32_t GetResidentMip(uint32_t Id) const { return ResidentMips[Id]; }
+
+		bool IsIdle() const { return InFlight.empty(); }
+
+	private:
+		struct TInFlightRequest
+		{
+			TTextureStreamingRequest Request;
+
+			uint64_t DoneFrame = 0;
+		};
+
+		TTextureStreamingManager& Manager;
+
+		const std::vector<TStreamingTextureDesc>& Descs;
+
+		uint32_t Latency = 0;
+
+		std::vector<uint32_t> ResidentMips;
+
+		std::deque<TInFlightRequest> InFlight;
+	};
+
+	void TestWantedMip()
+	{
+		// 2048 texels over one world unit
+		Check(TTextureStreamingManager::ComputeWantedMip(2048, 2048, 12, 1.0f, 4096.0f) == 0, "magnified texture wants mip 0");
+		Check(TTextureStreamingManager::ComputeWantedMip(2048, 2048, 12, 1.0f, 2048.0f) == 0, "one texel per pixel wants mip 0");
+		Check(TTextureStreamingManager::ComputeWantedMip(2048, 2048, 12, 1.0f, 1024.0f) == 1, "two texels per pixel want mip 1");
+		Check(TTextureStreamingManager::ComputeWantedMip(2048, 2048, 12, 4.0f, 1024.0f) == 3, "tiling UVs raise the mip");
+		Check(TTextureStreamingManager::ComputeWantedMip(2048, 1024, 12, 1.0f, 1.0f) == 11, "distant texture clamps to the last mip");
+		Check(TTextureStreamingManager::ComputeWantedMip(2048, 2048, 12, 1.0f, 0.0f) == 11, "invisible texture wants the last mip");
+	}
+
+	// Every texture seen at a fixed distance, the wanted mips fit the budget
+	void TestStaticView()
+	{
+		TTextureStreamingSettings Settings;
+		Settings.PoolBudget = 64ull * 1024 * 1024;
+		Settings.MaxRequestsPerUpdate = 4;
+
+		std::vector<TStreamingTextureDesc> Descs;
+		for (uint32_t i = 0; i < 24; i++)
+		{
+			Descs.push_back(MakeDesc(1024u << (i % 2)));
+		}
+
+		TTextureStreamingManager Manager(Settings);
+		for (const TStreamingTextureDesc& Desc : Descs)
+		{
+			Manager.RegisterTexture(Desc);
+		}
+
+		TStreamingBackend Backend(Manager, Descs, 2);
+
+		uint32_t ConvergedFrame = 0;
+		for (uint64_t Frame = 1; Frame <= 200 && ConvergedFrame == 0; Frame++)
+		{
+			Manager.BeginFrame();
+			for (uint32_t Id = 0; Id < (uint32_t)Descs.size(); Id++)
+			{
+				// 256 pixels per world unit at UV density 1: mip 2 or 3
+				Manager.ReportFootprint(Id, 1.0f, 256.0f);
+			}
+
+			std::vector<TTextureStreamingRequest> Requests;
+			Manager.Update(Requests);
+			Check(Requests.size() <= Settings.MaxRequestsPerUpdate, "static view: requests per update are capped");
+			Backend.Submit(Requests, Frame);
+			Check(Backend.Tick(Frame) <= Settings.PoolBudget, "static view: resident mips stay within the budget");
+
+			bool bConverged = Backend.IsIdle();
+			for (uint32_t Id = 0; Id < (uint32_t)Descs.size() && bConverged; Id++)
+			{
+				bConverged = Manager.GetResidentMip(Id) == Manager.GetWantedMip(Id);
+			}
+
+			ConvergedFrame = bConverged ? (uint32_t)Frame : 0;
+		}
+
+		printf("Static view: %zu textures resident at their wanted mip after %u frames, %llu loads, %llu evictions\n",
+			Descs.size(), ConvergedFrame, (unsigned long long)Manager.GetStats().LoadCount, (unsigned long long)Manager.GetStats().EvictionCount);
+
+		Check(ConvergedFrame > 0, "static view: every texture reaches its wanted mip");
+		Check(Manager.GetStats().EvictionCount == 0, "static view: nothing is evicted while in budget");
+	}
+
+	// Camera moving along a row of textures, only the nearby ones are seen and they need more than the budget
+	void TestMovingCamera()
+	{
+		TTextureStreamingSettings Settings;
+		Settings.PoolBudget = 48ull * 1024 * 1024;
+		Settings.MaxRequestsPerUpdate = 8;
+
+		std::vector<TStreamingTextureDesc> Descs;
+		for (uint32_t i = 0; i < 64; i++)
+		{
+			Descs.push_back(MakeDesc(2048));
+		}
+
+		TTextureStreamingManager Manager(Settings);
+		for (const TStreamingTextureDesc& Desc : Descs)
+		{
+			Manager.RegisterTexture(Desc);
+		}
+
+		TStreamingBackend Backend(Manager, Descs, 3);
+
+		// Tails are granted without a budget check, so they may sit on top of a full pool
+		uint64_t TailBytes = 0;
+		for (const TStreamingTextureDesc& Desc : Descs)
+		{
+			TailBytes += GetChainSize(Desc, GetTailMip(Desc, Settings.TailMipSize));
+		}
+
+		std::mt19937 Random(7);
+		std::uniform_real_distribution<float> Jitter(0.8f, 1.25f);
+
+		uint64_t PeakBytes = 0;
+		uint64_t WantedPeakBytes = 0;
+		bool bTailEvicted = false;
+		for (uint64_t Frame = 1; Frame <= 600; Frame++)
+		{
+			const float CameraX = (float)Frame * 0.1f;
+
+			Manager.BeginFrame();
+			for (uint32_t Id = 0; Id < (uint32_t)Descs.size(); Id++)
+			{
+				const float Distance = std::abs((float)Id - CameraX) + 0.5f;
+				if (Distance < 8.0f)
+				{
+					Manager.ReportFootprint(Id, 1.0f, 2048.0f / Distance * Jitter(Random));
+				}
+			}
+
+			std::vector<TTextureStreamingRequest> Requests;
+			Manager.Update(Requests);
+			Backend.Submit(Requests, Frame);
+			PeakBytes = std::max<uint64_t>(PeakBytes, Backend.Tick(Frame));
+			WantedPeakBytes = std::max<uint64_t>(WantedPeakBytes, Manager.GetStats().WantedBytes);
+
+			for (uint32_t Id = 0; Id < (uint32_t)Descs.size(); Id++)
+			{
+				const uint32_t TailMip = GetTailMip(Descs[Id], Settings.TailMipSize);
+				bTailEvicted |= Frame > 64 && Backend.GetResidentMip(Id) > TailMip;
+			}
+		}
+
+		printf("Moving camera: peak resident %.1f MB of %.1f MB budget and %.1f MB of tails, peak wanted %.1f MB, %llu loads, %llu evictions\n",
+			PeakBytes / 1048576.0, Settings.PoolBudget / 1048576.0, TailBytes / 1048576.0, WantedPeakBytes / 1048576.0,
+			(unsigned long long)Manager.GetStats().LoadCount, (unsigned long long)Manager.GetStats().EvictionCount);
+
+		Check(WantedPeakBytes > Settings.PoolBudget, "moving camera: the view wants more than the budget");
+		Check(PeakBytes <= Settings.PoolBudget + TailBytes, "moving camera: resident mips stay within the budget and the tails");
+		Check(!bTailEvicted, "moving camera: tails stay resident once loaded");
+		Check(Manager.GetStats().EvictionCount > 0, "moving camera: textures left behind are evicted");
+	}
+
+	// A backend that cannot read the mips back, the budget holds exactly one full chain
+	void TestFailedRequest()
+	{
+		const TStreamingTextureDesc Desc = MakeDesc(1024);
+		const uint32_t MipCount = (uint32_t)Desc.MipSizes.size();
+
+		TTextureStreamingSettings Settings;
+		Settings.PoolBudget = GetChainSize(Desc, 0);
+
+		TTextureStreamingManager Manager(Settings);
+		const uint32_t Id = Manager.RegisterTexture(Desc);
+		Check(Manager.GetTailMip(Id) == GetTailMip(Desc, Settings.TailMipSize), "failed request: the tail mip is exposed to the backend");
+
+		std::vector<TTextureStreamingRequest> Requests;
+		Manager.BeginFrame();
+		Manager.ReportFootprint(Id, 1.0f, 4096.0f);
+		Manager.Update(Requests);
+		Check(Requests.size() == 1 && Requests[0].FirstMip == 0, "failed request: the full chain is requested");
+
+		Manager.OnRequestFailed(Id);
+		Check(Manager.GetResidentMip(Id) == MipCount && Manager.GetStats().FailedCount == 1, "failed request: nothing becomes resident");
+
+		// The failed request no longer holds the budget, so the full chain is requested again
+		Requests.clear();
+		Manager.BeginFrame();
+		Manager.ReportFootprint(Id, 1.0f, 4096.0f);
+		Manager.Update(Requests);
+		Check(Requests.size() == 1 && Requests[0].FirstMip == 0, "failed request: the texture is requested again");
+		Check(Manager.GetStats().PendingRequests == 1, "failed request: only the new request is pending");
+
+		Manager.OnRequestCompleted(Id, 0);
+		Check(Manager.GetResidentMip(Id) == 0, "failed request: the retry becomes resident");
+	}
+}
+
+int main()
+{
+	TestWantedMip();
+	TestStaticView();
+	TestMovingCamera();
+	TestFailedRequest();
+
+	printf("%s\n", FailureCount == 0 ? "All texture streaming checks passed" : "Texture streaming checks FAILED");
+
+	return FailureCount;
+}
@@ -0,0 +1,187 @@
+#include "TextureUploadQueue.h"
+#include <cassert>
+
+TStagingRing::TStagingRing(uint64_t InCapacity)
+	:Capacity(InCapacity)
+{
+}
+
+bool TStagingRing::Allocate(uint64_t Size, uint64_t Alignment, uint64_t& OutOffset)
+{
+	if (Size > Capacity)
+	{
+		return false;
+	}
+
+	// Empty ring, restart at physical offset 0 so any request up to Capacity fits
+	if (Head == Tail)
+	{
+		Head = Tail = (Head + Capacity - 1) / Capacity * Capacity;
+	}
+
+	uint64_t PhysicalHead = Head % Capacity;
+	uint64_t AlignedOffset = (PhysicalHead + Alignment - 1) / Alignment * Alignment;
+
+	// Not enough room before the end of the ring, skip the tail gap and start from 0
+	uint64_t Start;
+	if (AlignedOffset + Size > Capacity)
+	{
+		Start = Head + (Capacity - PhysicalHead);
+		AlignedOffset = 0;
+	}
+	else
+	{
+		Start = Head + (AlignedOffset - PhysicalHead);
+	}
+
+	uint64_t NewHead = Start + Size;
+	if (NewHead - Tail > Capacity)
+	{
+		return false;
+	}
+
+	Head = NewHead;
+	OutOffset = AlignedOffset;
+
+	return true;
+}
+
+void TStagingRing::FreeUpTo(uint64_t End)
+{
+	assert(End >= Tail && End <= Head);
+
+	Tail = End;
+}
+
+
+TTextureUploadQueue::TTextureUploadQueue(TRHICopyQueue* InCopyQueue, const TTextureUploadSettings& InSettings)
+	:CopyQueue(InCopyQueue), Settings(InSettings), StagingRing(InCopyQueue->GetStagingRingSize())
+{
+}
+
+TTextureUploadQueue::~TTextureUploadQueue()
+{
+	Flush();
+}
+
+uint64_t TTextureUploadQueue::Enqueue(uint64_t Size, uint64_t Alignment, TUploadCallback OnComplete)
+{
+	TUploadRequest Request;
+	Request.Id = NextRequestId++;
+	Request.Size = Size;
+	Request.Alignment = Alignment;
+	Request.OnComplete = OnComplete;
+
+	PendingRequests.push_back(Request);
+
+	Stats.PendingCount++;
+	Stats.PendingBytes += Size;
+
+	return Request.Id;
+}
+
+void TTextureUploadQueue::Tick()
+{
+	RetireCompletedSubmissions();
+
+	SubmitPendingRequests();
+}
+
+void TTextureUploadQueue::Flush()
+{
+	while (!IsIdle())
+	{
+		SubmitPendingRequests();
+
+		if (!InFlightSubmissions.empty())
+		{
+			CopyQueue->WaitForFenceValue(InFlightSubmissions.front().FenceValue);
+
+			RetireCompletedSubmissions();
+		}
+	}
+}
+
+void TTextureUploadQueue::RetireCompletedSubmissions()
+{
+	if (InFlightSubmissions.empty())
+	{
+		return;
+	}
+
+	uint64_t CompletedFenceValue = CopyQueue->GetCompletedFenceValue();
+
+	while (!InFlightSubmissions.empty() && InFlightSubmissions.front().FenceValue <= CompletedFenceValue)
+	{
+		RetireSubmission();
+	}
+}
+
+void TTextureUploadQueue::RetireSubmission()
+{
+	// Move out first, callbacks may enqueue new requests
+	TUploadSubmission Submission = std::move(InFlightSubmissions.front());
+	InFlightSubmissions.pop_front();
+
+	StagingRing.FreeUpTo(Submission.RingEnd);
+
+	Stats.InFlightCount -= (uint32_t)Submission.Callbacks.size();
+	Stats.CompletedCount += Submission.Callbacks.size();
+
+	for (auto& Callback : Submission.Callbacks)
+	{
+		if (Callback)
+		{
+			Callback();
+		}
+	}
+}
+
+void TTextureUploadQueue::SubmitPendingRequests()
+{
+	TUploadSubmission Submission;
+
+	uint64_t FrameBytes = 0;
+
+	while (!PendingRequests.empty() && Submission.Callbacks.size() < Settings.MaxUploadsPerFrame)
+	{
+		TUploadRequest& Request = PendingRequests.front();
+
+		// Always let one request through so a texture bigger than the budget still makes progress
+		if (FrameBytes > 0 && FrameBytes + Request.Size > Settings.MaxBytesPerFrame)
+		{
+			break;
+		}
+
+		uint64_t StagingOffset = 0;
+		if (Request.Size > StagingRing.GetCapacity())
+		{
+			StagingOffset = TRHICopyQueue::DedicatedStagingOffset;
+		}
+		else if (!StagingRing.Allocate(Request.Size, Request.Alignment, StagingOffset))
+		{
+			// Ring is full, wait for in-flight submissions to retire
+			break;
+		}
+
+		CopyQueue->RecordUpload(Request.Id, StagingOffset);
+
+		FrameBytes += Request.Size;
+		Submission.Callbacks.push_back(std::move(Request.OnComplete));
+
+		Stats.PendingCount--;
+		Stats.PendingBytes -= Request.Size;
+		Stats.InFlightCount++;
+		Stats.UploadedBytes += Request.Size;
+
+		PendingRequests.pop_front();
+	}
+
+	if (!Submission.Callbacks.empty())
+	{
+		Submission.FenceValue = CopyQueue->Submit();
+		Submission.RingEnd = StagingRing.GetHead();
+
+		InFlightSubmissions.push_back(std::move(Submission));
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "RHI/RHI.h"
+#include <deque>
+#include <vector>
+#include <functional>
+
+// Ring allocator over the copy queue's staging memory.
+// Offsets handed out are physical, Head/Tail are monotonic so a submission only needs to remember its end.
+class TStagingRing
+{
+public:
+	TStagingRing(uint64_t InCapacity);
+
+	bool Allocate(uint64_t Size, uint64_t Alignment, uint64_t& OutOffset);
+
+	// Release every allocation made before the ring head reached End
+	void FreeUpTo(uint64_t End);
+
+	uint64_t GetHead() const { return Head; }
+
+	uint64_t GetCapacity() const { return Capacity; }
+
+	uint64_t GetUsedSize() const { return Head - Tail; }
+
+private:
+	uint64_t Capacity = 0;
+
+	uint64_t Head = 0;
+
+	uint64_t Tail = 0;
+};
+
+typedef std::function<void()> TUploadCallback;
+
+struct TTextureUploadSettings
+{
+	// Bytes moved to the copy queue per Tick, keeps a level load from saturating the bus in one frame
+	uint64_t MaxBytesPerFrame = 32 * 1024 * 1024;
+
+	uint32_t MaxUploadsPerFrame = 16;
+};
+
+struct TTextureUploadStats
+{
+	uint32_t PendingCount = 0;
+
+	uint32_t InFlightCount = 0;
+
+	uint64_t CompletedCount = 0;
+
+	uint64_t PendingBytes = 0;
+
+	uint64_t UploadedBytes = 0;
+};
+
+// Platform-neutral streaming upload service.
+// Requests wait in FIFO order, each Tick moves as many as the budget and staging ring allow to the copy queue,
+// completion callbacks run on the thread calling Tick once the submission's fence has passed.
+class TTextureUploadQueue
+{
+public:
+	TTextureUploadQueue(TRHICopyQueue* InCopyQueue, const TTextureUploadSettings& InSettings = TTextureUploadSettings());
+
+	~TTextureUploadQueue();
+
+	TTextureUploadQueue(const TTextureUploadQueue& Other) = delete;
+
+	TTextureUploadQueue& operator=(const TTextureUploadQueue& Other) = delete;
+
+public:
+	// Returns request id, the copy queue uses it to find the data to upload
+	uint64_t Enqueue(uint64_t Size, uint64_t Alignment, TUploadCallback OnComplete);
+
+	void Tick();
+
+	// Block until every enqueued upload has completed
+	void Flush();
+
+	bool IsIdle() const { return PendingRequests.empty() && InFlightSubmissions.empty(); }
+
+	const TTextureUploadStats& GetStats() const { return Stats; }
+
+private:
+	void RetireCompletedSubmissions();
+
+	void SubmitPendingRequests();
+
+	void RetireSubmission();
+
+private:
+	struct TUploadRequest
+	{
+		uint64_t Id = 0;
+
+		uint64_t Size = 0;
+
+		uint64_t Alignment = 0;
+
+		TUploadCallback OnComplete;
+	};
+
+	struct TUploadSubmission
+	{
+		uint64_t FenceValue = 0;
+
+		// Ring head after this submission's allocations
+		uint64_t RingEnd = 0;
+
+		std::vector<TUploadCallback> Callbacks;
+	};
+
+	TRHICopyQueue* CopyQueue = nullptr;
+
+	TTextureUploadSettings Settings;
+
+	TStagingRing StagingRing;
+
+	uint64_t NextRequestId = 1;
+
+	std::deque<TUploadRequest> PendingRequests;
+
+	std::deque<TUploadSubmission> InFlightSubmissions;
+
+	TTextureUploadStats Stats;
+};
@@ -0,0 +1,243 @@
+#include "TextureUploadQueue.h"
+#include "RHI/NullCopyQueue.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+
+// Drives TTextureUploadQueue with TNullCopyQueue, completing fences by hand, and checks budgets, staging ring
+// placement, the dedicated staging path, Flush and callback order. Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	const uint64_t KB = 1024;
+
+	void TestFrameBudgets()
+	{
+		TNullCopyQueue CopyQueue(16 * 1024 * KB);
+
+		TTextureUploadSettings Settings;
+		Settings.MaxBytesPerFrame = 1024 * KB;
+		Settings.MaxUploadsPerFrame = 4;
+
+		TTextureUploadQueue UploadQueue(&CopyQueue, Settings);
+
+		// 300 KB each, three fit the byte budget
+		for (int i = 0; i < 6; i++)
+		{
+			UploadQueue.Enqueue(300 * KB, 256, nullptr);
+		}
+		UploadQueue.Tick();
+		Check(CopyQueue.GetRecordedUploads().size() == 3, "budgets: bytes per frame limit the uploads");
+		Check(UploadQueue.GetStats().PendingCount == 3 && UploadQueue.GetStats().InFlightCount == 3, "budgets: stats split pending and in flight");
+
+		UploadQueue.Tick();
+		Check(CopyQueue.GetRecordedUploads().size() == 3 && CopyQueue.GetSubmitCount() == 2, "budgets: the rest go in the next frame");
+
+		// Small uploads, the count limit applies first
+		for (int i = 0; i < 10; i++)
+		{
+			UploadQueue.Enqueue(1 * KB, 256, nullptr);
+		}
+		UploadQueue.Tick();
+		Check(CopyQueue.GetRecordedUploads().size() == 4, "budgets: uploads per frame limit small requests");
+
+		// A request over the byte budget still goes through on its own
+		UploadQueue.Flush();
+		UploadQueue.Enqueue(3 * 1024 * KB, 256, nullptr);
+		UploadQueue.Enqueue(1 * KB, 256, nullptr);
+		UploadQueue.Tick();
+		Check(CopyQueue.GetRecordedUploads().size() == 1, "budgets: a request larger than the budget is sent alone");
+
+		UploadQueue.Flush();
+		Check(UploadQueue.IsIdle() && UploadQueue.GetStats().PendingBytes == 0, "budgets: flush drains the queue");
+	}
+
+	// Random sizes and alignments through a small ring with completions lagging behind. Every staging range must be
+	// aligned, inside the ring and disjoint from every range still in flight.
+	void TestRingWrapAround()
+	{
+		const uint64_t RingSize = 1024 * KB;
+		TNullCopyQueue CopyQueue(RingSize);
+
+		TTextureUploadSettings Settings;
+		Settings.MaxBytesPerFrame = 512 * KB;
+		Settings.MaxUploadsPerFrame = 8;
+
+		TTextureUploadQueue UploadQueue(&CopyQueue, Settings);
+
+		struct TRange
+		{
+			uint64_t Begin;
+
+			uint64_t End;
+
+			uint64_t FenceValue;
+		};
+
+		struct TRequestInfo
+		{
+			uint64_t Size;
+
+			uint64_t Alignment;
+		};
+
+		std::mt19937 Random(3);
+		std::unordered_map<uint64_t, TRequestInfo> Requests;
+		std::vector<TRange> LiveRanges;
+		uint64_t WrapCount = 0;
+		uint64_t LastOffset = 0;
+		bool bAligned = true;
+		bool bInsideRing = true;
+		bool bDisjoint = true;
+		uint64_t CompletedCount = 0;
+
+		for (int Frame = 0; Frame < 2000; Frame++)
+		{
+			for (int i = Random() % 4; i > 0; i--)
+			{
+				const uint64_t Alignment = 1ull << (4 + Random() % 9);
+				const uint64_t Size = 1 + Random() % (200 * KB);
+				const uint64_t Id = UploadQueue.Enqueue(Size, Alignment, [&CompletedCount]() { CompletedCount++; });
+				Requests[Id] = { Size, Alignment };
+			}
+
+			// The GPU lags one to three submissions behind
+			const uint64_t Lag = 1 + Random() % 3;
+			if (CopyQueue.GetSubmittedFenceValue() > Lag)
+			{
+				CopyQueue.CompleteFenceValue(CopyQueue.GetSubmittedFenceValue() - Lag);
+			}
+			LiveRanges.erase(std::remove_if(LiveRanges.begin(), LiveRanges.end(),
+				[&CopyQueue](const TRange& Range) { return Range.FenceValue <= CopyQueue.GetCompletedFenceValue(); }), LiveRanges.end());
+
+			const uint32_t SubmitCount = CopyQueue.GetSubmitCount();
+			UploadQueue.Tick();
+			if (CopyQueue.GetSubmitCount() == SubmitCount)
+			{
+				continue;
+			}
+
+			for (const auto& Upload : CopyQueue.GetRecordedUploads())
+			{
+				const TRequestInfo& Info = Requests[Upload.first];
+				const TRange Range = { Upload.second, Upload.second + Info.Size, CopyQueue.GetSubmittedFenceValue() };
+
+				bAligned &= Range.Begin % Info.Alignment == 0;
+				bInsideRing &= Range.End <= RingSize;
+				for (const TRange& Live : LiveRanges)
+				{
+					bDisjoint &= Range.End <= Live.Begin || Range.Begin >= Live.End;
+				}
+
+				WrapCount += Range.Begin < LastOffset;
+				LastOffset = Range.Begin;
+				LiveRanges.push_back(Range);
+			}
+		}
+
+		UploadQueue.Flush();
+
+		printf("Ring wrap-around: %zu uploads through a %llu KB ring, wrapped %llu times\n",
+			Requests.size(), (unsigned long long)(RingSize / KB), (unsigned long long)WrapCount);
+
+		Check(WrapCount > 10, "ring: allocations wrap around the end of the ring");
+		Check(bAligned, "ring: staging offsets honour the alignment");
+		Check(bInsideRing, "ring: allocations never run past the end of the ring");
+		Check(bDisjoint, "ring: in flight allocations never overlap");
+		Check(CompletedCount == Requests.size(), "ring: every upload completes");
+	}
+
+	void TestDedicatedStaging()
+	{
+		TNullCopyQueue CopyQueue(256 * KB);
+		TTextureUploadQueue UploadQueue(&CopyQueue);
+
+		UploadQueue.Enqueue(64 * KB, 512, nullptr);
+		UploadQueue.Enqueue(1024 * KB, 512, nullptr);
+		UploadQueue.Enqueue(64 * KB, 512, nullptr);
+		UploadQueue.Tick();
+
+		const auto& Uploads = CopyQueue.GetRecordedUploads();
+		Check(Uploads.size() == 3, "dedicated: an oversized upload does not block the ones around it");
+		if (Uploads.size() == 3)
+		{
+			Check(Uploads[1].second == TRHICopyQueue::DedicatedStagingOffset, "dedicated: uploads larger than the ring use dedicated staging");
+			Check(Uploads[0].second != TRHICopyQueue::DedicatedStagingOffset && Uploads[2].second != TRHICopyQueue::DedicatedStagingOffset,
+				"dedicated: uploads that fit use the ring");
+			Check(Uploads[2].second == 64 * KB, "dedicated: the oversized upload takes no ring space");
+		}
+
+		UploadQueue.Flush();
+	}
+
+	void TestFlushAndCallbackOrder()
+	{
+		TNullCopyQueue CopyQueue(512 * KB);
+
+		TTextureUploadSettings Settings;
+		Settings.MaxBytesPerFrame = 256 * KB;
+		Settings.MaxUploadsPerFrame = 3;
+
+		TTextureUploadQueue UploadQueue(&CopyQueue, Settings);
+
+		std::vector<uint64_t> CompletionOrder;
+		std::vector<uint64_t> EnqueueOrder;
+		for (uint64_t i = 0; i < 40; i++)
+		{
+			const uint64_t Size = (i % 5 == 0) ? 600 * KB : (1 + i) * 3 * KB;
+			EnqueueOrder.push_back(UploadQueue.Enqueue(Size, 256, [&CompletionOrder, i]() { CompletionOrder.push_back(i); }));
+		}
+
+		// A few frames where the GPU never catches up, nothing may complete
+		for (int Frame = 0; Frame < 3; Frame++)
+		{
+			UploadQueue.Tick();
+		}
+		Check(CompletionOrder.empty(), "flush: nothing completes before its fence");
+		Check(UploadQueue.GetStats().InFlightCount > 0, "flush: ticks submit while the GPU is busy");
+
+		// A callback enqueueing more work is picked up by the same Flush
+		bool bChainedCompleted = false;
+		UploadQueue.Enqueue(8 * KB, 256, [&UploadQueue, &bChainedCompleted]()
+		{
+			UploadQueue.Enqueue(8 * KB, 256, [&bChainedCompleted]() { bChainedCompleted = true; });
+		});
+
+		UploadQueue.Flush();
+
+		bool bInOrder = CompletionOrder.size() == EnqueueOrder.size();
+		for (size_t i = 0; bInOrder && i < CompletionOrder.size(); i++)
+		{
+			bInOrder = CompletionOrder[i] == i;
+		}
+
+		Check(bInOrder, "callbacks: fire once each in submission order");
+		Check(bChainedCompleted, "flush: uploads enqueued by callbacks complete too");
+		Check(UploadQueue.IsIdle(), "flush: the queue is idle afterwards");
+		Check(UploadQueue.GetStats().CompletedCount == EnqueueOrder.size() + 2, "flush: completed count covers every upload");
+		Check(UploadQueue.GetStats().InFlightCount == 0 && UploadQueue.GetStats().PendingCount == 0, "flush: nothing pending or in flight");
+	}
+}
+
+int main()
+{
+	TestFrameBudgets();
+	TestRingWrapAround();
+	TestDedicatedStaging();
+	TestFlushAndCallbackOrder();
+
+	printf("%s\n", FailureCount == 0 ? "All texture upload queue checks passed" : "Texture upload queue checks FAILED");
+
+	return FailureCount;
+}
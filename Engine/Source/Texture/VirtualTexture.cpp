@@ -0,0 +1,489 @@
+#include "VirtualTexture.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+	const uint32_t MaxFeedbackTextures = 1 << 10;
+
+	const uint32_t MaxFeedbackMips = 1 << 4;
+
+	const uint32_t MaxFeedbackPages = 1 << 9;
+
+	// Larger gaps don't make a page more urgent
+	const uint32_t MaxPriorityMipGap = 16;
+
+	uint32_t GetEntryMip(uint32_t Entry)
+	{
+		return Entry >> 24;
+	}
+
+	int32_t WrapOrClamp(int32_t Coord, int32_t Size, bool bWrap)
+	{
+		return bWrap ? ((Coord % Size) + Size) % Size : std::clamp<int32_t>(Coord, 0, Size - 1);
+	}
+}
+
+uint32_t PackVirtualFeedback(const TVirtualPage& Page)
+{
+	return Page.TextureId | (Page.Mip << 10) | (Page.X << 14) | (Page.Y << 23);
+}
+
+TVirtualPage UnpackVirtualFeedback(uint32_t Entry)
+{
+	TVirtualPage Page;
+	Page.TextureId = Entry & 0x3FF;
+	Page.Mip = (Entry >> 10) & 0xF;
+	Page.X = (Entry >> 14) & 0x1FF;
+	Page.Y = Entry >> 23;
+
+	return Page;
+}
+
+TVirtualTextureManager::TVirtualTextureManager(const TVirtualTextureSettings& InSettings)
+	:Settings(InSettings)
+{
+	Tiles.resize(Settings.GetPhysicalTileCount());
+
+	FreeTiles.reserve(Tiles.size());
+	for (uint32_t TileIndex = (uint32_t)Tiles.size(); TileIndex > 0; TileIndex--)
+	{
+		FreeTiles.push_back(TileIndex - 1);
+	}
+}
+
+uint64_t TVirtualTextureManager::GetPageKey(const TVirtualPage& Page)
+{
+	return ((uint64_t)Page.TextureId << 40) | ((uint64_t)Page.Mip << 32) | ((uint64_t)Page.Y << 16) | Page.X;
+}
+
+TVirtualPage TVirtualTextureManager::GetPage(uint64_t PageKey)
+{
+	TVirtualPage Page;
+	Page.TextureId = (uint32_t)(PageKey >> 40);
+	Page.Mip = (uint32_t)(PageKey >> 32) & 0xFF;
+	Page.Y = (uint32_t)(PageKey >> 16) & 0xFFFF;
+	Page.X = (uint32_t)PageKey & 0xFFFF;
+
+	return Page;
+}
+
+uint32_t TVirtualTextureManager::RegisterTexture(const TVirtualTextureDesc& Desc)
+{
+	assert(Desc.Width > 0 && Desc.Height > 0);
+
+	const uint32_t TextureId = (uint32_t)Textures.size();
+	if (TextureId >= MaxFeedbackTextures)
+	{
+		return InvalidVirtualTextureId;
+	}
+
+	// Pages per mip down to the first mip that fits one tile
+	TVirtualTexture Texture;
+	Texture.Desc = Desc;
+	for (uint32_t Mip = 0; ; Mip++)
+	{
+		const uint32_t MipWidth = std::max<uint32_t>(Desc.Width >> Mip, 1);
+		const uint32_t MipHeight = std::max<uint32_t>(Desc.Height >> Mip, 1);
+
+		TVirtualMip VirtualMip;
+		VirtualMip.PagesX = (MipWidth + Settings.TileSize - 1) / Settings.TileSize;
+		VirtualMip.PagesY = (MipHeight + Settings.TileSize - 1) / Settings.TileSize;
+		if (VirtualMip.PagesX > MaxFeedbackPages || VirtualMip.PagesY > MaxFeedbackPages || Mip >= MaxFeedbackMips)
+		{
+			return InvalidVirtualTextureId;
+		}
+
+		VirtualMip.PageTable.assign((size_t)VirtualMip.PagesX * VirtualMip.PagesY, VirtualPageUnmapped);
+		Texture.Mips.push_back(std::move(VirtualMip));
+
+		if (Texture.Mips.back().PagesX == 1 && Texture.Mips.back().PagesY == 1)
+		{
+			break;
+		}
+	}
+	Texture.DirtyMips = (1u << Texture.Mips.size()) - 1;
+
+	// The tail tile is reserved now, so a registered texture can always be sampled once it is loaded
+	const int32_t TailTile = AllocateTile(true);
+	if (TailTile < 0)
+	{
+		return InvalidVirtualTextureId;
+	}
+
+	Textures.push_back(std::move(Texture));
+
+	TVirtualPage TailPage;
+	TailPage.TextureId = TextureId;
+	TailPage.Mip = (uint32_t)Textures.back().Mips.size() - 1;
+
+	const uint64_t TailKey = GetPageKey(TailPage);
+	Tiles[TailTile].PageKey = TailKey;
+	PageTiles[TailKey] = (uint32_t)TailTile;
+	PendingTails.push_back(TailKey);
+
+	return TextureId;
+}
+
+void TVirtualTextureManager::BeginFrame()
+{
+	FrameIndex++;
+
+	FeedbackPages.clear();
+}
+
+void TVirtualTextureManager::AddFeedback(const uint32_t* Entries, size_t Count)
+{
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		if (Entries[Index] == VirtualFeedbackEmpty)
+		{
+			continue;
+		}
+
+		TVirtualPage Page = UnpackVirtualFeedback(Entries[Index]);
+		if (Page.TextureId >= Textures.size())
+		{
+			continue;
+		}
+
+		// Shaders clamp to the tail, stale entries of a resized texture are dropped
+		const TVirtualTexture& Texture = Textures[Page.TextureId];
+		Page.Mip = std::min<uint32_t>(Page.Mip, (uint32_t)Texture.Mips.size() - 1);
+		if (Page.X >= Texture.Mips[Page.Mip].PagesX || Page.Y >= Texture.Mips[Page.Mip].PagesY)
+		{
+			continue;
+		}
+
+		FeedbackPages[GetPageKey(Page)]++;
+	}
+}
+
+void TVirtualTextureManager::Update(std::vector<TVirtualTileRequest>& OutRequests)
+{
+	auto MakeRequest = [this, &OutRequests](uint64_t PageKey, uint32_t TileIndex)
+	{
+		TVirtualTileRequest Request;
+		Request.Page = GetPage(PageKey);
+		Request.PhysicalX = TileIndex % Settings.PhysicalTilesX;
+		Request.PhysicalY = TileIndex / Settings.PhysicalTilesX;
+		OutRequests.push_back(Request);
+
+		Stats.LoadCount++;
+	};
+
+	// Tails first, their tiles were reserved at registration
+	uint32_t RequestCount = 0;
+	for (uint64_t TailKey : PendingTails)
+	{
+		MakeRequest(TailKey, PageTiles.at(TailKey));
+		RequestCount++;
+	}
+	PendingTails.clear();
+
+	// Keep every tile sampled this frame, whether directly or as the fallback of a missing page, before evicting any
+	std::vector<TPageRequest> Candidates;
+	for (const auto& Pair : FeedbackPages)
+	{
+		auto Iter = PageTiles.find(Pair.first);
+		if (Iter != PageTiles.end())
+		{
+			TouchTile(Iter->second);
+			continue;
+		}
+
+		const TVirtualPage Page = GetPage(Pair.first);
+		const uint32_t Entry = TranslatePage(Page);
+
+		uint32_t FallbackMip = GetMipCount(Page.TextureId);
+		if (Entry != VirtualPageUnmapped)
+		{
+			FallbackMip = GetEntryMip(Entry);
+			TouchTile((Entry & 0xFFF) + ((Entry >> 12) & 0xFFF) * Settings.PhysicalTilesX);
+		}
+
+		// Pixels sampling the page, doubled for every mip they are blurred by
+		TPageRequest Candidate;
+		Candidate.PageKey = Pair.first;
+		Candidate.Priority = (uint64_t)Pair.second << std::min<uint32_t>(FallbackMip - Page.Mip, MaxPriorityMipGap);
+		Candidate.Mip = Page.Mip;
+		Candidates.push_back(Candidate);
+	}
+
+	std::sort(Candidates.begin(), Candidates.end(), [](const TPageRequest& A, const TPageRequest& B)
+	{
+		if (A.Priority != B.Priority)
+		{
+			return A.Priority > B.Priority;
+		}
+
+		// Coarser pages cover more of the screen once loaded
+		if (A.Mip != B.Mip)
+		{
+			return A.Mip > B.Mip;
+		}
+
+		return A.PageKey < B.PageKey;
+	});
+
+	for (size_t Index = 0; Index < Candidates.size() && RequestCount < Settings.MaxRequestsPerUpdate; Index++)
+	{
+		const int32_t TileIndex = AllocateTile(false);
+		if (TileIndex < 0)
+		{
+			// Every tile is in use this frame, the cache is too small for the view
+			Stats.ThrashCount += Candidates.size() - Index;
+			break;
+		}
+
+		Tiles[TileIndex].PageKey = Candidates[Index].PageKey;
+		PageTiles[Candidates[Index].PageKey] = (uint32_t)TileIndex;
+
+		MakeRequest(Candidates[Index].PageKey, (uint32_t)TileIndex);
+		RequestCount++;
+	}
+
+	// Refresh stats
+	Stats.FeedbackPages = (uint32_t)FeedbackPages.size();
+	Stats.MissingPages = (uint32_t)Candidates.size();
+	Stats.ResidentTiles = 0;
+	Stats.PendingTiles = 0;
+	for (const TPhysicalTile& Tile : Tiles)
+	{
+		Stats.ResidentTiles += (Tile.State == ETileState::Resident) ? 1 : 0;
+		Stats.PendingTiles += (Tile.State == ETileState::Loading) ? 1 : 0;
+	}
+}
+
+void TVirtualTextureManager::OnTileLoaded(const TVirtualTileRequest& Request)
+{
+	const uint32_t TileIndex = Request.PhysicalX + Request.PhysicalY * Settings.PhysicalTilesX;
+
+	TPhysicalTile& Tile = Tiles[TileIndex];
+	assert(Tile.State == ETileState::Loading && Tile.PageKey == GetPageKey(Request.Page));
+
+	Tile.State = ETileState::Resident;
+	Tile.LastUsedFrame = FrameIndex;
+	if (!Tile.bPinned)
+	{
+		LinkTile(TileIndex);
+	}
+
+	MapPage(Request.Page, TileIndex);
+}
+
+uint32_t TVirtualTextureManager::TranslatePage(const TVirtualPage& Page) const
+{
+	const TVirtualTexture& Texture = Textures[Page.TextureId];
+	const uint32_t Mip = std::min<uint32_t>(Page.Mip, (uint32_t)Texture.Mips.size() - 1);
+	const TVirtualMip& VirtualMip = Texture.Mips[Mip];
+
+	const uint32_t X = std::min<uint32_t>(Page.X, VirtualMip.PagesX - 1);
+	const uint32_t Y = std::min<uint32_t>(Page.Y, VirtualMip.PagesY - 1);
+
+	return VirtualMip.PageTable[(size_t)Y * VirtualMip.PagesX + X];
+}
+
+bool TVirtualTextureManager::IsPageResident(const TVirtualPage& Page) const
+{
+	auto Iter = PageTiles.find(GetPageKey(Page));
+
+	return Iter != PageTiles.end() && Tiles[Iter->second].State == ETileState::Resident;
+}
+
+int32_t TVirtualTextureManager::AllocateTile(bool bPinned)
+{
+	int32_t TileIndex = -1;
+	if (!FreeTiles.empty())
+	{
+		TileIndex = (int32_t)FreeTiles.back();
+		FreeTiles.pop_back();
+	}
+	else if (LRUHead >= 0 && Tiles[LRUHead].LastUsedFrame < FrameIndex)
+	{
+		TileIndex = LRUHead;
+
+		TPhysicalTile& Victim = Tiles[TileIndex];
+		UnlinkTile(TileIndex);
+		UnmapPage(GetPage(Victim.PageKey));
+		PageTiles.erase(Victim.PageKey);
+
+		Stats.EvictionCount++;
+	}
+
+	if (TileIndex >= 0)
+	{
+		TPhysicalTile& Tile = Tiles[TileIndex];
+		Tile.State = ETileState::Loading;
+		Tile.bPinned = bPinned;
+		Tile.LastUsedFrame = FrameIndex;
+	}
+
+	return TileIndex;
+}
+
+void TVirtualTextureManager::MapPage(const TVirtualPage& Page, uint32_t TileIndex)
+{
+	const uint32_t Entry = PackVirtualPageEntry(TileIndex % Settings.PhysicalTilesX, TileIndex / Settings.PhysicalTilesX, Page.Mip);
+
+	// Unmapped entries have mip 0xFF, so they are replaced along with coarser fallbacks
+	WritePageSubtree(Page, Page.Mip + 1, 0xFF, Entry);
+}
+
+void TVirtualTextureManager::UnmapPage(const TVirtualPage& Page)
+{
+	const TVirtualTexture& Texture = Textures[Page.TextureId];
+
+	uint32_t Fallback = VirtualPageUnmapped;
+	if (Page.Mip + 1 < Texture.Mips.size())
+	{
+		const TVirtualMip& ParentMip = Texture.Mips[Page.Mip + 1];
+		const uint32_t ParentX = std::min<uint32_t>(Page.X >> 1, ParentMip.PagesX - 1);
+		const uint32_t ParentY = std::min<uint32_t>(Page.Y >> 1, ParentMip.PagesY - 1);
+
+		Fallback = ParentMip.PageTable[(size_t)ParentY * ParentMip.PagesX + ParentX];
+	}
+
+	WritePageSubtree(Page, Page.Mip, Page.Mip, Fallback);
+}
+
+void TVirtualTextureManager::WritePageSubtree(const TVirtualPage& Page, uint32_t MatchMinMip, uint32_t MatchMaxMip, uint32_t Entry)
+{
+	TVirtualTexture& Texture = Textures[Page.TextureId];
+	TVirtualMip& VirtualMip = Texture.Mips[Page.Mip];
+
+	uint32_t& PageEntry = VirtualMip.PageTable[(size_t)Page.Y * VirtualMip.PagesX + Page.X];
+	const uint32_t ResolvedMip = GetEntryMip(PageEntry);
+	if (ResolvedMip < MatchMinMip || ResolvedMip > MatchMaxMip)
+	{
+		// A page resolves to itself or coarser, so finer pages under an unmatched one resolve finer still
+		return;
+	}
+
+	PageEntry = Entry;
+	Texture.DirtyMips |= 1u << Page.Mip;
+
+	if (Page.Mip == 0)
+	{
+		return;
+	}
+
+	// Children are the 2x2 pages below, the last page of a row or column also owns the odd pages left over
+	const TVirtualMip& ChildMip = Texture.Mips[Page.Mip - 1];
+	const uint32_t ChildX1 = (Page.X + 1 == VirtualMip.PagesX) ? ChildMip.PagesX : std::min<uint32_t>(Page.X * 2 + 2, ChildMip.PagesX);
+	const uint32_t ChildY1 = (Page.Y + 1 == VirtualMip.PagesY) ? ChildMip.PagesY : std::min<uint32_t>(Page.Y * 2 + 2, ChildMip.PagesY);
+
+	TVirtualPage Child;
+	Child.TextureId = Page.TextureId;
+	Child.Mip = Page.Mip - 1;
+	for (Child.Y = Page.Y * 2; Child.Y < ChildY1; Child.Y++)
+	{
+		for (Child.X = Page.X * 2; Child.X < ChildX1; Child.X++)
+		{
+			WritePageSubtree(Child, MatchMinMip, MatchMaxMip, Entry);
+		}
+	}
+}
+
+void TVirtualTextureManager::TouchTile(uint32_t TileIndex)
+{
+	TPhysicalTile& Tile = Tiles[TileIndex];
+	Tile.LastUsedFrame = FrameIndex;
+
+	if (Tile.State == ETileState::Resident && !Tile.bPinned)
+	{
+		UnlinkTile(TileIndex);
+		LinkTile(TileIndex);
+	}
+}
+
+void TVirtualTextureManager::LinkTile(uint32_t TileIndex)
+{
+	TPhysicalTile& Tile = Tiles[TileIndex];
+	Tile.Prev = LRUTail;
+	Tile.Next = -1;
+
+	if (LRUTail >= 0)
+	{
+		Tiles[LRUTail].Next = (int32_t)TileIndex;
+	}
+	else
+	{
+		LRUHead = (int32_t)TileIndex;
+	}
+	LRUTail = (int32_t)TileIndex;
+}
+
+void TVirtualTextureManager::UnlinkTile(uint32_t TileIndex)
+{
+	TPhysicalTile& Tile = Tiles[TileIndex];
+
+	if (Tile.Prev >= 0)
+	{
+		Tiles[Tile.Prev].Next = Tile.Next;
+	}
+	else
+	{
+		LRUHead = Tile.Next;
+	}
+
+	if (Tile.Next >= 0)
+	{
+		Tiles[Tile.Next].Prev = Tile.Prev;
+	}
+	else
+	{
+		LRUTail = Tile.Prev;
+	}
+
+	Tile.Prev = -1;
+	Tile.Next = -1;
+}
+
+bool BuildVirtualTile(const TDecodedImage& Image, const TVirtualPage& Page, const TVirtualTextureSettings& Settings, bool bWrap,
+	std::vector<uint8_t>& OutTexels)
+{
+	TDecodedMip Level;
+	if (Image.Mips.empty())
+	{
+		if (Page.Mip > 0)
+		{
+			return false;
+		}
+
+		Level.Width = Image.Width;
+		Level.Height = Image.Height;
+		Level.RowPitch = Image.RowPitch;
+	}
+	else if (Page.Mip < Image.Mips.size())
+	{
+		Level = Image.Mips[Page.Mip];
+	}
+	else
+	{
+		return false;
+	}
+
+	const uint32_t BytesPerPixel = GetBytesPerPixel(Image.Format);
+	const uint32_t StoredSize = Settings.GetStoredTileSize();
+	OutTexels.resize((size_t)StoredSize * StoredSize * BytesPerPixel);
+
+	const int32_t FirstX = (int32_t)(Page.X * Settings.TileSize) - (int32_t)Settings.TileBorder;
+	const int32_t FirstY = (int32_t)(Page.Y * Settings.TileSize) - (int32_t)Settings.TileBorder;
+
+	for (uint32_t y = 0; y < StoredSize; y++)
+	{
+		const int32_t SrcY = WrapOrClamp(FirstY + (int32_t)y, (int32_t)Level.Height, bWrap);
+		const uint8_t* SrcRow = Image.Data.data() + Level.Offset + (size_t)SrcY * Level.RowPitch;
+		uint8_t* DstRow = OutTexels.data() + (size_t)y * StoredSize * BytesPerPixel;
+
+		for (uint32_t x = 0; x < StoredSize; x++)
+		{
+			const int32_t SrcX = WrapOrClamp(FirstX + (int32_t)x, (int32_t)Level.Width, bWrap);
+			memcpy(DstRow + (size_t)x * BytesPerPixel, SrcRow + (size_t)SrcX * BytesPerPixel, BytesPerPixel);
+		}
+	}
+
+	return true;
+}
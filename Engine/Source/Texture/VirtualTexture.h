@@ -0,0 +1,248 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "TextureLoader/ImageDecoder.h"
+
+struct TVirtualTextureSettings
+{
+	// Texels per tile side, without the border
+	uint32_t TileSize = 128;
+
+	// Texels repeated from the neighbouring tiles on every side, so filtering never reads another tile
+	uint32_t TileBorder = 4;
+
+	// The physical texture holds PhysicalTilesX * PhysicalTilesY tiles, that is the whole memory budget
+	uint32_t PhysicalTilesX = 16;
+
+	uint32_t PhysicalTilesY = 16;
+
+	uint32_t MaxRequestsPerUpdate = 16;
+
+	uint32_t GetStoredTileSize() const { return TileSize + 2 * TileBorder; }
+
+	uint32_t GetPhysicalTileCount() const { return PhysicalTilesX * PhysicalTilesY; }
+};
+
+struct TVirtualTextureDesc
+{
+	uint32_t Width = 0;
+
+	uint32_t Height = 0;
+};
+
+struct TVirtualPage
+{
+	uint32_t TextureId = 0;
+
+	uint32_t Mip = 0;
+
+	uint32_t X = 0;
+
+	uint32_t Y = 0;
+};
+
+const uint32_t InvalidVirtualTextureId = 0xFFFFFFFF;
+
+// Feedback buffer texels: 10 bit texture id, 4 bit mip, 9 bit page x and y. Pixels without a virtual texture write this.
+const uint32_t VirtualFeedbackEmpty = 0xFFFFFFFF;
+
+uint32_t PackVirtualFeedback(const TVirtualPage& Page);
+
+TVirtualPage UnpackVirtualFeedback(uint32_t Entry);
+
+// Page table entries as a sampling shader would read them: physical tile x in bits 0-11, y in bits 12-23 and the mip of the
+// resident page in bits 24-31. Every page points at itself when resident, otherwise at its nearest resident coarser mip.
+const uint32_t VirtualPageUnmapped = 0xFFFFFFFF;
+
+inline uint32_t PackVirtualPageEntry(uint32_t PhysicalX, uint32_t PhysicalY, uint32_t ResidentMip)
+{
+	return PhysicalX | (PhysicalY << 12) | (ResidentMip << 24);
+}
+
+// Fill the physical tile at PhysicalX, PhysicalY with the page, then report back with OnTileLoaded.
+// The page is not mapped before that, an evicted page is unmapped when the request is made.
+struct TVirtualTileRequest
+{
+	TVirtualPage Page;
+
+	uint32_t PhysicalX = 0;
+
+	uint32_t PhysicalY = 0;
+};
+
+struct TVirtualTextureStats
+{
+	uint32_t ResidentTiles = 0;
+
+	uint32_t PendingTiles = 0;
+
+	// Distinct pages in the last feedback
+	uint32_t FeedbackPages = 0;
+
+	// Missing pages in the last feedback
+	uint32_t MissingPages = 0;
+
+	uint64_t LoadCount = 0;
+
+	uint64_t EvictionCount = 0;
+
+	// Requests held back because every unpinned tile was used this frame
+	uint64_t ThrashCount = 0;
+};
+
+// CPU simulator of virtual texture page tables and an LRU physical tile cache. Nothing in TRender or the shaders
+// uses it yet, it is only driven by VirtualTextureTest with simulated feedback.
+// Every texture is split into TileSize pages per mip down to its tail, the first mip that fits one tile. Tails are
+// pinned so every page table entry always resolves. The pages sampled in a frame come in as a feedback buffer, Update
+// turns the missing ones into tile requests, most blurred pixels first, evicting the least recently used tiles.
+// Holds no device state, the caller fills tiles, uploads the dirty page table mips and reports back with OnTileLoaded.
+class TVirtualTextureManager
+{
+public:
+	TVirtualTextureManager(const TVirtualTextureSettings& InSettings = TVirtualTextureSettings());
+
+public:
+	// InvalidVirtualTextureId when the texture is too large for the feedback format or no tile is left for its tail
+	uint32_t RegisterTexture(const TVirtualTextureDesc& Desc);
+
+	void BeginFrame();
+
+	// Texels of the feedback buffer read back for this frame, VirtualFeedbackEmpty entries are skipped
+	void AddFeedback(const uint32_t* Entries, size_t Count);
+
+	void Update(std::vector<TVirtualTileRequest>& OutRequests);
+
+	void OnTileLoaded(const TVirtualTileRequest& Request);
+
+	const TVirtualTextureSettings& GetSettings() const { return Settings; }
+
+	// Mips with pages, the last one is the pinned tail
+	uint32_t GetMipCount(uint32_t TextureId) const { return (uint32_t)Textures[TextureId].Mips.size(); }
+
+	uint32_t GetPageCountX(uint32_t TextureId, uint32_t Mip) const { return Textures[TextureId].Mips[Mip].PagesX; }
+
+	uint32_t GetPageCountY(uint32_t TextureId, uint32_t Mip) const { return Textures[TextureId].Mips[Mip].PagesY; }
+
+	// Packed entries, x fastest
+	const std::vector<uint32_t>& GetPageTable(uint32_t TextureId, uint32_t Mip) const { return Textures[TextureId].Mips[Mip].PageTable; }
+
+	// Bit per mip whose page table changed since the last ClearDirtyPageTables
+	uint32_t GetDirtyPageTableMips(uint32_t TextureId) const { return Textures[TextureId].DirtyMips; }
+
+	void ClearDirtyPageTables(uint32_t TextureId) { Textures[TextureId].DirtyMips = 0; }
+
+	// Page table lookup, Mip is clamped to the tail
+	uint32_t TranslatePage(const TVirtualPage& Page) const;
+
+	bool IsPageResident(const TVirtualPage& Page) const;
+
+	const TVirtualTextureStats& GetStats() const { return Stats; }
+
+private:
+	enum class ETileState
+	{
+		Free,
+		Loading,
+		Resident,
+	};
+
+	struct TPhysicalTile
+	{
+		uint64_t PageKey = 0;
+
+		ETileState State = ETileState::Free;
+
+		// Tails are never evicted
+		bool bPinned = false;
+
+		uint64_t LastUsedFrame = 0;
+
+		// LRU list of resident unpinned tiles, -1 ends it
+		int32_t Prev = -1;
+
+		int32_t Next = -1;
+	};
+
+	struct TVirtualMip
+	{
+		uint32_t PagesX = 0;
+
+		uint32_t PagesY = 0;
+
+		std::vector<uint32_t> PageTable;
+	};
+
+	struct TVirtualTexture
+	{
+		TVirtualTextureDesc Desc;
+
+		std::vector<TVirtualMip> Mips;
+
+		uint32_t DirtyMips = 0;
+	};
+
+	struct TPageRequest
+	{
+		uint64_t PageKey = 0;
+
+		uint64_t Priority = 0;
+
+		uint32_t Mip = 0;
+	};
+
+	static uint64_t GetPageKey(const TVirtualPage& Page);
+
+	static TVirtualPage GetPage(uint64_t PageKey);
+
+	// Free tile first, then the least recently used one not seen this frame. -1 when there is none.
+	int32_t AllocateTile(bool bPinned);
+
+	void MapPage(const TVirtualPage& Page, uint32_t TileIndex);
+
+	void UnmapPage(const TVirtualPage& Page);
+
+	// Point the entries of Page and of every finer page under it that currently resolve to a mip in
+	// [MatchMinMip, MatchMaxMip] at Entry
+	void WritePageSubtree(const TVirtualPage& Page, uint32_t MatchMinMip, uint32_t MatchMaxMip, uint32_t Entry);
+
+	void TouchTile(uint32_t TileIndex);
+
+	void LinkTile(uint32_t TileIndex);
+
+	void UnlinkTile(uint32_t TileIndex);
+
+private:
+	TVirtualTextureSettings Settings;
+
+	std::vector<TVirtualTexture> Textures;
+
+	std::vector<TPhysicalTile> Tiles;
+
+	// Free tiles, lowest index last
+	std::vector<uint32_t> FreeTiles;
+
+	// Least recently used first
+	int32_t LRUHead = -1;
+
+	int32_t LRUTail = -1;
+
+	// Loading and resident pages
+	std::unordered_map<uint64_t, uint32_t> PageTiles;
+
+	// Pixel count per page of this frame's feedback
+	std::unordered_map<uint64_t, uint32_t> FeedbackPages;
+
+	// Tails registered since the last update
+	std::vector<uint64_t> PendingTails;
+
+	uint64_t FrameIndex = 0;
+
+	TVirtualTextureStats Stats;
+};
+
+// Texels of one page with its border, GetStoredTileSize() rows of tightly packed R8 or RGBA8 texels.
+// Texels outside the mip wrap for tiling textures, otherwise clamp. Image must have a full mip chain or a single level.
+bool BuildVirtualTile(const TDecodedImage& Image, const TVirtualPage& Page, const TVirtualTextureSettings& Settings, bool bWrap,
+	std::vector<uint8_t>& OutTexels);
@@ -0,0 +1,363 @@
+#include "VirtualTexture.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+// Linux simulation of TVirtualTextureManager: a camera drifting over a few visible textures and cutting to other ones,
+// feeding back the pages it samples, with loads completing one frame after the request. Checks the page table
+// invariants against a reference, the thrash path of a tiny cache and the tile borders. Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	// Mip of the nearest resident page at or above Mip, 0xFF when none is resident
+	uint32_t FindResidentMip(const TVirtualTextureManager& Manager, uint32_t TextureId, uint32_t Mip, uint32_t X, uint32_t Y)
+	{
+		const uint32_t MipCount = Manager.GetMipCount(TextureId);
+		for (uint32_t ParentMip = Mip; ParentMip < MipCount; ParentMip++)
+		{
+			if (Manager.IsPageResident({ TextureId, ParentMip, X, Y }))
+			{
+				return ParentMip;
+			}
+
+			if (ParentMip + 1 < MipCount)
+			{
+				X = std::min<uint32_t>(X >> 1, Manager.GetPageCountX(TextureId, ParentMip + 1) - 1);
+				Y = std::min<uint32_t>(Y >> 1, Manager.GetPageCountY(TextureId, ParentMip + 1) - 1);
+			}
+		}
+
+		return 0xFF;
+	}
+
+	// Page table entries whose mip is not the nearest resident one
+	size_t CountPageTableErrors(const TVirtualTextureManager& Manager, uint32_t TextureCount)
+	{
+		size_t ErrorCount = 0;
+		for (uint32_t TextureId = 0; TextureId < TextureCount; TextureId++)
+		{
+			for (uint32_t Mip = 0; Mip < Manager.GetMipCount(TextureId); Mip++)
+			{
+				const std::vector<uint32_t>& PageTable = Manager.GetPageTable(TextureId, Mip);
+				const uint32_t PagesX = Manager.GetPageCountX(TextureId, Mip);
+				for (uint32_t Y = 0; Y < Manager.GetPageCountY(TextureId, Mip); Y++)
+				{
+					for (uint32_t X = 0; X < PagesX; X++)
+					{
+						ErrorCount += (PageTable[Y * PagesX + X] >> 24) != FindResidentMip(Manager, TextureId, Mip, X, Y);
+					}
+				}
+			}
+		}
+
+		return ErrorCount;
+	}
+
+	void TestFeedbackPacking()
+	{
+		// Registration caps textures at 512 pages per axis, so mip 9 is the coarsest one with pages
+		const TVirtualPage Pages[] = { { 0, 0, 0, 0 }, { 1023, 0, 511, 511 }, { 1023, 9, 0, 0 }, { 37, 3, 100, 7 } };
+		bool bRoundTrip = true;
+		for (const TVirtualPage& Page : Pages)
+		{
+			const TVirtualPage Unpacked = UnpackVirtualFeedback(PackVirtualFeedback(Page));
+			bRoundTrip &= Unpacked.TextureId == Page.TextureId && Unpacked.Mip == Page.Mip && Unpacked.X == Page.X && Unpacked.Y == Page.Y;
+			bRoundTrip &= PackVirtualFeedback(Page) != VirtualFeedbackEmpty;
+		}
+
+		Check(bRoundTrip, "feedback entries round trip and never collide with the empty entry");
+	}
+
+	void TestMovingView()
+	{
+		std::mt19937 Random(7);
+
+		TVirtualTextureSettings Settings;
+		Settings.PhysicalTilesX = 16;
+		Settings.PhysicalTilesY = 16;
+		Settings.MaxRequestsPerUpdate = 32;
+
+		TVirtualTextureManager Manager(Settings);
+
+		// 2k to 16k textures, some not a power of two
+		const uint32_t TextureCount = 40;
+		std::vector<TVirtualTextureDesc> Descs;
+		uint64_t FullyResidentBytes = 0;
+		bool bRegistered = true;
+		for (uint32_t i = 0; i < TextureCount; i++)
+		{
+			TVirtualTextureDesc Desc;
+			Desc.Width = 1u << (11 + Random() % 4);
+			Desc.Height = Desc.Width >> (Random() % 2);
+			if (i % 7 == 0)
+			{
+				Desc.Width += 300;
+				Desc.Height += 77;
+			}
+			Descs.push_back(Desc);
+
+			bRegistered &= Manager.RegisterTexture(Desc) == i;
+			FullyResidentBytes += (uint64_t)Desc.Width * Desc.Height * 4 * 4 / 3;
+		}
+
+		Check(bRegistered, "moving view: every texture registers");
+		if (!bRegistered)
+		{
+			return;
+		}
+
+		// 320x180 feedback texels in bands of 40 over 6 visible textures, around a drifting UV center at a distance
+		// that changes over time
+		const uint32_t FeedbackWidth = 320;
+		const uint32_t FeedbackHeight = 180;
+		const int FrameCount = 600;
+		const int VisibleCount = 6;
+
+		std::vector<uint32_t> Feedback(FeedbackWidth * FeedbackHeight);
+		std::vector<TVirtualTileRequest> InFlight;
+		float CenterU[VisibleCount];
+		float CenterV[VisibleCount];
+		uint32_t Visible[VisibleCount];
+		for (int k = 0; k < VisibleCount; k++)
+		{
+			CenterU[k] = 0.5f;
+			CenterV[k] = 0.5f;
+			Visible[k] = k;
+		}
+
+		uint64_t SampleCount = 0;
+		uint64_t ExactCount = 0;
+		double TotalBlurMips = 0.0;
+		double UpdateMs = 0.0;
+		size_t PageTableErrors = 0;
+		bool bWithinBudget = true;
+		bool bRequestsCapped = true;
+		for (int Frame = 0; Frame < FrameCount; Frame++)
+		{
+			Manager.BeginFrame();
+			for (const TVirtualTileRequest& Request : InFlight)
+			{
+				Manager.OnTileLoaded(Request);
+			}
+			InFlight.clear();
+
+			// Cut to another part of the scene every second
+			if (Frame % 60 == 0)
+			{
+				for (int k = 0; k < VisibleCount; k++)
+				{
+					Visible[k] = Random() % TextureCount;
+				}
+			}
+
+			const float Distance = 1.5f + 1.2f * std::sin(Frame * 0.02f);
+			for (size_t i = 0; i < Feedback.size(); i++)
+			{
+				const int k = (int)(i / 40) % VisibleCount;
+				const uint32_t TextureId = Visible[k];
+				const TVirtualTextureDesc& Desc = Descs[TextureId];
+
+				CenterU[k] += 0.00000003f;
+				float U = CenterU[k] + ((i % FeedbackWidth) / (float)FeedbackWidth - 0.5f) * 0.3f * Distance;
+				float V = CenterV[k] + ((i / FeedbackWidth) / (float)FeedbackHeight - 0.5f) * 0.3f * Distance;
+				U -= std::floor(U);
+				V -= std::floor(V);
+
+				const float TexelsPerPixel = std::max<uint32_t>(Desc.Width, Desc.Height) * 0.3f * Distance / FeedbackWidth;
+				uint32_t Mip = TexelsPerPixel <= 1.0f ? 0 : (uint32_t)std::log2(TexelsPerPixel);
+				Mip = std::min<uint32_t>(Mip, Manager.GetMipCount(TextureId) - 1);
+
+				const uint32_t MipWidth = std::max<uint32_t>(Desc.Width >> Mip, 1);
+				const uint32_t MipHeight = std::max<uint32_t>(Desc.Height >> Mip, 1);
+
+				TVirtualPage Page;
+				Page.TextureId = TextureId;
+				Page.Mip = Mip;
+				Page.X = std::min<uint32_t>((uint32_t)(U * MipWidth) / Settings.TileSize, Manager.GetPageCountX(TextureId, Mip) - 1);
+				Page.Y = std::min<uint32_t>((uint32_t)(V * MipHeight) / Settings.TileSize, Manager.GetPageCountY(TextureId, Mip) - 1);
+				Feedback[i] = PackVirtualFeedback(Page);
+
+				// What the shader would sample this frame
+				const uint32_t Entry = Manager.TranslatePage(Page);
+				SampleCount++;
+				if (Entry != VirtualPageUnmapped)
+				{
+					ExactCount += (Entry >> 24) == Page.Mip;
+					TotalBlurMips += (Entry >> 24) - Page.Mip;
+				}
+				else
+				{
+					TotalBlurMips += Manager.GetMipCount(TextureId) - Page.Mip;
+				}
+			}
+
+			const auto StartTime = std::chrono::steady_clock::now();
+			Manager.AddFeedback(Feedback.data(), Feedback.size());
+			std::vector<TVirtualTileRequest> Requests;
+			Manager.Update(Requests);
+			UpdateMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
+
+			// The first update also requests the tail of every texture registered before it
+			bRequestsCapped &= Frame == 0 || Requests.size() <= Settings.MaxRequestsPerUpdate;
+			bWithinBudget &= Manager.GetStats().ResidentTiles + Manager.GetStats().PendingTiles <= Settings.GetPhysicalTileCount();
+			InFlight = Requests;
+
+			if (Frame % 100 == 0)
+			{
+				PageTableErrors += CountPageTableErrors(Manager, TextureCount);
+			}
+		}
+		PageTableErrors += CountPageTableErrors(Manager, TextureCount);
+
+		const TVirtualTextureStats& Stats = Manager.GetStats();
+		const uint32_t StoredTileSize = Settings.GetStoredTileSize();
+		printf("%u textures, %.1f MB fully resident with mips, physical cache of %ux%u tiles of %u texels = %.1f MB RGBA8\n",
+			TextureCount, FullyResidentBytes / 1048576.0, Settings.PhysicalTilesX, Settings.PhysicalTilesY, StoredTileSize,
+			Settings.GetPhysicalTileCount() * (double)StoredTileSize * StoredTileSize * 4 / 1048576.0);
+		printf("%d frames: exact mip %.1f%%, mean blur %.3f mips, %llu loads, %llu evictions, %llu thrashed, %u resident, update %.3f ms/frame for %zu feedback texels\n",
+			FrameCount, 100.0 * ExactCount / SampleCount, TotalBlurMips / SampleCount, (unsigned long long)Stats.LoadCount,
+			(unsigned long long)Stats.EvictionCount, (unsigned long long)Stats.ThrashCount, Stats.ResidentTiles, UpdateMs / FrameCount, Feedback.size());
+
+		Check(PageTableErrors == 0, "moving view: every page table entry points at the nearest resident mip");
+		Check(bRequestsCapped, "moving view: requests per update are capped");
+		Check(bWithinBudget, "moving view: resident and loading tiles fit the physical cache");
+		Check(Stats.EvictionCount > 0, "moving view: cuts evict tiles of textures no longer seen");
+		Check(ExactCount * 10 > SampleCount * 9, "moving view: most samples hit their exact mip");
+		Check(TotalBlurMips / SampleCount < 0.25, "moving view: missing pages blur by a fraction of a mip on average");
+	}
+
+	// Eight tiles, tails take them until registration fails, then a page wider than the cache thrashes
+	void TestTinyCache()
+	{
+		TVirtualTextureSettings Settings;
+		Settings.PhysicalTilesX = 4;
+		Settings.PhysicalTilesY = 2;
+
+		TVirtualTextureManager Manager(Settings);
+
+		uint32_t TextureCount = 0;
+		while (Manager.RegisterTexture({ 4096, 4096 }) != InvalidVirtualTextureId)
+		{
+			TextureCount++;
+		}
+
+		std::vector<TVirtualTileRequest> Requests;
+		Manager.BeginFrame();
+		Manager.Update(Requests);
+		for (const TVirtualTileRequest& Request : Requests)
+		{
+			Manager.OnTileLoaded(Request);
+		}
+
+		std::vector<uint32_t> Feedback;
+		for (uint32_t Y = 0; Y < 32; Y++)
+		{
+			for (uint32_t X = 0; X < 32; X++)
+			{
+				Feedback.push_back(PackVirtualFeedback({ 0, 0, X, Y }));
+			}
+		}
+
+		Manager.BeginFrame();
+		Manager.AddFeedback(Feedback.data(), Feedback.size());
+		Requests.clear();
+		Manager.Update(Requests);
+
+		printf("Tiny cache: %u textures registered before tails used every tile, then %zu requests and %llu thrashed\n",
+			TextureCount, Requests.size(), (unsigned long long)Manager.GetStats().ThrashCount);
+
+		Check(TextureCount == Settings.GetPhysicalTileCount(), "tiny cache: one tail tile per texture until the cache is full");
+		Check(Requests.empty(), "tiny cache: pinned tails are never evicted");
+		Check(Manager.GetStats().ThrashCount > 0, "tiny cache: requests without a tile are counted as thrashing");
+		Check(CountPageTableErrors(Manager, TextureCount) == 0, "tiny cache: page tables stay valid");
+	}
+
+	// Borders repeat the neighbouring texels, wrapped or clamped at the image edge
+	void TestTileBorders()
+	{
+		TDecodedImage Image;
+		Image.Width = 300;
+		Image.Height = 200;
+		Image.Format = EDecodedImageFormat::RGBA8;
+		Image.RowPitch = Image.Width * 4;
+		Image.Data.resize(Image.RowPitch * Image.Height);
+		for (size_t i = 0; i < Image.Data.size(); i++)
+		{
+			Image.Data[i] = (uint8_t)(i * 31 + 7);
+		}
+
+		TVirtualTextureSettings Settings;
+		const int StoredTileSize = (int)Settings.GetStoredTileSize();
+		const int Border = (int)Settings.TileBorder;
+
+		size_t MismatchCount = 0;
+		bool bBuilt = true;
+		std::vector<uint8_t> Tile;
+		for (int Wrap = 0; Wrap < 2; Wrap++)
+		{
+			for (uint32_t PageY = 0; PageY < 2; PageY++)
+			{
+				for (uint32_t PageX = 0; PageX < 3; PageX++)
+				{
+					bBuilt &= BuildVirtualTile(Image, { 0, 0, PageX, PageY }, Settings, Wrap != 0, Tile);
+					if (Tile.size() != (size_t)StoredTileSize * StoredTileSize * 4)
+					{
+						MismatchCount++;
+						continue;
+					}
+
+					for (int Y = 0; Y < StoredTileSize; Y++)
+					{
+						for (int X = 0; X < StoredTileSize; X++)
+						{
+							int SourceX = (int)(PageX * Settings.TileSize) + X - Border;
+							int SourceY = (int)(PageY * Settings.TileSize) + Y - Border;
+							if (Wrap)
+							{
+								SourceX = (SourceX % (int)Image.Width + (int)Image.Width) % (int)Image.Width;
+								SourceY = (SourceY % (int)Image.Height + (int)Image.Height) % (int)Image.Height;
+							}
+							else
+							{
+								SourceX = std::clamp(SourceX, 0, (int)Image.Width - 1);
+								SourceY = std::clamp(SourceY, 0, (int)Image.Height - 1);
+							}
+
+							MismatchCount += memcmp(&Tile[((size_t)Y * StoredTileSize + X) * 4], &Image.Data[(size_t)SourceY * Image.RowPitch + SourceX * 4], 4) != 0;
+						}
+					}
+				}
+			}
+		}
+
+		printf("Tile borders: %zu mismatching texels\n", MismatchCount);
+
+		Check(bBuilt, "tile borders: every page of the image builds");
+		Check(MismatchCount == 0, "tile borders: borders wrap or clamp like the sampler");
+	}
+}
+
+int main()
+{
+	TestFeedbackPacking();
+	TestMovingView();
+	TestTinyCache();
+	TestTileBorders();
+
+	printf("%s\n", FailureCount == 0 ? "All virtual texture checks passed" : "Virtual texture checks FAILED");
+
+	return FailureCount;
+}
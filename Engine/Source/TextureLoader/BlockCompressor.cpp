@@ -0,0 +1,1862 @@
+#include "BlockCompressor.h"
+#include "HDRPacking.h"
+#include "Utils/HalfFloat.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	// 4x4 texels row by row. LDR formats hold 0-255, BC6H holds half float bit patterns in RGB.
+	typedef float TBlockTexels[16][4];
+
+	const uint32_t BlockTexelCount = 16;
+
+	const uint8_t BlockIdentity[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+	class TBitWriter
+	{
+	public:
+		TBitWriter(uint8_t* InData, uint32_t ByteCount)
+			:Data(InData)
+		{
+			memset(Data, 0, ByteCount);
+		}
+
+		// LSB first, like every BC format
+		void Write(uint32_t Value, uint32_t BitCount)
+		{
+			for (uint32_t i = 0; i < BitCount; i++, Position++)
+			{
+				if ((Value >> i) & 1)
+				{
+					Data[Position >> 3] |= (uint8_t)(1 << (Position & 7));
+				}
+			}
+		}
+
+	private:
+		uint8_t* Data = nullptr;
+
+		uint32_t Position = 0;
+	};
+
+	class TBitReader
+	{
+	public:
+		TBitReader(const uint8_t* InData)
+			:Data(InData)
+		{}
+
+		uint32_t Read(uint32_t BitCount)
+		{
+			uint32_t Value = 0;
+			for (uint32_t i = 0; i < BitCount; i++, Position++)
+			{
+				Value |= (uint32_t)((Data[Position >> 3] >> (Position & 7)) & 1) << i;
+			}
+
+			return Value;
+		}
+
+	private:
+		const uint8_t* Data = nullptr;
+
+		uint32_t Position = 0;
+	};
+
+	float Square(float Value)
+	{
+		return Value * Value;
+	}
+
+	int ClampInt(int Value, int Min, int Max)
+	{
+		return std::min<int>(std::max<int>(Value, Min), Max);
+	}
+
+	// Mean and dominant direction of the texels in Subset over channels [FirstChannel, FirstChannel + ChannelCount)
+	void ComputePrincipalAxis(const TBlockTexels& Texels, const uint8_t* Subset, uint32_t Count, uint32_t FirstChannel, uint32_t ChannelCount,
+		float Mean[4], float Axis[4])
+	{
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			Mean[c] = 0.0f;
+			Axis[c] = 0.0f;
+		}
+
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			for (uint32_t c = 0; c < ChannelCount; c++)
+			{
+				Mean[c] += Texels[Subset[i]][FirstChannel + c];
+			}
+		}
+
+		for (uint32_t c = 0; c < ChannelCount; c++)
+		{
+			Mean[c] /= (float)Count;
+		}
+
+		float Covariance[4][4] = {};
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			float Delta[4];
+			for (uint32_t c = 0; c < ChannelCount; c++)
+			{
+				Delta[c] = Texels[Subset[i]][FirstChannel + c] - Mean[c];
+			}
+
+			for (uint32_t a = 0; a < ChannelCount; a++)
+			{
+				for (uint32_t b = 0; b < ChannelCount; b++)
+				{
+					Covariance[a][b] += Delta[a] * Delta[b];
+				}
+			}
+		}
+
+		// Power iteration from the row of the widest channel
+		uint32_t WidestChannel = 0;
+		for (uint32_t c = 1; c < ChannelCount; c++)
+		{
+			if (Covariance[c][c] > Covariance[WidestChannel][WidestChannel])
+			{
+				WidestChannel = c;
+			}
+		}
+
+		float Vector[4] = {};
+		for (uint32_t c = 0; c < ChannelCount; c++)
+		{
+			Vector[c] = Covariance[WidestChannel][c];
+		}
+
+		for (uint32_t Iteration = 0; Iteration < 8; Iteration++)
+		{
+			float NewVector[4] = {};
+			float MaxComponent = 0.0f;
+			for (uint32_t a = 0; a < ChannelCount; a++)
+			{
+				for (uint32_t b = 0; b < ChannelCount; b++)
+				{
+					NewVector[a] += Covariance[a][b] * Vector[b];
+				}
+				MaxComponent = std::max<float>(MaxComponent, std::fabs(NewVector[a]));
+			}
+
+			if (MaxComponent <= 0.0f)
+			{
+				break;
+			}
+
+			for (uint32_t c = 0; c < ChannelCount; c++)
+			{
+				Vector[c] = NewVector[c] / MaxComponent;
+			}
+		}
+
+		float Length = 0.0f;
+		for (uint32_t c = 0; c < ChannelCount; c++)
+		{
+			Length += Square(Vector[c]);
+		}
+
+		// A flat subset keeps a zero axis, both endpoints land on the mean
+		if (Length > 1e-12f)
+		{
+			Length = std::sqrt(Length);
+			for (uint32_t c = 0; c < ChannelCount; c++)
+			{
+				Axis[c] = Vector[c] / Length;
+			}
+		}
+	}
+
+	// Endpoints at the extreme projections on the principal axis, clamped to [0, MaxValue]
+	void ComputeAxisEndpoints(const TBlockTexels& Texels, const uint8_t* Subset, uint32_t Count, uint32_t FirstChannel, uint32_t ChannelCount,
+		float MaxValue, float OutEnd0[4], float OutEnd1[4])
+	{
+		float Mean[4];
+		float Axis[4];
+		ComputePrincipalAxis(Texels, Subset, Count, FirstChannel, ChannelCount, Mean, Axis);
+
+		float MinT = FLT_MAX;
+		float MaxT = -FLT_MAX;
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			float T = 0.0f;
+			for (uint32_t c = 0; c < ChannelCount; c++)
+			{
+				T += (Texels[Subset[i]][FirstChannel + c] - Mean[c]) * Axis[c];
+			}
+
+			MinT = std::min<float>(MinT, T);
+			MaxT = std::max<float>(MaxT, T);
+		}
+
+		for (uint32_t c = 0; c < ChannelCount; c++)
+		{
+			OutEnd0[c] = std::min<float>(std::max<float>(Mean[c] + Axis[c] * MinT, 0.0f), MaxValue);
+			OutEnd1[c] = std::min<float>(std::max<float>(Mean[c] + Axis[c] * MaxT, 0.0f), MaxValue);
+		}
+	}
+
+	// Squared distance of the subset to its principal axis, a cheap estimate of how well one segment fits it
+	float ComputeAxisResidual(const TBlockTexels& Texels, const uint8_t* Subset, uint32_t Count, uint32_t ChannelCount)
+	{
+		float Mean[4];
+		float Axis[4];
+		ComputePrincipalAxis(Texels, Subset, Count, 0, ChannelCount, Mean, Axis);
+
+		float Residual = 0.0f;
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			float DistanceSquared = 0.0f;
+			float T = 0.0f;
+			for (uint32_t c = 0; c < ChannelCount; c++)
+			{
+				float Delta = Texels[Subset[i]][c] - Mean[c];
+				DistanceSquared += Delta * Delta;
+				T += Delta * Axis[c];
+			}
+
+			Residual += DistanceSquared - T * T;
+		}
+
+		return Residual;
+	}
+
+	// Endpoints minimizing the squared error for fixed texel weights, Weights[i] in [0, 1] blends from End0 to End1
+	bool SolveLeastSquares(const TBlockTexels& Texels, const uint8_t* Subset, uint32_t Count, uint32_t FirstChannel, uint32_t ChannelCount,
+		const float* Weights, float OutEnd0[4], float OutEnd1[4])
+	{
+		float A00 = 0.0f;
+		float A01 = 0.0f;
+		float A11 = 0.0f;
+		float B0[4] = {};
+		float B1[4] = {};
+
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			const float W = Weights[i];
+			const float InvW = 1.0f - W;
+
+			A00 += InvW * InvW;
+			A01 += InvW * W;
+			A11 += W * W;
+
+			for (uint32_t c = 0; c < ChannelCount; c++)
+			{
+				B0[c] += InvW * Texels[Subset[i]][FirstChannel + c];
+				B1[c] += W * Texels[Subset[i]][FirstChannel + c];
+			}
+		}
+
+		const float Determinant = A00 * A11 - A01 * A01;
+		if (std::fabs(Determinant) < 1e-6f)
+		{
+			return false;
+		}
+
+		for (uint32_t c = 0; c < ChannelCount; c++)
+		{
+			OutEnd0[c] = (B0[c] * A11 - B1[c] * A01) / Determinant;
+			OutEnd1[c] = (B1[c] * A00 - B0[c] * A01) / Determinant;
+		}
+
+		return true;
+	}
+
+	uint32_t GetRefineIterations(EBlockCompressQuality Quality, uint32_t NormalIterations, uint32_t HighIterations)
+	{
+		switch (Quality)
+		{
+		case EBlockCompressQuality::Fast:
+			return 0;
+		case EBlockCompressQuality::Normal:
+			return NormalIterations;
+		default:
+			return HighIterations;
+		}
+	}
+
+	//------------------------------------------------------------------------------------------------
+	// BC1 (also the color half of BC3)
+	//------------------------------------------------------------------------------------------------
+
+	enum class EBC1Mode
+	{
+		// C0 > C1, two interpolated colors
+		FourColor,
+
+		// C0 <= C1, one midpoint. The transparent black entry is never used, the block stays opaque.
+		ThreeColor,
+
+		// BC3 color blocks always decode four colors, whatever the endpoint order
+		ForcedFourColor,
+	};
+
+	struct TBC1Block
+	{
+		uint16_t Color0 = 0;
+
+		uint16_t Color1 = 0;
+
+		uint8_t Indices[16] = {};
+
+		float Error = FLT_MAX;
+	};
+
+	uint16_t PackRGB565(const float Color[4])
+	{
+		int R = ClampInt((int)std::floor(Color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+		int G = ClampInt((int)std::floor(Color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+		int B = ClampInt((int)std::floor(Color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+
+		return (uint16_t)((R << 11) | (G << 5) | B);
+	}
+
+	void UnpackRGB565(uint16_t Color, int OutColor[3])
+	{
+		int R = (Color >> 11) & 31;
+		int G = (Color >> 5) & 63;
+		int B = Color & 31;
+
+		OutColor[0] = (R << 3) | (R >> 2);
+		OutColor[1] = (G << 2) | (G >> 4);
+		OutColor[2] = (B << 3) | (B >> 2);
+	}
+
+	// Palette entries used by the encoder, the three color black entry is left out
+	uint32_t BuildBC1Palette(uint16_t Color0, uint16_t Color1, bool bFourColor, int Palette[4][3])
+	{
+		UnpackRGB565(Color0, Palette[0]);
+		UnpackRGB565(Color1, Palette[1]);
+
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			if (bFourColor)
+			{
+				Palette[2][c] = (2 * Palette[0][c] + Palette[1][c]) / 3;
+				Palette[3][c] = (Palette[0][c] + 2 * Palette[1][c]) / 3;
+			}
+			else
+			{
+				Palette[2][c] = (Palette[0][c] + Palette[1][c]) / 2;
+				Palette[3][c] = 0;
+			}
+		}
+
+		return bFourColor ? 4 : 3;
+	}
+
+	void EvaluateBC1(const TBlockTexels& Texels, const float End0[4], const float End1[4], EBC1Mode Mode, TBC1Block& Best)
+	{
+		uint16_t Color0 = PackRGB565(End0);
+		uint16_t Color1 = PackRGB565(End1);
+
+		if ((Mode == EBC1Mode::ThreeColor) ? (Color0 > Color1) : (Color0 < Color1))
+		{
+			std::swap(Color0, Color1);
+		}
+
+		const bool bFourColor = (Mode == EBC1Mode::ForcedFourColor) || (Color0 > Color1);
+
+		int Palette[4][3];
+		const uint32_t PaletteSize = BuildBC1Palette(Color0, Color1, bFourColor, Palette);
+
+		TBC1Block Block;
+		Block.Color0 = Color0;
+		Block.Color1 = Color1;
+		Block.Error = 0.0f;
+
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			float BestDistance = FLT_MAX;
+			for (uint32_t Entry = 0; Entry < PaletteSize; Entry++)
+			{
+				float Distance = Square(Texels[i][0] - Palette[Entry][0]) + Square(Texels[i][1] - Palette[Entry][1]) + Square(Texels[i][2] - Palette[Entry][2]);
+				if (Distance < BestDistance)
+				{
+					BestDistance = Distance;
+					Block.Indices[i] = (uint8_t)Entry;
+				}
+			}
+
+			Block.Error += BestDistance;
+		}
+
+		if (Block.Error < Best.Error)
+		{
+			Best = Block;
+		}
+	}
+
+	// Least squares refinement of the endpoints for the current index assignment
+	void RefineBC1(const TBlockTexels& Texels, EBC1Mode Mode, uint32_t Iterations, TBC1Block& Best)
+	{
+		for (uint32_t Iteration = 0; Iteration < Iterations; Iteration++)
+		{
+			const bool bFourColor = (Mode == EBC1Mode::ForcedFourColor) || (Best.Color0 > Best.Color1);
+			const float FourColorWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+			const float ThreeColorWeights[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+
+			float Weights[16];
+			for (uint32_t i = 0; i < BlockTexelCount; i++)
+			{
+				Weights[i] = bFourColor ? FourColorWeights[Best.Indices[i]] : ThreeColorWeights[Best.Indices[i]];
+			}
+
+			float End0[4];
+			float End1[4];
+			if (!SolveLeastSquares(Texels, BlockIdentity, BlockTexelCount, 0, 3, Weights, End0, End1))
+			{
+				break;
+			}
+
+			const float PreviousError = Best.Error;
+			EvaluateBC1(Texels, End0, End1, Mode, Best);
+			if (Best.Error >= PreviousError)
+			{
+				break;
+			}
+		}
+	}
+
+	void WriteBC1Block(const TBC1Block& Block, uint8_t* Out)
+	{
+		TBitWriter Writer(Out, 8);
+		Writer.Write(Block.Color0, 16);
+		Writer.Write(Block.Color1, 16);
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			Writer.Write(Block.Indices[i], 2);
+		}
+	}
+
+	void EncodeBC1Block(const TBlockTexels& Texels, EBlockCompressQuality Quality, bool bColorOfBC3, uint8_t* Out)
+	{
+		float End0[4];
+		float End1[4];
+
+		if (Quality == EBlockCompressQuality::Fast)
+		{
+			// Bounding box diagonal, oriented by the sign of the green/blue covariance with red
+			float Min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+			float Max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			float Mean[3] = {};
+			for (uint32_t i = 0; i < BlockTexelCount; i++)
+			{
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					Min[c] = std::min<float>(Min[c], Texels[i][c]);
+					Max[c] = std::max<float>(Max[c], Texels[i][c]);
+					Mean[c] += Texels[i][c] / BlockTexelCount;
+				}
+			}
+
+			float CovarianceRG = 0.0f;
+			float CovarianceRB = 0.0f;
+			for (uint32_t i = 0; i < BlockTexelCount; i++)
+			{
+				CovarianceRG += (Texels[i][0] - Mean[0]) * (Texels[i][1] - Mean[1]);
+				CovarianceRB += (Texels[i][0] - Mean[0]) * (Texels[i][2] - Mean[2]);
+			}
+
+			// Inset by 1/16 of the range so the end colors sit inside the cluster
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				float Inset = (Max[c] - Min[c]) / 16.0f;
+				End0[c] = Min[c] + Inset;
+				End1[c] = Max[c] - Inset;
+			}
+
+			if (CovarianceRG < 0.0f)
+			{
+				std::swap(End0[1], End1[1]);
+			}
+
+			if (CovarianceRB < 0.0f)
+			{
+				std::swap(End0[2], End1[2]);
+			}
+		}
+		else
+		{
+			ComputeAxisEndpoints(Texels, BlockIdentity, BlockTexelCount, 0, 3, 255.0f, End0, End1);
+		}
+
+		const EBC1Mode Mode = bColorOfBC3 ? EBC1Mode::ForcedFourColor : EBC1Mode::FourColor;
+
+		TBC1Block Best;
+		EvaluateBC1(Texels, End0, End1, Mode, Best);
+		RefineBC1(Texels, Mode, GetRefineIterations(Quality, 1, 3), Best);
+
+		// The midpoint palette fits blocks with a single gradient step better
+		if (!bColorOfBC3 && Quality == EBlockCompressQuality::High)
+		{
+			TBC1Block ThreeColor;
+			EvaluateBC1(Texels, End0, End1, EBC1Mode::ThreeColor, ThreeColor);
+			RefineBC1(Texels, EBC1Mode::ThreeColor, 2, ThreeColor);
+
+			if (ThreeColor.Error < Best.Error)
+			{
+				Best = ThreeColor;
+			}
+		}
+
+		WriteBC1Block(Best, Out);
+	}
+
+	void DecodeBC1Colors(const uint8_t* Block, bool bForceFourColor, uint8_t OutTexels[16][4])
+	{
+		TBitReader Reader(Block);
+		uint16_t Color0 = (uint16_t)Reader.Read(16);
+		uint16_t Color1 = (uint16_t)Reader.Read(16);
+
+		const bool bFourColor = bForceFourColor || Color0 > Color1;
+
+		int Palette[4][3];
+		BuildBC1Palette(Color0, Color1, bFourColor, Palette);
+
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			uint32_t Index = Reader.Read(2);
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				OutTexels[i][c] = (uint8_t)Palette[Index][c];
+			}
+
+			// Three color index 3 is transparent black
+			OutTexels[i][3] = (!bFourColor && Index == 3) ? 0 : 255;
+		}
+	}
+
+	//------------------------------------------------------------------------------------------------
+	// BC4 (also BC3 alpha and both BC5 channels)
+	//------------------------------------------------------------------------------------------------
+
+	void BuildBC4Palette(int Value0, int Value1, int Palette[8])
+	{
+		Palette[0] = Value0;
+		Palette[1] = Value1;
+
+		if (Value0 > Value1)
+		{
+			for (int i = 2; i < 8; i++)
+			{
+				Palette[i] = ((8 - i) * Value0 + (i - 1) * Value1 + 3) / 7;
+			}
+		}
+		else
+		{
+			for (int i = 2; i < 6; i++)
+			{
+				Palette[i] = ((6 - i) * Value0 + (i - 1) * Value1 + 2) / 5;
+			}
+
+			Palette[6] = 0;
+			Palette[7] = 255;
+		}
+	}
+
+	float SelectBC4Indices(const float Values[16], int Value0, int Value1, uint8_t Indices[16])
+	{
+		int Palette[8];
+		BuildBC4Palette(Value0, Value1, Palette);
+
+		float Error = 0.0f;
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			float BestDistance = FLT_MAX;
+			for (uint32_t Entry = 0; Entry < 8; Entry++)
+			{
+				float Distance = Square(Values[i] - Palette[Entry]);
+				if (Distance < BestDistance)
+				{
+					BestDistance = Distance;
+					Indices[i] = (uint8_t)Entry;
+				}
+			}
+
+			Error += BestDistance;
+		}
+
+		return Error;
+	}
+
+	void EncodeBC4Block(const float Values[16], EBlockCompressQuality Quality, uint8_t* Out)
+	{
+		int Min = 255;
+		int Max = 0;
+		int InnerMin = 255;
+		int InnerMax = 0;
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			int Value = ClampInt((int)std::floor(Values[i] + 0.5f), 0, 255);
+			Min = std::min<int>(Min, Value);
+			Max = std::max<int>(Max, Value);
+
+			// The six value palette has exact 0 and 255 entries, its endpoints only need to cover the rest
+			if (Value > 0 && Value < 255)
+			{
+				InnerMin = std::min<int>(InnerMin, Value);
+				InnerMax = std::max<int>(InnerMax, Value);
+			}
+		}
+
+		int BestValue0 = Max;
+		int BestValue1 = Max;
+		uint8_t BestIndices[16];
+		float BestError = SelectBC4Indices(Values, BestValue0, BestValue1, BestIndices);
+
+		auto TryEndpoints = [&](int Value0, int Value1)
+		{
+			uint8_t Indices[16];
+			float Error = SelectBC4Indices(Values, Value0, Value1, Indices);
+			if (Error < BestError)
+			{
+				BestError = Error;
+				BestValue0 = Value0;
+				BestValue1 = Value1;
+				memcpy(BestIndices, Indices, sizeof(Indices));
+			}
+		};
+
+		// Endpoints are searched around the range ends, the error is cheap enough to evaluate exhaustively
+		const int Radius = (Quality == EBlockCompressQuality::Fast) ? 0 : (Quality == EBlockCompressQuality::Normal ? 2 : 6);
+
+		if (Max > Min)
+		{
+			for (int DeltaMax = -Radius; DeltaMax <= Radius; DeltaMax++)
+			{
+				for (int DeltaMin = -Radius; DeltaMin <= Radius; DeltaMin++)
+				{
+					int Value0 = ClampInt(Max + DeltaMax, 0, 255);
+					int Value1 = ClampInt(Min + DeltaMin, 0, 255);
+					if (Value0 > Value1)
+					{
+						TryEndpoints(Value0, Value1);
+					}
+				}
+			}
+		}
+
+		if (Quality != EBlockCompressQuality::Fast && (Min == 0 || Max == 255) && InnerMin <= InnerMax)
+		{
+			for (int DeltaMin = -Radius; DeltaMin <= Radius; DeltaMin++)
+			{
+				for (int DeltaMax = -Radius; DeltaMax <= Radius; DeltaMax++)
+				{
+					int Value0 = ClampInt(InnerMin + DeltaMin, 0, 255);
+					int Value1 = ClampInt(InnerMax + DeltaMax, 0, 255);
+					if (Value0 <= Value1)
+					{
+						TryEndpoints(Value0, Value1);
+					}
+				}
+			}
+		}
+
+		TBitWriter Writer(Out, 8);
+		Writer.Write((uint32_t)BestValue0, 8);
+		Writer.Write((uint32_t)BestValue1, 8);
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			Writer.Write(BestIndices[i], 3);
+		}
+	}
+
+	void DecodeBC4Values(const uint8_t* Block, uint8_t OutTexels[16][4], uint32_t Channel)
+	{
+		TBitReader Reader(Block);
+		int Value0 = (int)Reader.Read(8);
+		int Value1 = (int)Reader.Read(8);
+
+		int Palette[8];
+		BuildBC4Palette(Value0, Value1, Palette);
+
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			OutTexels[i][Channel] = (uint8_t)Palette[Reader.Read(3)];
+		}
+	}
+
+	//------------------------------------------------------------------------------------------------
+	// BC7, modes 1 (two subsets RGB), 5 (RGB + separate alpha) and 6 (RGBA)
+	//------------------------------------------------------------------------------------------------
+
+	const uint8_t BC7Weights2[4] = { 0, 21, 43, 64 };
+
+	const uint8_t BC7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+
+	const uint8_t BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Bit i set puts texel i in subset 1
+	const uint16_t BC7Partitions2[64] =
+	{
+		0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+		0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+		0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+		0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+		0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+		0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+		0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+		0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+	};
+
+	// Anchor texel of subset 1, its index is stored without the top bit
+	const uint8_t BC7Anchors2[64] =
+	{
+		15, 15, 15, 15, 15, 15, 15, 15,
+		15, 15, 15, 15, 15, 15, 15, 15,
+		15, 2, 8, 2, 2, 8, 8, 15,
+		2, 8, 2, 2, 8, 8, 2, 2,
+		15, 15, 6, 8, 2, 8, 15, 15,
+		2, 8, 2, 2, 2, 15, 15, 6,
+		6, 2, 6, 8, 15, 15, 2, 2,
+		15, 15, 15, 15, 15, 2, 2, 15,
+	};
+
+	const uint8_t* GetBC7Weights(uint32_t IndexBits)
+	{
+		return IndexBits == 2 ? BC7Weights2 : (IndexBits == 3 ? BC7Weights3 : BC7Weights4);
+	}
+
+	int BC7Interpolate(int Value0, int Value1, int Weight)
+	{
+		return ((64 - Weight) * Value0 + Weight * Value1 + 32) >> 6;
+	}
+
+	int BC7Expand(uint32_t Value, uint32_t Bits)
+	{
+		Value <<= (8 - Bits);
+		return (int)(Value | (Value >> Bits));
+	}
+
+	enum class EBC7PBit
+	{
+		None,
+		PerEndpoint,
+		Shared,
+	};
+
+	struct TBC7SubsetMode
+	{
+		uint32_t FirstChannel;
+
+		uint32_t ChannelCount;
+
+		uint32_t EndpointBits;
+
+		EBC7PBit PBit;
+
+		uint32_t IndexBits;
+	};
+
+	struct TBC7SubsetFit
+	{
+		// Stored endpoint bits, without the p-bit
+		uint8_t Endpoints[2][4] = {};
+
+		uint8_t PBits[2] = {};
+
+		// Indexed by texel, only texels of the subset are written
+		uint8_t Indices[16] = {};
+
+		float Error = FLT_MAX;
+	};
+
+	void DecodeBC7Endpoints(const TBC7SubsetMode& Mode, const uint8_t Stored[2][4], const uint8_t PBits[2], int OutEndpoints[2][4])
+	{
+		for (uint32_t e = 0; e < 2; e++)
+		{
+			for (uint32_t c = 0; c < Mode.ChannelCount; c++)
+			{
+				if (Mode.PBit == EBC7PBit::None)
+				{
+					OutEndpoints[e][c] = BC7Expand(Stored[e][c], Mode.EndpointBits);
+				}
+				else
+				{
+					OutEndpoints[e][c] = BC7Expand(((uint32_t)Stored[e][c] << 1) | PBits[e], Mode.EndpointBits + 1);
+				}
+			}
+		}
+	}
+
+	uint8_t QuantizeBC7Channel(float Value, uint32_t EndpointBits, int PBit)
+	{
+		const int MaxStored = (1 << EndpointBits) - 1;
+
+		// Expansion is close to linear, the nearest stored value is next to the scaled guess
+		int Guess;
+		if (PBit < 0)
+		{
+			Guess = (int)std::floor(Value / 255.0f * MaxStored + 0.5f);
+		}
+		else
+		{
+			Guess = (int)std::floor((Value / 255.0f * ((MaxStored << 1) | 1) - PBit) * 0.5f + 0.5f);
+		}
+
+		int Best = 0;
+		float BestDistance = FLT_MAX;
+		for (int Candidate = Guess - 1; Candidate <= Guess + 1; Candidate++)
+		{
+			int Stored = ClampInt(Candidate, 0, MaxStored);
+			int Expanded = (PBit < 0) ? BC7Expand((uint32_t)Stored, EndpointBits) : BC7Expand(((uint32_t)Stored << 1) | (uint32_t)PBit, EndpointBits + 1);
+
+			float Distance = std::fabs(Expanded - Value);
+			if (Distance < BestDistance)
+			{
+				BestDistance = Distance;
+				Best = Stored;
+			}
+		}
+
+		return (uint8_t)Best;
+	}
+
+	float SelectBC7Indices(const TBlockTexels& Texels, const uint8_t* Subset, uint32_t Count, const TBC7SubsetMode& Mode,
+		const int Endpoints[2][4], uint8_t Indices[16])
+	{
+		const uint32_t EntryCount = 1u << Mode.IndexBits;
+		const uint8_t* Weights = GetBC7Weights(Mode.IndexBits);
+
+		int Palette[16][4];
+		for (uint32_t Entry = 0; Entry < EntryCount; Entry++)
+		{
+			for (uint32_t c = 0; c < Mode.ChannelCount; c++)
+			{
+				Palette[Entry][c] = BC7Interpolate(Endpoints[0][c], Endpoints[1][c], Weights[Entry]);
+			}
+		}
+
+		float Error = 0.0f;
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			const float* Texel = Texels[Subset[i]] + Mode.FirstChannel;
+
+			float BestDistance = FLT_MAX;
+			for (uint32_t Entry = 0; Entry < EntryCount; Entry++)
+			{
+				float Distance = 0.0f;
+				for (uint32_t c = 0; c < Mode.ChannelCount; c++)
+				{
+					Distance += Square(Texel[c] - Palette[Entry][c]);
+				}
+
+				if (Distance < BestDistance)
+				{
+					BestDistance = Distance;
+					Indices[Subset[i]] = (uint8_t)Entry;
+				}
+			}
+
+			Error += BestDistance;
+		}
+
+		return Error;
+	}
+
+	// Quantize both endpoints under every p-bit choice of the mode and keep the best
+	void EvaluateBC7Subset(const TBlockTexels& Texels, const uint8_t* Subset, uint32_t Count, const TBC7SubsetMode& Mode,
+		const float End0[4], const float End1[4], TBC7SubsetFit& Best)
+	{
+		const uint32_t PBitCombinations = (Mode.PBit == EBC7PBit::None) ? 1 : (Mode.PBit == EBC7PBit::Shared ? 2 : 4);
+
+		for (uint32_t Combination = 0; Combination < PBitCombinations; Combination++)
+		{
+			TBC7SubsetFit Fit;
+			memcpy(Fit.Indices, Best.Indices, sizeof(Fit.Indices));
+
+			int PBit0 = -1;
+			int PBit1 = -1;
+			if (Mode.PBit == EBC7PBit::Shared)
+			{
+				PBit0 = PBit1 = (int)Combination;
+			}
+			else if (Mode.PBit == EBC7PBit::PerEndpoint)
+			{
+				PBit0 = (int)(Combination & 1);
+				PBit1 = (int)(Combination >> 1);
+			}
+
+			Fit.PBits[0] = (uint8_t)std::max<int>(PBit0, 0);
+			Fit.PBits[1] = (uint8_t)std::max<int>(PBit1, 0);
+
+			for (uint32_t c = 0; c < Mode.ChannelCount; c++)
+			{
+				Fit.Endpoints[0][c] = QuantizeBC7Channel(End0[c], Mode.EndpointBits, PBit0);
+				Fit.Endpoints[1][c] = QuantizeBC7Channel(End1[c], Mode.EndpointBits, PBit1);
+			}
+
+			int Endpoints[2][4];
+			DecodeBC7Endpoints(Mode, Fit.Endpoints, Fit.PBits, Endpoints);
+			Fit.Error = SelectBC7Indices(Texels, Subset, Count, Mode, Endpoints, Fit.Indices);
+
+			if (Fit.Error < Best.Error)
+			{
+				Best = Fit;
+			}
+		}
+	}
+
+	void FitBC7Subset(const TBlockTexels& Texels, const uint8_t* Subset, uint32_t Count, const TBC7SubsetMode& Mode, uint32_t Iterations,
+		TBC7SubsetFit& Fit)
+	{
+		float End0[4];
+		float End1[4];
+		ComputeAxisEndpoints(Texels, Subset, Count, Mode.FirstChannel, Mode.ChannelCount, 255.0f, End0, End1);
+		EvaluateBC7Subset(Texels, Subset, Count, Mode, End0, End1, Fit);
+
+		const uint8_t* Weights = GetBC7Weights(Mode.IndexBits);
+		for (uint32_t Iteration = 0; Iteration < Iterations; Iteration++)
+		{
+			float TexelWeights[16];
+			for (uint32_t i = 0; i < Count; i++)
+			{
+				TexelWeights[i] = Weights[Fit.Indices[Subset[i]]] / 64.0f;
+			}
+
+			if (!SolveLeastSquares(Texels, Subset, Count, Mode.FirstChannel, Mode.ChannelCount, TexelWeights, End0, End1))
+			{
+				break;
+			}
+
+			for (uint32_t c = 0; c < Mode.ChannelCount; c++)
+			{
+				End0[c] = std::min<float>(std::max<float>(End0[c], 0.0f), 255.0f);
+				End1[c] = std::min<float>(std::max<float>(End1[c], 0.0f), 255.0f);
+			}
+
+			const float PreviousError = Fit.Error;
+			EvaluateBC7Subset(Texels, Subset, Count, Mode, End0, End1, Fit);
+			if (Fit.Error >= PreviousError)
+			{
+				break;
+			}
+		}
+	}
+
+	// The anchor index is stored without its top bit, mirror the subset when that bit is set
+	void FixBC7Anchor(const uint8_t* Subset, uint32_t Count, uint32_t Anchor, uint32_t IndexBits, TBC7SubsetFit& Fit)
+	{
+		const uint32_t MaxIndex = (1u << IndexBits) - 1;
+		if (Fit.Indices[Anchor] <= (MaxIndex >> 1))
+		{
+			return;
+		}
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			std::swap(Fit.Endpoints[0][c], Fit.Endpoints[1][c]);
+		}
+		std::swap(Fit.PBits[0], Fit.PBits[1]);
+
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			Fit.Indices[Subset[i]] = (uint8_t)(MaxIndex - Fit.Indices[Subset[i]]);
+		}
+	}
+
+	float EncodeBC7Mode6(const TBlockTexels& Texels, EBlockCompressQuality Quality, uint8_t* Out)
+	{
+		const TBC7SubsetMode Mode = { 0, 4, 7, EBC7PBit::PerEndpoint, 4 };
+
+		TBC7SubsetFit Fit;
+		FitBC7Subset(Texels, BlockIdentity, BlockTexelCount, Mode, GetRefineIterations(Quality, 2, 4), Fit);
+		FixBC7Anchor(BlockIdentity, BlockTexelCount, 0, Mode.IndexBits, Fit);
+
+		TBitWriter Writer(Out, 16);
+		Writer.Write(1 << 6, 7);
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			Writer.Write(Fit.Endpoints[0][c], 7);
+			Writer.Write(Fit.Endpoints[1][c], 7);
+		}
+		Writer.Write(Fit.PBits[0], 1);
+		Writer.Write(Fit.PBits[1], 1);
+
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			Writer.Write(Fit.Indices[i], i == 0 ? 3 : 4);
+		}
+
+		return Fit.Error;
+	}
+
+	float EncodeBC7Mode5(const TBlockTexels& Texels, EBlockCompressQuality Quality, uint8_t* Out)
+	{
+		const TBC7SubsetMode ColorMode = { 0, 3, 7, EBC7PBit::None, 2 };
+		const TBC7SubsetMode AlphaMode = { 3, 1, 8, EBC7PBit::None, 2 };
+		const uint32_t Iterations = GetRefineIterations(Quality, 2, 4);
+
+		TBC7SubsetFit ColorFit;
+		FitBC7Subset(Texels, BlockIdentity, BlockTexelCount, ColorMode, Iterations, ColorFit);
+		FixBC7Anchor(BlockIdentity, BlockTexelCount, 0, ColorMode.IndexBits, ColorFit);
+
+		TBC7SubsetFit AlphaFit;
+		FitBC7Subset(Texels, BlockIdentity, BlockTexelCount, AlphaMode, Iterations, AlphaFit);
+		FixBC7Anchor(BlockIdentity, BlockTexelCount, 0, AlphaMode.IndexBits, AlphaFit);
+
+		TBitWriter Writer(Out, 16);
+		Writer.Write(1 << 5, 6);
+
+		// No channel rotation
+		Writer.Write(0, 2);
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			Writer.Write(ColorFit.Endpoints[0][c], 7);
+			Writer.Write(ColorFit.Endpoints[1][c], 7);
+		}
+		Writer.Write(AlphaFit.Endpoints[0][0], 8);
+		Writer.Write(AlphaFit.Endpoints[1][0], 8);
+
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			Writer.Write(ColorFit.Indices[i], i == 0 ? 1 : 2);
+		}
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			Writer.Write(AlphaFit.Indices[i], i == 0 ? 1 : 2);
+		}
+
+		return ColorFit.Error + AlphaFit.Error;
+	}
+
+	// Opaque blocks only, mode 1 decodes alpha as 255
+	float EncodeBC7Mode1(const TBlockTexels& Texels, EBlockCompressQuality Quality, uint8_t* Out)
+	{
+		const TBC7SubsetMode Mode = { 0, 3, 6, EBC7PBit::Shared, 3 };
+
+		// Rank partitions by how well a line fits each subset, only the best few get a full fit
+		std::pair<float, uint32_t> Ranked[64];
+		for (uint32_t Partition = 0; Partition < 64; Partition++)
+		{
+			uint8_t Subsets[2][16];
+			uint32_t Counts[2] = {};
+			for (uint32_t i = 0; i < BlockTexelCount; i++)
+			{
+				uint32_t SubsetIndex = (BC7Partitions2[Partition] >> i) & 1;
+				Subsets[SubsetIndex][Counts[SubsetIndex]++] = (uint8_t)i;
+			}
+
+			Ranked[Partition].first = ComputeAxisResidual(Texels, Subsets[0], Counts[0], 3) + ComputeAxisResidual(Texels, Subsets[1], Counts[1], 3);
+			Ranked[Partition].second = Partition;
+		}
+
+		const uint32_t CandidateCount = (Quality == EBlockCompressQuality::High) ? 16 : 4;
+		std::partial_sort(Ranked, Ranked + CandidateCount, Ranked + 64);
+
+		float BestError = FLT_MAX;
+		uint32_t BestPartition = 0;
+		TBC7SubsetFit BestFits[2];
+
+		for (uint32_t Candidate = 0; Candidate < CandidateCount; Candidate++)
+		{
+			const uint32_t Partition = Ranked[Candidate].second;
+
+			uint8_t Subsets[2][16];
+			uint32_t Counts[2] = {};
+			for (uint32_t i = 0; i < BlockTexelCount; i++)
+			{
+				uint32_t SubsetIndex = (BC7Partitions2[Partition] >> i) & 1;
+				Subsets[SubsetIndex][Counts[SubsetIndex]++] = (uint8_t)i;
+			}
+
+			TBC7SubsetFit Fits[2];
+			float Error = 0.0f;
+			for (uint32_t s = 0; s < 2; s++)
+			{
+				FitBC7Subset(Texels, Subsets[s], Counts[s], Mode, GetRefineIterations(Quality, 1, 2), Fits[s]);
+				FixBC7Anchor(Subsets[s], Counts[s], s == 0 ? 0 : BC7Anchors2[Partition], Mode.IndexBits, Fits[s]);
+				Error += Fits[s].Error;
+			}
+
+			if (Error < BestError)
+			{
+				BestError = Error;
+				BestPartition = Partition;
+				BestFits[0] = Fits[0];
+				BestFits[1] = Fits[1];
+			}
+		}
+
+		TBitWriter Writer(Out, 16);
+		Writer.Write(1 << 1, 2);
+		Writer.Write(BestPartition, 6);
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			for (uint32_t s = 0; s < 2; s++)
+			{
+				Writer.Write(BestFits[s].Endpoints[0][c], 6);
+				Writer.Write(BestFits[s].Endpoints[1][c], 6);
+			}
+		}
+		Writer.Write(BestFits[0].PBits[0], 1);
+		Writer.Write(BestFits[1].PBits[0], 1);
+
+		const uint32_t Anchor = BC7Anchors2[BestPartition];
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			uint32_t SubsetIndex = (BC7Partitions2[BestPartition] >> i) & 1;
+			Writer.Write(BestFits[SubsetIndex].Indices[i], (i == 0 || i == Anchor) ? 2 : 3);
+		}
+
+		return BestError;
+	}
+
+	void EncodeBC7Block(const TBlockTexels& Texels, EBlockCompressQuality Quality, uint8_t* Out)
+	{
+		bool bOpaque = true;
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			bOpaque = bOpaque && Texels[i][3] >= 255.0f;
+		}
+
+		float BestError = EncodeBC7Mode6(Texels, Quality, Out);
+		if (Quality == EBlockCompressQuality::Fast)
+		{
+			return;
+		}
+
+		uint8_t Candidate[16];
+		float Error = bOpaque ? EncodeBC7Mode1(Texels, Quality, Candidate) : EncodeBC7Mode5(Texels, Quality, Candidate);
+		if (Error < BestError)
+		{
+			memcpy(Out, Candidate, sizeof(Candidate));
+		}
+	}
+
+	bool DecodeBC7Block(const uint8_t* Block, uint8_t OutTexels[16][4])
+	{
+		TBitReader Reader(Block);
+
+		uint32_t ModeIndex = 0;
+		while (ModeIndex < 8 && Reader.Read(1) == 0)
+		{
+			ModeIndex++;
+		}
+
+		if (ModeIndex == 6)
+		{
+			const TBC7SubsetMode Mode = { 0, 4, 7, EBC7PBit::PerEndpoint, 4 };
+
+			uint8_t Stored[2][4];
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				Stored[0][c] = (uint8_t)Reader.Read(7);
+				Stored[1][c] = (uint8_t)Reader.Read(7);
+			}
+
+			uint8_t PBits[2];
+			PBits[0] = (uint8_t)Reader.Read(1);
+			PBits[1] = (uint8_t)Reader.Read(1);
+
+			int Endpoints[2][4];
+			DecodeBC7Endpoints(Mode, Stored, PBits, Endpoints);
+
+			for (uint32_t i = 0; i < BlockTexelCount; i++)
+			{
+				uint32_t Index = Reader.Read(i == 0 ? 3 : 4);
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					OutTexels[i][c] = (uint8_t)BC7Interpolate(Endpoints[0][c], Endpoints[1][c], BC7Weights4[Index]);
+				}
+			}
+
+			return true;
+		}
+		else if (ModeIndex == 5)
+		{
+			uint32_t Rotation = Reader.Read(2);
+
+			const TBC7SubsetMode ColorMode = { 0, 3, 7, EBC7PBit::None, 2 };
+			uint8_t Stored[2][4] = {};
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				Stored[0][c] = (uint8_t)Reader.Read(7);
+				Stored[1][c] = (uint8_t)Reader.Read(7);
+			}
+
+			const uint8_t NoPBits[2] = {};
+			int Endpoints[2][4];
+			DecodeBC7Endpoints(ColorMode, Stored, NoPBits, Endpoints);
+			Endpoints[0][3] = (int)Reader.Read(8);
+			Endpoints[1][3] = (int)Reader.Read(8);
+
+			uint32_t ColorIndices[16];
+			for (uint32_t i = 0; i < BlockTexelCount; i++)
+			{
+				ColorIndices[i] = Reader.Read(i == 0 ? 1 : 2);
+			}
+
+			for (uint32_t i = 0; i < BlockTexelCount; i++)
+			{
+				uint32_t AlphaIndex = Reader.Read(i == 0 ? 1 : 2);
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					OutTexels[i][c] = (uint8_t)BC7Interpolate(Endpoints[0][c], Endpoints[1][c], BC7Weights2[ColorIndices[i]]);
+				}
+				OutTexels[i][3] = (uint8_t)BC7Interpolate(Endpoints[0][3], Endpoints[1][3], BC7Weights2[AlphaIndex]);
+
+				if (Rotation > 0)
+				{
+					std::swap(OutTexels[i][3], OutTexels[i][Rotation - 1]);
+				}
+			}
+
+			return true;
+		}
+		else if (ModeIndex == 1)
+		{
+			const TBC7SubsetMode Mode = { 0, 3, 6, EBC7PBit::Shared, 3 };
+
+			uint32_t Partition = Reader.Read(6);
+
+			uint8_t Stored[2][2][4] = {};
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				for (uint32_t s = 0; s < 2; s++)
+				{
+					Stored[s][0][c] = (uint8_t)Reader.Read(6);
+					Stored[s][1][c] = (uint8_t)Reader.Read(6);
+				}
+			}
+
+			int Endpoints[2][2][4];
+			for (uint32_t s = 0; s < 2; s++)
+			{
+				uint8_t PBit = (uint8_t)Reader.Read(1);
+				const uint8_t PBits[2] = { PBit, PBit };
+				DecodeBC7Endpoints(Mode, Stored[s], PBits, Endpoints[s]);
+			}
+
+			const uint32_t Anchor = BC7Anchors2[Partition];
+			for (uint32_t i = 0; i < BlockTexelCount; i++)
+			{
+				uint32_t SubsetIndex = (BC7Partitions2[Partition] >> i) & 1;
+				uint32_t Index = Reader.Read((i == 0 || i == Anchor) ? 2 : 3);
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					OutTexels[i][c] = (uint8_t)BC7Interpolate(Endpoints[SubsetIndex][0][c], Endpoints[SubsetIndex][1][c], BC7Weights3[Index]);
+				}
+				OutTexels[i][3] = 255;
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+
+	//------------------------------------------------------------------------------------------------
+	// BC6H unsigned, mode 11 (one subset, 10-bit endpoints, 4-bit indices)
+	//------------------------------------------------------------------------------------------------
+
+	// Largest finite half float
+	const uint32_t BC6HMaxHalf = 0x7BFF;
+
+	const uint32_t BC6HEndpointBits = 10;
+
+	int BC6HUnquantize(int Stored)
+	{
+		const int MaxStored = (1 << BC6HEndpointBits) - 1;
+		if (Stored == 0)
+		{
+			return 0;
+		}
+		if (Stored == MaxStored)
+		{
+			return 0xFFFF;
+		}
+
+		return ((Stored << 16) + 0x8000) >> BC6HEndpointBits;
+	}
+
+	// Interpolated values are scaled by 31/64 into half float bits
+	int BC6HFinishUnsigned(int Value)
+	{
+		return (Value * 31) >> 6;
+	}
+
+	int QuantizeBC6HChannel(float HalfBits)
+	{
+		const int MaxStored = (1 << BC6HEndpointBits) - 1;
+		int Guess = (int)(HalfBits * 64.0f / 31.0f * (1 << BC6HEndpointBits) / 65536.0f);
+
+		int Best = 0;
+		float BestDistance = FLT_MAX;
+		for (int Candidate = Guess - 1; Candidate <= Guess + 1; Candidate++)
+		{
+			int Stored = ClampInt(Candidate, 0, MaxStored);
+			float Distance = std::fabs((float)BC6HFinishUnsigned(BC6HUnquantize(Stored)) - HalfBits);
+			if (Distance < BestDistance)
+			{
+				BestDistance = Distance;
+				Best = Stored;
+			}
+		}
+
+		return Best;
+	}
+
+	struct TBC6HBlock
+	{
+		int Endpoints[2][3] = {};
+
+		uint8_t Indices[16] = {};
+
+		float Error = FLT_MAX;
+	};
+
+	// Errors are measured on half float bits, roughly logarithmic like the eye
+	void EvaluateBC6H(const TBlockTexels& Texels, const float End0[4], const float End1[4], TBC6HBlock& Best)
+	{
+		TBC6HBlock Block;
+		int Unquantized[2][3];
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			Block.Endpoints[0][c] = QuantizeBC6HChannel(End0[c]);
+			Block.Endpoints[1][c] = QuantizeBC6HChannel(End1[c]);
+			Unquantized[0][c] = BC6HUnquantize(Block.Endpoints[0][c]);
+			Unquantized[1][c] = BC6HUnquantize(Block.Endpoints[1][c]);
+		}
+
+		int Palette[16][3];
+		for (uint32_t Entry = 0; Entry < 16; Entry++)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				Palette[Entry][c] = BC6HFinishUnsigned(BC7Interpolate(Unquantized[0][c], Unquantized[1][c], BC7Weights4[Entry]));
+			}
+		}
+
+		Block.Error = 0.0f;
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			float BestDistance = FLT_MAX;
+			for (uint32_t Entry = 0; Entry < 16; Entry++)
+			{
+				float Distance = Square(Texels[i][0] - Palette[Entry][0]) + Square(Texels[i][1] - Palette[Entry][1]) + Square(Texels[i][2] - Palette[Entry][2]);
+				if (Distance < BestDistance)
+				{
+					BestDistance = Distance;
+					Block.Indices[i] = (uint8_t)Entry;
+				}
+			}
+
+			Block.Error += BestDistance;
+		}
+
+		if (Block.Error < Best.Error)
+		{
+			Best = Block;
+		}
+	}
+
+	void EncodeBC6HBlock(const TBlockTexels& Texels, EBlockCompressQuality Quality, uint8_t* Out)
+	{
+		float End0[4];
+		float End1[4];
+		ComputeAxisEndpoints(Texels, BlockIdentity, BlockTexelCount, 0, 3, (float)BC6HMaxHalf, End0, End1);
+
+		TBC6HBlock Best;
+		EvaluateBC6H(Texels, End0, End1, Best);
+
+		const uint32_t Iterations = GetRefineIterations(Quality, 2, 4);
+		for (uint32_t Iteration = 0; Iteration < Iterations; Iteration++)
+		{
+			float Weights[16];
+			for (uint32_t i = 0; i < BlockTexelCount; i++)
+			{
+				Weights[i] = BC7Weights4[Best.Indices[i]] / 64.0f;
+			}
+
+			if (!SolveLeastSquares(Texels, BlockIdentity, BlockTexelCount, 0, 3, Weights, End0, End1))
+			{
+				break;
+			}
+
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				End0[c] = std::min<float>(std::max<float>(End0[c], 0.0f), (float)BC6HMaxHalf);
+				End1[c] = std::min<float>(std::max<float>(End1[c], 0.0f), (float)BC6HMaxHalf);
+			}
+
+			const float PreviousError = Best.Error;
+			EvaluateBC6H(Texels, End0, End1, Best);
+			if (Best.Error >= PreviousError)
+			{
+				break;
+			}
+		}
+
+		// Texel 0 index is stored without its top bit
+		if (Best.Indices[0] > 7)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				std::swap(Best.Endpoints[0][c], Best.Endpoints[1][c]);
+			}
+
+			for (uint32_t i = 0; i < BlockTexelCount; i++)
+			{
+				Best.Indices[i] = (uint8_t)(15 - Best.Indices[i]);
+			}
+		}
+
+		TBitWriter Writer(Out, 16);
+		Writer.Write(0x03, 5);
+		for (uint32_t e = 0; e < 2; e++)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				Writer.Write((uint32_t)Best.Endpoints[e][c], BC6HEndpointBits);
+			}
+		}
+
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			Writer.Write(Best.Indices[i], i == 0 ? 3 : 4);
+		}
+	}
+
+	//------------------------------------------------------------------------------------------------
+	// Image level
+	//------------------------------------------------------------------------------------------------
+
+	bool IsHDRFormat(EDecodedImageFormat Format)
+	{
+		return Format == EDecodedImageFormat::RGB32F || Format == EDecodedImageFormat::R9G9B9E5 || Format == EDecodedImageFormat::R11G11B10;
+	}
+
+	// RGB of texel X in a row of an HDR image, clamped to the BC6H unsigned range [0, 65504], NaN becomes 0
+	void ReadHDRTexel(EDecodedImageFormat Format, const uint8_t* Row, uint32_t X, float OutRGB[3])
+	{
+		if (Format == EDecodedImageFormat::RGB32F)
+		{
+			const float* Pixel = reinterpret_cast<const float*>(Row) + X * 3;
+			OutRGB[0] = Pixel[0];
+			OutRGB[1] = Pixel[1];
+			OutRGB[2] = Pixel[2];
+		}
+		else
+		{
+			uint32_t Packed;
+			memcpy(&Packed, Row + X * 4, sizeof(Packed));
+
+			if (Format == EDecodedImageFormat::R9G9B9E5)
+			{
+				UnpackR9G9B9E5(Packed, OutRGB);
+			}
+			else
+			{
+				UnpackR11G11B10(Packed, OutRGB);
+			}
+		}
+
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			OutRGB[c] = (OutRGB[c] > 0.0f) ? std::min<float>(OutRGB[c], 65504.0f) : 0.0f;
+		}
+	}
+
+	// Gather a 4x4 block, texels past the image edge repeat the last row and column
+	void FetchBlock(const TDecodedImage& Image, const TDecodedMip& Level, uint32_t BlockX, uint32_t BlockY, TBlockTexels& OutTexels)
+	{
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			const uint32_t SrcY = std::min<uint32_t>(BlockY * 4 + y, Level.Height - 1);
+			const uint8_t* Row = Image.Data.data() + Level.Offset + (size_t)SrcY * Level.RowPitch;
+
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				const uint32_t SrcX = std::min<uint32_t>(BlockX * 4 + x, Level.Width - 1);
+				float* Texel = OutTexels[y * 4 + x];
+
+				switch (Image.Format)
+				{
+				case EDecodedImageFormat::R8:
+					Texel[0] = Texel[1] = Texel[2] = Row[SrcX];
+					Texel[3] = 255.0f;
+					break;
+				case EDecodedImageFormat::RGBA8:
+					for (uint32_t c = 0; c < 4; c++)
+					{
+						Texel[c] = Row[SrcX * 4 + c];
+					}
+					break;
+				case EDecodedImageFormat::RGB32F:
+				case EDecodedImageFormat::R9G9B9E5:
+				case EDecodedImageFormat::R11G11B10:
+				{
+					float RGB[3];
+					ReadHDRTexel(Image.Format, Row, SrcX, RGB);
+					for (uint32_t c = 0; c < 3; c++)
+					{
+						Texel[c] = (float)THalfFloat::FromFloat(RGB[c]);
+					}
+					Texel[3] = 0.0f;
+					break;
+				}
+				}
+			}
+		}
+	}
+
+	void EncodeBlock(EBlockFormat Format, const TBlockTexels& Texels, EBlockCompressQuality Quality, uint8_t* Out)
+	{
+		float Channel[16];
+
+		switch (Format)
+		{
+		case EBlockFormat::BC1:
+			EncodeBC1Block(Texels, Quality, false, Out);
+			break;
+		case EBlockFormat::BC3:
+			for (uint32_t i = 0; i < BlockTexelCount; i++)
+			{
+				Channel[i] = Texels[i][3];
+			}
+			EncodeBC4Block(Channel, Quality, Out);
+			EncodeBC1Block(Texels, Quality, true, Out + 8);
+			break;
+		case EBlockFormat::BC4:
+			for (uint32_t i = 0; i < BlockTexelCount; i++)
+			{
+				Channel[i] = Texels[i][0];
+			}
+			EncodeBC4Block(Channel, Quality, Out);
+			break;
+		case EBlockFormat::BC5:
+			for (uint32_t c = 0; c < 2; c++)
+			{
+				for (uint32_t i = 0; i < BlockTexelCount; i++)
+				{
+					Channel[i] = Texels[i][c];
+				}
+				EncodeBC4Block(Channel, Quality, Out + c * 8);
+			}
+			break;
+		case EBlockFormat::BC6H:
+			EncodeBC6HBlock(Texels, Quality, Out);
+			break;
+		case EBlockFormat::BC7:
+			EncodeBC7Block(Texels, Quality, Out);
+			break;
+		}
+	}
+
+	uint32_t GetErrorChannelCount(EBlockFormat Format)
+	{
+		switch (Format)
+		{
+		case EBlockFormat::BC4:
+			return 1;
+		case EBlockFormat::BC5:
+			return 2;
+		case EBlockFormat::BC1:
+		case EBlockFormat::BC6H:
+			return 3;
+		default:
+			return 4;
+		}
+	}
+
+	// Squared error of one decoded block over the texels inside the image, BC6H in linear float
+	double MeasureBlockError(EBlockFormat Format, const uint8_t* Block, const TDecodedImage& Image, const TDecodedMip& Level,
+		uint32_t BlockX, uint32_t BlockY, float& InOutPeak)
+	{
+		const uint32_t ChannelCount = GetErrorChannelCount(Format);
+
+		float HDRTexels[16][3];
+		uint8_t LDRTexels[16][4];
+		if (Format == EBlockFormat::BC6H)
+		{
+			DecodeBlockHDR(Block, HDRTexels);
+		}
+		else
+		{
+			DecodeBlockLDR(Format, Block, LDRTexels);
+		}
+
+		double Error = 0.0;
+		for (uint32_t y = 0; y < 4 && BlockY * 4 + y < Level.Height; y++)
+		{
+			const uint8_t* Row = Image.Data.data() + Level.Offset + (size_t)(BlockY * 4 + y) * Level.RowPitch;
+
+			for (uint32_t x = 0; x < 4 && BlockX * 4 + x < Level.Width; x++)
+			{
+				const uint32_t SrcX = BlockX * 4 + x;
+				const uint32_t Texel = y * 4 + x;
+
+				float SourceHDR[3] = { 0.0f, 0.0f, 0.0f };
+				if (Format == EBlockFormat::BC6H)
+				{
+					ReadHDRTexel(Image.Format, Row, SrcX, SourceHDR);
+				}
+
+				for (uint32_t c = 0; c < ChannelCount; c++)
+				{
+					double Source;
+					double Decoded;
+					if (Format == EBlockFormat::BC6H)
+					{
+						Source = SourceHDR[c];
+						Decoded = HDRTexels[Texel][c];
+						InOutPeak = std::max<float>(InOutPeak, (float)Source);
+					}
+					else
+					{
+						if (Image.Format == EDecodedImageFormat::R8)
+						{
+							Source = (c < 3) ? Row[SrcX] : 255;
+						}
+						else
+						{
+							Source = Row[SrcX * 4 + c];
+						}
+						Decoded = LDRTexels[Texel][c];
+					}
+
+					Error += (Source - Decoded) * (Source - Decoded);
+				}
+			}
+		}
+
+		return Error;
+	}
+}
+
+std::string TBlockCompressStats::ToString() const
+{
+	char Buffer[256];
+	snprintf(Buffer, sizeof(Buffer), "%s: %.2f MB -> %.2f MB (%.1fx), %zu mips, mip 0 PSNR %.2f dB, %.2fs",
+		GetBlockFormatName(Format), SourceBytes / (1024.0 * 1024.0), CompressedBytes / (1024.0 * 1024.0),
+		CompressedBytes > 0 ? (double)SourceBytes / CompressedBytes : 0.0, MipPSNR.size(), MipPSNR.empty() ? 0.0 : MipPSNR[0], Seconds);
+
+	return std::string(Buffer);
+}
+
+uint32_t GetBlockBytes(EBlockFormat Format)
+{
+	return (Format == EBlockFormat::BC1 || Format == EBlockFormat::BC4) ? 8 : 16;
+}
+
+uint32_t GetBlockDxgiFormat(EBlockFormat Format, bool bSRGB)
+{
+	switch (Format)
+	{
+	case EBlockFormat::BC1:
+		return bSRGB ? 72 : 71;  // DXGI_FORMAT_BC1_UNORM(_SRGB)
+	case EBlockFormat::BC3:
+		return bSRGB ? 78 : 77;  // DXGI_FORMAT_BC3_UNORM(_SRGB)
+	case EBlockFormat::BC4:
+		return 80;               // DXGI_FORMAT_BC4_UNORM
+	case EBlockFormat::BC5:
+		return 83;               // DXGI_FORMAT_BC5_UNORM
+	case EBlockFormat::BC6H:
+		return 95;               // DXGI_FORMAT_BC6H_UF16
+	default:
+		return bSRGB ? 99 : 98;  // DXGI_FORMAT_BC7_UNORM(_SRGB)
+	}
+}
+
+const char* GetBlockFormatName(EBlockFormat Format)
+{
+	switch (Format)
+	{
+	case EBlockFormat::BC1:
+		return "BC1";
+	case EBlockFormat::BC3:
+		return "BC3";
+	case EBlockFormat::BC4:
+		return "BC4";
+	case EBlockFormat::BC5:
+		return "BC5";
+	case EBlockFormat::BC6H:
+		return "BC6H";
+	default:
+		return "BC7";
+	}
+}
+
+bool DecodeBlockLDR(EBlockFormat Format, const uint8_t* Block, uint8_t OutTexels[16][4])
+{
+	switch (Format)
+	{
+	case EBlockFormat::BC1:
+		DecodeBC1Colors(Block, false, OutTexels);
+		return true;
+	case EBlockFormat::BC3:
+		DecodeBC1Colors(Block + 8, true, OutTexels);
+		DecodeBC4Values(Block, OutTexels, 3);
+		return true;
+	case EBlockFormat::BC4:
+	case EBlockFormat::BC5:
+		for (uint32_t i = 0; i < BlockTexelCount; i++)
+		{
+			OutTexels[i][1] = OutTexels[i][2] = 0;
+			OutTexels[i][3] = 255;
+		}
+		DecodeBC4Values(Block, OutTexels, 0);
+		if (Format == EBlockFormat::BC5)
+		{
+			DecodeBC4Values(Block + 8, OutTexels, 1);
+		}
+		return true;
+	case EBlockFormat::BC7:
+		return DecodeBC7Block(Block, OutTexels);
+	default:
+		return false;
+	}
+}
+
+bool DecodeBlockHDR(const uint8_t* Block, float OutTexels[16][3])
+{
+	TBitReader Reader(Block);
+
+	// Mode 11, unsigned
+	if (Reader.Read(5) != 0x03)
+	{
+		return false;
+	}
+
+	int Unquantized[2][3];
+	for (uint32_t e = 0; e < 2; e++)
+	{
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			Unquantized[e][c] = BC6HUnquantize((int)Reader.Read(BC6HEndpointBits));
+		}
+	}
+
+	for (uint32_t i = 0; i < BlockTexelCount; i++)
+	{
+		uint32_t Index = Reader.Read(i == 0 ? 3 : 4);
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			int Half = BC6HFinishUnsigned(BC7Interpolate(Unquantized[0][c], Unquantized[1][c], BC7Weights4[Index]));
+			OutTexels[i][c] = THalfFloat::ToFloat((uint16_t)Half);
+		}
+	}
+
+	return true;
+}
+
+bool CompressImage(const TDecodedImage& Image, const TBlockCompressSettings& Settings, TThreadPool& ThreadPool,
+	TCompressedImage& OutImage, TBlockCompressStats* OutStats)
+{
+	typedef std::chrono::steady_clock TClock;
+	TClock::time_point StartTime = TClock::now();
+
+	const bool bHDR = IsHDRFormat(Image.Format);
+	if (bHDR != (Settings.Format == EBlockFormat::BC6H) || Image.Width == 0 || Image.Height == 0)
+	{
+		return false;
+	}
+
+	std::vector<TDecodedMip> Levels = Image.Mips;
+	if (Levels.empty())
+	{
+		TDecodedMip Level;
+		Level.Width = Image.Width;
+		Level.Height = Image.Height;
+		Level.RowPitch = Image.RowPitch;
+		Level.Offset = 0;
+		Levels.push_back(Level);
+	}
+
+	OutImage = TCompressedImage();
+	OutImage.Width = Image.Width;
+	OutImage.Height = Image.Height;
+	OutImage.Format = Settings.Format;
+	OutImage.bSRGB = Settings.bSRGB;
+
+	const uint32_t BlockBytes = GetBlockBytes(Settings.Format);
+
+	size_t DataSize = 0;
+	for (const TDecodedMip& Level : Levels)
+	{
+		TCompressedMip Mip;
+		Mip.Width = Level.Width;
+		Mip.Height = Level.Height;
+		Mip.RowPitch = std::max<uint32_t>((Level.Width + 3) / 4, 1) * BlockBytes;
+		Mip.Offset = DataSize;
+		Mip.Size = (size_t)Mip.RowPitch * std::max<uint32_t>((Level.Height + 3) / 4, 1);
+
+		DataSize += Mip.Size;
+		OutImage.Mips.push_back(Mip);
+	}
+	OutImage.Data.resize(DataSize);
+
+	const bool bMeasureError = Settings.bMeasureError && OutStats != nullptr;
+	const uint32_t ErrorChannelCount = GetErrorChannelCount(Settings.Format);
+
+	std::vector<double> MipPSNR;
+	for (size_t LevelIndex = 0; LevelIndex < Levels.size(); LevelIndex++)
+	{
+		const TDecodedMip& Level = Levels[LevelIndex];
+		const TCompressedMip& Mip = OutImage.Mips[LevelIndex];
+		const uint32_t BlockCountX = (Level.Width + 3) / 4;
+		const uint32_t BlockCountY = (Level.Height + 3) / 4;
+
+		// One slot per block row so the error sum needs no lock
+		std::vector<double> RowErrors(BlockCountY, 0.0);
+		std::vector<float> RowPeaks(BlockCountY, 0.0f);
+
+		ThreadPool.ParallelFor(BlockCountY, [&](uint32_t BlockY)
+		{
+			uint8_t* Row = OutImage.Data.data() + Mip.Offset + (size_t)BlockY * Mip.RowPitch;
+
+			for (uint32_t BlockX = 0; BlockX < BlockCountX; BlockX++)
+			{
+				TBlockTexels Texels;
+				FetchBlock(Image, Level, BlockX, BlockY, Texels);
+
+				uint8_t* Block = Row + (size_t)BlockX * BlockBytes;
+				EncodeBlock(Settings.Format, Texels, Settings.Quality, Block);
+
+				if (bMeasureError)
+				{
+					RowErrors[BlockY] += MeasureBlockError(Settings.Format, Block, Image, Level, BlockX, BlockY, RowPeaks[BlockY]);
+				}
+			}
+		});
+
+		if (bMeasureError)
+		{
+			double Error = 0.0;
+			float Peak = bHDR ? 0.0f : 255.0f;
+			for (uint32_t BlockY = 0; BlockY < BlockCountY; BlockY++)
+			{
+				Error += RowErrors[BlockY];
+				Peak = std::max<float>(Peak, RowPeaks[BlockY]);
+			}
+
+			const double MeanSquaredError = Error / ((double)Level.Width * Level.Height * ErrorChannelCount);
+			MipPSNR.push_back(MeanSquaredError > 0.0 && Peak > 0.0f ? 10.0 * std::log10((double)Peak * Peak / MeanSquaredError) : std::numeric_limits<double>::infinity());
+		}
+	}
+
+	if (OutStats)
+	{
+		OutStats->Format = Settings.Format;
+		OutStats->MipPSNR = MipPSNR;
+		OutStats->SourceBytes = Image.Data.size();
+		OutStats->CompressedBytes = OutImage.Data.size();
+		OutStats->Seconds = std::chrono::duration<double>(TClock::now() - StartTime).count();
+	}
+
+	return true;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ImageDecoder.h"
+
+class TThreadPool;
+
+// BC7 and BC6H are only partially covered: BC7 blocks use modes 1, 5 and 6 and BC6H blocks use mode 11, one subset
+// with 10-bit endpoints. Blocks that need the other partitions or precisions lose quality against a full encoder.
+enum class EBlockFormat
+{
+	BC1,  // RGB, 1-bit alpha unused, 8 bytes per block
+	BC3,  // RGBA, 16 bytes per block
+	BC4,  // R, 8 bytes per block
+	BC5,  // RG, 16 bytes per block
+	BC6H, // Unsigned half float RGB, 16 bytes per block
+	BC7,  // RGBA, 16 bytes per block
+};
+
+enum class EBlockCompressQuality
+{
+	// Bounding box endpoints, no refinement
+	Fast,
+
+	// Principal axis endpoints refined by least squares, a few BC7 partitions
+	Normal,
+
+	// More refinement iterations, wider BC4 search, BC1 3-color blocks and more BC7 partitions
+	High,
+};
+
+struct TBlockCompressSettings
+{
+	EBlockFormat Format = EBlockFormat::BC7;
+
+	EBlockCompressQuality Quality = EBlockCompressQuality::Normal;
+
+	// Only selects the _SRGB DXGI format, blocks are fitted on the stored sRGB values
+	bool bSRGB = false;
+
+	// Decode every block again and measure the error against the source
+	bool bMeasureError = true;
+};
+
+struct TCompressedMip
+{
+	uint32_t Width = 0;
+
+	uint32_t Height = 0;
+
+	// Bytes per row of 4x4 blocks
+	uint32_t RowPitch = 0;
+
+	size_t Offset = 0;
+
+	size_t Size = 0;
+};
+
+struct TCompressedImage
+{
+	uint32_t Width = 0;
+
+	uint32_t Height = 0;
+
+	EBlockFormat Format = EBlockFormat::BC7;
+
+	bool bSRGB = false;
+
+	// Every mip level, packed back to back
+	std::vector<uint8_t> Data;
+
+	std::vector<TCompressedMip> Mips;
+};
+
+struct TBlockCompressStats
+{
+	EBlockFormat Format = EBlockFormat::BC7;
+
+	// Per mip. LDR formats use a peak of 255 over the channels the format stores, BC6H uses the brightest source value.
+	std::vector<double> MipPSNR;
+
+	uint64_t SourceBytes = 0;
+
+	uint64_t CompressedBytes = 0;
+
+	double Seconds = 0.0;
+
+	std::string ToString() const;
+};
+
+uint32_t GetBlockBytes(EBlockFormat Format);
+
+// Numeric DXGI_FORMAT, kept as an integer so the compressor builds without the Windows SDK
+uint32_t GetBlockDxgiFormat(EBlockFormat Format, bool bSRGB);
+
+const char* GetBlockFormatName(EBlockFormat Format);
+
+// Compress every mip of Image, block rows are split across the thread pool.
+// BC6H takes RGB32F, R9G9B9E5 or R11G11B10 images, the other formats take R8 or RGBA8 (BC4 reads red, BC5 red and green).
+bool CompressImage(const TDecodedImage& Image, const TBlockCompressSettings& Settings, TThreadPool& ThreadPool,
+	TCompressedImage& OutImage, TBlockCompressStats* OutStats = nullptr);
+
+// Decode one block to 16 RGBA texels, row by row. Only the BC7 modes (1, 5, 6) and BC6H mode (11) the encoder writes are
+// supported, false for the others.
+bool DecodeBlockLDR(EBlockFormat Format, const uint8_t* Block, uint8_t OutTexels[16][4]);
+
+bool DecodeBlockHDR(const uint8_t* Block, float OutTexels[16][3]);
@@ -0,0 +1,320 @@
+#include "BlockCompressor.h"
+#include "DDSWriter.h"
+#include "MipGenerator.h"
+#include "Utils/ThreadPool.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+// Compresses a fixed synthetic image and its mips with every format and quality, decodes the blocks again and checks
+// the top mip's PSNR against a per format floor. The small mips squeeze the whole image into a block or two and are
+// only reported. Each format is then written through SaveCompressedDDS and the file is parsed back.
+// Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	// Not a multiple of 4, so the edge blocks repeat their last row and column
+	const uint32_t ImageWidth = 70;
+
+	const uint32_t ImageHeight = 54;
+
+	// Smooth gradients, a hard edged checker, a disc in alpha and a little noise
+	TDecodedImage MakeLDRImage()
+	{
+		TDecodedImage Image;
+		Image.Width = ImageWidth;
+		Image.Height = ImageHeight;
+		Image.Format = EDecodedImageFormat::RGBA8;
+		Image.RowPitch = ImageWidth * 4;
+		Image.Data.resize((size_t)Image.RowPitch * ImageHeight);
+
+		std::mt19937 Random(1);
+		for (uint32_t y = 0; y < ImageHeight; y++)
+		{
+			for (uint32_t x = 0; x < ImageWidth; x++)
+			{
+				uint8_t* Texel = Image.Data.data() + (size_t)y * Image.RowPitch + x * 4;
+				const int Noise = (int)(Random() % 9) - 4;
+
+				if (x >= 40 && y >= 24)
+				{
+					const bool bWhite = ((x / 3) + (y / 3)) % 2 == 0;
+					Texel[0] = bWhite ? 230 : 20;
+					Texel[1] = bWhite ? 220 : 40;
+					Texel[2] = bWhite ? 200 : 90;
+				}
+				else
+				{
+					Texel[0] = (uint8_t)std::min<int>(std::max<int>(x * 255 / ImageWidth + Noise, 0), 255);
+					Texel[1] = (uint8_t)std::min<int>(std::max<int>(y * 255 / ImageHeight + Noise, 0), 255);
+					Texel[2] = (uint8_t)(128 + 100 * std::sin(x * 0.2f) * std::cos(y * 0.15f));
+				}
+
+				const float DX = x - ImageWidth * 0.5f;
+				const float DY = y - ImageHeight * 0.5f;
+				Texel[3] = (DX * DX + DY * DY < 400.0f) ? 255 : (uint8_t)std::min<float>(std::sqrt(DX * DX + DY * DY) * 3.0f, 200.0f);
+			}
+		}
+
+		return Image;
+	}
+
+	// Sky-like range from 0.01 to a few thousand, a bright sun and some saturated color
+	TDecodedImage MakeHDRImage()
+	{
+		TDecodedImage Image;
+		Image.Width = ImageWidth;
+		Image.Height = ImageHeight;
+		Image.Format = EDecodedImageFormat::RGB32F;
+		Image.RowPitch = ImageWidth * 3 * sizeof(float);
+		Image.Data.resize((size_t)Image.RowPitch * ImageHeight);
+
+		for (uint32_t y = 0; y < ImageHeight; y++)
+		{
+			for (uint32_t x = 0; x < ImageWidth; x++)
+			{
+				float* Texel = reinterpret_cast<float*>(Image.Data.data() + (size_t)y * Image.RowPitch) + x * 3;
+
+				const float Sky = std::exp2((float)y / ImageHeight * -8.0f) * 4.0f;
+				Texel[0] = Sky * 0.6f;
+				Texel[1] = Sky * 0.8f + 0.01f;
+				Texel[2] = Sky * (1.0f + 0.5f * std::sin(x * 0.1f));
+
+				const float DX = x - 20.0f;
+				const float DY = y - 10.0f;
+				if (DX * DX + DY * DY < 16.0f)
+				{
+					Texel[0] = 3000.0f;
+					Texel[1] = 2800.0f;
+					Texel[2] = 2500.0f;
+				}
+			}
+		}
+
+		return Image;
+	}
+
+	uint32_t GetStoredChannelCount(EBlockFormat Format)
+	{
+		switch (Format)
+		{
+		case EBlockFormat::BC1:
+		case EBlockFormat::BC6H:
+			return 3;
+		case EBlockFormat::BC4:
+			return 1;
+		case EBlockFormat::BC5:
+			return 2;
+		default:
+			return 4;
+		}
+	}
+
+	// PSNR of one mip from the decoded blocks, independent of the stats CompressImage measures
+	double MeasureMipPSNR(const TDecodedImage& Image, const TCompressedImage& Compressed, size_t MipIndex)
+	{
+		const TCompressedMip& Mip = Compressed.Mips[MipIndex];
+		const TDecodedMip Level = Image.Mips.empty() ? TDecodedMip{ Image.Width, Image.Height, Image.RowPitch, 0 } : Image.Mips[MipIndex];
+		const uint32_t ChannelCount = GetStoredChannelCount(Compressed.Format);
+		const bool bHDR = Compressed.Format == EBlockFormat::BC6H;
+
+		double ErrorSum = 0.0;
+		float Peak = bHDR ? 0.0f : 255.0f;
+		for (uint32_t y = 0; y < Mip.Height; y++)
+		{
+			for (uint32_t x = 0; x < Mip.Width; x++)
+			{
+				const uint8_t* Block = Compressed.Data.data() + Mip.Offset + (size_t)(y / 4) * Mip.RowPitch + (x / 4) * GetBlockBytes(Compressed.Format);
+				const uint32_t Texel = (y % 4) * 4 + x % 4;
+				const uint8_t* SourceRow = Image.Data.data() + Level.Offset + (size_t)y * Level.RowPitch;
+
+				float HDRTexels[16][3];
+				uint8_t LDRTexels[16][4];
+				if (bHDR)
+				{
+					DecodeBlockHDR(Block, HDRTexels);
+				}
+				else
+				{
+					DecodeBlockLDR(Compressed.Format, Block, LDRTexels);
+				}
+
+				for (uint32_t c = 0; c < ChannelCount; c++)
+				{
+					double Decoded;
+					double Source;
+					if (bHDR)
+					{
+						Decoded = HDRTexels[Texel][c];
+						Source = reinterpret_cast<const float*>(SourceRow)[x * 3 + c];
+						Peak = std::max<float>(Peak, (float)Source);
+					}
+					else
+					{
+						Decoded = LDRTexels[Texel][c];
+						Source = SourceRow[x * 4 + c];
+					}
+
+					ErrorSum += (Decoded - Source) * (Decoded - Source);
+				}
+			}
+		}
+
+		const double MeanSquaredError = ErrorSum / ((double)Mip.Width * Mip.Height * ChannelCount);
+
+		return MeanSquaredError > 0.0 ? 10.0 * std::log10((double)Peak * Peak / MeanSquaredError) : 99.0;
+	}
+
+	uint32_t ReadUInt32(const std::vector<uint8_t>& File, size_t Offset)
+	{
+		uint32_t Value = 0;
+		if (Offset + 4 <= File.size())
+		{
+			memcpy(&Value, File.data() + Offset, 4);
+		}
+
+		return Value;
+	}
+
+	// Parse the header fields DDSTextureLoader reads and compare the payload
+	void TestDDSRoundTrip(const TCompressedImage& Compressed, uint32_t ExpectedDxgiFormat)
+	{
+		const std::filesystem::path FilePath = std::filesystem::temp_directory_path() / "BlockCompressorTest.dds";
+		Check(SaveCompressedDDS(FilePath.wstring(), Compressed), "DDS: the file is written");
+
+		std::ifstream File(FilePath, std::ios::in | std::ios::binary);
+		const std::vector<uint8_t> Bytes((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+		File.close();
+		std::filesystem::remove(FilePath);
+
+		// Magic, DDS_HEADER, DDS_HEADER_DXT10, then the mips
+		const size_t DataOffset = 4 + 124 + 20;
+		const uint32_t MipCount = (uint32_t)Compressed.Mips.size();
+
+		Check(Bytes.size() == DataOffset + Compressed.Data.size(), "DDS: file size is the headers plus every mip");
+		Check(ReadUInt32(Bytes, 0) == 0x20534444, "DDS: magic");
+		Check(ReadUInt32(Bytes, 4) == 124 && ReadUInt32(Bytes, 4 + 72) == 32, "DDS: header and pixel format sizes");
+
+		const uint32_t Flags = ReadUInt32(Bytes, 8);
+		Check((Flags & 0x1007) == 0x1007 && (Flags & 0x80000) != 0 && ((Flags & 0x20000) != 0) == (MipCount > 1), "DDS: header flags");
+		Check(ReadUInt32(Bytes, 12) == Compressed.Height && ReadUInt32(Bytes, 16) == Compressed.Width, "DDS: height and width");
+		Check(ReadUInt32(Bytes, 20) == Compressed.Mips[0].Size, "DDS: linear size of the top mip");
+		Check(ReadUInt32(Bytes, 28) == MipCount, "DDS: mip count");
+		Check((ReadUInt32(Bytes, 80) & 0x4) != 0 && ReadUInt32(Bytes, 84) == 0x30315844, "DDS: DX10 FourCC");
+		Check(((ReadUInt32(Bytes, 108) & 0x400008) != 0) == (MipCount > 1), "DDS: mipmap caps");
+
+		Check(ReadUInt32(Bytes, 128) == ExpectedDxgiFormat, "DDS: DXGI format");
+		Check(ReadUInt32(Bytes, 132) == 3 && ReadUInt32(Bytes, 140) == 1, "DDS: 2D texture with one array slice");
+		Check(Bytes.size() >= DataOffset && memcmp(Bytes.data() + DataOffset, Compressed.Data.data(), Compressed.Data.size()) == 0,
+			"DDS: mip data follows the headers unchanged");
+	}
+
+	struct TFormatCase
+	{
+		EBlockFormat Format;
+
+		bool bSRGB;
+
+		// DXGI_FORMAT value written to the DX10 header
+		uint32_t DxgiFormat;
+
+		// Lowest PSNR accepted on the top mip, at Fast quality and at Normal or High
+		double MinFastPSNR;
+
+		double MinPSNR;
+	};
+}
+
+int main()
+{
+	TThreadPool ThreadPool;
+
+	TMipGenSettings MipSettings;
+	TDecodedImage LDRImage = MakeLDRImage();
+	GenerateMips(LDRImage, MipSettings, ThreadPool);
+
+	TDecodedImage HDRImage = MakeHDRImage();
+	GenerateMips(HDRImage, MipSettings, ThreadPool);
+
+	const TFormatCase Cases[] = {
+		{ EBlockFormat::BC1, false, 71, 29.0, 35.0 },
+		{ EBlockFormat::BC1, true, 72, 29.0, 35.0 },
+		{ EBlockFormat::BC3, false, 77, 30.0, 36.0 },
+		{ EBlockFormat::BC4, false, 80, 50.0, 52.0 },
+		{ EBlockFormat::BC5, false, 83, 50.0, 51.5 },
+		{ EBlockFormat::BC6H, false, 95, 57.0, 57.0 },
+		{ EBlockFormat::BC7, false, 98, 29.0, 38.5 },
+		{ EBlockFormat::BC7, true, 99, 29.0, 38.5 },
+	};
+
+	const EBlockCompressQuality Qualities[] = { EBlockCompressQuality::Fast, EBlockCompressQuality::Normal, EBlockCompressQuality::High };
+	const char* QualityNames[] = { "Fast", "Normal", "High" };
+
+	for (const TFormatCase& Case : Cases)
+	{
+		const TDecodedImage& Image = (Case.Format == EBlockFormat::BC6H) ? HDRImage : LDRImage;
+
+		for (int QualityIndex = 0; QualityIndex < 3; QualityIndex++)
+		{
+			TBlockCompressSettings Settings;
+			Settings.Format = Case.Format;
+			Settings.Quality = Qualities[QualityIndex];
+			Settings.bSRGB = Case.bSRGB;
+
+			TCompressedImage Compressed;
+			TBlockCompressStats Stats;
+			const bool bCompressed = CompressImage(Image, Settings, ThreadPool, Compressed, &Stats);
+			Check(bCompressed && Compressed.Mips.size() == Image.Mips.size(), "compress: every mip is compressed");
+			if (!bCompressed)
+			{
+				continue;
+			}
+
+			double MinPSNR = 99.0;
+			bool bStatsAgree = Stats.MipPSNR.size() == Compressed.Mips.size();
+			for (size_t MipIndex = 0; MipIndex < Compressed.Mips.size(); MipIndex++)
+			{
+				const double PSNR = MeasureMipPSNR(Image, Compressed, MipIndex);
+				MinPSNR = std::min<double>(MinPSNR, PSNR);
+				bStatsAgree &= MipIndex < Stats.MipPSNR.size() && (std::fabs(Stats.MipPSNR[MipIndex] - PSNR) < 0.01 || (PSNR >= 99.0 && Stats.MipPSNR[MipIndex] > 99.0));
+			}
+
+			printf("%s%s %-6s: top mip %.2f dB, lowest mip %.2f dB, %.1f ms\n", GetBlockFormatName(Case.Format), Case.bSRGB ? " sRGB" : "",
+				QualityNames[QualityIndex], Stats.MipPSNR.empty() ? 0.0 : Stats.MipPSNR[0], MinPSNR, Stats.Seconds * 1000.0);
+
+			Check(bStatsAgree, "compress: the reported PSNR matches the decoded blocks");
+			Check(!Stats.MipPSNR.empty() && Stats.MipPSNR[0] >= (QualityIndex == 0 ? Case.MinFastPSNR : Case.MinPSNR), "compress: top mip PSNR above the format's floor");
+
+			if (QualityIndex == 1)
+			{
+				TestDDSRoundTrip(Compressed, Case.DxgiFormat);
+			}
+		}
+	}
+
+	// Mismatched inputs are rejected
+	TCompressedImage Compressed;
+	TBlockCompressSettings Settings;
+	Settings.Format = EBlockFormat::BC6H;
+	Check(!CompressImage(LDRImage, Settings, ThreadPool, Compressed), "compress: BC6H rejects LDR images");
+	Settings.Format = EBlockFormat::BC7;
+	Check(!CompressImage(HDRImage, Settings, ThreadPool, Compressed), "compress: LDR formats reject HDR images");
+	Check(!SaveCompressedDDS(L"Unused.dds", TCompressedImage()), "DDS: an image without mips is not written");
+
+	printf("%s\n", FailureCount == 0 ? "All block compressor checks passed" : "Block compressor checks FAILED");
+
+	return FailureCount;
+}
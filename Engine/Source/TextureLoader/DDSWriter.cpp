@@ -0,0 +1,86 @@
+#include "DDSWriter.h"
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	// Values from DDS.h
+	const uint32_t DDSMagic = 0x20534444;
+	const uint32_t DDSHeaderSize = 124;
+	const uint32_t DDSPixelFormatSize = 32;
+	const uint32_t DDSFourCC = 0x00000004;
+	const uint32_t DDSHeaderFlagsTexture = 0x00001007;
+	const uint32_t DDSHeaderFlagsMipmap = 0x00020000;
+	const uint32_t DDSHeaderFlagsLinearSize = 0x00080000;
+	const uint32_t DDSSurfaceFlagsTexture = 0x00001000;
+	const uint32_t DDSSurfaceFlagsMipmap = 0x00400008;
+	const uint32_t DX10FourCC = 0x30315844; // "DX10"
+	const uint32_t ResourceDimensionTexture2D = 3;
+
+	void WriteUInt32(std::ofstream& File, uint32_t Value)
+	{
+		// DDS is little endian like every platform we build for
+		File.write((const char*)&Value, sizeof(Value));
+	}
+}
+
+bool SaveCompressedDDS(const std::wstring& FilePath, const TCompressedImage& Image)
+{
+	if (Image.Mips.empty())
+	{
+		return false;
+	}
+
+	std::error_code Error;
+	std::filesystem::create_directories(std::filesystem::path(FilePath).parent_path(), Error);
+
+	std::ofstream File(std::filesystem::path(FilePath), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	const uint32_t MipCount = (uint32_t)Image.Mips.size();
+
+	WriteUInt32(File, DDSMagic);
+
+	// DDS_HEADER
+	WriteUInt32(File, DDSHeaderSize);
+	WriteUInt32(File, DDSHeaderFlagsTexture | DDSHeaderFlagsLinearSize | (MipCount > 1 ? DDSHeaderFlagsMipmap : 0));
+	WriteUInt32(File, Image.Height);
+	WriteUInt32(File, Image.Width);
+	WriteUInt32(File, (uint32_t)Image.Mips[0].Size);
+	WriteUInt32(File, 0); // depth
+	WriteUInt32(File, MipCount);
+	for (uint32_t i = 0; i < 11; i++)
+	{
+		WriteUInt32(File, 0); // reserved1
+	}
+
+	// DDS_PIXELFORMAT, the format lives in the DX10 header
+	WriteUInt32(File, DDSPixelFormatSize);
+	WriteUInt32(File, DDSFourCC);
+	WriteUInt32(File, DX10FourCC);
+	for (uint32_t i = 0; i < 5; i++)
+	{
+		WriteUInt32(File, 0);
+	}
+
+	WriteUInt32(File, DDSSurfaceFlagsTexture | (MipCount > 1 ? DDSSurfaceFlagsMipmap : 0));
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		WriteUInt32(File, 0); // caps2-4, reserved2
+	}
+
+	// DDS_HEADER_DXT10
+	WriteUInt32(File, GetBlockDxgiFormat(Image.Format, Image.bSRGB));
+	WriteUInt32(File, ResourceDimensionTexture2D);
+	WriteUInt32(File, 0); // miscFlag
+	WriteUInt32(File, 1); // arraySize
+	WriteUInt32(File, 0); // miscFlags2
+
+	// Mips are already packed largest first with the pitch DDSTextureLoader expects
+	File.write((const char*)Image.Data.data(), Image.Data.size());
+
+	return File.good();
+}
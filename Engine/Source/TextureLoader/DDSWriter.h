@@ -0,0 +1,8 @@
+#pragma once
+
+#include <string>
+#include "BlockCompressor.h"
+
+// Write a block compressed 2D texture and its mips as a DDS file with the DX10 header, the layout DDSTextureLoader reads.
+// Portable, the header is written field by field instead of through DDS.h.
+bool SaveCompressedDDS(const std::wstring& FilePath, const TCompressedImage& Image);
@@ -0,0 +1,399 @@
+#include "HDRPacking.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define HDRPACK_USE_SSE 1
+#include <emmintrin.h>
+#else
+#define HDRPACK_USE_SSE 0
+#endif
+
+namespace
+{
+	const uint32_t RowsPerTask = 16;
+
+	// Smallest shared exponent, 2^-16
+	const float MinR9G9B9E5Exponent = 1.0f / 65536.0f;
+
+	// Smallest normal float11 and float10, 2^-14. Below it they step by 2^-20 and 2^-19.
+	const float MinPackedNormal = 1.0f / 16384.0f;
+
+	uint32_t FloatToBits(float Value)
+	{
+		uint32_t Bits;
+		memcpy(&Bits, &Value, sizeof(Bits));
+
+		return Bits;
+	}
+
+	float BitsToFloat(uint32_t Bits)
+	{
+		float Value;
+		memcpy(&Value, &Bits, sizeof(Value));
+
+		return Value;
+	}
+
+	// NaN fails the comparison and goes to 0 with the negatives
+	float ClampChannel(float Value, float MaxValue)
+	{
+		return (Value > 0.0f) ? std::min<float>(Value, MaxValue) : 0.0f;
+	}
+
+	// Value in [0, MaxFloat11Value]. 6 bit mantissa, 5 bit exponent biased by 15.
+	uint32_t PackFloat11(float Value)
+	{
+		if (Value < MinPackedNormal)
+		{
+			return (uint32_t)std::lrint(Value * 1048576.0f);
+		}
+
+		// Rebias the exponent from 127 to 15, then round the mantissa to 6 bits
+		const uint32_t Bits = FloatToBits(Value) - 0x38000000;
+
+		return (Bits + 0xFFFF + ((Bits >> 17) & 1)) >> 17;
+	}
+
+	// Value in [0, MaxFloat10Value]. 5 bit mantissa, 5 bit exponent biased by 15.
+	uint32_t PackFloat10(float Value)
+	{
+		if (Value < MinPackedNormal)
+		{
+			return (uint32_t)std::lrint(Value * 524288.0f);
+		}
+
+		const uint32_t Bits = FloatToBits(Value) - 0x38000000;
+
+		return (Bits + 0x1FFFF + ((Bits >> 18) & 1)) >> 18;
+	}
+
+	float UnpackSmallFloat(uint32_t Packed, uint32_t MantissaBits)
+	{
+		const uint32_t Exponent = Packed >> MantissaBits;
+		const uint32_t Mantissa = Packed & ((1u << MantissaBits) - 1);
+
+		if (Exponent == 0)
+		{
+			return std::ldexp((float)Mantissa, -14 - (int)MantissaBits);
+		}
+
+		return BitsToFloat(((Exponent + 112) << 23) | (Mantissa << (23 - MantissaBits)));
+	}
+
+	// Slots per block of rows so the stats need no lock
+	struct TRowBlockStats
+	{
+		uint64_t ClampedCount = 0;
+
+		uint64_t InvalidCount = 0;
+
+		double RelativeErrorSum = 0.0;
+
+		double MaxRelativeError = 0.0;
+	};
+
+#if HDRPACK_USE_SSE
+	// Three loads of 4 interleaved RGB texels to one register per channel
+	void LoadRGB4(const float* Texels, __m128& OutR, __m128& OutG, __m128& OutB)
+	{
+		// A = r0 g0 b0 r1, B = g1 b1 r2 g2, C = b2 r3 g3 b3
+		const __m128 A = _mm_loadu_ps(Texels);
+		const __m128 B = _mm_loadu_ps(Texels + 4);
+		const __m128 C = _mm_loadu_ps(Texels + 8);
+
+		const __m128 R23 = _mm_shuffle_ps(B, C, _MM_SHUFFLE(1, 1, 2, 2));
+		OutR = _mm_shuffle_ps(A, R23, _MM_SHUFFLE(2, 0, 3, 0));
+
+		const __m128 G01 = _mm_shuffle_ps(A, B, _MM_SHUFFLE(0, 0, 1, 1));
+		const __m128 G23 = _mm_shuffle_ps(B, C, _MM_SHUFFLE(2, 2, 3, 3));
+		OutG = _mm_shuffle_ps(G01, G23, _MM_SHUFFLE(2, 0, 2, 0));
+
+		const __m128 B01 = _mm_shuffle_ps(A, B, _MM_SHUFFLE(1, 1, 2, 2));
+		const __m128 B23 = _mm_shuffle_ps(C, C, _MM_SHUFFLE(3, 3, 0, 0));
+		OutB = _mm_shuffle_ps(B01, B23, _MM_SHUFFLE(2, 0, 2, 0));
+	}
+
+	__m128 ClampChannel4(__m128 Value, float MaxValue)
+	{
+		// maxps returns the second operand for NaN
+		return _mm_min_ps(_mm_max_ps(Value, _mm_setzero_ps()), _mm_set1_ps(MaxValue));
+	}
+
+	__m128i SelectInt4(__m128 Mask, __m128i IfTrue, __m128i IfFalse)
+	{
+		const __m128i IntMask = _mm_castps_si128(Mask);
+
+		return _mm_or_si128(_mm_and_si128(IntMask, IfTrue), _mm_andnot_si128(IntMask, IfFalse));
+	}
+
+	// Same steps as PackR9G9B9E5, cvtps rounds to nearest even like lrint
+	__m128i PackR9G9B9E5x4(__m128 R, __m128 G, __m128 B)
+	{
+		R = ClampChannel4(R, MaxR9G9B9E5Value);
+		G = ClampChannel4(G, MaxR9G9B9E5Value);
+		B = ClampChannel4(B, MaxR9G9B9E5Value);
+
+		const __m128 MaxChannel = _mm_max_ps(_mm_max_ps(R, G), _mm_max_ps(B, _mm_set1_ps(MinR9G9B9E5Exponent)));
+		const __m128i Exponent = _mm_srli_epi32(_mm_add_epi32(_mm_castps_si128(MaxChannel), _mm_set1_epi32(0x4000)), 23);
+		const __m128 Scale = _mm_castsi128_ps(_mm_sub_epi32(_mm_set1_epi32((int)0x83000000), _mm_slli_epi32(Exponent, 23)));
+
+		__m128i Packed = _mm_cvtps_epi32(_mm_mul_ps(R, Scale));
+		Packed = _mm_or_si128(Packed, _mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(G, Scale)), 9));
+		Packed = _mm_or_si128(Packed, _mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(B, Scale)), 18));
+
+		return _mm_or_si128(Packed, _mm_slli_epi32(_mm_sub_epi32(Exponent, _mm_set1_epi32(0x6F)), 27));
+	}
+
+	// Value already clamped, MantissaShift is 17 for float11 and 18 for float10
+	template<int MantissaShift>
+	__m128i PackSmallFloat4(__m128 Value, float DenormalScale)
+	{
+		const __m128i Bits = _mm_sub_epi32(_mm_castps_si128(Value), _mm_set1_epi32(0x38000000));
+		const __m128i Odd = _mm_and_si128(_mm_srli_epi32(Bits, MantissaShift), _mm_set1_epi32(1));
+		const __m128i Rounded = _mm_add_epi32(_mm_add_epi32(Bits, _mm_set1_epi32((1 << (MantissaShift - 1)) - 1)), Odd);
+		const __m128i Normal = _mm_srli_epi32(Rounded, MantissaShift);
+
+		const __m128i Denormal = _mm_cvtps_epi32(_mm_mul_ps(Value, _mm_set1_ps(DenormalScale)));
+
+		return SelectInt4(_mm_cmplt_ps(Value, _mm_set1_ps(MinPackedNormal)), Denormal, Normal);
+	}
+
+	__m128i PackR11G11B10x4(__m128 R, __m128 G, __m128 B)
+	{
+		__m128i Packed = PackSmallFloat4<17>(ClampChannel4(R, MaxFloat11Value), 1048576.0f);
+		Packed = _mm_or_si128(Packed, _mm_slli_epi32(PackSmallFloat4<17>(ClampChannel4(G, MaxFloat11Value), 1048576.0f), 11));
+
+		return _mm_or_si128(Packed, _mm_slli_epi32(PackSmallFloat4<18>(ClampChannel4(B, MaxFloat10Value), 524288.0f), 22));
+	}
+#endif
+
+	void PackRow(const float* SrcRow, uint32_t* DstRow, uint32_t Width, EDecodedImageFormat Format)
+	{
+		uint32_t x = 0;
+
+#if HDRPACK_USE_SSE
+		for (; x + 4 <= Width; x += 4)
+		{
+			__m128 R, G, B;
+			LoadRGB4(SrcRow + x * 3, R, G, B);
+
+			const __m128i Packed = (Format == EDecodedImageFormat::R9G9B9E5) ? PackR9G9B9E5x4(R, G, B) : PackR11G11B10x4(R, G, B);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(DstRow + x), Packed);
+		}
+#endif
+
+		for (; x < Width; x++)
+		{
+			DstRow[x] = (Format == EDecodedImageFormat::R9G9B9E5) ? PackR9G9B9E5(SrcRow + x * 3) : PackR11G11B10(SrcRow + x * 3);
+		}
+	}
+
+	void MeasureRow(const float* SrcRow, const uint32_t* PackedRow, uint32_t Width, EDecodedImageFormat Format, TRowBlockStats& Stats)
+	{
+		const float MaxValue[3] = {
+			(Format == EDecodedImageFormat::R9G9B9E5) ? MaxR9G9B9E5Value : MaxFloat11Value,
+			(Format == EDecodedImageFormat::R9G9B9E5) ? MaxR9G9B9E5Value : MaxFloat11Value,
+			(Format == EDecodedImageFormat::R9G9B9E5) ? MaxR9G9B9E5Value : MaxFloat10Value };
+
+		for (uint32_t x = 0; x < Width; x++)
+		{
+			const float* Source = SrcRow + x * 3;
+
+			float Decoded[3];
+			if (Format == EDecodedImageFormat::R9G9B9E5)
+			{
+				UnpackR9G9B9E5(PackedRow[x], Decoded);
+			}
+			else
+			{
+				UnpackR11G11B10(PackedRow[x], Decoded);
+			}
+
+			float Brightest = MinPackedNormal;
+			float MaxError = 0.0f;
+			for (int c = 0; c < 3; c++)
+			{
+				if (!(Source[c] >= 0.0f))
+				{
+					Stats.InvalidCount++;
+				}
+				else if (Source[c] > MaxValue[c])
+				{
+					Stats.ClampedCount++;
+				}
+
+				const float Clamped = ClampChannel(Source[c], MaxValue[c]);
+				Brightest = std::max<float>(Brightest, Clamped);
+				MaxError = std::max<float>(MaxError, std::abs(Decoded[c] - Clamped));
+			}
+
+			const double RelativeError = (double)MaxError / Brightest;
+			Stats.RelativeErrorSum += RelativeError;
+			Stats.MaxRelativeError = std::max<double>(Stats.MaxRelativeError, RelativeError);
+		}
+	}
+}
+
+uint32_t PackR9G9B9E5(const float RGB[3])
+{
+	const float R = ClampChannel(RGB[0], MaxR9G9B9E5Value);
+	const float G = ClampChannel(RGB[1], MaxR9G9B9E5Value);
+	const float B = ClampChannel(RGB[2], MaxR9G9B9E5Value);
+
+	// Round the brightest channel to 9 bits first, so a carry into the next exponent picks the larger shared exponent
+	const float MaxChannel = std::max<float>(std::max<float>(R, G), std::max<float>(B, MinR9G9B9E5Exponent));
+	const uint32_t Exponent = (FloatToBits(MaxChannel) + 0x4000) >> 23;
+
+	// 2^(24 - SharedExponent), which maps the brightest channel to [256, 511]
+	const float Scale = BitsToFloat(0x83000000 - (Exponent << 23));
+
+	const uint32_t MantissaR = (uint32_t)std::lrint(R * Scale);
+	const uint32_t MantissaG = (uint32_t)std::lrint(G * Scale);
+	const uint32_t MantissaB = (uint32_t)std::lrint(B * Scale);
+
+	return MantissaR | (MantissaG << 9) | (MantissaB << 18) | ((Exponent - 0x6F) << 27);
+}
+
+void UnpackR9G9B9E5(uint32_t Packed, float OutRGB[3])
+{
+	// 2^(SharedExponent - 15 - 9)
+	const float Scale = BitsToFloat(((Packed >> 27) + 103) << 23);
+
+	OutRGB[0] = (Packed & 0x1FF) * Scale;
+	OutRGB[1] = ((Packed >> 9) & 0x1FF) * Scale;
+	OutRGB[2] = ((Packed >> 18) & 0x1FF) * Scale;
+}
+
+uint32_t PackR11G11B10(const float RGB[3])
+{
+	const uint32_t R = PackFloat11(ClampChannel(RGB[0], MaxFloat11Value));
+	const uint32_t G = PackFloat11(ClampChannel(RGB[1], MaxFloat11Value));
+	const uint32_t B = PackFloat10(ClampChannel(RGB[2], MaxFloat10Value));
+
+	return R | (G << 11) | (B << 22);
+}
+
+void UnpackR11G11B10(uint32_t Packed, float OutRGB[3])
+{
+	OutRGB[0] = UnpackSmallFloat(Packed & 0x7FF, 6);
+	OutRGB[1] = UnpackSmallFloat((Packed >> 11) & 0x7FF, 6);
+	OutRGB[2] = UnpackSmallFloat(Packed >> 22, 5);
+}
+
+std::string THDRPackStats::ToString() const
+{
+	char Buffer[320];
+	snprintf(Buffer, sizeof(Buffer), "%s: %.2f MB -> %.2f MB (%.1fx), relative error mean %.5f max %.5f, %llu clamped and %llu negative/NaN channels, %.3fs",
+		(Format == EDecodedImageFormat::R9G9B9E5) ? "R9G9B9E5" : "R11G11B10", SourceBytes / (1024.0 * 1024.0), PackedBytes / (1024.0 * 1024.0),
+		PackedBytes > 0 ? (double)SourceBytes / PackedBytes : 0.0, MeanRelativeError, MaxRelativeError,
+		(unsigned long long)ClampedCount, (unsigned long long)InvalidCount, Seconds);
+
+	return std::string(Buffer);
+}
+
+bool PackHDRImage(TDecodedImage& Image, EDecodedImageFormat Format, TThreadPool& ThreadPool, THDRPackStats* OutStats)
+{
+	typedef std::chrono::steady_clock TClock;
+	TClock::time_point StartTime = TClock::now();
+
+	if (Image.Format != EDecodedImageFormat::RGB32F || (Format != EDecodedImageFormat::R9G9B9E5 && Format != EDecodedImageFormat::R11G11B10))
+	{
+		return false;
+	}
+
+	std::vector<TDecodedMip> Levels = Image.Mips;
+	if (Levels.empty())
+	{
+		TDecodedMip Level;
+		Level.Width = Image.Width;
+		Level.Height = Image.Height;
+		Level.RowPitch = Image.RowPitch;
+		Level.Offset = 0;
+		Levels.push_back(Level);
+	}
+
+	// Packed rows are tight like the source
+	std::vector<TDecodedMip> PackedLevels;
+	size_t DataSize = 0;
+	for (const TDecodedMip& Level : Levels)
+	{
+		TDecodedMip PackedLevel = Level;
+		PackedLevel.RowPitch = Level.Width * sizeof(uint32_t);
+		PackedLevel.Offset = DataSize;
+
+		DataSize += (size_t)PackedLevel.RowPitch * Level.Height;
+		PackedLevels.push_back(PackedLevel);
+	}
+
+	std::vector<uint8_t> PackedData(DataSize);
+	TRowBlockStats TotalStats;
+	uint64_t TexelCount = 0;
+
+	for (size_t LevelIndex = 0; LevelIndex < Levels.size(); LevelIndex++)
+	{
+		const TDecodedMip& Level = Levels[LevelIndex];
+		const TDecodedMip& PackedLevel = PackedLevels[LevelIndex];
+
+		const uint32_t BlockCount = (Level.Height + RowsPerTask - 1) / RowsPerTask;
+		std::vector<TRowBlockStats> BlockStats(OutStats ? BlockCount : 0);
+
+		ThreadPool.ParallelFor(BlockCount, [&](uint32_t Block)
+		{
+			const uint32_t RowEnd = std::min<uint32_t>((Block + 1) * RowsPerTask, Level.Height);
+			for (uint32_t y = Block * RowsPerTask; y < RowEnd; y++)
+			{
+				const float* SrcRow = reinterpret_cast<const float*>(Image.Data.data() + Level.Offset + (size_t)y * Level.RowPitch);
+				uint32_t* DstRow = reinterpret_cast<uint32_t*>(PackedData.data() + PackedLevel.Offset + (size_t)y * PackedLevel.RowPitch);
+
+				PackRow(SrcRow, DstRow, Level.Width, Format);
+
+				if (OutStats)
+				{
+					MeasureRow(SrcRow, DstRow, Level.Width, Format, BlockStats[Block]);
+				}
+			}
+		});
+
+		for (const TRowBlockStats& Stats : BlockStats)
+		{
+			TotalStats.ClampedCount += Stats.ClampedCount;
+			TotalStats.InvalidCount += Stats.InvalidCount;
+			TotalStats.RelativeErrorSum += Stats.RelativeErrorSum;
+			TotalStats.MaxRelativeError = std::max<double>(TotalStats.MaxRelativeError, Stats.MaxRelativeError);
+		}
+
+		TexelCount += (uint64_t)Level.Width * Level.Height;
+	}
+
+	if (OutStats)
+	{
+		OutStats->Format = Format;
+		OutStats->TexelCount = TexelCount;
+		OutStats->ClampedCount = TotalStats.ClampedCount;
+		OutStats->InvalidCount = TotalStats.InvalidCount;
+		OutStats->MaxRelativeError = TotalStats.MaxRelativeError;
+		OutStats->MeanRelativeError = TexelCount > 0 ? TotalStats.RelativeErrorSum / TexelCount : 0.0;
+		OutStats->SourceBytes = Image.Data.size();
+		OutStats->PackedBytes = PackedData.size();
+	}
+
+	Image.Format = Format;
+	Image.RowPitch = PackedLevels[0].RowPitch;
+	Image.Data = std::move(PackedData);
+	if (!Image.Mips.empty())
+	{
+		Image.Mips = PackedLevels;
+	}
+
+	if (OutStats)
+	{
+		OutStats->Seconds = std::chrono::duration<double>(TClock::now() - StartTime).count();
+	}
+
+	return true;
+}
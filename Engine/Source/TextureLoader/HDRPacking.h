@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "ImageDecoder.h"
+
+class TThreadPool;
+
+// Largest values the packed formats hold, larger ones are clamped to them
+const float MaxR9G9B9E5Value = 65408.0f;
+
+const float MaxFloat11Value = 65024.0f;
+
+const float MaxFloat10Value = 64512.0f;
+
+// Both formats are unsigned: negatives and NaN become 0, values above the maximum are clamped.
+// Mantissas are rounded to nearest even like DirectXMath, which truncates float11/float10 denormals instead.
+uint32_t PackR9G9B9E5(const float RGB[3]);
+
+void UnpackR9G9B9E5(uint32_t Packed, float OutRGB[3]);
+
+uint32_t PackR11G11B10(const float RGB[3]);
+
+void UnpackR11G11B10(uint32_t Packed, float OutRGB[3]);
+
+struct THDRPackStats
+{
+	EDecodedImageFormat Format = EDecodedImageFormat::R9G9B9E5;
+
+	// Every mip level
+	uint64_t TexelCount = 0;
+
+	// Channels above the largest value of the format
+	uint64_t ClampedCount = 0;
+
+	// Negative or NaN channels, stored as 0
+	uint64_t InvalidCount = 0;
+
+	// Largest channel error of a texel over its brightest channel, measured against the clamped source.
+	// Texels darker than 2^-14 are measured against 2^-14.
+	double MaxRelativeError = 0.0;
+
+	double MeanRelativeError = 0.0;
+
+	uint64_t SourceBytes = 0;
+
+	uint64_t PackedBytes = 0;
+
+	double Seconds = 0.0;
+
+	std::string ToString() const;
+};
+
+// Pack an RGB32F image and its mips into R9G9B9E5 or R11G11B10 in place, rows are split across the thread pool.
+// Stats are only measured when OutStats is set, they decode every texel again.
+bool PackHDRImage(TDecodedImage& Image, EDecodedImageFormat Format, TThreadPool& ThreadPool, THDRPackStats* OutStats = nullptr);
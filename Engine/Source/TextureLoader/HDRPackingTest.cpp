@@ -0,0 +1,273 @@
+#include "HDRPacking.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+
+// Checks R9G9B9E5 and R11G11B10 packing: every encodable value round trips, random values stay within half a step,
+// out of range, NaN, infinite and denormal inputs are handled as documented, and the SIMD rows of PackHDRImage match
+// the scalar functions bit for bit. Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	const float Infinity = std::numeric_limits<float>::infinity();
+
+	const float NaN = std::numeric_limits<float>::quiet_NaN();
+
+	// Float denormal, far below anything the packed formats hold
+	const float FloatDenormal = std::numeric_limits<float>::denorm_min() * 1000.0f;
+
+	float RoundTripR9G9B9E5(float Value, int Channel)
+	{
+		float RGB[3] = { 0.0f, 0.0f, 0.0f };
+		RGB[Channel] = Value;
+
+		float Decoded[3];
+		UnpackR9G9B9E5(PackR9G9B9E5(RGB), Decoded);
+
+		return Decoded[Channel];
+	}
+
+	float RoundTripR11G11B10(float Value, int Channel)
+	{
+		float RGB[3] = { 0.0f, 0.0f, 0.0f };
+		RGB[Channel] = Value;
+
+		float Decoded[3];
+		UnpackR11G11B10(PackR11G11B10(RGB), Decoded);
+
+		return Decoded[Channel];
+	}
+
+	// Every float11 and float10 code below the infinity exponent decodes and packs back to itself
+	void TestR11G11B10Codes()
+	{
+		bool bFloat11RoundTrips = true;
+		bool bFloat10RoundTrips = true;
+		bool bMonotonic = true;
+		float Previous = -1.0f;
+		for (uint32_t Code = 0; Code < (31u << 6); Code++)
+		{
+			float Decoded[3];
+			UnpackR11G11B10(Code | (Code << 11), Decoded);
+			bMonotonic &= Decoded[0] > Previous;
+			Previous = Decoded[0];
+
+			bFloat11RoundTrips &= PackR11G11B10(Decoded) == (Code | (Code << 11));
+		}
+
+		for (uint32_t Code = 0; Code < (31u << 5); Code++)
+		{
+			float Decoded[3];
+			UnpackR11G11B10(Code << 22, Decoded);
+			bFloat10RoundTrips &= PackR11G11B10(Decoded) == (Code << 22);
+		}
+
+		Check(bFloat11RoundTrips, "R11G11B10: every float11 code round trips");
+		Check(bFloat10RoundTrips, "R11G11B10: every float10 code round trips");
+		Check(bMonotonic, "R11G11B10: float11 codes decode in increasing order");
+		Check(Previous == MaxFloat11Value, "R11G11B10: the largest float11 code is MaxFloat11Value");
+	}
+
+	// Packed values with a normalized brightest channel, or the smallest exponent, decode and pack back to themselves
+	void TestR9G9B9E5Codes()
+	{
+		std::mt19937 Random(1);
+		bool bRoundTrips = true;
+		int CodeCount = 0;
+		while (CodeCount < 200000)
+		{
+			const uint32_t Packed = Random();
+			const uint32_t Exponent = Packed >> 27;
+			const uint32_t Brightest = std::max<uint32_t>(std::max<uint32_t>(Packed & 0x1FF, (Packed >> 9) & 0x1FF), (Packed >> 18) & 0x1FF);
+			if (Brightest < 256 && Exponent > 0)
+			{
+				continue;
+			}
+
+			float Decoded[3];
+			UnpackR9G9B9E5(Packed, Decoded);
+			bRoundTrips &= PackR9G9B9E5(Decoded) == Packed;
+			CodeCount++;
+		}
+
+		float Largest[3];
+		UnpackR9G9B9E5(0xFFFFFFFF, Largest);
+
+		Check(bRoundTrips, "R9G9B9E5: normalized codes round trip");
+		Check(Largest[0] == MaxR9G9B9E5Value, "R9G9B9E5: the largest code is MaxR9G9B9E5Value");
+	}
+
+	// Log-uniform values over the whole normal range, errors in units of half a step of the format
+	void TestErrorBounds()
+	{
+		std::mt19937 Random(2);
+		std::uniform_real_distribution<float> Log2Value(-14.0f, 15.9f);
+		std::uniform_real_distribution<float> Fraction(0.0f, 1.0f);
+
+		double MaxSharedError = 0.0;
+		double MaxFloat11Error = 0.0;
+		double MaxFloat10Error = 0.0;
+		for (int i = 0; i < 1000000; i++)
+		{
+			// The other two channels are a fraction of the first, they share its exponent
+			const float Value = std::exp2(Log2Value(Random));
+			const float RGB[3] = { Value, Value * Fraction(Random), Value * Fraction(Random) };
+
+			float Decoded[3];
+			UnpackR9G9B9E5(PackR9G9B9E5(RGB), Decoded);
+			for (int c = 0; c < 3; c++)
+			{
+				// The brightest channel maps to [256, 511], so half a step is at most 1/512 of it
+				MaxSharedError = std::max<double>(MaxSharedError, std::fabs(Decoded[c] - RGB[c]) / (Value / 512.0));
+			}
+
+			// 6 and 5 bit mantissas, half a step is 2^-7 and 2^-6 of the value
+			UnpackR11G11B10(PackR11G11B10(RGB), Decoded);
+			MaxFloat11Error = std::max<double>(MaxFloat11Error, std::fabs(Decoded[0] - RGB[0]) / (RGB[0] / 128.0));
+			MaxFloat10Error = std::max<double>(MaxFloat10Error, std::fabs(Decoded[2] - RGB[2]) / (std::max<float>(RGB[2], 1.0f / 16384.0f) / 64.0));
+		}
+
+		printf("Error in half steps: R9G9B9E5 %.4f, float11 %.4f, float10 %.4f\n", MaxSharedError, MaxFloat11Error, MaxFloat10Error);
+
+		Check(MaxSharedError <= 1.0001, "R9G9B9E5: error within half a step of the shared exponent");
+		Check(MaxFloat11Error <= 1.0001, "R11G11B10: float11 error within half a step");
+		Check(MaxFloat10Error <= 1.0001, "R11G11B10: float10 error within half a step");
+	}
+
+	void TestOutOfRange()
+	{
+		const float Invalid[] = { -1.0f, -1e30f, -Infinity, NaN, -NaN, -0.0f };
+		for (float Value : Invalid)
+		{
+			for (int Channel = 0; Channel < 3; Channel++)
+			{
+				Check(RoundTripR9G9B9E5(Value, Channel) == 0.0f, "R9G9B9E5: negatives and NaN become 0");
+				Check(RoundTripR11G11B10(Value, Channel) == 0.0f, "R11G11B10: negatives and NaN become 0");
+			}
+		}
+
+		const float TooLarge[] = { 65536.0f, 1e30f, Infinity };
+		for (float Value : TooLarge)
+		{
+			for (int Channel = 0; Channel < 3; Channel++)
+			{
+				Check(RoundTripR9G9B9E5(Value, Channel) == MaxR9G9B9E5Value, "R9G9B9E5: large and infinite values clamp to the maximum");
+				Check(RoundTripR11G11B10(Value, Channel) == (Channel < 2 ? MaxFloat11Value : MaxFloat10Value),
+					"R11G11B10: large and infinite values clamp to the maximum");
+			}
+		}
+
+		// Clamping one channel must not disturb the others
+		const float Mixed[3] = { Infinity, 1.5f, NaN };
+		float Decoded[3];
+		UnpackR11G11B10(PackR11G11B10(Mixed), Decoded);
+		Check(Decoded[0] == MaxFloat11Value && Decoded[1] == 1.5f && Decoded[2] == 0.0f, "R11G11B10: channels clamp independently");
+
+		UnpackR9G9B9E5(PackR9G9B9E5(Mixed), Decoded);
+		Check(Decoded[0] == MaxR9G9B9E5Value && Decoded[1] == 0.0f && Decoded[2] == 0.0f,
+			"R9G9B9E5: a clamped channel sets the shared exponent, darker ones flush to 0");
+	}
+
+	void TestDenormals()
+	{
+		// Float denormals are far below the smallest step of both formats
+		for (int Channel = 0; Channel < 3; Channel++)
+		{
+			Check(RoundTripR9G9B9E5(FloatDenormal, Channel) == 0.0f, "R9G9B9E5: float denormals become 0");
+			Check(RoundTripR11G11B10(FloatDenormal, Channel) == 0.0f, "R11G11B10: float denormals become 0");
+		}
+
+		// The packed formats' own denormals are exact multiples of their smallest step
+		bool bExact = true;
+		for (uint32_t Mantissa = 1; Mantissa < 64; Mantissa++)
+		{
+			bExact &= RoundTripR11G11B10(std::ldexp((float)Mantissa, -20), 0) == std::ldexp((float)Mantissa, -20);
+			bExact &= RoundTripR11G11B10(std::ldexp((float)(Mantissa / 2), -19), 2) == std::ldexp((float)(Mantissa / 2), -19);
+			bExact &= RoundTripR9G9B9E5(std::ldexp((float)(Mantissa * 8), -24), 1) == std::ldexp((float)(Mantissa * 8), -24);
+		}
+		Check(bExact, "denormals: multiples of the smallest step are exact");
+
+		// Below the smallest step values round to the nearest multiple
+		Check(RoundTripR11G11B10(std::ldexp(1.4f, -20), 0) == std::ldexp(1.0f, -20), "denormals: float11 rounds below the normal range");
+		Check(RoundTripR11G11B10(std::ldexp(0.4f, -20), 0) == 0.0f, "denormals: float11 flushes below half a step");
+		Check(RoundTripR9G9B9E5(std::ldexp(0.4f, -24), 0) == 0.0f, "denormals: R9G9B9E5 flushes below half a step");
+
+		// The normal and denormal float11 ranges meet without a gap
+		Check(RoundTripR11G11B10(1.0f / 16384.0f, 0) == 1.0f / 16384.0f, "denormals: the smallest float11 normal is exact");
+		Check(RoundTripR11G11B10(std::ldexp(63.6f, -20), 0) == 1.0f / 16384.0f, "denormals: the largest denormal rounds up into the normals");
+	}
+
+	// PackHDRImage packs 4 texels at a time with SSE, the row tails use the scalar functions
+	void TestImageMatchesScalar(EDecodedImageFormat Format, TThreadPool& ThreadPool)
+	{
+		const uint32_t Width = 37;
+		const uint32_t Height = 29;
+
+		std::mt19937 Random(3);
+		std::uniform_real_distribution<float> Log2Value(-30.0f, 17.0f);
+		const float Special[] = { 0.0f, -0.0f, -1.0f, NaN, Infinity, -Infinity, FloatDenormal, 1e30f };
+
+		TDecodedImage Image;
+		Image.Width = Width;
+		Image.Height = Height;
+		Image.Format = EDecodedImageFormat::RGB32F;
+		Image.RowPitch = Width * 3 * sizeof(float);
+		Image.Data.resize((size_t)Image.RowPitch * Height);
+
+		std::vector<float> Source((size_t)Width * Height * 3);
+		for (size_t i = 0; i < Source.size(); i++)
+		{
+			Source[i] = (Random() % 16 == 0) ? Special[Random() % 8] : std::exp2(Log2Value(Random));
+		}
+		memcpy(Image.Data.data(), Source.data(), Image.Data.size());
+
+		THDRPackStats Stats;
+		const bool bPacked = PackHDRImage(Image, Format, ThreadPool, &Stats);
+		printf("%s\n", Stats.ToString().c_str());
+
+		bool bMatches = bPacked && Image.Format == Format && Image.Data.size() == (size_t)Width * Height * 4;
+		for (size_t i = 0; bMatches && i < (size_t)Width * Height; i++)
+		{
+			uint32_t Packed;
+			memcpy(&Packed, Image.Data.data() + i * 4, 4);
+			bMatches = Packed == ((Format == EDecodedImageFormat::R9G9B9E5) ? PackR9G9B9E5(&Source[i * 3]) : PackR11G11B10(&Source[i * 3]));
+		}
+
+		Check(bMatches, "image: SIMD rows match the scalar packing bit for bit");
+		Check(Stats.TexelCount == (uint64_t)Width * Height && Stats.InvalidCount > 0 && Stats.ClampedCount > 0, "image: stats count invalid and clamped channels");
+
+		TDecodedImage Packed = Image;
+		Check(!PackHDRImage(Packed, Format, ThreadPool), "image: only RGB32F images are packed");
+	}
+}
+
+int main()
+{
+	TThreadPool ThreadPool;
+
+	TestR11G11B10Codes();
+	TestR9G9B9E5Codes();
+	TestErrorBounds();
+	TestOutOfRange();
+	TestDenormals();
+	TestImageMatchesScalar(EDecodedImageFormat::R9G9B9E5, ThreadPool);
+	TestImageMatchesScalar(EDecodedImageFormat::R11G11B10, ThreadPool);
+
+	printf("%s\n", FailureCount == 0 ? "All HDR packing checks passed" : "HDR packing checks FAILED");
+
+	return FailureCount;
+}
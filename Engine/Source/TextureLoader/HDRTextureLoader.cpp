@@ -1,6 +1,5 @@
 #include "HDRTextureLoader.h"
 
-#define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 bool CreateHDRTextureFromFile(
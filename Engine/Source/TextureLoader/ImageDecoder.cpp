@@ -0,0 +1,111 @@
+#include "ImageDecoder.h"
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+EImageFileType GetImageFileType(const std::string& FilePath)
+{
+	size_t DotPos = FilePath.rfind('.');
+	if (DotPos == std::string::npos || DotPos == FilePath.length() - 1)
+	{
+		return EImageFileType::Unknown;
+	}
+
+	std::string Ext = FilePath.substr(DotPos + 1);
+	std::transform(Ext.begin(), Ext.end(), Ext.begin(), [](char c) { return (char)::tolower(c); });
+
+	if (Ext == "png")
+	{
+		return EImageFileType::PNG;
+	}
+	else if (Ext == "jpg" || Ext == "jpeg")
+	{
+		return EImageFileType::JPG;
+	}
+	else if (Ext == "hdr")
+	{
+		return EImageFileType::HDR;
+	}
+	else if (Ext == "dds")
+	{
+		return EImageFileType::DDS;
+	}
+
+	return EImageFileType::Unknown;
+}
+
+uint32_t GetBytesPerPixel(EDecodedImageFormat Format)
+{
+	switch (Format)
+	{
+	case EDecodedImageFormat::R8:
+		return 1;
+	case EDecodedImageFormat::RGBA8:
+		return 4;
+	case EDecodedImageFormat::RGB32F:
+		return 12;
+	case EDecodedImageFormat::R9G9B9E5:
+	case EDecodedImageFormat::R11G11B10:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+bool DecodeImageFromMemory(const uint8_t* FileData, size_t FileSize, EImageFileType FileType, TDecodedImage& OutImage)
+{
+	int Width, Height, Components;
+	if (!stbi_info_from_memory(FileData, (int)FileSize, &Width, &Height, &Components))
+	{
+		return false;
+	}
+
+	if (FileType == EImageFileType::HDR)
+	{
+		stbi_set_flip_vertically_on_load_thread(true);
+		float* Pixels = stbi_loadf_from_memory(FileData, (int)FileSize, &Width, &Height, &Components, 3);
+		stbi_set_flip_vertically_on_load_thread(false);
+
+		if (!Pixels)
+		{
+			return false;
+		}
+
+		OutImage.Format = EDecodedImageFormat::RGB32F;
+		OutImage.Width = Width;
+		OutImage.Height = Height;
+		OutImage.RowPitch = Width * 3 * sizeof(float);
+		OutImage.Data.resize((size_t)OutImage.RowPitch * Height);
+		memcpy(OutImage.Data.data(), Pixels, OutImage.Data.size());
+
+		stbi_image_free(Pixels);
+	}
+	else if (FileType == EImageFileType::PNG || FileType == EImageFileType::JPG)
+	{
+		int RequiredComponents = (Components == 1) ? 1 : 4;
+
+		stbi_uc* Pixels = stbi_load_from_memory(FileData, (int)FileSize, &Width, &Height, &Components, RequiredComponents);
+		if (!Pixels)
+		{
+			return false;
+		}
+
+		OutImage.Format = (RequiredComponents == 1) ? EDecodedImageFormat::R8 : EDecodedImageFormat::RGBA8;
+		OutImage.Width = Width;
+		OutImage.Height = Height;
+		OutImage.RowPitch = Width * RequiredComponents;
+		OutImage.Data.resize((size_t)OutImage.RowPitch * Height);
+		memcpy(OutImage.Data.data(), Pixels, OutImage.Data.size());
+
+		stbi_image_free(Pixels);
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
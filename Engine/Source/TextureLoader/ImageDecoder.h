@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class EImageFileType
+{
+	Unknown,
+	PNG,
+	JPG,
+	HDR,
+	DDS,
+};
+
+enum class EDecodedImageFormat
+{
+	R8,
+	RGBA8,
+	RGB32F,
+
+	// Packed HDR, 4 bytes per pixel, see HDRPacking.h
+	R9G9B9E5,
+	R11G11B10,
+};
+
+struct TDecodedMip
+{
+	uint32_t Width = 0;
+
+	uint32_t Height = 0;
+
+	uint32_t RowPitch = 0;
+
+	size_t Offset = 0;
+};
+
+// Decoded 2D image, rows tightly packed
+struct TDecodedImage
+{
+	uint32_t Width = 0;
+
+	uint32_t Height = 0;
+
+	EDecodedImageFormat Format = EDecodedImageFormat::RGBA8;
+
+	uint32_t RowPitch = 0;
+
+	std::vector<uint8_t> Data;
+
+	// Mip levels packed in Data after level 0, empty when only level 0 exists
+	std::vector<TDecodedMip> Mips;
+};
+
+EImageFileType GetImageFileType(const std::string& FilePath);
+
+uint32_t GetBytesPerPixel(EDecodedImageFormat Format);
+
+// Platform-independent decode of PNG/JPG/HDR from memory (stb_image).
+// Gray images stay single channel, others are expanded to RGBA8. HDR is RGB32F, flipped vertically like CreateHDRTextureFromFile.
+bool DecodeImageFromMemory(const uint8_t* FileData, size_t FileSize, EImageFileType FileType, TDecodedImage& OutImage);
@@ -0,0 +1,485 @@
+#include "MipGenerator.h"
+#include "HDRPacking.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define MIPGEN_USE_SSE 1
+#include <emmintrin.h>
+#else
+#define MIPGEN_USE_SSE 0
+#endif
+
+namespace
+{
+	// Levels are filtered as 4 floats per pixel, unused channels ride along
+	const uint32_t FloatsPerPixel = 4;
+
+	const uint32_t RowsPerTask = 16;
+
+	const float Pi = 3.14159265358979f;
+
+	struct TFilterTap
+	{
+		uint32_t Index;
+
+		float Weight;
+	};
+
+	// Taps of destination texel i are Taps[First[i], First[i] + Count[i])
+	struct TFilterKernel
+	{
+		std::vector<uint32_t> First;
+
+		std::vector<uint32_t> Count;
+
+		std::vector<TFilterTap> Taps;
+	};
+
+	struct TFloatLevel
+	{
+		uint32_t Width = 0;
+
+		uint32_t Height = 0;
+
+		std::vector<float> Pixels;
+	};
+
+	float SRGBToLinear(float Value)
+	{
+		return Value <= 0.04045f ? Value / 12.92f : std::pow((Value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSRGB(float Value)
+	{
+		return Value <= 0.0031308f ? Value * 12.92f : 1.055f * std::pow(Value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	float Saturate(float Value)
+	{
+		return Value < 0.0f ? 0.0f : (Value > 1.0f ? 1.0f : Value);
+	}
+
+	uint8_t UnormToByte(float Value)
+	{
+		return (uint8_t)(Saturate(Value) * 255.0f + 0.5f);
+	}
+
+	double BesselI0(double X)
+	{
+		double Sum = 1.0;
+		double Term = 1.0;
+		double HalfX = X * 0.5;
+
+		for (int k = 1; k < 64; k++)
+		{
+			double Factor = HalfX / k;
+			Term *= Factor * Factor;
+			Sum += Term;
+
+			if (Term < Sum * 1e-12)
+			{
+				break;
+			}
+		}
+
+		return Sum;
+	}
+
+	float Sinc(float X)
+	{
+		if (std::fabs(X) < 1e-6f)
+		{
+			return 1.0f;
+		}
+
+		X *= Pi;
+		return std::sin(X) / X;
+	}
+
+	// Windowed sinc, T in destination texels. The window is not zero at its edge, so taps are placed in double
+	// precision: odd sizes put taps exactly on the edge and float rounding would flip them in and out.
+	float EvaluateKaiser(double T, float Width, float Alpha)
+	{
+		double Radius = Width * 0.5;
+		if (std::fabs(T) >= Radius)
+		{
+			return 0.0f;
+		}
+
+		double Ratio = T / Radius;
+		double Window = BesselI0(Alpha * std::sqrt(1.0 - Ratio * Ratio)) / BesselI0(Alpha);
+
+		return Sinc((float)T) * (float)Window;
+	}
+
+	uint32_t ResolveIndex(int32_t Index, uint32_t Size, bool bWrap)
+	{
+		int32_t SignedSize = (int32_t)Size;
+
+		if (bWrap)
+		{
+			return (uint32_t)(((Index % SignedSize) + SignedSize) % SignedSize);
+		}
+
+		return (uint32_t)std::min<int32_t>(std::max<int32_t>(Index, 0), SignedSize - 1);
+	}
+
+	void BuildKernel(uint32_t SrcSize, uint32_t DstSize, const TMipGenSettings& Settings, TFilterKernel& OutKernel)
+	{
+		OutKernel.First.resize(DstSize);
+		OutKernel.Count.resize(DstSize);
+		OutKernel.Taps.clear();
+
+		const double Scale = (double)SrcSize / (double)DstSize;
+
+		for (uint32_t i = 0; i < DstSize; i++)
+		{
+			uint32_t First = (uint32_t)OutKernel.Taps.size();
+
+			if (SrcSize == DstSize)
+			{
+				// Axis already at 1 texel
+				OutKernel.Taps.push_back({ i, 1.0f });
+			}
+			else if (Settings.Filter == EMipFilter::Box)
+			{
+				// Area coverage, exact for odd sizes too
+				double Low = i * Scale;
+				double High = (i + 1) * Scale;
+
+				for (int32_t j = (int32_t)std::floor(Low); j < (int32_t)std::ceil(High); j++)
+				{
+					float Weight = (float)(std::min<double>(High, (double)(j + 1)) - std::max<double>(Low, (double)j));
+					if (Weight > 0.0f)
+					{
+						OutKernel.Taps.push_back({ ResolveIndex(j, SrcSize, Settings.bWrap), Weight });
+					}
+				}
+			}
+			else
+			{
+				double Center = (i + 0.5) * Scale;
+				double Radius = Settings.KaiserWidth * 0.5 * Scale;
+
+				for (int32_t j = (int32_t)std::floor(Center - Radius); j <= (int32_t)std::ceil(Center + Radius); j++)
+				{
+					float Weight = EvaluateKaiser((j + 0.5 - Center) / Scale, Settings.KaiserWidth, Settings.KaiserAlpha);
+					if (Weight != 0.0f)
+					{
+						OutKernel.Taps.push_back({ ResolveIndex(j, SrcSize, Settings.bWrap), Weight });
+					}
+				}
+			}
+
+			uint32_t Count = (uint32_t)OutKernel.Taps.size() - First;
+
+			float WeightSum = 0.0f;
+			for (uint32_t t = First; t < First + Count; t++)
+			{
+				WeightSum += OutKernel.Taps[t].Weight;
+			}
+
+			for (uint32_t t = First; t < First + Count; t++)
+			{
+				OutKernel.Taps[t].Weight /= WeightSum;
+			}
+
+			OutKernel.First[i] = First;
+			OutKernel.Count[i] = Count;
+		}
+	}
+
+	// Dst[i] += Src[i] * Weight
+	void AccumulateScaled(float* Dst, const float* Src, float Weight, uint32_t FloatCount)
+	{
+		uint32_t i = 0;
+
+#if MIPGEN_USE_SSE
+		__m128 WeightVec = _mm_set1_ps(Weight);
+		for (; i + 4 <= FloatCount; i += 4)
+		{
+			__m128 Sum = _mm_add_ps(_mm_loadu_ps(Dst + i), _mm_mul_ps(_mm_loadu_ps(Src + i), WeightVec));
+			_mm_storeu_ps(Dst + i, Sum);
+		}
+#endif
+
+		for (; i < FloatCount; i++)
+		{
+			Dst[i] += Src[i] * Weight;
+		}
+	}
+
+	void FilterRow(const float* SrcRow, float* DstRow, uint32_t DstWidth, const TFilterKernel& Kernel)
+	{
+		for (uint32_t x = 0; x < DstWidth; x++)
+		{
+			float* DstPixel = DstRow + x * FloatsPerPixel;
+			DstPixel[0] = DstPixel[1] = DstPixel[2] = DstPixel[3] = 0.0f;
+
+			const TFilterTap* Taps = Kernel.Taps.data() + Kernel.First[x];
+			for (uint32_t t = 0; t < Kernel.Count[x]; t++)
+			{
+				AccumulateScaled(DstPixel, SrcRow + Taps[t].Index * FloatsPerPixel, Taps[t].Weight, FloatsPerPixel);
+			}
+		}
+	}
+
+	void RenormalizeRow(float* Row, uint32_t Width)
+	{
+		for (uint32_t x = 0; x < Width; x++)
+		{
+			float* Pixel = Row + x * FloatsPerPixel;
+
+			float NX = Pixel[0] * 2.0f - 1.0f;
+			float NY = Pixel[1] * 2.0f - 1.0f;
+			float NZ = Pixel[2] * 2.0f - 1.0f;
+			float Length = std::sqrt(NX * NX + NY * NY + NZ * NZ);
+
+			if (Length > 1e-6f)
+			{
+				NX /= Length;
+				NY /= Length;
+				NZ /= Length;
+			}
+			else
+			{
+				NX = 0.0f;
+				NY = 0.0f;
+				NZ = 1.0f;
+			}
+
+			Pixel[0] = NX * 0.5f + 0.5f;
+			Pixel[1] = NY * 0.5f + 0.5f;
+			Pixel[2] = NZ * 0.5f + 0.5f;
+		}
+	}
+
+	void DecodeRow(const uint8_t* SrcRow, float* DstRow, uint32_t Width, EDecodedImageFormat Format, const float* SRGBTable)
+	{
+		for (uint32_t x = 0; x < Width; x++)
+		{
+			float* Pixel = DstRow + x * FloatsPerPixel;
+
+			switch (Format)
+			{
+			case EDecodedImageFormat::R8:
+				Pixel[0] = SrcRow[x] / 255.0f;
+				Pixel[1] = 0.0f;
+				Pixel[2] = 0.0f;
+				Pixel[3] = 1.0f;
+				break;
+			case EDecodedImageFormat::RGBA8:
+				Pixel[0] = SRGBTable[SrcRow[x * 4 + 0]];
+				Pixel[1] = SRGBTable[SrcRow[x * 4 + 1]];
+				Pixel[2] = SRGBTable[SrcRow[x * 4 + 2]];
+				Pixel[3] = SrcRow[x * 4 + 3] / 255.0f;
+				break;
+			case EDecodedImageFormat::RGB32F:
+			{
+				const float* SrcPixel = reinterpret_cast<const float*>(SrcRow) + x * 3;
+				Pixel[0] = SrcPixel[0];
+				Pixel[1] = SrcPixel[1];
+				Pixel[2] = SrcPixel[2];
+				Pixel[3] = 1.0f;
+				break;
+			}
+			case EDecodedImageFormat::R9G9B9E5:
+			case EDecodedImageFormat::R11G11B10:
+			{
+				uint32_t Packed;
+				memcpy(&Packed, SrcRow + x * 4, sizeof(Packed));
+				if (Format == EDecodedImageFormat::R9G9B9E5)
+				{
+					UnpackR9G9B9E5(Packed, Pixel);
+				}
+				else
+				{
+					UnpackR11G11B10(Packed, Pixel);
+				}
+				Pixel[3] = 1.0f;
+				break;
+			}
+			}
+		}
+	}
+
+	void EncodeRow(const float* SrcRow, uint8_t* DstRow, uint32_t Width, EDecodedImageFormat Format, bool bSRGB)
+	{
+		for (uint32_t x = 0; x < Width; x++)
+		{
+			const float* Pixel = SrcRow + x * FloatsPerPixel;
+
+			switch (Format)
+			{
+			case EDecodedImageFormat::R8:
+				DstRow[x] = UnormToByte(Pixel[0]);
+				break;
+			case EDecodedImageFormat::RGBA8:
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					DstRow[x * 4 + c] = UnormToByte(bSRGB ? LinearToSRGB(Saturate(Pixel[c])) : Pixel[c]);
+				}
+				DstRow[x * 4 + 3] = UnormToByte(Pixel[3]);
+				break;
+			case EDecodedImageFormat::RGB32F:
+			{
+				// Sharp filters ring below zero around bright texels
+				float* DstPixel = reinterpret_cast<float*>(DstRow) + x * 3;
+				DstPixel[0] = std::max<float>(Pixel[0], 0.0f);
+				DstPixel[1] = std::max<float>(Pixel[1], 0.0f);
+				DstPixel[2] = std::max<float>(Pixel[2], 0.0f);
+				break;
+			}
+			case EDecodedImageFormat::R9G9B9E5:
+			case EDecodedImageFormat::R11G11B10:
+			{
+				// Negative ringing is clamped by the packing
+				uint32_t Packed = (Format == EDecodedImageFormat::R9G9B9E5) ? PackR9G9B9E5(Pixel) : PackR11G11B10(Pixel);
+				memcpy(DstRow + x * 4, &Packed, sizeof(Packed));
+				break;
+			}
+			}
+		}
+	}
+
+	template<typename FuncType>
+	void ForEachRowBlock(TThreadPool& ThreadPool, uint32_t RowCount, FuncType Func)
+	{
+		uint32_t BlockCount = (RowCount + RowsPerTask - 1) / RowsPerTask;
+
+		ThreadPool.ParallelFor(BlockCount, [&](uint32_t Block)
+		{
+			uint32_t RowEnd = std::min<uint32_t>((Block + 1) * RowsPerTask, RowCount);
+			for (uint32_t y = Block * RowsPerTask; y < RowEnd; y++)
+			{
+				Func(y);
+			}
+		});
+	}
+}
+
+uint32_t GetFullMipCount(uint32_t Width, uint32_t Height)
+{
+	uint32_t MipCount = 1;
+	uint32_t Size = std::max<uint32_t>(Width, Height);
+
+	while (Size > 1)
+	{
+		Size >>= 1;
+		MipCount++;
+	}
+
+	return MipCount;
+}
+
+void GenerateMips(TDecodedImage& Image, const TMipGenSettings& Settings, TThreadPool& ThreadPool)
+{
+	if (Image.Width == 0 || Image.Height == 0)
+	{
+		return;
+	}
+
+	uint32_t MipCount = GetFullMipCount(Image.Width, Image.Height);
+	if (Settings.MaxMipCount > 0)
+	{
+		MipCount = std::min<uint32_t>(MipCount, Settings.MaxMipCount);
+	}
+
+	const uint32_t BytesPerPixel = GetBytesPerPixel(Image.Format);
+
+	// Lay out all levels in one buffer
+	Image.Mips.resize(MipCount);
+
+	size_t TotalSize = 0;
+	for (uint32_t Level = 0; Level < MipCount; Level++)
+	{
+		TDecodedMip& Mip = Image.Mips[Level];
+		Mip.Width = std::max<uint32_t>(Image.Width >> Level, 1);
+		Mip.Height = std::max<uint32_t>(Image.Height >> Level, 1);
+		Mip.RowPitch = (Level == 0) ? Image.RowPitch : Mip.Width * BytesPerPixel;
+		Mip.Offset = TotalSize;
+
+		TotalSize += (size_t)Mip.RowPitch * Mip.Height;
+	}
+
+	if (MipCount == 1)
+	{
+		return;
+	}
+
+	Image.Data.resize(TotalSize);
+
+	// sRGB only applies to 8-bit color, R8 and float images are linear already
+	const bool bSRGB = Settings.bSRGB && !Settings.bNormalMap && Image.Format == EDecodedImageFormat::RGBA8;
+
+	float SRGBTable[256];
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		SRGBTable[i] = bSRGB ? SRGBToLinear(i / 255.0f) : i / 255.0f;
+	}
+
+	TFloatLevel SrcLevel;
+	SrcLevel.Width = Image.Width;
+	SrcLevel.Height = Image.Height;
+	SrcLevel.Pixels.resize((size_t)SrcLevel.Width * SrcLevel.Height * FloatsPerPixel);
+
+	ForEachRowBlock(ThreadPool, SrcLevel.Height, [&](uint32_t y)
+	{
+		DecodeRow(Image.Data.data() + (size_t)y * Image.RowPitch, SrcLevel.Pixels.data() + (size_t)y * SrcLevel.Width * FloatsPerPixel,
+			SrcLevel.Width, Image.Format, SRGBTable);
+	});
+
+	TFilterKernel KernelX;
+	TFilterKernel KernelY;
+	std::vector<float> TempPixels;
+
+	for (uint32_t Level = 1; Level < MipCount; Level++)
+	{
+		const TDecodedMip& Mip = Image.Mips[Level];
+
+		TFloatLevel DstLevel;
+		DstLevel.Width = Mip.Width;
+		DstLevel.Height = Mip.Height;
+		DstLevel.Pixels.resize((size_t)DstLevel.Width * DstLevel.Height * FloatsPerPixel);
+
+		BuildKernel(SrcLevel.Width, DstLevel.Width, Settings, KernelX);
+		BuildKernel(SrcLevel.Height, DstLevel.Height, Settings, KernelY);
+
+		// Horizontal pass, every source row
+		const size_t SrcRowFloats = (size_t)SrcLevel.Width * FloatsPerPixel;
+		const size_t DstRowFloats = (size_t)DstLevel.Width * FloatsPerPixel;
+		TempPixels.resize(DstRowFloats * SrcLevel.Height);
+
+		ForEachRowBlock(ThreadPool, SrcLevel.Height, [&](uint32_t y)
+		{
+			FilterRow(SrcLevel.Pixels.data() + y * SrcRowFloats, TempPixels.data() + y * DstRowFloats, DstLevel.Width, KernelX);
+		});
+
+		// Vertical pass, then write the level out
+		uint8_t* MipData = Image.Data.data() + Mip.Offset;
+
+		ForEachRowBlock(ThreadPool, DstLevel.Height, [&](uint32_t y)
+		{
+			float* DstRow = DstLevel.Pixels.data() + y * DstRowFloats;
+			std::fill(DstRow, DstRow + DstRowFloats, 0.0f);
+
+			const TFilterTap* Taps = KernelY.Taps.data() + KernelY.First[y];
+			for (uint32_t t = 0; t < KernelY.Count[y]; t++)
+			{
+				AccumulateScaled(DstRow, TempPixels.data() + Taps[t].Index * DstRowFloats, Taps[t].Weight, (uint32_t)DstRowFloats);
+			}
+
+			if (Settings.bNormalMap)
+			{
+				RenormalizeRow(DstRow, DstLevel.Width);
+			}
+
+			EncodeRow(DstRow, MipData + (size_t)y * Mip.RowPitch, DstLevel.Width, Image.Format, bSRGB);
+		});
+
+		SrcLevel = std::move(DstLevel);
+	}
+}
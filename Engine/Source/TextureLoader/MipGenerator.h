@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include "ImageDecoder.h"
+
+class TThreadPool;
+
+enum class EMipFilter
+{
+	Box,
+	Kaiser,
+};
+
+struct TMipGenSettings
+{
+	EMipFilter Filter = EMipFilter::Kaiser;
+
+	// Filter color channels in linear space, alpha is always linear
+	bool bSRGB = false;
+
+	// Renormalize xyz of tangent-space normal maps on every level
+	bool bNormalMap = false;
+
+	// Wrap filter taps around the edges for tiling textures, otherwise clamp
+	bool bWrap = false;
+
+	// Kaiser window, width in destination texels
+	float KaiserWidth = 3.0f;
+
+	float KaiserAlpha = 4.0f;
+
+	// 0 generates the full chain down to 1x1
+	uint32_t MaxMipCount = 0;
+};
+
+uint32_t GetFullMipCount(uint32_t Width, uint32_t Height);
+
+// Build the mip chain of Image on the CPU and pack it into Image.Data/Image.Mips.
+// Every level is filtered from the unquantized previous level, rows are split across the thread pool.
+void GenerateMips(TDecodedImage& Image, const TMipGenSettings& Settings, TThreadPool& ThreadPool);
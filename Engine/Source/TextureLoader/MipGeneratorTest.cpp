@@ -0,0 +1,433 @@
+#include "MipGenerator.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+// Checks GenerateMips against a straightforward double precision reference: direct 2D filtering of every level from
+// the unquantized previous one, with its own box coverage, Kaiser window and sRGB conversions. 8-bit levels must match
+// within one step. Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	const double Pi = 3.14159265358979323846;
+
+	struct TReferenceLevel
+	{
+		uint32_t Width = 0;
+
+		uint32_t Height = 0;
+
+		// 4 channels per pixel
+		std::vector<double> Pixels;
+	};
+
+	struct TReferenceTap
+	{
+		uint32_t Index;
+
+		double Weight;
+	};
+
+	double ReferenceSRGBToLinear(double Value)
+	{
+		return Value <= 0.04045 ? Value / 12.92 : std::pow((Value + 0.055) / 1.055, 2.4);
+	}
+
+	double ReferenceLinearToSRGB(double Value)
+	{
+		return Value <= 0.0031308 ? Value * 12.92 : 1.055 * std::pow(Value, 1.0 / 2.4) - 0.055;
+	}
+
+	// Power series of the zeroth order modified Bessel function
+	double ReferenceBesselI0(double X)
+	{
+		double Sum = 0.0;
+		double Term = 1.0;
+		for (int k = 0; k < 100; k++)
+		{
+			if (k > 0)
+			{
+				Term *= (X * X / 4.0) / ((double)k * k);
+			}
+			Sum += Term;
+		}
+
+		return Sum;
+	}
+
+	uint32_t ReferenceIndex(int32_t Index, uint32_t Size, bool bWrap)
+	{
+		if (bWrap)
+		{
+			return (uint32_t)(((Index % (int32_t)Size) + (int32_t)Size) % (int32_t)Size);
+		}
+
+		return (uint32_t)std::clamp<int32_t>(Index, 0, (int32_t)Size - 1);
+	}
+
+	// 1D weights of destination texel i, normalized to sum to one
+	std::vector<TReferenceTap> ReferenceTaps(uint32_t i, uint32_t SrcSize, uint32_t DstSize, const TMipGenSettings& Settings)
+	{
+		std::vector<TReferenceTap> Taps;
+		if (SrcSize == DstSize)
+		{
+			Taps.push_back({ i, 1.0 });
+			return Taps;
+		}
+
+		const double Scale = (double)SrcSize / DstSize;
+		if (Settings.Filter == EMipFilter::Box)
+		{
+			// Overlap of source texel j with the footprint of destination texel i
+			for (uint32_t j = 0; j < SrcSize; j++)
+			{
+				double Overlap = std::min<double>((i + 1) * Scale, j + 1.0) - std::max<double>(i * Scale, (double)j);
+				if (Overlap > 1e-9)
+				{
+					Taps.push_back({ j, Overlap });
+				}
+			}
+		}
+		else
+		{
+			const double Center = (i + 0.5) * Scale;
+			const double Radius = Settings.KaiserWidth * 0.5;
+			for (int32_t j = (int32_t)std::floor(Center - Radius * Scale) - 1; j <= (int32_t)std::ceil(Center + Radius * Scale) + 1; j++)
+			{
+				const double T = (j + 0.5 - Center) / Scale;
+				if (std::fabs(T) >= Radius)
+				{
+					continue;
+				}
+
+				const double Sinc = std::fabs(T) < 1e-9 ? 1.0 : std::sin(Pi * T) / (Pi * T);
+				const double Ratio = T / Radius;
+				const double Window = ReferenceBesselI0(Settings.KaiserAlpha * std::sqrt(1.0 - Ratio * Ratio)) / ReferenceBesselI0(Settings.KaiserAlpha);
+				Taps.push_back({ ReferenceIndex(j, SrcSize, Settings.bWrap), Sinc * Window });
+			}
+		}
+
+		double Sum = 0.0;
+		for (const TReferenceTap& Tap : Taps)
+		{
+			Sum += Tap.Weight;
+		}
+		for (TReferenceTap& Tap : Taps)
+		{
+			Tap.Weight /= Sum;
+		}
+
+		return Taps;
+	}
+
+	// Direct 2D filter, every destination texel sums the outer product of its row and column taps
+	TReferenceLevel ReferenceDownsample(const TReferenceLevel& Src, const TMipGenSettings& Settings)
+	{
+		TReferenceLevel Dst;
+		Dst.Width = std::max<uint32_t>(Src.Width / 2, 1);
+		Dst.Height = std::max<uint32_t>(Src.Height / 2, 1);
+		Dst.Pixels.assign((size_t)Dst.Width * Dst.Height * 4, 0.0);
+
+		for (uint32_t y = 0; y < Dst.Height; y++)
+		{
+			const std::vector<TReferenceTap> TapsY = ReferenceTaps(y, Src.Height, Dst.Height, Settings);
+			for (uint32_t x = 0; x < Dst.Width; x++)
+			{
+				const std::vector<TReferenceTap> TapsX = ReferenceTaps(x, Src.Width, Dst.Width, Settings);
+				double* Pixel = &Dst.Pixels[((size_t)y * Dst.Width + x) * 4];
+
+				for (const TReferenceTap& TapY : TapsY)
+				{
+					for (const TReferenceTap& TapX : TapsX)
+					{
+						const double* SrcPixel = &Src.Pixels[((size_t)TapY.Index * Src.Width + TapX.Index) * 4];
+						for (int c = 0; c < 4; c++)
+						{
+							Pixel[c] += SrcPixel[c] * TapX.Weight * TapY.Weight;
+						}
+					}
+				}
+
+				if (Settings.bNormalMap)
+				{
+					double N[3] = { Pixel[0] * 2.0 - 1.0, Pixel[1] * 2.0 - 1.0, Pixel[2] * 2.0 - 1.0 };
+					double Length = std::sqrt(N[0] * N[0] + N[1] * N[1] + N[2] * N[2]);
+					for (int c = 0; c < 3; c++)
+					{
+						Pixel[c] = (Length > 1e-6 ? N[c] / Length : (c == 2 ? 1.0 : 0.0)) * 0.5 + 0.5;
+					}
+				}
+			}
+		}
+
+		return Dst;
+	}
+
+	TDecodedImage MakeRGBA8Image(uint32_t Width, uint32_t Height, uint32_t Seed)
+	{
+		TDecodedImage Image;
+		Image.Width = Width;
+		Image.Height = Height;
+		Image.Format = EDecodedImageFormat::RGBA8;
+		Image.RowPitch = Width * 4;
+		Image.Data.resize((size_t)Image.RowPitch * Height);
+
+		// Smooth gradients under noise, so both low and high frequencies are filtered
+		std::mt19937 Random(Seed);
+		std::uniform_int_distribution<int> Noise(-40, 40);
+		for (uint32_t y = 0; y < Height; y++)
+		{
+			for (uint32_t x = 0; x < Width; x++)
+			{
+				uint8_t* Pixel = &Image.Data[(size_t)y * Image.RowPitch + x * 4];
+				Pixel[0] = (uint8_t)std::clamp<int>((int)(x * 255 / Width) + Noise(Random), 0, 255);
+				Pixel[1] = (uint8_t)std::clamp<int>((int)(y * 255 / Height) + Noise(Random), 0, 255);
+				Pixel[2] = (uint8_t)std::clamp<int>(128 + Noise(Random) * 3, 0, 255);
+				Pixel[3] = (uint8_t)(((x / 4 + y / 4) % 2) ? 255 : 0);
+			}
+		}
+
+		return Image;
+	}
+
+	// Largest difference in 8-bit steps between every generated level and the reference chain
+	int CompareRGBA8Chain(const TDecodedImage& Source, const TMipGenSettings& Settings)
+	{
+		TDecodedImage Image = Source;
+		GenerateMips(Image, Settings, TThreadPool::Get());
+
+		const bool bSRGB = Settings.bSRGB && !Settings.bNormalMap;
+
+		TReferenceLevel Level;
+		Level.Width = Source.Width;
+		Level.Height = Source.Height;
+		Level.Pixels.resize((size_t)Level.Width * Level.Height * 4);
+		for (size_t i = 0; i < Level.Pixels.size(); i++)
+		{
+			const double Value = Source.Data[i] / 255.0;
+			Level.Pixels[i] = (bSRGB && i % 4 != 3) ? ReferenceSRGBToLinear(Value) : Value;
+		}
+
+		int MaxError = 0;
+		for (uint32_t MipIndex = 1; MipIndex < (uint32_t)Image.Mips.size(); MipIndex++)
+		{
+			Level = ReferenceDownsample(Level, Settings);
+
+			const TDecodedMip& Mip = Image.Mips[MipIndex];
+			if (Mip.Width != Level.Width || Mip.Height != Level.Height)
+			{
+				return 255;
+			}
+
+			for (uint32_t y = 0; y < Mip.Height; y++)
+			{
+				for (uint32_t x = 0; x < Mip.Width; x++)
+				{
+					for (int c = 0; c < 4; c++)
+					{
+						double Value = std::clamp(Level.Pixels[((size_t)y * Level.Width + x) * 4 + c], 0.0, 1.0);
+						if (bSRGB && c != 3)
+						{
+							Value = ReferenceLinearToSRGB(Value);
+						}
+
+						const int Expected = (int)(Value * 255.0 + 0.5);
+						const int Actual = Image.Data[Mip.Offset + (size_t)y * Mip.RowPitch + x * 4 + c];
+						MaxError = std::max<int>(MaxError, std::abs(Actual - Expected));
+					}
+				}
+			}
+		}
+
+		return MaxError;
+	}
+
+	void TestLayout()
+	{
+		Check(GetFullMipCount(1, 1) == 1, "1x1 has one mip");
+		Check(GetFullMipCount(256, 256) == 9, "256x256 has nine mips");
+		Check(GetFullMipCount(300, 7) == 9, "mip count follows the larger side");
+
+		TDecodedImage Image = MakeRGBA8Image(40, 12, 1);
+		TMipGenSettings Settings;
+		GenerateMips(Image, Settings, TThreadPool::Get());
+
+		bool bLayoutValid = Image.Mips.size() == 6;
+		size_t Offset = 0;
+		for (uint32_t Level = 0; Level < (uint32_t)Image.Mips.size() && bLayoutValid; Level++)
+		{
+			const TDecodedMip& Mip = Image.Mips[Level];
+			bLayoutValid = Mip.Width == std::max<uint32_t>(40 >> Level, 1) && Mip.Height == std::max<uint32_t>(12 >> Level, 1)
+				&& Mip.RowPitch == Mip.Width * 4 && Mip.Offset == Offset;
+			Offset += (size_t)Mip.RowPitch * Mip.Height;
+		}
+
+		Check(bLayoutValid && Image.Data.size() == Offset, "levels are packed back to back down to 1x1");
+
+		TDecodedImage Capped = MakeRGBA8Image(64, 64, 1);
+		Settings.MaxMipCount = 3;
+		GenerateMips(Capped, Settings, TThreadPool::Get());
+		Check(Capped.Mips.size() == 3, "MaxMipCount caps the chain");
+	}
+
+	void TestReferenceChains()
+	{
+		struct TCase
+		{
+			const char* Name;
+
+			uint32_t Width;
+
+			uint32_t Height;
+
+			EMipFilter Filter;
+
+			bool bSRGB;
+
+			bool bWrap;
+		};
+
+		const TCase Cases[] =
+		{
+			{ "Box linear 64x64", 64, 64, EMipFilter::Box, false, false },
+			{ "Box sRGB 64x32", 64, 32, EMipFilter::Box, true, false },
+			{ "Box odd 37x23", 37, 23, EMipFilter::Box, false, false },
+			{ "Kaiser linear clamp 64x64", 64, 64, EMipFilter::Kaiser, false, false },
+			{ "Kaiser sRGB wrap 64x48", 64, 48, EMipFilter::Kaiser, true, true },
+			{ "Kaiser odd wrap 45x19", 45, 19, EMipFilter::Kaiser, false, true },
+		};
+
+		for (const TCase& Case : Cases)
+		{
+			TMipGenSettings Settings;
+			Settings.Filter = Case.Filter;
+			Settings.bSRGB = Case.bSRGB;
+			Settings.bWrap = Case.bWrap;
+
+			const int MaxError = CompareRGBA8Chain(MakeRGBA8Image(Case.Width, Case.Height, Case.Width * 31 + Case.Height), Settings);
+			printf("%-28s max error %d / 255\n", Case.Name, MaxError);
+
+			Check(MaxError <= 1, Case.Name);
+		}
+	}
+
+	void TestNormalMap()
+	{
+		TDecodedImage Image = MakeRGBA8Image(64, 64, 5);
+
+		TMipGenSettings Settings;
+		Settings.bNormalMap = true;
+		Settings.bSRGB = true;
+
+		const int MaxError = CompareRGBA8Chain(Image, Settings);
+		printf("%-28s max error %d / 255\n", "Kaiser normal map 64x64", MaxError);
+		Check(MaxError <= 1, "normal map levels match the renormalized reference");
+
+		GenerateMips(Image, Settings, TThreadPool::Get());
+
+		double MaxLengthError = 0.0;
+		for (uint32_t Level = 1; Level < (uint32_t)Image.Mips.size(); Level++)
+		{
+			const TDecodedMip& Mip = Image.Mips[Level];
+			for (uint32_t y = 0; y < Mip.Height; y++)
+			{
+				for (uint32_t x = 0; x < Mip.Width; x++)
+				{
+					const uint8_t* Pixel = &Image.Data[Mip.Offset + (size_t)y * Mip.RowPitch + x * 4];
+					double N[3] = { Pixel[0] / 127.5 - 1.0, Pixel[1] / 127.5 - 1.0, Pixel[2] / 127.5 - 1.0 };
+					MaxLengthError = std::max<double>(MaxLengthError, std::fabs(std::sqrt(N[0] * N[0] + N[1] * N[1] + N[2] * N[2]) - 1.0));
+				}
+			}
+		}
+
+		// Three channels quantized to 1/127.5
+		Check(MaxLengthError < 0.015, "normal map levels stay unit length");
+	}
+
+	void TestConstantAndEnergy()
+	{
+		// Constant images stay constant, Kaiser weights are normalized so ringing can not appear
+		TDecodedImage Constant = MakeRGBA8Image(32, 32, 9);
+		for (size_t i = 0; i < Constant.Data.size(); i++)
+		{
+			Constant.Data[i] = (uint8_t)(i % 4 == 3 ? 200 : 90 + (i % 4) * 20);
+		}
+
+		TMipGenSettings Settings;
+		Settings.bSRGB = true;
+		GenerateMips(Constant, Settings, TThreadPool::Get());
+
+		bool bConstant = true;
+		const TDecodedMip& Last = Constant.Mips.back();
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			bConstant &= Constant.Data[Last.Offset + c] == Constant.Data[c];
+		}
+		Check(bConstant, "constant image stays constant through sRGB Kaiser mips");
+
+		// Box filtered power of two HDR keeps its mean on every level
+		TDecodedImage HDR;
+		HDR.Width = 64;
+		HDR.Height = 64;
+		HDR.Format = EDecodedImageFormat::RGB32F;
+		HDR.RowPitch = HDR.Width * 12;
+		HDR.Data.resize((size_t)HDR.RowPitch * HDR.Height);
+
+		std::mt19937 Random(3);
+		std::exponential_distribution<float> Radiance(0.5f);
+		std::vector<float> Texels((size_t)HDR.Width * HDR.Height * 3);
+		double SourceMean = 0.0;
+		for (float& Texel : Texels)
+		{
+			Texel = Radiance(Random);
+			SourceMean += Texel;
+		}
+		SourceMean /= Texels.size();
+		memcpy(HDR.Data.data(), Texels.data(), HDR.Data.size());
+
+		Settings = TMipGenSettings();
+		Settings.Filter = EMipFilter::Box;
+		GenerateMips(HDR, Settings, TThreadPool::Get());
+
+		double MaxMeanError = 0.0;
+		for (const TDecodedMip& Mip : HDR.Mips)
+		{
+			const float* Level = reinterpret_cast<const float*>(HDR.Data.data() + Mip.Offset);
+			double Mean = 0.0;
+			for (size_t i = 0; i < (size_t)Mip.Width * Mip.Height * 3; i++)
+			{
+				Mean += Level[i];
+			}
+			Mean /= (double)Mip.Width * Mip.Height * 3;
+			MaxMeanError = std::max<double>(MaxMeanError, std::fabs(Mean - SourceMean) / SourceMean);
+		}
+
+		printf("%-28s max relative mean error %.2e\n", "Box RGB32F 64x64", MaxMeanError);
+		Check(MaxMeanError < 1e-5, "box filtered HDR keeps its mean on every level");
+	}
+}
+
+int main()
+{
+	TestLayout();
+	TestReferenceChains();
+	TestNormalMap();
+	TestConstantAndEnergy();
+
+	printf("%s\n", FailureCount == 0 ? "All mip generator checks passed" : "Mip generator checks FAILED");
+
+	return FailureCount;
+}
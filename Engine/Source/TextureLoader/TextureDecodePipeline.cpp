@@ -0,0 +1,136 @@
+#include "TextureDecodePipeline.h"
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+std::string TTextureDecodeStats::ToString() const
+{
+	char Buffer[256];
+	snprintf(Buffer, sizeof(Buffer), "Texture decode: %u files (%u failed), %.1f MB read, %.1f MB decoded, read %.2fs, total %.2fs, %.1f MB/s (%.1f MB/s decoded)\n",
+		FileCount, FailedCount, BytesRead / (1024.0 * 1024.0), BytesDecoded / (1024.0 * 1024.0), ReadSeconds, WallSeconds,
+		GetThroughputMBps(), GetDecodedMBps());
+
+	return std::string(Buffer);
+}
+
+TTextureDecodePipeline::TTextureDecodePipeline(TThreadPool& InThreadPool, const TTextureDecodeSettings& InSettings)
+	:ThreadPool(InThreadPool), Settings(InSettings)
+{
+}
+
+bool TTextureDecodePipeline::ReadFile(const std::string& FilePath, uint32_t ChunkSize, std::vector<uint8_t>& OutData)
+{
+	std::ifstream File(FilePath, std::ios::binary | std::ios::ate);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	// Size the buffer once, then fill it with large sequential reads
+	std::streamoff FileSize = File.tellg();
+	if (FileSize <= 0)
+	{
+		return false;
+	}
+
+	File.seekg(0, std::ios::beg);
+	OutData.resize((size_t)FileSize);
+
+	size_t Offset = 0;
+	while (Offset < OutData.size())
+	{
+		size_t ReadSize = std::min<size_t>(ChunkSize, OutData.size() - Offset);
+		if (!File.read(reinterpret_cast<char*>(OutData.data() + Offset), ReadSize))
+		{
+			return false;
+		}
+		Offset += ReadSize;
+	}
+
+	return true;
+}
+
+void TTextureDecodePipeline::DecodeFiles(const std::vector<std::string>& FilePaths, std::vector<TTextureDecodeResult>& OutResults)
+{
+	typedef std::chrono::steady_clock TClock;
+	TClock::time_point StartTime = TClock::now();
+
+	OutResults.clear();
+	OutResults.resize(FilePaths.size());
+
+	std::mutex Mutex;
+	std::condition_variable Condition;
+	uint64_t BufferedBytes = 0;
+	uint32_t OutstandingCount = 0;
+	uint64_t DecodedBytes = 0;
+	uint32_t FailedCount = 0;
+
+	double ReadSeconds = 0.0;
+	uint64_t BytesRead = 0;
+
+	for (size_t Index = 0; Index < FilePaths.size(); Index++)
+	{
+		TClock::time_point ReadStart = TClock::now();
+
+		auto FileData = std::make_shared<std::vector<uint8_t>>();
+		bool bRead = ReadFile(FilePaths[Index], Settings.ReadChunkSize, *FileData);
+
+		ReadSeconds += std::chrono::duration<double>(TClock::now() - ReadStart).count();
+
+		if (!bRead)
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			FailedCount++;
+			continue;
+		}
+
+		BytesRead += FileData->size();
+
+		EImageFileType FileType = GetImageFileType(FilePaths[Index]);
+		uint64_t FileSize = FileData->size();
+
+		{
+			// Back-pressure, wait for decoders to drain before reading more
+			std::unique_lock<std::mutex> Lock(Mutex);
+			Condition.wait(Lock, [&]() { return BufferedBytes == 0 || BufferedBytes + FileSize <= Settings.MaxBufferedBytes; });
+
+			BufferedBytes += FileSize;
+			OutstandingCount++;
+		}
+
+		TTextureDecodeResult* Result = &OutResults[Index];
+		ThreadPool.Enqueue([&, Result, FileData, FileType, FileSize]()
+		{
+			Result->bSuccess = DecodeImageFromMemory(FileData->data(), FileData->size(), FileType, Result->Image);
+
+			std::unique_lock<std::mutex> Lock(Mutex);
+			BufferedBytes -= FileSize;
+			OutstandingCount--;
+			if (Result->bSuccess)
+			{
+				DecodedBytes += Result->Image.Data.size();
+			}
+			else
+			{
+				FailedCount++;
+			}
+			Condition.notify_all();
+		});
+	}
+
+	{
+		std::unique_lock<std::mutex> Lock(Mutex);
+		Condition.wait(Lock, [&]() { return OutstandingCount == 0; });
+	}
+
+	Stats.FileCount = (uint32_t)FilePaths.size();
+	Stats.FailedCount = FailedCount;
+	Stats.BytesRead = BytesRead;
+	Stats.BytesDecoded = DecodedBytes;
+	Stats.ReadSeconds = ReadSeconds;
+	Stats.WallSeconds = std::chrono::duration<double>(TClock::now() - StartTime).count();
+}
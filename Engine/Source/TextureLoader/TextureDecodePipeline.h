@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ImageDecoder.h"
+#include "Utils/ThreadPool.h"
+#include <string>
+#include <vector>
+
+struct TTextureDecodeSettings
+{
+	// Files are read with sequential reads of this size
+	uint32_t ReadChunkSize = 8 * 1024 * 1024;
+
+	// Read-ahead stops when this many file bytes are waiting for a decoder
+	uint64_t MaxBufferedBytes = 256 * 1024 * 1024;
+};
+
+struct TTextureDecodeResult
+{
+	bool bSuccess = false;
+
+	TDecodedImage Image;
+};
+
+struct TTextureDecodeStats
+{
+	uint32_t FileCount = 0;
+
+	uint32_t FailedCount = 0;
+
+	uint64_t BytesRead = 0;
+
+	uint64_t BytesDecoded = 0;
+
+	double ReadSeconds = 0.0;
+
+	double WallSeconds = 0.0;
+
+	// Compressed file bytes per second of wall time
+	double GetThroughputMBps() const { return WallSeconds > 0.0 ? BytesRead / (1024.0 * 1024.0) / WallSeconds : 0.0; }
+
+	// Decoded texel bytes per second of wall time
+	double GetDecodedMBps() const { return WallSeconds > 0.0 ? BytesDecoded / (1024.0 * 1024.0) / WallSeconds : 0.0; }
+
+	std::string ToString() const;
+};
+
+// Reads texture files one after another on the calling thread and decodes them on a thread pool.
+// Read-ahead is bounded by MaxBufferedBytes so a large batch doesn't hold every compressed file in memory.
+class TTextureDecodePipeline
+{
+public:
+	TTextureDecodePipeline(TThreadPool& InThreadPool, const TTextureDecodeSettings& InSettings = TTextureDecodeSettings());
+
+public:
+	// PNG/JPG/HDR files, results are in FilePaths order
+	void DecodeFiles(const std::vector<std::string>& FilePaths, std::vector<TTextureDecodeResult>& OutResults);
+
+	const TTextureDecodeStats& GetStats() const { return Stats; }
+
+	static bool ReadFile(const std::string& FilePath, uint32_t ChunkSize, std::vector<uint8_t>& OutData);
+
+private:
+	TThreadPool& ThreadPool;
+
+	TTextureDecodeSettings Settings;
+
+	TTextureDecodeStats Stats;
+};
@@ -0,0 +1,166 @@
+#include "TextureDecodePipeline.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+// Decodes every PNG/JPG/HDR in Engine/Resource/Textures one after another on this thread, then through
+// TTextureDecodePipeline, and reports both throughputs. The pooled results must match the serial ones in order, also
+// when back-pressure lets only one file be buffered. DDS files have no decode step and are only read, their read
+// throughput is reported for comparison. Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	typedef std::chrono::steady_clock TClock;
+
+	double ElapsedSeconds(TClock::time_point StartTime)
+	{
+		return std::chrono::duration<double>(TClock::now() - StartTime).count();
+	}
+
+	bool IsSameImage(const TDecodedImage& A, const TDecodedImage& B)
+	{
+		return A.Width == B.Width && A.Height == B.Height && A.Format == B.Format && A.RowPitch == B.RowPitch && A.Data == B.Data;
+	}
+
+	bool IsSameResults(const std::vector<TTextureDecodeResult>& A, const std::vector<TTextureDecodeResult>& B)
+	{
+		if (A.size() != B.size())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < A.size(); i++)
+		{
+			if (A[i].bSuccess != B[i].bSuccess || !IsSameImage(A[i].Image, B[i].Image))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+int main()
+{
+	const std::filesystem::path TextureDir = std::filesystem::path(SOLUTION_DIR) / "Engine/Resource/Textures";
+
+	std::vector<std::string> DecodeFilePaths;
+	std::vector<std::string> DDSFilePaths;
+	for (const auto& Entry : std::filesystem::directory_iterator(TextureDir))
+	{
+		const std::string FilePath = Entry.path().string();
+		const EImageFileType FileType = GetImageFileType(FilePath);
+		if (FileType == EImageFileType::PNG || FileType == EImageFileType::JPG || FileType == EImageFileType::HDR)
+		{
+			DecodeFilePaths.push_back(FilePath);
+		}
+		else if (FileType == EImageFileType::DDS)
+		{
+			DDSFilePaths.push_back(FilePath);
+		}
+	}
+	std::sort(DecodeFilePaths.begin(), DecodeFilePaths.end());
+
+	Check(!DecodeFilePaths.empty(), "the texture folder holds PNG/JPG/HDR files");
+
+	TTextureDecodeSettings Settings;
+
+	// Serial reference, read and decode each file before the next
+	std::vector<TTextureDecodeResult> SerialResults(DecodeFilePaths.size());
+	uint64_t SerialBytesRead = 0;
+	uint64_t SerialBytesDecoded = 0;
+	auto StartTime = TClock::now();
+	for (size_t i = 0; i < DecodeFilePaths.size(); i++)
+	{
+		std::vector<uint8_t> FileData;
+		if (TTextureDecodePipeline::ReadFile(DecodeFilePaths[i], Settings.ReadChunkSize, FileData))
+		{
+			SerialBytesRead += FileData.size();
+			SerialResults[i].bSuccess = DecodeImageFromMemory(FileData.data(), FileData.size(), GetImageFileType(DecodeFilePaths[i]), SerialResults[i].Image);
+			SerialBytesDecoded += SerialResults[i].Image.Data.size();
+		}
+	}
+	const double SerialSeconds = ElapsedSeconds(StartTime);
+	const double SerialMBps = SerialBytesRead / (1024.0 * 1024.0) / SerialSeconds;
+
+	bool bAllDecoded = true;
+	for (const TTextureDecodeResult& Result : SerialResults)
+	{
+		bAllDecoded &= Result.bSuccess;
+	}
+	Check(bAllDecoded, "serial: every file decodes");
+
+	printf("Serial: %zu files, %.1f MB read, %.1f MB decoded in %.2fs, %.1f MB/s\n", DecodeFilePaths.size(),
+		SerialBytesRead / (1024.0 * 1024.0), SerialBytesDecoded / (1024.0 * 1024.0), SerialSeconds, SerialMBps);
+
+	TThreadPool ThreadPool;
+
+	{
+		TTextureDecodePipeline Pipeline(ThreadPool, Settings);
+		std::vector<TTextureDecodeResult> Results;
+		Pipeline.DecodeFiles(DecodeFilePaths, Results);
+
+		const TTextureDecodeStats& Stats = Pipeline.GetStats();
+		printf("Pooled: %s", Stats.ToString().c_str());
+		printf("Pooled over serial: %.2fx\n", Stats.GetThroughputMBps() / SerialMBps);
+
+		Check(IsSameResults(SerialResults, Results), "pooled: results match the serial decode in file order");
+		Check(Stats.FileCount == DecodeFilePaths.size() && Stats.FailedCount == 0, "pooled: stats count every file");
+		Check(Stats.BytesRead == SerialBytesRead && Stats.BytesDecoded == SerialBytesDecoded, "pooled: stats count every byte");
+	}
+
+	// One byte of read-ahead, each file waits until the previous decodes have drained
+	{
+		TTextureDecodeSettings TightSettings;
+		TightSettings.MaxBufferedBytes = 1;
+		TightSettings.ReadChunkSize = 64 * 1024;
+
+		TTextureDecodePipeline Pipeline(ThreadPool, TightSettings);
+		std::vector<TTextureDecodeResult> Results;
+		Pipeline.DecodeFiles(DecodeFilePaths, Results);
+
+		printf("Pooled, no read-ahead: %s", Pipeline.GetStats().ToString().c_str());
+		Check(IsSameResults(SerialResults, Results), "back-pressure: results match with no read-ahead");
+	}
+
+	// Missing files fail without holding up the others
+	{
+		std::vector<std::string> FilePaths = { DecodeFilePaths[0], (TextureDir / "Missing.png").string(), DecodeFilePaths[0] };
+
+		TTextureDecodePipeline Pipeline(ThreadPool, Settings);
+		std::vector<TTextureDecodeResult> Results;
+		Pipeline.DecodeFiles(FilePaths, Results);
+
+		Check(Results.size() == 3 && Results[0].bSuccess && !Results[1].bSuccess && Results[2].bSuccess, "missing: only the missing file fails");
+		Check(Pipeline.GetStats().FailedCount == 1, "missing: counted as failed");
+	}
+
+	// DDS is uploaded as stored, loading one is a read
+	uint64_t DDSBytes = 0;
+	StartTime = TClock::now();
+	for (const std::string& FilePath : DDSFilePaths)
+	{
+		std::vector<uint8_t> FileData;
+		TTextureDecodePipeline::ReadFile(FilePath, Settings.ReadChunkSize, FileData);
+		DDSBytes += FileData.size();
+	}
+	const double DDSSeconds = ElapsedSeconds(StartTime);
+	printf("DDS: %zu files, %.1f MB read in %.3fs, %.1f MB/s\n", DDSFilePaths.size(), DDSBytes / (1024.0 * 1024.0), DDSSeconds,
+		DDSSeconds > 0.0 ? DDSBytes / (1024.0 * 1024.0) / DDSSeconds : 0.0);
+
+	printf("%s\n", FailureCount == 0 ? "All texture decode pipeline checks passed" : "Texture decode pipeline checks FAILED");
+
+	return FailureCount;
+}
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
 class TFormatConvert
 {
 public:
@@ -12,10 +17,43 @@ public:
 			return std::string();
 		}
 
+#ifdef _WIN32
 		int SizeNeeded = WideCharToMultiByte(CP_UTF8, 0, &WStr[0], (int)WStr.size(), NULL, 0, NULL, NULL);
 		std::string Str(SizeNeeded, 0);
 		WideCharToMultiByte(CP_UTF8, 0, &WStr[0], (int)WStr.size(), &Str[0], SizeNeeded, NULL, NULL);
 		return Str;
+#else
+		// wchar_t holds UTF-32 code points outside Windows
+		std::string Str;
+		Str.reserve(WStr.size());
+		for (wchar_t Char : WStr)
+		{
+			const uint32_t CodePoint = (uint32_t)Char;
+			if (CodePoint < 0x80)
+			{
+				Str.push_back((char)CodePoint);
+			}
+			else if (CodePoint < 0x800)
+			{
+				Str.push_back((char)(0xC0 | (CodePoint >> 6)));
+				Str.push_back((char)(0x80 | (CodePoint & 0x3F)));
+			}
+			else if (CodePoint < 0x10000)
+			{
+				Str.push_back((char)(0xE0 | (CodePoint >> 12)));
+				Str.push_back((char)(0x80 | ((CodePoint >> 6) & 0x3F)));
+				Str.push_back((char)(0x80 | (CodePoint & 0x3F)));
+			}
+			else
+			{
+				Str.push_back((char)(0xF0 | (CodePoint >> 18)));
+				Str.push_back((char)(0x80 | ((CodePoint >> 12) & 0x3F)));
+				Str.push_back((char)(0x80 | ((CodePoint >> 6) & 0x3F)));
+				Str.push_back((char)(0x80 | (CodePoint & 0x3F)));
+			}
+		}
+		return Str;
+#endif
 	}
 
 	static std::wstring StrToWStr(const std::string& Str)
@@ -25,10 +63,33 @@ public:
 			return std::wstring();
 		}
 
+#ifdef _WIN32
 		int SizeNeeded = MultiByteToWideChar(CP_UTF8, 0, &Str[0], (int)Str.size(), NULL, 0);
 		std::wstring WStr(SizeNeeded, 0);
 		MultiByteToWideChar(CP_UTF8, 0, &Str[0], (int)Str.size(), &WStr[0], SizeNeeded);
 		return WStr;
+#else
+		// Malformed sequences become U+FFFD like MultiByteToWideChar
+		std::wstring WStr;
+		WStr.reserve(Str.size());
+		for (size_t i = 0; i < Str.size();)
+		{
+			const uint8_t Lead = (uint8_t)Str[i];
+			const size_t Length = (Lead < 0x80) ? 1 : ((Lead >> 5) == 0x6) ? 2 : ((Lead >> 4) == 0xE) ? 3 : ((Lead >> 3) == 0x1E) ? 4 : 0;
+
+			bool bValid = Length > 0 && i + Length <= Str.size();
+			uint32_t CodePoint = (Length == 1) ? Lead : (Lead & (0x7F >> Length));
+			for (size_t j = 1; bValid && j < Length; j++)
+			{
+				const uint8_t Continuation = (uint8_t)Str[i + j];
+				bValid = (Continuation & 0xC0) == 0x80;
+				CodePoint = (CodePoint << 6) | (Continuation & 0x3F);
+			}
+
+			WStr.push_back(bValid ? (wchar_t)CodePoint : (wchar_t)0xFFFD);
+			i += bValid ? Length : 1;
+		}
+		return WStr;
+#endif
 	}
 };
-
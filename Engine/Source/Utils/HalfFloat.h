@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// IEEE 754 half precision conversions for textures written on the CPU
+class THalfFloat
+{
+public:
+	// Round to nearest even, overflow goes to infinity
+	static uint16_t FromFloat(float Value)
+	{
+		uint32_t Bits;
+		memcpy(&Bits, &Value, sizeof(Bits));
+
+		const uint32_t Sign = (Bits >> 16) & 0x8000;
+		const int32_t FloatExponent = (int32_t)((Bits >> 23) & 0xFF);
+		uint32_t Mantissa = Bits & 0x7FFFFF;
+
+		if (FloatExponent == 0xFF)
+		{
+			return (uint16_t)(Sign | 0x7C00 | (Mantissa ? 0x200 : 0));
+		}
+
+		const int32_t Exponent = FloatExponent - 127 + 15;
+		if (Exponent >= 31)
+		{
+			return (uint16_t)(Sign | 0x7C00);
+		}
+
+		// Round to nearest even, a mantissa carry correctly bumps the exponent
+		if (Exponent <= 0)
+		{
+			if (Exponent < -10)
+			{
+				return (uint16_t)Sign;
+			}
+
+			Mantissa |= 0x800000;
+			const uint32_t Shift = (uint32_t)(14 - Exponent);
+			uint32_t Half = Mantissa >> Shift;
+			const uint32_t Rest = Mantissa & ((1u << Shift) - 1);
+			const uint32_t HalfWay = 1u << (Shift - 1);
+			if (Rest > HalfWay || (Rest == HalfWay && (Half & 1)))
+			{
+				Half++;
+			}
+
+			return (uint16_t)(Sign | Half);
+		}
+
+		uint32_t Half = ((uint32_t)Exponent << 10) | (Mantissa >> 13);
+		const uint32_t Rest = Mantissa & 0x1FFF;
+		if (Rest > 0x1000 || (Rest == 0x1000 && (Half & 1)))
+		{
+			Half++;
+		}
+
+		return (uint16_t)(Sign | Half);
+	}
+
+	// Exact, every half is representable as a float
+	static float ToFloat(uint16_t Half)
+	{
+		const uint32_t Sign = (uint32_t)(Half & 0x8000) << 16;
+		const uint32_t Exponent = (Half >> 10) & 0x1F;
+		const uint32_t Mantissa = Half & 0x3FF;
+
+		if (Exponent == 0)
+		{
+			float Value = std::ldexp((float)Mantissa, -24);
+			return Sign ? -Value : Value;
+		}
+
+		uint32_t Bits;
+		if (Exponent == 31)
+		{
+			Bits = Sign | 0x7F800000 | (Mantissa << 13);
+		}
+		else
+		{
+			Bits = Sign | ((Exponent + 112) << 23) | (Mantissa << 13);
+		}
+
+		float Value;
+		memcpy(&Value, &Bits, sizeof(Value));
+
+		return Value;
+	}
+};
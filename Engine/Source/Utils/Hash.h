@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+class THash
+{
+public:
+	// FNV-1a over 8-byte words, fast enough to fingerprint source assets on every load
+	static uint64_t HashBytes(const void* Data, size_t Size, uint64_t Seed = 0xcbf29ce484222325ull)
+	{
+		const uint64_t Prime = 0x100000001b3ull;
+		const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+
+		uint64_t Hash = Seed ^ (uint64_t)Size;
+
+		size_t Offset = 0;
+		for (; Offset + 8 <= Size; Offset += 8)
+		{
+			uint64_t Word;
+			memcpy(&Word, Bytes + Offset, 8);
+
+			Hash = (Hash ^ Word) * Prime;
+			Hash ^= Hash >> 29;
+		}
+
+		for (; Offset < Size; Offset++)
+		{
+			Hash = (Hash ^ Bytes[Offset]) * Prime;
+		}
+
+		return Hash ^ (Hash >> 32);
+	}
+
+	static uint64_t Combine(uint64_t Hash, uint64_t Value)
+	{
+		return HashBytes(&Value, sizeof(Value), Hash);
+	}
+};
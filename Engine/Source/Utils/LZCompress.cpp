@@ -0,0 +1,204 @@
+#include "LZCompress.h"
+#include <cstring>
+
+namespace
+{
+	const size_t MinMatchLength = 4;
+
+	// The last bytes are always literals, so the match search never reads past the end
+	const size_t LastLiteralCount = 5;
+
+	const uint32_t HashBits = 14;
+
+	const size_t MaxOffset = 65535;
+
+	uint32_t Read32(const uint8_t* Data)
+	{
+		uint32_t Value;
+		memcpy(&Value, Data, sizeof(Value));
+
+		return Value;
+	}
+
+	uint32_t HashSequence(uint32_t Sequence)
+	{
+		return (Sequence * 2654435761u) >> (32 - HashBits);
+	}
+
+	void WriteLength(size_t Length, std::vector<uint8_t>& Out)
+	{
+		while (Length >= 255)
+		{
+			Out.push_back(255);
+			Length -= 255;
+		}
+
+		Out.push_back((uint8_t)Length);
+	}
+
+	void WriteSequence(const uint8_t* Literals, size_t LiteralCount, size_t Offset, size_t MatchLength, std::vector<uint8_t>& Out)
+	{
+		const size_t MatchCode = (MatchLength > 0) ? MatchLength - MinMatchLength : 0;
+
+		uint8_t Token = (uint8_t)(((LiteralCount < 15 ? LiteralCount : 15) << 4) | (MatchCode < 15 ? MatchCode : 15));
+		Out.push_back(Token);
+
+		if (LiteralCount >= 15)
+		{
+			WriteLength(LiteralCount - 15, Out);
+		}
+
+		Out.insert(Out.end(), Literals, Literals + LiteralCount);
+
+		// The last sequence has literals only
+		if (MatchLength == 0)
+		{
+			return;
+		}
+
+		Out.push_back((uint8_t)(Offset & 0xFF));
+		Out.push_back((uint8_t)(Offset >> 8));
+
+		if (MatchCode >= 15)
+		{
+			WriteLength(MatchCode - 15, Out);
+		}
+	}
+
+	bool ReadLength(const uint8_t*& Input, const uint8_t* InputEnd, size_t& Length)
+	{
+		uint8_t Byte;
+		do
+		{
+			if (Input >= InputEnd)
+			{
+				return false;
+			}
+
+			Byte = *Input++;
+			Length += Byte;
+		} while (Byte == 255);
+
+		return true;
+	}
+}
+
+void TLZCompress::Compress(const uint8_t* Data, size_t Size, std::vector<uint8_t>& OutCompressed)
+{
+	std::vector<uint8_t> Compressed;
+	Compressed.reserve(Size / 2 + 16);
+
+	// Last position of every hashed 4-byte sequence, plus one so zero means empty
+	std::vector<uint32_t> HashTable((size_t)1 << HashBits, 0);
+
+	size_t Anchor = 0;
+	size_t Position = 0;
+
+	if (Size > MinMatchLength + LastLiteralCount)
+	{
+		const size_t SearchEnd = Size - LastLiteralCount - MinMatchLength;
+
+		while (Position <= SearchEnd)
+		{
+			uint32_t Sequence = Read32(Data + Position);
+			uint32_t& Entry = HashTable[HashSequence(Sequence)];
+			size_t Candidate = (size_t)Entry;
+			Entry = (uint32_t)(Position + 1);
+
+			if (Candidate == 0 || Position - (Candidate - 1) > MaxOffset || Read32(Data + Candidate - 1) != Sequence)
+			{
+				Position++;
+				continue;
+			}
+
+			Candidate--;
+
+			size_t MatchLength = MinMatchLength;
+			const size_t MatchLimit = Size - LastLiteralCount;
+			while (Position + MatchLength < MatchLimit && Data[Candidate + MatchLength] == Data[Position + MatchLength])
+			{
+				MatchLength++;
+			}
+
+			WriteSequence(Data + Anchor, Position - Anchor, Position - Candidate, MatchLength, Compressed);
+
+			Position += MatchLength;
+			Anchor = Position;
+		}
+	}
+
+	WriteSequence(Data + Anchor, Size - Anchor, 0, 0, Compressed);
+
+	std::swap(Compressed, OutCompressed);
+}
+
+bool TLZCompress::Decompress(const uint8_t* Compressed, size_t CompressedSize, size_t DecompressedSize, std::vector<uint8_t>& OutData)
+{
+	std::vector<uint8_t> Data(DecompressedSize);
+
+	const uint8_t* Input = Compressed;
+	const uint8_t* InputEnd = Compressed + CompressedSize;
+	size_t Output = 0;
+
+	while (Input < InputEnd)
+	{
+		const uint8_t Token = *Input++;
+
+		size_t LiteralCount = Token >> 4;
+		if (LiteralCount == 15 && !ReadLength(Input, InputEnd, LiteralCount))
+		{
+			return false;
+		}
+
+		if (LiteralCount > (size_t)(InputEnd - Input) || LiteralCount > DecompressedSize - Output)
+		{
+			return false;
+		}
+
+		memcpy(Data.data() + Output, Input, LiteralCount);
+		Input += LiteralCount;
+		Output += LiteralCount;
+
+		// Literals only, the final sequence
+		if (Input == InputEnd)
+		{
+			break;
+		}
+
+		if (InputEnd - Input < 2)
+		{
+			return false;
+		}
+
+		const size_t Offset = (size_t)Input[0] | ((size_t)Input[1] << 8);
+		Input += 2;
+
+		size_t MatchLength = Token & 0x0F;
+		if (MatchLength == 15 && !ReadLength(Input, InputEnd, MatchLength))
+		{
+			return false;
+		}
+		MatchLength += MinMatchLength;
+
+		if (Offset == 0 || Offset > Output || MatchLength > DecompressedSize - Output)
+		{
+			return false;
+		}
+
+		// Byte by byte, matches may overlap their own output
+		for (size_t i = 0; i < MatchLength; i++)
+		{
+			Data[Output + i] = Data[Output - Offset + i];
+		}
+		Output += MatchLength;
+	}
+
+	if (Output != DecompressedSize)
+	{
+		return false;
+	}
+
+	std::swap(Data, OutData);
+
+	return true;
+}
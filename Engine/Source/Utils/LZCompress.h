@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Byte oriented LZ77 in the LZ4 block layout: a token with 4-bit literal and match lengths, 255-extended,
+// the literals, then a 16-bit offset. Fast to decode and good on the smooth, repetitive payloads of our caches.
+class TLZCompress
+{
+public:
+	static void Compress(const uint8_t* Data, size_t Size, std::vector<uint8_t>& OutCompressed);
+
+	// False on malformed input or when it doesn't decode to exactly DecompressedSize bytes
+	static bool Decompress(const uint8_t* Compressed, size_t CompressedSize, size_t DecompressedSize, std::vector<uint8_t>& OutData);
+};
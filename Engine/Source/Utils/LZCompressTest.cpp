@@ -0,0 +1,209 @@
+#include "LZCompress.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// Round trips empty, incompressible, repetitive and SDF-like inputs, then feeds Decompress truncated and corrupted
+// streams, which must be rejected rather than read or written out of bounds. Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	bool RoundTrip(const std::vector<uint8_t>& Data, std::vector<uint8_t>& OutCompressed)
+	{
+		TLZCompress::Compress(Data.data(), Data.size(), OutCompressed);
+
+		std::vector<uint8_t> Decompressed;
+		return TLZCompress::Decompress(OutCompressed.data(), OutCompressed.size(), Data.size(), Decompressed) && Decompressed == Data;
+	}
+
+	std::vector<uint8_t> MakeRandomBytes(size_t Size, uint32_t Seed)
+	{
+		std::mt19937 Random(Seed);
+		std::vector<uint8_t> Data(Size);
+		for (uint8_t& Byte : Data)
+		{
+			Byte = (uint8_t)Random();
+		}
+
+		return Data;
+	}
+
+	// Quantized distance to a sphere, smooth like the mesh SDF payloads
+	std::vector<uint8_t> MakeSDFVolume(int Resolution)
+	{
+		std::vector<uint8_t> Data((size_t)Resolution * Resolution * Resolution);
+		for (int Z = 0; Z < Resolution; Z++)
+		{
+			for (int Y = 0; Y < Resolution; Y++)
+			{
+				for (int X = 0; X < Resolution; X++)
+				{
+					const float DX = X - Resolution * 0.4f;
+					const float DY = Y - Resolution * 0.5f;
+					const float DZ = Z - Resolution * 0.6f;
+					const float Distance = std::sqrt(DX * DX + DY * DY + DZ * DZ) - Resolution * 0.25f;
+
+					Data[((size_t)Z * Resolution + Y) * Resolution + X] = (uint8_t)std::clamp((int)(Distance * 16.0f) + 128, 0, 255);
+				}
+			}
+		}
+
+		return Data;
+	}
+
+	void TestEmptyAndTiny()
+	{
+		std::vector<uint8_t> Compressed;
+		Check(RoundTrip({}, Compressed), "empty: round trips");
+		Check(Compressed.size() == 1, "empty: a single literal-only token");
+
+		std::vector<uint8_t> Decompressed;
+		Check(TLZCompress::Decompress(nullptr, 0, 0, Decompressed) && Decompressed.empty(), "empty: an empty stream decodes to nothing");
+		Check(!TLZCompress::Decompress(nullptr, 0, 16, Decompressed), "empty: an empty stream is not 16 bytes");
+
+		// Shorter than a match plus the trailing literals, everything is a literal
+		for (size_t Size = 1; Size <= 12; Size++)
+		{
+			const std::vector<uint8_t> Data(Size, 7);
+			Check(RoundTrip(Data, Compressed), "tiny: inputs shorter than the match window round trip");
+		}
+	}
+
+	void TestIncompressible()
+	{
+		const std::vector<uint8_t> Data = MakeRandomBytes(1 << 20, 1);
+
+		std::vector<uint8_t> Compressed;
+		Check(RoundTrip(Data, Compressed), "incompressible: round trips");
+
+		// One token and the 255-extended literal length, 1 + 1 + Size / 255 bytes of overhead
+		printf("Incompressible: %zu -> %zu bytes\n", Data.size(), Compressed.size());
+		Check(Compressed.size() <= Data.size() + Data.size() / 255 + 16, "incompressible: expansion is bounded by the length bytes");
+	}
+
+	void TestRepetitive()
+	{
+		// A single byte run, the match overlaps its own output at offset 1
+		const std::vector<uint8_t> Run(1 << 20, 0xAB);
+		std::vector<uint8_t> Compressed;
+		Check(RoundTrip(Run, Compressed), "repetitive: a byte run round trips");
+		printf("Byte run: %zu -> %zu bytes\n", Run.size(), Compressed.size());
+		Check(Compressed.size() < Run.size() / 200, "repetitive: a byte run compresses over 200:1");
+
+		// A short period repeated, with a literal block between the repeats
+		std::vector<uint8_t> Pattern;
+		const std::vector<uint8_t> Noise = MakeRandomBytes(300, 2);
+		for (int i = 0; i < 2000; i++)
+		{
+			const uint8_t Period[7] = { 1, 2, 3, 5, 8, 13, 21 };
+			Pattern.insert(Pattern.end(), Period, Period + 7);
+			if (i % 500 == 0)
+			{
+				Pattern.insert(Pattern.end(), Noise.begin(), Noise.end());
+			}
+		}
+		Check(RoundTrip(Pattern, Compressed), "repetitive: a periodic pattern with noise round trips");
+		Check(Compressed.size() < Pattern.size() / 10, "repetitive: a periodic pattern compresses over 10:1");
+
+		// Repeats further apart than the 16-bit offset can't match
+		std::vector<uint8_t> Distant = MakeRandomBytes(70000, 3);
+		Distant.insert(Distant.end(), Distant.begin(), Distant.begin() + 1000);
+		Check(RoundTrip(Distant, Compressed), "repetitive: repeats past the maximum offset round trip");
+	}
+
+	void TestSDFPayload()
+	{
+		const std::vector<uint8_t> Data = MakeSDFVolume(128);
+
+		auto StartTime = std::chrono::steady_clock::now();
+		std::vector<uint8_t> Compressed;
+		TLZCompress::Compress(Data.data(), Data.size(), Compressed);
+		const double CompressSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+		StartTime = std::chrono::steady_clock::now();
+		std::vector<uint8_t> Decompressed;
+		const bool bDecoded = TLZCompress::Decompress(Compressed.data(), Compressed.size(), Data.size(), Decompressed);
+		const double DecompressSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+		const double MB = Data.size() / (1024.0 * 1024.0);
+		printf("SDF volume 128^3: %zu -> %zu bytes (%.1f:1), compress %.0f MB/s, decompress %.0f MB/s\n",
+			Data.size(), Compressed.size(), (double)Data.size() / Compressed.size(), MB / CompressSeconds, MB / DecompressSeconds);
+
+		Check(bDecoded && Decompressed == Data, "SDF: round trips");
+		Check(Compressed.size() < Data.size() / 2, "SDF: a smooth volume compresses at least 2:1");
+	}
+
+	void TestMalformed()
+	{
+		const std::vector<uint8_t> Data = MakeSDFVolume(32);
+		std::vector<uint8_t> Compressed;
+		TLZCompress::Compress(Data.data(), Data.size(), Compressed);
+
+		// Every truncation must fail, the stream can't decode to the full size without its tail
+		int AcceptedTruncations = 0;
+		std::vector<uint8_t> Decompressed;
+		for (size_t Size = 0; Size < Compressed.size(); Size++)
+		{
+			AcceptedTruncations += TLZCompress::Decompress(Compressed.data(), Size, Data.size(), Decompressed);
+		}
+		Check(AcceptedTruncations == 0, "truncated: every truncated stream is rejected");
+
+		Check(!TLZCompress::Decompress(Compressed.data(), Compressed.size(), Data.size() - 1, Decompressed), "size: a smaller expected size is rejected");
+		Check(!TLZCompress::Decompress(Compressed.data(), Compressed.size(), Data.size() + 1, Decompressed), "size: a larger expected size is rejected");
+
+		// An offset reaching before the start of the output
+		const uint8_t BadOffset[] = { 0x40, 'a', 'b', 'c', 'd', 0x10, 0x00, 0x10, 'e' };
+		Check(!TLZCompress::Decompress(BadOffset, sizeof(BadOffset), 9, Decompressed), "corrupt: an offset before the output start is rejected");
+
+		const uint8_t ZeroOffset[] = { 0x40, 'a', 'b', 'c', 'd', 0x00, 0x00, 0x10, 'e' };
+		Check(!TLZCompress::Decompress(ZeroOffset, sizeof(ZeroOffset), 9, Decompressed), "corrupt: a zero offset is rejected");
+
+		// The same stream with a valid offset decodes
+		const uint8_t GoodOffset[] = { 0x40, 'a', 'b', 'c', 'd', 0x04, 0x00, 0x10, 'e' };
+		Check(TLZCompress::Decompress(GoodOffset, sizeof(GoodOffset), 9, Decompressed) && Decompressed[7] == 'd',
+			"corrupt: the hand written reference stream decodes");
+
+		// A 255-extended length running off the end
+		const uint8_t OpenLength[] = { 0xF0, 0xFF, 0xFF };
+		Check(!TLZCompress::Decompress(OpenLength, sizeof(OpenLength), 1000, Decompressed), "corrupt: an unterminated length is rejected");
+
+		// Random bit flips either fail or decode to exactly the expected size, never crash
+		std::mt19937 Random(4);
+		int RejectedCount = 0;
+		for (int i = 0; i < 2000; i++)
+		{
+			std::vector<uint8_t> Corrupt = Compressed;
+			Corrupt[Random() % Corrupt.size()] ^= (uint8_t)(1 << (Random() % 8));
+
+			const bool bDecoded = TLZCompress::Decompress(Corrupt.data(), Corrupt.size(), Data.size(), Decompressed);
+			RejectedCount += !bDecoded;
+			Check(!bDecoded || Decompressed.size() == Data.size(), "corrupt: an accepted stream has the expected size");
+		}
+		printf("Bit flips: %d of 2000 corrupted streams rejected, the rest are caught by the cache payload hash\n", RejectedCount);
+	}
+}
+
+int main()
+{
+	TestEmptyAndTiny();
+	TestIncompressible();
+	TestRepetitive();
+	TestSDFPayload();
+	TestMalformed();
+
+	printf("%s\n", FailureCount == 0 ? "All LZ compression checks passed" : "LZ compression checks FAILED");
+
+	return FailureCount;
+}
@@ -0,0 +1,203 @@
+#include "OffsetAllocator.h"
+#include <cassert>
+
+namespace
+{
+	uint32_t AlignUp(uint32_t Value, uint32_t Alignment)
+	{
+		return (Value + Alignment - 1) / Alignment * Alignment;
+	}
+}
+
+TOffsetAllocator::TOffsetAllocator(uint32_t InCapacity)
+{
+	Grow(InCapacity);
+}
+
+bool TOffsetAllocator::Allocate(uint32_t Size, uint32_t Alignment, TOffsetAllocation& OutAllocation)
+{
+	OutAllocation = TOffsetAllocation();
+
+	if (Size == 0 || Alignment == 0)
+	{
+		return false;
+	}
+
+	// Smallest block that still fits after aligning its start
+	for (auto SizeIter = FreeBlocksBySize.lower_bound(Size); SizeIter != FreeBlocksBySize.end(); ++SizeIter)
+	{
+		const uint32_t BlockOffset = SizeIter->second;
+		const uint32_t BlockSize = SizeIter->first;
+
+		const uint32_t AlignedOffset = AlignUp(BlockOffset, Alignment);
+		const uint32_t Padding = AlignedOffset - BlockOffset;
+		if (Padding > BlockSize - Size)
+		{
+			continue;
+		}
+
+		RemoveFreeBlock(FreeBlocks.find(BlockOffset));
+
+		// Padding and tail go back to the free list
+		if (Padding > 0)
+		{
+			AddFreeBlock(BlockOffset, Padding);
+		}
+
+		const uint32_t TailSize = BlockSize - Padding - Size;
+		if (TailSize > 0)
+		{
+			AddFreeBlock(AlignedOffset + Size, TailSize);
+		}
+
+		TLiveAllocation Live;
+		Live.Size = Size;
+		Live.Alignment = Alignment;
+		Allocations[AlignedOffset] = Live;
+
+		UsedSize += Size;
+
+		OutAllocation.Offset = AlignedOffset;
+		OutAllocation.Size = Size;
+
+		return true;
+	}
+
+	return false;
+}
+
+void TOffsetAllocator::Free(const TOffsetAllocation& Allocation)
+{
+	if (!Allocation.IsValid())
+	{
+		return;
+	}
+
+	auto Iter = Allocations.find(Allocation.Offset);
+	assert(Iter != Allocations.end() && Iter->second.Size == Allocation.Size);
+	if (Iter == Allocations.end())
+	{
+		return;
+	}
+
+	uint32_t Offset = Allocation.Offset;
+	uint32_t Size = Iter->second.Size;
+
+	Allocations.erase(Iter);
+	UsedSize -= Size;
+
+	// Merge with the free neighbours
+	auto Next = FreeBlocks.lower_bound(Offset);
+	if (Next != FreeBlocks.end() && Next->first == Offset + Size)
+	{
+		Size += Next->second;
+		RemoveFreeBlock(Next);
+	}
+
+	auto Prev = FreeBlocks.lower_bound(Offset);
+	if (Prev != FreeBlocks.begin())
+	{
+		--Prev;
+		if (Prev->first + Prev->second == Offset)
+		{
+			Offset = Prev->first;
+			Size += Prev->second;
+			RemoveFreeBlock(Prev);
+		}
+	}
+
+	AddFreeBlock(Offset, Size);
+}
+
+void TOffsetAllocator::Grow(uint32_t NewCapacity)
+{
+	if (NewCapacity <= Capacity)
+	{
+		return;
+	}
+
+	uint32_t Offset = Capacity;
+	uint32_t Size = NewCapacity - Capacity;
+
+	// Extend the free block that ends at the old capacity
+	if (!FreeBlocks.empty())
+	{
+		auto Last = std::prev(FreeBlocks.end());
+		if (Last->first + Last->second == Capacity)
+		{
+			Offset = Last->first;
+			Size += Last->second;
+			RemoveFreeBlock(Last);
+		}
+	}
+
+	AddFreeBlock(Offset, Size);
+
+	Capacity = NewCapacity;
+}
+
+void TOffsetAllocator::Defragment(std::vector<TOffsetMove>& OutMoves)
+{
+	OutMoves.clear();
+
+	std::map<uint32_t, TLiveAllocation> Packed;
+	FreeBlocks.clear();
+	FreeBlocksBySize.clear();
+
+	uint32_t Cursor = 0;
+	for (const auto& Pair : Allocations)
+	{
+		const TLiveAllocation& Live = Pair.second;
+
+		const uint32_t NewOffset = AlignUp(Cursor, Live.Alignment);
+		if (NewOffset > Cursor)
+		{
+			AddFreeBlock(Cursor, NewOffset - Cursor);
+		}
+
+		if (NewOffset != Pair.first)
+		{
+			TOffsetMove Move;
+			Move.OldOffset = Pair.first;
+			Move.NewOffset = NewOffset;
+			Move.Size = Live.Size;
+			OutMoves.push_back(Move);
+		}
+
+		Packed[NewOffset] = Live;
+		Cursor = NewOffset + Live.Size;
+	}
+
+	if (Cursor < Capacity)
+	{
+		AddFreeBlock(Cursor, Capacity - Cursor);
+	}
+
+	Allocations = std::move(Packed);
+}
+
+uint32_t TOffsetAllocator::GetLargestFreeBlock() const
+{
+	return FreeBlocksBySize.empty() ? 0 : std::prev(FreeBlocksBySize.end())->first;
+}
+
+void TOffsetAllocator::AddFreeBlock(uint32_t Offset, uint32_t Size)
+{
+	FreeBlocks[Offset] = Size;
+	FreeBlocksBySize.emplace(Size, Offset);
+}
+
+void TOffsetAllocator::RemoveFreeBlock(std::map<uint32_t, uint32_t>::iterator Iter)
+{
+	auto Range = FreeBlocksBySize.equal_range(Iter->second);
+	for (auto SizeIter = Range.first; SizeIter != Range.second; ++SizeIter)
+	{
+		if (SizeIter->second == Iter->first)
+		{
+			FreeBlocksBySize.erase(SizeIter);
+			break;
+		}
+	}
+
+	FreeBlocks.erase(Iter);
+}
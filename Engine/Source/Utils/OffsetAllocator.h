@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+struct TOffsetAllocation
+{
+	static const uint32_t InvalidOffset = UINT32_MAX;
+
+	uint32_t Offset = InvalidOffset;
+
+	uint32_t Size = 0;
+
+	bool IsValid() const { return Offset != InvalidOffset; }
+};
+
+// Allocation moved by Defragment, live data must be copied from OldOffset to NewOffset
+struct TOffsetMove
+{
+	uint32_t OldOffset = 0;
+
+	uint32_t NewOffset = 0;
+
+	uint32_t Size = 0;
+};
+
+// Best fit suballocator over an abstract range of units (bytes, vertices or indices).
+// Free blocks are coalesced on Free, Defragment packs every live allocation to the front.
+class TOffsetAllocator
+{
+public:
+	explicit TOffsetAllocator(uint32_t InCapacity = 0);
+
+	// Alignment is in units, any value greater than zero
+	bool Allocate(uint32_t Size, uint32_t Alignment, TOffsetAllocation& OutAllocation);
+
+	void Free(const TOffsetAllocation& Allocation);
+
+	// Adds free space at the end of the range
+	void Grow(uint32_t NewCapacity);
+
+	// Moves are sorted by offset and NewOffset <= OldOffset, so applying them in order never overwrites live data
+	void Defragment(std::vector<TOffsetMove>& OutMoves);
+
+	uint32_t GetCapacity() const { return Capacity; }
+
+	uint32_t GetUsedSize() const { return UsedSize; }
+
+	uint32_t GetLargestFreeBlock() const;
+
+	uint32_t GetFreeBlockCount() const { return (uint32_t)FreeBlocks.size(); }
+
+	uint32_t GetAllocationCount() const { return (uint32_t)Allocations.size(); }
+
+private:
+	void AddFreeBlock(uint32_t Offset, uint32_t Size);
+
+	void RemoveFreeBlock(std::map<uint32_t, uint32_t>::iterator Iter);
+
+private:
+	uint32_t Capacity = 0;
+
+	uint32_t UsedSize = 0;
+
+	// Offset -> size
+	std::map<uint32_t, uint32_t> FreeBlocks;
+
+	// Size -> offset, for best fit lookup
+	std::multimap<uint32_t, uint32_t> FreeBlocksBySize;
+
+	struct TLiveAllocation
+	{
+		uint32_t Size = 0;
+
+		uint32_t Alignment = 1;
+	};
+
+	// Offset -> live allocation, Defragment keeps the alignment
+	std::map<uint32_t, TLiveAllocation> Allocations;
+};
@@ -0,0 +1,256 @@
+#include "OffsetAllocator.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+// Checks best fit, alignment padding, coalescing and Grow on hand built layouts, then replays TGeometryPool::Grow on
+// a randomly fragmented arena and checks every live allocation survives the copy. Returns the number of failed checks.
+namespace
+{
+	int FailureCount = 0;
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			printf("FAILED: %s\n", What);
+			FailureCount++;
+		}
+	}
+
+	// Allocations of the given sizes back to back from offset 0
+	std::vector<TOffsetAllocation> AllocateInOrder(TOffsetAllocator& Allocator, const std::vector<uint32_t>& Sizes)
+	{
+		std::vector<TOffsetAllocation> Allocations(Sizes.size());
+		for (size_t i = 0; i < Sizes.size(); i++)
+		{
+			Allocator.Allocate(Sizes[i], 1, Allocations[i]);
+		}
+
+		return Allocations;
+	}
+
+	void TestBestFit()
+	{
+		// Holes of 40, 10 and 20 units, separated by live allocations, and a 30 unit tail
+		TOffsetAllocator Allocator(130);
+		std::vector<TOffsetAllocation> Allocations = AllocateInOrder(Allocator, { 40, 5, 10, 5, 20, 20 });
+		Allocator.Free(Allocations[0]);
+		Allocator.Free(Allocations[2]);
+		Allocator.Free(Allocations[4]);
+
+		Check(Allocator.GetFreeBlockCount() == 4, "best fit: three holes and the tail are free");
+
+		TOffsetAllocation Allocation;
+		Allocator.Allocate(10, 1, Allocation);
+		Check(Allocation.Offset == 45, "best fit: an exact fit takes the 10 unit hole");
+
+		Allocator.Allocate(15, 1, Allocation);
+		Check(Allocation.Offset == 60, "best fit: 15 units take the 20 unit hole over the larger ones");
+
+		Allocator.Allocate(35, 1, Allocation);
+		Check(Allocation.Offset == 0, "best fit: 35 units take the 40 unit hole, the tail is too small");
+
+		Allocator.Allocate(100, 1, Allocation);
+		Check(!Allocation.IsValid(), "best fit: a request larger than every block fails");
+		Check(Allocator.GetUsedSize() == 30 + 10 + 15 + 35, "best fit: used size counts only live allocations");
+	}
+
+	void TestAlignment()
+	{
+		TOffsetAllocator Allocator(256);
+
+		TOffsetAllocation First;
+		Allocator.Allocate(3, 1, First);
+
+		TOffsetAllocation Aligned;
+		Allocator.Allocate(16, 64, Aligned);
+		Check(Aligned.Offset == 64, "alignment: the start is rounded up");
+		Check(Allocator.GetFreeBlockCount() == 2, "alignment: the padding goes back to the free list");
+
+		// The padding block is reused by a small unaligned request
+		TOffsetAllocation Small;
+		Allocator.Allocate(61, 1, Small);
+		Check(Small.Offset == 3, "alignment: padding is allocatable");
+
+		// Only the 176 unit tail remains, a 176 unit request aligned to 64 does not fit after padding
+		TOffsetAllocation TooLarge;
+		Allocator.Allocate(176, 64, TooLarge);
+		Check(!TooLarge.IsValid(), "alignment: padding counts against the block size");
+
+		TOffsetAllocation Fits;
+		Allocator.Allocate(128, 64, Fits);
+		Check(Fits.Offset == 128 && Allocator.GetFreeBlockCount() == 1, "alignment: a request that fits after padding succeeds");
+
+		TOffsetAllocation Odd;
+		Allocator.Allocate(8, 48, Odd);
+		Check(Odd.Offset == 96, "alignment: non power of two alignments are honoured");
+
+		TOffsetAllocation Invalid;
+		Check(!Allocator.Allocate(0, 1, Invalid) && !Allocator.Allocate(4, 0, Invalid), "alignment: zero size or alignment is rejected");
+	}
+
+	void TestCoalescing()
+	{
+		TOffsetAllocator Allocator(100);
+		std::vector<TOffsetAllocation> Allocations = AllocateInOrder(Allocator, { 10, 10, 10, 10, 10 });
+
+		// With the right neighbour
+		Allocator.Free(Allocations[2]);
+		Allocator.Free(Allocations[1]);
+		Check(Allocator.GetFreeBlockCount() == 2 && Allocator.GetLargestFreeBlock() == 50, "coalescing: merges with the next free block");
+
+		// With both neighbours, the 20 unit hole and the tail
+		Allocator.Free(Allocations[4]);
+		Check(Allocator.GetFreeBlockCount() == 2 && Allocator.GetLargestFreeBlock() == 60, "coalescing: merges with the tail");
+
+		Allocator.Free(Allocations[3]);
+		Check(Allocator.GetFreeBlockCount() == 1 && Allocator.GetLargestFreeBlock() == 90, "coalescing: merges with both neighbours");
+
+		// With the left neighbour only
+		TOffsetAllocator Left(30);
+		std::vector<TOffsetAllocation> LeftAllocations = AllocateInOrder(Left, { 10, 10, 10 });
+		Left.Free(LeftAllocations[0]);
+		Left.Free(LeftAllocations[1]);
+		Check(Left.GetFreeBlockCount() == 1 && Left.GetLargestFreeBlock() == 20, "coalescing: merges with the previous free block");
+
+		Allocator.Free(Allocations[0]);
+		Check(Allocator.GetFreeBlockCount() == 1 && Allocator.GetLargestFreeBlock() == 100 && Allocator.GetUsedSize() == 0,
+			"coalescing: freeing everything leaves one block");
+	}
+
+	void TestGrow()
+	{
+		TOffsetAllocator Allocator(64);
+		std::vector<TOffsetAllocation> Allocations = AllocateInOrder(Allocator, { 16, 16 });
+
+		Allocator.Grow(128);
+		Check(Allocator.GetCapacity() == 128, "grow: capacity increases");
+		Check(Allocator.GetFreeBlockCount() == 1 && Allocator.GetLargestFreeBlock() == 96, "grow: the tail block is extended, not split");
+
+		Allocator.Grow(100);
+		Check(Allocator.GetCapacity() == 128, "grow: a smaller capacity is ignored");
+
+		// Full to the end, growing adds a separate block
+		TOffsetAllocation Rest;
+		Allocator.Allocate(96, 1, Rest);
+		Allocator.Grow(160);
+		Check(Allocator.GetFreeBlockCount() == 1 && Allocator.GetLargestFreeBlock() == 32, "grow: a full range gains a new tail block");
+
+		TOffsetAllocation Allocation;
+		Check(Allocator.Allocate(32, 1, Allocation) && Allocation.Offset == 128, "grow: the new space is allocatable");
+	}
+
+	// Fragments an arena with random allocations and frees, then grows it like TGeometryPool::Grow: defragment, grow,
+	// copy the first KeptSize units and then each move from the old buffer to the new one.
+	void TestDefragmentCopy(uint32_t Alignment)
+	{
+		const uint32_t Capacity = 1 << 16;
+		TOffsetAllocator Allocator(Capacity);
+
+		std::mt19937 Random(Alignment);
+		std::vector<TOffsetAllocation> Live;
+		for (int i = 0; i < 4000; i++)
+		{
+			if (!Live.empty() && Random() % 3 == 0)
+			{
+				const size_t Index = Random() % Live.size();
+				Allocator.Free(Live[Index]);
+				Live[Index] = Live.back();
+				Live.pop_back();
+				continue;
+			}
+
+			TOffsetAllocation Allocation;
+			if (Allocator.Allocate(1 + Random() % 200, Alignment, Allocation))
+			{
+				Live.push_back(Allocation);
+			}
+		}
+
+		// Each allocation's units hold its index, free units hold a marker
+		const uint32_t FreeMarker = UINT32_MAX;
+		std::vector<uint32_t> OldBuffer(Capacity, FreeMarker);
+		for (size_t i = 0; i < Live.size(); i++)
+		{
+			std::fill(OldBuffer.begin() + Live[i].Offset, OldBuffer.begin() + Live[i].Offset + Live[i].Size, (uint32_t)i);
+		}
+
+		const uint32_t FreeBlockCount = Allocator.GetFreeBlockCount();
+		const uint32_t UsedSize = Allocator.GetUsedSize();
+
+		std::vector<TOffsetMove> Moves;
+		Allocator.Defragment(Moves);
+		Allocator.Grow(Capacity * 2);
+
+		bool bSorted = true;
+		bool bMovesDown = true;
+		for (size_t i = 0; i < Moves.size(); i++)
+		{
+			bSorted &= i == 0 || Moves[i].OldOffset > Moves[i - 1].OldOffset;
+			bMovesDown &= Moves[i].NewOffset <= Moves[i].OldOffset;
+		}
+
+		const uint32_t KeptSize = Moves.empty() ? Capacity : Moves[0].NewOffset;
+
+		std::vector<uint32_t> NewBuffer(Capacity * 2, FreeMarker);
+		std::copy(OldBuffer.begin(), OldBuffer.begin() + KeptSize, NewBuffer.begin());
+		for (const TOffsetMove& Move : Moves)
+		{
+			std::copy(OldBuffer.begin() + Move.OldOffset, OldBuffer.begin() + Move.OldOffset + Move.Size, NewBuffer.begin() + Move.NewOffset);
+		}
+
+		// Relocate the handles and check their contents
+		bool bContentsKept = true;
+		bool bAligned = true;
+		for (size_t i = 0; i < Live.size(); i++)
+		{
+			uint32_t Offset = Live[i].Offset;
+			for (const TOffsetMove& Move : Moves)
+			{
+				if (Move.OldOffset == Offset)
+				{
+					Offset = Move.NewOffset;
+					break;
+				}
+			}
+
+			bAligned &= Offset % Alignment == 0;
+			for (uint32_t Unit = 0; Unit < Live[i].Size; Unit++)
+			{
+				bContentsKept &= NewBuffer[Offset + Unit] == (uint32_t)i;
+			}
+		}
+
+		// Everything used now sits before one free block running to the new capacity
+		const uint32_t PackedEnd = Capacity * 2 - Allocator.GetLargestFreeBlock();
+
+		printf("Defragment (alignment %u): %zu live allocations, %u free blocks -> %u, %zu moves, kept %u units in place\n",
+			Alignment, Live.size(), FreeBlockCount, Allocator.GetFreeBlockCount(), Moves.size(), KeptSize);
+
+		Check(bSorted && bMovesDown, "defragment: moves are sorted by offset and only move down");
+		Check(bContentsKept, "defragment: every allocation survives the pool's copy");
+		Check(bAligned, "defragment: allocations keep their alignment");
+		Check(Allocator.GetUsedSize() == UsedSize && Allocator.GetAllocationCount() == Live.size(), "defragment: allocations are neither lost nor added");
+		Check(Alignment > 1 || PackedEnd == UsedSize, "defragment: unaligned allocations pack without gaps");
+		Check(PackedEnd <= Capacity, "defragment: the packed allocations fit in the old capacity");
+
+		// The packed range and the grown tail are one block
+		TOffsetAllocation Large;
+		Check(Allocator.Allocate(Capacity, 1, Large), "defragment: the freed space joins the grown tail");
+	}
+}
+
+int main()
+{
+	TestBestFit();
+	TestAlignment();
+	TestCoalescing();
+	TestGrow();
+	TestDefragmentCopy(1);
+	TestDefragmentCopy(16);
+
+	printf("%s\n", FailureCount == 0 ? "All offset allocator checks passed" : "Offset allocator checks FAILED");
+
+	return FailureCount;
+}
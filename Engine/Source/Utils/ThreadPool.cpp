@@ -0,0 +1,147 @@
+#include "ThreadPool.h"
+#include <atomic>
+
+TThreadPool::TThreadPool(uint32_t ThreadCount)
+{
+	if (ThreadCount == 0)
+	{
+		ThreadCount = std::thread::hardware_concurrency();
+		ThreadCount = ThreadCount > 0 ? ThreadCount : 4;
+	}
+
+	for (uint32_t i = 0; i < ThreadCount; i++)
+	{
+		Workers.emplace_back(&TThreadPool::WorkerLoop, this);
+	}
+}
+
+TThreadPool::~TThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> Lock(Mutex);
+		bStopping = true;
+	}
+	TaskCondition.notify_all();
+
+	for (std::thread& Worker : Workers)
+	{
+		Worker.join();
+	}
+}
+
+TThreadPool& TThreadPool::Get()
+{
+	static TThreadPool Instance;
+	return Instance;
+}
+
+void TThreadPool::Enqueue(std::function<void()> Task)
+{
+	{
+		std::unique_lock<std::mutex> Lock(Mutex);
+		Tasks.push_back(std::move(Task));
+	}
+	TaskCondition.notify_one();
+}
+
+void TThreadPool::Wait()
+{
+	std::unique_lock<std::mutex> Lock(Mutex);
+	IdleCondition.wait(Lock, [this]() { return Tasks.empty() && ActiveTaskCount == 0; });
+}
+
+void TThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> Task;
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			TaskCondition.wait(Lock, [this]() { return bStopping || !Tasks.empty(); });
+
+			if (bStopping && Tasks.empty())
+			{
+				return;
+			}
+
+			Task = std::move(Tasks.front());
+			Tasks.pop_front();
+			ActiveTaskCount++;
+		}
+
+		Task();
+
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			ActiveTaskCount--;
+			if (Tasks.empty() && ActiveTaskCount == 0)
+			{
+				IdleCondition.notify_all();
+			}
+		}
+	}
+}
+
+bool TThreadPool::TryRunPendingTask()
+{
+	std::function<void()> Task;
+	{
+		std::unique_lock<std::mutex> Lock(Mutex);
+		if (Tasks.empty())
+		{
+			return false;
+		}
+
+		Task = std::move(Tasks.front());
+		Tasks.pop_front();
+		ActiveTaskCount++;
+	}
+
+	Task();
+
+	{
+		std::unique_lock<std::mutex> Lock(Mutex);
+		ActiveTaskCount--;
+		if (Tasks.empty() && ActiveTaskCount == 0)
+		{
+			IdleCondition.notify_all();
+		}
+	}
+
+	return true;
+}
+
+void TThreadPool::ParallelFor(uint32_t Count, const std::function<void(uint32_t)>& Func)
+{
+	if (Count == 0)
+	{
+		return;
+	}
+
+	std::atomic<uint32_t> RemainingCount(Count);
+	std::mutex DoneMutex;
+	std::condition_variable DoneCondition;
+
+	for (uint32_t Index = 0; Index < Count; Index++)
+	{
+		Enqueue([&, Index]()
+		{
+			Func(Index);
+
+			// Decrement under the lock, the caller's stack must outlive this notify
+			std::unique_lock<std::mutex> Lock(DoneMutex);
+			if (--RemainingCount == 0)
+			{
+				DoneCondition.notify_all();
+			}
+		});
+	}
+
+	// Help out instead of just blocking
+	while (RemainingCount > 0 && TryRunPendingTask())
+	{
+	}
+
+	std::unique_lock<std::mutex> Lock(DoneMutex);
+	DoneCondition.wait(Lock, [&]() { return RemainingCount == 0; });
+}
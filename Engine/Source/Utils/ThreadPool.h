@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class TThreadPool
+{
+public:
+	// ThreadCount 0 uses one worker per hardware thread
+	TThreadPool(uint32_t ThreadCount = 0);
+
+	~TThreadPool();
+
+	TThreadPool(const TThreadPool& Other) = delete;
+
+	TThreadPool& operator=(const TThreadPool& Other) = delete;
+
+	// Shared pool for engine-side jobs
+	static TThreadPool& Get();
+
+public:
+	void Enqueue(std::function<void()> Task);
+
+	// Block until every enqueued task has finished
+	void Wait();
+
+	// Run Func(Index) for Index in [0, Count) and block until done.
+	// The calling thread helps with queued tasks, so nesting inside a task doesn't deadlock.
+	void ParallelFor(uint32_t Count, const std::function<void(uint32_t)>& Func);
+
+	uint32_t GetThreadCount() const { return (uint32_t)Workers.size(); }
+
+private:
+	void WorkerLoop();
+
+	bool TryRunPendingTask();
+
+private:
+	std::vector<std::thread> Workers;
+
+	std::deque<std::function<void()>> Tasks;
+
+	std::mutex Mutex;
+
+	std::condition_variable TaskCondition;
+
+	std::condition_variable IdleCondition;
+
+	uint32_t ActiveTaskCount = 0;
+
+	bool bStopping = false;
+};
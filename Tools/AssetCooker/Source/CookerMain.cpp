@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <cstring>
+#include "Cooker/AssetCooker.h"
+#include "Cooker/TextureCookTasks.h"
+#include "File/FileHelpers.h"
+#include "Utils/ThreadPool.h"
+
+// Mesh tasks import FBX, builds without the FBX SDK (Linux) only cook textures
+#ifdef WITH_FBX_COOK
+#include "Cooker/MeshCookTasks.h"
+#endif
+
+// Usage: AssetCooker [-force] [-quality=fast|normal|high] [-legacy]
+// Cooks Engine/Resource into Engine/Save, assets unchanged since the last run are skipped.
+// -quality picks the texture compression preset, -legacy uses BC1/BC3 instead of BC7 for color textures.
+int main(int argc, char* argv[])
+{
+	bool bForce = false;
+	TTextureCookSettings TextureSettings;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-force") == 0)
+		{
+			bForce = true;
+		}
+		else if (strcmp(argv[i], "-quality=fast") == 0)
+		{
+			TextureSettings.Quality = EBlockCompressQuality::Fast;
+		}
+		else if (strcmp(argv[i], "-quality=normal") == 0)
+		{
+			TextureSettings.Quality = EBlockCompressQuality::Normal;
+		}
+		else if (strcmp(argv[i], "-quality=high") == 0)
+		{
+			TextureSettings.Quality = EBlockCompressQuality::High;
+		}
+		else if (strcmp(argv[i], "-legacy") == 0)
+		{
+			TextureSettings.bLegacyFormats = true;
+		}
+		else
+		{
+			printf("Unknown argument %s\nUsage: AssetCooker [-force] [-quality=fast|normal|high] [-legacy]\n", argv[i]);
+			return 2;
+		}
+	}
+
+	TAssetCooker Cooker(TThreadPool::Get(), TFileHelpers::EngineDir() + L"Save/CookManifest.txt");
+#ifdef WITH_FBX_COOK
+	AddMeshCookTasks(Cooker);
+#endif
+	AddTextureCookTasks(Cooker, TextureSettings);
+
+	TCookStats Stats = Cooker.Run(bForce);
+
+	for (const TCookTaskResult& Result : Stats.Results)
+	{
+		if (Result.bCooked)
+		{
+			printf("%-16s %s in %.2f s\n", Result.AssetName.c_str(), Result.bSuccess ? "cooked" : "FAILED", Result.Seconds);
+		}
+		else
+		{
+			printf("%-16s up to date\n", Result.AssetName.c_str());
+		}
+	}
+
+	printf("%s\n", Stats.ToString().c_str());
+
+	return Stats.FailedCount == 0 ? 0 : 1;
+}